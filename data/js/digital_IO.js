@@ -99,25 +99,20 @@ document.addEventListener("DOMContentLoaded", function () {
         elements.conversionFactor.style.display = isPulseMode ? "block" : "none";
     }
 
-    function getSensorReading() {
-        fetch('/getValue', { method: "GET" })
-            .then(response => response.json())
-            .then(data => {
-                // Cari data sensor berdasarkan Nama Sensor (Sensor Code)
-                const sensor = data.find(s => s.KodeSensor === elements.nameDI.value);
-                elements.currentValue.value = sensor ? sensor.Value : '-';
-
-                // Update Unit Satuan secara dinamis
-                switch (elements.taskMode.value) {
-                    case "Normal": elements.unit.innerHTML = "."; break;
-                    case "Cycle Time": elements.unit.innerHTML = "sec"; break;
-                    case "Run Time": elements.unit.innerHTML = "min"; break;
-                    case "Counting": elements.unit.innerHTML = "pcs"; break;
-                    case "Pulse Mode": elements.unit.innerHTML = "Hz"; break;
-                    default: elements.unit.innerHTML = "-";
-                }
-            })
-            .catch(error => console.error("Polling error:", error));
+    function showSensorReading(live) {
+        // Cari data sensor berdasarkan Nama Sensor (Sensor Code)
+        const value = live.v[elements.nameDI.value];
+        elements.currentValue.value = value !== undefined ? value : '-';
+
+        // Update Unit Satuan secara dinamis
+        switch (elements.taskMode.value) {
+            case "Normal": elements.unit.innerHTML = "."; break;
+            case "Cycle Time": elements.unit.innerHTML = "sec"; break;
+            case "Run Time": elements.unit.innerHTML = "min"; break;
+            case "Counting": elements.unit.innerHTML = "pcs"; break;
+            case "Pulse Mode": elements.unit.innerHTML = "Hz"; break;
+            default: elements.unit.innerHTML = "-";
+        }
     }
 
     function submitForm(formData) {
@@ -153,6 +148,6 @@ document.addEventListener("DOMContentLoaded", function () {
         fetchData(elements.inputPin.value[2]);
     }
 
-    // Mulai Polling
-    setInterval(getSensorReading, 2000);
+    // Data realtime lewat SSE /live
+    LiveData.subscribe(showSensorReading);
 });
\ No newline at end of file
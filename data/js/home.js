@@ -39,92 +39,100 @@ document.addEventListener("DOMContentLoaded", () => {
     document.getElementById('di4Unit'),
   ];
 
-  // --- 2. FUNGSI FETCH DATA (Polling) ---
-  // Fungsi ini jalan TERPISAH dari loading Highcharts
+  // --- 2. UPDATE DATA (SSE /live, lihat js/live.js) ---
+  // Jalan TERPISAH dari loading Highcharts
   // Agar text data muncul duluan meskipun grafik belum siap.
-  function getSensorData() {
-    fetch('/homeLoad', { method: 'GET' })
-      .then(r => r.ok ? r.json() : Promise.reject(new Error(`HTTP ${r.status}`)))
-      .then(data => {
-        // A. Update Network Info
-        if (networkMode) networkMode.value = data.networkMode || '-';
-        if (ssid) ssid.value = data.ssid || '-';
-        if (ipAddres) ipAddres.value = data.ipAddress || '-';
-        if (sendInterval) sendInterval.value = data.sendInterval || '-';
-        if (protocolMode) protocolMode.value = data.protocolMode || '-';
-        if (endpoint) endpoint.value = data.endpoint || '-';
-        if (macAddress) macAddress.value = data.macAddress || '-';
-        if (connStatus) connStatus.value = data.connStatus || '-';
-        if (jobNumber) jobNumber.value = data.jobNumber || '-';
-
-        // B. Parse Sensor Data
-        const DI_values = (data.DI && data.DI.value) || [0, 0, 0, 0];
-        const DI_taskmode = (data.DI && data.DI.taskMode) || ['Normal', 'Counting', 'Cycle Time', 'Run Time'];
-        const AI_rawValues = (data.AI && data.AI.rawValue) || [0, 0, 0, 0];
-        const AI_scaledValues = (data.AI && data.AI.scaledValue) || [0, 0, 0, 0];
-        const enabled_AI = Array.isArray(data.enAI) ? data.enAI : [1, 1, 1, 1];
-
-        // C. Update Digital Input UI
-        for (let i = 0; i < 4; i++) {
-          if (diValues[i]) diValues[i].value = DI_values[i] ?? '0';
-          if (diTexts[i]) diTexts[i].textContent = DI_taskmode[i] ?? '-';
-          if (diUnits[i]) {
-            const mode = DI_taskmode[i];
-            diUnits[i].textContent =
-              mode === 'Counting' ? 'pcs' :
-                mode === 'Cycle Time' ? 'sec' :
-                  mode === 'Run Time' ? 'min' :
-                    mode === 'Pulse Mode' ? 'Hz' : '.';
-          }
+  function toHomeData(s) {
+    const m = s.meta || {};
+    return {
+      networkMode: m.networkMode, ssid: m.ssid, ipAddress: m.ipAddress, macAddress: m.macAddress,
+      sendInterval: m.sendInterval, protocolMode: m.protocolMode, endpoint: m.endpoint,
+      jobNumber: m.jobNumber, connStatus: s.conn, datetime: s.t, enAI: m.enAI,
+      AI: { rawValue: s.ai.map(p => p[0]), scaledValue: s.ai.map(p => p[1]) },
+      DI: { value: s.di, taskMode: m.diTaskMode }
+    };
+  }
+
+  function updateDashboard(live) {
+    const data = toHomeData(live);
+
+    // A. Update Network Info
+    if (networkMode) networkMode.value = data.networkMode || '-';
+    if (ssid) ssid.value = data.ssid || '-';
+    if (ipAddres) ipAddres.value = data.ipAddress || '-';
+    if (sendInterval) sendInterval.value = data.sendInterval || '-';
+    if (protocolMode) protocolMode.value = data.protocolMode || '-';
+    if (endpoint) endpoint.value = data.endpoint || '-';
+    if (macAddress) macAddress.value = data.macAddress || '-';
+    if (connStatus) connStatus.value = data.connStatus || '-';
+    if (jobNumber) jobNumber.value = data.jobNumber || '-';
+
+    // B. Parse Sensor Data
+    const DI_values = (data.DI && data.DI.value) || [0, 0, 0, 0];
+    const DI_taskmode = (data.DI && data.DI.taskMode) || ['Normal', 'Counting', 'Cycle Time', 'Run Time'];
+    const AI_rawValues = (data.AI && data.AI.rawValue) || [0, 0, 0, 0];
+    const AI_scaledValues = (data.AI && data.AI.scaledValue) || [0, 0, 0, 0];
+    const enabled_AI = Array.isArray(data.enAI) ? data.enAI : [1, 1, 1, 1];
+
+    // C. Update Digital Input UI
+    for (let i = 0; i < 4; i++) {
+      if (diValues[i]) diValues[i].value = DI_values[i] ?? '0';
+      if (diTexts[i]) diTexts[i].textContent = DI_taskmode[i] ?? '-';
+      if (diUnits[i]) {
+        const mode = DI_taskmode[i];
+        diUnits[i].textContent =
+          mode === 'Counting' ? 'pcs' :
+            mode === 'Cycle Time' ? 'sec' :
+              mode === 'Run Time' ? 'min' :
+                mode === 'Pulse Mode' ? 'Hz' : '.';
+      }
+    }
+
+    // D. Update Grafik (HANYA JIKA HIGHCHARTS SUDAH LOAD)
+    if (chartT && chartS) {
+      // 1. Atur Visibilitas (Sekali saja)
+      if (firstRun) {
+        for (let i = 0; i < enabled_AI.length && i < 4; i++) {
+          const isVisible = enabled_AI[i] === 1;
+          if (chartT.series[i]) chartT.series[i].setVisible(isVisible, false);
+          if (chartS.series[i]) chartS.series[i].setVisible(isVisible, false);
         }
+        chartT.redraw();
+        chartS.redraw();
+        firstRun = false;
+      }
+
+      // 2. Tentukan Waktu X-Axis
+      let x;
+      if (data.datetime && typeof data.datetime === 'string' && data.datetime.includes(' ')) {
+        const [dStr, tStr] = data.datetime.split(' ');
+        const [y, m, d] = dStr.split('-').map(v => parseInt(v, 10));
+        const [H, M, S] = tStr.split(':').map(v => parseInt(v, 10));
+        x = new Date(y, (m - 1), d, H, M, S).getTime() + (7 * 3600 * 1000);
+      } else {
+        x = Date.now();
+      }
 
-        // D. Update Grafik (HANYA JIKA HIGHCHARTS SUDAH LOAD)
-        if (chartT && chartS) {
-          // 1. Atur Visibilitas (Sekali saja)
-          if (firstRun) {
-            for (let i = 0; i < enabled_AI.length && i < 4; i++) {
-              const isVisible = enabled_AI[i] === 1;
-              if (chartT.series[i]) chartT.series[i].setVisible(isVisible, false);
-              if (chartS.series[i]) chartS.series[i].setVisible(isVisible, false);
-            }
-            chartT.redraw();
-            chartS.redraw();
-            firstRun = false;
-          }
-
-          // 2. Tentukan Waktu X-Axis
-          let x;
-          if (data.datetime && typeof data.datetime === 'string' && data.datetime.includes(' ')) {
-            const [dStr, tStr] = data.datetime.split(' ');
-            const [y, m, d] = dStr.split('-').map(v => parseInt(v, 10));
-            const [H, M, S] = tStr.split(':').map(v => parseInt(v, 10));
-            x = new Date(y, (m - 1), d, H, M, S).getTime() + (7 * 3600 * 1000);
-          } else {
-            x = Date.now();
-          }
-
-          // 3. Plot Data Raw
-          const sensorRawValues = AI_rawValues.map(v => Math.round((v || 0) * 100) / 100);
-          sensorRawValues.forEach((y, i) => {
-            if (enabled_AI[i] === 1 && chartT.series[i]) {
-              const shift = chartT.series[i].data.length > 40;
-              chartT.series[i].addPoint([x, y], false, shift, true);
-            }
-          });
-          chartT.redraw();
-
-          // 4. Plot Data Scaled
-          const sensorScaledValues = AI_scaledValues.map(v => Math.round((v || 0) * 100) / 100);
-          sensorScaledValues.forEach((y, i) => {
-            if (enabled_AI[i] === 1 && chartS.series[i]) {
-              const shift = chartS.series[i].data.length > 40;
-              chartS.series[i].addPoint([x, y], false, shift, true);
-            }
-          });
-          chartS.redraw();
+      // 3. Plot Data Raw
+      const sensorRawValues = AI_rawValues.map(v => Math.round((v || 0) * 100) / 100);
+      sensorRawValues.forEach((y, i) => {
+        if (enabled_AI[i] === 1 && chartT.series[i]) {
+          const shift = chartT.series[i].data.length > 40;
+          chartT.series[i].addPoint([x, y], false, shift, true);
         }
-      })
-      .catch(err => console.error('Data fetch error:', err));
+      });
+      chartT.redraw();
+
+      // 4. Plot Data Scaled
+      const sensorScaledValues = AI_scaledValues.map(v => Math.round((v || 0) * 100) / 100);
+      sensorScaledValues.forEach((y, i) => {
+        if (enabled_AI[i] === 1 && chartS.series[i]) {
+          const shift = chartS.series[i].data.length > 40;
+          chartS.series[i].addPoint([x, y], false, shift, true);
+        }
+      });
+      chartS.redraw();
+    }
   }
 
   // --- 3. FUNGSI LAZY LOAD HIGHCHARTS ---
@@ -152,9 +160,8 @@ document.addEventListener("DOMContentLoaded", () => {
 
   // --- 4. MAIN EXECUTION ---
 
-  // A. Mulai Polling Data Text SEKARANG (Agar dashboard terasa cepat)
-  getSensorData();
-  setInterval(getSensorData, 2000);
+  // A. Langganan data live SEKARANG (Agar dashboard terasa cepat)
+  LiveData.subscribe(updateDashboard);
 
   // B. Mulai Download Highcharts di Background
   loadHighcharts(() => {
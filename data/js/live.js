@@ -0,0 +1,51 @@
+/* js/live.js
+ * Satu koneksi SSE ke /live per halaman. Server mengirim:
+ *   meta  : info statis (network, nama & mode channel)
+ *   full  : state lengkap saat pertama connect
+ *   delta : hanya field yang berubah
+ * State digabung di sini, halaman cukup subscribe(callback).
+ */
+const LiveData = (function () {
+  const state = { meta: {}, t: null, ai: [], di: [], v: {}, conn: '-' };
+  const listeners = [];
+  let source = null;
+
+  function notify() {
+    listeners.forEach(cb => {
+      try { cb(state); } catch (err) { console.error('Live listener error:', err); }
+    });
+  }
+
+  function applyFull(f) {
+    state.t = f.t;
+    state.ai = f.ai || [];
+    state.di = f.di || [];
+    state.v = f.v || {};
+    if (f.conn !== undefined) state.conn = f.conn;
+  }
+
+  function applyDelta(d) {
+    if (d.t) state.t = d.t;
+    if (d.ai) Object.keys(d.ai).forEach(i => { state.ai[+i] = d.ai[i]; });
+    if (d.di) Object.keys(d.di).forEach(i => { state.di[+i] = d.di[i]; });
+    if (d.v) Object.assign(state.v, d.v);
+    if (d.conn !== undefined) state.conn = d.conn;
+  }
+
+  function connect() {
+    source = new EventSource('/live');
+    source.addEventListener('meta', e => { state.meta = JSON.parse(e.data); });
+    source.addEventListener('full', e => { applyFull(JSON.parse(e.data)); notify(); });
+    source.addEventListener('delta', e => { applyDelta(JSON.parse(e.data)); notify(); });
+    // EventSource reconnect otomatis, server kirim ulang meta + full
+    source.onerror = () => console.warn('Live stream disconnected, retrying...');
+  }
+
+  return {
+    state,
+    subscribe(cb) {
+      listeners.push(cb);
+      if (!source) connect();
+    }
+  };
+})();
@@ -25,6 +25,7 @@ document.addEventListener("DOMContentLoaded", function () {
     var multiplier = document.getElementById('multiplier');
     var realtimeValue = document.getElementById('realtimeValue');
     var offsetAddress = document.getElementById('offsetAddress');
+    var deviceIp = document.getElementById('deviceIp');
 
     // --- Load Data Awal ---
     fetch('/modbusLoad', { method: "GET" })
@@ -80,7 +81,8 @@ document.addEventListener("DOMContentLoaded", function () {
             parseInt(functionCode.value), 
             parseInt(registerAddress.value), 
             parseFloat(multiplier.value), 
-            parseInt(offsetAddress.value)
+            parseInt(offsetAddress.value),
+            deviceIp.value.trim()
         ];
         submitForm();
     });
@@ -102,7 +104,8 @@ document.addEventListener("DOMContentLoaded", function () {
             functionCode.value, 
             registerAddress.value, 
             multiplier.value, 
-            offsetAddress.value
+            offsetAddress.value,
+            deviceIp.value.trim()
         ];
         // Set dropdown ke item baru
         parameterList.value = paramName.value; 
@@ -132,6 +135,7 @@ document.addEventListener("DOMContentLoaded", function () {
             registerAddress.value = "";
             multiplier.value = "";
             offsetAddress.value = "";
+            deviceIp.value = "";
 
             submitForm();
         } else {
@@ -153,6 +157,7 @@ document.addEventListener("DOMContentLoaded", function () {
             registerAddress.value = modbusData[key][2];
             multiplier.value = modbusData[key][3];
             offsetAddress.value = modbusData[key][4];
+            deviceIp.value = modbusData[key][5] || "";
         }
     }
 
@@ -204,21 +209,9 @@ document.addEventListener("DOMContentLoaded", function () {
             .catch(error => console.error('An error occurred:', error));
     }
 
-    function getModbusReading() {
-        fetch('/getValue', { method: "GET" })
-            .then(response => response.json())
-            .then(data => {
-                let found = false;
-                for (let i = 0; i < data.length; i++) {
-                    if (data[i].KodeSensor === parameterList.value) {
-                        realtimeValue.innerHTML = Math.round(data[i].Value * 100) / 100;
-                        found = true;
-                        break;
-                    }
-                }
-                if (!found) realtimeValue.innerHTML = "-";
-            })
-            .catch(error => console.error("Polling error:", error));
+    function showModbusReading(live) {
+        const value = live.v[parameterList.value];
+        realtimeValue.innerHTML = value !== undefined ? Math.round(parseFloat(value) * 100) / 100 : "-";
     }
     
     // Tombol Close Popup (meskipun ada di common.js, di sini ada logic display: none spesifik)
@@ -228,6 +221,6 @@ document.addEventListener("DOMContentLoaded", function () {
         });
     }
 
-    // Polling setiap 2 detik
-    setInterval(getModbusReading, 2000);
+    // Data realtime lewat SSE /live
+    LiveData.subscribe(showModbusReading);
 });
\ No newline at end of file
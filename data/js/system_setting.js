@@ -10,6 +10,7 @@ document.addEventListener("DOMContentLoaded", function () {
         username: document.getElementById('username'),
         password: document.getElementById('password'),
         sdInterval: document.getElementById('sdInterval'),
+        liveInterval: document.getElementById('liveInterval'),
         settingsForm: document.getElementById('settingsForm')
     };
 
@@ -32,6 +33,7 @@ document.addEventListener("DOMContentLoaded", function () {
             elements.username.value = data.username;
             elements.password.value = data.password;
             elements.sdInterval.value = data.sdInterval || 5;
+            elements.liveInterval.value = data.liveInterval || 1000;
         })
         .catch(error => console.error("Error:", error));
 
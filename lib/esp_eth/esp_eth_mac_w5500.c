@@ -37,11 +37,16 @@
 #include "esp_intr_alloc.h"
 #include "esp_heap_caps.h"
 #include "esp_rom_gpio.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "hal/cpu_hal.h"
+#include "lwip/pbuf.h"
+#include "lwip/netif.h"
 #include "w5500.h"
+#include "esp_eth_w5500.h"
 #include "sdkconfig.h"
 
 ////////////////////////////////////////
@@ -52,9 +57,23 @@ static const char *TAG = "w5500.mac";
 #define W5500_TX_MEM_SIZE (0x4000)
 #define W5500_RX_MEM_SIZE (0x4000)
 
+// transfers longer than this go through queued (interrupt driven) DMA instead of polling
+#define W5500_SPI_POLLING_MAX_LEN (64)
+
 ////////////////////////////////////////
 
+struct emac_w5500_s;
+
 typedef struct
+{
+#if LWIP_SUPPORT_CUSTOM_PBUF
+  struct pbuf_custom pbuf;              // handed to lwIP, custom_free_function returns the slot
+#endif
+  struct emac_w5500_s *owner;
+  uint8_t data[ETH_MAX_PACKET_SIZE] __attribute__((aligned(4)));
+} w5500_rx_slot_t;
+
+typedef struct emac_w5500_s
 {
   esp_eth_mac_t parent;
   esp_eth_mediator_t *eth;
@@ -65,8 +84,18 @@ typedef struct
   int int_gpio_num;
   uint8_t addr[6];
   bool packets_remain;
+  w5500_rx_slot_t *rx_pool;             // ETH_W5500_RX_POOL_COUNT slots, DMA capable
+  QueueHandle_t rx_free;                // free list of rx_pool slots
+  struct netif *lwip_netif;
+  volatile bool rx_pool_enabled;        // set once the lwIP input path can return pool slots
+  int spi_clock_mhz;                    // current SPI clock, 0 = not set through esp_eth_mac_w5500_set_clock()
+  portMUX_TYPE stats_lock;              // stats are written by the RX task and read from other cores
+  eth_w5500_stats_t stats;
 } emac_w5500_t;
 
+// esp_eth_spi_w5500.c: switch to the SPI device running at another clock (no transaction may be in flight)
+esp_err_t w5500_spi_set_clock(spi_device_handle_t *spi_handle, int clock_speed_mhz);
+
 ////////////////////////////////////////
 
 static inline bool w5500_lock(emac_w5500_t *emac)
@@ -249,6 +278,76 @@ err:
 
 ////////////////////////////////////////
 
+static inline void w5500_fill_read_trans(spi_transaction_t *trans, uint32_t address, void *buf, uint32_t len)
+{
+  memset(trans, 0, sizeof(*trans));
+  trans->cmd = (address >> W5500_ADDR_OFFSET);
+  trans->addr = ((address & 0xFFFF) | (W5500_ACCESS_MODE_READ << W5500_RWB_OFFSET) | W5500_SPI_OP_MODE_VDM);
+  // round up to a word so spi_master can DMA straight into the buffer without a bounce copy,
+  // callers always provide ETH_MAX_PACKET_SIZE buffers so the extra bytes are harmless
+  trans->length = 8 * ((len + 3) & ~3);
+  trans->rx_buffer = buf;
+}
+
+////////////////////////////////////////
+
+static esp_err_t w5500_read_buffer_dma(emac_w5500_t *emac, uint8_t *buf, uint32_t len, uint16_t offset)
+{
+  esp_err_t ret = ESP_OK;
+  spi_transaction_t trans[2];
+  spi_transaction_t *done = NULL;
+  uint32_t first = len;
+  int count = 1;
+  int queued = 0;
+
+  if (offset + len > W5500_RX_MEM_SIZE)
+  {
+    first = W5500_RX_MEM_SIZE - offset;
+    count = 2;
+  }
+
+  w5500_fill_read_trans(&trans[0], W5500_MEM_SOCK_RX(0, offset), buf, first);
+
+  if (count == 2)
+  {
+    // wrapped frame: second segment starts at the beginning of the RX memory
+    w5500_fill_read_trans(&trans[1], W5500_MEM_SOCK_RX(0, 0), buf + first, len - first);
+  }
+
+  if (!w5500_lock(emac))
+  {
+    return ESP_ERR_TIMEOUT;
+  }
+
+  // queue both segments back to back, the task blocks (no busy-wait) until DMA completes
+  for (int i = 0; i < count; i++)
+  {
+    if (spi_device_queue_trans(emac->spi_hdl, &trans[i], portMAX_DELAY) != ESP_OK)
+    {
+      ESP_LOGE(TAG, "%s(%d): SPI queue failed", __FUNCTION__, __LINE__);
+      ret = ESP_FAIL;
+      break;
+    }
+
+    queued++;
+  }
+
+  while (queued--)
+  {
+    if (spi_device_get_trans_result(emac->spi_hdl, &done, portMAX_DELAY) != ESP_OK)
+    {
+      ESP_LOGE(TAG, "%s(%d): SPI transmit failed", __FUNCTION__, __LINE__);
+      ret = ESP_FAIL;
+    }
+  }
+
+  w5500_unlock(emac);
+
+  return ret;
+}
+
+////////////////////////////////////////
+
 static esp_err_t w5500_read_buffer(emac_w5500_t *emac, void *buffer, uint32_t len, uint16_t offset)
 {
   esp_err_t ret = ESP_OK;
@@ -256,6 +355,11 @@ static esp_err_t w5500_read_buffer(emac_w5500_t *emac, void *buffer, uint32_t le
   uint8_t *buf = buffer;
   offset %= W5500_RX_MEM_SIZE;
 
+  if (len > W5500_SPI_POLLING_MAX_LEN)
+  {
+    return w5500_read_buffer_dma(emac, buf, len, offset);
+  }
+
   if (offset + len > W5500_RX_MEM_SIZE)
   {
     remain = (offset + len) % W5500_RX_MEM_SIZE;
@@ -431,12 +535,105 @@ IRAM_ATTR static void w5500_isr_handler(void *arg)
 
 ////////////////////////////////////////
 
+static void w5500_rx_slot_put(w5500_rx_slot_t *slot)
+{
+  emac_w5500_t *emac = slot->owner;
+
+  xQueueSend(emac->rx_free, &slot, 0);
+}
+
+////////////////////////////////////////
+
+static inline bool w5500_is_pool_buffer(emac_w5500_t *emac, const uint8_t *buf)
+{
+  const uint8_t *start = (const uint8_t *) emac->rx_pool;
+  const uint8_t *end = (const uint8_t *)(emac->rx_pool + ETH_W5500_RX_POOL_COUNT);
+
+  return emac->rx_pool && buf >= start && buf < end;
+}
+
+////////////////////////////////////////
+
+#if LWIP_SUPPORT_CUSTOM_PBUF
+static void w5500_rx_pbuf_free(struct pbuf *p)
+{
+  // pbuf is the first member of the slot
+  w5500_rx_slot_put((w5500_rx_slot_t *) p);
+}
+#endif
+
+////////////////////////////////////////
+
+// stack_input replacement installed by esp_eth_mac_w5500_attach_lwip()
+static esp_err_t w5500_lwip_input(esp_eth_handle_t eth_handle, uint8_t *buffer, uint32_t length, void *priv)
+{
+  emac_w5500_t *emac = (emac_w5500_t *) priv;
+  struct netif *netif = emac->lwip_netif;
+  struct pbuf *p = NULL;
+  w5500_rx_slot_t *slot = NULL;
+
+  if (w5500_is_pool_buffer(emac, buffer))
+  {
+    slot = __containerof(buffer, w5500_rx_slot_t, data);
+  }
+
+  if (netif_is_up(netif))
+  {
+#if LWIP_SUPPORT_CUSTOM_PBUF
+
+    if (slot)
+    {
+      // zero copy: lwIP holds the slot until the last pbuf reference is released
+      slot->pbuf.custom_free_function = w5500_rx_pbuf_free;
+      p = pbuf_alloced_custom(PBUF_RAW, length, PBUF_REF, &slot->pbuf, buffer, ETH_MAX_PACKET_SIZE);
+      slot = p ? NULL : slot;
+    }
+    else
+#endif
+    {
+      // heap buffer (frame received before the pool path was enabled) or no custom pbuf support
+      p = pbuf_alloc(PBUF_RAW, length, PBUF_RAM);
+
+      if (p)
+      {
+        pbuf_take(p, buffer, length);
+      }
+    }
+  }
+
+  // buffer not handed over to lwIP as a custom pbuf: release it here
+  if (slot)
+  {
+    w5500_rx_slot_put(slot);
+  }
+  else if (!w5500_is_pool_buffer(emac, buffer))
+  {
+    free(buffer);
+  }
+
+  if (p == NULL)
+  {
+    return ESP_FAIL;
+  }
+
+  if (netif->input(p, netif) != ERR_OK)
+  {
+    pbuf_free(p);
+  }
+
+  return ESP_OK;
+}
+
+////////////////////////////////////////
+
 static void emac_w5500_task(void *arg)
 {
   emac_w5500_t *emac = (emac_w5500_t *)arg;
   uint8_t status = 0;
   uint8_t *buffer = NULL;
   uint32_t length = 0;
+  w5500_rx_slot_t *slot = NULL;
+  int64_t busy_start = 0;
 
   while (1)
   {
@@ -458,33 +655,58 @@ static void emac_w5500_task(void *arg)
       // clear interrupt status
       w5500_write(emac, W5500_REG_SOCK_IR(0), &status, sizeof(status));
 
+      busy_start = esp_timer_get_time();
+
       do
       {
         length = ETH_MAX_PACKET_SIZE;
-        buffer = heap_caps_malloc(length, MALLOC_CAP_DMA);
+        slot = NULL;
 
-        if (!buffer)
+        if (emac->rx_pool_enabled)
         {
-          ESP_LOGE(TAG, "No mem for receive buffer");
-          break;
-        }
-        else if (emac->parent.receive(&emac->parent, buffer, &length) == ESP_OK)
-        {
-          /* pass the buffer to stack (e.g. TCP/IP layer) */
-          if (length)
+          if (xQueueReceive(emac->rx_free, &slot, 0) != pdTRUE)
           {
-            emac->eth->stack_input(emac->eth, buffer, length);
+            // every slot is still owned by lwIP: discard the frame inside the w5500
+            emac->parent.receive(&emac->parent, NULL, &length);
+            portENTER_CRITICAL(&emac->stats_lock);
+            emac->stats.rx_dropped++;
+            portEXIT_CRITICAL(&emac->stats_lock);
+            continue;
           }
-          else
+
+          buffer = slot->data;
+        }
+        else
+        {
+          buffer = heap_caps_malloc(length, MALLOC_CAP_DMA);
+
+          if (!buffer)
           {
-            free(buffer);
+            ESP_LOGE(TAG, "No mem for receive buffer");
+            break;
           }
         }
+
+        if (emac->parent.receive(&emac->parent, buffer, &length) == ESP_OK && length)
+        {
+          portENTER_CRITICAL(&emac->stats_lock);
+          emac->stats.rx_frames++;
+          emac->stats.rx_bytes += length;
+          portEXIT_CRITICAL(&emac->stats_lock);
+
+          /* pass the buffer to stack (e.g. TCP/IP layer) */
+          emac->eth->stack_input(emac->eth, buffer, length);
+        }
         else
         {
-          free(buffer);
+          slot ? w5500_rx_slot_put(slot) : free(buffer);
         }
       } while (emac->packets_remain);
+
+      int64_t busy_us = esp_timer_get_time() - busy_start;
+      portENTER_CRITICAL(&emac->stats_lock);
+      emac->stats.rx_busy_us += busy_us;
+      portEXIT_CRITICAL(&emac->stats_lock);
     }
   }
 
@@ -781,9 +1003,21 @@ static esp_err_t emac_w5500_receive(esp_eth_mac_t *mac, uint8_t *buf, uint32_t *
     rx_len = __builtin_bswap16(rx_len) - 2; // data size includes 2 bytes of header
     offset += 2;
 
-    // read the payload
-    ESP_GOTO_ON_ERROR(w5500_read_buffer(emac, buf, rx_len, offset), err, TAG, "Read payload failed, len=%d, offset=%d",
-                      rx_len, offset);
+    if (rx_len > ETH_MAX_PACKET_SIZE - 4)
+    {
+      // corrupted header, skip the frame instead of overrunning the caller's buffer
+      portENTER_CRITICAL(&emac->stats_lock);
+      emac->stats.rx_dropped++;
+      portEXIT_CRITICAL(&emac->stats_lock);
+      buf = NULL;
+    }
+
+    // read the payload (buf == NULL: caller only wants the frame discarded)
+    if (buf)
+    {
+      ESP_GOTO_ON_ERROR(w5500_read_buffer(emac, buf, rx_len, offset), err, TAG, "Read payload failed, len=%d, offset=%d",
+                        rx_len, offset);
+    }
 
     offset += rx_len;
 
@@ -799,7 +1033,7 @@ static esp_err_t emac_w5500_receive(esp_eth_mac_t *mac, uint8_t *buf, uint32_t *
     emac->packets_remain = remain_bytes > 0;
   }
 
-  *length = rx_len;
+  *length = buf ? rx_len : 0;
 
 err:
   return ret;
@@ -865,6 +1099,8 @@ static esp_err_t emac_w5500_del(esp_eth_mac_t *mac)
 
   vTaskDelete(emac->rx_task_hdl);
   vSemaphoreDelete(emac->spi_lock);
+  vQueueDelete(emac->rx_free);
+  heap_caps_free(emac->rx_pool);
   free(emac);
 
   return ESP_OK;
@@ -872,6 +1108,81 @@ static esp_err_t emac_w5500_del(esp_eth_mac_t *mac)
 
 ////////////////////////////////////////
 
+esp_err_t esp_eth_mac_w5500_attach_lwip(esp_eth_handle_t eth_handle, esp_eth_mac_t *mac, void *lwip_netif)
+{
+  esp_err_t ret = ESP_OK;
+  ESP_GOTO_ON_FALSE(eth_handle && mac && lwip_netif, ESP_ERR_INVALID_ARG, err, TAG, "Invalid argument");
+
+  emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+  emac->lwip_netif = (struct netif *) lwip_netif;
+
+  ESP_GOTO_ON_ERROR(esp_eth_update_input_path(eth_handle, w5500_lwip_input, emac), err, TAG,
+                    "Update input path failed");
+
+  // from now on frames go through w5500_lwip_input, which knows how to give pool slots back
+  emac->rx_pool_enabled = true;
+
+err:
+  return ret;
+}
+
+////////////////////////////////////////
+
+esp_err_t esp_eth_mac_w5500_get_stats(esp_eth_mac_t *mac, eth_w5500_stats_t *stats)
+{
+  esp_err_t ret = ESP_OK;
+  ESP_GOTO_ON_FALSE(mac && stats, ESP_ERR_INVALID_ARG, err, TAG, "Invalid argument");
+
+  emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+  portENTER_CRITICAL(&emac->stats_lock);
+  *stats = emac->stats;
+  portEXIT_CRITICAL(&emac->stats_lock);
+  stats->rx_pool_free = uxQueueMessagesWaiting(emac->rx_free);
+
+err:
+  return ret;
+}
+
+////////////////////////////////////////
+
+esp_err_t esp_eth_mac_w5500_set_clock(esp_eth_mac_t *mac, int clock_speed_mhz)
+{
+  esp_err_t ret = ESP_OK;
+  ESP_GOTO_ON_FALSE(mac && clock_speed_mhz >= W5500_SPI_CLOCK_MIN_MHZ &&
+                    clock_speed_mhz <= W5500_SPI_CLOCK_MAX_MHZ, ESP_ERR_INVALID_ARG, err, TAG,
+                    "Invalid argument");
+
+  emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+
+  if (emac->spi_clock_mhz == clock_speed_mhz)
+  {
+    return ESP_OK;
+  }
+
+  // every w5500 SPI access (polled and queued DMA) runs under spi_lock, so nothing is in flight here
+  ESP_GOTO_ON_FALSE(w5500_lock(emac), ESP_ERR_TIMEOUT, err, TAG, "SPI lock timeout");
+  ret = w5500_spi_set_clock(&emac->spi_hdl, clock_speed_mhz);
+
+  if (ret == ESP_OK)
+  {
+    emac->spi_clock_mhz = clock_speed_mhz;
+  }
+
+  w5500_unlock(emac);
+
+err:
+  return ret;
+}
+
+////////////////////////////////////////
+
+int esp_eth_mac_w5500_get_clock(esp_eth_mac_t *mac)
+{
+  return mac ? __containerof(mac, emac_w5500_t, parent)->spi_clock_mhz : 0;
+}
+
+////////////////////////////////////////
+
 esp_eth_mac_t *esp_eth_mac_new_w5500(const eth_w5500_config_t *w5500_config, const eth_mac_config_t *mac_config)
 {
   esp_eth_mac_t *ret = NULL;
@@ -889,6 +1200,7 @@ esp_eth_mac_t *esp_eth_mac_new_w5500(const eth_w5500_config_t *w5500_config, con
   emac->sw_reset_timeout_ms = mac_config->sw_reset_timeout_ms;
   emac->int_gpio_num = w5500_config->int_gpio_num;
   emac->spi_hdl = w5500_config->spi_hdl;
+  portMUX_INITIALIZE(&emac->stats_lock);
   emac->parent.set_mediator = emac_w5500_set_mediator;
   emac->parent.init = emac_w5500_init;
   emac->parent.deinit = emac_w5500_deinit;
@@ -912,6 +1224,19 @@ esp_eth_mac_t *esp_eth_mac_new_w5500(const eth_w5500_config_t *w5500_config, con
   emac->spi_lock = xSemaphoreCreateMutex();
   ESP_GOTO_ON_FALSE(emac->spi_lock, NULL, err, TAG, "Create lock failed");
 
+  /* preallocate RX frame pool once, instead of a DMA malloc per received frame */
+  emac->rx_pool = heap_caps_calloc(ETH_W5500_RX_POOL_COUNT, sizeof(w5500_rx_slot_t), MALLOC_CAP_DMA);
+  ESP_GOTO_ON_FALSE(emac->rx_pool, NULL, err, TAG, "No mem for RX pool");
+  emac->rx_free = xQueueCreate(ETH_W5500_RX_POOL_COUNT, sizeof(w5500_rx_slot_t *));
+  ESP_GOTO_ON_FALSE(emac->rx_free, NULL, err, TAG, "Create RX pool queue failed");
+
+  for (int i = 0; i < ETH_W5500_RX_POOL_COUNT; i++)
+  {
+    w5500_rx_slot_t *slot = &emac->rx_pool[i];
+    slot->owner = emac;
+    xQueueSend(emac->rx_free, &slot, 0);
+  }
+
   /* create w5500 task */
   BaseType_t core_num = tskNO_AFFINITY;
 
@@ -940,6 +1265,12 @@ err:
       vSemaphoreDelete(emac->spi_lock);
     }
 
+    if (emac->rx_free)
+    {
+      vQueueDelete(emac->rx_free);
+    }
+
+    heap_caps_free(emac->rx_pool);
     free(emac);
   }
 
@@ -21,12 +21,44 @@
 #include "driver/gpio.h"
 #include "esp_eth_w5500.h"
 #include "driver/spi_master.h"
+#include "hal/gpio_ll.h"
+#include "esp_attr.h"
 
 #include "esp_log.h"
 #include "esp_check.h"
 
 static const char *TAG = "w5500.spi";
 
+// spi_master has no call to change the clock of an added device, so w5500_spi_set_clock() keeps
+// one device per clock and switches the MAC between them. Devices are added once per clock, never
+// per switch: the SD lease toggles between two clocks, both stay registered.
+typedef struct
+{
+  spi_device_handle_t handle;
+  int clock_mhz;
+} w5500_spi_dev_t;
+
+static spi_device_interface_config_t s_devcfg;
+static spi_host_device_t s_host;
+static w5500_spi_dev_t s_dev[2];
+static int s_active;
+
+// Both devices use the same CS pin, but the GPIO matrix routes a pin to one CS signal only,
+// so CS is driven from the transaction callbacks (polled and queued) instead of the SPI peripheral
+static int s_cs_gpio = -1;
+
+static void IRAM_ATTR w5500_spi_cs_low(spi_transaction_t *trans)
+{
+  (void)trans;
+  gpio_ll_set_level(&GPIO, s_cs_gpio, 0);
+}
+
+static void IRAM_ATTR w5500_spi_cs_high(spi_transaction_t *trans)
+{
+  (void)trans;
+  gpio_ll_set_level(&GPIO, s_cs_gpio, 1);
+}
+
 ////////////////////////////////////////
 
 esp_eth_mac_t* w5500_new_mac( spi_device_handle_t *spi_handle, int INT_GPIO )
@@ -51,7 +83,10 @@ esp_eth_mac_t* w5500_new_mac( spi_device_handle_t *spi_handle, int INT_GPIO )
 esp_eth_mac_t* w5500_begin(int MISO_GPIO, int MOSI_GPIO, int SCLK_GPIO, int CS_GPIO, int INT_GPIO, int SPICLOCK_MHZ,
                            int SPIHOST)
 {
-  if (ESP_OK != gpio_install_isr_service(0))
+  // ISR service may already be installed by Arduino attachInterrupt()
+  esp_err_t err = gpio_install_isr_service(0);
+
+  if ((ESP_OK != err) && (ESP_ERR_INVALID_STATE != err))
   {
     ESP_LOGE(TAG, "%s(%d): Error gpio_install_isr_service", __FUNCTION__, __LINE__);
 
@@ -68,7 +103,10 @@ esp_eth_mac_t* w5500_begin(int MISO_GPIO, int MOSI_GPIO, int SCLK_GPIO, int CS_G
     .quadhd_io_num = -1,
   };
 
-  if ( ESP_OK != spi_bus_initialize( SPIHOST, &buscfg, 1 ))
+  // The bus may already be initialized by another device sharing it (SD card)
+  err = spi_bus_initialize( SPIHOST, &buscfg, 1 );
+
+  if ((ESP_OK != err) && (ESP_ERR_INVALID_STATE != err))
   {
     ESP_LOGE(TAG, "%s(%d): Error spi_bus_initialize", __FUNCTION__, __LINE__);
 
@@ -81,11 +119,17 @@ esp_eth_mac_t* w5500_begin(int MISO_GPIO, int MOSI_GPIO, int SCLK_GPIO, int CS_G
     .address_bits = 8,
     .mode = 0,
     .clock_speed_hz = SPICLOCK_MHZ * 1000 * 1000,
-    .spics_io_num = CS_GPIO,
+    .spics_io_num = -1,
     .queue_size = 20,
-    .cs_ena_posttrans = w5500_cal_spi_cs_hold_time(SPICLOCK_MHZ),
+    .pre_cb = w5500_spi_cs_low,
+    .post_cb = w5500_spi_cs_high,
   };
 
+  // CS idles high; post_cb runs after the last clock edge, well past the w5500 CS hold time
+  s_cs_gpio = CS_GPIO;
+  gpio_set_direction((gpio_num_t)CS_GPIO, GPIO_MODE_OUTPUT);
+  gpio_set_level((gpio_num_t)CS_GPIO, 1);
+
   spi_device_handle_t spi_handle = NULL;
 
   if (ESP_OK != spi_bus_add_device( SPIHOST, &devcfg, &spi_handle ))
@@ -95,7 +139,55 @@ esp_eth_mac_t* w5500_begin(int MISO_GPIO, int MOSI_GPIO, int SCLK_GPIO, int CS_G
     return NULL;
   }
 
-  return w5500_new_mac( &spi_handle, INT_GPIO );
+  s_devcfg = devcfg;
+  s_host = SPIHOST;
+  s_dev[0].handle = spi_handle;
+  s_dev[0].clock_mhz = SPICLOCK_MHZ;
+  s_active = 0;
+
+  esp_eth_mac_t *mac = w5500_new_mac( &spi_handle, INT_GPIO );
+
+  if (mac)
+  {
+    esp_eth_mac_w5500_set_clock(mac, SPICLOCK_MHZ); // records the clock, device already runs at it
+  }
+
+  return mac;
+}
+
+////////////////////////////////////////
+
+esp_err_t w5500_spi_set_clock(spi_device_handle_t *spi_handle, int SPICLOCK_MHZ)
+{
+  if (s_dev[s_active].clock_mhz == SPICLOCK_MHZ)
+  {
+    return ESP_OK;
+  }
+
+  int spare = !s_active;
+
+  if (s_dev[spare].clock_mhz != SPICLOCK_MHZ)
+  {
+    // first change, or a third clock: (re)build the spare device, the active one keeps working until then
+    if (s_dev[spare].handle)
+    {
+      ESP_RETURN_ON_ERROR(spi_bus_remove_device(s_dev[spare].handle), TAG, "Error spi_bus_remove_device");
+      s_dev[spare].handle = NULL;
+      s_dev[spare].clock_mhz = 0;
+    }
+
+    spi_device_interface_config_t devcfg = s_devcfg;
+    devcfg.clock_speed_hz = SPICLOCK_MHZ * 1000 * 1000;
+
+    ESP_RETURN_ON_ERROR(spi_bus_add_device(s_host, &devcfg, &s_dev[spare].handle), TAG,
+                        "Error spi_bus_add_device at %d MHz", SPICLOCK_MHZ);
+    s_dev[spare].clock_mhz = SPICLOCK_MHZ;
+  }
+
+  s_active = spare;
+  *spi_handle = s_dev[spare].handle;
+
+  return ESP_OK;
 }
 
 ////////////////////////////////////////
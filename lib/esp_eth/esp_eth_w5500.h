@@ -40,6 +40,26 @@ extern "C" {
 
 #define CS_HOLD_TIME_MIN_NS     210
 
+// Number of preallocated DMA-capable RX frame buffers handed to lwIP
+#ifndef ETH_W5500_RX_POOL_COUNT
+  #define ETH_W5500_RX_POOL_COUNT 8
+#endif
+
+////////////////////////////////////////
+
+/**
+   @brief RX path counters of the w5500 MAC. Counters are free running, callers
+          compute rates (frames/sec, CPU%) from the difference of two snapshots.
+*/
+typedef struct
+{
+  uint32_t rx_frames;     //!< Frames handed to the TCP/IP stack
+  uint32_t rx_bytes;      //!< Payload bytes handed to the TCP/IP stack
+  uint32_t rx_dropped;    //!< Frames discarded in the w5500 (pool exhausted or bad length)
+  uint32_t rx_pool_free;  //!< RX pool buffers currently free (snapshot)
+  uint64_t rx_busy_us;    //!< Time spent by the RX task servicing frames
+} eth_w5500_stats_t;
+
 ////////////////////////////////////////
 
 /*
@@ -61,6 +81,13 @@ extern "C" {
 */
 
 
+////////////////////////////////////////
+
+// SPI clock range of the w5500, checked by ESP32_W5500::begin() and esp_eth_mac_w5500_set_clock().
+// Above 20 MHz the CS hold time below can no longer be met.
+#define W5500_SPI_CLOCK_MIN_MHZ 1
+#define W5500_SPI_CLOCK_MAX_MHZ 20
+
 ////////////////////////////////////////
 
 /**
@@ -72,7 +99,7 @@ extern "C" {
 */
 static inline uint8_t w5500_cal_spi_cs_hold_time(int clock_speed_mhz)
 {
-  if (clock_speed_mhz <= 0 || clock_speed_mhz > 20)
+  if (clock_speed_mhz < W5500_SPI_CLOCK_MIN_MHZ || clock_speed_mhz > W5500_SPI_CLOCK_MAX_MHZ)
   {
     return 0;
   }
@@ -133,6 +160,52 @@ esp_err_t w5500_set_phy_duplex(esp_eth_phy_t *phy, eth_duplex_t duplex);
 
 ////////////////////////////////////////
 
+/**
+   @brief Route received frames straight into lwIP using the preallocated RX pool.
+          Buffers are wrapped in custom pbufs and returned to the pool by their free
+          callback instead of going through malloc()/free() per frame.
+
+   @param eth_handle Ethernet driver handle (already attached to its esp_netif)
+   @param mac w5500 MAC Handle
+   @param lwip_netif lwIP netif of the Ethernet interface (esp_netif_get_netif_impl())
+
+   @return esp_err_t
+            - ESP_OK when the input path was switched
+*/
+esp_err_t esp_eth_mac_w5500_attach_lwip(esp_eth_handle_t eth_handle, esp_eth_mac_t *mac, void *lwip_netif);
+
+/**
+   @brief Read the RX path counters of the w5500 MAC.
+
+   @param mac w5500 MAC Handle
+   @param stats Output counters
+
+   @return esp_err_t
+            - ESP_OK on success
+*/
+esp_err_t esp_eth_mac_w5500_get_stats(esp_eth_mac_t *mac, eth_w5500_stats_t *stats);
+
+/**
+   @brief Change the SPI clock of the w5500 at runtime. Waits for the current SPI
+          access to finish, then switches to the SPI device registered for that
+          clock (added on first use, then reused). Other devices on the bus keep
+          their own clock.
+
+   @param mac w5500 MAC Handle
+   @param clock_speed_mhz SPI Clock frequency in MHz (valid range is <1, 20>)
+
+   @return esp_err_t
+            - ESP_OK when the clock was changed (or already set)
+*/
+esp_err_t esp_eth_mac_w5500_set_clock(esp_eth_mac_t *mac, int clock_speed_mhz);
+
+/**
+   @brief Current SPI clock of the w5500 in MHz (0 if unknown)
+*/
+int esp_eth_mac_w5500_get_clock(esp_eth_mac_t *mac);
+
+////////////////////////////////////////
+
 #ifdef __cplusplus
 }
 #endif
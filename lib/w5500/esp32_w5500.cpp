@@ -40,7 +40,9 @@ extern void tcpipInit();
 ESP32_W5500::ESP32_W5500()
   : initialized(false)
   , staticIP(false)
+  , gotIP(false)
   , eth_handle(NULL)
+  , eth_mac(NULL)
   , started(false)
   , eth_link(ETH_LINK_DOWN)
 {
@@ -53,6 +55,52 @@ ESP32_W5500::~ESP32_W5500()
 
 ////////////////////////////////////////
 
+void ESP32_W5500::eth_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
+{
+  ESP32_W5500 *self = (ESP32_W5500 *) arg;
+
+  if (event_base == ETH_EVENT)
+  {
+    switch (event_id)
+    {
+      case ETHERNET_EVENT_START:
+        self->started = true;
+        break;
+
+      case ETHERNET_EVENT_CONNECTED:
+        self->eth_link = ETH_LINK_UP;
+        break;
+
+      case ETHERNET_EVENT_DISCONNECTED:
+        self->eth_link = ETH_LINK_DOWN;
+        self->gotIP = false;
+        break;
+
+      case ETHERNET_EVENT_STOP:
+        self->started = false;
+        self->eth_link = ETH_LINK_DOWN;
+        self->gotIP = false;
+        break;
+
+      default:
+        break;
+    }
+  }
+  else if (event_base == IP_EVENT)
+  {
+    if (event_id == IP_EVENT_ETH_GOT_IP)
+    {
+      self->gotIP = true;
+    }
+    else if (event_id == IP_EVENT_ETH_LOST_IP)
+    {
+      self->gotIP = false;
+    }
+  }
+}
+
+////////////////////////////////////////
+
 bool ESP32_W5500::begin(int MISO, int MOSI, int SCLK, int CS, int INT, int SPICLOCK_MHZ, int SPIHOST,
                         uint8_t *W5500_Mac)
 {
@@ -62,6 +110,15 @@ bool ESP32_W5500::begin(int MISO, int MOSI, int SCLK, int CS, int INT, int SPICL
 
   //   return false;
   // }
+
+  // Same range as esp_eth_mac_w5500_set_clock(), checked before the SPI device is added
+  if ( (SPICLOCK_MHZ < W5500_SPI_CLOCK_MIN_MHZ) || (SPICLOCK_MHZ > W5500_SPI_CLOCK_MAX_MHZ) )
+  {
+    Serial.printf("SPI Clock must be >= %d and <= %d MHz for W5500\n", W5500_SPI_CLOCK_MIN_MHZ, W5500_SPI_CLOCK_MAX_MHZ);
+
+    return false;
+  }
+
   tcpipInit();
 
   esp_base_mac_addr_set( W5500_Mac );
@@ -71,7 +128,7 @@ bool ESP32_W5500::begin(int MISO, int MOSI, int SCLK, int CS, int INT, int SPICL
   esp_netif_config_t cfg = ESP_NETIF_DEFAULT_ETH();
   esp_netif_t *eth_netif = esp_netif_new(&cfg);
 
-  esp_eth_mac_t *eth_mac = w5500_begin(MISO, MOSI, SCLK, CS, INT, SPICLOCK_MHZ, SPIHOST);
+  eth_mac = w5500_begin(MISO, MOSI, SCLK, CS, INT, SPICLOCK_MHZ, SPIHOST);
 
   if (eth_mac == NULL)
   {
@@ -104,15 +161,9 @@ bool ESP32_W5500::begin(int MISO, int MOSI, int SCLK, int CS, int INT, int SPICL
 
   eth_mac->set_addr(eth_mac, W5500_Mac);
 
-#if 1
-
-  if ( (SPICLOCK_MHZ < 14) || (SPICLOCK_MHZ > 25) )//asalnya 14 min
-  {
-    Serial.println("SPI Clock must be >= 8 and <= 25 MHz for W5500");
-    ESP_ERROR_CHECK(ESP_FAIL);
-  }
-
-#endif
+  esp_event_handler_register(ETH_EVENT, ESP_EVENT_ANY_ID, &ESP32_W5500::eth_event_handler, this);
+  esp_event_handler_register(IP_EVENT, IP_EVENT_ETH_GOT_IP, &ESP32_W5500::eth_event_handler, this);
+  esp_event_handler_register(IP_EVENT, IP_EVENT_ETH_LOST_IP, &ESP32_W5500::eth_event_handler, this);
 
   /* attach Ethernet driver to TCP/IP stack */
   if (esp_netif_attach(eth_netif, esp_eth_new_netif_glue(eth_handle)) != ESP_OK)
@@ -122,6 +173,12 @@ bool ESP32_W5500::begin(int MISO, int MOSI, int SCLK, int CS, int INT, int SPICL
     return false;
   }
 
+  // RX frames langsung ke lwIP memakai pool buffer driver (tanpa malloc per frame)
+  if (esp_eth_mac_w5500_attach_lwip(eth_handle, eth_mac, esp_netif_get_netif_impl(eth_netif)) != ESP_OK)
+  {
+    Serial.println("esp_eth_mac_w5500_attach_lwip failed, using default input path");
+  }
+
   if (esp_eth_start(eth_handle) != ESP_OK)
   {
     Serial.println("esp_eth_start failed");
@@ -217,13 +274,9 @@ IPAddress ESP32_W5500::localIP()
 
   if (tcpip_adapter_get_ip_info(TCPIP_ADAPTER_IF_ETH, &ip))
   {
-    printf("localIP NULL");
-
     return IPAddress();
   }
 
-  printf("localIP =", IPAddress(ip.ip.addr));
-
   return IPAddress(ip.ip.addr);
 }
 
@@ -351,6 +404,50 @@ bool ESP32_W5500::linkUp()
 
 ////////////////////////////////////////
 
+bool ESP32_W5500::hasIP()
+{
+  if (gotIP)
+  {
+    return true;
+  }
+
+  // static IP doesn't always raise IP_EVENT_ETH_GOT_IP, fall back to the netif address
+  return staticIP && linkUp() && (static_cast<uint32_t>(localIP()) != 0);
+}
+
+////////////////////////////////////////
+
+bool ESP32_W5500::rxStats(eth_w5500_stats_t &stats)
+{
+  if (!eth_mac)
+  {
+    return false;
+  }
+
+  return esp_eth_mac_w5500_get_stats(eth_mac, &stats) == ESP_OK;
+}
+
+////////////////////////////////////////
+
+bool ESP32_W5500::setSpiClock(int mhz)
+{
+  if (!eth_mac)
+  {
+    return false;
+  }
+
+  return esp_eth_mac_w5500_set_clock(eth_mac, mhz) == ESP_OK;
+}
+
+////////////////////////////////////////
+
+int ESP32_W5500::spiClockMHz()
+{
+  return esp_eth_mac_w5500_get_clock(eth_mac);
+}
+
+////////////////////////////////////////
+
 uint8_t ESP32_W5500::linkSpeed()
 {
 #ifdef ESP_IDF_VERSION_MAJOR
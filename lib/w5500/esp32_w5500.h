@@ -16,6 +16,7 @@
 #include "WiFi.h"
 #include "esp_system.h"
 #include "esp_eth.h"
+#include "esp_eth_w5500.h"
 
 #include <hal/spi_types.h>
 
@@ -36,9 +37,11 @@ class ESP32_W5500
   private:
     bool initialized;
     bool staticIP;
+    bool gotIP;
 
 #if ESP_IDF_VERSION_MAJOR > 3
     esp_eth_handle_t eth_handle;
+    esp_eth_mac_t *eth_mac;
 
   protected:
     bool started;
@@ -64,6 +67,10 @@ class ESP32_W5500
 
     bool fullDuplex();
     bool linkUp();
+    bool hasIP();
+    bool rxStats(eth_w5500_stats_t &stats);
+    bool setSpiClock(int mhz);
+    int spiClockMHz();
     uint8_t linkSpeed();
 
     bool enableIpV6();
@@ -0,0 +1,67 @@
+# ============================================================================
+# PlatformIO pre-script: kompres aset web sebelum buildfs / uploadfs
+#
+# data/ tetap berisi sumber asli. Saat image SPIFFS dibuat, isinya disalin ke
+# $BUILD_DIR/data: file teks (html/js/css/svg) di-gzip jadi <nama>.gz, file
+# lain disalin apa adanya. etags.txt berisi ETag kuat (hash isi file yang
+# benar-benar dikirim) dan dibaca oleh StaticAssets.hpp saat boot.
+# ============================================================================
+
+Import("env")
+
+import gzip
+import hashlib
+import os
+import shutil
+
+COMPRESS_EXT = (".html", ".js", ".css", ".svg", ".txt")
+FS_TARGETS = ("buildfs", "uploadfs", "uploadfsota")
+
+
+def build_web_data(src, dst):
+    shutil.rmtree(dst, ignore_errors=True)
+    etags = []
+    raw_total = 0
+    out_total = 0
+
+    for root, _, files in os.walk(src):
+        for name in sorted(files):
+            path = os.path.join(root, name)
+            rel = os.path.relpath(path, src).replace(os.sep, "/")
+            out = os.path.join(dst, rel)
+            os.makedirs(os.path.dirname(out), exist_ok=True)
+
+            with open(path, "rb") as f:
+                raw = f.read()
+
+            if name.endswith(COMPRESS_EXT):
+                # mtime=0 supaya hasil (dan ETag) sama selama sumber tidak berubah
+                data = gzip.compress(raw, compresslevel=9, mtime=0)
+                out += ".gz"
+                served = "/" + rel
+            else:
+                data = raw
+                served = "/" + (rel[:-3] if rel.endswith(".gz") else rel)
+
+            with open(out, "wb") as f:
+                f.write(data)
+
+            raw_total += len(raw)
+            out_total += len(data)
+
+            # file .json adalah config runtime, tidak disajikan sebagai aset statis
+            if not name.endswith(".json"):
+                etags.append((served, hashlib.sha1(data).hexdigest()[:16]))
+
+    with open(os.path.join(dst, "etags.txt"), "w") as f:
+        for served, tag in etags:
+            f.write("%s %s\n" % (served, tag))
+
+    print("Web assets: %d -> %d bytes (%d files)" % (raw_total, out_total, len(etags)))
+
+
+if any(t in FS_TARGETS for t in COMMAND_LINE_TARGETS):
+    src_dir = env.subst("$PROJECT_DATA_DIR")
+    out_dir = os.path.join(env.subst("$BUILD_DIR"), "data")
+    build_web_data(src_dir, out_dir)
+    env.Replace(PROJECT_DATA_DIR=out_dir)
@@ -0,0 +1,133 @@
+# ============================================================================
+# Uji latency kanal perintah WebSocket /ws (CommandSocket.hpp) dari PC di LAN
+#
+#   python3 scripts/ws_latency.py 192.168.1.50 --user admin --password admin \
+#       --do 1 --count 200
+#
+# Mengirim "ping" lalu "set" DO bergantian ON/OFF, mengukur waktu kirim ->
+# ack per perintah, lalu mencetak p50 / p99 / max. Kolom "device" adalah
+# waktu frame masuk -> ack di firmware ("us" di ack), sisanya jaringan + stack.
+# Target: p99 set DO < 20 ms. Hanya pustaka standar Python, tanpa dependensi.
+# ============================================================================
+
+import argparse
+import base64
+import json
+import os
+import socket
+import struct
+import sys
+import time
+
+
+def ws_connect(host, port, user, password):
+    sock = socket.create_connection((host, port), timeout=5)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    key = base64.b64encode(os.urandom(16)).decode()
+    auth = base64.b64encode(f"{user}:{password}".encode()).decode()
+    request = (
+        "GET /ws HTTP/1.1\r\n"
+        f"Host: {host}:{port}\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        f"Sec-WebSocket-Key: {key}\r\n"
+        "Sec-WebSocket-Version: 13\r\n"
+        f"Authorization: Basic {auth}\r\n\r\n"
+    )
+    sock.sendall(request.encode())
+    response = b""
+    while b"\r\n\r\n" not in response:
+        chunk = sock.recv(1024)
+        if not chunk:
+            break
+        response += chunk
+    status = response.split(b"\r\n", 1)[0].decode(errors="replace")
+    if " 101 " not in status:
+        sys.exit(f"Handshake gagal: {status} (login salah?)")
+    return sock
+
+
+def ws_send(sock, text):
+    payload = text.encode()
+    mask = os.urandom(4)
+    header = bytes([0x81])  # FIN + text
+    if len(payload) < 126:
+        header += bytes([0x80 | len(payload)])
+    else:
+        header += bytes([0x80 | 126]) + struct.pack(">H", len(payload))
+    masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+    sock.sendall(header + mask + masked)
+
+
+def recv_exact(sock, n):
+    data = b""
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("koneksi ditutup device")
+        data += chunk
+    return data
+
+
+def ws_recv(sock):
+    while True:
+        b0, b1 = recv_exact(sock, 2)
+        length = b1 & 0x7F
+        if length == 126:
+            length = struct.unpack(">H", recv_exact(sock, 2))[0]
+        elif length == 127:
+            length = struct.unpack(">Q", recv_exact(sock, 8))[0]
+        payload = recv_exact(sock, length)
+        opcode = b0 & 0x0F
+        if opcode == 0x1:
+            return payload.decode()
+        if opcode == 0x8:
+            raise ConnectionError("device menutup WebSocket")
+
+
+def percentile(values, q):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(q * len(ordered)))]
+
+
+def run(sock, label, build, count):
+    rtt, device = [], []
+    for n in range(count):
+        req_id = n + 1
+        msg = build(n)
+        msg["id"] = req_id
+        t0 = time.perf_counter()
+        ws_send(sock, json.dumps(msg))
+        while True:
+            ack = json.loads(ws_recv(sock))
+            if ack.get("id") == req_id and "us" in ack:
+                break
+        rtt.append((time.perf_counter() - t0) * 1000)
+        device.append(ack["us"] / 1000)
+        if not ack.get("ok"):
+            print(f"  #{req_id} ditolak: {ack}")
+    print(f"{label:6} n={count}  p50 {percentile(rtt, 0.5):6.2f} ms  p99 {percentile(rtt, 0.99):6.2f} ms  "
+          f"max {max(rtt):6.2f} ms  | device p99 {percentile(device, 0.99):5.2f} ms")
+    return percentile(rtt, 0.99)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Uji latency WebSocket /ws")
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--user", default="admin")
+    parser.add_argument("--password", default="admin")
+    parser.add_argument("--do", type=int, default=1, help="index DO yang di-toggle (1-based)")
+    parser.add_argument("--count", type=int, default=100)
+    args = parser.parse_args()
+
+    sock = ws_connect(args.host, args.port, args.user, args.password)
+    run(sock, "ping", lambda n: {"op": "ping"}, args.count)
+    p99 = run(sock, "set", lambda n: {"op": "set", "do": args.do, "value": n % 2 == 0, "verify": True}, args.count)
+    ws_send(sock, json.dumps({"id": 0, "op": "set", "do": args.do, "value": False}))
+    sock.close()
+    sys.exit(0 if p99 < 20 else 1)
+
+
+if __name__ == "__main__":
+    main()
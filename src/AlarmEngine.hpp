@@ -0,0 +1,217 @@
+#ifndef ALARM_ENGINE_HPP
+#define ALARM_ENGINE_HPP
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "config.hpp"
+#include "Metrics.hpp"
+#include "RuntimeConfig.hpp"
+#include "TaskMessages.hpp"
+#include "CommandQueue.hpp"
+#include "ModbusSlave.hpp"
+#include "VirtualChannels.hpp"
+
+extern QueueHandle_t queueAlarmEvents;
+
+// ============================================================================
+// ALARM ENGINE (threshold lokal, tanpa menunggu cloud)
+// Dievaluasi Task_DataAcquisition tiap siklus, setelah transform AI/DI
+// (filter, scaling, kalibrasi) & kanal virtual, dari definisi "alarms" di
+// modbusSetup.json.
+// Per alarm hanya beberapa operasi float + satu perbandingan waktu, state
+// di array tetap (index = urutan alarm di snapshot): tanpa alokasi, tanpa lock.
+// Snapshot baru: state dipetakan ulang per identitas alarm (nama + tipe +
+// sumber), seperti Totalizers::remap(); alarm yang tetap aktif tidak
+// memicu event / interlock lagi hanya karena config lain diedit.
+// Sampel sumber basi (tag Modbus tanpa read sukses, ADC tidak terbaca) lebih
+// tua dari max(ALARM_STALE_MS, 3x scan rate): alarm itu tidak dievaluasi
+// (nilai 0 dari read gagal tidak memicu lo/lolo), status ditahan, delay dan
+// jendela roc mulai lagi saat sampel segar datang.
+//
+//   hi / hihi : aktif jika value > limit, normal lagi jika <= limit - deadband
+//   lo / lolo : aktif jika value < limit, normal lagi jika >= limit + deadband
+//   roc       : |laju| (unit/detik, diukur per ALARM_ROC_WINDOW_MS) > limit
+//   onDelayMs / offDelayMs : kondisi harus bertahan selama itu sebelum
+//                            status berubah (filter spike / chatter)
+//
+// Saat aktif, DO interlock (jika ada) dipaksa ke doValue lewat commandQueue
+// (prioritas HIGH, diterapkan langsung). Saat normal kembali DO TIDAK
+// dilepas otomatis; operator yang mengembalikannya (perintah biasa).
+// Tiap transisi jadi AlarmEvent di queueAlarmEvents; Task_DataLogger
+// mengirimnya ke uplink & SD tanpa menunggu interval kirim.
+// ============================================================================
+
+#define ALARM_ROC_WINDOW_MS 1000
+#define ALARM_STALE_MS 5000
+
+class AlarmEngine
+{
+public:
+  void evaluate(const RuntimeConfig *cfg, uint32_t nowMs)
+  {
+    if (cfg->generation != _generation)
+      remap(cfg, nowMs);
+
+    int64_t t0 = esp_timer_get_time();
+    uint32_t staleMs = max((uint32_t)ALARM_STALE_MS, 3 * cfg->scanRateMs);
+    for (uint8_t n = 0; n < cfg->alarmCount; n++)
+    {
+      const AlarmConfig &a = cfg->alarms[n];
+      State &s = _state[n];
+      float value;
+      uint32_t sampleMs = sample(a, value, nowMs);
+      s.value = value;
+      s.stale = !sampleMs || nowMs - sampleMs > staleMs;
+      if (s.stale)
+      {
+        s.sinceMs = nowMs; // delay dihitung ulang dari sampel segar pertama
+        s.hasRef = false;
+        mAlarmStaleSkips.inc();
+        continue;
+      }
+      if (condition(a, s, value, nowMs) == s.active)
+      {
+        s.sinceMs = nowMs; // stabil: delay dihitung dari sini
+        continue;
+      }
+      if (nowMs - s.sinceMs < (s.active ? a.offDelayMs : a.onDelayMs))
+        continue;
+      s.active = !s.active;
+      s.sinceMs = nowMs;
+      transition(cfg, n, s.active, value, nowMs);
+    }
+    if (cfg->alarmCount)
+      mAlarmEval.observeUs((uint32_t)(esp_timer_get_time() - t0));
+  }
+
+  // Web handler: status terakhir (index sesuai snapshot generation ini)
+  bool active(uint8_t n) const { return n < RUNTIME_MAX_ALARMS && _state[n].active; }
+  float value(uint8_t n) const { return n < RUNTIME_MAX_ALARMS ? _state[n].value : 0; }
+  bool stale(uint8_t n) const { return n < RUNTIME_MAX_ALARMS && _state[n].stale; }
+  uint32_t generation() const { return _generation; }
+
+private:
+  struct State
+  {
+    char name[32]; // identitas untuk remap()
+    uint8_t type, source, index;
+    volatile bool active, stale;
+    bool hasRef;
+    uint32_t sinceMs;
+    uint32_t refMs; // roc: awal jendela
+    float ref, rate;
+    volatile float value;
+  };
+
+  // Snapshot baru: bawa state alarm yang sama (nama, tipe & sumber tidak
+  // berubah) ke index barunya; alarm baru mulai normal, tanpa event
+  void remap(const RuntimeConfig *cfg, uint32_t nowMs)
+  {
+    static State old[RUNTIME_MAX_ALARMS]; // hanya Task_DataAcquisition
+    memcpy(old, _state, sizeof(old));
+    for (uint8_t n = 0; n < cfg->alarmCount; n++)
+    {
+      const AlarmConfig &a = cfg->alarms[n];
+      State &s = _state[n];
+      memset(&s, 0, sizeof(s));
+      s.sinceMs = nowMs; // on-delay berlaku juga untuk evaluasi pertama
+      for (uint8_t k = 0; k < _count; k++)
+      {
+        if (strcmp(old[k].name, a.name) == 0 && old[k].type == a.type && old[k].source == a.source &&
+            old[k].index == a.index)
+        {
+          s = old[k];
+          break;
+        }
+      }
+      strlcpy(s.name, a.name, sizeof(s.name));
+      s.type = a.type;
+      s.source = a.source;
+      s.index = a.index;
+    }
+    _count = cfg->alarmCount;
+    _generation = cfg->generation;
+  }
+
+  // Nilai & timestamp sampel sumber, 0 = belum ada sampel valid
+  static uint32_t sample(const AlarmConfig &a, float &value, uint32_t nowMs)
+  {
+    switch (a.source)
+    {
+    case ALARM_SRC_AI:
+      value = analogInput[a.index].mapValue;
+      return analogInput[a.index].sampleMs;
+    case ALARM_SRC_DI:
+      value = digitalInput[a.index].value;
+      return nowMs;
+    case ALARM_SRC_VIRTUAL:
+      value = virtualChannels.value(a.index);
+      return nowMs;
+    default:
+      return slaveRegisters.tagSample(a.index, value);
+    }
+  }
+
+  static bool condition(const AlarmConfig &a, State &s, float value, uint32_t nowMs)
+  {
+    switch (a.type)
+    {
+    case ALARM_HI:
+    case ALARM_HIHI:
+      return value > (s.active ? a.limit - a.deadband : a.limit);
+    case ALARM_LO:
+    case ALARM_LOLO:
+      return value < (s.active ? a.limit + a.deadband : a.limit);
+    default: // ALARM_ROC
+      if (!s.hasRef)
+      {
+        s.hasRef = true;
+        s.ref = value;
+        s.refMs = nowMs;
+        return false;
+      }
+      if (nowMs - s.refMs >= ALARM_ROC_WINDOW_MS)
+      {
+        s.rate = (value - s.ref) * 1000.0f / (nowMs - s.refMs);
+        s.ref = value;
+        s.refMs = nowMs;
+      }
+      return fabsf(s.rate) > (s.active ? a.limit - a.deadband : a.limit);
+    }
+  }
+
+  void transition(const RuntimeConfig *cfg, uint8_t n, bool active, float value, uint32_t nowMs)
+  {
+    const AlarmConfig &a = cfg->alarms[n];
+    mAlarmTransitions.inc();
+    if (active && a.doIndex)
+    {
+      WriteCommand cmd = {};
+      cmd.target = CMD_TARGET_DO;
+      cmd.source = CMD_SRC_ALARM;
+      cmd.priority = CMD_PRIO_HIGH;
+      cmd.fc = 5;
+      cmd.addr = a.doIndex;
+      cmd.count = 1;
+      cmd.values[0] = a.doValue;
+      commandQueue.submit(cmd);
+    }
+
+    AlarmEvent ev;
+    ev.generation = cfg->generation;
+    ev.timestamp = nowMs;
+    ev.alarm = n;
+    ev.active = active;
+    ev.value = value;
+    if (!queueAlarmEvents || xQueueSend(queueAlarmEvents, &ev, 0) != pdTRUE)
+      mAlarmEventDrops.inc();
+  }
+
+  State _state[RUNTIME_MAX_ALARMS] = {};
+  uint8_t _count = 0;
+  uint32_t _generation = 0;
+};
+
+AlarmEngine alarmEngine;
+
+#endif
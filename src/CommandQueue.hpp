@@ -0,0 +1,334 @@
+#ifndef COMMAND_QUEUE_HPP
+#define COMMAND_QUEUE_HPP
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include "esp_timer.h"
+#include "config.hpp"
+#include "Metrics.hpp"
+#include "ModbusFrame.hpp"
+#include "RuntimeConfig.hpp"
+#include "TaskMessages.hpp"
+
+// ============================================================================
+// COMMAND QUEUE (perintah tulis DO lokal & coil/register perangkat RS-485)
+// Sumber: MQTT (mqttCallback), HTTP (POST /command), WebSocket (/ws),
+// Modbus TCP (write ke slave map). Semua lewat satu jalur supaya validasi,
+// id & hasilnya tercatat sama.
+//
+// DO lokal tidak butuh bus: diterapkan langsung di submit() (task pengirim),
+// jadi perintah ke pin tidak menunggu transaksi RS-485 yang sedang jalan.
+// Pengirim (async_tcp, network, slave, alarm) dan callback pulse diserialkan
+// oleh _doLock. Pulse (pulseMs) dikembalikan oleh esp_timer one-shot per DO
+// ke value sebelum pulse; perintah baru ke DO yang sama membatalkan pulse yang
+// masih berjalan (pulse beruntun tetap kembali ke value sebelum pulse pertama).
+//
+// Perintah RS-485 masuk dua queue FreeRTOS per prioritas; Task_ModbusClient
+// (pemilik bus) mengambilnya di setiap titik preempt scan (sebelum tiap blok,
+// saat menunggu TCP, saat idle) dan selalu menghabiskan antrean HIGH dulu.
+// submit() membangunkan task itu, jadi perintah tidak menunggu scan selesai:
+// paling lama satu transaksi bus yang sedang berjalan.
+//
+// Hasil (status + latency submit -> aktuasi terkonfirmasi) disimpan di ring
+// kecil untuk GET /commandStatus?id=, dan latency masuk histogram per sumber.
+// ============================================================================
+
+#define COMMAND_QUEUE_DEPTH 8
+#define COMMAND_RESULT_HISTORY 16
+
+enum CommandStatus : uint8_t
+{
+  CMD_STATUS_PENDING = 0,
+  CMD_STATUS_DONE,          // tertulis (dan cocok saat dibaca ulang, jika verify)
+  CMD_STATUS_FAILED,        // timeout / exception / CRC dari perangkat
+  CMD_STATUS_VERIFY_FAILED, // tulis diterima, tapi baca ulang berbeda
+  CMD_STATUS_UNKNOWN        // id tidak ada di riwayat
+};
+
+static const char *const COMMAND_STATUS_NAMES[] = {"pending", "done", "failed", "verifyFailed", "unknown"};
+static const char *const COMMAND_SOURCE_NAMES[] = {"mqtt", "http", "modbus", "ws", "alarm"};
+
+struct CommandResult
+{
+  uint32_t id;
+  uint8_t status;      // CommandStatus
+  uint8_t frameResult; // ModbusFrameResult transaksi terakhir
+  uint8_t source;      // CommandSource
+  uint32_t latencyUs;
+};
+
+class CommandQueue
+{
+public:
+  bool begin()
+  {
+    _queue[CMD_PRIO_NORMAL] = xQueueCreate(COMMAND_QUEUE_DEPTH, sizeof(WriteCommand));
+    _queue[CMD_PRIO_HIGH] = xQueueCreate(COMMAND_QUEUE_DEPTH, sizeof(WriteCommand));
+    _doLock = xSemaphoreCreateMutex();
+    for (uint8_t i = 1; i <= jumlahOutputDigital; i++)
+    {
+      _output[i].owner = this;
+      _output[i].index = i;
+      esp_timer_create_args_t args = {};
+      args.callback = &CommandQueue::pulseEnd;
+      args.arg = &_output[i];
+      args.name = "do_pulse";
+      esp_timer_create(&args, &_output[i].pulse);
+    }
+    return _queue[CMD_PRIO_NORMAL] && _queue[CMD_PRIO_HIGH] && _doLock;
+  }
+
+  // Dari task mana pun (bukan ISR). Kembalikan id perintah, 0 = ditolak
+  uint32_t submit(WriteCommand cmd)
+  {
+    if (!valid(cmd) || !_queue[CMD_PRIO_NORMAL] || !_doLock)
+    {
+      mCommandsRejected.inc();
+      return 0;
+    }
+    cmd.id = _nextId.fetch_add(1) + 1;
+    cmd.submittedUs = esp_timer_get_time();
+    mCommandsSubmitted.inc();
+    if (cmd.target == CMD_TARGET_DO)
+    {
+      executeDigitalOutput(cmd);
+      return cmd.id;
+    }
+    store(cmd.id, CMD_STATUS_PENDING, MB_FRAME_OK, cmd.source, 0);
+
+    uint8_t prio = cmd.priority == CMD_PRIO_HIGH ? CMD_PRIO_HIGH : CMD_PRIO_NORMAL;
+    if (xQueueSend(_queue[prio], &cmd, 0) != pdTRUE)
+    {
+      store(cmd.id, CMD_STATUS_FAILED, MB_FRAME_TIMEOUT, cmd.source, 0);
+      mCommandsRejected.inc();
+      return 0;
+    }
+    if (Task_Core1_ModbusClient)
+      xTaskNotifyGive(Task_Core1_ModbusClient);
+    return cmd.id;
+  }
+
+  // Task_ModbusClient: perintah berikutnya, HIGH dulu
+  bool take(WriteCommand &cmd)
+  {
+    if (!_queue[CMD_PRIO_HIGH])
+      return false;
+    return xQueueReceive(_queue[CMD_PRIO_HIGH], &cmd, 0) == pdTRUE ||
+           xQueueReceive(_queue[CMD_PRIO_NORMAL], &cmd, 0) == pdTRUE;
+  }
+
+  // Task_ModbusClient: catat hasil eksekusi
+  void finish(const WriteCommand &cmd, uint8_t status, uint8_t frameResult)
+  {
+    uint32_t latencyUs = (uint32_t)(esp_timer_get_time() - cmd.submittedUs);
+    store(cmd.id, status, frameResult, cmd.source, latencyUs);
+    if (status != CMD_STATUS_DONE)
+    {
+      mCommandsFailed.inc();
+      return;
+    }
+    switch (cmd.source)
+    {
+    case CMD_SRC_MQTT:
+      mCommandLatencyMqtt.observeUs(latencyUs);
+      break;
+    case CMD_SRC_HTTP:
+      mCommandLatencyHttp.observeUs(latencyUs);
+      break;
+    case CMD_SRC_WS:
+      mCommandLatencyWs.observeUs(latencyUs);
+      break;
+    case CMD_SRC_ALARM:
+      mCommandLatencyAlarm.observeUs(latencyUs);
+      break;
+    default:
+      mCommandLatencyModbus.observeUs(latencyUs);
+      break;
+    }
+  }
+
+  CommandResult result(uint32_t id)
+  {
+    CommandResult r = {id, CMD_STATUS_UNKNOWN, MB_FRAME_OK, 0, 0};
+    portENTER_CRITICAL(&_mux);
+    for (const CommandResult &h : _history)
+    {
+      if (h.id == id && id != 0)
+        r = h;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return r;
+  }
+
+  // Status untuk ack langsung setelah submit(): DO lokal sudah dieksekusi,
+  // perintah RS-485 baru masuk antrean (hasil lewat result() / ack kedua)
+  const char *ackStatus(const WriteCommand &cmd, uint32_t id)
+  {
+    if (cmd.target != CMD_TARGET_DO)
+      return COMMAND_STATUS_NAMES[CMD_STATUS_PENDING];
+    return COMMAND_STATUS_NAMES[result(id).status];
+  }
+
+  static void resultToJson(const CommandResult &r, JsonObject out)
+  {
+    out["id"] = r.id;
+    out["status"] = COMMAND_STATUS_NAMES[r.status <= CMD_STATUS_UNKNOWN ? r.status : CMD_STATUS_UNKNOWN];
+    if (r.status == CMD_STATUS_UNKNOWN)
+      return;
+    out["source"] = COMMAND_SOURCE_NAMES[r.source < CMD_SRC_COUNT ? r.source : 0];
+    out["frameResult"] = r.frameResult;
+    if (r.status != CMD_STATUS_PENDING)
+      out["latencyUs"] = r.latencyUs;
+  }
+
+private:
+  static bool valid(const WriteCommand &cmd)
+  {
+    if (cmd.target == CMD_TARGET_DO)
+      return cmd.addr >= 1 && cmd.addr <= jumlahOutputDigital && cmd.count == 1 && doPinUsable(DO_PINS[cmd.addr - 1]);
+    if (cmd.target != CMD_TARGET_RTU || cmd.pulseMs || cmd.unit < 1 || cmd.unit > 247)
+      return false;
+    if (cmd.fc == 5 || cmd.fc == 6)
+      return cmd.count == 1;
+    return (cmd.fc == 15 || cmd.fc == 16) && cmd.count >= 1 && cmd.count <= COMMAND_MAX_VALUES;
+  }
+
+  // Value logis; level pin dibalik jika "inv". OUTPUT di ESP32 tetap bisa
+  // dibaca, jadi level pin sekaligus verifikasi.
+  static bool writeDigitalOutput(uint8_t index, bool on)
+  {
+    bool level = on != digitalOutput[index].inv;
+    digitalWrite(DO_PINS[index - 1], level);
+    digitalOutput[index].value = on;
+    return digitalRead(DO_PINS[index - 1]) == level;
+  }
+
+  // State pulse per DO, hanya diubah di bawah _doLock
+  struct OutputState
+  {
+    CommandQueue *owner;
+    uint8_t index;
+    bool pulsing; // timer pulse berjalan
+    bool restore; // value sebelum pulse
+    esp_timer_handle_t pulse;
+  };
+
+  // Task esp_timer. Timer yang aktif lagi berarti pulse baru dimulai selagi
+  // callback ini menunggu lock: biarkan pulse baru yang mengembalikan.
+  static void pulseEnd(void *arg)
+  {
+    OutputState *out = (OutputState *)arg;
+    xSemaphoreTake(out->owner->_doLock, portMAX_DELAY);
+    if (out->pulsing && !esp_timer_is_active(out->pulse))
+    {
+      writeDigitalOutput(out->index, out->restore);
+      out->pulsing = false;
+    }
+    xSemaphoreGive(out->owner->_doLock);
+  }
+
+  void executeDigitalOutput(const WriteCommand &cmd)
+  {
+    OutputState &out = _output[cmd.addr];
+    xSemaphoreTake(_doLock, portMAX_DELAY);
+    if (out.pulsing)
+      esp_timer_stop(out.pulse); // restore tetap value sebelum pulse pertama
+    else
+      out.restore = digitalOutput[cmd.addr].value;
+    bool ok = writeDigitalOutput(cmd.addr, cmd.values[0]);
+    out.pulsing = out.pulse && cmd.pulseMs && esp_timer_start_once(out.pulse, cmd.pulseMs * 1000ULL) == ESP_OK;
+    xSemaphoreGive(_doLock);
+    finish(cmd, ok || !cmd.verify ? CMD_STATUS_DONE : CMD_STATUS_VERIFY_FAILED, MB_FRAME_OK);
+  }
+
+  void store(uint32_t id, uint8_t status, uint8_t frameResult, uint8_t source, uint32_t latencyUs)
+  {
+    portENTER_CRITICAL(&_mux);
+    CommandResult *slot = &_history[id % COMMAND_RESULT_HISTORY];
+    slot->id = id;
+    slot->status = status;
+    slot->frameResult = frameResult;
+    slot->source = source;
+    slot->latencyUs = latencyUs;
+    portEXIT_CRITICAL(&_mux);
+  }
+
+  QueueHandle_t _queue[2] = {NULL, NULL};
+  std::atomic<uint32_t> _nextId{0};
+  CommandResult _history[COMMAND_RESULT_HISTORY] = {};
+  OutputState _output[jumlahOutputDigital + 1] = {};
+  SemaphoreHandle_t _doLock = NULL;
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+CommandQueue commandQueue;
+
+// ----------------------------------------------------------------------------
+// JSON -> WriteCommand (MQTT & HTTP)
+//   DO lokal : {"do":"Pompa 1"} atau {"do":2}, "value":true,
+//              opsional "pulseMs":500 (value selama 500 ms lalu kembali)
+//              Nama dicocokkan ke snapshot config pemanggil, bukan ke
+//              digitalOutput[] yang bisa sedang ditulis web handler.
+//   RS-485   : {"unit":1, "fc":6, "addr":100, "value":123}
+//              {"unit":1, "fc":16, "addr":100, "values":[1,2,3]}
+//   opsional : "priority":"high", "verify":true
+// ----------------------------------------------------------------------------
+inline uint8_t digitalOutputIndex(const RuntimeConfig *cfg, JsonVariantConst v)
+{
+  if (v.is<int>())
+  {
+    int n = v.as<int>();
+    return n >= 1 && n <= jumlahOutputDigital ? n : 0;
+  }
+  const char *name = v.as<const char *>();
+  for (uint8_t i = 1; name && name[0] && i <= jumlahOutputDigital; i++)
+  {
+    if (strcmp(cfg->dout[i].name, name) == 0)
+      return i;
+  }
+  return 0;
+}
+
+inline bool commandFromJson(const RuntimeConfig *cfg, JsonObjectConst o, uint8_t source, WriteCommand &cmd)
+{
+  memset(&cmd, 0, sizeof(cmd));
+  cmd.source = source;
+  cmd.priority = strcasecmp(o["priority"] | "", "high") == 0 ? CMD_PRIO_HIGH : CMD_PRIO_NORMAL;
+  cmd.verify = o["verify"] | false;
+
+  if (o.containsKey("do"))
+  {
+    cmd.target = CMD_TARGET_DO;
+    cmd.fc = 5;
+    cmd.addr = digitalOutputIndex(cfg, o["do"]);
+    cmd.count = 1;
+    cmd.pulseMs = o["pulseMs"] | 0;
+    JsonVariantConst value = o["value"];
+    cmd.values[0] = value.isNull() ? cmd.pulseMs > 0 : value.as<bool>(); // pulse tanpa value = pulse ON
+    return cmd.addr != 0;
+  }
+
+  cmd.target = CMD_TARGET_RTU;
+  cmd.unit = o["unit"] | 0;
+  cmd.fc = o["fc"] | 0;
+  cmd.addr = o["addr"] | 0;
+  JsonArrayConst values = o["values"];
+  if (values.isNull())
+  {
+    cmd.count = 1;
+    cmd.values[0] = o["value"].as<int>();
+  }
+  else
+  {
+    for (JsonVariantConst v : values)
+    {
+      if (cmd.count >= COMMAND_MAX_VALUES)
+        return false;
+      cmd.values[cmd.count++] = v.as<int>();
+    }
+  }
+  return true;
+}
+
+#endif
@@ -0,0 +1,348 @@
+#ifndef COMMAND_SOCKET_HPP
+#define COMMAND_SOCKET_HPP
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include "esp_timer.h"
+#include "config.hpp"
+#include "ConfigStore.hpp"
+#include "CommandQueue.hpp"
+
+extern void configChanged(uint8_t sections);
+
+// ============================================================================
+// COMMAND SOCKET (WebSocket /ws)
+// Kanal perintah latency rendah untuk UI / tool di LAN: satu koneksi
+// persisten, tanpa form POST + tulis config, tanpa menunggu poll mqtt.loop().
+// Handler jalan di task async_tcp begitu frame masuk; DO lokal diterapkan di
+// commandQueue.submit() di task itu juga, jadi frame -> pin < 1 ms + jaringan.
+//
+// Request (satu frame teks JSON, "id" bebas dari client, dikembalikan di ack):
+//   {"id":1,"op":"set","do":"Pompa 1","value":true}
+//   {"id":2,"op":"pulse","do":2,"pulseMs":500}
+//   {"id":3,"op":"set","unit":1,"fc":6,"addr":100,"value":123}   RS-485
+//   {"id":4,"op":"tune","ai":1,"filterPeriod":2.5,"lowLimit":0,"highLimit":100}
+//   {"id":5,"op":"ping"}
+// Ack di stream yang sama: {"id":1,"ok":true,"cmd":17,"status":"done","us":240}
+// ("us" = frame masuk -> ack). Perintah RS-485 di-ack "pending" dulu, lalu
+// ack kedua dengan status akhir begitu Task_ModbusClient selesai.
+//
+// Model thread (dua task, data bersama keduanya dijaga _mux):
+//   - async_tcp (onEvent dan semua yang dipanggilnya): satu-satunya pemakai
+//     daftar client AsyncWebSocket (library tidak mengunci daftar itu untuk
+//     task lain) dan satu-satunya pembaca snapshot config lewat
+//     RuntimeConfigReadGuard = slot RCU_READER_WEB. Slot RCU per task: guard
+//     ini tidak boleh dipakai dari task lain (mis. loop()), karena read() di
+//     task kedua melepas snapshot yang masih dipegang handler.
+//   - Task_NetworkManagement (loop()): menerapkan tune yang dititipkan ke
+//     analogInput[] dan mem-publish snapshot baru lewat configChanged(). Tidak
+//     menyentuh client WebSocket dan tidak membaca snapshot.
+// Ack kedua dikirim dari event client pemilik perintah: frame berikutnya atau
+// pong. keepAlivePeriod(1) membuat library mengirim ping tiap detik saat jalur
+// diam, jadi ack kedua paling lambat ~1,5 s tanpa client harus polling
+// ("op":"ping" = segera).
+//
+// Tune mengubah parameter AI live dan disimpan lewat configStore seperti form
+// web. Handler hanya memvalidasi & menitipkan nilainya; publish di loop()
+// (bangun snapshot + lock RCU tidak jalan di async_tcp). Tweak beruntun
+// sebelum loop() berikutnya digabung: satu snapshot, satu commit flash.
+//
+// Auth: Basic auth login web dicek per upgrade request (kredensial terbaru).
+// ============================================================================
+
+#define COMMAND_SOCKET_MAX_CLIENTS 4
+#define COMMAND_SOCKET_FRAME_MAX 384
+#define COMMAND_SOCKET_PENDING 8
+
+class CommandSocket
+{
+public:
+  CommandSocket() : _ws("/ws") {}
+
+  void begin(AsyncWebServer &server)
+  {
+    _ws.setFilter([](AsyncWebServerRequest *request)
+                  { return request->authenticate(networkSettings.loginUsername.c_str(), networkSettings.loginPassword.c_str()); });
+    _ws.onEvent([this](AsyncWebSocket *, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len)
+                { onEvent(client, type, arg, data, len); });
+    server.addHandler(&_ws);
+  }
+
+  // Dipanggil berkala dari Task_NetworkManagement: terapkan tune yang
+  // dititipkan handler /ws. Tidak menyentuh client WebSocket.
+  void loop()
+  {
+    Tune tune[jumlahInputAnalog + 1];
+    bool changed = false;
+    portENTER_CRITICAL(&_mux);
+    for (uint8_t i = 1; i <= jumlahInputAnalog; i++)
+    {
+      tune[i] = _tune[i];
+      _tune[i].fields = 0;
+      changed |= tune[i].fields != 0;
+    }
+    portEXIT_CRITICAL(&_mux);
+    if (!changed)
+      return;
+
+    for (uint8_t i = 1; i <= jumlahInputAnalog; i++)
+      applyTune(tune[i], analogInput[i]);
+    configChanged(CFG_ANALOG); // snapshot baru dipakai akuisisi di siklus berikutnya
+  }
+
+private:
+  struct Pending
+  {
+    uint32_t client, cmd, reqId;
+  };
+
+  enum TuneField : uint16_t
+  {
+    TUNE_FILTER = 1 << 0,
+    TUNE_FILTER_PERIOD = 1 << 1,
+    TUNE_SCALING = 1 << 2,
+    TUNE_LOW_LIMIT = 1 << 3,
+    TUNE_HIGH_LIMIT = 1 << 4,
+    TUNE_CALIBRATION = 1 << 5,
+    TUNE_M_VALUE = 1 << 6,
+    TUNE_C_VALUE = 1 << 7
+  };
+
+  // Field AI yang dikirim tune (nama sama dengan AnalogInput)
+  struct Tune
+  {
+    uint16_t fields; // TuneField, 0 = tidak ada tune
+    bool filter, scaling, calibration;
+    float filterPeriod, lowLimit, highLimit, mValue, cValue;
+  };
+
+  // Task async_tcp
+  void onEvent(AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len)
+  {
+    switch (type)
+    {
+    case WS_EVT_CONNECT:
+      if (_ws.count() > COMMAND_SOCKET_MAX_CLIENTS)
+        client->close(1013); // try again later
+      else
+        client->keepAlivePeriod(1);
+      return;
+    case WS_EVT_DISCONNECT:
+      dropPending(client->id());
+      return;
+    case WS_EVT_PONG:
+      flushPending(client);
+      return;
+    case WS_EVT_DATA:
+      break;
+    default:
+      return;
+    }
+
+    int64_t rxUs = esp_timer_get_time();
+    AwsFrameInfo *info = (AwsFrameInfo *)arg;
+    StaticJsonDocument<256> ack;
+
+    // Hanya frame teks utuh (tanpa fragmentasi); perintah selalu kecil
+    if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_TEXT || len > COMMAND_SOCKET_FRAME_MAX)
+    {
+      ack["ok"] = false;
+      ack["error"] = "frame";
+      send(client, ack);
+      return;
+    }
+
+    StaticJsonDocument<COMMAND_SOCKET_FRAME_MAX> req;
+    if (deserializeJson(req, data, len) || !req.is<JsonObject>())
+    {
+      ack["ok"] = false;
+      ack["error"] = "json";
+      send(client, ack);
+      return;
+    }
+
+    JsonObjectConst o = req.as<JsonObjectConst>();
+    uint32_t reqId = o["id"] | 0;
+    const char *op = o["op"] | "";
+    ack["id"] = reqId;
+
+    if (strcmp(op, "ping") == 0)
+      ack["ok"] = true;
+    else if (strcmp(op, "set") == 0 || strcmp(op, "pulse") == 0)
+      handleCommand(client, o, reqId, strcmp(op, "pulse") == 0, ack);
+    else if (strcmp(op, "tune") == 0)
+      handleTune(o, ack);
+    else
+    {
+      ack["ok"] = false;
+      ack["error"] = "op";
+    }
+    ack["us"] = (uint32_t)(esp_timer_get_time() - rxUs);
+    send(client, ack);
+    flushPending(client);
+  }
+
+  void handleCommand(AsyncWebSocketClient *client, JsonObjectConst o, uint32_t reqId, bool pulse, JsonDocument &ack)
+  {
+    RuntimeConfigReadGuard cfg;
+    WriteCommand cmd;
+    bool ok = commandFromJson(cfg.get(), o, CMD_SRC_WS, cmd) && (!pulse || (cmd.target == CMD_TARGET_DO && cmd.pulseMs > 0));
+    uint32_t id = ok ? commandQueue.submit(cmd) : 0;
+    if (!id)
+    {
+      ack["ok"] = false;
+      ack["error"] = ok ? "rejected" : "command";
+      return;
+    }
+
+    bool pending = cmd.target != CMD_TARGET_DO; // RS-485: status akhir di ack kedua
+    ack["ok"] = pending || commandQueue.result(id).status == CMD_STATUS_DONE;
+    ack["cmd"] = id;
+    ack["status"] = commandQueue.ackStatus(cmd, id);
+    if (pending && !trackPending(client->id(), id, reqId))
+      ack["error"] = "untracked"; // tetap dieksekusi; cek GET /commandStatus
+  }
+
+  bool trackPending(uint32_t client, uint32_t cmd, uint32_t reqId)
+  {
+    bool tracked = false;
+    portENTER_CRITICAL(&_mux);
+    for (Pending &p : _pending)
+    {
+      if (!p.cmd)
+      {
+        p.client = client;
+        p.cmd = cmd;
+        p.reqId = reqId;
+        tracked = true;
+        break;
+      }
+    }
+    portEXIT_CRITICAL(&_mux);
+    return tracked;
+  }
+
+  // Ack akhir perintah RS-485 milik client ini yang sudah selesai
+  void flushPending(AsyncWebSocketClient *client)
+  {
+    for (uint8_t i = 0; i < COMMAND_SOCKET_PENDING; i++)
+    {
+      Pending p;
+      portENTER_CRITICAL(&_mux);
+      p = _pending[i];
+      portEXIT_CRITICAL(&_mux);
+      if (!p.cmd || p.client != client->id())
+        continue;
+
+      CommandResult r = commandQueue.result(p.cmd);
+      if (r.status == CMD_STATUS_PENDING)
+        continue;
+      portENTER_CRITICAL(&_mux);
+      _pending[i].cmd = 0;
+      portEXIT_CRITICAL(&_mux);
+
+      StaticJsonDocument<192> ack;
+      ack["id"] = p.reqId;
+      ack["ok"] = r.status == CMD_STATUS_DONE;
+      CommandQueue::resultToJson(r, ack.createNestedObject("result"));
+      send(client, ack);
+    }
+  }
+
+  // Client putus: perintah tetap jalan, hasilnya lewat GET /commandStatus
+  void dropPending(uint32_t client)
+  {
+    portENTER_CRITICAL(&_mux);
+    for (Pending &p : _pending)
+    {
+      if (p.client == client)
+        p.cmd = 0;
+    }
+    portEXIT_CRITICAL(&_mux);
+  }
+
+  // Parameter AI yang boleh diubah live; field yang tidak ada dibiarkan.
+  // Hanya divalidasi & dititipkan, diterapkan oleh loop().
+  void handleTune(JsonObjectConst o, JsonDocument &ack)
+  {
+    int i = o["ai"] | 0;
+    if (i < 1 || i > jumlahInputAnalog)
+    {
+      ack["ok"] = false;
+      ack["error"] = "tune";
+      return;
+    }
+
+    Tune t = {};
+    tuneField(o, "filter", TUNE_FILTER, t.filter, t.fields);
+    tuneField(o, "filterPeriod", TUNE_FILTER_PERIOD, t.filterPeriod, t.fields);
+    tuneField(o, "scaling", TUNE_SCALING, t.scaling, t.fields);
+    tuneField(o, "lowLimit", TUNE_LOW_LIMIT, t.lowLimit, t.fields);
+    tuneField(o, "highLimit", TUNE_HIGH_LIMIT, t.highLimit, t.fields);
+    tuneField(o, "calibration", TUNE_CALIBRATION, t.calibration, t.fields);
+    tuneField(o, "mValue", TUNE_M_VALUE, t.mValue, t.fields);
+    tuneField(o, "cValue", TUNE_C_VALUE, t.cValue, t.fields);
+    if ((t.fields & TUNE_FILTER_PERIOD) && t.filterPeriod < 0)
+    {
+      ack["ok"] = false;
+      ack["error"] = "tune";
+      return;
+    }
+
+    portENTER_CRITICAL(&_mux);
+    applyTune(t, _tune[i]); // gabung dengan tune yang belum diterapkan
+    _tune[i].fields |= t.fields;
+    portEXIT_CRITICAL(&_mux);
+    ack["ok"] = true;
+  }
+
+  template <typename T>
+  static void tuneField(JsonObjectConst o, const char *key, uint16_t bit, T &value, uint16_t &fields)
+  {
+    JsonVariantConst v = o[key];
+    if (v.isNull())
+      return;
+    value = v.as<T>();
+    fields |= bit;
+  }
+
+  // Salin field yang ada di tune ke AnalogInput (atau ke Tune lain)
+  template <typename Target>
+  static void applyTune(const Tune &t, Target &dst)
+  {
+    if (t.fields & TUNE_FILTER)
+      dst.filter = t.filter;
+    if (t.fields & TUNE_FILTER_PERIOD)
+      dst.filterPeriod = t.filterPeriod;
+    if (t.fields & TUNE_SCALING)
+      dst.scaling = t.scaling;
+    if (t.fields & TUNE_LOW_LIMIT)
+      dst.lowLimit = t.lowLimit;
+    if (t.fields & TUNE_HIGH_LIMIT)
+      dst.highLimit = t.highLimit;
+    if (t.fields & TUNE_CALIBRATION)
+      dst.calibration = t.calibration;
+    if (t.fields & TUNE_M_VALUE)
+      dst.mValue = t.mValue;
+    if (t.fields & TUNE_C_VALUE)
+      dst.cValue = t.cValue;
+  }
+
+  void send(AsyncWebSocketClient *client, const JsonDocument &doc)
+  {
+    char buf[256];
+    size_t n = serializeJson(doc, buf, sizeof(buf));
+    if (client->canSend())
+      client->text(buf, n);
+  }
+
+  AsyncWebSocket _ws;
+  Pending _pending[COMMAND_SOCKET_PENDING] = {};
+  Tune _tune[jumlahInputAnalog + 1] = {};
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+CommandSocket commandSocket;
+
+#endif
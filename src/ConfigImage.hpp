@@ -0,0 +1,433 @@
+#ifndef CONFIG_IMAGE_HPP
+#define CONFIG_IMAGE_HPP
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <ArduinoJson.h>
+#include <type_traits>
+#include "esp_timer.h"
+#include "esp32/rom/crc.h"
+#include "config.hpp"
+
+extern DynamicJsonDocument jsonParam;
+extern String stringParam;
+extern int numOfParam;
+
+// ============================================================================
+// CONFIG IMAGE (binary config di NVS, jalur fast-boot)
+// Semua config (network, AI, DI, DO, Modbus) disimpan sebagai satu struct POD
+// di NVS namespace "cfg", diberi magic + versi + CRC32. Boot cukup memanggil
+// load(): satu getBytes() + CRC, tanpa SPIFFS dan tanpa parsing JSON.
+// Daftar tag Modbus (jsonParam, bentuknya bebas) disimpan terpisah sebagai
+// MessagePack di key "tags", dengan CRC sendiri di header.
+// File JSON di SPIFFS tetap ditulis, tapi hanya untuk import/export web dan
+// migrasi dari firmware lama (image belum ada / versi beda -> readConfig()).
+// Layout berubah? Naikkan CONFIG_IMAGE_VERSION: image lama otomatis ditolak.
+// ============================================================================
+
+#define CONFIG_IMAGE_MAGIC 0x4746434DUL // "MCFG"
+#define CONFIG_IMAGE_VERSION 1
+#define CONFIG_IMAGE_NAMESPACE "cfg"
+#define CONFIG_IMAGE_TAGS_MAX JSON_PARAM_CAPACITY // MessagePack <= pool jsonParam
+
+static_assert(CONFIG_IMAGE_TAGS_MAX <= 0xFFFF, "tagsSize di header 16 bit");
+
+struct ConfigImageHeader
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t payloadSize;
+  uint32_t generation; // naik setiap save()
+  uint32_t payloadCrc;
+  uint16_t tagsSize;   // panjang blob MessagePack tag Modbus
+  uint16_t reserved;
+  uint32_t tagsCrc;
+};
+
+struct ConfigImagePayload
+{
+  struct
+  {
+    char networkMode[12], dhcpMode[8], protocolMode[12], protocolMode2[16], sendTrig[20];
+    char ssid[33], password[65], apSsid[33], apPassword[65];
+    char ipAddress[16], subnetMask[16], ipGateway[16], ipDNS[16];
+    char endpoint[128], pubTopic[64], subTopic[64], mqttUsername[33], mqttPassword[65];
+    char loginUsername[33], loginPassword[65];
+    char erpUrl[128], erpUsername[33], erpPassword[65];
+    int32_t port, sdSaveInterval, liveInterval;
+    float sendInterval;
+    uint8_t loggerMode;
+  } net;
+
+  struct
+  {
+    char name[32], inputType[12];
+    uint8_t filter, scaling, calibration;
+    float filterPeriod, lowLimit, highLimit, mValue, cValue;
+  } ai[jumlahInputAnalog];
+
+  struct
+  {
+    char name[32], taskMode[16];
+    uint8_t inv, inputState;
+    uint32_t intervalTime;
+    float conversionFactor;
+  } di[jumlahInputDigital];
+
+  struct
+  {
+    char name[32];
+    uint8_t inv;
+  } dout[jumlahOutputDigital];
+
+  struct
+  {
+    int32_t baudrate, port, slaveID;
+    float scanRate;
+    uint8_t dataBit, stopBit, mode;
+    char parity[8];
+  } modbus;
+};
+
+static_assert(std::is_trivially_copyable<ConfigImagePayload>::value, "ConfigImagePayload harus POD");
+
+class ConfigImage
+{
+public:
+  // NVS -> struct global. false jika image tidak ada, rusak, atau beda versi.
+  bool load()
+  {
+    int64_t t0 = esp_timer_get_time();
+    _loadUs = 0;
+
+    Preferences prefs;
+    if (!prefs.begin(CONFIG_IMAGE_NAMESPACE, true))
+      return false;
+
+    ConfigImageHeader hdr;
+    ConfigImagePayload *p = new ConfigImagePayload; // ~2 KB, jangan di stack setup()
+    bool ok = prefs.getBytes("hdr", &hdr, sizeof(hdr)) == sizeof(hdr) &&
+              hdr.magic == CONFIG_IMAGE_MAGIC &&
+              hdr.version == CONFIG_IMAGE_VERSION &&
+              hdr.payloadSize == sizeof(ConfigImagePayload) &&
+              prefs.getBytes("img", p, sizeof(*p)) == sizeof(*p) &&
+              crc32_le(0, (const uint8_t *)p, sizeof(*p)) == hdr.payloadCrc;
+
+    // Tag Modbus bagian dari image: hilang / CRC salah -> seluruh image ditolak,
+    // supaya boot jatuh ke /modbusSetup.json, bukan jalan dengan tabel tag kosong
+    uint8_t *tags = NULL;
+    if (ok && hdr.tagsSize > 0)
+    {
+      tags = hdr.tagsSize <= CONFIG_IMAGE_TAGS_MAX ? (uint8_t *)malloc(hdr.tagsSize) : NULL;
+      ok = tags && prefs.getBytes("tags", tags, hdr.tagsSize) == hdr.tagsSize &&
+           crc32_le(0, tags, hdr.tagsSize) == hdr.tagsCrc;
+      if (!ok)
+        Serial.println("[CFG] Modbus tag table missing or CRC mismatch");
+    }
+    prefs.end();
+
+    if (ok)
+    {
+      jsonParam.clear();
+      if (tags && deserializeMsgPack(jsonParam, (const char *)tags, hdr.tagsSize))
+      {
+        Serial.println("[CFG] Modbus tag table does not fit jsonParam");
+        jsonParam.clear();
+        ok = false;
+      }
+    }
+    free(tags);
+
+    if (!ok)
+    {
+      Serial.println("[CFG] No valid config image in NVS");
+      delete p;
+      return false;
+    }
+
+    apply(*p);
+    delete p;
+
+    syncModbusTags();
+
+    _generation = hdr.generation;
+    _source = "nvs";
+    _loadUs = (uint32_t)(esp_timer_get_time() - t0);
+    Serial.printf("[CFG] Config image gen %u loaded from NVS in %u us\n", _generation, _loadUs);
+    return true;
+  }
+
+  // struct global -> NVS. Dipanggil setiap config berubah.
+  bool save()
+  {
+    ConfigImagePayload *p = new ConfigImagePayload;
+    capture(*p);
+
+    ConfigImageHeader hdr = {};
+    hdr.magic = CONFIG_IMAGE_MAGIC;
+    hdr.version = CONFIG_IMAGE_VERSION;
+    hdr.payloadSize = sizeof(ConfigImagePayload);
+    hdr.generation = _generation + 1;
+    hdr.payloadCrc = crc32_le(0, (const uint8_t *)p, sizeof(*p));
+
+    // Tabel tag yang tidak muat tidak boleh menimpa image lama: image tanpa
+    // tag akan lolos CRC dan boot berikutnya kehilangan semua tag Modbus
+    size_t tagsSize = measureMsgPack(jsonParam);
+    uint8_t *tags = NULL;
+    if (tagsSize > CONFIG_IMAGE_TAGS_MAX)
+    {
+      Serial.printf("[CFG] ❌ Modbus tag table too large (%u B > %u B), image not saved\n",
+                    (unsigned)tagsSize, (unsigned)CONFIG_IMAGE_TAGS_MAX);
+      delete p;
+      return false;
+    }
+    if (tagsSize > 0)
+    {
+      tags = (uint8_t *)malloc(tagsSize);
+      if (!tags || serializeMsgPack(jsonParam, tags, tagsSize) != tagsSize)
+      {
+        Serial.println("[CFG] ❌ Failed to serialize Modbus tag table, image not saved");
+        free(tags);
+        delete p;
+        return false;
+      }
+      hdr.tagsSize = tagsSize;
+      hdr.tagsCrc = crc32_le(0, tags, tagsSize);
+    }
+
+    Preferences prefs;
+    bool ok = prefs.begin(CONFIG_IMAGE_NAMESPACE, false);
+    if (ok)
+    {
+      // Header ditulis terakhir: jika mati listrik di tengah, CRC lama tidak
+      // cocok dengan payload baru dan boot jatuh ke migrasi JSON
+      ok = prefs.putBytes("img", p, sizeof(*p)) == sizeof(*p);
+      if (ok && hdr.tagsSize)
+        ok = prefs.putBytes("tags", tags, hdr.tagsSize) == hdr.tagsSize;
+      if (ok)
+        ok = prefs.putBytes("hdr", &hdr, sizeof(hdr)) == sizeof(hdr);
+      prefs.end();
+    }
+
+    free(tags);
+    delete p;
+
+    if (ok)
+    {
+      _generation = hdr.generation;
+      Serial.printf("[CFG] Config image gen %u saved to NVS\n", _generation);
+    }
+    else
+    {
+      Serial.println("[CFG] ❌ Failed to write config image to NVS");
+    }
+    return ok;
+  }
+
+  // Paksa boot berikutnya membaca ulang file JSON
+  void invalidate()
+  {
+    Preferences prefs;
+    if (prefs.begin(CONFIG_IMAGE_NAMESPACE, false))
+    {
+      prefs.remove("hdr");
+      prefs.end();
+    }
+  }
+
+  // Dipakai setelah config diambil dari JSON (migrasi / import)
+  void markSource(const char *source) { _source = source; }
+
+  uint32_t generation() const { return _generation; }
+  uint32_t loadMicros() const { return _loadUs; }
+  const char *source() const { return _source; }
+
+private:
+  template <size_t N>
+  static void put(char (&dst)[N], const String &src)
+  {
+    if (src.length() >= N)
+      Serial.printf("[CFG] ⚠ Value truncated to %u chars: %s\n", (unsigned)(N - 1), src.c_str());
+    strlcpy(dst, src.c_str(), N);
+  }
+
+  template <size_t N>
+  static String get(const char (&src)[N])
+  {
+    char tmp[N];
+    memcpy(tmp, src, N);
+    tmp[N - 1] = '\0';
+    return String(tmp);
+  }
+
+  static void capture(ConfigImagePayload &p)
+  {
+    memset(&p, 0, sizeof(p)); // padding ikut 0 supaya CRC deterministik
+
+    put(p.net.networkMode, networkSettings.networkMode);
+    put(p.net.dhcpMode, networkSettings.dhcpMode);
+    put(p.net.protocolMode, networkSettings.protocolMode);
+    put(p.net.protocolMode2, networkSettings.protocolMode2);
+    put(p.net.sendTrig, networkSettings.sendTrig);
+    put(p.net.ssid, networkSettings.ssid);
+    put(p.net.password, networkSettings.password);
+    put(p.net.apSsid, networkSettings.apSsid);
+    put(p.net.apPassword, networkSettings.apPassword);
+    put(p.net.ipAddress, networkSettings.ipAddress);
+    put(p.net.subnetMask, networkSettings.subnetMask);
+    put(p.net.ipGateway, networkSettings.ipGateway);
+    put(p.net.ipDNS, networkSettings.ipDNS);
+    put(p.net.endpoint, networkSettings.endpoint);
+    put(p.net.pubTopic, networkSettings.pubTopic);
+    put(p.net.subTopic, networkSettings.subTopic);
+    put(p.net.mqttUsername, networkSettings.mqttUsername);
+    put(p.net.mqttPassword, networkSettings.mqttPassword);
+    put(p.net.loginUsername, networkSettings.loginUsername);
+    put(p.net.loginPassword, networkSettings.loginPassword);
+    put(p.net.erpUrl, networkSettings.erpUrl);
+    put(p.net.erpUsername, networkSettings.erpUsername);
+    put(p.net.erpPassword, networkSettings.erpPassword);
+    p.net.port = networkSettings.port;
+    p.net.sdSaveInterval = networkSettings.sdSaveInterval;
+    p.net.liveInterval = networkSettings.liveInterval;
+    p.net.sendInterval = networkSettings.sendInterval;
+    p.net.loggerMode = networkSettings.loggerMode;
+
+    for (int i = 1; i <= jumlahInputAnalog; i++)
+    {
+      auto &a = p.ai[i - 1];
+      put(a.name, analogInput[i].name);
+      put(a.inputType, analogInput[i].inputType);
+      a.filter = analogInput[i].filter;
+      a.scaling = analogInput[i].scaling;
+      a.calibration = analogInput[i].calibration;
+      a.filterPeriod = analogInput[i].filterPeriod;
+      a.lowLimit = analogInput[i].lowLimit;
+      a.highLimit = analogInput[i].highLimit;
+      a.mValue = analogInput[i].mValue;
+      a.cValue = analogInput[i].cValue;
+    }
+
+    for (int i = 1; i <= jumlahInputDigital; i++)
+    {
+      auto &d = p.di[i - 1];
+      put(d.name, digitalInput[i].name);
+      put(d.taskMode, digitalInput[i].taskMode);
+      d.inv = digitalInput[i].inv;
+      d.inputState = digitalInput[i].inputState;
+      d.intervalTime = digitalInput[i].intervalTime;
+      d.conversionFactor = digitalInput[i].conversionFactor;
+    }
+
+    for (int i = 1; i <= jumlahOutputDigital; i++)
+    {
+      put(p.dout[i - 1].name, digitalOutput[i].name);
+      p.dout[i - 1].inv = digitalOutput[i].inv;
+    }
+
+    p.modbus.baudrate = modbusParam.baudrate;
+    p.modbus.port = modbusParam.port;
+    p.modbus.slaveID = modbusParam.slaveID;
+    p.modbus.scanRate = modbusParam.scanRate;
+    p.modbus.dataBit = modbusParam.dataBit;
+    p.modbus.stopBit = modbusParam.stopBit;
+    p.modbus.mode = modbusParam.mode;
+    put(p.modbus.parity, modbusParam.parity);
+  }
+
+  static void apply(const ConfigImagePayload &p)
+  {
+    networkSettings.networkMode = get(p.net.networkMode);
+    networkSettings.dhcpMode = get(p.net.dhcpMode);
+    networkSettings.protocolMode = get(p.net.protocolMode);
+    networkSettings.protocolMode2 = get(p.net.protocolMode2);
+    networkSettings.sendTrig = get(p.net.sendTrig);
+    networkSettings.ssid = get(p.net.ssid);
+    networkSettings.password = get(p.net.password);
+    networkSettings.apSsid = get(p.net.apSsid);
+    networkSettings.apPassword = get(p.net.apPassword);
+    networkSettings.ipAddress = get(p.net.ipAddress);
+    networkSettings.subnetMask = get(p.net.subnetMask);
+    networkSettings.ipGateway = get(p.net.ipGateway);
+    networkSettings.ipDNS = get(p.net.ipDNS);
+    networkSettings.endpoint = get(p.net.endpoint);
+    networkSettings.pubTopic = get(p.net.pubTopic);
+    networkSettings.subTopic = get(p.net.subTopic);
+    networkSettings.mqttUsername = get(p.net.mqttUsername);
+    networkSettings.mqttPassword = get(p.net.mqttPassword);
+    networkSettings.loginUsername = get(p.net.loginUsername);
+    networkSettings.loginPassword = get(p.net.loginPassword);
+    networkSettings.erpUrl = get(p.net.erpUrl);
+    networkSettings.erpUsername = get(p.net.erpUsername);
+    networkSettings.erpPassword = get(p.net.erpPassword);
+    networkSettings.port = p.net.port;
+    networkSettings.sdSaveInterval = p.net.sdSaveInterval;
+    networkSettings.liveInterval = p.net.liveInterval;
+    networkSettings.sendInterval = p.net.sendInterval;
+    networkSettings.loggerMode = p.net.loggerMode;
+
+    for (int i = 1; i <= jumlahInputAnalog; i++)
+    {
+      const auto &a = p.ai[i - 1];
+      analogInput[i].name = get(a.name);
+      analogInput[i].inputType = get(a.inputType);
+      analogInput[i].filter = a.filter;
+      analogInput[i].scaling = a.scaling;
+      analogInput[i].calibration = a.calibration;
+      analogInput[i].filterPeriod = a.filterPeriod;
+      analogInput[i].lowLimit = a.lowLimit;
+      analogInput[i].highLimit = a.highLimit;
+      analogInput[i].mValue = a.mValue;
+      analogInput[i].cValue = a.cValue;
+    }
+
+    for (int i = 1; i <= jumlahInputDigital; i++)
+    {
+      const auto &d = p.di[i - 1];
+      digitalInput[i].name = get(d.name);
+      digitalInput[i].taskMode = get(d.taskMode);
+      digitalInput[i].inv = d.inv;
+      digitalInput[i].inputState = d.inputState;
+      digitalInput[i].intervalTime = d.intervalTime;
+      digitalInput[i].conversionFactor = d.conversionFactor;
+    }
+
+    for (int i = 1; i <= jumlahOutputDigital; i++)
+    {
+      digitalOutput[i].name = get(p.dout[i - 1].name);
+      digitalOutput[i].inv = p.dout[i - 1].inv;
+    }
+
+    modbusParam.baudrate = p.modbus.baudrate;
+    modbusParam.port = p.modbus.port;
+    modbusParam.slaveID = p.modbus.slaveID;
+    modbusParam.scanRate = p.modbus.scanRate;
+    modbusParam.dataBit = p.modbus.dataBit;
+    modbusParam.stopBit = p.modbus.stopBit;
+    modbusParam.mode = p.modbus.mode;
+    modbusParam.parity = get(p.modbus.parity);
+  }
+
+  // jsonParam juga menyimpan parameter serial (dipakai /modbusLoad & export)
+  static void syncModbusTags()
+  {
+    jsonParam["baudrate"] = modbusParam.baudrate;
+    jsonParam["parity"] = modbusParam.parity;
+    jsonParam["stopBit"] = modbusParam.stopBit;
+    jsonParam["dataBit"] = modbusParam.dataBit;
+    jsonParam["scanRate"] = modbusParam.scanRate;
+
+    JsonArray nameData = jsonParam["nameData"];
+    numOfParam = nameData.size();
+    stringParam = "";
+    serializeJson(jsonParam, stringParam);
+  }
+
+  uint32_t _generation = 0;
+  uint32_t _loadUs = 0;
+  const char *_source = "default";
+};
+
+ConfigImage configImage;
+
+#endif
@@ -0,0 +1,346 @@
+#ifndef CONFIG_STORE_HPP
+#define CONFIG_STORE_HPP
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SPIFFS.h>
+#include <ArduinoJson.h>
+#include "SharedSpiSD.hpp"
+#include "SpiBusManager.hpp"
+#include "ConfigImage.hpp"
+#include "Trace.hpp"
+
+extern SemaphoreHandle_t jsonMutex;
+extern SemaphoreHandle_t sdMutex;
+extern void buildConfigJson(const String &type, JsonDocument &out);
+
+// ============================================================================
+// CONFIG STORE (commit transaksional + mirror SD asinkron)
+// Web handler hanya mengubah struct global lalu memanggil markDirty(). Commit
+// dijalankan Task_DataLogger setelah edit berhenti CONFIG_COMMIT_QUIET_MS
+// (beberapa form beruntun = satu commit), paling lambat CONFIG_COMMIT_MAX_DELAY_MS.
+// Urutan commit:
+//   1. image biner NVS (ConfigImage, header ditulis terakhir) -> titik commit,
+//      generation naik satu
+//   2. file JSON SPIFFS: tulis <file>.tmp, hapus lama, rename
+//   3. tandai section untuk mirror SD; disalin dari SPIFFS dengan pola tmp +
+//      rename yang sama, tanpa menahan request web
+// SPIFFS & FAT tidak bisa rename menimpa file, jadi recover() saat boot:
+// ada .tmp tanpa file utama = rename belum selesai (tmp sudah lengkap);
+// ada keduanya = crash saat menulis tmp, tmp dibuang.
+// ============================================================================
+
+#define CONFIG_COMMIT_QUIET_MS 1500
+#define CONFIG_COMMIT_MAX_DELAY_MS 10000
+#define CONFIG_SD_RETRY_MS 30000
+
+enum ConfigSection : uint8_t
+{
+  CFG_NETWORK = 1 << 0,
+  CFG_DIGITAL = 1 << 1,
+  CFG_ANALOG = 1 << 2,
+  CFG_MODBUS = 1 << 3,
+  CFG_SYSTEM = 1 << 4,
+  CFG_ALL = 0x1F
+};
+
+// File JSON per jenis config (format import/export & mirror SD, bukan sumber boot)
+struct ConfigFileEntry
+{
+  uint8_t section;
+  const char *type;
+  const char *path;
+};
+const ConfigFileEntry configFiles[] = {
+    {CFG_NETWORK, "network", "/configNetwork.json"},
+    {CFG_DIGITAL, "digital", "/configDigital.json"},
+    {CFG_ANALOG, "analog", "/configAnalog.json"},
+    {CFG_MODBUS, "modbusSetup", "/modbusSetup.json"},
+    {CFG_SYSTEM, "systemSettings", "/systemSettings.json"},
+};
+
+class ConfigStore
+{
+public:
+  void begin()
+  {
+    _lock = xSemaphoreCreateMutex();
+    recover(SPIFFS, "SPIFFS");
+  }
+
+  // Dipanggil dari web handler setelah struct global diubah. Tidak ada I/O.
+  void markDirty(uint8_t sections)
+  {
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if (!_dirty)
+      _firstDirty = millis();
+    _dirty |= sections;
+    _lastDirty = millis();
+    _edits++;
+    xSemaphoreGive(_lock);
+  }
+
+  // Dipanggil berkala dari Task_DataLogger
+  void loop()
+  {
+    uint8_t due = 0;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if (_dirty && (millis() - _lastDirty >= CONFIG_COMMIT_QUIET_MS ||
+                   millis() - _firstDirty >= CONFIG_COMMIT_MAX_DELAY_MS))
+    {
+      due = _dirty;
+      _dirty = 0;
+    }
+    xSemaphoreGive(_lock);
+
+    if (due)
+      commit(due);
+
+    if (_sdPending && millis() >= _sdRetryAt)
+      mirrorToSD();
+  }
+
+  // Commit sekarang juga (sebelum restart). Mirror SD menyusul di boot berikutnya.
+  bool flush()
+  {
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    uint8_t due = _dirty;
+    _dirty = 0;
+    xSemaphoreGive(_lock);
+    return due ? commit(due) : true;
+  }
+
+  // Bereskan rename yang terputus (lihat header)
+  void recover(fs::FS &fs, const char *label)
+  {
+    for (const ConfigFileEntry &f : configFiles)
+    {
+      String tmp = String(f.path) + ".tmp";
+      if (!fs.exists(tmp))
+        continue;
+      if (fs.exists(f.path))
+      {
+        fs.remove(tmp);
+        Serial.printf("[CFG] %s: discarded partial %s\n", label, tmp.c_str());
+      }
+      else if (fs.rename(tmp, f.path))
+      {
+        Serial.printf("[CFG] %s: completed interrupted commit of %s\n", label, f.path);
+      }
+    }
+  }
+
+  void statsToJson(JsonObject obj)
+  {
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    obj["generation"] = configImage.generation();
+    obj["dirty"] = _dirty;
+    obj["sdPending"] = _sdPending;
+    obj["edits"] = _edits;
+    obj["commits"] = _commits;
+    obj["failures"] = _failures;
+    obj["lastCommitMs"] = _lastCommitMs;
+    obj["lastCommitDurationMs"] = _lastCommitDuration;
+    obj["sdMirrors"] = _sdMirrors;
+    xSemaphoreGive(_lock);
+  }
+
+  // Tulis satu file secara atomik: <path>.tmp -> hapus lama -> rename
+  static bool writeAtomic(fs::FS &fs, const char *path, const String &data)
+  {
+    String tmp = String(path) + ".tmp";
+    File file = fs.open(tmp, "w");
+    if (!file)
+      return false;
+    size_t written = file.print(data);
+    file.close();
+    if (written != data.length())
+    {
+      fs.remove(tmp);
+      return false;
+    }
+    if (fs.exists(path) && !fs.remove(path))
+      return false;
+    return fs.rename(tmp, path);
+  }
+
+private:
+  bool commit(uint8_t sections)
+  {
+    TraceScope trace(TR_CONFIG_COMMIT);
+    unsigned long start = millis();
+    String data[sizeof(configFiles) / sizeof(configFiles[0])];
+
+    // Snapshot di bawah jsonMutex; I/O file dilakukan setelah mutex dilepas
+    if (!xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(1000)))
+    {
+      requeue(sections);
+      return false;
+    }
+    // File dibangun dulu: section yang tidak muat membatalkan seluruh commit
+    // (image NVS juga), bukan menulis config terpotong
+    DynamicJsonDocument docSave(JSON_PARAM_CAPACITY);
+    for (size_t i = 0; i < sizeof(configFiles) / sizeof(configFiles[0]); i++)
+    {
+      if (!(sections & configFiles[i].section))
+        continue;
+      docSave.clear();
+      buildConfigJson(configFiles[i].type, docSave);
+      if (docSave.overflowed())
+      {
+        xSemaphoreGive(jsonMutex);
+        Serial.printf("[CFG] ❌ %s does not fit %u B, commit aborted\n", configFiles[i].path,
+                      (unsigned)JSON_PARAM_CAPACITY);
+        // Tidak di-requeue: isi yang sama akan overflow lagi sampai config diubah
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        _failures++;
+        xSemaphoreGive(_lock);
+        return false;
+      }
+      serializeJson(docSave, data[i]);
+    }
+    bool ok = configImage.save();
+    xSemaphoreGive(jsonMutex);
+
+    for (size_t i = 0; i < sizeof(configFiles) / sizeof(configFiles[0]); i++)
+    {
+      if (!(sections & configFiles[i].section))
+        continue;
+      if (writeAtomic(SPIFFS, configFiles[i].path, data[i]))
+      {
+        Serial.printf("✅ Config Saved: %s\n", configFiles[i].path);
+      }
+      else
+      {
+        Serial.printf("❌ Failed to write %s\n", configFiles[i].path);
+        ok = false;
+      }
+    }
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    _sdPending |= sections;
+    _sdRetryAt = 0;
+    if (ok)
+    {
+      _commits++;
+      _lastCommitMs = millis();
+      _lastCommitDuration = millis() - start;
+    }
+    xSemaphoreGive(_lock);
+
+    if (!ok)
+      requeue(sections);
+    else
+      Serial.printf("[CFG] Commit gen %u (sections 0x%02X) in %lu ms\n",
+                    configImage.generation(), sections, millis() - start);
+    return ok;
+  }
+
+  void requeue(uint8_t sections)
+  {
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if (!_dirty)
+      _firstDirty = millis();
+    _dirty |= sections;
+    _lastDirty = millis(); // coba lagi setelah quiet period berikutnya
+    _failures++;
+    xSemaphoreGive(_lock);
+  }
+
+  // Salin file SPIFFS yang sudah di-commit ke SD (tmp + rename), per sektor
+  void mirrorToSD()
+  {
+    if (!SD.mounted() || !xSemaphoreTake(sdMutex, 0))
+    {
+      _sdRetryAt = millis() + CONFIG_SD_RETRY_MS;
+      return;
+    }
+
+    SpiBusLease lease(SPI_CLIENT_SD_CONFIG, SPI_PRIO_NORMAL, 500, 20);
+    if (!lease)
+    {
+      xSemaphoreGive(sdMutex);
+      _sdRetryAt = millis() + 1000;
+      return;
+    }
+
+    if (!_sdRecovered)
+    {
+      recover(SD, "SD");
+      _sdRecovered = true;
+    }
+
+    uint8_t done = 0;
+    for (const ConfigFileEntry &f : configFiles)
+    {
+      if (!(_sdPending & f.section))
+        continue;
+      if (copyToSD(f.path, lease))
+        done |= f.section;
+      else
+        Serial.printf("  ✗ Failed to mirror %s to SD\n", f.path);
+    }
+
+    lease.release();
+    xSemaphoreGive(sdMutex);
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    _sdPending &= ~done;
+    if (done)
+      _sdMirrors++;
+    _sdRetryAt = _sdPending ? millis() + CONFIG_SD_RETRY_MS : 0;
+    xSemaphoreGive(_lock);
+
+    if (done)
+      Serial.printf("  ✓ Config mirrored to SD (sections 0x%02X)\n", done);
+  }
+
+  bool copyToSD(const char *path, SpiBusLease &lease)
+  {
+    File src = SPIFFS.open(path, "r");
+    if (!src)
+      return false;
+
+    String tmp = String(path) + ".tmp";
+    File dst = SD.open(tmp, FILE_WRITE);
+    if (!dst)
+    {
+      src.close();
+      return false;
+    }
+
+    SpiSliceWriter out(dst, lease);
+    uint8_t buf[128];
+    size_t n;
+    bool ok = true;
+    while (ok && (n = src.read(buf, sizeof(buf))) > 0)
+      ok = out.write(buf, n) == n;
+    ok = out.finish() && ok;
+    src.close();
+    dst.close();
+
+    if (!ok || !lease.reacquire())
+      return false;
+    if (SD.exists(path))
+      SD.remove(path);
+    return SD.rename(tmp, path);
+  }
+
+  SemaphoreHandle_t _lock = NULL;
+  uint8_t _dirty = 0;
+  uint8_t _sdPending = 0;
+  unsigned long _firstDirty = 0;
+  unsigned long _lastDirty = 0;
+  unsigned long _sdRetryAt = 0;
+  unsigned long _lastCommitMs = 0;
+  unsigned long _lastCommitDuration = 0;
+  uint32_t _edits = 0;
+  uint32_t _commits = 0;
+  uint32_t _failures = 0;
+  uint32_t _sdMirrors = 0;
+  bool _sdRecovered = false;
+};
+
+ConfigStore configStore;
+
+#endif
@@ -0,0 +1,445 @@
+#ifndef EXPRESSION_HPP
+#define EXPRESSION_HPP
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// ============================================================================
+// EXPRESSION (kanal virtual: dP = AI1 - AI2, flow = k * sqrt(dP), dst.)
+// Ekspresi di-compile SEKALI saat snapshot config dibuat menjadi bytecode
+// stack (ExprProgram, POD, ikut di RuntimeConfig), lalu dievaluasi per siklus
+// akuisisi oleh exprEval(): satu switch per instruksi, stack float di stack
+// C, tanpa alokasi & tanpa parse string. Seperti SignalMath.hpp, tanpa
+// Arduino.h supaya bisa dikompilasi & diukur di host.
+//
+// Sintaks:
+//   angka, variabel (AI1, DI2, nama tag, kanal virtual sebelumnya; nama
+//   dengan spasi ditulis {Flow Meter 1}), + - * / ^, unary - !,
+//   < <= > >= == !=, && ||, ( )
+//   min(a,b,..) max(a,b,..) abs(x) sqrt(x) pow(a,b) if(c,a,b)
+//   prev(x)  : nilai x pada evaluasi sebelumnya (evaluasi pertama = x)
+//   integ(x) : integral x dt (detik) sejak config dimuat
+// Nilai boolean = 1 / 0. Pembagian nol & sqrt negatif menghasilkan NaN/inf
+// apa adanya (tidak dipotong), supaya kesalahan terlihat di data.
+// ============================================================================
+
+#define EXPR_MAX_CODE 64  // byte bytecode
+#define EXPR_MAX_CONST 8
+#define EXPR_MAX_STATE 8  // slot state prev()/integ() per ekspresi
+#define EXPR_MAX_STACK 12
+
+enum ExprOp : uint8_t
+{
+  EX_CONST = 0, // + index konstanta
+  EX_VAR,       // + slot variabel
+  EX_PREV,      // + slot state (2 slot: nilai, valid)
+  EX_INTEG,     // + slot state
+  EX_NEG,
+  EX_NOT,
+  EX_ADD,
+  EX_SUB,
+  EX_MUL,
+  EX_DIV,
+  EX_POW,
+  EX_LT,
+  EX_LE,
+  EX_GT,
+  EX_GE,
+  EX_EQ,
+  EX_NE,
+  EX_AND,
+  EX_OR,
+  EX_MIN,
+  EX_MAX,
+  EX_ABS,
+  EX_SQRT,
+  EX_IF
+};
+
+struct ExprProgram
+{
+  uint8_t len;        // panjang code
+  uint8_t constCount; // jumlah konstanta
+  uint8_t stateCount; // slot state yang dipakai prev()/integ()
+  uint8_t code[EXPR_MAX_CODE];
+  float consts[EXPR_MAX_CONST];
+};
+
+// Nama variabel -> slot (>= 0), -1 jika tidak dikenal
+typedef int (*ExprResolver)(const char *name, size_t len, void *ctx);
+
+// Evaluasi satu program. vars = nilai semua slot, state = EXPR_MAX_STATE
+// float milik kanal ini (nol saat config dimuat), dt = detik sejak evaluasi
+// sebelumnya (untuk integ).
+inline float exprEval(const ExprProgram &p, const float *vars, float *state, float dt)
+{
+  float st[EXPR_MAX_STACK];
+  int sp = 0;
+  uint8_t pc = 0;
+  while (pc < p.len)
+  {
+    switch (p.code[pc++])
+    {
+    case EX_CONST:
+      st[sp++] = p.consts[p.code[pc++]];
+      break;
+    case EX_VAR:
+      st[sp++] = vars[p.code[pc++]];
+      break;
+    case EX_PREV:
+    {
+      float *s = &state[p.code[pc++]];
+      float cur = st[sp - 1];
+      st[sp - 1] = s[1] != 0.0f ? s[0] : cur;
+      s[0] = cur;
+      s[1] = 1.0f;
+      break;
+    }
+    case EX_INTEG:
+    {
+      float *s = &state[p.code[pc++]];
+      *s += st[sp - 1] * dt;
+      st[sp - 1] = *s;
+      break;
+    }
+    case EX_NEG:
+      st[sp - 1] = -st[sp - 1];
+      break;
+    case EX_NOT:
+      st[sp - 1] = st[sp - 1] == 0.0f;
+      break;
+    case EX_ABS:
+      st[sp - 1] = fabsf(st[sp - 1]);
+      break;
+    case EX_SQRT:
+      st[sp - 1] = sqrtf(st[sp - 1]);
+      break;
+    case EX_IF:
+      sp -= 2;
+      st[sp - 1] = st[sp - 1] != 0.0f ? st[sp] : st[sp + 1];
+      break;
+    default:
+    {
+      // Operator biner: dua nilai teratas -> satu
+      uint8_t op = p.code[pc - 1];
+      float b = st[--sp];
+      float &a = st[sp - 1];
+      switch (op)
+      {
+      case EX_ADD: a = a + b; break;
+      case EX_SUB: a = a - b; break;
+      case EX_MUL: a = a * b; break;
+      case EX_DIV: a = a / b; break;
+      case EX_POW: a = powf(a, b); break;
+      case EX_LT: a = a < b; break;
+      case EX_LE: a = a <= b; break;
+      case EX_GT: a = a > b; break;
+      case EX_GE: a = a >= b; break;
+      case EX_EQ: a = a == b; break;
+      case EX_NE: a = a != b; break;
+      case EX_AND: a = a != 0.0f && b != 0.0f; break;
+      case EX_OR: a = a != 0.0f || b != 0.0f; break;
+      case EX_MIN: a = fminf(a, b); break;
+      case EX_MAX: a = fmaxf(a, b); break;
+      }
+      break;
+    }
+    }
+  }
+  return sp == 1 ? st[0] : NAN;
+}
+
+// Recursive descent langsung ke bytecode. compile() mengembalikan NULL jika
+// berhasil, atau pesan kesalahan (literal statis).
+class ExprCompiler
+{
+public:
+  const char *compile(const char *src, ExprProgram &out, ExprResolver resolve, void *ctx)
+  {
+    memset(&out, 0, sizeof(out));
+    _p = src;
+    _out = &out;
+    _resolve = resolve;
+    _ctx = ctx;
+    _error = NULL;
+    _depth = 0;
+
+    parseOr();
+    skipSpace();
+    if (!_error && *_p)
+      _error = "unexpected character";
+    if (!_error && _depth != 1)
+      _error = "empty expression";
+    return _error;
+  }
+
+private:
+  void skipSpace()
+  {
+    while (isspace((unsigned char)*_p))
+      _p++;
+  }
+
+  bool accept(const char *tok)
+  {
+    skipSpace();
+    size_t n = strlen(tok);
+    if (strncmp(_p, tok, n) != 0)
+      return false;
+    _p += n;
+    return true;
+  }
+
+  void fail(const char *msg)
+  {
+    if (!_error)
+      _error = msg;
+  }
+
+  // pop/push: perubahan kedalaman stack saat runtime
+  void emit(uint8_t op, int pop, int push)
+  {
+    if (_out->len >= EXPR_MAX_CODE)
+      return fail("expression too long");
+    _out->code[_out->len++] = op;
+    _depth += push - pop;
+    if (_depth > EXPR_MAX_STACK)
+      fail("expression too deep");
+  }
+
+  void emitArg(uint8_t op, uint8_t arg, int pop, int push)
+  {
+    emit(op, pop, push);
+    if (_out->len >= EXPR_MAX_CODE)
+      return fail("expression too long");
+    _out->code[_out->len++] = arg;
+  }
+
+  void parseOr()
+  {
+    parseAnd();
+    while (!_error && accept("||"))
+    {
+      parseAnd();
+      emit(EX_OR, 2, 1);
+    }
+  }
+
+  void parseAnd()
+  {
+    parseCompare();
+    while (!_error && accept("&&"))
+    {
+      parseCompare();
+      emit(EX_AND, 2, 1);
+    }
+  }
+
+  void parseCompare()
+  {
+    parseAdd();
+    while (!_error)
+    {
+      uint8_t op;
+      if (accept("<="))
+        op = EX_LE;
+      else if (accept(">="))
+        op = EX_GE;
+      else if (accept("=="))
+        op = EX_EQ;
+      else if (accept("!="))
+        op = EX_NE;
+      else if (accept("<"))
+        op = EX_LT;
+      else if (accept(">"))
+        op = EX_GT;
+      else
+        return;
+      parseAdd();
+      emit(op, 2, 1);
+    }
+  }
+
+  void parseAdd()
+  {
+    parseMul();
+    while (!_error)
+    {
+      uint8_t op;
+      if (accept("+"))
+        op = EX_ADD;
+      else if (accept("-"))
+        op = EX_SUB;
+      else
+        return;
+      parseMul();
+      emit(op, 2, 1);
+    }
+  }
+
+  void parseMul()
+  {
+    parseUnary();
+    while (!_error)
+    {
+      uint8_t op;
+      if (accept("*"))
+        op = EX_MUL;
+      else if (accept("/"))
+        op = EX_DIV;
+      else
+        return;
+      parseUnary();
+      emit(op, 2, 1);
+    }
+  }
+
+  void parseUnary()
+  {
+    if (accept("-"))
+    {
+      parseUnary();
+      emit(EX_NEG, 1, 1);
+    }
+    else if (accept("!"))
+    {
+      parseUnary();
+      emit(EX_NOT, 1, 1);
+    }
+    else
+      parsePow();
+  }
+
+  void parsePow()
+  {
+    parsePrimary();
+    if (!_error && accept("^"))
+    {
+      parseUnary(); // asosiatif kanan: 2^3^2 = 2^9
+      emit(EX_POW, 2, 1);
+    }
+  }
+
+  void parsePrimary()
+  {
+    skipSpace();
+    if (_error)
+      return;
+    if (accept("("))
+    {
+      parseOr();
+      if (!accept(")"))
+        fail("missing ')'");
+      return;
+    }
+    if (isdigit((unsigned char)*_p) || *_p == '.')
+    {
+      char *end;
+      float v = strtof(_p, &end);
+      _p = end;
+      if (_out->constCount >= EXPR_MAX_CONST)
+        return fail("too many constants");
+      _out->consts[_out->constCount] = v;
+      emitArg(EX_CONST, _out->constCount++, 0, 1);
+      return;
+    }
+    if (*_p == '{')
+    {
+      const char *name = ++_p;
+      while (*_p && *_p != '}')
+        _p++;
+      if (*_p != '}')
+        return fail("missing '}'");
+      variable(name, _p++ - name);
+      return;
+    }
+    if (isalpha((unsigned char)*_p) || *_p == '_')
+    {
+      const char *name = _p;
+      while (isalnum((unsigned char)*_p) || *_p == '_' || *_p == '.')
+        _p++;
+      size_t len = _p - name;
+      if (accept("("))
+        call(name, len);
+      else
+        variable(name, len);
+      return;
+    }
+    fail("unexpected character");
+  }
+
+  void variable(const char *name, size_t len)
+  {
+    int slot = _resolve ? _resolve(name, len, _ctx) : -1;
+    if (slot < 0 || slot > 255)
+      return fail("unknown variable");
+    emitArg(EX_VAR, (uint8_t)slot, 0, 1);
+  }
+
+  // Argumen dipisah koma sampai ')'; kembalikan jumlahnya
+  int arguments()
+  {
+    int n = 0;
+    skipSpace();
+    if (accept(")"))
+      return 0;
+    do
+    {
+      parseOr();
+      n++;
+    } while (!_error && accept(","));
+    if (!accept(")"))
+      fail("missing ')'");
+    return n;
+  }
+
+  static bool named(const char *name, size_t len, const char *fn)
+  {
+    return strlen(fn) == len && strncmp(name, fn, len) == 0;
+  }
+
+  void call(const char *name, size_t len)
+  {
+    int n = arguments();
+    if (_error)
+      return;
+    if (named(name, len, "min") || named(name, len, "max"))
+    {
+      if (n < 2)
+        return fail("min/max need 2+ arguments");
+      for (int i = 1; i < n; i++)
+        emit(named(name, len, "min") ? EX_MIN : EX_MAX, 2, 1);
+    }
+    else if (named(name, len, "pow") && n == 2)
+      emit(EX_POW, 2, 1);
+    else if (named(name, len, "if") && n == 3)
+      emit(EX_IF, 3, 1);
+    else if (named(name, len, "abs") && n == 1)
+      emit(EX_ABS, 1, 1);
+    else if (named(name, len, "sqrt") && n == 1)
+      emit(EX_SQRT, 1, 1);
+    else if ((named(name, len, "prev") || named(name, len, "integ")) && n == 1)
+    {
+      bool prev = named(name, len, "prev");
+      uint8_t slots = prev ? 2 : 1;
+      if (_out->stateCount + slots > EXPR_MAX_STATE)
+        return fail("too many prev/integ");
+      emitArg(prev ? EX_PREV : EX_INTEG, _out->stateCount, 1, 1);
+      _out->stateCount += slots;
+    }
+    else
+      fail("unknown function or wrong argument count");
+  }
+
+  const char *_p;
+  ExprProgram *_out;
+  ExprResolver _resolve;
+  void *_ctx;
+  const char *_error;
+  int _depth;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef FIXED_STRING_HPP
+#define FIXED_STRING_HPP
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+// ============================================================================
+// FIXED STRING (buffer teks kapasitas tetap, tanpa heap)
+// Pengganti String di loop task: serializeJson() dan printf langsung ke buffer
+// statis, jadi kirim data / simpan SD / SSE tidak malloc-free tiap siklus.
+// Kalau isi melebihi kapasitas, teks dipotong dan overflowed() = true
+// (caller memutuskan: lewati kirim, log, dsb), tidak pernah tulis di luar buffer.
+// ============================================================================
+
+template <size_t N>
+class FixedString : public Print
+{
+public:
+  FixedString() { clear(); }
+
+  void clear()
+  {
+    _len = 0;
+    _buf[0] = '\0';
+    _overflow = false;
+  }
+
+  size_t write(uint8_t c) override
+  {
+    if (_len + 1 >= N)
+    {
+      _overflow = true;
+      return 0;
+    }
+    _buf[_len++] = (char)c;
+    _buf[_len] = '\0';
+    return 1;
+  }
+
+  size_t write(const uint8_t *data, size_t size) override
+  {
+    size_t room = N - 1 - _len;
+    if (size > room)
+    {
+      _overflow = true;
+      size = room;
+    }
+    memcpy(_buf + _len, data, size);
+    _len += size;
+    _buf[_len] = '\0';
+    return size;
+  }
+
+  size_t appendf(const char *fmt, ...) __attribute__((format(printf, 2, 3)))
+  {
+    va_list args;
+    va_start(args, fmt);
+    size_t room = N - _len;
+    int n = vsnprintf(_buf + _len, room, fmt, args);
+    va_end(args);
+    if (n < 0)
+      return 0;
+    if ((size_t)n >= room)
+    {
+      _overflow = true;
+      n = room - 1;
+    }
+    _len += n;
+    return n;
+  }
+
+  const char *c_str() const { return _buf; }
+  size_t length() const { return _len; }
+  static constexpr size_t capacity() { return N - 1; }
+  bool overflowed() const { return _overflow; }
+
+private:
+  char _buf[N];
+  size_t _len;
+  bool _overflow;
+};
+
+#endif
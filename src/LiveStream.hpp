@@ -0,0 +1,266 @@
+#ifndef LIVE_STREAM_HPP
+#define LIVE_STREAM_HPP
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include "config.hpp"
+#include "ConfigImage.hpp"
+#include "FixedString.hpp"
+#include "SignalMath.hpp"
+
+extern DynamicJsonDocument jsonSend;
+extern SemaphoreHandle_t jsonMutex;
+extern String jobNum;
+extern size_t formatTimeDateNow(char *buf, size_t len);
+extern uint32_t bootFirstSampleMs;
+
+// ============================================================================
+// LIVE STREAM (SSE /live)
+// Menggantikan polling /homeLoad, /getValue dan /getCurrentValue dari dashboard.
+// Tiap interval satu frame delta dibangun & di-serialize SEKALI, lalu dikirim
+// ke semua browser yang terhubung (N client = 1 serialisasi, 1 akses RTC).
+//   event "meta"  : info statis (network, nama & mode channel), saat connect
+//   event "full"  : state lengkap terakhir, saat connect
+//   event "delta" : hanya field yang berubah sejak frame sebelumnya
+// Index "ai"/"di" 0-based: ai[0] = AI1 = [raw, scaled].
+// Delta lebih besar dari LIVE_DELTA_CAPACITY (banyak tag Modbus berubah
+// sekaligus) dipecah jadi beberapa event "delta" berurutan, masing-masing
+// dengan "t". _full hanya diperbarui untuk nilai yang benar-benar terkirim,
+// jadi nilai yang tidak muat tetap dianggap berubah di frame berikutnya.
+// ============================================================================
+
+#define LIVE_DELTA_CAPACITY 1536
+#define LIVE_FULL_CAPACITY 5120 // "v" = salinan jsonSend (4096) + ai/di/t/conn
+
+class LiveStream
+{
+public:
+  LiveStream() : _events("/live"), _full(LIVE_FULL_CAPACITY) {}
+
+  void begin(AsyncWebServer &server)
+  {
+    _lock = xSemaphoreCreateMutex();
+    resetState();
+
+    _events.onConnect([this](AsyncEventSourceClient *client)
+                      {
+      String meta = buildMeta();
+      client->send(meta.c_str(), "meta", millis());
+
+      String full;
+      if (xSemaphoreTake(_lock, pdMS_TO_TICKS(50)))
+      {
+        if (_hasFrame)
+          serializeJson(_full, full);
+        xSemaphoreGive(_lock);
+      }
+      if (full.length())
+        client->send(full.c_str(), "full", _frameId); });
+
+    server.addHandler(&_events);
+  }
+
+  // Dipanggil berkala dari Task_NetworkManagement
+  void loop(uint32_t intervalMs)
+  {
+    if (millis() - _lastFrame < intervalMs)
+      return;
+    _lastFrame = millis();
+
+    if (_events.count() == 0)
+      return; // tidak ada browser: tidak ada kerja sama sekali
+
+    buildDelta();
+  }
+
+  size_t clients() { return _events.count(); }
+
+private:
+  void resetState()
+  {
+    _full.clear();
+    _full["t"] = "";
+    JsonArray ai = _full.createNestedArray("ai");
+    for (int i = 1; i <= jumlahInputAnalog; i++)
+    {
+      JsonArray pair = ai.createNestedArray();
+      pair.add(0);
+      pair.add(0);
+    }
+    JsonArray di = _full.createNestedArray("di");
+    for (int i = 1; i <= jumlahInputDigital; i++)
+      di.add(0);
+    _full.createNestedObject("v");
+    _full["conn"] = "";
+    _hasFrame = false;
+  }
+
+  // Frame di buffer tetap (member), bukan String per frame
+  void sendDelta(const JsonDocument &delta)
+  {
+    _frame.clear();
+    serializeJson(delta, _frame);
+    if (_frame.overflowed())
+    {
+      ESP_LOGW("Live", "Delta frame > %u bytes, dropped", (unsigned)_frame.capacity());
+      return;
+    }
+    _frameId++;
+    _events.send(_frame.c_str(), "delta", _frameId);
+  }
+
+  // Sisa pool delta cukup untuk satu member baru (slot + salinan key/string)?
+  static bool fits(const JsonDocument &delta, JsonString key, JsonVariantConst value)
+  {
+    size_t need = 2 * JSON_OBJECT_SIZE(1) + key.size() + 1; // + objek "v" baru
+    if (value.is<const char *>())
+      need += strlen(value.as<const char *>()) + 1;
+    return delta.capacity() - delta.memoryUsage() >= need;
+  }
+
+  bool buildDelta()
+  {
+    StaticJsonDocument<LIVE_DELTA_CAPACITY> delta;
+
+    if (!xSemaphoreTake(_lock, pdMS_TO_TICKS(50)))
+      return false;
+
+    // Satu akses RTC per frame, bukan per client. Disimpan sebagai pointer ke
+    // _now (const char*), jadi _full tidak menumpuk salinan string tiap frame
+    formatTimeDateNow(_now, sizeof(_now));
+    bool force = !_hasFrame;
+    _full["t"] = (const char *)_now;
+    delta["t"] = (const char *)_now;
+
+    JsonArray ai = _full["ai"];
+    for (int i = 1; i <= jumlahInputAnalog; i++)
+    {
+      float raw = round2(analogInput[i].adcValue);
+      float scaled = round2(analogInput[i].mapValue);
+      JsonArray pair = ai[i - 1];
+      if (force || pair[0].as<float>() != raw || pair[1].as<float>() != scaled)
+      {
+        pair[0] = raw;
+        pair[1] = scaled;
+        if (delta["ai"].isNull())
+          delta.createNestedObject("ai");
+        char idx[4];
+        snprintf(idx, sizeof(idx), "%d", i - 1);
+        JsonArray d = delta["ai"].createNestedArray(idx);
+        d.add(raw);
+        d.add(scaled);
+      }
+    }
+
+    JsonArray di = _full["di"];
+    for (int i = 1; i <= jumlahInputDigital; i++)
+    {
+      float value = round2(digitalInput[i].value);
+      if (force || di[i - 1].as<float>() != value)
+      {
+        di[i - 1] = value;
+        if (delta["di"].isNull())
+          delta.createNestedObject("di");
+        char idx[4];
+        snprintf(idx, sizeof(idx), "%d", i - 1);
+        delta["di"][idx] = value;
+      }
+    }
+
+    if (force || _full["conn"] != networkSettings.connStatus)
+    {
+      _full["conn"] = networkSettings.connStatus;
+      delta["conn"] = networkSettings.connStatus;
+    }
+
+    // Nilai per nama sensor (AI/DI/Modbus) dari jsonSend. Bagian ai/di/conn di
+    // atas ukurannya tetap dan selalu muat; "v" yang bisa melebihi satu event.
+    uint16_t parts = 0;
+    if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(20)))
+    {
+      JsonObject values = _full["v"];
+      for (JsonPair kv : jsonSend.as<JsonObject>())
+      {
+        if (kv.key() == "-")
+          continue;
+        if (!force && values[kv.key()] == kv.value())
+          continue;
+        if (!fits(delta, kv.key(), kv.value()))
+        {
+          sendDelta(delta); // event penuh: kirim, lanjut di event berikutnya
+          parts++;
+          delta.clear();
+          delta["t"] = (const char *)_now;
+          if (!fits(delta, kv.key(), kv.value()))
+            continue; // satu nilai > satu event: tidak pernah terkirim, _full tetap
+        }
+        if (delta["v"].isNull())
+          delta.createNestedObject("v");
+        delta["v"][kv.key()] = kv.value();
+        values[kv.key()] = kv.value();
+      }
+      xSemaphoreGive(jsonMutex);
+    }
+
+    // Nilai String lama tidak dibebaskan oleh ArduinoJson saat ditimpa: rapikan pool
+    if (_full.memoryUsage() > _full.capacity() * 3 / 4)
+      _full.garbageCollect();
+
+    _hasFrame = true;
+    if (!parts || delta.size() > 1) // sisa setelah dipecah: lebih dari "t" saja
+      sendDelta(delta);
+    xSemaphoreGive(_lock);
+    return true;
+  }
+
+  String buildMeta()
+  {
+    DynamicJsonDocument meta(1536);
+    meta["networkMode"] = networkSettings.networkMode;
+    meta["ssid"] = networkSettings.ssid;
+    meta["ipAddress"] = (networkSettings.networkMode == "WiFi") ? WiFi.localIP().toString() : networkSettings.ipAddress;
+    meta["macAddress"] = (networkSettings.networkMode == "WiFi") ? WiFi.macAddress() : networkSettings.macAddress;
+    meta["protocolMode"] = networkSettings.protocolMode;
+    meta["endpoint"] = networkSettings.endpoint;
+    meta["jobNumber"] = jobNum;
+    meta["sendInterval"] = networkSettings.sendInterval;
+    meta["liveInterval"] = networkSettings.liveInterval;
+    meta["bootToFirstSampleMs"] = bootFirstSampleMs;
+    meta["configSource"] = configImage.source();
+
+    JsonArray enAI = meta.createNestedArray("enAI");
+    JsonArray aiName = meta.createNestedArray("aiName");
+    for (int i = 1; i <= jumlahInputAnalog; i++)
+    {
+      enAI.add(analogInput[i].name != "" ? 1 : 0);
+      aiName.add(analogInput[i].name);
+    }
+
+    JsonArray diName = meta.createNestedArray("diName");
+    JsonArray diTaskMode = meta.createNestedArray("diTaskMode");
+    for (int i = 1; i <= jumlahInputDigital; i++)
+    {
+      diName.add(digitalInput[i].name);
+      diTaskMode.add(digitalInput[i].taskMode);
+    }
+
+    String out;
+    serializeJson(meta, out);
+    return out;
+  }
+
+  AsyncEventSource _events;
+  DynamicJsonDocument _full; // state terakhir yang sudah dikirim
+  FixedString<2048> _frame;  // hasil serialize delta
+  char _now[24] = "";
+  SemaphoreHandle_t _lock = NULL;
+  bool _hasFrame = false;
+  uint32_t _frameId = 0;
+  unsigned long _lastFrame = 0;
+};
+
+LiveStream liveStream;
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef METRIC_TYPES_HPP
+#define METRIC_TYPES_HPP
+
+#include <atomic>
+#include <stdint.h>
+
+// ============================================================================
+// METRIC TYPES (counter & histogram lock-free, dipakai Metrics.hpp)
+// Hot path hanya fetch_add atomik 32-bit. Histogram: bucket tetap dalam
+// mikrodetik, disimpan non-kumulatif dan dijumlahkan saat export. Sum 64-bit
+// dari dua atomik 32-bit (carry manual) karena atomik 64-bit di ESP32 tidak
+// lock-free. Tanpa Arduino.h: bisa diuji di host (test/test_metrics).
+// Setiap objek mendaftarkan diri ke linked list global saat konstruksi.
+// ============================================================================
+
+#define METRIC_BUCKETS 10
+static const uint32_t METRIC_BUCKET_US[METRIC_BUCKETS - 1] = {
+    100, 300, 1000, 3000, 10000, 30000, 100000, 300000, 1000000}; // + bucket +Inf
+
+class MetricCounter
+{
+public:
+  MetricCounter(const char *name, const char *help) : _name(name), _help(help)
+  {
+    _next = head();
+    head() = this;
+  }
+
+  void inc(uint32_t n = 1) { _value.fetch_add(n, std::memory_order_relaxed); }
+  uint32_t value() const { return _value.load(std::memory_order_relaxed); }
+
+  static MetricCounter *&head()
+  {
+    static MetricCounter *list = nullptr;
+    return list;
+  }
+
+  const char *_name;
+  const char *_help;
+  MetricCounter *_next;
+
+private:
+  std::atomic<uint32_t> _value{0};
+};
+
+class MetricHistogram
+{
+public:
+  // labels: "key=\"value\"" (opsional). Histogram dengan nama sama harus
+  // didefinisikan berurutan supaya HELP/TYPE hanya ditulis sekali.
+  // traceId: span MetricTimer ikut dicatat ke trace buffer.
+  MetricHistogram(const char *name, const char *help, const char *labels = nullptr, uint8_t traceId = 0 /* TR_NONE */)
+      : _name(name), _help(help), _labels(labels), _traceId(traceId)
+  {
+    _next = head();
+    head() = this;
+  }
+
+  void observeUs(uint32_t us)
+  {
+    int b = 0;
+    while (b < METRIC_BUCKETS - 1 && us > METRIC_BUCKET_US[b])
+      b++;
+    _buckets[b].fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t old = _sumLo.fetch_add(us, std::memory_order_relaxed);
+    if (old + us < old) // carry
+      _sumHi.fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint32_t count() const { return _count.load(std::memory_order_relaxed); }
+  uint32_t bucket(int b) const { return _buckets[b].load(std::memory_order_relaxed); }
+
+  // Perkiraan kuantil (0..1) dari bucket, interpolasi linear di dalam bucket
+  // seperti histogram_quantile() Prometheus. Bucket +Inf -> batas bawahnya.
+  uint32_t quantileUs(float q) const
+  {
+    uint32_t counts[METRIC_BUCKETS];
+    uint32_t total = 0;
+    for (int b = 0; b < METRIC_BUCKETS; b++)
+      total += counts[b] = bucket(b);
+    if (total == 0)
+      return 0;
+
+    float rank = q * total;
+    uint32_t cumulative = 0;
+    for (int b = 0; b < METRIC_BUCKETS - 1; b++)
+    {
+      if (cumulative + counts[b] >= rank && counts[b] > 0)
+      {
+        uint32_t lower = b ? METRIC_BUCKET_US[b - 1] : 0;
+        return lower + (uint32_t)((METRIC_BUCKET_US[b] - lower) * (rank - cumulative) / counts[b]);
+      }
+      cumulative += counts[b];
+    }
+    return METRIC_BUCKET_US[METRIC_BUCKETS - 2];
+  }
+
+  uint64_t sumUs() const
+  {
+    uint32_t hi, lo;
+    do
+    {
+      hi = _sumHi.load();
+      lo = _sumLo.load();
+    } while (hi != _sumHi.load());
+    return ((uint64_t)hi << 32) | lo;
+  }
+
+  static MetricHistogram *&head()
+  {
+    static MetricHistogram *list = nullptr;
+    return list;
+  }
+
+  const char *_name;
+  const char *_help;
+  const char *_labels;
+  const uint8_t _traceId;
+  MetricHistogram *_next;
+
+private:
+  std::atomic<uint32_t> _buckets[METRIC_BUCKETS] = {};
+  std::atomic<uint32_t> _count{0};
+  std::atomic<uint32_t> _sumLo{0};
+  std::atomic<uint32_t> _sumHi{0};
+};
+
+#endif
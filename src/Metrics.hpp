@@ -0,0 +1,337 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include "esp_timer.h"
+#include "esp_freertos_hooks.h"
+#include "esp_heap_caps.h"
+#include "MetricTypes.hpp"
+#include "Trace.hpp"
+
+extern QueueHandle_t queueSensorData;
+extern QueueHandle_t queueModbusData;
+extern QueueHandle_t queueAlarmEvents;
+extern TaskHandle_t Task_Core0_Network;
+extern TaskHandle_t Task_Core1_DataAcquisition;
+extern TaskHandle_t Task_Core1_ModbusClient;
+extern TaskHandle_t Task_Core1_DataLogger;
+extern TaskHandle_t Task_Core1_ModbusSlave;
+extern TaskHandle_t Task_Core0_ModbusTcp;
+extern TaskHandle_t Task_Core0_Vibration;
+
+// ============================================================================
+// METRICS (counter & histogram lock-free, export Prometheus text / JSON)
+// Hot path hanya melakukan fetch_add atomik 32-bit (S32C1I, tanpa mutex,
+// aman dari task mana pun di kedua core). Semua format & gauge sistem
+// (queue, stack, heap, CPU) dihitung saat /metrics di-scrape.
+// Counter & histogram sendiri ada di MetricTypes.hpp (tanpa HAL, diuji di
+// host); di sini definisi metric, timer, gauge sistem dan export.
+// ============================================================================
+
+// Ukur durasi satu scope ke histogram: { MetricTimer t(mAdcRead); ... }
+class MetricTimer
+{
+public:
+  explicit MetricTimer(MetricHistogram &h) : _h(h), _t0(esp_timer_get_time()) { traceBegin(h._traceId); }
+  ~MetricTimer()
+  {
+    _h.observeUs((uint32_t)(esp_timer_get_time() - _t0));
+    traceEnd(_h._traceId);
+  }
+
+private:
+  MetricHistogram &_h;
+  int64_t _t0;
+};
+
+// ----------------------------------------------------------------------------
+// Definisi metric (urutan di sini = urutan export, dibalik oleh linked list)
+// ----------------------------------------------------------------------------
+MetricCounter mAdcReads("iot_adc_reads_total", "ADS1115 channel conversions");
+MetricCounter mSensorQueueDrops("iot_sensor_queue_drops_total", "Sensor packets dropped because queueSensorData was full");
+MetricCounter mModbusQueueDrops("iot_modbus_queue_drops_total", "Modbus batches dropped because queueModbusData was full");
+MetricCounter mModbusRequests("iot_modbus_requests_total", "Modbus RTU master transactions");
+MetricCounter mModbusTimeouts("iot_modbus_timeouts_total", "Modbus RTU transactions without reply");
+MetricCounter mModbusErrors("iot_modbus_errors_total", "Modbus RTU replies rejected (CRC, exception, mismatch)");
+MetricCounter mModbusTcpRequests("iot_modbus_tcp_requests_total", "Modbus TCP master transactions");
+MetricCounter mModbusTcpFailures("iot_modbus_tcp_failures_total", "Modbus TCP transactions without a valid reply (timeout, connect, exception)");
+MetricCounter mModbusTcpConnects("iot_modbus_tcp_connects_total", "Modbus TCP master connection attempts");
+MetricCounter mSlaveRequests("iot_modbus_slave_requests_total", "Modbus slave requests served (TCP/RTU)");
+MetricCounter mSlaveExceptions("iot_modbus_slave_exceptions_total", "Modbus slave requests answered with an exception");
+MetricCounter mGatewayRequests("iot_modbus_gateway_requests_total", "Modbus TCP requests forwarded to the RS-485 bus (incl. coalesced & cached)");
+MetricCounter mGatewayCoalesced("iot_modbus_gateway_coalesced_total", "Gateway reads that joined an identical queued/in-flight bus transaction");
+MetricCounter mGatewayCacheHits("iot_modbus_gateway_cache_hits_total", "Gateway reads answered from the response cache");
+MetricCounter mGatewayBusTransactions("iot_modbus_gateway_bus_transactions_total", "Gateway transactions actually sent on the RS-485 bus");
+MetricCounter mCommandsSubmitted("iot_commands_submitted_total", "Write commands accepted into the command queue");
+MetricCounter mCommandsRejected("iot_commands_rejected_total", "Write commands rejected (invalid or queue full)");
+MetricCounter mAlarmTransitions("iot_alarm_transitions_total", "Alarm state changes (raise + clear)");
+MetricCounter mAlarmStaleSkips("iot_alarm_stale_skips_total", "Alarm evaluations skipped because the source sample was stale");
+MetricCounter mAlarmEventDrops("iot_alarm_event_drops_total", "Alarm events dropped because queueAlarmEvents was full");
+MetricCounter mTotalizerGaps("iot_totalizer_gaps_total", "Totalizer sample gaps too long to integrate");
+MetricCounter mTotalizerResets("iot_totalizer_resets_total", "Totalizer period resets (scheduled + manual)");
+MetricCounter mTotalizerSaves("iot_totalizer_saves_total", "Totalizer accumulator writes to NVS");
+MetricCounter mVibrationCaptures("iot_vibration_captures_total", "High-rate vibration blocks captured and analyzed");
+MetricCounter mVibrationAborts("iot_vibration_aborts_total", "Vibration captures dropped (ADC DMA overflow or timeout)");
+MetricCounter mCommandsFailed("iot_commands_failed_total", "Write commands that failed on the bus or read-back verification");
+MetricCounter mHttpSends("iot_http_sends_total", "HTTP POST uplink attempts");
+MetricCounter mHttpFailures("iot_http_failures_total", "HTTP POST uplink failures");
+MetricCounter mSdWrites("iot_sd_writes_total", "SD card log appends");
+MetricCounter mSdFailures("iot_sd_failures_total", "SD card log appends skipped or failed");
+MetricCounter mMutexTimeouts("iot_mutex_timeouts_total", "Measured mutex takes that timed out");
+
+MetricHistogram mAdcRead("iot_adc_read_seconds", "Time to read all ADS1115 channels");
+MetricHistogram mModbusTransaction("iot_modbus_transaction_seconds", "Modbus RTU request to parsed reply", nullptr, TR_MODBUS_TRANSACTION);
+MetricHistogram mModbusTcpTransaction("iot_modbus_tcp_transaction_seconds", "Modbus TCP request sent to parsed reply");
+MetricHistogram mSlaveRequestTcp("iot_modbus_slave_request_seconds", "Modbus slave request service time (frame in to reply out)", "transport=\"tcp\"");
+MetricHistogram mSlaveRequestRtu("iot_modbus_slave_request_seconds", "Modbus slave request service time (frame in to reply out)", "transport=\"rtu\"");
+MetricHistogram mSlaveRequestGateway("iot_modbus_slave_request_seconds", "Modbus slave request service time (frame in to reply out)", "transport=\"gateway\"");
+MetricHistogram mCommandLatencyMqtt("iot_command_latency_seconds", "Command submit to confirmed actuation", "source=\"mqtt\"");
+MetricHistogram mCommandLatencyHttp("iot_command_latency_seconds", "Command submit to confirmed actuation", "source=\"http\"");
+MetricHistogram mCommandLatencyModbus("iot_command_latency_seconds", "Command submit to confirmed actuation", "source=\"modbus\"");
+MetricHistogram mCommandLatencyWs("iot_command_latency_seconds", "Command submit to confirmed actuation", "source=\"ws\"");
+MetricHistogram mCommandLatencyAlarm("iot_command_latency_seconds", "Command submit to confirmed actuation", "source=\"alarm\"");
+MetricHistogram mAlarmEval("iot_alarm_eval_seconds", "Alarm engine pass over all configured alarms");
+MetricHistogram mVirtualEval("iot_virtual_eval_seconds", "Virtual channel pass over all configured expressions");
+MetricHistogram mVibrationFft("iot_vibration_fft_seconds", "Windowed FFT + feature extraction per vibration channel");
+MetricHistogram mHttpSend("iot_http_send_seconds", "HTTP POST uplink latency");
+MetricHistogram mSdWrite("iot_sd_write_seconds", "SD card log append latency (incl. bus wait)", nullptr, TR_SD_WRITE);
+MetricHistogram mMutexWaitI2c("iot_mutex_wait_seconds", "Time blocked waiting for a mutex", "mutex=\"i2c\"");
+MetricHistogram mMutexWaitJson("iot_mutex_wait_seconds", "Time blocked waiting for a mutex", "mutex=\"json\"");
+
+// xSemaphoreTake yang mencatat waktu tunggu (+ span trace tunggu & pegang;
+// pasangkan dengan metricGive() memakai holdTrace yang sama)
+inline bool metricTake(SemaphoreHandle_t mutex, TickType_t wait, MetricHistogram &h,
+                       uint8_t waitTrace = TR_NONE, uint8_t holdTrace = TR_NONE)
+{
+  traceBegin(waitTrace);
+  int64_t t0 = esp_timer_get_time();
+  bool ok = xSemaphoreTake(mutex, wait) == pdTRUE;
+  h.observeUs((uint32_t)(esp_timer_get_time() - t0));
+  traceEnd(waitTrace);
+  if (ok)
+    traceBegin(holdTrace);
+  else
+    mMutexTimeouts.inc();
+  return ok;
+}
+
+inline void metricGive(SemaphoreHandle_t mutex, uint8_t holdTrace = TR_NONE)
+{
+  traceEnd(holdTrace);
+  xSemaphoreGive(mutex);
+}
+
+// ----------------------------------------------------------------------------
+// Beban CPU per core dari idle hook: selang antar panggilan hook yang pendek
+// (<= satu tick + margin) dihitung sebagai waktu idle. Perkiraan: task yang
+// jalan < 1 tick di antara dua hook ikut terhitung idle.
+// ----------------------------------------------------------------------------
+class CpuLoad
+{
+public:
+  void begin()
+  {
+    esp_register_freertos_idle_hook_for_cpu(idleHook0, 0);
+    esp_register_freertos_idle_hook_for_cpu(idleHook1, 1);
+    _windowStart = esp_timer_get_time();
+  }
+
+  // Dipanggil berkala (Task_NetworkManagement), jendela 1 detik
+  void update()
+  {
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = now - _windowStart;
+    if (elapsed < 1000000)
+      return;
+    for (int c = 0; c < 2; c++)
+    {
+      uint32_t idle = _idleUs[c].exchange(0);
+      float load = 100.0f - 100.0f * idle / elapsed;
+      _loadPct[c] = load < 0 ? 0 : load;
+    }
+    _windowStart = now;
+  }
+
+  float percent(int core) const { return _loadPct[core]; }
+
+private:
+  static bool idleHook0() { return account(0); }
+  static bool idleHook1() { return account(1); }
+
+  static bool account(int core)
+  {
+    int64_t now = esp_timer_get_time();
+    int64_t gap = now - _lastIdle[core];
+    if (gap > 0 && gap <= portTICK_PERIOD_MS * 1000 + 200)
+      _idleUs[core].fetch_add((uint32_t)gap, std::memory_order_relaxed);
+    _lastIdle[core] = now;
+    return true; // boleh waiti sampai interrupt berikutnya
+  }
+
+  static int64_t _lastIdle[2];
+  static std::atomic<uint32_t> _idleUs[2];
+  int64_t _windowStart = 0;
+  float _loadPct[2] = {0, 0};
+};
+
+int64_t CpuLoad::_lastIdle[2] = {0, 0};
+std::atomic<uint32_t> CpuLoad::_idleUs[2];
+
+CpuLoad cpuLoad;
+
+// ----------------------------------------------------------------------------
+// Export
+// ----------------------------------------------------------------------------
+struct MetricTaskRef
+{
+  const char *name;
+  TaskHandle_t *handle;
+};
+
+inline void metricTasks(const MetricTaskRef *&tasks, size_t &count)
+{
+  static const MetricTaskRef refs[] = {
+      {"network", &Task_Core0_Network},
+      {"acquisition", &Task_Core1_DataAcquisition},
+      {"modbus", &Task_Core1_ModbusClient},
+      {"logger", &Task_Core1_DataLogger},
+      {"rtu_slave", &Task_Core1_ModbusSlave},
+      {"tcp_slave", &Task_Core0_ModbusTcp},
+      {"vibration", &Task_Core0_Vibration},
+  };
+  tasks = refs;
+  count = sizeof(refs) / sizeof(refs[0]);
+}
+
+inline float heapFragmentationPct()
+{
+  size_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  return freeBytes ? 100.0f * (1.0f - (float)largest / freeBytes) : 0;
+}
+
+// Prometheus text exposition format 0.0.4
+inline void writeMetricsPrometheus(Print &out)
+{
+  for (MetricCounter *c = MetricCounter::head(); c; c = c->_next)
+  {
+    out.printf("# HELP %s %s\n# TYPE %s counter\n%s %u\n", c->_name, c->_help, c->_name, c->_name, c->value());
+  }
+
+  const char *lastName = "";
+  for (MetricHistogram *h = MetricHistogram::head(); h; h = h->_next)
+  {
+    if (strcmp(lastName, h->_name) != 0)
+      out.printf("# HELP %s %s\n# TYPE %s histogram\n", h->_name, h->_help, h->_name);
+    lastName = h->_name;
+
+    const char *sep = h->_labels ? "," : "";
+    const char *labels = h->_labels ? h->_labels : "";
+    uint32_t cumulative = 0;
+    for (int b = 0; b < METRIC_BUCKETS - 1; b++)
+    {
+      cumulative += h->bucket(b);
+      out.printf("%s_bucket{%s%sle=\"%g\"} %u\n", h->_name, labels, sep, METRIC_BUCKET_US[b] / 1e6, cumulative);
+    }
+    cumulative += h->bucket(METRIC_BUCKETS - 1);
+    out.printf("%s_bucket{%s%sle=\"+Inf\"} %u\n", h->_name, labels, sep, cumulative);
+    out.printf("%s_sum{%s} %.6f\n", h->_name, labels, h->sumUs() / 1e6);
+    out.printf("%s_count{%s} %u\n", h->_name, labels, h->count());
+  }
+
+  out.print("# HELP iot_queue_depth Messages waiting in a FreeRTOS queue\n# TYPE iot_queue_depth gauge\n");
+  out.printf("iot_queue_depth{queue=\"sensor\"} %u\n", (unsigned)uxQueueMessagesWaiting(queueSensorData));
+  out.printf("iot_queue_depth{queue=\"modbus\"} %u\n", (unsigned)uxQueueMessagesWaiting(queueModbusData));
+  out.printf("iot_queue_depth{queue=\"alarm\"} %u\n", (unsigned)uxQueueMessagesWaiting(queueAlarmEvents));
+
+  const MetricTaskRef *tasks;
+  size_t taskCount;
+  metricTasks(tasks, taskCount);
+  out.print("# HELP iot_task_stack_free_bytes Minimum free stack ever (high-water mark)\n# TYPE iot_task_stack_free_bytes gauge\n");
+  for (size_t i = 0; i < taskCount; i++)
+  {
+    if (*tasks[i].handle)
+      out.printf("iot_task_stack_free_bytes{task=\"%s\"} %u\n", tasks[i].name, (unsigned)uxTaskGetStackHighWaterMark(*tasks[i].handle));
+  }
+
+  out.print("# HELP iot_cpu_load_percent CPU load per core (idle-hook estimate, 1 s window)\n# TYPE iot_cpu_load_percent gauge\n");
+  for (int c = 0; c < 2; c++)
+    out.printf("iot_cpu_load_percent{core=\"%d\"} %.1f\n", c, cpuLoad.percent(c));
+
+  out.print("# HELP iot_heap_free_bytes Free 8-bit heap\n# TYPE iot_heap_free_bytes gauge\n");
+  out.printf("iot_heap_free_bytes %u\n", (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT));
+  out.print("# HELP iot_heap_min_free_bytes Lowest free heap since boot\n# TYPE iot_heap_min_free_bytes gauge\n");
+  out.printf("iot_heap_min_free_bytes %u\n", (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+  out.print("# HELP iot_heap_largest_block_bytes Largest allocatable block\n# TYPE iot_heap_largest_block_bytes gauge\n");
+  out.printf("iot_heap_largest_block_bytes %u\n", (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+  out.print("# HELP iot_heap_fragmentation_percent 100 * (1 - largest block / free)\n# TYPE iot_heap_fragmentation_percent gauge\n");
+  out.printf("iot_heap_fragmentation_percent %.1f\n", heapFragmentationPct());
+  // Steady state tanpa alokasi di loop task: jumlah blok harus datar
+  // (naik terus = ada yang bocor / menumpuk di heap)
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+  out.print("# HELP iot_heap_allocated_blocks Allocated heap blocks\n# TYPE iot_heap_allocated_blocks gauge\n");
+  out.printf("iot_heap_allocated_blocks %u\n", (unsigned)info.allocated_blocks);
+  out.print("# HELP iot_uptime_seconds Seconds since boot\n# TYPE iot_uptime_seconds counter\n");
+  out.printf("iot_uptime_seconds %llu\n", (unsigned long long)(esp_timer_get_time() / 1000000));
+}
+
+// Isi sama dengan format Prometheus, untuk dashboard / skrip
+inline void writeMetricsJson(JsonObject obj)
+{
+  JsonObject counters = obj.createNestedObject("counters");
+  for (MetricCounter *c = MetricCounter::head(); c; c = c->_next)
+    counters[c->_name] = c->value();
+
+  JsonObject histograms = obj.createNestedObject("histograms");
+  for (MetricHistogram *h = MetricHistogram::head(); h; h = h->_next)
+  {
+    String key = h->_name;
+    if (h->_labels)
+      key += String("{") + h->_labels + "}";
+    JsonObject o = histograms.createNestedObject(key);
+    o["count"] = h->count();
+    o["sumUs"] = (double)h->sumUs();
+    o["p50Us"] = h->quantileUs(0.50f);
+    o["p99Us"] = h->quantileUs(0.99f);
+    JsonArray buckets = o.createNestedArray("buckets"); // non-kumulatif, batas = bucketUs
+    for (int b = 0; b < METRIC_BUCKETS; b++)
+      buckets.add(h->bucket(b));
+  }
+  JsonArray bounds = obj.createNestedArray("bucketUs");
+  for (int b = 0; b < METRIC_BUCKETS - 1; b++)
+    bounds.add(METRIC_BUCKET_US[b]);
+
+  JsonObject queues = obj.createNestedObject("queueDepth");
+  queues["sensor"] = uxQueueMessagesWaiting(queueSensorData);
+  queues["modbus"] = uxQueueMessagesWaiting(queueModbusData);
+  queues["alarm"] = uxQueueMessagesWaiting(queueAlarmEvents);
+
+  const MetricTaskRef *tasks;
+  size_t taskCount;
+  metricTasks(tasks, taskCount);
+  JsonObject stacks = obj.createNestedObject("stackFreeBytes");
+  for (size_t i = 0; i < taskCount; i++)
+  {
+    if (*tasks[i].handle)
+      stacks[tasks[i].name] = uxTaskGetStackHighWaterMark(*tasks[i].handle);
+  }
+
+  JsonArray cpu = obj.createNestedArray("cpuLoadPercent");
+  cpu.add(cpuLoad.percent(0));
+  cpu.add(cpuLoad.percent(1));
+
+  JsonObject heap = obj.createNestedObject("heap");
+  heap["free"] = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  heap["minFree"] = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  heap["largestBlock"] = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  heap["fragmentationPct"] = heapFragmentationPct();
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+  heap["allocatedBlocks"] = info.allocated_blocks;
+  obj["uptimeS"] = (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+#endif
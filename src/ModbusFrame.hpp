@@ -0,0 +1,458 @@
+#ifndef MODBUS_FRAME_HPP
+#define MODBUS_FRAME_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ============================================================================
+// MODBUS FRAMING (RTU master read/write & slave, TCP master)
+// Bangun request & validasi response tanpa akses UART/socket, supaya framing
+// bisa diuji/diukur di host. I/O tetap di readModbusBlock() (RS-485) dan
+// ModbusTcpClient.
+// CRC16 (poly 0xA001) pakai tabel 256 entri (512 byte, dibangun sekali):
+// satu lookup per byte menggantikan 8 iterasi shift per byte.
+// ============================================================================
+
+#define MODBUS_READ_REQUEST_LEN 8
+#define MODBUS_RTU_FRAME_MAX 256 // unit + PDU + CRC
+
+struct ModbusCrcTable
+{
+  uint16_t v[256];
+  ModbusCrcTable()
+  {
+    for (int n = 0; n < 256; n++)
+    {
+      uint16_t crc = n;
+      for (int i = 0; i < 8; i++)
+        crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+      v[n] = crc;
+    }
+  }
+};
+
+inline const uint16_t *modbusCrcTable()
+{
+  static const ModbusCrcTable table;
+  return table.v;
+}
+
+// CRC dalam urutan register (byte rendah dikirim duluan)
+inline uint16_t modbusCrc16(const uint8_t *data, size_t len)
+{
+  const uint16_t *table = modbusCrcTable();
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++)
+    crc = (crc >> 8) ^ table[(crc ^ data[i]) & 0xFF];
+  return crc;
+}
+
+// Request FC3/FC4 (atau FC lain dengan format addr+count yang sama)
+inline size_t modbusBuildReadRequest(uint8_t *out, uint8_t slaveId, uint8_t funCode, uint16_t regAddress, uint16_t count = 1)
+{
+  out[0] = slaveId;
+  out[1] = funCode;
+  out[2] = regAddress >> 8;
+  out[3] = regAddress & 0xFF;
+  out[4] = count >> 8;
+  out[5] = count & 0xFF;
+  uint16_t crc = modbusCrc16(out, 6);
+  out[6] = crc & 0xFF;
+  out[7] = crc >> 8;
+  return MODBUS_READ_REQUEST_LEN;
+}
+
+enum ModbusFrameResult : uint8_t
+{
+  MB_FRAME_OK = 0,
+  MB_FRAME_SHORT,     // belum/tidak lengkap
+  MB_FRAME_MISMATCH,  // slave ID / function code lain
+  MB_FRAME_EXCEPTION, // slave membalas exception (FC | 0x80)
+  MB_FRAME_CRC,       // CRC salah (noise di bus)
+  MB_FRAME_TIMEOUT    // tidak ada balasan (diisi pemanggil, bukan parser)
+};
+
+// Panjang response FC3/FC4 untuk count register (RTU, termasuk CRC)
+inline size_t modbusReadResponseLen(uint16_t count)
+{
+  return 5 + 2 * (size_t)count;
+}
+
+// Validasi response FC3/FC4 dan ambil count register (block read)
+inline ModbusFrameResult modbusParseReadBlock(const uint8_t *buf, size_t len, uint8_t slaveId, uint8_t funCode,
+                                              uint16_t count, uint16_t *values)
+{
+  if (len < 5)
+    return MB_FRAME_SHORT;
+  if (buf[0] != slaveId)
+    return MB_FRAME_MISMATCH;
+  if (buf[1] == (funCode | 0x80))
+    return modbusCrc16(buf, 3) == (uint16_t)(buf[3] | (buf[4] << 8)) ? MB_FRAME_EXCEPTION : MB_FRAME_CRC;
+  if (buf[1] != funCode)
+    return MB_FRAME_MISMATCH;
+
+  size_t frameLen = 3 + (size_t)buf[2] + 2;
+  if (buf[2] < 2 || len < frameLen)
+    return MB_FRAME_SHORT;
+  uint16_t crc = buf[frameLen - 2] | (buf[frameLen - 1] << 8);
+  if (modbusCrc16(buf, frameLen - 2) != crc)
+    return MB_FRAME_CRC;
+  if (buf[2] != 2 * count)
+    return MB_FRAME_MISMATCH;
+
+  for (uint16_t i = 0; i < count; i++)
+    values[i] = (buf[3 + 2 * i] << 8) | buf[4 + 2 * i];
+  return MB_FRAME_OK;
+}
+
+// Validasi response FC3/FC4 dan ambil register pertama
+inline ModbusFrameResult modbusParseReadResponse(const uint8_t *buf, size_t len, uint8_t slaveId, uint8_t funCode, uint16_t *value)
+{
+  return modbusParseReadBlock(buf, len, slaveId, funCode, 1, value);
+}
+
+// ----------------------------------------------------------------------------
+// Modbus TCP (MBAP: transaction ID, protocol ID 0, length, unit ID)
+// ----------------------------------------------------------------------------
+
+#define MODBUS_TCP_READ_REQUEST_LEN 12
+#define MODBUS_MBAP_LEN 7
+
+inline size_t modbusTcpBuildReadRequest(uint8_t *out, uint16_t tid, uint8_t unitId, uint8_t funCode, uint16_t regAddress, uint16_t count)
+{
+  out[0] = tid >> 8;
+  out[1] = tid & 0xFF;
+  out[2] = 0;
+  out[3] = 0;
+  out[4] = 0;
+  out[5] = 6; // unit ID + PDU 5 byte
+  out[6] = unitId;
+  out[7] = funCode;
+  out[8] = regAddress >> 8;
+  out[9] = regAddress & 0xFF;
+  out[10] = count >> 8;
+  out[11] = count & 0xFF;
+  return MODBUS_TCP_READ_REQUEST_LEN;
+}
+
+// Panjang ADU lengkap di awal buf (0 = belum lengkap, SIZE_MAX = header rusak)
+inline size_t modbusTcpFrameLen(const uint8_t *buf, size_t len, size_t maxFrame)
+{
+  if (len < MODBUS_MBAP_LEN)
+    return 0;
+  size_t frameLen = 6 + ((buf[4] << 8) | buf[5]);
+  if (buf[2] || buf[3] || frameLen < MODBUS_MBAP_LEN + 1 || frameLen > maxFrame)
+    return (size_t)-1;
+  return len >= frameLen ? frameLen : 0;
+}
+
+// Validasi ADU response FC3/FC4 (sudah lengkap, TID dicocokkan pemanggil)
+inline ModbusFrameResult modbusTcpParseReadBlock(const uint8_t *adu, size_t len, uint8_t unitId, uint8_t funCode,
+                                                 uint16_t count, uint16_t *values)
+{
+  if (len < MODBUS_MBAP_LEN + 2)
+    return MB_FRAME_SHORT;
+  if (adu[6] != unitId)
+    return MB_FRAME_MISMATCH;
+  const uint8_t *pdu = adu + MODBUS_MBAP_LEN;
+  if (pdu[0] == (funCode | 0x80))
+    return MB_FRAME_EXCEPTION;
+  if (pdu[0] != funCode || len < MODBUS_MBAP_LEN + 2 + (size_t)pdu[1] || pdu[1] != 2 * count)
+    return MB_FRAME_MISMATCH;
+
+  for (uint16_t i = 0; i < count; i++)
+    values[i] = (pdu[2 + 2 * i] << 8) | pdu[3 + 2 * i];
+  return MB_FRAME_OK;
+}
+
+// ----------------------------------------------------------------------------
+// Sisi slave RTU
+// ----------------------------------------------------------------------------
+
+// Request untuk slaveId dengan CRC benar -> panjang PDU (mulai buf[1]).
+// 0 = abaikan tanpa balasan (alamat lain, broadcast, CRC salah / terpotong).
+inline size_t modbusRtuRequestPdu(const uint8_t *buf, size_t len, uint8_t slaveId)
+{
+  if (len < 4 || buf[0] != slaveId)
+    return 0;
+  uint16_t crc = buf[len - 2] | (buf[len - 1] << 8);
+  if (modbusCrc16(buf, len - 2) != crc)
+    return 0;
+  return len - 3;
+}
+
+// Tambah CRC di belakang frame [slaveId, PDU...], kembalikan panjang total
+inline size_t modbusRtuFinishFrame(uint8_t *frame, size_t len)
+{
+  uint16_t crc = modbusCrc16(frame, len);
+  frame[len] = crc & 0xFF;
+  frame[len + 1] = crc >> 8;
+  return len + 2;
+}
+
+// ----------------------------------------------------------------------------
+// Write master (FC5/FC6/FC15/FC16) & read-back coil (FC1/FC2)
+// ----------------------------------------------------------------------------
+
+#define MODBUS_WRITE_RESPONSE_LEN 8
+
+// values: FC5/FC15 = 0/1 per coil, FC6/FC16 = isi register. Kembalikan
+// panjang frame (termasuk CRC), 0 = FC tidak didukung
+inline size_t modbusBuildWriteRequest(uint8_t *out, uint8_t slaveId, uint8_t funCode, uint16_t regAddress,
+                                      uint16_t count, const uint16_t *values)
+{
+  out[0] = slaveId;
+  out[1] = funCode;
+  out[2] = regAddress >> 8;
+  out[3] = regAddress & 0xFF;
+  size_t len;
+  switch (funCode)
+  {
+  case 5:
+    out[4] = values[0] ? 0xFF : 0x00;
+    out[5] = 0;
+    len = 6;
+    break;
+  case 6:
+    out[4] = values[0] >> 8;
+    out[5] = values[0] & 0xFF;
+    len = 6;
+    break;
+  case 15:
+    out[4] = count >> 8;
+    out[5] = count & 0xFF;
+    out[6] = (count + 7) / 8;
+    memset(out + 7, 0, out[6]);
+    for (uint16_t i = 0; i < count; i++)
+    {
+      if (values[i])
+        out[7 + i / 8] |= 1 << (i % 8);
+    }
+    len = 7 + out[6];
+    break;
+  case 16:
+    out[4] = count >> 8;
+    out[5] = count & 0xFF;
+    out[6] = count * 2;
+    for (uint16_t i = 0; i < count; i++)
+    {
+      out[7 + 2 * i] = values[i] >> 8;
+      out[8 + 2 * i] = values[i] & 0xFF;
+    }
+    len = 7 + 2 * count;
+    break;
+  default:
+    return 0;
+  }
+  return modbusRtuFinishFrame(out, len);
+}
+
+// Balasan write = 6 byte pertama request (FC5/6 echo; FC15/16 addr + count)
+inline ModbusFrameResult modbusParseWriteResponse(const uint8_t *buf, size_t len, const uint8_t *request)
+{
+  if (len >= 5 && buf[0] == request[0] && buf[1] == (request[1] | 0x80))
+    return modbusCrc16(buf, 3) == (uint16_t)(buf[3] | (buf[4] << 8)) ? MB_FRAME_EXCEPTION : MB_FRAME_CRC;
+  if (len < MODBUS_WRITE_RESPONSE_LEN)
+    return MB_FRAME_SHORT;
+  if (modbusCrc16(buf, 6) != (uint16_t)(buf[6] | (buf[7] << 8)))
+    return MB_FRAME_CRC;
+  return memcmp(buf, request, 6) == 0 ? MB_FRAME_OK : MB_FRAME_MISMATCH;
+}
+
+// Validasi response FC1/FC2, values[i] = 0/1 per coil / input
+inline ModbusFrameResult modbusParseReadBits(const uint8_t *buf, size_t len, uint8_t slaveId, uint8_t funCode,
+                                             uint16_t count, uint16_t *values)
+{
+  if (len < 5)
+    return MB_FRAME_SHORT;
+  if (buf[0] != slaveId)
+    return MB_FRAME_MISMATCH;
+  if (buf[1] == (funCode | 0x80))
+    return modbusCrc16(buf, 3) == (uint16_t)(buf[3] | (buf[4] << 8)) ? MB_FRAME_EXCEPTION : MB_FRAME_CRC;
+  if (buf[1] != funCode)
+    return MB_FRAME_MISMATCH;
+
+  size_t frameLen = 3 + (size_t)buf[2] + 2;
+  if (len < frameLen)
+    return MB_FRAME_SHORT;
+  if (modbusCrc16(buf, frameLen - 2) != (uint16_t)(buf[frameLen - 2] | (buf[frameLen - 1] << 8)))
+    return MB_FRAME_CRC;
+  if (buf[2] != (count + 7) / 8)
+    return MB_FRAME_MISMATCH;
+
+  for (uint16_t i = 0; i < count; i++)
+    values[i] = (buf[3 + i / 8] >> (i % 8)) & 1;
+  return MB_FRAME_OK;
+}
+
+// Jeda antar frame t3.5 (us): 3.5 karakter x 11 bit; di atas 19200 baud
+// tetap 1750 us (Modbus over serial line, 2.5.1.1)
+inline uint32_t modbusRtuFrameGapUs(uint32_t baudrate)
+{
+  if (baudrate == 0 || baudrate > 19200)
+    return 1750;
+  return (uint32_t)(3.5 * 11 * 1000000.0 / baudrate);
+}
+
+// ============================================================================
+// ENCODING NILAI KE REGISTER (slave map)
+// 16-bit: AB = big endian (standar Modbus), BA = byte ditukar.
+// 32/64-bit: ABCD = big endian, CDAB = urutan word dibalik (umum di PLC),
+// BADC = byte ditukar per word, DCBA = little endian penuh.
+// ============================================================================
+
+enum ModbusEncoding : uint8_t
+{
+  MB_ENC_INT16 = 0,
+  MB_ENC_UINT16,
+  MB_ENC_INT32,
+  MB_ENC_FLOAT32,
+  MB_ENC_UINT32,
+  MB_ENC_INT64,  // totalizer: tanpa kehilangan resolusi saat nilai besar
+  MB_ENC_FLOAT64
+};
+
+enum ModbusWordOrder : uint8_t
+{
+  MB_ORDER_ABCD = 0,
+  MB_ORDER_CDAB,
+  MB_ORDER_BADC,
+  MB_ORDER_DCBA
+};
+
+inline uint8_t modbusEncodingWidth(uint8_t encoding)
+{
+  switch (encoding)
+  {
+  case MB_ENC_INT16:
+  case MB_ENC_UINT16:
+    return 1;
+  case MB_ENC_INT64:
+  case MB_ENC_FLOAT64:
+    return 4;
+  default:
+    return 2;
+  }
+}
+
+inline uint16_t modbusSwapBytes(uint16_t v)
+{
+  return (uint16_t)((v << 8) | (v >> 8));
+}
+
+// bits (word paling signifikan dulu) <-> width register sesuai order
+inline void modbusPutWords(uint16_t *out, uint64_t bits, uint8_t width, uint8_t order)
+{
+  bool swapBytes = order == MB_ORDER_BADC || order == MB_ORDER_DCBA;
+  bool swapWords = order == MB_ORDER_CDAB || order == MB_ORDER_DCBA;
+  for (uint8_t i = 0; i < width; i++)
+  {
+    uint16_t w = (uint16_t)(bits >> (16 * (width - 1 - i)));
+    out[swapWords ? width - 1 - i : i] = swapBytes ? modbusSwapBytes(w) : w;
+  }
+}
+
+inline uint64_t modbusGetWords(const uint16_t *in, uint8_t width, uint8_t order)
+{
+  bool swapBytes = order == MB_ORDER_BADC || order == MB_ORDER_DCBA;
+  bool swapWords = order == MB_ORDER_CDAB || order == MB_ORDER_DCBA;
+  uint64_t bits = 0;
+  for (uint8_t i = 0; i < width; i++)
+  {
+    uint16_t w = in[swapWords ? width - 1 - i : i];
+    bits = (bits << 16) | (swapBytes ? modbusSwapBytes(w) : w);
+  }
+  return bits;
+}
+
+// Clamp ke [lo, hi] lalu geser 0.5 menjauhi nol; cast ke integer = round
+inline double modbusRoundClamp(double v, double lo, double hi)
+{
+  v = v < lo ? lo : (v > hi ? hi : v);
+  return v < 0 ? v - 0.5 : v + 0.5;
+}
+
+// Tulis value * scale ke out[0..width-1]. Integer dibulatkan & di-clamp ke
+// range tipe (bukan wrap seperti cast (int) lama). value double supaya
+// totalizer besar tetap presisi di int32/uint32/int64/float64; encoding
+// 16-bit & float32 tetap dihitung di float.
+inline void modbusEncodeValue(uint16_t *out, double value, float scale, uint8_t encoding, uint8_t order)
+{
+  uint64_t bits;
+  switch (encoding)
+  {
+  case MB_ENC_INT16:
+  case MB_ENC_UINT16:
+  {
+    float v = (float)value * scale;
+    float lo = encoding == MB_ENC_INT16 ? -32768.0f : 0.0f;
+    float hi = encoding == MB_ENC_INT16 ? 32767.0f : 65535.0f;
+    v = v < lo ? lo : (v > hi ? hi : v);
+    int32_t n = (int32_t)(v < 0 ? v - 0.5f : v + 0.5f);
+    bits = (uint16_t)n;
+    break;
+  }
+  case MB_ENC_INT32:
+    bits = (uint32_t)(int32_t)modbusRoundClamp(value * scale, -2147483648.0, 2147483647.0);
+    break;
+  case MB_ENC_UINT32:
+    bits = (uint32_t)modbusRoundClamp(value * scale, 0.0, 4294967295.0);
+    break;
+  case MB_ENC_INT64:
+    bits = (uint64_t)(int64_t)modbusRoundClamp(value * scale, -9.2e18, 9.2e18);
+    break;
+  case MB_ENC_FLOAT64:
+  {
+    double d = value * scale;
+    memcpy(&bits, &d, sizeof(bits));
+    break;
+  }
+  default:
+  {
+    float f = (float)value * scale;
+    uint32_t b;
+    memcpy(&b, &f, sizeof(b));
+    bits = b;
+    break;
+  }
+  }
+  modbusPutWords(out, bits, modbusEncodingWidth(encoding), order);
+}
+
+// Kebalikan modbusEncodeValue: register -> value (sudah dibagi scale)
+inline float modbusDecodeValue(const uint16_t *in, float scale, uint8_t encoding, uint8_t order)
+{
+  uint64_t bits = modbusGetWords(in, modbusEncodingWidth(encoding), order);
+  double v;
+  switch (encoding)
+  {
+  case MB_ENC_INT16:
+    v = (int16_t)bits;
+    break;
+  case MB_ENC_UINT16:
+  case MB_ENC_UINT32:
+    v = (double)bits;
+    break;
+  case MB_ENC_INT32:
+    v = (int32_t)(uint32_t)bits;
+    break;
+  case MB_ENC_INT64:
+    v = (double)(int64_t)bits;
+    break;
+  case MB_ENC_FLOAT64:
+    memcpy(&v, &bits, sizeof(v));
+    break;
+  default:
+  {
+    uint32_t b = (uint32_t)bits;
+    float f;
+    memcpy(&f, &b, sizeof(f));
+    v = f;
+    break;
+  }
+  }
+  return (float)(scale != 0 ? v / scale : v);
+}
+
+#endif
@@ -0,0 +1,349 @@
+#ifndef MODBUS_GATEWAY_HPP
+#define MODBUS_GATEWAY_HPP
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "MetricTypes.hpp"
+#include "ModbusFrame.hpp"
+#include "ModbusRegisterTable.hpp"
+
+// ============================================================================
+// MODBUS GATEWAY (TCP -> RTU)
+// Request Modbus TCP untuk unit ID yang dipetakan ke bus RS-485 (lihat
+// "gateway" di modbusSetup.json) diteruskan ke perangkat di bus oleh
+// Task_ModbusClient, di sela blok scan dan di waktu idle antar scan; task
+// itu satu-satunya pemakai port master, jadi tidak ada rebutan bus.
+//
+// Supaya beban bus tidak naik sebanding jumlah SCADA:
+//   - coalescing : read identik (unit + PDU sama) yang masih antre / sedang
+//                  di bus menumpang ke transaksi yang sama
+//   - cache      : balasan read disimpan cacheMs; poll identik dari master
+//                  lain dalam jendela itu dijawab tanpa menyentuh bus
+// Write (FC5/6/15/16) selalu diteruskan satu per satu dan tidak di-cache.
+//
+// Slot dibagi dua core (server TCP di core 0, bus di core 1): status slot
+// dijaga spinlock, transaksi bus sendiri berjalan di luar lock.
+// Sisi TCP (ModbusGatewayPending) menyimpan MBAP tiap request sendiri, jadi
+// master yang menumpang satu transaksi bus tetap menerima transaction ID dan
+// unit ID miliknya. Tanpa balasan dalam MODBUS_TCP_GATEWAY_TIMEOUT_MS master
+// menerima exception 0x0B; balasan bus yang datang sesudahnya dibuang.
+// Diuji di test/test_modbus_gateway (UART palsu sebagai bus).
+// ============================================================================
+
+#define MODBUS_GATEWAY_SLOTS 8
+#define MODBUS_EX_GATEWAY_TARGET 0x0B
+#define MODBUS_TCP_GATEWAY_PENDING 16
+#define MODBUS_TCP_GATEWAY_TIMEOUT_MS 2000
+
+extern MetricCounter mGatewayRequests; // Metrics.hpp
+extern MetricCounter mGatewayCoalesced;
+extern MetricCounter mGatewayCacheHits;
+extern MetricCounter mGatewayBusTransactions;
+extern MetricCounter mModbusErrors;
+
+// Satu transaksi di bus: kirim frame RTU, kembalikan panjang balasan (0 = timeout)
+typedef size_t (*ModbusGatewayTransact)(const uint8_t *frame, size_t len, uint8_t *resp, size_t maxLen, uint8_t unit, void *ctx);
+
+class ModbusGateway
+{
+public:
+  // --- Server TCP: antrekan / tumpangkan request. -1 = semua slot terpakai ---
+  int submit(uint8_t unit, const uint8_t *pdu, size_t len, uint16_t cacheMs)
+  {
+    if (len == 0 || len > MODBUS_PDU_MAX)
+      return -1;
+    bool cacheable = pdu[0] >= 1 && pdu[0] <= 4;
+    uint32_t now = millis();
+    int found = -1;
+
+    portENTER_CRITICAL(&_mux);
+    reclaim(now);
+    for (int i = 0; i < MODBUS_GATEWAY_SLOTS && found < 0 && cacheable; i++)
+    {
+      Slot &s = _slots[i];
+      bool fresh = s.state != SLOT_DONE || now - s.doneMs <= s.cacheMs;
+      if (s.state != SLOT_FREE && s.cacheable && fresh && s.unit == unit && s.pduLen == len && memcmp(s.pdu, pdu, len) == 0)
+      {
+        s.waiters++;
+        found = i;
+        if (s.state == SLOT_DONE)
+          mGatewayCacheHits.inc();
+        else
+          mGatewayCoalesced.inc();
+      }
+    }
+    for (int i = 0; i < MODBUS_GATEWAY_SLOTS && found < 0; i++)
+    {
+      Slot &s = _slots[i];
+      if (s.state == SLOT_FREE)
+      {
+        s.state = SLOT_QUEUED;
+        s.unit = unit;
+        s.cacheable = cacheable && cacheMs > 0;
+        s.cacheMs = cacheMs;
+        s.pduLen = len;
+        memcpy(s.pdu, pdu, len);
+        s.waiters = 1;
+        s.seq = ++_seq;
+        found = i;
+      }
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    if (found >= 0)
+      mGatewayRequests.inc();
+    return found;
+  }
+
+  // --- Server TCP: salin balasan jika sudah ada ---
+  bool result(int slot, uint8_t *resp, size_t *len)
+  {
+    bool done = false;
+    portENTER_CRITICAL(&_mux);
+    Slot &s = _slots[slot];
+    if (s.state == SLOT_DONE)
+    {
+      memcpy(resp, s.resp, s.respLen);
+      *len = s.respLen;
+      done = true;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return done;
+  }
+
+  // --- Server TCP: balasan sudah dikirim / client putus ---
+  void release(int slot)
+  {
+    portENTER_CRITICAL(&_mux);
+    Slot &s = _slots[slot];
+    if (s.waiters > 0)
+      s.waiters--;
+    portEXIT_CRITICAL(&_mux);
+  }
+
+  // --- Task_ModbusClient: ambil request tertua yang antre ---
+  bool next(int &slot, uint8_t &unit, uint8_t *pdu, size_t &len)
+  {
+    slot = -1;
+    portENTER_CRITICAL(&_mux);
+    for (int i = 0; i < MODBUS_GATEWAY_SLOTS; i++)
+    {
+      Slot &s = _slots[i];
+      if (s.state == SLOT_QUEUED && s.waiters == 0)
+        s.state = SLOT_FREE; // semua peminta sudah putus / menyerah
+      if (s.state == SLOT_QUEUED && (slot < 0 || (int32_t)(s.seq - _slots[slot].seq) < 0))
+        slot = i;
+    }
+    if (slot >= 0)
+    {
+      Slot &s = _slots[slot];
+      s.state = SLOT_BUSY;
+      unit = s.unit;
+      len = s.pduLen;
+      memcpy(pdu, s.pdu, len);
+    }
+    portEXIT_CRITICAL(&_mux);
+    return slot >= 0;
+  }
+
+  // --- Task_ModbusClient: PDU balasan perangkat (sudah termasuk exception) ---
+  // Semua peminta sudah timeout / putus selama di bus: balasan terlambat
+  // dibuang, bukan disimpan sebagai cache (slot langsung bebas).
+  void complete(int slot, const uint8_t *resp, size_t len)
+  {
+    portENTER_CRITICAL(&_mux);
+    Slot &s = _slots[slot];
+    if (s.waiters == 0)
+    {
+      s.state = SLOT_FREE;
+    }
+    else
+    {
+      memcpy(s.resp, resp, len);
+      s.respLen = len;
+      s.doneMs = millis();
+      s.state = SLOT_DONE;
+    }
+    portEXIT_CRITICAL(&_mux);
+  }
+
+  // --- Task_ModbusClient: teruskan semua request yang antre ke bus ---
+  // Balasan yang tidak ada / unit atau CRC salah -> exception 0x0B
+  void service(ModbusGatewayTransact transact, void *ctx)
+  {
+    int slot;
+    uint8_t unit;
+    uint8_t pdu[MODBUS_PDU_MAX];
+    size_t len;
+    while (next(slot, unit, pdu, len))
+    {
+      uint8_t frame[MODBUS_RTU_FRAME_MAX];
+      uint8_t resp[MODBUS_RTU_FRAME_MAX];
+      uint8_t out[MODBUS_PDU_MAX];
+      size_t outLen;
+
+      frame[0] = unit;
+      memcpy(frame + 1, pdu, len);
+      size_t frameLen = modbusRtuFinishFrame(frame, 1 + len);
+      mGatewayBusTransactions.inc();
+      size_t n = transact(frame, frameLen, resp, sizeof(resp), unit, ctx);
+
+      if (n >= 5 && resp[0] == unit && modbusCrc16(resp, n - 2) == (uint16_t)(resp[n - 2] | (resp[n - 1] << 8)))
+      {
+        outLen = n - 3; // tanpa unit ID & CRC
+        memcpy(out, resp + 1, outLen);
+      }
+      else
+      {
+        if (n)
+          mModbusErrors.inc();
+        outLen = exception(out, pdu[0], MODBUS_EX_GATEWAY_TARGET);
+      }
+      complete(slot, out, outLen);
+    }
+  }
+
+  // Balasan exception PDU (gateway tidak dapat jawaban dari perangkat)
+  static size_t exception(uint8_t *resp, uint8_t fc, uint8_t code)
+  {
+    resp[0] = fc | 0x80;
+    resp[1] = code;
+    return 2;
+  }
+
+private:
+  enum SlotState : uint8_t
+  {
+    SLOT_FREE = 0,
+    SLOT_QUEUED, // menunggu giliran bus
+    SLOT_BUSY,   // sedang di bus
+    SLOT_DONE    // balasan ada, dibaca waiter / disimpan sebagai cache
+  };
+
+  struct Slot
+  {
+    uint8_t state; // SlotState
+    uint8_t unit;
+    bool cacheable;
+    uint8_t waiters; // request TCP yang masih menunggu slot ini
+    uint16_t cacheMs;
+    uint32_t seq, doneMs;
+    size_t pduLen, respLen;
+    uint8_t pdu[MODBUS_PDU_MAX];
+    uint8_t resp[MODBUS_PDU_MAX];
+  };
+
+  // Slot selesai tanpa waiter: bebas jika bukan cache atau cache kedaluwarsa
+  void reclaim(uint32_t now)
+  {
+    for (Slot &s : _slots)
+    {
+      if (s.state == SLOT_DONE && s.waiters == 0 && (!s.cacheable || now - s.doneMs > s.cacheMs))
+        s.state = SLOT_FREE;
+    }
+  }
+
+  Slot _slots[MODBUS_GATEWAY_SLOTS] = {};
+  uint32_t _seq = 0;
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+ModbusGateway modbusGateway;
+
+// Balasan untuk satu master: MBAP request asli + PDU. timedOut = 0x0B dari
+// sisi TCP (tidak ada balasan bus dalam MODBUS_TCP_GATEWAY_TIMEOUT_MS)
+typedef void (*ModbusGatewayReply)(uint8_t client, const uint8_t *mbap, const uint8_t *pdu, size_t pduLen, bool timedOut, int64_t rxUs, void *ctx);
+
+// Request gateway yang menunggu balasan, per master (dipakai ModbusTcpServer)
+class ModbusGatewayPending
+{
+public:
+  explicit ModbusGatewayPending(ModbusGateway &gateway) : _gateway(gateway)
+  {
+    for (Entry &e : _entries)
+      e.slot = -1;
+  }
+
+  // Frame MBAP lengkap dari master client. false = penuh (jawab "device busy")
+  bool add(uint8_t client, const uint8_t *frame, size_t frameLen, uint16_t cacheMs, int64_t rxUs)
+  {
+    Entry *e = NULL;
+    for (Entry &candidate : _entries)
+    {
+      if (candidate.slot < 0)
+      {
+        e = &candidate;
+        break;
+      }
+    }
+    int slot = e ? _gateway.submit(frame[6], frame + 7, frameLen - 7, cacheMs) : -1;
+    if (slot < 0)
+      return false;
+
+    e->slot = slot;
+    e->client = client;
+    memcpy(e->mbap, frame, sizeof(e->mbap));
+    e->fc = frame[7];
+    e->rxUs = rxUs;
+    _count++;
+    return true;
+  }
+
+  // Master putus: slot gateway dilepas (balasan yang datang nanti dibuang)
+  void dropClient(uint8_t client)
+  {
+    for (Entry &e : _entries)
+    {
+      if (e.slot >= 0 && e.client == client)
+        finish(e);
+    }
+  }
+
+  // Kirim balasan yang sudah selesai (atau cache hit); lewat timeout -> 0x0B
+  void deliver(int64_t nowUs, ModbusGatewayReply reply, void *ctx)
+  {
+    for (Entry &e : _entries)
+    {
+      if (e.slot < 0)
+        continue;
+      uint8_t pdu[MODBUS_PDU_MAX];
+      size_t pduLen;
+      if (_gateway.result(e.slot, pdu, &pduLen))
+      {
+        finish(e);
+        reply(e.client, e.mbap, pdu, pduLen, false, e.rxUs, ctx);
+      }
+      else if (nowUs - e.rxUs > MODBUS_TCP_GATEWAY_TIMEOUT_MS * 1000LL)
+      {
+        finish(e);
+        pduLen = ModbusGateway::exception(pdu, e.fc, MODBUS_EX_GATEWAY_TARGET);
+        reply(e.client, e.mbap, pdu, pduLen, true, e.rxUs, ctx);
+      }
+    }
+  }
+
+  uint8_t count() const { return _count; }
+
+private:
+  struct Entry
+  {
+    int8_t slot; // slot ModbusGateway, -1 = kosong
+    uint8_t client;
+    uint8_t mbap[7];
+    uint8_t fc;
+    int64_t rxUs;
+  };
+
+  void finish(Entry &e)
+  {
+    _gateway.release(e.slot);
+    e.slot = -1;
+    _count--;
+  }
+
+  ModbusGateway &_gateway;
+  Entry _entries[MODBUS_TCP_GATEWAY_PENDING];
+  uint8_t _count = 0;
+};
+
+#endif
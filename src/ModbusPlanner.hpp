@@ -0,0 +1,100 @@
+#ifndef MODBUS_PLANNER_HPP
+#define MODBUS_PLANNER_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// MODBUS BLOCK-READ PLANNER (master RTU & TCP)
+// Tag yang berdekatan di satu perangkat digabung jadi satu request FC3/FC4
+// (maks. 125 register), jadi scan N tag di meter yang sama = beberapa
+// transaksi, bukan N. Celah register kosong ikut dibaca selama tidak lebih
+// dari MODBUS_BLOCK_MAX_GAP: satu request lebih lebar hampir selalu lebih
+// murah daripada satu round-trip tambahan (RS-485 maupun TCP).
+// Dihitung sekali saat snapshot config dibuat, bukan per scan.
+// ============================================================================
+
+#define MODBUS_BLOCK_MAX_REGS 125
+#define MODBUS_BLOCK_MAX_GAP 8
+#define MODBUS_TCP_MAX_TARGETS 8
+
+struct ModbusBlock
+{
+  uint8_t target; // 0 = bus RS-485, 1.. = tcpTargets[target - 1]
+  uint8_t unit;   // slave ID / unit ID
+  uint8_t fc;
+  uint16_t start, count;
+  uint8_t firstTag, tagCount; // range di blockTags[]
+};
+
+// Perangkat Modbus TCP yang di-poll (elemen ke-6 tag: "ip[:port]")
+struct ModbusTcpTarget
+{
+  uint32_t ip; // urutan byte IPAddress (octet pertama di byte terendah)
+  uint16_t port;
+};
+
+// Urutan planner: target, unit, fc, register
+template <typename Tag>
+inline bool modbusPlanLess(const Tag &a, const Tag &b)
+{
+  if (a.target != b.target)
+    return a.target < b.target;
+  if (a.slaveId != b.slaveId)
+    return a.slaveId < b.slaveId;
+  if (a.fc != b.fc)
+    return a.fc < b.fc;
+  return a.reg < b.reg;
+}
+
+// Susun blok dari tabel tag. order[] menerima index tag terurut per blok
+// (blockTags), blocks[] minimal n entri. Kembalikan jumlah blok.
+// Tag dengan FC selain 3/4 tetap jadi blok sendiri (1 register).
+template <typename Tag>
+inline size_t modbusPlanBlocks(const Tag *tags, size_t n, uint8_t *order, ModbusBlock *blocks)
+{
+  for (size_t i = 0; i < n; i++)
+    order[i] = (uint8_t)i;
+  for (size_t i = 1; i < n; i++) // insertion sort, n <= 64
+  {
+    uint8_t t = order[i];
+    size_t j = i;
+    for (; j > 0 && modbusPlanLess(tags[t], tags[order[j - 1]]); j--)
+      order[j] = order[j - 1];
+    order[j] = t;
+  }
+
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    const Tag &t = tags[order[i]];
+    if (count > 0)
+    {
+      ModbusBlock &b = blocks[count - 1];
+      uint32_t end = (uint32_t)b.start + b.count; // eksklusif
+      bool mergeable = (t.fc == 3 || t.fc == 4) && b.target == t.target && b.unit == t.slaveId && b.fc == t.fc;
+      if (mergeable && t.reg < end)
+      {
+        b.tagCount++; // register sama dengan tag sebelumnya (multiplier beda)
+        continue;
+      }
+      if (mergeable && t.reg - end <= MODBUS_BLOCK_MAX_GAP && t.reg + 1u - b.start <= MODBUS_BLOCK_MAX_REGS)
+      {
+        b.count = t.reg + 1 - b.start;
+        b.tagCount++;
+        continue;
+      }
+    }
+    ModbusBlock &b = blocks[count++];
+    b.target = t.target;
+    b.unit = t.slaveId;
+    b.fc = t.fc;
+    b.start = t.reg;
+    b.count = 1;
+    b.firstTag = (uint8_t)i;
+    b.tagCount = 1;
+  }
+  return count;
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef MODBUS_REGISTER_TABLE_HPP
+#define MODBUS_REGISTER_TABLE_HPP
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================================
+// MODBUS REGISTER TABLE (tabel slave double buffer + jalur baca FC1-4)
+// Bagian ModbusRegisterBank (ModbusSlave.hpp) yang tidak butuh config / HAL:
+// penyimpanan IR/HR/coil/DI dan processRead(). Tanpa Arduino.h seperti
+// ModbusFrame.hpp: bisa diuji & diukur di host (test/test_slave_bank).
+//
+// Writer (satu task) mengisi bank yang tidak aktif di antara beginWrite() dan
+// commit(), lalu menukar index aktif. Reader menyalin range yang diminta dari
+// bank aktif dan mengulang hanya jika bank itu mulai ditulis selama
+// penyalinan (seq ganjil / berubah). Reader tidak pernah menunggu writer.
+// ============================================================================
+
+#define MODBUS_SLAVE_REGS 256 // alamat per tabel slave (ireg/hreg/coil/ists)
+
+#define MODBUS_EX_ILLEGAL_FUNCTION 0x01
+#define MODBUS_EX_ILLEGAL_ADDRESS 0x02
+#define MODBUS_EX_ILLEGAL_VALUE 0x03
+#define MODBUS_EX_DEVICE_BUSY 0x06
+
+#define MODBUS_PDU_MAX 253
+
+class ModbusRegisterTable
+{
+public:
+  struct Bank
+  {
+    uint32_t generation;
+    uint16_t ireg[MODBUS_SLAVE_REGS];
+    uint16_t hreg[MODBUS_SLAVE_REGS];
+    uint8_t coil[MODBUS_SLAVE_REGS / 8];
+    uint8_t ists[MODBUS_SLAVE_REGS / 8];
+  };
+
+  // --- Writer: bank tidak aktif (isi lama = dua update sebelumnya) ---
+  Bank &beginWrite()
+  {
+    _writing = 1 - _active.load(std::memory_order_relaxed);
+    _seq[_writing].fetch_add(1, std::memory_order_relaxed); // ganjil: sedang ditulis
+    std::atomic_thread_fence(std::memory_order_release);
+    return _bank[_writing];
+  }
+
+  void commit()
+  {
+    std::atomic_thread_fence(std::memory_order_release);
+    _seq[_writing].fetch_add(1, std::memory_order_relaxed);
+    _active.store(_writing, std::memory_order_release);
+  }
+
+  static void setBit(uint8_t *bits, uint16_t addr, bool on)
+  {
+    if (on)
+      bits[addr / 8] |= 1 << (addr % 8);
+    else
+      bits[addr / 8] &= ~(1 << (addr % 8));
+  }
+
+  static size_t exception(uint8_t *resp, uint8_t fc, uint8_t code)
+  {
+    resp[0] = fc | 0x80;
+    resp[1] = code;
+    return 2;
+  }
+
+  // --- Reader: PDU FC1-4 (tanpa unit ID / CRC / MBAP) ---
+  // Tulis PDU balasan ke resp (minimal MODBUS_PDU_MAX byte), kembalikan
+  // panjangnya. FC lain dijawab illegal function.
+  size_t processRead(const uint8_t *req, size_t len, uint8_t *resp)
+  {
+    if (len < 1)
+      return 0;
+    uint8_t fc = req[0];
+    if (fc < 1 || fc > 4)
+      return exception(resp, fc, MODBUS_EX_ILLEGAL_FUNCTION);
+    if (len < 5)
+      return exception(resp, fc, MODBUS_EX_ILLEGAL_VALUE);
+
+    uint16_t addr = (req[1] << 8) | req[2];
+    uint16_t qty = (req[3] << 8) | req[4];
+    bool bits = fc <= 2;
+    if (qty < 1 || qty > (bits ? 2000 : 125))
+      return exception(resp, fc, MODBUS_EX_ILLEGAL_VALUE);
+    if ((uint32_t)addr + qty > MODBUS_SLAVE_REGS)
+      return exception(resp, fc, MODBUS_EX_ILLEGAL_ADDRESS);
+
+    resp[0] = fc;
+    if (bits)
+    {
+      size_t bytes = (qty + 7) / 8;
+      resp[1] = bytes;
+      readBits(fc == 1 ? offsetof(Bank, coil) : offsetof(Bank, ists), addr, qty, resp + 2);
+      return 2 + bytes;
+    }
+
+    uint16_t regs[125];
+    readRegs(fc == 3 ? offsetof(Bank, hreg) : offsetof(Bank, ireg), addr, qty, regs);
+    resp[1] = qty * 2;
+    for (uint16_t i = 0; i < qty; i++)
+    {
+      resp[2 + 2 * i] = regs[i] >> 8;
+      resp[3 + 2 * i] = regs[i] & 0xFF;
+    }
+    return 2 + qty * 2;
+  }
+
+private:
+  // Salin konsisten dari bank aktif (retry jika bank mulai ditulis)
+  template <typename Copy>
+  void readStable(Copy copy)
+  {
+    while (true)
+    {
+      uint8_t b = _active.load(std::memory_order_acquire);
+      uint32_t seq = _seq[b].load(std::memory_order_acquire);
+      if (seq & 1)
+        continue; // writer baru saja pindah ke bank ini, _active segera berubah
+      copy(_bank[b]);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (_seq[b].load(std::memory_order_relaxed) == seq)
+        return;
+    }
+  }
+
+  void readRegs(size_t table, uint16_t addr, uint16_t qty, uint16_t *out)
+  {
+    readStable([&](const Bank &bank)
+               { memcpy(out, (const uint8_t *)&bank + table + addr * 2, qty * 2); });
+  }
+
+  void readBits(size_t table, uint16_t addr, uint16_t qty, uint8_t *out)
+  {
+    readStable([&](const Bank &bank)
+               {
+      const uint8_t *src = (const uint8_t *)&bank + table;
+      memset(out, 0, (qty + 7) / 8);
+      for (uint16_t i = 0; i < qty; i++)
+      {
+        uint16_t a = addr + i;
+        if (src[a / 8] & (1 << (a % 8)))
+          out[i / 8] |= 1 << (i % 8);
+      } });
+  }
+
+  Bank _bank[2] = {};
+  std::atomic<uint32_t> _seq[2] = {};
+  std::atomic<uint8_t> _active{0};
+  uint8_t _writing = 1;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef MODBUS_RTU_SLAVE_HPP
+#define MODBUS_RTU_SLAVE_HPP
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "MetricTypes.hpp"
+#include "ModbusFrame.hpp"
+#include "Rs485Port.hpp"
+
+// ============================================================================
+// MODBUS RTU SLAVE (service loop)
+// Frame dianggap selesai setelah jeda t3.5 tanpa byte baru, lalu PDU-nya
+// dijawab handler (firmware: slaveRegistersPdu di ModbusSlave.hpp, test host:
+// tabel register langsung). poll() dipanggil tiap tick (1 ms): byte terakhir
+// terbaca <= 1 tick setelah tiba, jeda t3.5 diukur dalam tick, jadi balasan
+// keluar paling lambat t3.5 (dibulatkan ke tick) + 1 tick (test_rtu_slave).
+// Dipakai di dua mode:
+//   - port sendiri : Task_ModbusRtuSlave memanggil poll() terus-menerus
+//   - bus bersama  : Task_ModbusClient memanggil serviceFor() di sela scan,
+//                    jadi request master dan balasan slave tidak pernah tumpang
+//                    tindih di bus (request yang datang saat scan tidak dijawab)
+// ============================================================================
+
+extern MetricCounter mSlaveRequests; // Metrics.hpp
+extern MetricCounter mSlaveExceptions;
+extern MetricHistogram mSlaveRequestRtu;
+
+// PDU request (tanpa id & CRC) -> PDU balasan di resp, 0 = tidak dijawab
+typedef size_t (*ModbusSlavePduHandler)(const uint8_t *req, size_t len, uint8_t *resp, void *ctx);
+
+class ModbusRtuSlave
+{
+public:
+  // Baca byte yang sudah ada; jawab jika frame lengkap. true = ada aktivitas
+  bool poll(Rs485Port &port, uint8_t slaveId, ModbusSlavePduHandler handler, void *ctx)
+  {
+    HardwareSerial &serial = port.serial();
+    int64_t now = esp_timer_get_time();
+    bool activity = false;
+
+    while (serial.available())
+    {
+      int c = serial.read();
+      if (c < 0)
+        break;
+      if (_len < sizeof(_buf))
+        _buf[_len++] = (uint8_t)c;
+      else
+        _overflow = true; // frame terlalu panjang: dibuang saat jeda berikutnya
+      _lastByteUs = now;
+      activity = true;
+    }
+
+    if (_len > 0 && now - _lastByteUs >= port.frameGapUs())
+    {
+      if (!_overflow)
+        reply(port, slaveId, handler, ctx);
+      _len = 0;
+      _overflow = false;
+      activity = true;
+    }
+    return activity;
+  }
+
+  // Layani selama budgetMs (mode bus bersama)
+  void serviceFor(Rs485Port &port, uint8_t slaveId, ModbusSlavePduHandler handler, void *ctx, uint32_t budgetMs)
+  {
+    uint32_t start = millis();
+    do
+    {
+      poll(port, slaveId, handler, ctx);
+      vTaskDelay(1);
+    } while (millis() - start < budgetMs);
+  }
+
+  // Port baru dibuka / master mengambil bus: sisa byte tidak berarti lagi
+  void reset() { _len = 0; }
+
+private:
+  void reply(Rs485Port &port, uint8_t slaveId, ModbusSlavePduHandler handler, void *ctx)
+  {
+    size_t pduLen = modbusRtuRequestPdu(_buf, _len, slaveId);
+    if (pduLen == 0)
+      return; // bukan untuk kita / CRC salah: diam (sesuai spesifikasi)
+
+    int64_t t0 = _lastByteUs; // latency dihitung dari byte terakhir request
+    uint8_t out[MODBUS_RTU_FRAME_MAX];
+    out[0] = slaveId;
+    size_t respLen = handler(_buf + 1, pduLen, out + 1, ctx);
+    if (respLen == 0)
+      return;
+    size_t frameLen = modbusRtuFinishFrame(out, 1 + respLen);
+
+    HardwareSerial &serial = port.serial();
+    serial.write(out, frameLen);
+    serial.flush(); // tunggu stop bit terakhir (DE turun oleh driver)
+
+    mSlaveRequests.inc();
+    if (out[1] & 0x80)
+      mSlaveExceptions.inc();
+    mSlaveRequestRtu.observeUs((uint32_t)(esp_timer_get_time() - t0));
+  }
+
+  uint8_t _buf[MODBUS_RTU_FRAME_MAX];
+  size_t _len = 0;
+  bool _overflow = false;
+  int64_t _lastByteUs = 0;
+};
+
+#endif
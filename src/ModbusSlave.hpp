@@ -0,0 +1,271 @@
+#ifndef MODBUS_SLAVE_HPP
+#define MODBUS_SLAVE_HPP
+
+#include <Arduino.h>
+#include <atomic>
+#include "config.hpp"
+#include "CommandQueue.hpp"
+#include "ModbusFrame.hpp"
+#include "ModbusRegisterTable.hpp"
+#include "RuntimeConfig.hpp"
+
+// ============================================================================
+// MODBUS SLAVE REGISTER BANK
+// Tabel slave (IR/HR/coil/DI) sebagai array kontigu: request dilayani dengan
+// index langsung (alamat = offset), bukan pencarian list register per alamat.
+// Isi diatur slave map di RuntimeConfig (lihat defaultSlaveMap()) dan di-encode
+// sekaligus sekali per siklus akuisisi.
+//
+// Dua bank (double buffer, ModbusRegisterTable.hpp): writer
+// (Task_DataAcquisition) mengisi bank yang tidak aktif lalu menukar index
+// aktif; reader (server TCP/RTU) tidak pernah menunggu writer yang
+// ter-preempt. Tidak ada mutex bersama akuisisi.
+//
+// Write (FC5/6/15/16) tidak mengubah bank: alamat dicari di slave map lalu
+// diterjemahkan jadi perintah di commandQueue (coil -> DO lokal, holding
+// register -> register tag RS-485 asal nilainya). Balasan write dikirim begitu
+// perintah masuk antrean; nilai baru terlihat di read setelah scan berikutnya.
+// ============================================================================
+
+extern double totalizerValue(uint8_t index); // Totalizers.hpp
+
+class ModbusRegisterBank
+{
+public:
+  // --- Task_ModbusClient: nilai terbaru per tag master ---
+  // valid = dibaca sukses; hanya itu yang memperbarui timestamp sampel
+  // (totalizer tidak mengintegralkan nilai 0 dari read yang gagal)
+  void setTagValue(uint16_t index, float value, bool valid)
+  {
+    if (index >= RUNTIME_MAX_MODBUS_TAGS)
+      return;
+    portENTER_CRITICAL(&_tagMux);
+    _tagValues[index] = value;
+    if (valid)
+      _tagSampleMs[index] = millis();
+    portEXIT_CRITICAL(&_tagMux);
+  }
+
+  float tagValue(uint16_t index) const { return index < RUNTIME_MAX_MODBUS_TAGS ? _tagValues[index] : 0; }
+
+  // Nilai + waktu read sukses terakhir (0 = belum pernah), sepasang
+  uint32_t tagSample(uint16_t index, float &value)
+  {
+    if (index >= RUNTIME_MAX_MODBUS_TAGS)
+      return 0;
+    portENTER_CRITICAL(&_tagMux);
+    value = _tagValues[index];
+    uint32_t sampleMs = _tagSampleMs[index];
+    portEXIT_CRITICAL(&_tagMux);
+    return sampleMs;
+  }
+
+  // Tabel tag berubah: index lama tidak berarti lagi
+  void resetTagValues()
+  {
+    portENTER_CRITICAL(&_tagMux);
+    for (int i = 0; i < RUNTIME_MAX_MODBUS_TAGS; i++)
+    {
+      _tagValues[i] = 0;
+      _tagSampleMs[i] = 0;
+    }
+    portEXIT_CRITICAL(&_tagMux);
+  }
+
+  // --- Task_DataAcquisition: encode semua entri slave map ke bank baru ---
+  void update(const RuntimeConfig *cfg)
+  {
+    ModbusRegisterTable::Bank &bank = _table.beginWrite();
+
+    // Map berubah: alamat yang tidak dipetakan lagi harus kembali 0
+    if (bank.generation != cfg->generation)
+    {
+      memset(&bank, 0, sizeof(bank));
+      bank.generation = cfg->generation;
+    }
+
+    for (uint16_t n = 0; n < cfg->slaveMapCount; n++)
+    {
+      const SlaveMapEntry &e = cfg->slaveMap[n];
+      double value = sourceValue(e);
+      switch (e.area)
+      {
+      case SLAVE_AREA_IREG:
+        modbusEncodeValue(&bank.ireg[e.addr], value, e.scale, e.encoding, e.order);
+        break;
+      case SLAVE_AREA_HREG:
+        modbusEncodeValue(&bank.hreg[e.addr], value, e.scale, e.encoding, e.order);
+        break;
+      case SLAVE_AREA_COIL:
+        ModbusRegisterTable::setBit(bank.coil, e.addr, value != 0);
+        break;
+      case SLAVE_AREA_ISTS:
+        ModbusRegisterTable::setBit(bank.ists, e.addr, value != 0);
+        break;
+      }
+    }
+
+    _table.commit();
+  }
+
+  // --- Server TCP/RTU: proses satu PDU (tanpa unit ID / CRC / MBAP) ---
+  // Tulis PDU balasan ke resp (minimal MODBUS_PDU_MAX byte), kembalikan panjangnya.
+  // Tanpa cfg (slave map tidak diketahui) write dijawab illegal function.
+  size_t processPdu(const uint8_t *req, size_t len, uint8_t *resp, const RuntimeConfig *cfg = NULL)
+  {
+    if (len < 1)
+      return 0;
+    uint8_t fc = req[0];
+    if (cfg && (fc == 5 || fc == 6 || fc == 15 || fc == 16))
+      return processWrite(cfg, req, len, resp);
+    return _table.processRead(req, len, resp);
+  }
+
+private:
+  // Entri slave map yang dimulai tepat di addr
+  static const SlaveMapEntry *findEntry(const RuntimeConfig *cfg, uint8_t area, uint16_t addr)
+  {
+    for (uint16_t n = 0; n < cfg->slaveMapCount; n++)
+    {
+      const SlaveMapEntry &e = cfg->slaveMap[n];
+      if (e.area == area && e.addr == addr)
+        return &e;
+    }
+    return NULL;
+  }
+
+  // Coil -> DO lokal
+  static bool coilCommand(const RuntimeConfig *cfg, uint16_t addr, bool on, WriteCommand &cmd)
+  {
+    const SlaveMapEntry *e = findEntry(cfg, SLAVE_AREA_COIL, addr);
+    if (!e || e->source != SLAVE_SRC_DO)
+      return false;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.target = CMD_TARGET_DO;
+    cmd.source = CMD_SRC_MODBUS;
+    cmd.fc = 5;
+    cmd.addr = e->index;
+    cmd.count = 1;
+    cmd.values[0] = on;
+    return true;
+  }
+
+  // Holding register (1-2 word sesuai encoding) -> FC6 ke register asal tag.
+  // Nilai di-decode dengan scale/encoding slave map lalu dibagi multiplier tag,
+  // kebalikan dari jalur baca. Hanya tag RS-485 FC3 yang bisa ditulis.
+  static bool registerCommand(const RuntimeConfig *cfg, uint16_t addr, const uint16_t *regs, uint16_t avail,
+                              uint16_t &width, WriteCommand &cmd)
+  {
+    const SlaveMapEntry *e = findEntry(cfg, SLAVE_AREA_HREG, addr);
+    if (!e || e->source != SLAVE_SRC_TAG)
+      return false;
+    const ModbusTagConfig &tag = cfg->tags[e->index];
+    width = modbusEncodingWidth(e->encoding);
+    if (width > avail || tag.target != 0 || tag.fc != 3 || tag.multiplier == 0)
+      return false;
+
+    float raw = modbusDecodeValue(regs, e->scale, e->encoding, e->order) / tag.multiplier;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.target = CMD_TARGET_RTU;
+    cmd.source = CMD_SRC_MODBUS;
+    cmd.verify = true;
+    cmd.unit = tag.slaveId;
+    cmd.fc = 6;
+    cmd.addr = tag.reg;
+    cmd.count = 1;
+    cmd.values[0] = (uint16_t)constrain(lroundf(raw), 0L, 65535L);
+    return true;
+  }
+
+  // FC5/6/15/16: validasi semua alamat dulu, baru antrekan (all-or-nothing
+  // untuk alamat; antrean penuh di tengah jalan -> device busy)
+  size_t processWrite(const RuntimeConfig *cfg, const uint8_t *req, size_t len, uint8_t *resp)
+  {
+    uint8_t fc = req[0];
+    if (len < 5)
+      return exception(resp, fc, MODBUS_EX_ILLEGAL_VALUE);
+    uint16_t addr = (req[1] << 8) | req[2];
+    uint16_t qty = (req[3] << 8) | req[4]; // FC5/6: nilai
+    WriteCommand cmds[COMMAND_QUEUE_DEPTH];
+    uint8_t n = 0;
+
+    if (fc == 5 || fc == 6)
+    {
+      uint16_t width;
+      if (fc == 5 && qty != 0xFF00 && qty != 0x0000)
+        return exception(resp, fc, MODBUS_EX_ILLEGAL_VALUE);
+      bool ok = fc == 5 ? coilCommand(cfg, addr, qty == 0xFF00, cmds[0])
+                        : registerCommand(cfg, addr, &qty, 1, width, cmds[0]);
+      if (!ok)
+        return exception(resp, fc, MODBUS_EX_ILLEGAL_ADDRESS);
+      n = 1;
+    }
+    else
+    {
+      size_t bytes = fc == 15 ? (qty + 7) / 8 : qty * 2u;
+      if (qty < 1 || qty > (fc == 15 ? 1968 : 123) || len < 6 + bytes || req[5] != bytes)
+        return exception(resp, fc, MODBUS_EX_ILLEGAL_VALUE);
+      const uint8_t *data = req + 6;
+      uint16_t regs[123];
+      for (uint16_t i = 0; fc == 16 && i < qty; i++)
+        regs[i] = (data[2 * i] << 8) | data[2 * i + 1];
+
+      for (uint16_t i = 0; i < qty;)
+      {
+        uint16_t width = 1;
+        bool ok = n < COMMAND_QUEUE_DEPTH &&
+                  (fc == 15 ? coilCommand(cfg, addr + i, data[i / 8] & (1 << (i % 8)), cmds[n])
+                            : registerCommand(cfg, addr + i, regs + i, qty - i, width, cmds[n]));
+        if (!ok)
+          return exception(resp, fc, MODBUS_EX_ILLEGAL_ADDRESS);
+        n++;
+        i += width;
+      }
+    }
+
+    for (uint8_t i = 0; i < n; i++)
+    {
+      if (!commandQueue.submit(cmds[i]))
+        return exception(resp, fc, MODBUS_EX_DEVICE_BUSY);
+    }
+    memcpy(resp, req, 5); // FC5/6: echo; FC15/16: fc, addr, qty
+    return 5;
+  }
+
+  double sourceValue(const SlaveMapEntry &e) const
+  {
+    switch (e.source)
+    {
+    case SLAVE_SRC_AI:
+      return analogInput[e.index].mapValue;
+    case SLAVE_SRC_AI_RAW:
+      return analogInput[e.index].adcValue;
+    case SLAVE_SRC_DI:
+      return digitalInput[e.index].value;
+    case SLAVE_SRC_DO:
+      return digitalOutput[e.index].value;
+    case SLAVE_SRC_TAG:
+      return _tagValues[e.index];
+    case SLAVE_SRC_TOTAL:
+      return totalizerValue(e.index);
+    }
+    return 0;
+  }
+
+  static size_t exception(uint8_t *resp, uint8_t fc, uint8_t code) { return ModbusRegisterTable::exception(resp, fc, code); }
+
+  ModbusRegisterTable _table;
+  volatile float _tagValues[RUNTIME_MAX_MODBUS_TAGS] = {};
+  uint32_t _tagSampleMs[RUNTIME_MAX_MODBUS_TAGS] = {};
+  portMUX_TYPE _tagMux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+ModbusRegisterBank slaveRegisters;
+
+// Handler ModbusRtuSlave: ctx = snapshot RuntimeConfig milik task pemanggil
+inline size_t slaveRegistersPdu(const uint8_t *req, size_t len, uint8_t *resp, void *ctx)
+{
+  return slaveRegisters.processPdu(req, len, resp, (const RuntimeConfig *)ctx);
+}
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef MODBUS_TCP_CLIENT_HPP
+#define MODBUS_TCP_CLIENT_HPP
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "esp_timer.h"
+#include "MetricTypes.hpp"
+#include "ModbusFrame.hpp"
+#include "ModbusPlanner.hpp"
+
+// ============================================================================
+// MODBUS TCP CLIENT (master, polling meter lewat WiFi/Ethernet)
+// Satu koneksi persisten per target (tcpTargets di RuntimeConfig), dibuka
+// sekali dan dipakai ulang antar scan; handshake TCP tidak dibayar per request.
+// Per koneksi sampai MODBUS_TCP_MAX_INFLIGHT request dikirim sekaligus dengan
+// transaction ID berbeda, balasan dicocokkan lewat TID (gateway/meter yang
+// memproses berurutan tetap benar, hanya tidak lebih cepat).
+// Blok berasal dari planner yang sama dengan RS-485 (ModbusPlanner.hpp).
+// Hanya melihat rencana blok & daftar target (bukan RuntimeConfig), jadi
+// bisa diuji di host terhadap simulator TCP lokal (test/test_modbus_tcp).
+//
+// Non-blocking kecuali connect(): poll() dipanggil Task_ModbusClient di sela
+// blok RS-485, jadi kedua transport berjalan paralel dalam satu scan.
+// Timeout -> koneksi ditutup (stream bisa tidak sinkron lagi) dan dibuka
+// ulang di blok berikutnya; connect gagal -> target dilewati selama
+// MODBUS_TCP_RETRY_MS supaya meter mati tidak memperlambat scan lain.
+// ============================================================================
+
+#define MODBUS_TCP_MAX_INFLIGHT 4
+#define MODBUS_TCP_TIMEOUT_MS 1000
+#define MODBUS_TCP_CONNECT_TIMEOUT_MS 500
+#define MODBUS_TCP_RETRY_MS 5000
+#define MODBUS_TCP_ADU_MAX (MODBUS_MBAP_LEN + 253)
+
+extern MetricCounter mModbusTcpRequests; // Metrics.hpp
+extern MetricCounter mModbusTcpFailures;
+extern MetricCounter mModbusTcpConnects;
+extern MetricHistogram mModbusTcpTransaction;
+
+// Hasil satu blok: values berisi blk.count register jika status MB_FRAME_OK
+typedef void (*ModbusBlockHandler)(uint16_t block, uint8_t status, const uint16_t *values, uint32_t latencyUs, void *ctx);
+
+class ModbusTcpClient
+{
+public:
+  // Antrekan semua blok TCP dari snapshot untuk scan baru. blocks milik
+  // snapshot config: harus tetap hidup sampai poll() selesai / abort().
+  void startScan(const ModbusBlock *blocks, uint16_t blockCount, const ModbusTcpTarget *targets, uint8_t targetCount)
+  {
+    _blocks = blocks;
+    _blockCount = blockCount;
+    _targetCount = targetCount;
+    _scanning = true;
+    for (uint8_t i = 0; i < MODBUS_TCP_MAX_TARGETS; i++)
+    {
+      Conn &c = _conns[i];
+      uint32_t ip = i < targetCount ? targets[i].ip : 0;
+      uint16_t port = i < targetCount ? targets[i].port : 0;
+      if (c.ip != ip || c.port != port)
+      {
+        c.sock.stop(); // target berubah / dihapus dari config
+        c.ip = ip;
+        c.port = port;
+        c.retryAt = 0;
+      }
+      clearInflight(c);
+      c.next = nextBlock(i + 1, 0);
+    }
+  }
+
+  // Kirim, terima & cek timeout untuk semua target. true = scan belum selesai
+  bool poll(ModbusBlockHandler done, void *ctx)
+  {
+    if (!_scanning)
+      return false;
+    bool busy = false;
+    for (uint8_t i = 0; i < _targetCount; i++)
+      busy |= service(i, done, ctx);
+    if (!busy)
+      _scanning = false;
+    return busy;
+  }
+
+  // Scan dibatalkan (config berubah): balasan yang masih di jalan dibuang
+  // saat tiba karena TID-nya tidak lagi terdaftar
+  void abort()
+  {
+    for (Conn &c : _conns)
+      clearInflight(c);
+    _scanning = false;
+  }
+
+private:
+  struct Inflight
+  {
+    bool used;
+    uint16_t tid, block;
+    int64_t sentUs;
+  };
+
+  struct Conn
+  {
+    WiFiClient sock;
+    uint32_t ip;
+    uint16_t port;
+    uint32_t retryAt;
+    uint16_t next; // blok berikutnya yang belum dikirim
+    uint8_t inflightCount;
+    Inflight inflight[MODBUS_TCP_MAX_INFLIGHT];
+    uint8_t rx[MODBUS_TCP_ADU_MAX];
+    size_t rxLen;
+  };
+
+  uint16_t nextBlock(uint8_t target, uint16_t from) const
+  {
+    while (from < _blockCount && _blocks[from].target != target)
+      from++;
+    return from;
+  }
+
+  static void clearInflight(Conn &c)
+  {
+    for (Inflight &f : c.inflight)
+      f.used = false;
+    c.inflightCount = 0;
+  }
+
+  void fail(uint16_t block, ModbusBlockHandler done, void *ctx)
+  {
+    mModbusTcpFailures.inc();
+    done(block, MB_FRAME_TIMEOUT, NULL, 0, ctx);
+  }
+
+  void failInflight(Conn &c, ModbusBlockHandler done, void *ctx)
+  {
+    for (Inflight &f : c.inflight)
+    {
+      if (f.used)
+        fail(f.block, done, ctx);
+    }
+    clearInflight(c);
+  }
+
+  bool connect(Conn &c)
+  {
+    // retryAt 0 = tidak dalam backoff (tanpa ini, setelah millis() > 2^31
+    // target baru tidak pernah di-connect sampai millis() wrap)
+    if (c.retryAt && (int32_t)(millis() - c.retryAt) < 0)
+      return false; // masih dalam backoff
+    mModbusTcpConnects.inc();
+    c.sock.stop();
+    c.rxLen = 0;
+    if (!c.sock.connect(IPAddress(c.ip), c.port, MODBUS_TCP_CONNECT_TIMEOUT_MS))
+    {
+      c.retryAt = millis() + MODBUS_TCP_RETRY_MS;
+      return false;
+    }
+    c.retryAt = 0;
+    c.sock.setNoDelay(true);
+    return true;
+  }
+
+  bool service(uint8_t i, ModbusBlockHandler done, void *ctx)
+  {
+    Conn &c = _conns[i];
+    uint8_t target = i + 1;
+    if (c.next >= _blockCount && c.inflightCount == 0)
+      return false;
+
+    if (!c.sock.connected())
+    {
+      failInflight(c, done, ctx); // koneksi diputus peer di tengah scan
+      if (!connect(c))
+      {
+        // Target tidak terjangkau: sisa blok scan ini langsung gagal
+        for (; c.next < _blockCount; c.next = nextBlock(target, c.next + 1))
+          fail(c.next, done, ctx);
+        return false;
+      }
+    }
+
+    while (c.inflightCount < MODBUS_TCP_MAX_INFLIGHT && c.next < _blockCount)
+    {
+      send(c, c.next);
+      c.next = nextBlock(target, c.next + 1);
+    }
+
+    receive(c, done, ctx);
+
+    int64_t now = esp_timer_get_time();
+    for (Inflight &f : c.inflight)
+    {
+      if (f.used && now - f.sentUs > MODBUS_TCP_TIMEOUT_MS * 1000LL)
+      {
+        failInflight(c, done, ctx);
+        c.sock.stop(); // balasan terlambat akan mengacaukan stream: mulai bersih
+        break;
+      }
+    }
+    return c.next < _blockCount || c.inflightCount > 0;
+  }
+
+  void send(Conn &c, uint16_t block)
+  {
+    const ModbusBlock &b = _blocks[block];
+    uint8_t req[MODBUS_TCP_READ_REQUEST_LEN];
+    uint16_t tid = ++_tid;
+    modbusTcpBuildReadRequest(req, tid, b.unit, b.fc, b.start, b.count);
+
+    for (Inflight &f : c.inflight)
+    {
+      if (!f.used)
+      {
+        f.used = true;
+        f.tid = tid;
+        f.block = block;
+        f.sentUs = esp_timer_get_time();
+        c.inflightCount++;
+        break;
+      }
+    }
+    mModbusTcpRequests.inc();
+    c.sock.write(req, sizeof(req));
+  }
+
+  void receive(Conn &c, ModbusBlockHandler done, void *ctx)
+  {
+    int avail = c.sock.available();
+    while (avail > 0)
+    {
+      size_t want = sizeof(c.rx) - c.rxLen;
+      int n = c.sock.read(c.rx + c.rxLen, want < (size_t)avail ? want : avail);
+      if (n <= 0)
+        return;
+      c.rxLen += n;
+      avail -= n;
+
+      // Beberapa balasan pipelined bisa datang dalam satu segmen
+      while (true)
+      {
+        size_t frameLen = modbusTcpFrameLen(c.rx, c.rxLen, sizeof(c.rx));
+        if (frameLen == (size_t)-1)
+        {
+          failInflight(c, done, ctx);
+          c.sock.stop(); // bukan Modbus TCP
+          c.rxLen = 0;
+          return;
+        }
+        if (frameLen == 0)
+          break;
+        complete(c, frameLen, done, ctx);
+        memmove(c.rx, c.rx + frameLen, c.rxLen - frameLen);
+        c.rxLen -= frameLen;
+      }
+    }
+  }
+
+  void complete(Conn &c, size_t frameLen, ModbusBlockHandler done, void *ctx)
+  {
+    uint16_t tid = (c.rx[0] << 8) | c.rx[1];
+    for (Inflight &f : c.inflight)
+    {
+      if (!f.used || f.tid != tid)
+        continue;
+      const ModbusBlock &b = _blocks[f.block];
+      uint16_t values[MODBUS_BLOCK_MAX_REGS];
+      uint8_t status = modbusTcpParseReadBlock(c.rx, frameLen, b.unit, b.fc, b.count, values);
+      uint32_t latencyUs = (uint32_t)(esp_timer_get_time() - f.sentUs);
+      mModbusTcpTransaction.observeUs(latencyUs);
+      if (status != MB_FRAME_OK)
+        mModbusTcpFailures.inc();
+      f.used = false;
+      c.inflightCount--;
+      done(f.block, status, values, latencyUs, ctx);
+      return;
+    }
+    // TID tidak dikenal: balasan dari scan yang sudah dibatalkan
+  }
+
+  const ModbusBlock *_blocks = NULL;
+  uint16_t _blockCount = 0;
+  uint8_t _targetCount = 0;
+  bool _scanning = false;
+  Conn _conns[MODBUS_TCP_MAX_TARGETS];
+  uint16_t _tid = 0;
+};
+
+ModbusTcpClient modbusTcpClient;
+
+#endif
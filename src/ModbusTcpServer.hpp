@@ -0,0 +1,275 @@
+#ifndef MODBUS_TCP_SERVER_HPP
+#define MODBUS_TCP_SERVER_HPP
+
+#include <Arduino.h>
+#include <errno.h>
+#include "lwip/sockets.h"
+#include "esp_timer.h"
+#include "Metrics.hpp"
+#include "ModbusSlave.hpp"
+#include "ModbusGateway.hpp"
+#include "RuntimeConfig.hpp"
+
+// ============================================================================
+// MODBUS TCP SERVER (slave, port 502)
+// Frame MBAP dari socket lwIP (WiFi STA maupun Ethernet), PDU dilayani
+// langsung dari slaveRegisters (O(1) per request, tanpa lock akuisisi).
+// Dijalankan Task_ModbusTcpServer sendiri: task tidur di select() sampai ada
+// koneksi baru / data dari salah satu master, jadi request dijawab begitu
+// datang, bukan menunggu giliran di loop Task_NetworkManagement.
+// Sampai MODBUS_TCP_MAX_CLIENTS master dilayani bersamaan; master yang diam
+// lebih dari MODBUS_TCP_IDLE_MS dilepas supaya slot tidak habis oleh koneksi
+// setengah-mati (kabel dicabut tanpa FIN).
+// Unit ID yang dipetakan ke gateway diteruskan ke bus RS-485 (ModbusGateway):
+// request dicatat sebagai pending dan dijawab begitu Task_ModbusClient selesai,
+// sementara master lain tetap dilayani.
+// ============================================================================
+
+#define MODBUS_TCP_PORT 502
+#define MODBUS_TCP_MAX_CLIENTS 4
+#define MODBUS_TCP_IDLE_MS 60000
+#define MODBUS_TCP_SEND_TIMEOUT_MS 200
+#define MODBUS_TCP_FRAME_MAX (7 + MODBUS_PDU_MAX) // MBAP + PDU
+
+class ModbusTcpServer
+{
+public:
+  ModbusTcpServer() : _pending(modbusGateway)
+  {
+    for (Client &c : _clients)
+      c.fd = -1;
+  }
+
+  bool listening() const { return _listenFd >= 0; }
+
+  bool begin()
+  {
+    if (_listenFd >= 0)
+      return true;
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0)
+      return false;
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(MODBUS_TCP_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, MODBUS_TCP_MAX_CLIENTS) < 0)
+    {
+      close(fd);
+      return false;
+    }
+    _listenFd = fd;
+    Serial.printf("[MB] Modbus TCP server listening on %d\n", MODBUS_TCP_PORT);
+    return true;
+  }
+
+  // Slave TCP dimatikan dari web: port ditutup, master yang terhubung diputus
+  void end()
+  {
+    for (Client &c : _clients)
+      drop(c);
+    if (_listenFd >= 0)
+    {
+      close(_listenFd);
+      _listenFd = -1;
+    }
+  }
+
+  // Tidur sampai ada socket siap (maks timeoutMs), lalu layani semuanya
+  void waitAndService(const RuntimeConfig *cfg, uint32_t timeoutMs)
+  {
+    _cfg = cfg;
+    if (_pending.count())
+      timeoutMs = 1; // cek balasan gateway tiap tick
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(_listenFd, &readable);
+    int maxFd = _listenFd;
+    for (Client &c : _clients)
+    {
+      if (c.fd >= 0)
+      {
+        FD_SET(c.fd, &readable);
+        maxFd = max(maxFd, c.fd);
+      }
+    }
+
+    struct timeval tv;
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+    int ready = select(maxFd + 1, &readable, NULL, NULL, &tv);
+    if (ready < 0)
+    {
+      end(); // netif turun / socket rusak: buka ulang di putaran berikutnya
+      return;
+    }
+
+    if (FD_ISSET(_listenFd, &readable))
+      acceptClient();
+
+    uint32_t now = millis();
+    for (Client &c : _clients)
+    {
+      if (c.fd < 0)
+        continue;
+      if (FD_ISSET(c.fd, &readable))
+        service(c);
+      else if (now - c.lastRxMs > MODBUS_TCP_IDLE_MS)
+        drop(c);
+    }
+    _pending.deliver(esp_timer_get_time(), deliverGateway, this);
+  }
+
+private:
+  struct Client
+  {
+    int fd;
+    uint32_t lastRxMs;
+    uint8_t buf[MODBUS_TCP_FRAME_MAX];
+    size_t len;
+  };
+
+  void acceptClient()
+  {
+    int fd = lwip_accept(_listenFd, NULL, NULL);
+    if (fd < 0)
+      return;
+
+    Client *slot = NULL;
+    for (Client &c : _clients)
+    {
+      if (c.fd < 0)
+      {
+        slot = &c;
+        break;
+      }
+    }
+    if (!slot)
+    {
+      close(fd); // penuh: master baru ditolak, yang lama tetap dilayani
+      return;
+    }
+
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    // Master yang tidak membaca balasan tidak boleh menahan master lain
+    struct timeval tv = {0, MODBUS_TCP_SEND_TIMEOUT_MS * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    slot->fd = fd;
+    slot->len = 0;
+    slot->lastRxMs = millis();
+  }
+
+  void drop(Client &c)
+  {
+    if (c.fd >= 0)
+      close(c.fd);
+    c.fd = -1;
+    c.len = 0;
+    _pending.dropClient(&c - _clients);
+  }
+
+  void service(Client &c)
+  {
+    int n = recv(c.fd, c.buf + c.len, sizeof(c.buf) - c.len, MSG_DONTWAIT);
+    if (n <= 0)
+    {
+      if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        drop(c); // FIN / RST dari master
+      return;
+    }
+    int64_t rxUs = esp_timer_get_time(); // latency dihitung dari frame masuk
+    c.len += n;
+    c.lastRxMs = millis();
+
+    // Satu segmen TCP bisa berisi beberapa request (pipelining master)
+    while (c.len >= 7)
+    {
+      size_t frameLen = 6 + ((c.buf[4] << 8) | c.buf[5]);
+      if (c.buf[2] || c.buf[3] || frameLen < 8 || frameLen > sizeof(c.buf))
+      {
+        drop(c); // bukan Modbus (protocol ID != 0 / panjang rusak)
+        return;
+      }
+      if (c.len < frameLen)
+        break;
+      if (!reply(c, frameLen, rxUs))
+      {
+        drop(c);
+        return;
+      }
+      memmove(c.buf, c.buf + frameLen, c.len - frameLen);
+      c.len -= frameLen;
+    }
+  }
+
+  bool reply(Client &c, size_t frameLen, int64_t rxUs)
+  {
+    if (_cfg && _cfg->gatewayUnit(c.buf[6]))
+      return forward(c, frameLen, rxUs);
+
+    uint8_t pdu[MODBUS_PDU_MAX];
+    size_t pduLen = slaveRegisters.processPdu(c.buf + 7, frameLen - 7, pdu, _cfg);
+    if (pduLen == 0)
+      return true;
+    if (!sendFrame(c, c.buf, pdu, pduLen))
+      return false;
+    mSlaveRequestTcp.observeUs((uint32_t)(esp_timer_get_time() - rxUs));
+    return true;
+  }
+
+  // MBAP dari request (TID, protocol, unit) + PDU balasan
+  bool sendFrame(Client &c, const uint8_t *mbap, const uint8_t *pdu, size_t pduLen)
+  {
+    uint8_t out[MODBUS_TCP_FRAME_MAX];
+    memcpy(out, mbap, 4); // transaction ID + protocol ID
+    out[4] = (pduLen + 1) >> 8;
+    out[5] = (pduLen + 1) & 0xFF;
+    out[6] = mbap[6]; // unit ID
+    memcpy(out + 7, pdu, pduLen);
+    if (send(c.fd, out, 7 + pduLen, 0) != (int)(7 + pduLen))
+      return false;
+
+    mSlaveRequests.inc();
+    if (pdu[0] & 0x80)
+      mSlaveExceptions.inc();
+    return true;
+  }
+
+  // Antrekan ke gateway; penuh -> exception "device busy" supaya master retry
+  bool forward(Client &c, size_t frameLen, int64_t rxUs)
+  {
+    if (!_pending.add(&c - _clients, c.buf, frameLen, _cfg->gatewayCacheMs, rxUs))
+    {
+      uint8_t pdu[2];
+      ModbusGateway::exception(pdu, c.buf[7], MODBUS_EX_DEVICE_BUSY);
+      return sendFrame(c, c.buf, pdu, sizeof(pdu));
+    }
+    if (Task_Core1_ModbusClient)
+      xTaskNotifyGive(Task_Core1_ModbusClient); // bangunkan pemilik bus
+    return true;
+  }
+
+  // Balasan gateway yang sudah selesai (atau cache hit), timeout -> 0x0B
+  static void deliverGateway(uint8_t client, const uint8_t *mbap, const uint8_t *pdu, size_t pduLen, bool timedOut, int64_t rxUs, void *ctx)
+  {
+    ModbusTcpServer *self = (ModbusTcpServer *)ctx;
+    Client &c = self->_clients[client];
+    if (!self->sendFrame(c, mbap, pdu, pduLen))
+      self->drop(c);
+    else if (!timedOut)
+      mSlaveRequestGateway.observeUs((uint32_t)(esp_timer_get_time() - rxUs));
+  }
+
+  int _listenFd = -1;
+  Client _clients[MODBUS_TCP_MAX_CLIENTS];
+  ModbusGatewayPending _pending;
+  const RuntimeConfig *_cfg = NULL;
+};
+
+ModbusTcpServer modbusTcpServer;
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef NET_PARSE_HPP
+#define NET_PARSE_HPP
+
+#include <stdlib.h>
+
+// ============================================================================
+// NET PARSE (teks config jaringan -> angka)
+// Tanpa Arduino.h seperti SignalMath.hpp, supaya bisa diuji di host.
+// ============================================================================
+
+struct IpAddressSplit
+{
+  int ip[5];
+};
+
+// "192.168.1.10" (pemisah '.' atau ',') -> ip[0..3]; maks 5 field, field
+// kosong / bukan angka = 0 (sama seperti String::toInt())
+inline IpAddressSplit parsingIP(const char *data)
+{
+  IpAddressSplit result = {};
+  int j = 0;
+  const char *start = data;
+  for (const char *p = data;; p++)
+  {
+    if (*p == '\0' || *p == '.' || *p == ',')
+    {
+      if (j < 5)
+        result.ip[j++] = (int)strtol(start, NULL, 10);
+      if (*p == '\0')
+        break;
+      start = p + 1;
+    }
+  }
+  return result;
+}
+
+#endif
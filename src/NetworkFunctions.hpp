@@ -7,27 +7,17 @@
 #include <WiFiClientSecure.h>
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
-#include <SD.h>
 #include <DNSServer.h>
 #include "config.hpp"
-#include <Ethernet.h>
-class MyEthernetServer : public EthernetServer
-{
-public:
-  // Gunakan constructor dari parent
-  MyEthernetServer(uint16_t port) : EthernetServer(port) {}
-
-  // Implementasi begin() sesuai aturan ESP32 Server Class
-  void begin(uint16_t port = 0) override
-  {
-    EthernetServer::begin(); // Panggil fungsi begin() asli milik library Ethernet
-  }
-};
+#include "SharedSpiSD.hpp"
+#include "SpiBusManager.hpp"
+#include "Metrics.hpp"
+#include "CommandQueue.hpp"
+#include "NetParse.hpp"
+#include <esp32_w5500.h>
 // Forward declarations
 extern PubSubClient mqtt;
 extern WiFiClient esp32;
-// EthernetServer ethServer(80);
-MyEthernetServer ethServer(80);
 extern DNSServer dnsServer;
 extern const byte DNS_PORT;
 extern bool dnsStarted;
@@ -37,14 +27,72 @@ extern bool flagGetJobNum;
 extern String jobNum;
 extern ErrorBlinker errorBlinker;
 extern ErrorMessages errorMessages;
+extern SemaphoreHandle_t sdMutex;
 
-extern String getTimeNow();
 extern String getTimeDateNow();
 
 // WiFi Connection State
 bool wifiConnected = false;
 bool wifiConnecting = false;
 bool apReady = false;
+bool ethReady = false; // true jika driver esp_eth W5500 berhasil di-install
+unsigned long ethConfigMillis = 0; // waktu ETH.config(), acuan timeout DHCP
+
+// Statistik RX W5500, dihitung ulang oleh Task_NetworkManagement lewat updateEthRxStats()
+float ethRxFramesPerSec = 0;
+float ethRxCpuPercent = 0; // persen waktu satu core yang dipakai task RX w5500
+uint32_t ethRxDropped = 0;
+uint32_t ethRxPoolFree = 0;
+
+void updateEthRxStats()
+{
+  static eth_w5500_stats_t prev = {};
+  static unsigned long prevMs = 0;
+  eth_w5500_stats_t now;
+
+  if (!ethReady || !ETH.rxStats(now))
+    return;
+
+  unsigned long nowMs = millis();
+  if (prevMs != 0 && nowMs > prevMs)
+  {
+    float dt = (nowMs - prevMs) / 1000.0f;
+    ethRxFramesPerSec = (now.rx_frames - prev.rx_frames) / dt;
+    ethRxCpuPercent = (float)(now.rx_busy_us - prev.rx_busy_us) / (dt * 10000.0f); // us -> %
+  }
+  ethRxDropped = now.rx_dropped;
+  ethRxPoolFree = now.rx_pool_free;
+
+  prev = now;
+  prevMs = nowMs;
+}
+
+// Clock SPI W5500 mengikuti aktivitas SD (ETH_SPI_CLOCK_* di config.hpp).
+// Mutex menjaga urutan: begitu hook grant kembali, clock pasti sudah rendah,
+// dan updateEthSpiClock() tidak bisa menaikkannya di tengah lease SD.
+SemaphoreHandle_t ethClockMutex = NULL;
+
+// Hook SpiBusManager: jalan di task yang baru mendapat lease SD
+void ethClockForSd()
+{
+  if (!ethReady)
+    return;
+  xSemaphoreTake(ethClockMutex, portMAX_DELAY);
+  ETH.setSpiClock(ETH_SPI_CLOCK_SD_MHZ);
+  xSemaphoreGive(ethClockMutex);
+}
+
+// Task_NetworkManagement: naikkan lagi setelah SD idle
+void updateEthSpiClock()
+{
+  if (!ethReady || ETH.spiClockMHz() == ETH_SPI_CLOCK_MHZ)
+    return;
+  xSemaphoreTake(ethClockMutex, portMAX_DELAY);
+  if (spiBus.idleMs() >= ETH_SPI_SD_IDLE_MS)
+    ETH.setSpiClock(ETH_SPI_CLOCK_MHZ);
+  xSemaphoreGive(ethClockMutex);
+}
+
 unsigned long wifiConnectStartTime = 0;
 // =================================================================
 // PERUBAHAN 1: Ubah timeout ke 10 detik (sesuai permintaan)
@@ -57,74 +105,94 @@ const unsigned long WIFI_CONNECT_TIMEOUT = 10000; // 10 detik timeout (sebelumny
 bool staConnectionAttemptFailed = false; // Flag untuk berhenti mencoba koneksi STA
 
 // Function declarations
-IpAddressSplit parsingIP(String data);
 void mqttCallback(char *topic, byte *payload, unsigned int length);
-void checkWiFi(int timeout);
+void checkWiFi(bool wifiMode, int timeout);
 void get_JobNum();
 void startDNSServer();
 void stopDNSServer();
 void configNetwork();
 void configProtocol();
+void applyMqttServer(const char *host, int port);
 void sendDataMQTT(String dataSend, String publishTopic, int intervalSend);
-void sendDataHTTP(String data, String serverPath, String httpUsername, String httpPassword, int intervalSend);
-void saveToSD(String data);
+void sendDataHTTP(const char *data, size_t len, const char *serverPath, const char *httpUsername, const char *httpPassword, int intervalSend);
+void saveToSD(const char *data);
 void sendBackupData();
 
 // Implementation
-IpAddressSplit parsingIP(String data)
+// Perintah dari broker, semua lewat commandQueue (dieksekusi Task_ModbusClient):
+//   {"Pompa 1": true}                          -> DO lokal by name (format lama)
+//   {"do":"Pompa 1","value":true}              -> satu perintah
+//   {"unit":1,"fc":6,"addr":100,"value":123}   -> register perangkat RS-485
+//   {"commands":[{..},{..}]}                   -> beberapa perintah berurutan
+// Nama DO dicocokkan ke snapshot yang dipegang Task_NetworkManagement selama
+// mqtt.loop() (callback jalan di task itu).
+const RuntimeConfig *mqttConfig = NULL;
+
+static void mqttSubmit(const WriteCommand &cmd)
 {
-  IpAddressSplit result;
-  int start = 0, j = 0;
-  int len = data.length();
-  for (int i = 0; i <= len; i++)
-  {
-    if (i == len || data.charAt(i) == '.' || data.charAt(i) == ',')
-    {
-      if (j < 5)
-      {
-        result.ip[j] = data.substring(start, i).toInt();
-        j++;
-      }
-      start = i + 1;
-    }
-  }
-  return result;
+  uint32_t id = commandQueue.submit(cmd);
+  if (id)
+    Serial.printf("[MQTT] command #%u %s\n", id, commandQueue.ackStatus(cmd, id));
+  else
+    Serial.println("[MQTT] command rejected");
+}
+
+static void mqttSubmitCommand(JsonObjectConst o)
+{
+  WriteCommand cmd;
+  if (commandFromJson(mqttConfig, o, CMD_SRC_MQTT, cmd))
+    mqttSubmit(cmd);
+  else
+    Serial.println("[MQTT] command rejected");
 }
 
 void mqttCallback(char *topic, byte *payload, unsigned int length)
 {
-  Serial.println("MQTT Message Received");
-  String command = "";
-  for (int j = 0; j < length; j++)
-    command += (char)payload[j];
-  Serial.println(command);
-
-  StaticJsonDocument<200> commandJson;
-  DeserializationError error = deserializeJson(commandJson, command);
-  if (error)
+  StaticJsonDocument<1024> commandJson;
+  DeserializationError error = deserializeJson(commandJson, payload, length);
+  if (error || !commandJson.is<JsonObject>() || !mqttConfig)
   {
     Serial.println("Failed to parse JSON");
     return;
   }
+  JsonObjectConst root = commandJson.as<JsonObjectConst>();
+
+  if (root.containsKey("commands"))
+  {
+    for (JsonObjectConst o : root["commands"].as<JsonArrayConst>())
+      mqttSubmitCommand(o);
+    return;
+  }
+  if (root.containsKey("do") || root.containsKey("unit"))
+  {
+    mqttSubmitCommand(root);
+    return;
+  }
 
   for (byte i = 1; i < jumlahOutputDigital + 1; i++)
   {
-    if (commandJson.containsKey(digitalOutput[i].name))
-    {
-      Serial.print(digitalOutput[i].name + ": ");
-      bool statusDO = commandJson[digitalOutput[i].name];
-      Serial.println(statusDO);
-      digitalWrite(2, commandJson[digitalOutput[i].name]);
-    }
+    const char *name = mqttConfig->dout[i].name;
+    JsonVariantConst v = root[name];
+    if (!name[0] || v.isNull())
+      continue;
+    WriteCommand cmd = {};
+    cmd.target = CMD_TARGET_DO;
+    cmd.source = CMD_SRC_MQTT;
+    cmd.fc = 5;
+    cmd.addr = i;
+    cmd.count = 1;
+    cmd.values[0] = v.as<bool>();
+    mqttSubmit(cmd);
   }
 }
 
 // =================================================================
 // PERUBAHAN 3: Modifikasi checkWiFi() secara keseluruhan
 // =================================================================
-void checkWiFi(int timeout)
+// wifiMode dari snapshot (!cfg->ethernet), bukan String networkSettings
+void checkWiFi(bool wifiMode, int timeout)
 {
-  if (networkSettings.networkMode == "WiFi")
+  if (wifiMode)
   {
     if (staConnectionAttemptFailed)
     {
@@ -141,7 +209,7 @@ void checkWiFi(int timeout)
       if (status != WL_CONNECTED && !wifiConnecting)
       {
         errorBlinker.trigger(5, 500);
-        errorMessages.addMessage(getTimeNow() + " - WiFi Disconnected, attempting reconnect...");
+        errorMessages.addTimedMessage("WiFi Disconnected, attempting reconnect...");
 
         Serial.println("WiFi disconnected. Status: " + String(status));
         wifiConnecting = true;
@@ -263,16 +331,24 @@ void get_JobNum()
   {
     Serial.print(F("Error code: "));
     Serial.println(httpResponseCode);
-    errorMessages.addMessage(getTimeNow() + " - Failed to get Job Number from ERP");
+    errorMessages.addTimedMessage("Failed to get Job Number from ERP");
   }
   http.end();
 }
 
+// Tunggu AP punya IP (polling, bukan delay tetap). Biasanya langsung true.
+bool waitSoftAP(uint32_t timeoutMs)
+{
+  unsigned long start = millis();
+  while (WiFi.softAPIP() == IPAddress(0, 0, 0, 0) && millis() - start < timeoutMs)
+    delay(10);
+  return WiFi.softAPIP() != IPAddress(0, 0, 0, 0);
+}
+
 void startDNSServer()
 {
   if (!dnsStarted && apReady)
   {
-    delay(500); // Tunggu AP fully ready
     dnsServer.start(DNS_PORT, "*", WiFi.softAPIP());
     dnsStarted = true;
     ESP_LOGI("DNS", "DNS server started, redirecting to %s", WiFi.softAPIP().toString().c_str());
@@ -307,7 +383,6 @@ void configNetwork()
     Serial.println("[1/7] Resetting WiFi...");
     WiFi.disconnect(true);
     WiFi.mode(WIFI_OFF);
-    delay(1000); // PENTING: Kasih waktu WiFi fully off
 
     // =====================================================================
     // STEP 2: Set MAC Address (SEBELUM WiFi ON)
@@ -329,7 +404,6 @@ void configNetwork()
     // =====================================================================
     Serial.println("[3/7] Setting WiFi mode to AP+STA...");
     WiFi.mode(WIFI_AP_STA);
-    delay(500);
     Serial.println("  ✓ Mode set to AP+STA");
 
     // =====================================================================
@@ -427,18 +501,15 @@ void configNetwork()
 
     if (apStarted)
     {
-      delay(1000); // PENTING: Tunggu AP fully initialized
-
       // Verify AP is actually running
-      if (WiFi.softAPIP() == IPAddress(0, 0, 0, 0))
+      if (!waitSoftAP(1000))
       {
         Serial.println("  ✗ AP Failed - IP is 0.0.0.0");
         Serial.println("  → Retrying AP start...");
         WiFi.softAPdisconnect(true);
-        delay(500);
         apStarted = WiFi.softAP(networkSettings.apSsid.c_str(),
                                 networkSettings.apPassword.c_str(), 6, 0, 4);
-        delay(1000);
+        waitSoftAP(1000);
       }
 
       if (WiFi.softAPIP() != IPAddress(0, 0, 0, 0))
@@ -478,16 +549,16 @@ void configNetwork()
       Serial.println("  Using Static IP");
       IpAddressSplit hasilParsing;
 
-      hasilParsing = parsingIP(networkSettings.ipAddress);
+      hasilParsing = parsingIP(networkSettings.ipAddress.c_str());
       IPAddress localIP(hasilParsing.ip[0], hasilParsing.ip[1], hasilParsing.ip[2], hasilParsing.ip[3]);
 
-      hasilParsing = parsingIP(networkSettings.subnetMask);
+      hasilParsing = parsingIP(networkSettings.subnetMask.c_str());
       IPAddress subnetIP(hasilParsing.ip[0], hasilParsing.ip[1], hasilParsing.ip[2], hasilParsing.ip[3]);
 
-      hasilParsing = parsingIP(networkSettings.ipGateway);
+      hasilParsing = parsingIP(networkSettings.ipGateway.c_str());
       IPAddress gatewayIP(hasilParsing.ip[0], hasilParsing.ip[1], hasilParsing.ip[2], hasilParsing.ip[3]);
 
-      hasilParsing = parsingIP(networkSettings.ipDNS);
+      hasilParsing = parsingIP(networkSettings.ipDNS.c_str());
       IPAddress dnsIP(hasilParsing.ip[0], hasilParsing.ip[1], hasilParsing.ip[2], hasilParsing.ip[3]);
 
       if (WiFi.config(localIP, gatewayIP, subnetIP, dnsIP))
@@ -553,9 +624,8 @@ void configNetwork()
     bool apStarted = WiFi.softAP(networkSettings.apSsid.c_str(),
                                  networkSettings.apPassword.c_str(), 6, 0, 4);
 
-    if (apStarted)
+    if (apStarted && waitSoftAP(1000))
     {
-      delay(1000);
       apReady = true;
       // Serial.println("  ✓ AP Started");
       Serial.printf("    AP IP: %s\n", WiFi.softAPIP().toString().c_str());
@@ -570,112 +640,93 @@ void configNetwork()
     // =====================================================================
     // STEP 2: Hardware Reset W5500
     // =====================================================================
-    // Serial.println("[2/5] Resetting W5500 chip...");
-    pinMode(ETH_RST, OUTPUT);
-    digitalWrite(ETH_RST, LOW);
-    delay(100);
-    digitalWrite(ETH_RST, HIGH);
-    delay(200);
-    // Serial.println("  ✓ W5500 reset complete");
+    // Hanya sekali: reset chip saat driver sudah jalan akan merusak state MAC RAW
+    if (!ethReady)
+    {
+      pinMode(ETH_RST, OUTPUT);
+      // Datasheet W5500: RSTn low min 500 us, PLL lock maks 1 ms
+      digitalWrite(ETH_RST, LOW);
+      delay(1);
+      digitalWrite(ETH_RST, HIGH);
+      delay(2);
+    }
 
     // =====================================================================
-    // STEP 3: Initialize SPI for W5500
+    // STEP 3: Install driver esp_eth W5500 (MAC RAW -> lwIP netif)
+    // Bus SPI sudah di-init di setup() dan dipakai bersama SD Card
     // =====================================================================
-    // Serial.println("[3/5] Initializing SPI...");
-    // SPI sudah di-init di setup(), tapi pastikan dengan pinout yang benar
-    SPI.begin(ETH_CLK, ETH_MISO, ETH_MOSI, -1); // -1 karena CS manual
-    SPI.setDataMode(SPI_MODE0);
-    Serial.printf("  ✓ SPI initialized (CLK:%d, MISO:%d, MOSI:%d, CS:%d)\n",
-                  ETH_CLK, ETH_MISO, ETH_MOSI, ETH_CS);
+    Serial.println("[3/5] Starting W5500 esp_eth driver...");
+    if (!ethReady)
+    {
+      if (!ethClockMutex)
+        ethClockMutex = xSemaphoreCreateMutex();
+      ethReady = ETH.begin(ETH_MISO, ETH_MOSI, ETH_CLK, ETH_CS, ETH_INT,
+                           ETH_SPI_CLOCK_MHZ, SHARED_SPI_HOST, mac);
+      if (ethReady)
+        spiBus.setGrantHook(ethClockForSd);
+    }
+    if (!ethReady)
+    {
+      ESP_LOGE("Ethernet", "  ✗ W5500 chip not found / driver install failed!");
+      errorMessages.addTimedMessage("W5500 hardware not found");
+      errorBlinker.trigger(5, 200);
+    }
+    else
+    {
+      Serial.printf("  ✓ W5500 driver started (CLK:%d, MISO:%d, MOSI:%d, CS:%d, INT:%d, %d MHz, %d MHz during SD)\n",
+                    ETH_CLK, ETH_MISO, ETH_MOSI, ETH_CS, ETH_INT, ETH_SPI_CLOCK_MHZ, ETH_SPI_CLOCK_SD_MHZ);
+    }
 
     // =====================================================================
-    // STEP 4: Initialize Ethernet with W5500
+    // STEP 4: IP Configuration (DHCP / Static) lewat esp_netif
     // =====================================================================
-    Serial.println("[4/5] Initializing Ethernet...");
-    Ethernet.init(ETH_CS); // Set CS pin untuk W5500
-    // ip static
-    // IPAddress localIP(10, 22, 7, 3);      // IP Requested
-    // IPAddress gatewayIP(10, 22, 7, 1);    // Asumsi Gateway default
-    // IPAddress subnetIP(255, 255, 255, 0); // Subnet standard
-    // IPAddress dnsIP(8, 8, 8, 8);          // DNS Google
-
-    // // Update variable global agar tampilan di web/serial benar
-    // networkSettings.ipAddress = localIP.toString();
-    // networkSettings.ipGateway = gatewayIP.toString();
-    // networkSettings.subnetMask = subnetIP.toString();
-    // networkSettings.ipDNS = dnsIP.toString();
-    // networkSettings.dhcpMode = "Static (Forced)";
-
-    // Serial.println("  [FORCE] Starting Ethernet with Static IP: 10.22.7.3 ...");
-
-    // // Syntax: begin(mac, ip, dns, gateway, subnet)
-    // Ethernet.begin(mac, localIP, dnsIP, gatewayIP, subnetIP);
-    // delay(1000); // Beri waktu untuk inisialisasi PHY
-
-    // Serial.println("  ✓ Ethernet configured manually");
-    // ini dhcp
-    // Parse IP addresses
+    Serial.println("[4/5] Configuring Ethernet IP...");
     IpAddressSplit hasilParsing;
-    hasilParsing = parsingIP(networkSettings.ipAddress);
+    hasilParsing = parsingIP(networkSettings.ipAddress.c_str());
     IPAddress localIP(hasilParsing.ip[0], hasilParsing.ip[1],
                       hasilParsing.ip[2], hasilParsing.ip[3]);
 
-    hasilParsing = parsingIP(networkSettings.subnetMask);
+    hasilParsing = parsingIP(networkSettings.subnetMask.c_str());
     IPAddress subnetIP(hasilParsing.ip[0], hasilParsing.ip[1],
                        hasilParsing.ip[2], hasilParsing.ip[3]);
 
-    hasilParsing = parsingIP(networkSettings.ipGateway);
+    hasilParsing = parsingIP(networkSettings.ipGateway.c_str());
     IPAddress gatewayIP(hasilParsing.ip[0], hasilParsing.ip[1],
                         hasilParsing.ip[2], hasilParsing.ip[3]);
 
-    hasilParsing = parsingIP(networkSettings.ipDNS);
+    hasilParsing = parsingIP(networkSettings.ipDNS.c_str());
     IPAddress dnsIP(hasilParsing.ip[0], hasilParsing.ip[1],
                     hasilParsing.ip[2], hasilParsing.ip[3]);
 
-    if (networkSettings.dhcpMode == "DHCP")
+    if (ethReady)
     {
-      Serial.println("  Starting Ethernet with DHCP...");
-      // 10s timeout, 4s response timeout
-      if (Ethernet.begin(mac, 10000, 4000) == 0)
+      if (networkSettings.dhcpMode == "DHCP")
       {
-        ESP_LOGE("Ethernet", "  ✗ Failed to configure Ethernet using DHCP");
-        errorMessages.addMessage(getTimeNow() + " - Failed to start Ethernet (DHCP)");
+        Serial.println("  Starting Ethernet with DHCP...");
+        ETH.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
       }
       else
       {
-        Serial.println("  ✓ Ethernet started with DHCP");
-        Serial.printf("    IP: %s\n", Ethernet.localIP().toString().c_str());
+        Serial.println("  Starting Ethernet with Static IP...");
+        ETH.config(localIP, gatewayIP, subnetIP, dnsIP);
       }
+      // DHCP berjalan di background lwIP, tidak ditunggu di sini.
+      // Timeout DHCP dilaporkan oleh Task_NetworkManagement.
+      ethConfigMillis = millis();
     }
-    else
-    {
-      Serial.println("  Starting Ethernet with Static IP...");
-      Ethernet.begin(mac, localIP, dnsIP, gatewayIP, subnetIP);
-      delay(1000);
-      Serial.println("  ✓ Ethernet configured with static IP");
-    }
-    // */ //batas dhcp dikomen saja ini
+
     // =====================================================================
-    // STEP 5: Verify Ethernet Hardware & Link Status
+    // STEP 5: Verify Link Status
     // =====================================================================
     Serial.println("[5/5] Verifying Ethernet connection...");
-
-    if (Ethernet.hardwareStatus() == EthernetNoHardware)
-    {
-      ESP_LOGE("Ethernet", "  ✗ W5500 chip not found!");
-      errorMessages.addMessage(getTimeNow() + " - W5500 hardware not found");
-      errorBlinker.trigger(5, 200);
-    }
-    else
+    if (ethReady)
     {
-      Serial.println("  ✓ W5500 chip detected");
-
-      if (Ethernet.linkStatus() == LinkOFF)
+      if (!ETH.linkUp())
       {
         ESP_LOGW("Ethernet", "  ⚠ Ethernet cable not connected");
-        errorMessages.addMessage(getTimeNow() + " - Ethernet cable disconnected");
+        errorMessages.addTimedMessage("Ethernet cable disconnected");
       }
-      else if (Ethernet.linkStatus() == LinkON)
+      else
       {
         Serial.println("  ✓ Ethernet cable connected");
       }
@@ -697,16 +748,14 @@ void configNetwork()
     Serial.println("ETHERNET CONFIGURATION COMPLETE");
     Serial.println("=================================");
     Serial.printf("MAC Address: %s\n", networkSettings.macAddress.c_str());
-    Serial.printf("IP Address:  %s\n", Ethernet.localIP().toString().c_str());
-    Serial.printf("Subnet Mask: %s\n", Ethernet.subnetMask().toString().c_str());
-    Serial.printf("Gateway:     %s\n", Ethernet.gatewayIP().toString().c_str());
-    Serial.printf("DNS Server:  %s\n", Ethernet.dnsServerIP().toString().c_str());
-    Serial.printf("Link Status: %s\n",
-                  Ethernet.linkStatus() == LinkON ? "CONNECTED" : "DISCONNECTED");
+    Serial.printf("IP Address:  %s\n", ETH.localIP().toString().c_str());
+    Serial.printf("Subnet Mask: %s\n", ETH.subnetMask().toString().c_str());
+    Serial.printf("Gateway:     %s\n", ETH.gatewayIP().toString().c_str());
+    Serial.printf("DNS Server:  %s\n", ETH.dnsIP().toString().c_str());
+    Serial.printf("Link Status: %s\n", ETH.linkUp() ? "CONNECTED" : "DISCONNECTED");
     Serial.println("=================================\n");
-    ethServer.begin();
-    Serial.println("[INFO] AsyncWebServer will handle Ethernet requests");
-    Serial.printf("  Access via Ethernet: http://%s\n", Ethernet.localIP().toString().c_str());
+    Serial.println("[INFO] AsyncWebServer will handle Ethernet requests (lwIP)");
+    Serial.printf("  Access via Ethernet: http://%s\n", ETH.localIP().toString().c_str());
     Serial.printf("  Access via WiFi AP:  http://%s\n", WiFi.softAPIP().toString().c_str());
   }
 }
@@ -714,10 +763,28 @@ void configNetwork()
 void configProtocol()
 {
   if (networkSettings.protocolMode == "MQTT")
-  {
-    mqtt.setServer(networkSettings.endpoint.c_str(), networkSettings.port);
-    mqtt.setCallback(mqttCallback);
-  }
+    applyMqttServer(networkSettings.endpoint.c_str(), networkSettings.port);
+}
+
+// PubSubClient hanya menyimpan pointer host, jadi host disalin ke buffer
+// statis (String networkSettings bisa di-realloc saat form disimpan).
+// Dipanggil lagi oleh Task_NetworkManagement saat config berubah.
+void applyMqttServer(const char *host, int port)
+{
+  static char mqttHost[128] = "";
+  static int mqttPort = -1;
+  if (mqttPort == port && strcmp(mqttHost, host) == 0)
+    return;
+
+  if (mqtt.connected())
+    mqtt.disconnect(); // reconnect berikutnya memakai broker baru
+  strlcpy(mqttHost, host, sizeof(mqttHost));
+  mqttPort = port;
+
+  // WiFiClient adalah socket lwIP, jadi berjalan di WiFi STA maupun Ethernet
+  mqtt.setClient(esp32);
+  mqtt.setServer(mqttHost, mqttPort);
+  mqtt.setCallback(mqttCallback);
 }
 
 void sendDataMQTT(String dataSend, String publishTopic, int intervalSend)
@@ -736,7 +803,8 @@ void sendDataMQTT(String dataSend, String publishTopic, int intervalSend)
   }
 }
 
-void sendDataHTTP(String data, String serverPath, String httpUsername, String httpPassword, int intervalSend)
+// Payload dari buffer caller (sendString statis), tidak disalin ke String
+void sendDataHTTP(const char *data, size_t len, const char *serverPath, const char *httpUsername, const char *httpPassword, int intervalSend)
 {
   if (millis() - sendTime >= (intervalSend * 1000))
   {
@@ -754,11 +822,16 @@ void sendDataHTTP(String data, String serverPath, String httpUsername, String ht
     if (WiFi.status() == WL_CONNECTED)
     {
       https.begin(client, serverPath);
-      ESP_LOGI("HTTP", "Sending to: %s", serverPath.c_str());
-      https.setAuthorization(httpUsername.c_str(), httpPassword.c_str());
+      ESP_LOGI("HTTP", "Sending to: %s", serverPath);
+      https.setAuthorization(httpUsername, httpPassword);
       https.addHeader("Content-Type", "application/json");
       https.setTimeout(10000);
-      int httpResponseSent = https.POST(data);
+      int64_t postStart = esp_timer_get_time();
+      traceBegin(TR_HTTP_POST);
+      int httpResponseSent = https.POST((uint8_t *)data, len);
+      traceEnd(TR_HTTP_POST);
+      mHttpSend.observeUs((uint32_t)(esp_timer_get_time() - postStart));
+      mHttpSends.inc();
       ESP_LOGI("HTTP", "Response code: %d", httpResponseSent);
 
       if (httpResponseSent >= 200 && httpResponseSent <= 204)
@@ -770,20 +843,27 @@ void sendDataHTTP(String data, String serverPath, String httpUsername, String ht
       }
       else
       {
+        mHttpFailures.inc();
         errorBlinker.trigger(4, 100);
         ESP_LOGW("HTTP", "✗ Failed to send data");
-        errorMessages.addMessage(getTimeNow() + " - Failed to send data to API");
+        errorMessages.addTimedMessage("Failed to send data to API");
         networkSettings.connStatus = "Not Connected";
       }
       https.end();
     }
-    else if (networkSettings.networkMode == "Ethernet")
+    else if (ethReady && ETH.hasIP()) // ethReady hanya true di mode Ethernet
     {
+      // HTTPClient memakai socket lwIP, routing otomatis lewat netif Ethernet
       https.begin(client, serverPath);
-      https.setAuthorization(httpUsername.c_str(), httpPassword.c_str());
+      https.setAuthorization(httpUsername, httpPassword);
       https.addHeader("Content-Type", "application/json");
       https.setTimeout(10000);
-      int httpResponseSent = https.POST(data);
+      int64_t postStart = esp_timer_get_time();
+      traceBegin(TR_HTTP_POST);
+      int httpResponseSent = https.POST((uint8_t *)data, len);
+      traceEnd(TR_HTTP_POST);
+      mHttpSend.observeUs((uint32_t)(esp_timer_get_time() - postStart));
+      mHttpSends.inc();
 
       if (httpResponseSent >= 200 && httpResponseSent <= 204)
       {
@@ -794,17 +874,20 @@ void sendDataHTTP(String data, String serverPath, String httpUsername, String ht
       }
       else
       {
+        mHttpFailures.inc();
         errorBlinker.trigger(4, 100);
-        errorMessages.addMessage(getTimeNow() + " - Failed to send data to API");
+        errorMessages.addTimedMessage("Failed to send data to API");
         networkSettings.connStatus = "Not Connected";
       }
       https.end();
     }
     else
     {
+      mHttpSends.inc();
+      mHttpFailures.inc();
       errorBlinker.trigger(4, 100);
       ESP_LOGW("HTTP", "✗ WiFi not connected");
-      errorMessages.addMessage(getTimeNow() + " - WiFi not connected");
+      errorMessages.addTimedMessage("WiFi not connected");
       networkSettings.connStatus = "Not Connected";
     }
     sendTime = millis();
@@ -819,7 +902,7 @@ void sendDataHTTP(String data, String serverPath, String httpUsername, String ht
 //   {
 //     errorBlinker.trigger(4, 200);
 //     ESP_LOGE("SD Card", "Initialization failed!");
-//     errorMessages.addMessage(getTimeNow() + " - Failed to initialize SD card");
+//     errorMessages.addTimedMessage("Failed to initialize SD card");
 //     return;
 //   }
 
@@ -831,7 +914,7 @@ void sendDataHTTP(String data, String serverPath, String httpUsername, String ht
 //   {
 //     errorBlinker.trigger(3, 200);
 //     ESP_LOGE("SD Card", "Failed to open file!");
-//     errorMessages.addMessage(getTimeNow() + " - Failed to open file for writing!");
+//     errorMessages.addTimedMessage("Failed to open file for writing!");
 //     SD.end();
 //     return;
 //   }
@@ -842,9 +925,11 @@ void sendDataHTTP(String data, String serverPath, String httpUsername, String ht
 //   SD.end();
 // }
 
-void saveToSD(String data)
+void saveToSD(const char *data)
 {
   Serial.println("Saving to SD card...");
+  MetricTimer timer(mSdWrite); // termasuk tunggu sdMutex & lease bus
+  mSdWrites.inc();
 
   // HAPUS SD.begin(5)! Kita asumsikan sudah nyala dari setup()
   // HAPUS SD.end()! Biarkan jalur SPI tetap hidup untuk Ethernet
@@ -855,25 +940,51 @@ void saveToSD(String data)
   //    return;
   // }
 
-  // Gunakan Mutex jika perlu (agar tidak bentrok dengan task lain)
-  // if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(1000))) {
-
-  File dataOffline = SD.open("/sensor_data.csv", FILE_APPEND);
-  if (!dataOffline)
+  // sdMutex: kepemilikan file; lease SPI: waktu pakai bus (ditulis per sektor)
+  if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(500)) != pdTRUE)
   {
-    errorBlinker.trigger(3, 200);
-    ESP_LOGE("SD Card", "Failed to open file!");
-    errorMessages.addMessage(getTimeNow() + " - Failed to open file for writing!");
-    // JANGAN panggil SD.end() disini
+    mSdFailures.inc();
+    Serial.println("⚠️ SD Save Skipped (SD Busy)");
     return;
   }
 
-  dataOffline.println(data);
-  dataOffline.close();
-  ESP_LOGI("SD Card", "✓ Data saved");
+  {
+    SpiBusLease lease(SPI_CLIENT_SD_LOG, SPI_PRIO_NORMAL, 2000, 20);
+    if (!lease)
+    {
+      mSdFailures.inc();
+      Serial.println("⚠️ SD Save Skipped (SPI Busy)");
+      xSemaphoreGive(sdMutex);
+      return;
+    }
 
-  // xSemaphoreGive(sdMutex);
-  // }
+    File dataOffline = SD.open("/sensor_data.csv", FILE_APPEND);
+    if (!dataOffline)
+    {
+      mSdFailures.inc();
+      errorBlinker.trigger(3, 200);
+      ESP_LOGE("SD Card", "Failed to open file!");
+      errorMessages.addTimedMessage("Failed to open file for writing!");
+      // JANGAN panggil SD.end() disini
+      xSemaphoreGive(sdMutex);
+      return;
+    }
+
+    SpiSliceWriter out(dataOffline, lease);
+    out.println(data);
+    bool ok = out.finish();
+    dataOffline.close();
+
+    if (ok)
+      ESP_LOGI("SD Card", "✓ Data saved");
+    else
+    {
+      mSdFailures.inc();
+      ESP_LOGE("SD Card", "Write failed or SPI lease lost");
+    }
+  }
+
+  xSemaphoreGive(sdMutex);
 }
 
 // void sendBackupData()
@@ -884,7 +995,7 @@ void saveToSD(String data)
 //   {
 //     errorBlinker.trigger(4, 200);
 //     ESP_LOGE("SD Card", "Initialization failed!");
-//     errorMessages.addMessage(getTimeNow() + " - Failed to initialize SD card");
+//     errorMessages.addTimedMessage("Failed to initialize SD card");
 //     return;
 //   }
 
@@ -893,7 +1004,7 @@ void saveToSD(String data)
 //   {
 //     errorBlinker.trigger(3, 200);
 //     ESP_LOGE("SD Card", "Failed to open file for reading!");
-//     errorMessages.addMessage(getTimeNow() + " - Failed to open file for reading!");
+//     errorMessages.addTimedMessage("Failed to open file for reading!");
 //     return;
 //   }
 
@@ -1005,16 +1116,34 @@ void saveToSD(String data)
 
 void sendBackupData()
 {
+  // sdMutex dipegang selama file dibaca; bus SPI hanya dipegang saat membaca SD,
+  // dan dilepas selama POST HTTPS supaya client lain tidak ikut menunggu jaringan.
+  if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(500)) != pdTRUE)
+    return;
+
+  SpiBusLease lease(SPI_CLIENT_SD_BACKUP, SPI_PRIO_LOW, 3000, 20);
+  if (!lease)
+  {
+    Serial.println("⚠️ Backup Send Skipped (SPI Busy)");
+    xSemaphoreGive(sdMutex);
+    return;
+  }
+
   if (!SD.exists("/sensor_data.csv"))
+  {
+    lease.release();
+    xSemaphoreGive(sdMutex);
     return;
+  }
 
   Serial.println("Checking SD card for backup data...");
 
-  // Gunakan Mutex SD jika memungkinkan
   File dataOffline = SD.open("/sensor_data.csv", FILE_READ);
   if (!dataOffline)
   {
     ESP_LOGE("SD", "Failed to open backup file");
+    lease.release();
+    xSemaphoreGive(sdMutex);
     return;
   }
 
@@ -1023,6 +1152,8 @@ void sendBackupData()
   {
     dataOffline.close();
     SD.remove("/sensor_data.csv"); // Hapus file kosong/sampah
+    lease.release();
+    xSemaphoreGive(sdMutex);
     return;
   }
 
@@ -1038,8 +1169,17 @@ void sendBackupData()
   bool firstLine = true;
   int count = 0;
 
+  bool busLost = false;
+
   while (dataOffline.available())
   {
+    // batas slice: beri kesempatan client SD prioritas lebih tinggi
+    if (!lease.yield())
+    {
+      busLost = true;
+      break;
+    }
+
     String line = dataOffline.readStringUntil('\n');
     line.trim();
     if (line.length() < 5)
@@ -1061,7 +1201,10 @@ void sendBackupData()
     {
       String fullData = "[" + jsonData + "]";
 
-      if (WiFi.status() == WL_CONNECTED || networkSettings.networkMode == "Ethernet")
+      // Lepas bus selama request jaringan
+      lease.release();
+
+      if (WiFi.status() == WL_CONNECTED || (ethReady && ETH.hasIP()))
       {
         // Mulai koneksi HTTP
         if (https.begin(client, "https://sensor-logger-trial.medionindonesia.com/api/v1/AddBackupList"))
@@ -1091,10 +1234,26 @@ void sendBackupData()
       firstLine = true;
       count = 0;
       vTaskDelay(10); // Beri jeda agar Watchdog tidak marah
+
+      if (!lease.reacquire())
+      {
+        busLost = true;
+        break;
+      }
     }
   }
 
+  if (busLost)
+  {
+    // File tidak dihapus: sisa data dikirim ulang di siklus berikutnya
+    dataOffline.close(); // file read-only, close tidak menulis ke kartu
+    Serial.println("⚠️ Backup interrupted (SPI Busy), will retry");
+    xSemaphoreGive(sdMutex);
+    return;
+  }
+
   // Kirim sisa data jika ada
+  lease.release();
   if (jsonData.length() > 5)
   {
     String fullData = "[" + jsonData + "]";
@@ -1108,9 +1267,13 @@ void sendBackupData()
   }
 
   dataOffline.close();
-
-  // Hapus file setelah sukses (atau rename ke .bak jika ingin aman)
-  SD.remove("/sensor_data.csv");
-  Serial.println("Backup process finished & file cleared.");
+  if (lease.reacquire())
+  {
+    // Hapus file setelah sukses (atau rename ke .bak jika ingin aman)
+    SD.remove("/sensor_data.csv");
+    lease.release();
+    Serial.println("Backup process finished & file cleared.");
+  }
+  xSemaphoreGive(sdMutex);
 }
 #endif // NETWORK_FUNCTIONS_HPP
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef PAYLOAD_HPP
+#define PAYLOAD_HPP
+
+#include <ArduinoJson.h>
+#include <stdio.h>
+
+// ============================================================================
+// PAYLOAD (jsonSend -> array record API / SD)
+//   [{"KodeSensor":"AI1", "additional":{"jobnum":"..."}, "StringWaktu":"...", "Value":"1.23"}]
+// Dipakai kirim periodik (waktu hanya saat offline) dan simpan SD (waktu selalu).
+// Hanya ArduinoJson: bisa diuji & diukur di host (test/test_payload).
+// ============================================================================
+
+// timeNow / jobNum NULL = field tidak ditulis. Key "-" (placeholder) dilewati.
+// Key, timeNow & jobNum disimpan sebagai pointer (const char*, tanpa salin):
+// serialize out selagi values (di bawah jsonMutex) dan buffer itu masih hidup.
+inline size_t buildSensorPayload(JsonObjectConst values, JsonArray out, const char *timeNow, const char *jobNum)
+{
+  size_t n = 0;
+  for (JsonPairConst kv : values)
+  {
+    if (kv.key() == "-")
+      continue;
+    JsonObject nestedObj = out.createNestedObject();
+    nestedObj["KodeSensor"] = kv.key().c_str();
+    if (jobNum)
+    {
+      JsonObject additional = nestedObj.createNestedObject("additional");
+      additional["jobnum"] = jobNum;
+    }
+    if (timeNow)
+      nestedObj["StringWaktu"] = timeNow;
+    char value[16];
+    snprintf(value, sizeof(value), "%.2f", kv.value().as<float>());
+    nestedObj["Value"] = value; // char* disalin ke pool (direset tiap kirim)
+    n++;
+  }
+  return n;
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef RS485_PORT_HPP
+#define RS485_PORT_HPP
+
+#include <Arduino.h>
+#include "driver/uart.h"
+#include "esp_timer.h"
+#include "ModbusFrame.hpp"
+
+// ============================================================================
+// RS-485 PORT (satu UART + transceiver)
+// Peran master / slave dipasang ke port berbeda (lihat RS485_* di config.hpp).
+// Jika pin DE diisi, UART dijalankan di UART_MODE_RS485_HALF_DUPLEX: driver
+// menaikkan DE (RTS) saat byte pertama dikirim dan menurunkannya setelah stop
+// bit terakhir keluar, tanpa delay/digitalWrite manual di kode Modbus.
+// ============================================================================
+
+class Rs485Port
+{
+public:
+  Rs485Port(HardwareSerial &serial, uart_port_t uart, int8_t rx, int8_t tx, int8_t de)
+      : _serial(serial), _uart(uart), _rx(rx), _tx(tx), _de(de) {}
+
+  bool enabled() const { return _rx >= 0 && _tx >= 0; }
+  HardwareSerial &serial() { return _serial; }
+  uint32_t baudrate() const { return _baudrate; }
+  uint32_t frameGapUs() const { return modbusRtuFrameGapUs(_baudrate); }
+
+  bool begin(long baudrate, uint8_t dataBit, uint8_t stopBit, const char *parity)
+  {
+    struct SerialFormat
+    {
+      uint8_t dataBit, stopBit;
+      const char *parity;
+      uint32_t config;
+    };
+    static const SerialFormat formats[] = {
+        {8, 1, "None", SERIAL_8N1}, {8, 2, "None", SERIAL_8N2},
+        {8, 1, "Odd", SERIAL_8O1}, {8, 2, "Odd", SERIAL_8O2},
+        {8, 1, "Even", SERIAL_8E1}, {8, 2, "Even", SERIAL_8E2},
+        {7, 1, "None", SERIAL_7N1}, {7, 2, "None", SERIAL_7N2},
+        {7, 1, "Odd", SERIAL_7O1}, {7, 2, "Odd", SERIAL_7O2},
+        {7, 1, "Even", SERIAL_7E1}, {7, 2, "Even", SERIAL_7E2},
+    };
+
+    if (!enabled())
+      return false;
+    for (const SerialFormat &f : formats)
+    {
+      if (f.dataBit == dataBit && f.stopBit == stopBit && strcmp(f.parity, parity) == 0)
+      {
+        _serial.begin(baudrate, f.config, _rx, _tx);
+        _baudrate = baudrate;
+        if (_de >= 0)
+        {
+          // Driver UART sudah ter-install oleh begin(): pasang DE sebagai RTS
+          uart_set_pin(_uart, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, _de, UART_PIN_NO_CHANGE);
+          uart_set_mode(_uart, UART_MODE_RS485_HALF_DUPLEX);
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Master: buang sisa byte di RX lalu kirim satu frame (blocking sampai
+  // byte terakhir keluar)
+  void send(const uint8_t *frame, size_t len)
+  {
+    while (_serial.available())
+      _serial.read();
+    _serial.write(frame, len);
+    _serial.flush();
+  }
+
+  // Master: tunggu byte pertama (timeoutMs) sambil yield, lalu baca sampai
+  // expectedLen byte (0 = tidak diketahui), exception 5 byte, atau bus diam
+  // lebih dari t3.5 (min 2 ms). Kembalikan jumlah byte (0 = timeout).
+  size_t receive(uint8_t *response, size_t maxLen, size_t expectedLen, uint32_t timeoutMs)
+  {
+    if (expectedLen == 0 || expectedLen > maxLen)
+      expectedLen = maxLen;
+
+    unsigned long startTime = millis();
+    while (millis() - startTime < timeoutMs)
+    {
+      if (_serial.available())
+        break;
+      vTaskDelay(1); // Beri CPU ke task lain
+    }
+    if (!_serial.available())
+      return 0;
+
+    size_t resIndex = 0;
+    int64_t gapUs = frameGapUs() > 2000 ? frameGapUs() : 2000;
+    int64_t lastByteUs = esp_timer_get_time();
+    while (resIndex < expectedLen)
+    {
+      if (resIndex >= 5 && (response[1] & 0x80))
+        break;
+      if (_serial.available())
+      {
+        response[resIndex++] = _serial.read();
+        lastByteUs = esp_timer_get_time();
+      }
+      else if (esp_timer_get_time() - lastByteUs > gapUs)
+        break;
+      else
+        vTaskDelay(1);
+    }
+    return resIndex;
+  }
+
+  void end()
+  {
+    if (!_baudrate)
+      return;
+    _serial.flush();
+    _serial.end();
+    _baudrate = 0;
+  }
+
+private:
+  HardwareSerial &_serial;
+  uart_port_t _uart;
+  int8_t _rx, _tx, _de;
+  uint32_t _baudrate = 0;
+};
+
+#endif
@@ -0,0 +1,1010 @@
+#ifndef RUNTIME_CONFIG_HPP
+#define RUNTIME_CONFIG_HPP
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include "config.hpp"
+#include "SignalMath.hpp"
+#include "ModbusFrame.hpp"
+#include "ModbusPlanner.hpp"
+#include "ModbusRegisterTable.hpp"
+#include "Expression.hpp"
+#include "Spectrum.hpp"
+
+extern DynamicJsonDocument jsonParam;
+extern SemaphoreHandle_t jsonMutex;
+
+// ============================================================================
+// RUNTIME CONFIG (snapshot immutable ala RCU)
+// Struct global (networkSettings, analogInput[], digitalInput[], jsonParam)
+// tetap jadi tempat edit web handler & sumber persistensi, tapi task TIDAK
+// lagi membacanya langsung (String bisa di-realloc saat task sedang membaca).
+// Setiap perubahan config -> runtimeConfig.publish() membuat snapshot baru
+// (POD, tanpa String) dan menukar pointer secara atomik. Task mengambil
+// snapshot dengan read() di titik aman awal loop-nya dan memakainya sampai
+// read() berikutnya. Snapshot lama dibebaskan setelah semua reader melewati
+// titik aman (quiescent-state RCU), jadi reader tidak pernah memakai lock
+// dan publisher tidak pernah menunggu reader.
+// ============================================================================
+
+#define RUNTIME_MAX_MODBUS_TAGS 64
+#define RUNTIME_MAX_SLAVE_MAP 64
+#define RUNTIME_MAX_TCP_TARGETS MODBUS_TCP_MAX_TARGETS
+#define RUNTIME_MAX_ALARMS 16
+#define RUNTIME_MAX_VIRTUAL 16
+#define RUNTIME_MAX_TOTALIZERS 8
+#define RUNTIME_MAX_VIBRATION 2 // kanal ADC internal high-rate
+#define RUNTIME_MAX_UNIT_TIMEOUTS 16
+#define MODBUS_RTU_TIMEOUT_MS 100 // default tunggu balasan slave RS-485
+#define RCU_MAX_RETIRED 4
+
+enum DigitalInputMode : uint8_t
+{
+  DI_MODE_NORMAL = 0,
+  DI_MODE_COUNTING,
+  DI_MODE_CYCLE_TIME,
+  DI_MODE_RUN_TIME,
+  DI_MODE_PULSE
+};
+
+enum UplinkProtocol : uint8_t
+{
+  UPLINK_NONE = 0,
+  UPLINK_HTTP,
+  UPLINK_MQTT
+};
+
+// Satu slot per task pembaca
+enum RcuReader : uint8_t
+{
+  RCU_READER_ACQUISITION = 0,
+  RCU_READER_MODBUS,
+  RCU_READER_LOGGER,
+  RCU_READER_NETWORK,
+  RCU_READER_WEB, // handler AsyncWebServer & CommandSocket /ws (hanya task async_tcp)
+  RCU_READER_RTU_SLAVE,
+  RCU_READER_TCP_SLAVE,
+  RCU_READER_VIBRATION,
+  RCU_READER_COUNT
+};
+
+struct DigitalChannelConfig
+{
+  char name[32];
+  uint8_t mode; // DigitalInputMode
+  bool inv, inputState;
+  uint32_t intervalTime;
+  float conversionFactor;
+};
+
+struct DigitalOutputConfig
+{
+  char name[32]; // dicocokkan perintah by name (MQTT / HTTP / WS)
+  bool inv;
+};
+
+struct ModbusTagConfig
+{
+  char name[32];
+  uint8_t slaveId, fc;
+  uint16_t reg;
+  float multiplier;
+  uint16_t slaveReg; // elemen ke-5 (opsional): register mirror di slave
+  uint8_t target;    // 0 = bus RS-485, 1.. = tcpTargets[target - 1]
+};
+
+// Slave map: register mana di tabel slave berisi nilai apa
+enum SlaveArea : uint8_t
+{
+  SLAVE_AREA_IREG = 0, // FC4
+  SLAVE_AREA_HREG,     // FC3
+  SLAVE_AREA_COIL,     // FC1
+  SLAVE_AREA_ISTS      // FC2
+};
+
+enum SlaveSource : uint8_t
+{
+  SLAVE_SRC_AI = 0, // nilai AI setelah scaling (mapValue)
+  SLAVE_SRC_AI_RAW, // nilai ADC (adcValue)
+  SLAVE_SRC_DI,
+  SLAVE_SRC_TAG, // nilai tag Modbus master (index tabel tag)
+  SLAVE_SRC_DO,  // status DO lokal; write coil -> perintah DO
+  SLAVE_SRC_TOTAL // akumulasi totalizer (double; pakai uint32/int64/float64)
+};
+
+struct SlaveMapEntry
+{
+  uint16_t addr;
+  uint8_t area;     // SlaveArea
+  uint8_t source;   // SlaveSource
+  uint8_t index;    // AI/DI/DO 1-based, tag & totalizer 0-based
+  uint8_t encoding; // ModbusEncoding (register saja)
+  uint8_t order;    // ModbusWordOrder
+  float scale;
+};
+
+// Alarm threshold (dievaluasi AlarmEngine di Task_DataAcquisition)
+enum AlarmType : uint8_t
+{
+  ALARM_HI = 0,
+  ALARM_HIHI,
+  ALARM_LO,
+  ALARM_LOLO,
+  ALARM_ROC // laju perubahan, limit dalam unit/detik (nilai absolut)
+};
+
+enum AlarmSource : uint8_t
+{
+  ALARM_SRC_AI = 0, // mapValue
+  ALARM_SRC_DI,     // value hasil mode DI
+  ALARM_SRC_TAG,    // nilai tag Modbus master (index tabel tag)
+  ALARM_SRC_VIRTUAL // kanal virtual (index tabel virtual)
+};
+
+struct AlarmConfig
+{
+  char name[32];
+  uint8_t type;    // AlarmType
+  uint8_t source;  // AlarmSource
+  uint8_t index;   // AI/DI 1-based, tag & virtual 0-based
+  uint8_t doIndex; // interlock: DO 1-based yang dipaksa saat alarm aktif, 0 = tanpa
+  bool doValue;
+  float limit, deadband; // deadband = histeresis saat kembali normal
+  uint32_t onDelayMs, offDelayMs;
+};
+
+// Kanal virtual: ekspresi atas AI/DI/tag, di-compile saat snapshot dibuat
+// (dievaluasi VirtualChannels di Task_DataAcquisition, sebelum alarm)
+struct VirtualChannelConfig
+{
+  char name[32];
+  ExprProgram program;
+};
+
+// Slot variabel ekspresi: nilai AI 1..n, DI 1..n, tag 0..63, virtual 0..15
+#define VSLOT_AI(i) ((i) - 1)
+#define VSLOT_DI(i) (jumlahInputAnalog + (i) - 1)
+#define VSLOT_TAG(n) (jumlahInputAnalog + jumlahInputDigital + (n))
+#define VSLOT_VIRTUAL(n) (VSLOT_TAG(RUNTIME_MAX_MODBUS_TAGS) + (n))
+#define VSLOT_COUNT VSLOT_VIRTUAL(RUNTIME_MAX_VIRTUAL)
+
+// Totalizer: integral trapesium rate (AI/tag/kanal virtual) atas timestamp
+// sampel asli (dievaluasi Totalizers di Task_DataAcquisition)
+enum TotalizerReset : uint8_t
+{
+  TOTAL_RESET_NONE = 0,
+  TOTAL_RESET_HOURLY,
+  TOTAL_RESET_DAILY,
+  TOTAL_RESET_WEEKLY, // Senin
+  TOTAL_RESET_MONTHLY
+};
+
+struct TotalizerConfig
+{
+  char name[32];
+  uint8_t slot;      // VSLOT_* sumber
+  uint8_t reset;     // TotalizerReset
+  uint8_t resetHour; // jam lokal reset untuk daily/weekly/monthly
+  float cutoff;      // low-flow cutoff: |rate| < cutoff dianggap 0
+  float timeBaseS;   // satuan waktu rate dalam detik (rate per jam = 3600)
+};
+
+// Capture getaran: ADC1 internal via DMA, fitur spektrum per interval
+// (VibrationCapture, task sendiri di core 0)
+struct VibrationChannelConfig
+{
+  char name[32];
+  uint8_t adcChannel; // ADC1_CHANNEL_x
+  float scale;        // satuan fisik per volt (mis. g/V sensor akselerometer)
+};
+
+struct VibrationConfig
+{
+  uint8_t channelCount; // 0 = nonaktif
+  VibrationChannelConfig channels[RUNTIME_MAX_VIBRATION];
+  uint32_t rateHz;     // sample rate per kanal
+  uint16_t samples;    // panjang blok FFT (pangkat 2)
+  uint32_t intervalMs; // jarak antar capture
+  uint8_t bandCount;
+  float bandEdges[SPECTRUM_MAX_BANDS + 1]; // Hz, naik
+};
+
+struct RuntimeConfig
+{
+  uint32_t generation;
+
+  // Akuisisi (index 1-based seperti analogInput[] / digitalInput[])
+  AnalogChannelConfig ai[jumlahInputAnalog + 1];
+  DigitalChannelConfig di[jumlahInputDigital + 1];
+  DigitalOutputConfig dout[jumlahOutputDigital + 1];
+  uint8_t sendTrigPin; // 0 = Timer/interval
+  bool slaveTCP, slaveRTU;
+
+  // Jaringan (Task_NetworkManagement)
+  bool ethernet;           // networkMode == "Ethernet", selain itu WiFi
+  bool dhcp;               // dhcpMode == "DHCP"
+  uint32_t liveIntervalMs; // push SSE /live
+
+  // Modbus master (RS-485)
+  uint32_t scanRateMs;
+  int32_t baudrate;
+  uint8_t dataBit, stopBit;
+  char parity[8];
+  uint16_t rtuTimeoutMs; // default semua unit
+  uint8_t unitTimeoutCount;
+  struct
+  {
+    uint8_t unit;
+    uint16_t ms;
+  } unitTimeouts[RUNTIME_MAX_UNIT_TIMEOUTS]; // slave lambat (gateway, meter lama)
+
+  // Timeout balasan unit di bus RS-485 (scan, perintah tulis, gateway)
+  uint16_t unitTimeoutMs(uint8_t unit) const
+  {
+    for (uint8_t i = 0; i < unitTimeoutCount; i++)
+    {
+      if (unitTimeouts[i].unit == unit)
+        return unitTimeouts[i].ms;
+    }
+    return rtuTimeoutMs;
+  }
+
+  uint16_t tagCount;
+  ModbusTagConfig tags[RUNTIME_MAX_MODBUS_TAGS];
+
+  // Modbus master (TCP) & rencana block read untuk kedua transport
+  uint8_t tcpTargetCount;
+  ModbusTcpTarget tcpTargets[RUNTIME_MAX_TCP_TARGETS];
+  uint16_t blockCount;
+  ModbusBlock blocks[RUNTIME_MAX_MODBUS_TAGS];
+  uint8_t blockTags[RUNTIME_MAX_MODBUS_TAGS]; // index tag, dikelompokkan per blok
+
+  // Modbus slave (TCP/RTU)
+  uint8_t slaveId; // alamat slave RTU
+  uint16_t slaveMapCount;
+  SlaveMapEntry slaveMap[RUNTIME_MAX_SLAVE_MAP];
+
+  // Gateway TCP -> RTU: unit ID yang diteruskan ke bus RS-485 (bitmap 0..255)
+  uint8_t gatewayUnits[32];
+  uint16_t gatewayCacheMs; // umur cache balasan read (0 = tanpa cache)
+
+  bool gatewayUnit(uint8_t unit) const { return gatewayUnits[unit / 8] & (1 << (unit % 8)); }
+
+  // Kanal virtual (urutan = urutan evaluasi)
+  uint8_t virtualCount;
+  VirtualChannelConfig virtuals[RUNTIME_MAX_VIRTUAL];
+
+  // Totalizer (state dicocokkan per nama, bukan index, antar config)
+  uint8_t totalizerCount;
+  TotalizerConfig totalizers[RUNTIME_MAX_TOTALIZERS];
+
+  VibrationConfig vibration;
+
+  // Alarm per kanal (urutan = index state di AlarmEngine)
+  uint8_t alarmCount;
+  AlarmConfig alarms[RUNTIME_MAX_ALARMS];
+
+  // Uplink
+  uint8_t protocol; // UplinkProtocol
+  uint32_t sendIntervalMs;
+  char endpoint[128];
+  int32_t port;
+  char authUser[33], authPass[65];
+
+  struct SerialParams
+  {
+    int32_t baudrate;
+    uint8_t dataBit, stopBit;
+    char parity[8];
+  };
+
+  SerialParams serialParams() const
+  {
+    SerialParams p = {};
+    p.baudrate = baudrate;
+    p.dataBit = dataBit;
+    p.stopBit = stopBit;
+    strlcpy(p.parity, parity, sizeof(p.parity));
+    return p;
+  }
+};
+
+static const char *const AI_TYPE_NAMES[] = {"0-10 V", "4-20 mA", "0-20 mA"};
+static const char *const DI_MODE_NAMES[] = {"Normal", "Counting", "Cycle Time", "Run Time", "Pulse Mode"};
+
+inline const char *aiTypeName(uint8_t type)
+{
+  return type <= AI_TYPE_0_20MA ? AI_TYPE_NAMES[type] : AI_TYPE_NAMES[0];
+}
+
+inline const char *diModeName(uint8_t mode)
+{
+  return mode <= DI_MODE_PULSE ? DI_MODE_NAMES[mode] : DI_MODE_NAMES[0];
+}
+
+inline uint8_t diModeFromString(const String &taskMode)
+{
+  for (uint8_t m = 0; m <= DI_MODE_PULSE; m++)
+  {
+    if (taskMode == DI_MODE_NAMES[m])
+      return m;
+  }
+  return DI_MODE_NORMAL;
+}
+
+static const char *const SLAVE_AREA_NAMES[] = {"ireg", "hreg", "coil", "ists"};
+static const char *const MB_ENCODING_NAMES[] = {"int16", "uint16", "int32", "float32", "uint32", "int64", "float64"};
+static const char *const MB_ORDER_NAMES[] = {"ABCD", "CDAB", "BADC", "DCBA"};
+static const char *const ALARM_TYPE_NAMES[] = {"hi", "hihi", "lo", "lolo", "roc"};
+static const char *const TOTAL_RESET_NAMES[] = {"none", "hourly", "daily", "weekly", "monthly"};
+
+// Index nama di tabel (case-insensitive), fallback jika tidak dikenal
+inline uint8_t nameIndex(const char *const *names, uint8_t count, const char *name, uint8_t fallback)
+{
+  if (!name)
+    return fallback;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (strcasecmp(names[i], name) == 0)
+      return i;
+  }
+  return fallback;
+}
+
+// Key JSON dari char[] snapshot wajib disalin: ArduinoJson menyimpan
+// const char* sebagai pointer, padahal snapshot bisa dibebaskan
+inline JsonString jsonKey(const char *name)
+{
+  return JsonString(name, strlen(name), JsonString::Copied);
+}
+
+class RuntimeConfigRcu
+{
+public:
+  bool begin()
+  {
+    _writeLock = xSemaphoreCreateMutex();
+    for (int r = 0; r < RCU_READER_COUNT; r++)
+      _seen[r].store(UINT32_MAX); // belum pernah read(): tidak memegang snapshot
+    return _writeLock != NULL;
+  }
+
+  // Reader: panggil di titik aman (awal loop). Pointer valid sampai read()
+  // berikutnya oleh reader yang sama; snapshot sebelumnya dilepas di sini.
+  const RuntimeConfig *read(RcuReader reader)
+  {
+    _seen[reader].store(_epoch.load());
+    return _current.load();
+  }
+
+  // Reader sesekali (web handler): lepas setelah selesai supaya reader yang
+  // diam tidak menahan snapshot lama. Pakai lewat RuntimeConfigReadGuard.
+  void release(RcuReader reader) { _seen[reader].store(UINT32_MAX); }
+
+  // Bangun snapshot dari struct global lalu tukar. Dipanggil setelah web
+  // handler mengubah config (bukan dari ISR). Tidak pernah menunggu reader:
+  // jika slot retired penuh, snapshot disimpan sebagai pending dan ditukar
+  // oleh maintain() begitu ada slot bebas.
+  // Jika jsonMutex tidak didapat, snapshot setengah jadi (tanpa tag, slave
+  // map, alarm, ...) TIDAK diterbitkan: snapshot lama tetap dipakai dan
+  // maintain() mengulang capture. Return false jika capture gagal.
+  bool publish()
+  {
+    RuntimeConfig *next = new RuntimeConfig;
+    if (!capture(*next))
+    {
+      delete next;
+      _retryCapture = true;
+      Serial.println("[RCU] jsonMutex busy, snapshot capture retried later");
+      return false;
+    }
+    _retryCapture = false;
+
+    xSemaphoreTake(_writeLock, portMAX_DELAY);
+    if (_pending)
+      delete _pending; // ditimpa edit yang lebih baru
+    _pending = next;
+    swapPendingLocked();
+    xSemaphoreGive(_writeLock);
+    return true;
+  }
+
+  // Dipanggil berkala (Task_NetworkManagement): ulangi capture yang gagal,
+  // bebaskan snapshot lama & terbitkan snapshot pending
+  void maintain()
+  {
+    if (_retryCapture)
+      publish();
+    if (xSemaphoreTake(_writeLock, 0))
+    {
+      swapPendingLocked();
+      xSemaphoreGive(_writeLock);
+    }
+  }
+
+  uint32_t generation() const { return _generation; }
+
+private:
+  struct Retired
+  {
+    const RuntimeConfig *ptr;
+    uint32_t epoch;
+  };
+
+  int retiredCount() const
+  {
+    int n = 0;
+    for (const Retired &r : _retired)
+      n += r.ptr != NULL;
+    return n;
+  }
+
+  void retire(const RuntimeConfig *ptr, uint32_t epoch)
+  {
+    for (Retired &r : _retired)
+    {
+      if (!r.ptr)
+      {
+        r.ptr = ptr;
+        r.epoch = epoch;
+        return;
+      }
+    }
+  }
+
+  void swapPendingLocked()
+  {
+    reclaimLocked();
+    if (!_pending || retiredCount() == RCU_MAX_RETIRED)
+      return;
+
+    RuntimeConfig *next = _pending;
+    _pending = NULL;
+    next->generation = _generation + 1;
+    const RuntimeConfig *old = _current.exchange(next);
+    _generation = next->generation; // setelah tukar: generation() baru => read() dapat snapshot baru
+    uint32_t epoch = _epoch.fetch_add(1) + 1;
+    if (old)
+      retire(old, epoch);
+    Serial.printf("[RCU] Runtime config gen %u published\n", next->generation);
+  }
+
+  void reclaimLocked()
+  {
+    uint32_t minSeen = UINT32_MAX;
+    for (int r = 0; r < RCU_READER_COUNT; r++)
+      minSeen = min(minSeen, _seen[r].load());
+
+    for (Retired &r : _retired)
+    {
+      // Semua reader sudah read() setelah pointer ditukar -> tidak ada yang memegang
+      if (r.ptr && minSeen >= r.epoch)
+      {
+        delete r.ptr;
+        r.ptr = NULL;
+      }
+    }
+  }
+
+  static void copyStr(char *dst, size_t size, const String &src)
+  {
+    strlcpy(dst, src.c_str(), size);
+  }
+
+  static bool pushSlaveMapEntry(RuntimeConfig &c, const SlaveMapEntry &e)
+  {
+    uint8_t width = e.area <= SLAVE_AREA_HREG ? modbusEncodingWidth(e.encoding) : 1;
+    if (c.slaveMapCount >= RUNTIME_MAX_SLAVE_MAP || e.addr + width > MODBUS_SLAVE_REGS)
+      return false;
+    c.slaveMap[c.slaveMapCount++] = e;
+    return true;
+  }
+
+  static SlaveMapEntry slaveEntry(uint8_t area, uint16_t addr, uint8_t source, uint8_t index, uint8_t encoding, float scale)
+  {
+    SlaveMapEntry e = {};
+    e.addr = addr;
+    e.area = area;
+    e.source = source;
+    e.index = index;
+    e.encoding = encoding;
+    e.order = MB_ORDER_ABCD;
+    e.scale = scale;
+    return e;
+  }
+
+  // Layout lama (tanpa "slaveMap" di modbusSetup.json), supaya SCADA yang
+  // sudah ada tetap membaca alamat yang sama:
+  //   IR 0-3 = AI x100, IR 10-13 = ADC raw, IR 20-23 = DI,
+  //   IR <slaveReg> = mirror tag master (elemen ke-5 tag, jika diisi)
+  // ditambah coil 0-3 = DO1-4 (bisa ditulis FC5/FC15)
+  static void defaultSlaveMap(RuntimeConfig &c)
+  {
+    for (uint8_t i = 1; i <= jumlahInputAnalog; i++)
+    {
+      pushSlaveMapEntry(c, slaveEntry(SLAVE_AREA_IREG, i - 1, SLAVE_SRC_AI, i, MB_ENC_INT16, 100.0f));
+      pushSlaveMapEntry(c, slaveEntry(SLAVE_AREA_IREG, i + 9, SLAVE_SRC_AI_RAW, i, MB_ENC_UINT16, 1.0f));
+    }
+    for (uint8_t i = 1; i <= jumlahInputDigital; i++)
+      pushSlaveMapEntry(c, slaveEntry(SLAVE_AREA_IREG, i + 19, SLAVE_SRC_DI, i, MB_ENC_UINT16, 1.0f));
+    for (uint8_t i = 1; i <= jumlahOutputDigital; i++)
+      pushSlaveMapEntry(c, slaveEntry(SLAVE_AREA_COIL, i - 1, SLAVE_SRC_DO, i, MB_ENC_UINT16, 1.0f));
+    for (uint8_t t = 0; t < c.tagCount; t++)
+    {
+      if (c.tags[t].slaveReg)
+        pushSlaveMapEntry(c, slaveEntry(SLAVE_AREA_IREG, c.tags[t].slaveReg, SLAVE_SRC_TAG, t, MB_ENC_UINT16, 1.0f));
+    }
+  }
+
+  // ["hreg", 100, "AI1", "float32", 1, "CDAB"]; source "AI1", "AI1.raw",
+  // "DI1", "DO1", nama tag Modbus atau nama totalizer. Entri tidak valid dilewati.
+  static void addSlaveMapEntry(RuntimeConfig &c, JsonArray p)
+  {
+    const char *source = p[2];
+    if (!source)
+      return;
+    SlaveMapEntry e = {};
+    e.area = nameIndex(SLAVE_AREA_NAMES, 4, p[0], 0xFF);
+    e.addr = p[1] | 0;
+    e.encoding = nameIndex(MB_ENCODING_NAMES, 7, p[3], MB_ENC_INT16);
+    e.scale = p[4] | 1.0f;
+    e.order = nameIndex(MB_ORDER_NAMES, 4, p[5], MB_ORDER_ABCD);
+    if (e.area > SLAVE_AREA_ISTS)
+      return;
+
+    int n = 0;
+    if ((strncmp(source, "AI", 2) == 0 || strncmp(source, "DI", 2) == 0) && isdigit((unsigned char)source[2]))
+    {
+      n = atoi(source + 2);
+      bool analog = source[0] == 'A';
+      if (n < 1 || n > (analog ? jumlahInputAnalog : jumlahInputDigital))
+        return;
+      e.index = n;
+      e.source = analog ? (strstr(source, ".raw") ? SLAVE_SRC_AI_RAW : SLAVE_SRC_AI) : SLAVE_SRC_DI;
+    }
+    else if (strncmp(source, "DO", 2) == 0 && isdigit((unsigned char)source[2]))
+    {
+      n = atoi(source + 2);
+      if (n < 1 || n > jumlahOutputDigital)
+        return;
+      e.index = n;
+      e.source = SLAVE_SRC_DO;
+    }
+    else
+    {
+      n = tagIndex(c, source);
+      e.source = SLAVE_SRC_TAG;
+      if (n < 0)
+      {
+        n = totalizerIndex(c, source);
+        e.source = SLAVE_SRC_TOTAL;
+      }
+      if (n < 0)
+        return;
+      e.index = n;
+    }
+    pushSlaveMapEntry(c, e);
+  }
+
+  static int tagIndex(const RuntimeConfig &c, const char *name)
+  {
+    for (int n = 0; n < c.tagCount; n++)
+    {
+      if (strcmp(c.tags[n].name, name) == 0)
+        return n;
+    }
+    return -1;
+  }
+
+  static int virtualIndex(const RuntimeConfig &c, const char *name)
+  {
+    for (int n = 0; n < c.virtualCount; n++)
+    {
+      if (strcmp(c.virtuals[n].name, name) == 0)
+        return n;
+    }
+    return -1;
+  }
+
+  // ExprResolver: "AI1"/"DI1", nama kanal AI/DI, nama tag, atau kanal
+  // virtual yang sudah ada (di atasnya) -> slot VSLOT_*
+  static int exprVariable(const char *name, size_t len, void *ctx)
+  {
+    const RuntimeConfig &c = *(const RuntimeConfig *)ctx;
+    char buf[32];
+    if (len == 0 || len >= sizeof(buf))
+      return -1;
+    memcpy(buf, name, len);
+    buf[len] = 0;
+
+    if ((strncmp(buf, "AI", 2) == 0 || strncmp(buf, "DI", 2) == 0) && isdigit((unsigned char)buf[2]))
+    {
+      int n = atoi(buf + 2);
+      bool analog = buf[0] == 'A';
+      if (n < 1 || n > (analog ? jumlahInputAnalog : jumlahInputDigital))
+        return -1;
+      return analog ? VSLOT_AI(n) : VSLOT_DI(n);
+    }
+    for (int i = 1; i <= jumlahInputAnalog; i++)
+    {
+      if (strcmp(c.ai[i].name, buf) == 0)
+        return VSLOT_AI(i);
+    }
+    for (int i = 1; i <= jumlahInputDigital; i++)
+    {
+      if (strcmp(c.di[i].name, buf) == 0)
+        return VSLOT_DI(i);
+    }
+    int n = tagIndex(c, buf);
+    if (n >= 0)
+      return VSLOT_TAG(n);
+    n = virtualIndex(c, buf);
+    return n >= 0 ? VSLOT_VIRTUAL(n) : -1;
+  }
+
+  // ["dP", "AI1 - AI2"]: nama, ekspresi (sintaks di Expression.hpp). Hanya
+  // boleh merujuk kanal virtual di atasnya; yang gagal compile dilewati.
+  static void addVirtual(RuntimeConfig &c, JsonArray p)
+  {
+    const char *name = p[0];
+    const char *expr = p[1];
+    if (!name || !expr || c.virtualCount >= RUNTIME_MAX_VIRTUAL)
+      return;
+    VirtualChannelConfig &v = c.virtuals[c.virtualCount];
+    strlcpy(v.name, name, sizeof(v.name));
+    ExprCompiler compiler;
+    const char *error = compiler.compile(expr, v.program, exprVariable, &c);
+    if (error)
+    {
+      Serial.printf("[VC] %s = \"%s\": %s\n", name, expr, error);
+      return;
+    }
+    c.virtualCount++;
+  }
+
+  static int totalizerIndex(const RuntimeConfig &c, const char *name)
+  {
+    for (int n = 0; n < c.totalizerCount; n++)
+    {
+      if (strcmp(c.totalizers[n].name, name) == 0)
+        return n;
+    }
+    return -1;
+  }
+
+  // ["Total Flow", "AI1", "h", 0.5, "daily", 6]
+  //   nama, source, satuan waktu rate ("s"/"min"/"h"/"d"), cutoff, reset, jam reset
+  // source seperti variabel ekspresi (AI, nama kanal, tag, kanal virtual).
+  static void addTotalizer(RuntimeConfig &c, JsonArray p)
+  {
+    const char *name = p[0];
+    const char *source = p[1];
+    if (!name || !source || c.totalizerCount >= RUNTIME_MAX_TOTALIZERS)
+      return;
+    int slot = exprVariable(source, strlen(source), &c);
+    if (slot < 0)
+      return;
+    TotalizerConfig &t = c.totalizers[c.totalizerCount];
+    strlcpy(t.name, name, sizeof(t.name));
+    t.slot = slot;
+    const char *base = p[2] | "s";
+    t.timeBaseS = strcmp(base, "min") == 0 ? 60.0f : strcmp(base, "h") == 0 ? 3600.0f : strcmp(base, "d") == 0 ? 86400.0f : 1.0f;
+    t.cutoff = fabsf(p[3] | 0.0f);
+    t.reset = nameIndex(TOTAL_RESET_NAMES, 5, p[4], TOTAL_RESET_NONE);
+    t.resetHour = constrain((int)(p[5] | 0), 0, 23);
+    c.totalizerCount++;
+  }
+
+  // GPIO -> ADC1_CHANNEL_x (-1 = bukan ADC1 atau dipakai DI / ETH_INT).
+  // ADC2 tidak bisa DMA dan bentrok dengan WiFi.
+  static int vibrationAdcChannel(int pin)
+  {
+    static const int8_t ADC1_PINS[] = {36, 37, 38, 39, 32, 33, 34, 35};
+    for (int i = 0; i < jumlahInputDigital; i++)
+    {
+      if (DI_PINS[i] == pin)
+        return -1;
+    }
+    for (int ch = 0; ch < 8; ch++)
+    {
+      if (ADC1_PINS[ch] == pin && pin != ETH_INT)
+        return ch;
+    }
+    return -1;
+  }
+
+  // {"channels":[["Pompa 1 DE", 36, 1.0], ...], "rateHz":10000,
+  //  "samples":1024, "intervalS":10, "bands":[10, 100, 500, 1000, 2500, 5000]}
+  // channel: [nama, GPIO, skala per volt]. Pin tidak valid dilewati.
+  static void addVibration(RuntimeConfig &c, JsonObject p)
+  {
+    VibrationConfig &v = c.vibration;
+    for (JsonArray ch : p["channels"].as<JsonArray>())
+    {
+      const char *name = ch[0];
+      int adc = vibrationAdcChannel(ch[1] | -1);
+      if (!name || adc < 0 || v.channelCount >= RUNTIME_MAX_VIBRATION)
+      {
+        Serial.printf("[VIB] channel %s skipped (pin %d)\n", name ? name : "?", (int)(ch[1] | -1));
+        continue;
+      }
+      VibrationChannelConfig &vc = v.channels[v.channelCount++];
+      strlcpy(vc.name, name, sizeof(vc.name));
+      vc.adcChannel = adc;
+      vc.scale = ch[2] | 1.0f;
+    }
+    v.rateHz = constrain((int)(p["rateHz"] | 10000), 1000, 50000);
+    uint16_t samples = constrain((int)(p["samples"] | 1024), 256, SPECTRUM_MAX_N);
+    v.samples = 256;
+    while (v.samples * 2 <= samples)
+      v.samples *= 2; // bulatkan ke bawah ke pangkat 2
+    v.intervalMs = constrain((int)(p["intervalS"] | 10), 1, 3600) * 1000UL;
+
+    // Batas pita harus naik & di bawah Nyquist; sisanya dipotong
+    float nyquist = v.rateHz / 2.0f;
+    uint8_t edges = 0;
+    for (JsonVariant e : p["bands"].as<JsonArray>())
+    {
+      float hz = e | 0.0f;
+      if (edges > SPECTRUM_MAX_BANDS || hz > nyquist || (edges && hz <= v.bandEdges[edges - 1]))
+        break;
+      v.bandEdges[edges++] = hz;
+    }
+    v.bandCount = edges > 1 ? edges - 1 : 0;
+  }
+
+  // ["Level tinggi", "AI1", "hi", 80, 2, 1000, 0, 2, false]
+  //   nama, source, type, limit, deadband, onDelayMs, offDelayMs, DO, doValue
+  // source "AI1", "DI1", nama tag atau kanal virtual; DO = index (1-based) / "DO2" / 0.
+  // Entri tidak valid dilewati.
+  static void addAlarm(RuntimeConfig &c, JsonArray p)
+  {
+    const char *source = p[1];
+    if (!source || c.alarmCount >= RUNTIME_MAX_ALARMS)
+      return;
+    AlarmConfig a = {};
+    strlcpy(a.name, p[0] | source, sizeof(a.name));
+    a.type = nameIndex(ALARM_TYPE_NAMES, 5, p[2], 0xFF);
+    a.limit = p[3] | 0.0f;
+    a.deadband = fabsf(p[4] | 0.0f);
+    a.onDelayMs = p[5] | 0;
+    a.offDelayMs = p[6] | 0;
+    a.doValue = p[8] | false;
+    if (a.type > ALARM_ROC)
+      return;
+
+    int n;
+    if ((strncmp(source, "AI", 2) == 0 || strncmp(source, "DI", 2) == 0) && isdigit((unsigned char)source[2]))
+    {
+      n = atoi(source + 2);
+      bool analog = source[0] == 'A';
+      if (n < 1 || n > (analog ? jumlahInputAnalog : jumlahInputDigital))
+        return;
+      a.source = analog ? ALARM_SRC_AI : ALARM_SRC_DI;
+    }
+    else
+    {
+      n = tagIndex(c, source);
+      a.source = ALARM_SRC_TAG;
+      if (n < 0)
+      {
+        n = virtualIndex(c, source);
+        a.source = ALARM_SRC_VIRTUAL;
+      }
+      if (n < 0)
+        return;
+    }
+    a.index = n;
+
+    const char *doName = p[7].as<const char *>();
+    int doIndex = doName ? (strncmp(doName, "DO", 2) == 0 ? atoi(doName + 2) : 0) : (p[7] | 0);
+    a.doIndex = doIndex >= 1 && doIndex <= jumlahOutputDigital ? doIndex : 0;
+    c.alarms[c.alarmCount++] = a;
+  }
+
+  // "192.168.1.50" atau "192.168.1.50:5020" -> index target (1-based),
+  // 0 jika kosong / tidak valid / tabel target penuh (tag tetap di RS-485)
+  static uint8_t tcpTargetIndex(RuntimeConfig &c, const char *addr)
+  {
+    if (!addr || !*addr)
+      return 0;
+    char host[24];
+    strlcpy(host, addr, sizeof(host));
+    uint16_t port = 502;
+    char *colon = strchr(host, ':');
+    if (colon)
+    {
+      *colon = 0;
+      port = atoi(colon + 1);
+    }
+    IPAddress ip;
+    if (!ip.fromString(host) || port == 0)
+      return 0;
+
+    for (uint8_t i = 0; i < c.tcpTargetCount; i++)
+    {
+      if (c.tcpTargets[i].ip == (uint32_t)ip && c.tcpTargets[i].port == port)
+        return i + 1;
+    }
+    if (c.tcpTargetCount >= RUNTIME_MAX_TCP_TARGETS)
+      return 0;
+    c.tcpTargets[c.tcpTargetCount].ip = (uint32_t)ip;
+    c.tcpTargets[c.tcpTargetCount].port = port;
+    return ++c.tcpTargetCount;
+  }
+
+  // false jika jsonMutex tidak didapat (isi c tidak lengkap)
+  static bool capture(RuntimeConfig &c)
+  {
+    memset(&c, 0, sizeof(c));
+
+    for (int i = 1; i <= jumlahInputAnalog; i++)
+    {
+      AnalogChannelConfig &a = c.ai[i];
+      copyStr(a.name, sizeof(a.name), analogInput[i].name);
+      a.type = AI_TYPE_0_10V;
+      for (uint8_t t = 0; t <= AI_TYPE_0_20MA; t++)
+      {
+        if (analogInput[i].inputType == AI_TYPE_NAMES[t])
+          a.type = t;
+      }
+      a.filter = analogInput[i].filter;
+      a.scaling = analogInput[i].scaling;
+      a.calibration = analogInput[i].calibration;
+      a.filterPeriod = analogInput[i].filterPeriod;
+      a.lowLimit = analogInput[i].lowLimit;
+      a.highLimit = analogInput[i].highLimit;
+      a.mValue = analogInput[i].mValue;
+      a.cValue = analogInput[i].cValue;
+      a.filterAlpha = a.filter ? lowPassAlpha(a.filterPeriod) : 0.0f;
+    }
+
+    for (int i = 1; i <= jumlahInputDigital; i++)
+    {
+      DigitalChannelConfig &d = c.di[i];
+      copyStr(d.name, sizeof(d.name), digitalInput[i].name);
+      d.mode = diModeFromString(digitalInput[i].taskMode);
+      d.inv = digitalInput[i].inv;
+      d.inputState = digitalInput[i].inputState;
+      d.intervalTime = digitalInput[i].intervalTime;
+      d.conversionFactor = digitalInput[i].conversionFactor;
+    }
+    for (int i = 1; i <= jumlahOutputDigital; i++)
+    {
+      copyStr(c.dout[i].name, sizeof(c.dout[i].name), digitalOutput[i].name);
+      c.dout[i].inv = digitalOutput[i].inv;
+    }
+
+    // "DI1".."DI4" -> 1..4, selain itu kirim berdasarkan interval
+    if (networkSettings.sendTrig.startsWith("DI") && networkSettings.sendTrig.length() >= 3)
+    {
+      int pin = networkSettings.sendTrig.substring(2, 3).toInt();
+      c.sendTrigPin = (pin >= 1 && pin <= jumlahInputDigital) ? pin : 0;
+    }
+    c.slaveTCP = networkSettings.protocolMode2.indexOf("TCP") >= 0;
+    c.slaveRTU = networkSettings.protocolMode2.indexOf("RTU") >= 0;
+    c.ethernet = networkSettings.networkMode == "Ethernet";
+    c.dhcp = networkSettings.dhcpMode == "DHCP";
+    c.liveIntervalMs = networkSettings.liveInterval;
+
+    c.scanRateMs = (uint32_t)(modbusParam.scanRate * 1000);
+    c.baudrate = modbusParam.baudrate;
+    c.dataBit = modbusParam.dataBit;
+    c.stopBit = modbusParam.stopBit;
+    copyStr(c.parity, sizeof(c.parity), modbusParam.parity);
+    c.slaveId = (modbusParam.slaveID >= 1 && modbusParam.slaveID <= 247) ? modbusParam.slaveID : 1;
+
+    // Tabel tag Modbus: {"nameData":[...], "<nama>":[slaveId, fc, reg, mul, slaveReg, "ip[:port]"]}
+    // Tanpa elemen ke-6 tag dibaca lewat RS-485; dengan IP lewat Modbus TCP
+    // (slaveId = unit ID).
+    if (!xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(1000)))
+      return false;
+    for (JsonVariant v : jsonParam["nameData"].as<JsonArray>())
+    {
+      if (c.tagCount >= RUNTIME_MAX_MODBUS_TAGS)
+        break;
+      const char *name = v.as<const char *>();
+      JsonArray p = jsonParam[name];
+      if (!name || p.isNull())
+        continue;
+      ModbusTagConfig &t = c.tags[c.tagCount++];
+      strlcpy(t.name, name, sizeof(t.name));
+      t.slaveId = p[0];
+      t.fc = p[1];
+      t.reg = p[2];
+      t.multiplier = p[3] | 1.0f;
+      t.slaveReg = p[4] | 0;
+      t.target = tcpTargetIndex(c, p[5]);
+    }
+    c.blockCount = modbusPlanBlocks(c.tags, c.tagCount, c.blockTags, c.blocks);
+
+    // Gateway: {"units":[1,2,5], "cacheMs":250}; unit 0 (broadcast) & 248..255 lokal
+    JsonObject gateway = jsonParam["gateway"];
+    for (JsonVariant u : gateway["units"].as<JsonArray>())
+    {
+      int unit = u | 0;
+      if (unit >= 1 && unit <= 247)
+        c.gatewayUnits[unit / 8] |= 1 << (unit % 8);
+    }
+    c.gatewayCacheMs = constrain((int)(gateway["cacheMs"] | 250), 0, 5000);
+
+    // Timeout RS-485: {"timeoutMs":100, "unitTimeoutMs":{"5":300}}. Maks 1 s
+    // supaya balasan gateway tetap sampai sebelum MODBUS_TCP_GATEWAY_TIMEOUT_MS
+    c.rtuTimeoutMs = constrain((int)(jsonParam["timeoutMs"] | MODBUS_RTU_TIMEOUT_MS), 20, 1000);
+    for (JsonPair kv : jsonParam["unitTimeoutMs"].as<JsonObject>())
+    {
+      int unit = atoi(kv.key().c_str());
+      if (unit < 1 || unit > 247 || c.unitTimeoutCount >= RUNTIME_MAX_UNIT_TIMEOUTS)
+        continue;
+      c.unitTimeouts[c.unitTimeoutCount].unit = unit;
+      c.unitTimeouts[c.unitTimeoutCount++].ms = constrain((int)(kv.value() | MODBUS_RTU_TIMEOUT_MS), 20, 1000);
+    }
+
+    // Kanal virtual: [nama, ekspresi]; sebelum totalizer, slave map & alarm
+    // supaya bisa jadi source
+    for (JsonArray v : jsonParam["virtual"].as<JsonArray>())
+      addVirtual(c, v);
+
+    // Totalizer: [nama, source, satuan waktu, cutoff, reset, jam reset]
+    for (JsonArray t : jsonParam["totalizers"].as<JsonArray>())
+      addTotalizer(c, t);
+
+    // Slave map: [area, addr, source, encoding, scale, order]
+    JsonArray slaveMap = jsonParam["slaveMap"];
+    if (slaveMap.isNull())
+      defaultSlaveMap(c);
+    else
+    {
+      for (JsonArray e : slaveMap)
+        addSlaveMapEntry(c, e);
+    }
+
+    // Getaran: capture high-rate ADC internal (lihat VibrationCapture.hpp)
+    JsonObject vibration = jsonParam["vibration"];
+    if (!vibration.isNull())
+      addVibration(c, vibration);
+
+    // Alarm: [nama, source, type, limit, deadband, onDelay, offDelay, DO, doValue]
+    for (JsonArray a : jsonParam["alarms"].as<JsonArray>())
+      addAlarm(c, a);
+    xSemaphoreGive(jsonMutex);
+
+    if (networkSettings.protocolMode == "HTTP")
+      c.protocol = UPLINK_HTTP;
+    else if (networkSettings.protocolMode == "MQTT")
+      c.protocol = UPLINK_MQTT;
+    c.sendIntervalMs = (uint32_t)(networkSettings.sendInterval * 1000);
+    copyStr(c.endpoint, sizeof(c.endpoint), networkSettings.endpoint);
+    c.port = networkSettings.port;
+    copyStr(c.authUser, sizeof(c.authUser), networkSettings.mqttUsername);
+    copyStr(c.authPass, sizeof(c.authPass), networkSettings.mqttPassword);
+    return true;
+  }
+
+  std::atomic<const RuntimeConfig *> _current{nullptr};
+  std::atomic<uint32_t> _epoch{0};
+  std::atomic<uint32_t> _seen[RCU_READER_COUNT];
+  Retired _retired[RCU_MAX_RETIRED] = {};
+  RuntimeConfig *_pending = NULL;
+  SemaphoreHandle_t _writeLock = NULL;
+  std::atomic<uint32_t> _generation{0};
+  std::atomic<bool> _retryCapture{false};
+};
+
+RuntimeConfigRcu runtimeConfig;
+
+// Akses snapshot dari web handler: valid selama guard hidup
+class RuntimeConfigReadGuard
+{
+public:
+  RuntimeConfigReadGuard() : _cfg(runtimeConfig.read(RCU_READER_WEB)) {}
+  ~RuntimeConfigReadGuard() { runtimeConfig.release(RCU_READER_WEB); }
+  const RuntimeConfig *operator->() const { return _cfg; }
+  const RuntimeConfig *get() const { return _cfg; }
+
+private:
+  const RuntimeConfig *_cfg;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef SCAN_STATS_HPP
+#define SCAN_STATS_HPP
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "ModbusFrame.hpp"
+#include "RuntimeConfig.hpp"
+
+// ============================================================================
+// SCAN STATS (throughput, latency & data loss per konfigurasi)
+// Dipakai untuk menyetel scanRate / sendInterval di plant sebenarnya:
+//   - akuisisi : sampel/detik, paket yang hilang karena queue penuh,
+//                umur paket saat diambil Task_DataLogger (latency end-to-end)
+//   - Modbus   : per tag ok / timeout / CRC / exception / mismatch + latency,
+//                durasi satu siklus scan vs scanRate yang diminta
+// Statistik tag di-reset saat generation config berubah (tabel tag baru).
+// Writer: task core 1 (satu writer per field); reader: web handler. Nilai
+// 32-bit dibaca tanpa lock, boleh sedikit tidak konsisten antar field.
+// ============================================================================
+
+struct ModbusTagStats
+{
+  uint32_t ok, timeout, crc, exception, mismatch;
+  uint32_t lastLatencyMs, maxLatencyMs;
+};
+
+class ScanStats
+{
+public:
+  // --- Task_DataAcquisition ---
+  void samplePushed(bool queued)
+  {
+    if (queued)
+      _samples++;
+    else
+      _samplesDropped++;
+  }
+
+  // --- Task_DataLogger ---
+  void sampleConsumed(unsigned long timestampMs)
+  {
+    uint32_t age = millis() - timestampMs;
+    _consumed++;
+    _ageSumMs += age;
+    if (age > _ageMaxMs)
+      _ageMaxMs = age;
+  }
+
+  // --- Task_ModbusClient ---
+  void tagResult(uint32_t generation, uint16_t index, uint8_t result, uint32_t latencyMs)
+  {
+    if (generation != _generation)
+    {
+      memset(_tags, 0, sizeof(_tags));
+      _scans = 0;
+      _scanMaxMs = 0;
+      _generation = generation;
+    }
+    if (index >= RUNTIME_MAX_MODBUS_TAGS)
+      return;
+
+    ModbusTagStats &t = _tags[index];
+    switch (result)
+    {
+    case MB_FRAME_OK:
+      t.ok++;
+      break;
+    case MB_FRAME_TIMEOUT:
+      t.timeout++;
+      break;
+    case MB_FRAME_CRC:
+    case MB_FRAME_SHORT:
+      t.crc++;
+      break;
+    case MB_FRAME_EXCEPTION:
+      t.exception++;
+      break;
+    default:
+      t.mismatch++;
+      break;
+    }
+    t.lastLatencyMs = latencyMs;
+    if (latencyMs > t.maxLatencyMs)
+      t.maxLatencyMs = latencyMs;
+  }
+
+  void scanDone(uint32_t durationMs)
+  {
+    _scans++;
+    _scanLastMs = durationMs;
+    if (durationMs > _scanMaxMs)
+      _scanMaxMs = durationMs;
+  }
+
+  void toJson(JsonObject obj, const RuntimeConfig *cfg)
+  {
+    uint32_t uptimeS = millis() / 1000;
+
+    JsonObject acq = obj.createNestedObject("acquisition");
+    acq["samples"] = _samples;
+    acq["dropped"] = _samplesDropped;
+    acq["samplesPerSec"] = uptimeS ? (float)_samples / uptimeS : 0;
+    acq["consumed"] = _consumed;
+    acq["latencyAvgMs"] = _consumed ? (float)_ageSumMs / _consumed : 0;
+    acq["latencyMaxMs"] = _ageMaxMs;
+
+    JsonObject mb = obj.createNestedObject("modbus");
+    mb["generation"] = _generation;
+    mb["scanRateMs"] = cfg->scanRateMs;
+    mb["scans"] = _scans;
+    mb["scanLastMs"] = _scanLastMs;
+    mb["scanMaxMs"] = _scanMaxMs;
+    mb["overrun"] = _scanLastMs > cfg->scanRateMs; // scanRate tidak tercapai
+
+    JsonArray tags = mb.createNestedArray("tags");
+    if (cfg->generation != _generation)
+      return; // tag stats milik tabel lama / belum ada scan
+    for (uint16_t i = 0; i < cfg->tagCount; i++)
+    {
+      const ModbusTagStats &t = _tags[i];
+      JsonObject o = tags.createNestedObject();
+      o["name"] = jsonKey(cfg->tags[i].name);
+      o["ok"] = t.ok;
+      o["timeout"] = t.timeout;
+      o["crc"] = t.crc;
+      o["exception"] = t.exception;
+      o["mismatch"] = t.mismatch;
+      uint32_t total = t.ok + t.timeout + t.crc + t.exception + t.mismatch;
+      o["lossPct"] = total ? 100.0f * (total - t.ok) / total : 0;
+      o["latencyMs"] = t.lastLatencyMs;
+      o["latencyMaxMs"] = t.maxLatencyMs;
+    }
+  }
+
+private:
+  uint32_t _samples = 0, _samplesDropped = 0;
+  uint32_t _consumed = 0, _ageMaxMs = 0;
+  uint64_t _ageSumMs = 0;
+
+  uint32_t _generation = 0;
+  uint32_t _scans = 0, _scanLastMs = 0, _scanMaxMs = 0;
+  ModbusTagStats _tags[RUNTIME_MAX_MODBUS_TAGS] = {};
+};
+
+ScanStats scanStats;
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef SHARED_SPI_SD_HPP
+#define SHARED_SPI_SD_HPP
+
+#include <Arduino.h>
+#include <FS.h>
+#include <vfs_api.h>
+#include "esp_vfs_fat.h"
+#include "driver/sdspi_host.h"
+#include "driver/spi_master.h"
+#include "config.hpp"
+
+// ============================================================================
+// SD CARD DI BUS SPI BERSAMA (W5500 + SD)
+// W5500 sekarang dijalankan oleh driver esp_eth (spi_master IDF), sehingga
+// SD Card tidak boleh lagi memakai SPIClass Arduino di pin yang sama.
+// SD di-mount lewat sdspi_host sebagai device kedua di host SPI yang sama,
+// lalu dibungkus fs::FS agar API SD.open()/exists()/remove() tetap sama.
+// ============================================================================
+
+// Inisialisasi bus SPI bersama. Aman dipanggil berkali-kali (oleh SD maupun W5500).
+bool sharedSpiBusInit()
+{
+  spi_bus_config_t buscfg = {};
+  buscfg.miso_io_num = ETH_MISO;
+  buscfg.mosi_io_num = ETH_MOSI;
+  buscfg.sclk_io_num = ETH_CLK;
+  buscfg.quadwp_io_num = -1;
+  buscfg.quadhd_io_num = -1;
+  buscfg.max_transfer_sz = 4096;
+
+  esp_err_t err = spi_bus_initialize(SHARED_SPI_HOST, &buscfg, 1);
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) // INVALID_STATE = bus sudah aktif
+  {
+    ESP_LOGE("SPI", "spi_bus_initialize failed: %s", esp_err_to_name(err));
+    return false;
+  }
+  return true;
+}
+
+class SharedSpiSD : public fs::FS
+{
+public:
+  SharedSpiSD() : fs::FS(fs::FSImplPtr(new VFSImpl())), _card(NULL) {}
+
+  bool begin(int csPin, uint32_t freqHz = 4000000, const char *mountpoint = "/sd", uint8_t maxFiles = 5)
+  {
+    if (_card)
+      return true;
+    if (!sharedSpiBusInit())
+      return false;
+
+    sdmmc_host_t host = SDSPI_HOST_DEFAULT();
+    host.slot = SHARED_SPI_HOST;
+    host.max_freq_khz = freqHz / 1000;
+
+    sdspi_device_config_t slot = SDSPI_DEVICE_CONFIG_DEFAULT();
+    slot.gpio_cs = (gpio_num_t)csPin;
+    slot.host_id = SHARED_SPI_HOST;
+
+    esp_vfs_fat_sdmmc_mount_config_t mountCfg = {};
+    mountCfg.format_if_mount_failed = false;
+    mountCfg.max_files = maxFiles;
+    mountCfg.allocation_unit_size = 16 * 1024;
+
+    esp_err_t err = esp_vfs_fat_sdspi_mount(mountpoint, &host, &slot, &mountCfg, &_card);
+    if (err != ESP_OK)
+    {
+      ESP_LOGE("SD", "esp_vfs_fat_sdspi_mount failed: %s", esp_err_to_name(err));
+      _card = NULL;
+      return false;
+    }
+    _mountpoint = mountpoint;
+    _impl->mountpoint(mountpoint);
+    return true;
+  }
+
+  void end()
+  {
+    if (!_card)
+      return;
+    _impl->mountpoint(NULL);
+    esp_vfs_fat_sdcard_unmount(_mountpoint.c_str(), _card);
+    _card = NULL;
+  }
+
+  bool mounted() { return _card != NULL; }
+
+  uint64_t totalBytes()
+  {
+    if (!_card)
+      return 0;
+    return (uint64_t)_card->csd.capacity * _card->csd.sector_size;
+  }
+
+private:
+  sdmmc_card_t *_card;
+  String _mountpoint;
+};
+
+// Nama global sengaja tetap "SD" agar pemanggilan lama tidak berubah.
+// Jangan include <SD.h> bersamaan dengan file ini.
+SharedSpiSD SD;
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef SIGNAL_MATH_HPP
+#define SIGNAL_MATH_HPP
+
+#include <math.h>
+#include <stdint.h>
+
+// ============================================================================
+// SIGNAL MATH (per-sampel, dipanggil tiap 100 ms per channel AI)
+// Sengaja tanpa Arduino.h / FreeRTOS: hanya <math.h>, sehingga bisa dikompilasi
+// & diukur di host (g++) tanpa HAL. Koefisien filter dihitung sekali saat
+// snapshot config dibuat (RuntimeConfig), bukan di setiap sampel.
+// ============================================================================
+
+#define AI_SAMPLE_PERIOD_S 0.1f // Sampling time (sesuai loop 100ms)
+
+// Count ADS1115 (GAIN_TWOTHIRDS, 0.1875 mV/LSB) untuk 1 V & 5 V di shunt/divider
+#define AI_ADC_1V 5333.33f
+#define AI_ADC_5V 26666.67f
+
+enum AnalogInputType : uint8_t
+{
+  AI_TYPE_0_10V = 0,
+  AI_TYPE_4_20MA,
+  AI_TYPE_0_20MA
+};
+
+// Config satu kanal AI (bagian snapshot RuntimeConfig)
+struct AnalogChannelConfig
+{
+  char name[32];
+  uint8_t type; // AnalogInputType
+  bool filter, scaling, calibration;
+  float filterPeriod, lowLimit, highLimit, mValue, cValue;
+  float filterAlpha; // koefisien low-pass dari filterPeriod (0 = tanpa filter)
+};
+
+// Koefisien low-pass orde 1 untuk cut-off fc (Hz). 0 = filter tidak aktif.
+inline float lowPassAlpha(float fc, float ts = AI_SAMPLE_PERIOD_S)
+{
+  // Safety check: Jika fc terlalu kecil, skip filter
+  if (fc < 0.01f)
+    return 0.0f;
+  float rc = 1.0f / (2.0f * 3.14159f * fc);
+  return ts / (rc + ts); // Normalized (0-1)
+}
+
+// Low-pass filter: Y = alpha*X + (1-alpha)*Y_prev
+inline float lowPassStep(float x, float yPrev, float alpha)
+{
+  if (alpha <= 0.0f)
+    return x;
+
+  float y = alpha * x + (1.0f - alpha) * yPrev;
+
+  // Safety: Jika hasil tidak masuk akal, return raw value
+  if (isnan(y) || isinf(y) || y > 30000.0f || y < -1000.0f)
+    return x;
+  return y;
+}
+
+// Versi lama (fc langsung), dipertahankan untuk pemanggil di luar task akuisisi
+inline float filterSensor(float filterVar, float filterResult_1, float fc)
+{
+  return lowPassStep(filterVar, filterResult_1, lowPassAlpha(fc));
+}
+
+// Skala linear, dibulatkan 2 desimal (nilai yang tampil & dikirim)
+inline float mapFloat(float x, float in_min, float in_max, float out_min, float out_max)
+{
+  float mappedValue = (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+  return roundf(mappedValue * 100.0f) / 100.0f;
+}
+
+// Count ADC (sudah difilter) -> nilai teknik: range sesuai tipe input, skala
+// lowLimit..highLimit jika scaling, lalu kalibrasi linear mX + c
+inline float analogSample(const AnalogChannelConfig &ai, float adc)
+{
+  float inMin = ai.type == AI_TYPE_4_20MA ? AI_ADC_1V : 0.0f;
+  float outMin = ai.type == AI_TYPE_4_20MA ? 4.0f : 0.0f;
+  float outMax = ai.type == AI_TYPE_0_10V ? 10.0f : 20.0f; // 4mA=1V (5333), 20mA=5V (26666)
+  if (ai.scaling)
+  {
+    outMin = ai.lowLimit;
+    outMax = ai.highLimit;
+  }
+  float value = mapFloat(adc, inMin, AI_ADC_5V, outMin, outMax);
+
+  // Kalibrasi Linear (mX + c) jika aktif
+  if (ai.calibration && ai.scaling)
+  {
+    float slope = (ai.mValue != 0) ? ai.mValue : 1.0f;
+    value = (value * slope) + ai.cValue;
+  }
+  return value;
+}
+
+// Nilai 2 desimal sebagai double, untuk disimpan di JsonDocument sebagai angka
+// (bukan String(v, 2)): tidak makan pool / heap, dan serialize tetap "1.23"
+inline double round2(float v)
+{
+  return round((double)v * 100.0) / 100.0;
+}
+
+#endif
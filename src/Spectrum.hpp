@@ -0,0 +1,212 @@
+#ifndef SPECTRUM_HPP
+#define SPECTRUM_HPP
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================================
+// SPECTRUM (fitur getaran dari satu blok sampel: RMS, peak, crest factor,
+// frekuensi dominan, RMS per pita frekuensi)
+// Tanpa Arduino.h / FreeRTOS seperti SignalMath.hpp: bisa dikompilasi & diuji
+// di host dengan sinyal sintetis.
+//
+// Kernel FFT mengikuti pola ESP-DSP (dsps_fft2r_fc32 + dsps_bit_rev_fc32):
+// radix-2 in-place, tabel twiddle dihitung sekali di init() dan disimpan
+// dalam urutan bit-reversed sehingga loop terdalam memakai satu twiddle
+// konstan dan akses memori berurutan. Input real N titik dikemas jadi N/2
+// titik kompleks (genap = re, ganjil = im) lalu dipisah (split) — setengah
+// kerja FFT kompleks N titik. Semua buffer milik objek: analyze() tanpa
+// alokasi.
+// ============================================================================
+
+#define SPECTRUM_MAX_N 1024
+#define SPECTRUM_MAX_BANDS 6
+
+struct VibrationFeatures
+{
+  float mean;    // komponen DC (dibuang sebelum fitur lain)
+  float rms;     // RMS AC
+  float peak;    // |x - mean| maksimum
+  float crest;   // peak / rms
+  float domFreq; // Hz, interpolasi parabola di log-magnitude
+  float domAmp;  // amplitudo puncak komponen dominan (perkiraan, window Hann)
+  uint8_t bandCount;
+  float bandRms[SPECTRUM_MAX_BANDS]; // RMS tiap pita [edge[b], edge[b+1])
+};
+
+class SpectrumAnalyzer
+{
+public:
+  // n: pangkat 2, 8..SPECTRUM_MAX_N
+  bool init(uint16_t n)
+  {
+    if (n < 8 || n > SPECTRUM_MAX_N || (n & (n - 1)))
+      return false;
+    _n = n;
+    uint16_t m = n / 2; // panjang FFT kompleks
+
+    // Twiddle FFT m titik: exp(-i 2 pi k / m), k < m/2, urutan bit-reversed
+    for (uint16_t k = 0; k < m / 2; k++)
+    {
+      _tw[2 * k] = cosf(2.0f * (float)M_PI * k / m);
+      _tw[2 * k + 1] = sinf(2.0f * (float)M_PI * k / m);
+    }
+    bitReverse(_tw, m / 2);
+
+    // Twiddle split: exp(-i 2 pi k / n), k <= m/2
+    for (uint16_t k = 0; k <= m / 2; k++)
+    {
+      _split[2 * k] = cosf(2.0f * (float)M_PI * k / n);
+      _split[2 * k + 1] = sinf(2.0f * (float)M_PI * k / n);
+    }
+
+    // Hann periodik
+    _winSum = _winSq = 0;
+    for (uint16_t i = 0; i < n; i++)
+    {
+      _win[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / n);
+      _winSum += _win[i];
+      _winSq += _win[i] * _win[i];
+    }
+    return true;
+  }
+
+  uint16_t size() const { return _n; }
+
+  // FFT kompleks in-place (re, im berselang), m titik, urutan natural
+  void fft(float *data, uint16_t m) const
+  {
+    // Radix-2 DIF (pola dsps_fft2r_fc32): output bit-reversed
+    for (uint16_t n2 = m / 2, ie = 1; n2 > 0; n2 >>= 1, ie <<= 1)
+    {
+      uint16_t ia = 0;
+      for (uint16_t j = 0; j < ie; j++)
+      {
+        float c = _tw[2 * j], s = _tw[2 * j + 1];
+        for (uint16_t i = 0; i < n2; i++, ia++)
+        {
+          uint16_t mIdx = ia + n2;
+          float re = c * data[2 * mIdx] + s * data[2 * mIdx + 1];
+          float im = c * data[2 * mIdx + 1] - s * data[2 * mIdx];
+          data[2 * mIdx] = data[2 * ia] - re;
+          data[2 * mIdx + 1] = data[2 * ia + 1] - im;
+          data[2 * ia] += re;
+          data[2 * ia + 1] += im;
+        }
+        ia += n2;
+      }
+    }
+    bitReverse(data, m);
+  }
+
+  // x: size() sampel, fs: Hz, edges: bandCount + 1 batas pita (Hz, naik)
+  void analyze(const float *x, float fs, const float *edges, uint8_t bandCount, VibrationFeatures &f)
+  {
+    uint16_t n = _n, m = n / 2;
+    memset(&f, 0, sizeof(f));
+
+    // Domain waktu
+    double sum = 0;
+    for (uint16_t i = 0; i < n; i++)
+      sum += x[i];
+    float mean = (float)(sum / n);
+    double sq = 0;
+    float peak = 0;
+    for (uint16_t i = 0; i < n; i++)
+    {
+      float v = x[i] - mean;
+      sq += v * v;
+      if (fabsf(v) > peak)
+        peak = fabsf(v);
+    }
+    f.mean = mean;
+    f.rms = sqrtf((float)(sq / n));
+    f.peak = peak;
+    f.crest = f.rms > 0 ? peak / f.rms : 0;
+
+    // Window + kemas real -> kompleks m titik, FFT
+    for (uint16_t i = 0; i < n; i++)
+      _work[i] = (x[i] - mean) * _win[i];
+    fft(_work, m);
+
+    // Split: power |X[k]|^2 untuk k dan m-k sekaligus, ditulis ke _work[2k]
+    // (slot Z[k] & Z[m-k] hanya dipakai pasangan ini)
+    float z0r = _work[0], z0i = _work[1];
+    _work[0] = (z0r + z0i) * (z0r + z0i); // DC
+    for (uint16_t k = 1; k <= m / 2; k++)
+    {
+      float ar = _work[2 * k], ai = _work[2 * k + 1];
+      float br = _work[2 * (m - k)], bi = -_work[2 * (m - k) + 1]; // conj(Z[m-k])
+      float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);          // Xe
+      float or_ = 0.5f * (ai - bi), oi = -0.5f * (ar - br);        // Xo = (A - B) / 2i
+      float c = _split[2 * k], s = -_split[2 * k + 1];             // W^k = c + i s
+      float tr = c * or_ - s * oi, ti = c * oi + s * or_;          // W^k * Xo
+      _work[2 * k] = (er + tr) * (er + tr) + (ei + ti) * (ei + ti);
+      _work[2 * (m - k)] = (er - tr) * (er - tr) + (ei - ti) * (ei - ti); // X[m-k] = conj(Xe - W^k Xo)
+    }
+
+    // Frekuensi dominan (tanpa DC)
+    float binHz = fs / n;
+    uint16_t best = 1;
+    for (uint16_t k = 2; k < m; k++)
+    {
+      if (power(k) > power(best))
+        best = k;
+    }
+    float delta = 0;
+    if (best > 1 && best < m - 1 && power(best) > 0)
+    {
+      float a = logf(power(best - 1) + 1e-30f), b = logf(power(best)), g = logf(power(best + 1) + 1e-30f);
+      float den = a - 2 * b + g;
+      delta = den != 0 ? 0.5f * (a - g) / den : 0;
+    }
+    f.domFreq = (best + delta) * binHz;
+    f.domAmp = 2.0f * sqrtf(power(best)) / _winSum;
+
+    // RMS per pita (Parseval, dinormalisasi energi window)
+    f.bandCount = bandCount > SPECTRUM_MAX_BANDS ? SPECTRUM_MAX_BANDS : bandCount;
+    float norm = 2.0f / ((float)n * _winSq);
+    for (uint8_t b = 0; b < f.bandCount; b++)
+    {
+      int k0 = (int)ceilf(edges[b] / binHz);
+      int k1 = (int)ceilf(edges[b + 1] / binHz);
+      double e = 0;
+      for (int k = k0 < 1 ? 1 : k0; k < k1 && k < m; k++)
+        e += power(k);
+      f.bandRms[b] = sqrtf((float)(e * norm));
+    }
+  }
+
+private:
+  float power(uint16_t k) const { return _work[2 * k]; }
+
+  // Tukar elemen kompleks ke posisi bit-reversed (pola dsps_bit_rev_fc32)
+  static void bitReverse(float *data, uint16_t m)
+  {
+    for (uint16_t i = 1, j = 0; i < m; i++)
+    {
+      uint16_t bit = m >> 1;
+      for (; j & bit; bit >>= 1)
+        j ^= bit;
+      j ^= bit;
+      if (i < j)
+      {
+        float re = data[2 * i], im = data[2 * i + 1];
+        data[2 * i] = data[2 * j];
+        data[2 * i + 1] = data[2 * j + 1];
+        data[2 * j] = re;
+        data[2 * j + 1] = im;
+      }
+    }
+  }
+
+  uint16_t _n = 0;
+  float _winSum = 0, _winSq = 0;
+  float _tw[SPECTRUM_MAX_N / 2];        // m/2 twiddle kompleks
+  float _split[SPECTRUM_MAX_N / 2 + 2]; // m/2 + 1 twiddle kompleks
+  float _win[SPECTRUM_MAX_N];
+  float _work[SPECTRUM_MAX_N]; // m titik kompleks, lalu power spectrum
+};
+
+#endif
@@ -0,0 +1,431 @@
+#ifndef SPI_BUS_MANAGER_HPP
+#define SPI_BUS_MANAGER_HPP
+
+#include <Arduino.h>
+#include <FS.h>
+#include <ArduinoJson.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "Trace.hpp"
+
+// ============================================================================
+// SPI BUS MANAGER (W5500 + SD CARD)
+// W5500 memakai spi_master langsung, sehingga transaksi Ethernet otomatis
+// diselipkan di antara perintah SD. Yang perlu diatur di sini adalah siapa
+// yang boleh memakai SD dan berapa lama: tiap client meminta "lease" dengan
+// prioritas dan batas waktu pegang (maxHold). Operasi SD panjang dipecah per
+// sektor (SPI_BUS_SLICE_BYTES) dan memanggil lease.yield() di antara slice,
+// jadi Ethernet dan client prioritas lebih tinggi tidak menunggu detikan.
+// ============================================================================
+
+#define SPI_BUS_SLICE_BYTES 512 // satu sektor SD per slice
+// File.flush() (sinkron FAT + direktori, beberapa sektor tulis) hanya tiap
+// SPI_BUS_FLUSH_BYTES dan di finish(), bukan per slice. Data yang belum di-flush
+// ada di cache sektor FATFS (RAM), jadi bus aman dilepas di antara slice.
+#define SPI_BUS_FLUSH_BYTES (32 * SPI_BUS_SLICE_BYTES)
+#define SPI_BUS_MAX_WAITERS 6
+#define SPI_BUS_WAIT_FOREVER UINT32_MAX
+
+enum SpiBusClient : uint8_t
+{
+  SPI_CLIENT_SYSTEM = 0, // mount SD saat boot
+  SPI_CLIENT_SD_LOG,     // Task_DataLogger: simpan data offline
+  SPI_CLIENT_SD_BACKUP,  // Task_DataLogger: baca ulang backup untuk dikirim
+  SPI_CLIENT_SD_CONFIG,  // mirror config dari ConfigStore
+  SPI_CLIENT_COUNT
+};
+
+enum SpiBusPriority : uint8_t
+{
+  SPI_PRIO_LOW = 0,
+  SPI_PRIO_NORMAL,
+  SPI_PRIO_HIGH
+};
+
+struct SpiBusClientStats
+{
+  uint32_t grants;
+  uint32_t timeouts;
+  uint32_t overruns;   // lease dipegang lebih lama dari maxHold
+  uint64_t waitTotalUs;
+  uint32_t waitMaxUs;
+  uint32_t holdMaxUs;
+};
+
+class SpiBusManager
+{
+public:
+  bool begin()
+  {
+    _state = xSemaphoreCreateMutex();
+    if (!_state)
+      return false;
+    for (int i = 0; i < SPI_BUS_MAX_WAITERS; i++)
+    {
+      _waiters[i].sem = xSemaphoreCreateBinary();
+      if (!_waiters[i].sem)
+        return false;
+    }
+    return true;
+  }
+
+  // Minta bus. Return false jika timeout; wait time dicatat per client.
+  bool acquire(SpiBusClient client, SpiBusPriority prio, uint32_t timeoutMs, uint32_t maxHoldMs)
+  {
+    int64_t t0 = esp_timer_get_time();
+    bool granted = false;
+    traceBegin(TR_SPI_WAIT);
+
+    xSemaphoreTake(_state, portMAX_DELAY);
+    if (!_busy && !waiterAtOrAboveLocked(prio))
+    {
+      grantLocked(client, prio, maxHoldMs);
+      granted = true;
+    }
+    else
+    {
+      int w = allocWaiterLocked();
+      if (w >= 0)
+      {
+        Waiter &me = _waiters[w];
+        me.client = client;
+        me.prio = prio;
+        me.maxHoldMs = maxHoldMs;
+        me.seq = _seq++;
+        me.granted = false;
+        refreshWaitingLocked();
+        xSemaphoreGive(_state);
+
+        TickType_t ticks = (timeoutMs == SPI_BUS_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+        bool woke = xSemaphoreTake(me.sem, ticks) == pdTRUE;
+
+        xSemaphoreTake(_state, portMAX_DELAY);
+        if (!woke && me.granted)
+          xSemaphoreTake(me.sem, 0); // diberi bus tepat setelah timeout: tetap diterima
+        granted = me.granted;
+        me.used = false;
+        refreshWaitingLocked();
+      }
+    }
+
+    uint32_t waitUs = (uint32_t)(esp_timer_get_time() - t0);
+    SpiBusClientStats &st = _stats[client];
+    if (granted)
+    {
+      st.grants++;
+      st.waitTotalUs += waitUs;
+      if (waitUs > st.waitMaxUs)
+        st.waitMaxUs = waitUs;
+    }
+    else
+    {
+      st.timeouts++;
+    }
+    xSemaphoreGive(_state);
+    traceEnd(TR_SPI_WAIT);
+    if (granted && _grantHook)
+      _grantHook();
+    if (granted)
+      traceBegin(TR_SPI_HOLD);
+    return granted;
+  }
+
+  // Dipanggil di task peminta setiap lease diberikan, sebelum transaksi SD
+  // pertama (clock W5500 diturunkan selama SD aktif, lihat NetworkFunctions)
+  void setGrantHook(void (*hook)()) { _grantHook = hook; }
+
+  // ms sejak bus terakhir lepas tanpa pemegang berikutnya; 0 = sedang dipakai
+  uint32_t idleMs()
+  {
+    xSemaphoreTake(_state, portMAX_DELAY);
+    uint32_t ms = _busy ? 0 : (uint32_t)((esp_timer_get_time() - _idleSince) / 1000);
+    xSemaphoreGive(_state);
+    return ms;
+  }
+
+  // Lepas bus, langsung diserahkan ke waiter prioritas tertinggi (FIFO per prioritas)
+  void release()
+  {
+    xSemaphoreTake(_state, portMAX_DELAY);
+    if (!_busy)
+    {
+      xSemaphoreGive(_state);
+      return;
+    }
+    traceEnd(TR_SPI_HOLD);
+
+    uint32_t holdUs = (uint32_t)(esp_timer_get_time() - _holdStart);
+    SpiBusClientStats &st = _stats[_owner];
+    if (holdUs > st.holdMaxUs)
+      st.holdMaxUs = holdUs;
+    if (holdUs > _maxHoldMs * 1000UL)
+      st.overruns++;
+
+    int next = nextWaiterLocked();
+    if (next >= 0)
+    {
+      Waiter &w = _waiters[next];
+      w.granted = true;
+      grantLocked(w.client, w.prio, w.maxHoldMs);
+      xSemaphoreGive(w.sem);
+    }
+    else
+    {
+      _busy = false;
+      _idleSince = esp_timer_get_time();
+    }
+    xSemaphoreGive(_state);
+  }
+
+  // true jika pemegang lease sebaiknya melepas bus di batas slice berikutnya
+  bool shouldYield()
+  {
+    // _holdStart 64-bit: dibaca di bawah _state agar tidak sobek terhadap grant
+    xSemaphoreTake(_state, portMAX_DELAY);
+    bool yield = _busy &&
+                 ((uint64_t)(esp_timer_get_time() - _holdStart) >= (uint64_t)_maxHoldMs * 1000ULL ||
+                  _topWaiting > (uint8_t)(_prio + 1));
+    xSemaphoreGive(_state);
+    return yield;
+  }
+
+  void printStats()
+  {
+    static const char *names[SPI_CLIENT_COUNT] = {"system", "sdLog", "sdBackup", "sdConfig"};
+    for (int i = 0; i < SPI_CLIENT_COUNT; i++)
+    {
+      const SpiBusClientStats &st = _stats[i];
+      if (st.grants == 0 && st.timeouts == 0)
+        continue;
+      Serial.printf("[SPI] %-8s grant:%u timeout:%u overrun:%u wait avg:%uus max:%uus hold max:%uus\n",
+                    names[i], st.grants, st.timeouts, st.overruns,
+                    st.grants ? (uint32_t)(st.waitTotalUs / st.grants) : 0,
+                    st.waitMaxUs, st.holdMaxUs);
+    }
+  }
+
+  void statsToJson(JsonObject obj)
+  {
+    static const char *names[SPI_CLIENT_COUNT] = {"system", "sdLog", "sdBackup", "sdConfig"};
+    for (int i = 0; i < SPI_CLIENT_COUNT; i++)
+    {
+      const SpiBusClientStats &st = _stats[i];
+      JsonObject c = obj.createNestedObject(names[i]);
+      c["grants"] = st.grants;
+      c["timeouts"] = st.timeouts;
+      c["overruns"] = st.overruns;
+      c["waitAvgUs"] = st.grants ? (uint32_t)(st.waitTotalUs / st.grants) : 0;
+      c["waitMaxUs"] = st.waitMaxUs;
+      c["holdMaxUs"] = st.holdMaxUs;
+    }
+  }
+
+private:
+  struct Waiter
+  {
+    bool used;
+    volatile bool granted;
+    SpiBusClient client;
+    SpiBusPriority prio;
+    uint32_t maxHoldMs;
+    uint32_t seq;
+    SemaphoreHandle_t sem;
+  };
+
+  void grantLocked(SpiBusClient client, SpiBusPriority prio, uint32_t maxHoldMs)
+  {
+    _busy = true;
+    _owner = client;
+    _prio = prio;
+    _maxHoldMs = maxHoldMs;
+    _holdStart = esp_timer_get_time();
+    refreshWaitingLocked();
+  }
+
+  int allocWaiterLocked()
+  {
+    for (int i = 0; i < SPI_BUS_MAX_WAITERS; i++)
+    {
+      if (!_waiters[i].used)
+      {
+        _waiters[i].used = true;
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  int nextWaiterLocked()
+  {
+    int best = -1;
+    for (int i = 0; i < SPI_BUS_MAX_WAITERS; i++)
+    {
+      const Waiter &w = _waiters[i];
+      if (!w.used || w.granted)
+        continue;
+      if (best < 0 || w.prio > _waiters[best].prio ||
+          (w.prio == _waiters[best].prio && (int32_t)(w.seq - _waiters[best].seq) < 0))
+        best = i;
+    }
+    return best;
+  }
+
+  bool waiterAtOrAboveLocked(SpiBusPriority prio)
+  {
+    for (int i = 0; i < SPI_BUS_MAX_WAITERS; i++)
+    {
+      if (_waiters[i].used && !_waiters[i].granted && _waiters[i].prio >= prio)
+        return true;
+    }
+    return false;
+  }
+
+  // _topWaiting = prioritas tertinggi yang sedang menunggu + 1 (0 = tidak ada waiter)
+  void refreshWaitingLocked()
+  {
+    uint8_t top = 0;
+    for (int i = 0; i < SPI_BUS_MAX_WAITERS; i++)
+    {
+      if (_waiters[i].used && !_waiters[i].granted && _waiters[i].prio + 1 > top)
+        top = _waiters[i].prio + 1;
+    }
+    _topWaiting = top;
+  }
+
+  SemaphoreHandle_t _state = NULL;
+  Waiter _waiters[SPI_BUS_MAX_WAITERS] = {};
+  uint32_t _seq = 0;
+
+  volatile bool _busy = false;
+  volatile SpiBusClient _owner = SPI_CLIENT_SYSTEM;
+  volatile SpiBusPriority _prio = SPI_PRIO_LOW;
+  volatile uint8_t _topWaiting = 0;
+  uint32_t _maxHoldMs = 0;
+  int64_t _holdStart = 0;
+  int64_t _idleSince = 0;
+  void (*_grantHook)() = NULL;
+
+  SpiBusClientStats _stats[SPI_CLIENT_COUNT] = {};
+};
+
+SpiBusManager spiBus;
+
+// ============================================================================
+// LEASE: pegang bus selama scope, lepas otomatis di destructor
+// ============================================================================
+class SpiBusLease
+{
+public:
+  SpiBusLease(SpiBusClient client, SpiBusPriority prio, uint32_t timeoutMs, uint32_t maxHoldMs)
+      : _client(client), _prio(prio), _maxHoldMs(maxHoldMs), _timeoutMs(timeoutMs)
+  {
+    _held = spiBus.acquire(client, prio, timeoutMs, maxHoldMs);
+  }
+
+  ~SpiBusLease() { release(); }
+
+  explicit operator bool() const { return _held; }
+
+  void release()
+  {
+    if (_held)
+    {
+      spiBus.release();
+      _held = false;
+    }
+  }
+
+  bool reacquire()
+  {
+    if (!_held)
+      _held = spiBus.acquire(_client, _prio, _timeoutMs, _maxHoldMs);
+    return _held;
+  }
+
+  // Dipanggil di batas slice: lepas bus jika maxHold habis / ada waiter lebih tinggi
+  bool yield()
+  {
+    if (!_held || !spiBus.shouldYield())
+      return _held;
+    release();
+    taskYIELD();
+    return reacquire();
+  }
+
+private:
+  SpiBusClient _client;
+  SpiBusPriority _prio;
+  uint32_t _maxHoldMs;
+  uint32_t _timeoutMs;
+  bool _held = false;
+};
+
+// ============================================================================
+// SLICED WRITER: tulis ke File per sektor, yield bus di antara sektor
+// ============================================================================
+class SpiSliceWriter : public Print
+{
+public:
+  SpiSliceWriter(File &file, SpiBusLease &lease) : _file(file), _lease(lease) {}
+
+  size_t write(uint8_t c) override
+  {
+    _buf[_len++] = c;
+    if (_len == SPI_BUS_SLICE_BYTES)
+      flushSlice();
+    return _failed ? 0 : 1;
+  }
+
+  size_t write(const uint8_t *data, size_t size) override
+  {
+    size_t done = 0;
+    while (done < size && !_failed)
+    {
+      size_t n = min(size - done, (size_t)(SPI_BUS_SLICE_BYTES - _len));
+      memcpy(_buf + _len, data + done, n);
+      _len += n;
+      done += n;
+      if (_len == SPI_BUS_SLICE_BYTES)
+        flushSlice();
+    }
+    return done;
+  }
+
+  // Tulis sisa buffer. Return false jika ada slice yang gagal ditulis.
+  bool finish()
+  {
+    flushSlice();
+    if (!_failed && _unsynced)
+      _file.flush();
+    _unsynced = 0;
+    return !_failed;
+  }
+
+private:
+  void flushSlice()
+  {
+    if (_len == 0 || _failed)
+      return;
+    if (_file.write(_buf, _len) != _len)
+      _failed = true;
+    _unsynced += _len;
+    if (_unsynced >= SPI_BUS_FLUSH_BYTES)
+    {
+      _file.flush();
+      _unsynced = 0;
+    }
+    _len = 0;
+    if (!_lease.yield())
+      _failed = true;
+  }
+
+  File &_file;
+  SpiBusLease &_lease;
+  uint8_t _buf[SPI_BUS_SLICE_BYTES];
+  size_t _len = 0;
+  size_t _unsynced = 0; // byte ditulis sejak flush terakhir
+  bool _failed = false;
+};
+
+#endif
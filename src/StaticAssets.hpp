@@ -0,0 +1,141 @@
+#ifndef STATIC_ASSETS_HPP
+#define STATIC_ASSETS_HPP
+
+#include <Arduino.h>
+#include <FS.h>
+#include <ESPAsyncWebServer.h>
+#include <vector>
+#include "esp32/rom/crc.h"
+
+// ============================================================================
+// STATIC ASSETS (gzip + ETag)
+// Aset di SPIFFS sudah di-gzip oleh scripts/gzip_web_assets.py saat buildfs.
+// Handler ini mengirim <file>.gz dengan Content-Encoding: gzip (lewat
+// AsyncFileResponse), menambahkan ETag kuat dari /etags.txt, dan menjawab
+// 304 Not Modified tanpa membuka file jika If-None-Match cocok.
+// File .json (config runtime) tidak pernah disajikan dari sini.
+// ============================================================================
+
+struct StaticAsset
+{
+  String path; // path URL (tanpa .gz)
+  String etag; // sudah dalam tanda kutip, siap dipakai di header
+};
+
+class StaticAssetHandler : public AsyncWebHandler
+{
+public:
+  void begin(fs::FS &fs)
+  {
+    _fs = &fs;
+    _assets.clear();
+
+    File manifest = fs.open("/etags.txt", "r");
+    if (manifest)
+    {
+      while (manifest.available())
+      {
+        String line = manifest.readStringUntil('\n');
+        line.trim();
+        int sp = line.indexOf(' ');
+        if (sp > 0)
+          _assets.push_back({line.substring(0, sp), "\"" + line.substring(sp + 1) + "\""});
+      }
+      manifest.close();
+    }
+    else
+    {
+      // Image SPIFFS dibuat tanpa script gzip: hitung CRC isi file sekali saat boot
+      Serial.println("[WEB] /etags.txt not found, computing ETags from file content");
+      scanFiles();
+    }
+
+    Serial.printf("[WEB] %u static assets registered\n", (unsigned)_assets.size());
+  }
+
+  // Kirim aset dengan ETag/304. Dipakai juga oleh route yang butuh auth dulu.
+  bool send(AsyncWebServerRequest *request, const String &path, const String &contentType = String())
+  {
+    const StaticAsset *asset = find(path);
+    if (!asset)
+      return false;
+
+    const char *cacheControl = path.endsWith(".html") ? "no-cache" : "max-age=86400";
+
+    if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == asset->etag)
+    {
+      AsyncWebServerResponse *notModified = request->beginResponse(304);
+      notModified->addHeader("ETag", asset->etag);
+      notModified->addHeader("Cache-Control", cacheControl);
+      request->send(notModified);
+      return true;
+    }
+
+    // AsyncFileResponse membuka <path>.gz jika <path> tidak ada dan memasang Content-Encoding
+    AsyncWebServerResponse *response = request->beginResponse(*_fs, path, contentType);
+    response->addHeader("ETag", asset->etag);
+    response->addHeader("Cache-Control", cacheControl);
+    request->send(response);
+    return true;
+  }
+
+  bool canHandle(AsyncWebServerRequest *request) override
+  {
+    return request->method() == HTTP_GET && find(request->url()) != nullptr;
+  }
+
+  void handleRequest(AsyncWebServerRequest *request) override
+  {
+    send(request, request->url());
+  }
+
+  bool isRequestHandlerTrivial() override { return false; }
+
+private:
+  const StaticAsset *find(const String &path) const
+  {
+    for (const StaticAsset &a : _assets)
+    {
+      if (a.path == path)
+        return &a;
+    }
+    return nullptr;
+  }
+
+  void scanFiles()
+  {
+    File root = _fs->open("/");
+    File file = root.openNextFile();
+    uint8_t buf[512];
+
+    while (file)
+    {
+      String name = file.path();
+      if (!name.startsWith("/"))
+        name = "/" + name;
+
+      if (!file.isDirectory() && !name.endsWith(".json"))
+      {
+        uint32_t crc = 0;
+        size_t n;
+        while ((n = file.read(buf, sizeof(buf))) > 0)
+          crc = crc32_le(crc, buf, n);
+
+        String path = name.endsWith(".gz") ? name.substring(0, name.length() - 3) : name;
+        char tag[24];
+        snprintf(tag, sizeof(tag), "\"%08x-%x\"", crc, (unsigned)file.size());
+        _assets.push_back({path, String(tag)});
+      }
+      file.close();
+      file = root.openNextFile();
+    }
+    root.close();
+  }
+
+  fs::FS *_fs = nullptr;
+  std::vector<StaticAsset> _assets;
+};
+
+StaticAssetHandler staticAssets;
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef TASK_MESSAGES_HPP
+#define TASK_MESSAGES_HPP
+
+#include <Arduino.h>
+#include <type_traits>
+#include "config.hpp"
+#include "RuntimeConfig.hpp"
+
+// ============================================================================
+// TASK MESSAGES (paket queue antar task)
+// xQueueSend menyalin paket byte per byte, jadi semua paket di sini harus
+// trivially copyable & ukuran tetap: tidak boleh ada String / pointer ke heap
+// (salinan String = dua objek menunjuk buffer yang sama -> leak / double free).
+//
+// Peta producer -> consumer:
+//   Task_DataAcquisition --queueSensorData--> Task_DataLogger
+//       SensorDataPacket, satu per siklus akuisisi (semua AI + DI)
+//   Task_ModbusClient    --queueModbusData--> Task_DataLogger
+//       ChannelBatchPacket, sampai CHANNEL_BATCH_MAX tag per paket
+//       (64 tag = 4 xQueueSend per scan, bukan 64)
+//   MQTT / HTTP / WebSocket / Modbus TCP --commandQueue--> Task_ModbusClient
+//       WriteCommand, dua tingkat prioritas (lihat CommandQueue.hpp);
+//       DO lokal langsung diterapkan di task pengirim, tidak lewat queue
+//   Task_DataAcquisition --queueAlarmEvents--> Task_DataLogger
+//       AlarmEvent per transisi alarm (aktif / normal), langsung ke uplink & SD
+// Hanya Task_DataLogger yang menulis nilai kanal ke jsonSend.
+//
+// Kanal dikirim sebagai ChannelId (jenis + index), bukan nama. Nama di-resolve
+// consumer dari snapshot RuntimeConfig dengan generation yang sama, jadi paket
+// dari tabel tag lama tidak salah label setelah config berubah.
+// ============================================================================
+
+enum ChannelKind : uint8_t
+{
+  CH_AI = 0,
+  CH_DI,
+  CH_MODBUS
+};
+
+struct ChannelId
+{
+  uint8_t kind;  // ChannelKind
+  uint8_t index; // AI/DI 1-based, Modbus = index tag (0-based)
+};
+
+inline ChannelId channelId(ChannelKind kind, uint8_t index)
+{
+  ChannelId id;
+  id.kind = kind;
+  id.index = index;
+  return id;
+}
+
+// Nama kanal dari snapshot config, "" kalau index di luar tabel
+inline const char *channelName(const RuntimeConfig *cfg, ChannelId id)
+{
+  switch (id.kind)
+  {
+  case CH_AI:
+    return id.index >= 1 && id.index <= jumlahInputAnalog ? cfg->ai[id.index].name : "";
+  case CH_DI:
+    return id.index >= 1 && id.index <= jumlahInputDigital ? cfg->di[id.index].name : "";
+  case CH_MODBUS:
+    return id.index < cfg->tagCount ? cfg->tags[id.index].name : "";
+  }
+  return "";
+}
+
+struct ChannelSample
+{
+  ChannelId id;
+  uint8_t status; // ModbusFrameResult untuk CH_MODBUS, 0 = OK
+  float value;
+};
+
+// Satu siklus akuisisi (index 1-based seperti analogInput[] / digitalInput[])
+struct SensorDataPacket
+{
+  float analogValues[jumlahInputAnalog + 1];
+  float digitalValues[jumlahInputDigital + 1];
+  uint32_t timestamp;
+};
+
+#define CHANNEL_BATCH_MAX 16
+
+struct ChannelBatchPacket
+{
+  uint32_t generation; // RuntimeConfig::generation saat sampel diambil
+  uint32_t timestamp;
+  uint8_t count;
+  ChannelSample samples[CHANNEL_BATCH_MAX];
+
+  void reset(uint32_t gen)
+  {
+    generation = gen;
+    timestamp = millis();
+    count = 0;
+  }
+
+  bool full() const { return count >= CHANNEL_BATCH_MAX; }
+
+  void add(ChannelId id, float value, uint8_t status)
+  {
+    if (full())
+      return;
+    samples[count].id = id;
+    samples[count].status = status;
+    samples[count].value = value;
+    count++;
+  }
+};
+
+// Perintah tulis: DO lokal atau coil/holding register perangkat di bus RS-485
+enum CommandTarget : uint8_t
+{
+  CMD_TARGET_DO = 0, // DO lokal, addr = index DO (1-based)
+  CMD_TARGET_RTU     // perangkat RS-485 (unit, fc, addr)
+};
+
+enum CommandSource : uint8_t
+{
+  CMD_SRC_MQTT = 0,
+  CMD_SRC_HTTP,
+  CMD_SRC_MODBUS,
+  CMD_SRC_WS,    // WebSocket /ws (CommandSocket.hpp)
+  CMD_SRC_ALARM, // interlock AlarmEngine
+  CMD_SRC_COUNT
+};
+
+enum CommandPriority : uint8_t
+{
+  CMD_PRIO_NORMAL = 0,
+  CMD_PRIO_HIGH // mis. stop / interlock: diambil sebelum antrean normal
+};
+
+#define COMMAND_MAX_VALUES 16
+
+struct WriteCommand
+{
+  uint32_t id; // diisi commandQueue.submit()
+  uint8_t target;   // CommandTarget
+  uint8_t source;   // CommandSource
+  uint8_t priority; // CommandPriority
+  bool verify;      // baca ulang setelah tulis
+  uint8_t unit, fc; // fc: 5/6/15/16 (DO lokal: 5)
+  uint16_t addr, count;
+  uint16_t values[COMMAND_MAX_VALUES];
+  uint32_t pulseMs;    // DO saja: > 0 = value selama pulseMs lalu kembali
+  int64_t submittedUs; // esp_timer_get_time() saat masuk antrean
+};
+
+// Transisi alarm; nama di-resolve logger dari snapshot dengan generation sama
+struct AlarmEvent
+{
+  uint32_t generation;
+  uint32_t timestamp; // millis() saat transisi
+  uint8_t alarm;      // index RuntimeConfig::alarms
+  bool active;
+  float value;
+};
+
+static_assert(std::is_trivially_copyable<SensorDataPacket>::value, "SensorDataPacket harus trivially copyable");
+static_assert(std::is_trivially_copyable<ChannelBatchPacket>::value, "ChannelBatchPacket harus trivially copyable");
+static_assert(std::is_trivially_copyable<WriteCommand>::value, "WriteCommand harus trivially copyable");
+static_assert(std::is_trivially_copyable<AlarmEvent>::value, "AlarmEvent harus trivially copyable");
+
+#endif
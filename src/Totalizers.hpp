@@ -0,0 +1,315 @@
+#ifndef TOTALIZERS_HPP
+#define TOTALIZERS_HPP
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <RTClib.h>
+#include "config.hpp"
+#include "Metrics.hpp"
+#include "RuntimeConfig.hpp"
+#include "ModbusSlave.hpp"
+#include "VirtualChannels.hpp"
+
+// ============================================================================
+// TOTALIZERS (flow -> volume, daya -> energi, di device)
+//   "totalizers": [["Total Flow", "AI1", "h", 0.5, "daily", 6], ...]
+// Rate diintegralkan trapesium atas timestamp sampel ASLI: AI = saat ADC
+// kanal itu dibaca, tag Modbus = saat read sukses terakhir (read gagal tidak
+// dihitung sebagai 0), DI & kanal virtual = siklus akuisisi. Jeda antar
+// sampel > max(TOTALIZER_MAX_GAP_MS, 3x scan rate) tidak diintegralkan
+// (putus komunikasi), dihitung di iot_totalizer_gaps_total.
+// |rate| < cutoff dianggap 0 (low-flow cutoff, menahan drift zero 4 mA).
+//
+// Reset terjadwal (jam lokal RTC, dicek Task_DataLogger): total periode
+// berjalan dipindah ke lastPeriod lalu mulai dari 0. Device mati melewati
+// batas periode -> reset saat waktu pertama terbaca setelah boot.
+//
+// Akumulator double, disimpan ke NVS (namespace "tot", satu blob) paling
+// sering tiap TOTALIZER_PERSIST_MS jika berubah, segera setelah reset, dan
+// sebelum restart dari web. NVS men-wear-level sendiri; 8 totalizer tiap
+// 10 menit ~ 144 tulis/hari, jauh di bawah umur flash. Kehilangan saat
+// listrik putus dibatasi satu interval simpan.
+// State dicocokkan per NAMA saat config berubah, jadi edit config lain tidak
+// mereset total.
+// ============================================================================
+
+#define TOTALIZER_MAX_GAP_MS 60000
+#define TOTALIZER_PERSIST_MS 600000UL
+#define TOTALIZER_NAMESPACE "tot"
+#define TOTALIZER_MAGIC 0x544F5431UL // "TOT1"
+
+struct TotalizerRecord
+{
+  char name[32];
+  double total, lastPeriod;
+  uint32_t periodKey; // jenis reset << 28 | nomor periode berjalan, 0 = belum diketahui
+};
+
+class Totalizers
+{
+public:
+  // Setup: muat akumulator tersimpan (dicocokkan ke config di evaluate() pertama)
+  void begin()
+  {
+    Image img;
+    Preferences prefs;
+    if (!prefs.begin(TOTALIZER_NAMESPACE, true))
+      return;
+    bool ok = prefs.getBytes("acc", &img, sizeof(img)) == sizeof(img) &&
+              img.magic == TOTALIZER_MAGIC && img.count <= RUNTIME_MAX_TOTALIZERS;
+    prefs.end();
+    if (!ok)
+      return;
+    for (uint8_t n = 0; n < img.count; n++)
+      _slot[n].rec = img.rec[n];
+    _count = img.count;
+    Serial.printf("[TOT] %u totalizer restored from NVS\n", _count);
+  }
+
+  // Task_DataAcquisition, setelah kanal virtual
+  void evaluate(const RuntimeConfig *cfg, uint32_t nowMs)
+  {
+    if (cfg->generation != _generation)
+      remap(cfg);
+
+    uint32_t maxGapMs = max((uint32_t)TOTALIZER_MAX_GAP_MS, 3 * cfg->scanRateMs);
+    for (uint8_t n = 0; n < cfg->totalizerCount; n++)
+    {
+      const TotalizerConfig &t = cfg->totalizers[n];
+      Slot &s = _slot[n];
+      float value;
+      uint32_t sampleMs = sample(t.slot, value, nowMs);
+      if (!sampleMs || sampleMs == s.sampleMs)
+        continue; // belum ada sampel baru
+      if (isnan(value))
+      {
+        s.sampleMs = 0; // nilai tidak valid: putus, mulai lagi dari sampel berikutnya
+        continue;
+      }
+      if (fabsf(value) < t.cutoff)
+        value = 0;
+
+      uint32_t dtMs = sampleMs - s.sampleMs;
+      bool integrate = s.sampleMs && dtMs <= maxGapMs;
+      if (s.sampleMs && !integrate)
+        mTotalizerGaps.inc();
+      float prev = s.value;
+      s.value = value;
+      s.sampleMs = sampleMs;
+      if (!integrate)
+        continue;
+
+      double area = (prev + value) * 0.5 * (dtMs / 1000.0) / t.timeBaseS;
+      portENTER_CRITICAL(&_mux);
+      s.rec.total += area;
+      _dirty = true;
+      portEXIT_CRITICAL(&_mux);
+    }
+  }
+
+  // Task_DataLogger (~1 Hz): reset terjadwal. localTime = detik "unix" jam lokal (RTC)
+  void schedule(uint32_t localTime)
+  {
+    portENTER_CRITICAL(&_mux);
+    for (uint8_t n = 0; n < _count; n++)
+    {
+      Slot &s = _slot[n];
+      uint32_t key = periodKey(s.reset, s.resetHour, localTime);
+      if (!key || key == s.rec.periodKey)
+        continue;
+      // Periode lewat -> reset. Key belum ada / jenis reset diganti di config:
+      // adopsi periode sekarang tanpa mereset
+      if (s.rec.periodKey >> 28 == s.reset)
+      {
+        s.rec.lastPeriod = s.rec.total;
+        s.rec.total = 0;
+        mTotalizerResets.inc();
+      }
+      s.rec.periodKey = key;
+      _urgent = true;
+    }
+    portEXIT_CRITICAL(&_mux);
+  }
+
+  bool persistDue(uint32_t nowMs)
+  {
+    portENTER_CRITICAL(&_mux);
+    bool due = _urgent || (_dirty && nowMs - _savedMs >= TOTALIZER_PERSIST_MS);
+    portEXIT_CRITICAL(&_mux);
+    return due;
+  }
+
+  void persist()
+  {
+    Image img = {};
+    img.magic = TOTALIZER_MAGIC;
+    portENTER_CRITICAL(&_mux);
+    img.count = _count;
+    for (uint8_t n = 0; n < _count; n++)
+      img.rec[n] = _slot[n].rec;
+    _dirty = _urgent = false;
+    portEXIT_CRITICAL(&_mux);
+
+    Preferences prefs;
+    bool ok = prefs.begin(TOTALIZER_NAMESPACE, false);
+    if (ok)
+    {
+      ok = prefs.putBytes("acc", &img, sizeof(img)) == sizeof(img);
+      prefs.end();
+    }
+    _savedMs = millis();
+    if (ok)
+      mTotalizerSaves.inc();
+    else
+      ESP_LOGE("TOT", "Failed to save totalizers to NVS");
+  }
+
+  // Reset manual (web): total berjalan -> lastPeriod
+  bool reset(const char *name)
+  {
+    bool found = false;
+    portENTER_CRITICAL(&_mux);
+    for (uint8_t n = 0; n < _count; n++)
+    {
+      if (strcmp(_slot[n].rec.name, name) == 0)
+      {
+        _slot[n].rec.lastPeriod = _slot[n].rec.total;
+        _slot[n].rec.total = 0;
+        _urgent = true;
+        found = true;
+      }
+    }
+    portEXIT_CRITICAL(&_mux);
+    if (found)
+      mTotalizerResets.inc();
+    return found;
+  }
+
+  uint32_t generation() const { return _generation; }
+
+  double total(uint8_t n)
+  {
+    portENTER_CRITICAL(&_mux);
+    double v = n < _count ? _slot[n].rec.total : 0;
+    portEXIT_CRITICAL(&_mux);
+    return v;
+  }
+
+  void toJson(JsonArray out)
+  {
+    Slot slots[RUNTIME_MAX_TOTALIZERS];
+    portENTER_CRITICAL(&_mux);
+    uint8_t count = _count;
+    memcpy(slots, _slot, sizeof(slots));
+    portEXIT_CRITICAL(&_mux);
+    for (uint8_t n = 0; n < count; n++)
+    {
+      JsonObject o = out.createNestedObject();
+      o["name"] = jsonKey(slots[n].rec.name);
+      o["total"] = slots[n].rec.total;
+      o["lastPeriod"] = slots[n].rec.lastPeriod;
+      o["reset"] = TOTAL_RESET_NAMES[slots[n].reset <= TOTAL_RESET_MONTHLY ? slots[n].reset : 0];
+    }
+  }
+
+private:
+  struct Slot
+  {
+    TotalizerRecord rec;
+    uint8_t reset, resetHour;
+    float value;       // sampel terakhir (cutoff sudah diterapkan)
+    uint32_t sampleMs; // timestamp sampel terakhir, 0 = belum ada
+  };
+
+  struct Image
+  {
+    uint32_t magic;
+    uint32_t count;
+    TotalizerRecord rec[RUNTIME_MAX_TOTALIZERS];
+  };
+
+  // Slot baru per config; akumulator diambil dari slot lama bernama sama
+  void remap(const RuntimeConfig *cfg)
+  {
+    Slot old[RUNTIME_MAX_TOTALIZERS];
+    portENTER_CRITICAL(&_mux);
+    uint8_t oldCount = _count;
+    memcpy(old, _slot, sizeof(old));
+    memset(_slot, 0, sizeof(_slot));
+    for (uint8_t n = 0; n < cfg->totalizerCount; n++)
+    {
+      const TotalizerConfig &t = cfg->totalizers[n];
+      Slot &s = _slot[n];
+      strlcpy(s.rec.name, t.name, sizeof(s.rec.name));
+      for (uint8_t k = 0; k < oldCount; k++)
+      {
+        if (strcmp(old[k].rec.name, t.name) == 0)
+          s.rec = old[k].rec;
+      }
+      s.reset = t.reset;
+      s.resetHour = t.resetHour;
+    }
+    _count = cfg->totalizerCount;
+    portEXIT_CRITICAL(&_mux);
+    _generation = cfg->generation;
+  }
+
+  // Nilai & timestamp sampel sumber (slot VSLOT_*), 0 = belum ada sampel
+  static uint32_t sample(uint8_t slot, float &value, uint32_t nowMs)
+  {
+    if (slot < VSLOT_DI(1))
+    {
+      uint8_t i = slot - VSLOT_AI(1) + 1;
+      value = analogInput[i].mapValue;
+      return analogInput[i].sampleMs;
+    }
+    if (slot < VSLOT_TAG(0))
+    {
+      value = digitalInput[slot - VSLOT_DI(1) + 1].value;
+      return nowMs;
+    }
+    if (slot < VSLOT_VIRTUAL(0))
+      return slaveRegisters.tagSample(slot - VSLOT_TAG(0), value);
+    value = virtualChannels.value(slot - VSLOT_VIRTUAL(0));
+    return nowMs;
+  }
+
+  // Periode reset untuk waktu lokal t; 0 = tanpa jadwal / RTC belum valid
+  static uint32_t periodKey(uint8_t reset, uint8_t hour, uint32_t t)
+  {
+    if (reset == TOTAL_RESET_NONE || t < 1577836800UL) // < 2020-01-01
+      return 0;
+    uint32_t period;
+    uint32_t day = (t - hour * 3600UL) / 86400; // periode mulai jam resetHour
+    if (reset == TOTAL_RESET_HOURLY)
+      period = t / 3600;
+    else if (reset == TOTAL_RESET_DAILY)
+      period = day;
+    else if (reset == TOTAL_RESET_WEEKLY)
+      period = (day + 3) / 7; // 1970-01-01 = Kamis -> minggu mulai Senin
+    else
+    {
+      DateTime d(t - hour * 3600UL);
+      period = d.year() * 12 + d.month();
+    }
+    return (uint32_t)reset << 28 | period;
+  }
+
+  Slot _slot[RUNTIME_MAX_TOTALIZERS] = {};
+  uint8_t _count = 0;
+  uint32_t _generation = 0;
+  bool _dirty = false, _urgent = false;
+  uint32_t _savedMs = 0;
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+Totalizers totalizers;
+
+// Untuk ModbusRegisterBank (SLAVE_SRC_TOTAL); index sesuai snapshot akuisisi
+double totalizerValue(uint8_t index)
+{
+  return totalizers.total(index);
+}
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <Arduino.h>
+#include <atomic>
+#include <memory>
+#include <ESPAsyncWebServer.h>
+#include "esp_timer.h"
+
+// ============================================================================
+// TRACE (ring buffer per core, export Chrome trace JSON)
+// Event begin/end (task, core, id, timestamp us) di titik penting: tunggu &
+// pegang mutex / bus SPI, baca ADC, TX/RX Modbus, HTTP POST, tulis SD, web
+// handler. Tujuannya melihat siapa memegang apa saat kirim data macet atau
+// watchdog reset, dan tabrakan antar core (buka hasil /trace di Perfetto atau
+// chrome://tracing).
+// Tulis: slot diklaim dengan fetch_add pada ring core yang sedang jalan, lalu
+// diisi dan ditandai dengan nomor urut (seq) paling akhir. Tanpa lock, aman
+// untuk task yang saling preempt. Pembaca membuang slot yang seq-nya tidak
+// cocok (sedang ditulis / sudah ditimpa).
+// ============================================================================
+
+#ifndef TRACE_EVENTS_PER_CORE
+#define TRACE_EVENTS_PER_CORE 512 // 12 byte/event -> 12 KB untuk dua core
+#endif
+#define TRACE_MAX_TASKS 16
+
+enum TraceId : uint8_t
+{
+  TR_NONE = 0,
+  TR_ADC_READ,
+  TR_MODBUS_TX,
+  TR_MODBUS_RX,
+  TR_MODBUS_TRANSACTION,
+  TR_HTTP_POST,
+  TR_SD_WRITE,
+  TR_JSON_WAIT,
+  TR_JSON_HOLD,
+  TR_I2C_WAIT,
+  TR_I2C_HOLD,
+  TR_SPI_WAIT,
+  TR_SPI_HOLD,
+  TR_WEB_HANDLER,
+  TR_CONFIG_COMMIT,
+  TR_COUNT
+};
+
+static const char *const TRACE_NAMES[TR_COUNT] = {
+    "none", "adc_read", "modbus_tx", "modbus_rx", "modbus_transaction", "http_post", "sd_write",
+    "json_mutex_wait", "json_mutex_hold", "i2c_mutex_wait", "i2c_mutex_hold",
+    "spi_bus_wait", "spi_bus_hold", "web_handler", "config_commit"};
+
+struct TraceEvent
+{
+  uint32_t seq; // index klaim + 1, ditulis terakhir (0 = kosong)
+  uint32_t tsUs;
+  uint8_t id;
+  char phase; // 'B' / 'E'
+  uint8_t task;
+  uint8_t core;
+};
+
+class TraceBuffer
+{
+public:
+  void record(uint8_t id, char phase)
+  {
+    if (id == TR_NONE)
+      return;
+    uint32_t tsUs = (uint32_t)esp_timer_get_time();
+    uint8_t task = taskIndex(xTaskGetCurrentTaskHandle());
+    int core = xPortGetCoreID();
+
+    uint32_t n = _head[core].fetch_add(1, std::memory_order_relaxed);
+    TraceEvent &e = _ring[core][n % TRACE_EVENTS_PER_CORE];
+    e.seq = 0;
+    e.tsUs = tsUs;
+    e.id = id;
+    e.phase = phase;
+    e.task = task;
+    e.core = core;
+    std::atomic_thread_fence(std::memory_order_release);
+    e.seq = n + 1;
+  }
+
+  // Kirim event windowMs terakhir sebagai Chrome trace JSON (chunked, dari
+  // salinan ring supaya tidak menahan apa pun selama transfer)
+  void sendChromeTrace(AsyncWebServerRequest *request, uint32_t windowMs)
+  {
+    std::shared_ptr<Export> ex(new (std::nothrow) Export);
+    if (!ex)
+    {
+      request->send(503, "text/plain", "Out of memory");
+      return;
+    }
+    snapshot(*ex, windowMs);
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+                                                                      [this, ex](uint8_t *buffer, size_t maxLen, size_t /*index*/) -> size_t
+                                                                      { return fill(*ex, (char *)buffer, maxLen); });
+    response->addHeader("Content-Disposition", "attachment; filename=\"trace.json\"");
+    request->send(response);
+  }
+
+private:
+  struct TaskSlot
+  {
+    std::atomic<TaskHandle_t> handle;
+    char name[configMAX_TASK_NAME_LEN];
+  };
+
+  struct Export
+  {
+    TraceEvent events[2 * TRACE_EVENTS_PER_CORE];
+    size_t count = 0;
+    size_t next = 0;  // event berikutnya yang ditulis
+    int meta = 0;     // baris metadata (nama core & task) yang sudah ditulis
+    int64_t baseUs;   // rekonstruksi timestamp 64-bit
+    uint32_t baseLow;
+    bool done = false;
+  };
+
+  // Nama task disalin saat pertama kali terlihat: handle bisa sudah tidak
+  // valid saat export
+  uint8_t taskIndex(TaskHandle_t handle)
+  {
+    for (int i = 0; i < TRACE_MAX_TASKS; i++)
+    {
+      TaskHandle_t h = _tasks[i].handle.load(std::memory_order_acquire);
+      if (h == handle)
+        return i;
+      if (h == NULL)
+      {
+        TaskHandle_t expected = NULL;
+        if (_tasks[i].handle.compare_exchange_strong(expected, handle))
+        {
+          strlcpy(_tasks[i].name, pcTaskGetTaskName(handle), sizeof(_tasks[i].name));
+          return i;
+        }
+        if (expected == handle)
+          return i;
+      }
+    }
+    return TRACE_MAX_TASKS; // tabel penuh: "other"
+  }
+
+  void snapshot(Export &ex, uint32_t windowMs)
+  {
+    int64_t now = esp_timer_get_time();
+    ex.baseUs = now;
+    ex.baseLow = (uint32_t)now;
+    uint32_t windowUs = windowMs * 1000UL;
+
+    for (int core = 0; core < 2; core++)
+    {
+      uint32_t head = _head[core].load(std::memory_order_acquire);
+      uint32_t first = head > TRACE_EVENTS_PER_CORE ? head - TRACE_EVENTS_PER_CORE : 0;
+      for (uint32_t n = first; n < head; n++)
+      {
+        TraceEvent e = _ring[core][n % TRACE_EVENTS_PER_CORE];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (e.seq != n + 1)
+          continue; // sedang ditulis / sudah ditimpa
+        if (ex.baseLow - e.tsUs > windowUs)
+          continue;
+        ex.events[ex.count++] = e;
+      }
+    }
+  }
+
+  size_t fill(Export &ex, char *out, size_t maxLen)
+  {
+    if (ex.done)
+      return 0;
+    size_t len = 0;
+    char line[160];
+
+    // Header + metadata: pid = core, tid = task
+    while (ex.meta < 2 + TRACE_MAX_TASKS + 1)
+    {
+      int n = 0;
+      int m = ex.meta;
+      if (m < 2)
+        n = snprintf(line, sizeof(line), "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"core %d\"}}",
+                     m == 0 ? "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" : ",\n", m, m);
+      else if (m - 2 < TRACE_MAX_TASKS)
+      {
+        if (_tasks[m - 2].handle.load())
+          n = snprintf(line, sizeof(line), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}"
+                                           ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                       m - 2, _tasks[m - 2].name, m - 2, _tasks[m - 2].name);
+      }
+      else
+        n = snprintf(line, sizeof(line), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"other\"}}", TRACE_MAX_TASKS);
+      if (len + n > maxLen)
+        return len;
+      memcpy(out + len, line, n);
+      len += n;
+      ex.meta++;
+    }
+
+    while (ex.next < ex.count)
+    {
+      const TraceEvent &e = ex.events[ex.next];
+      int64_t ts = ex.baseUs - (int64_t)(uint32_t)(ex.baseLow - e.tsUs);
+      int n = snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":%u,\"tid\":%u}",
+                       e.id < TR_COUNT ? TRACE_NAMES[e.id] : "?", e.phase, (long long)ts, e.core, e.task);
+      if (len + n > maxLen)
+        return len;
+      memcpy(out + len, line, n);
+      len += n;
+      ex.next++;
+    }
+
+    const char *tail = "\n]}\n";
+    size_t n = strlen(tail);
+    if (len + n > maxLen)
+      return len;
+    memcpy(out + len, tail, n);
+    ex.done = true;
+    return len + n;
+  }
+
+  TraceEvent _ring[2][TRACE_EVENTS_PER_CORE] = {};
+  std::atomic<uint32_t> _head[2] = {};
+  TaskSlot _tasks[TRACE_MAX_TASKS] = {};
+};
+
+TraceBuffer traceBuffer;
+
+inline void traceBegin(uint8_t id) { traceBuffer.record(id, 'B'); }
+inline void traceEnd(uint8_t id) { traceBuffer.record(id, 'E'); }
+
+// Span satu scope: { TraceScope t(TR_SD_WRITE); ... }
+class TraceScope
+{
+public:
+  explicit TraceScope(uint8_t id) : _id(id) { traceBegin(id); }
+  ~TraceScope() { traceEnd(_id); }
+
+private:
+  uint8_t _id;
+};
+
+#endif
@@ -0,0 +1,274 @@
+#ifndef VIBRATION_CAPTURE_HPP
+#define VIBRATION_CAPTURE_HPP
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <new>
+#include "driver/adc.h"
+#include "esp_timer.h"
+#include "config.hpp"
+#include "Metrics.hpp"
+#include "RuntimeConfig.hpp"
+#include "Spectrum.hpp"
+
+// ============================================================================
+// VIBRATION CAPTURE (motor / pompa: RMS, peak, crest factor, frekuensi
+// dominan & RMS per pita, bukan snapshot 100 ms)
+//   "vibration": {"channels":[["Pompa 1 DE", 36, 1.0], ["Pompa 1 NDE", 39, 1.0]],
+//                 "rateHz":10000, "samples":1024, "intervalS":10,
+//                 "bands":[10, 100, 500, 1000, 2500, 5000]}
+// Satu blok `samples` per kanal diambil tiap intervalS lewat ADC1 internal
+// mode DMA (driver adc_digi IDF 4.4, pendahulu adc_continuous IDF 5). ADS1115
+// tidak dipakai: maks 860 SPS dan I2C-nya dipakai bersama akuisisi AI 100 ms.
+// Kanal berselang di pola DMA, dipisah lewat tag channel tiap sampel.
+// Rate hardware ESP32 minimal VIB_ADC_MIN_RATE: rate per kanal yang lebih
+// rendah dicapai dengan oversampling + rata-rata blok (decimation).
+//
+// Driver di-init per capture lalu dilepas, jadi ADC1 bebas di antara capture.
+// Buffer sampel & SpectrumAnalyzer dialokasikan sekali saat capture pertama.
+// Hanya fitur yang keluar: Task_DataLogger menyalinnya ke jsonSend
+// (<nama>_rms, _peak, _crest, _freq, _band1..n), GET /vibration untuk detail
+// + cycles per FFT terakhir.
+// ============================================================================
+
+#ifndef VIB_ADC_SWAP_PAIRS
+// ESP32 (I2S-ADC): dua sampel 16-bit dalam satu word 32-bit DMA tersimpan
+// terbalik. 0 jika driver/board sudah mengurutkan.
+#define VIB_ADC_SWAP_PAIRS 1
+#endif
+#ifndef VIB_ADC_VOLTS_PER_LSB
+#define VIB_ADC_VOLTS_PER_LSB (3.3f / 4095) // atenuasi 11 dB, tanpa kalibrasi eFuse
+#endif
+#define VIB_ADC_MIN_RATE 20000 // SOC_ADC_SAMPLE_FREQ_THRES_LOW (ESP32)
+#define VIB_DMA_FRAME 256      // byte per baca (= conv_num_each_intr)
+#define VIB_DMA_STORE 4096     // ring buffer driver
+
+class VibrationCapture
+{
+public:
+  // Task_Vibration: capture pertama segera setelah config (re)load
+  bool due(const RuntimeConfig *cfg, uint32_t nowMs)
+  {
+    if (cfg->generation != _generation)
+    {
+      portENTER_CRITICAL(&_mux);
+      memset(_valid, 0, sizeof(_valid));
+      _generation = cfg->generation;
+      portEXIT_CRITICAL(&_mux);
+      return true;
+    }
+    return nowMs - _lastMs >= cfg->vibration.intervalMs;
+  }
+
+  void capture(const RuntimeConfig *cfg)
+  {
+    const VibrationConfig &v = cfg->vibration;
+    _lastMs = millis();
+    if (!allocate())
+      return;
+    if (!_analyzer->size() || _analyzer->size() != v.samples)
+      _analyzer->init(v.samples);
+
+    if (!start(v))
+      return;
+    bool ok = acquire(v);
+    adc_digi_stop();
+    adc_digi_deinitialize();
+    if (!ok)
+    {
+      mVibrationAborts.inc();
+      return;
+    }
+
+    for (uint8_t ch = 0; ch < v.channelCount; ch++)
+    {
+      VibrationFeatures f;
+      int64_t t0 = esp_timer_get_time();
+      uint32_t c0 = ESP.getCycleCount();
+      _analyzer->analyze(_buf[ch], (float)v.rateHz, v.bandEdges, v.bandCount, f);
+      uint32_t cycles = ESP.getCycleCount() - c0;
+      mVibrationFft.observeUs((uint32_t)(esp_timer_get_time() - t0));
+
+      portENTER_CRITICAL(&_mux);
+      _features[ch] = f;
+      _valid[ch] = true;
+      _fftCycles = cycles;
+      _updatedMs = _lastMs;
+      portEXIT_CRITICAL(&_mux);
+    }
+    mVibrationCaptures.inc();
+  }
+
+  uint32_t generation() const { return _generation; }
+
+  // Fitur terakhir kanal n (index snapshot); false jika belum ada capture
+  bool features(uint8_t n, VibrationFeatures &f)
+  {
+    portENTER_CRITICAL(&_mux);
+    bool valid = n < RUNTIME_MAX_VIBRATION && _valid[n];
+    if (valid)
+      f = _features[n];
+    portEXIT_CRITICAL(&_mux);
+    return valid;
+  }
+
+  void toJson(JsonObject out, const RuntimeConfig *cfg)
+  {
+    const VibrationConfig &v = cfg->vibration;
+    portENTER_CRITICAL(&_mux);
+    uint32_t cycles = _fftCycles, updatedMs = _updatedMs;
+    portEXIT_CRITICAL(&_mux);
+    out["rateHz"] = v.rateHz;
+    out["samples"] = v.samples;
+    out["intervalS"] = v.intervalMs / 1000;
+    out["fftCycles"] = cycles;
+    out["ageMs"] = updatedMs ? millis() - updatedMs : 0;
+    JsonArray channels = out.createNestedArray("channels");
+    for (uint8_t n = 0; n < v.channelCount; n++)
+    {
+      JsonObject o = channels.createNestedObject();
+      o["name"] = jsonKey(v.channels[n].name);
+      VibrationFeatures f;
+      if (_generation != cfg->generation || !features(n, f))
+        continue;
+      o["mean"] = f.mean;
+      o["rms"] = f.rms;
+      o["peak"] = f.peak;
+      o["crest"] = f.crest;
+      o["freq"] = f.domFreq;
+      o["amp"] = f.domAmp;
+      JsonArray bands = o.createNestedArray("bands");
+      for (uint8_t b = 0; b < f.bandCount; b++)
+      {
+        JsonObject band = bands.createNestedObject();
+        band["lo"] = v.bandEdges[b];
+        band["hi"] = v.bandEdges[b + 1];
+        band["rms"] = f.bandRms[b];
+      }
+    }
+  }
+
+private:
+  bool allocate()
+  {
+    if (_analyzer)
+      return true;
+    SpectrumAnalyzer *analyzer = new (std::nothrow) SpectrumAnalyzer;
+    float *buf = (float *)malloc(RUNTIME_MAX_VIBRATION * SPECTRUM_MAX_N * sizeof(float));
+    if (!analyzer || !buf)
+    {
+      delete analyzer;
+      free(buf);
+      ESP_LOGE("VIB", "Not enough heap for capture buffers");
+      return false;
+    }
+    for (uint8_t ch = 0; ch < RUNTIME_MAX_VIBRATION; ch++)
+      _buf[ch] = buf + ch * SPECTRUM_MAX_N;
+    _analyzer = analyzer;
+    return true;
+  }
+
+  bool start(const VibrationConfig &v)
+  {
+    uint32_t perRound = v.rateHz * v.channelCount;
+    _decim = (VIB_ADC_MIN_RATE + perRound - 1) / perRound;
+
+    adc_digi_init_config_t init = {};
+    init.max_store_buf_size = VIB_DMA_STORE;
+    init.conv_num_each_intr = VIB_DMA_FRAME;
+    adc_digi_pattern_config_t pattern[RUNTIME_MAX_VIBRATION] = {};
+    memset(_slotOf, 0xFF, sizeof(_slotOf));
+    for (uint8_t ch = 0; ch < v.channelCount; ch++)
+    {
+      uint8_t adc = v.channels[ch].adcChannel;
+      init.adc1_chan_mask |= BIT(adc);
+      pattern[ch].atten = ADC_ATTEN_DB_11;
+      pattern[ch].channel = adc;
+      pattern[ch].unit = 0; // ADC1
+      pattern[ch].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+      _slotOf[adc] = ch;
+    }
+    if (adc_digi_initialize(&init) != ESP_OK)
+    {
+      ESP_LOGE("VIB", "adc_digi_initialize failed");
+      return false;
+    }
+
+    adc_digi_configuration_t dig = {};
+    dig.conv_limit_en = 1;
+    dig.conv_limit_num = 250;
+    dig.pattern_num = v.channelCount;
+    dig.adc_pattern = pattern;
+    dig.sample_freq_hz = perRound * _decim;
+    dig.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    dig.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+    if (adc_digi_controller_configure(&dig) != ESP_OK || adc_digi_start() != ESP_OK)
+    {
+      ESP_LOGE("VIB", "ADC DMA start failed (%u Hz)", dig.sample_freq_hz);
+      adc_digi_deinitialize();
+      return false;
+    }
+    return true;
+  }
+
+  // Isi _buf[ch][0..samples) dalam volt x skala. false = timeout / overflow
+  // ring driver (blok tidak kontinu, fitur tidak dihitung)
+  bool acquire(const VibrationConfig &v)
+  {
+    uint16_t count[RUNTIME_MAX_VIBRATION] = {};
+    uint32_t sum[RUNTIME_MAX_VIBRATION] = {};
+    uint16_t summed[RUNTIME_MAX_VIBRATION] = {};
+    uint8_t done = 0;
+    uint32_t budgetMs = 500 + (uint64_t)v.samples * 1000 / v.rateHz;
+    uint32_t t0 = millis();
+
+    while (done < v.channelCount)
+    {
+      uint32_t got = 0;
+      esp_err_t err = adc_digi_read_bytes(_dma, sizeof(_dma), &got, 100);
+      if (err == ESP_ERR_INVALID_STATE || millis() - t0 > budgetMs)
+      {
+        ESP_LOGW("VIB", "Capture aborted (%s)", err == ESP_ERR_INVALID_STATE ? "DMA overflow" : "timeout");
+        return false;
+      }
+      if (err != ESP_OK)
+        continue;
+
+      for (uint32_t i = 0; i < got / SOC_ADC_DIGI_RESULT_BYTES; i++)
+      {
+        uint32_t idx = VIB_ADC_SWAP_PAIRS ? i ^ 1 : i;
+        if (idx >= got / SOC_ADC_DIGI_RESULT_BYTES)
+          continue;
+        const adc_digi_output_data_t *d = (const adc_digi_output_data_t *)&_dma[idx * SOC_ADC_DIGI_RESULT_BYTES];
+        uint8_t ch = d->type1.channel < sizeof(_slotOf) ? _slotOf[d->type1.channel] : 0xFF;
+        if (ch >= v.channelCount || count[ch] >= v.samples)
+          continue;
+        sum[ch] += d->type1.data;
+        if (++summed[ch] < _decim)
+          continue;
+        _buf[ch][count[ch]++] = sum[ch] * (VIB_ADC_VOLTS_PER_LSB / _decim) * v.channels[ch].scale;
+        sum[ch] = summed[ch] = 0;
+        if (count[ch] == v.samples)
+          done++;
+      }
+    }
+    return true;
+  }
+
+  SpectrumAnalyzer *_analyzer = NULL;
+  float *_buf[RUNTIME_MAX_VIBRATION] = {};
+  uint8_t _dma[VIB_DMA_FRAME];
+  uint8_t _slotOf[8];    // ADC1_CHANNEL_x -> index kanal config, 0xFF = tidak dipakai
+  uint32_t _decim = 1;   // sampel hardware per sampel output
+  uint32_t _lastMs = 0;  // awal capture terakhir
+  uint32_t _generation = 0;
+
+  VibrationFeatures _features[RUNTIME_MAX_VIBRATION] = {};
+  bool _valid[RUNTIME_MAX_VIBRATION] = {};
+  uint32_t _fftCycles = 0, _updatedMs = 0;
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+VibrationCapture vibration;
+
+#endif
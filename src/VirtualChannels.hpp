@@ -0,0 +1,69 @@
+#ifndef VIRTUAL_CHANNELS_HPP
+#define VIRTUAL_CHANNELS_HPP
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "config.hpp"
+#include "Metrics.hpp"
+#include "Expression.hpp"
+#include "RuntimeConfig.hpp"
+#include "ModbusSlave.hpp"
+
+// ============================================================================
+// VIRTUAL CHANNELS (kanal turunan dari "virtual" di modbusSetup.json)
+//   "virtual": [["dP", "AI1 - AI2"],
+//               ["Flow", "12.5 * sqrt(max(dP, 0))"],
+//               ["Energi kWh", "integ({Daya kW}) / 3600"]]
+// Ekspresi sudah jadi bytecode di snapshot (RuntimeConfig::addVirtual);
+// di sini tiap siklus akuisisi hanya menyalin nilai AI/DI/tag ke tabel slot
+// lalu menjalankan program berurutan, hasil tiap kanal langsung jadi slot
+// yang bisa dipakai kanal berikutnya. State prev()/integ() per kanal direset
+// saat generation config berubah.
+//
+// Hasil: value(n) dibaca AlarmEngine (source kanal virtual) & Task_DataLogger
+// (jsonSend -> uplink / SD / live view).
+// ============================================================================
+
+class VirtualChannels
+{
+public:
+  void evaluate(const RuntimeConfig *cfg)
+  {
+    int64_t t0 = esp_timer_get_time();
+    if (cfg->generation != _generation)
+    {
+      memset(_state, 0, sizeof(_state));
+      memset(_vars, 0, sizeof(_vars));
+      _lastUs = t0;
+      _generation = cfg->generation;
+    }
+    if (!cfg->virtualCount)
+      return;
+
+    float dt = (t0 - _lastUs) / 1e6f;
+    _lastUs = t0;
+    for (int i = 1; i <= jumlahInputAnalog; i++)
+      _vars[VSLOT_AI(i)] = analogInput[i].mapValue;
+    for (int i = 1; i <= jumlahInputDigital; i++)
+      _vars[VSLOT_DI(i)] = digitalInput[i].value;
+    for (uint16_t n = 0; n < cfg->tagCount; n++)
+      _vars[VSLOT_TAG(n)] = slaveRegisters.tagValue(n);
+
+    for (uint8_t n = 0; n < cfg->virtualCount; n++)
+      _vars[VSLOT_VIRTUAL(n)] = exprEval(cfg->virtuals[n].program, _vars, _state[n], dt);
+    mVirtualEval.observeUs((uint32_t)(esp_timer_get_time() - t0));
+  }
+
+  float value(uint8_t n) const { return n < RUNTIME_MAX_VIRTUAL ? _vars[VSLOT_VIRTUAL(n)] : 0; }
+  uint32_t generation() const { return _generation; }
+
+private:
+  float _vars[VSLOT_COUNT] = {}; // float 32-bit: dibaca task lain tanpa lock
+  float _state[RUNTIME_MAX_VIRTUAL][EXPR_MAX_STATE] = {};
+  int64_t _lastUs = 0;
+  uint32_t _generation = 0;
+};
+
+VirtualChannels virtualChannels;
+
+#endif
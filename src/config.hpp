@@ -18,6 +18,16 @@ byte mac[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
 // Digital Input Pins as an array
 const int DI_PINS[] = {32, 33, 25, 26};
 
+// Digital Output Pins (relay driver). Board esp32doit tidak punya jalur DO,
+// jadi pin diisi per board lewat build_flags, mis.
+//   -D 'DO_PIN_LIST={13, 14, 27, -1}'
+// -1 = DO tidak terpasang. Pin yang bentrok dengan board (lihat doPinUsable)
+// diperlakukan sama: tidak di-setup dan perintah ke DO itu ditolak.
+#ifndef DO_PIN_LIST
+#define DO_PIN_LIST {-1, -1, -1, -1}
+#endif
+const int DO_PINS[jumlahOutputDigital] = DO_PIN_LIST;
+
 #define SIG_LED_PIN 2
 
 // SD Card Pins
@@ -30,6 +40,64 @@ const int DI_PINS[] = {32, 33, 25, 26};
 #define ETH_CLK 18  // 14
 #define ETH_CS 4
 #define ETH_RST 12
+// Clock W5500 (driver esp_eth), diubah saat runtime: ETH_SPI_CLOCK_MHZ selama SD
+// idle >= ETH_SPI_SD_IDLE_MS, ETH_SPI_CLOCK_SD_MHZ (setelan lama yang terbukti aman
+// bersama kartu SD di bus yang sama) selama ada lease SD. SD tetap 4 MHz sendiri.
+// Maks 20 MHz: di atas itu CS hold time W5500 tidak bisa dijamin driver.
+// Bisa di-override lewat build_flags.
+#ifndef ETH_SPI_CLOCK_MHZ
+#define ETH_SPI_CLOCK_MHZ 20
+#endif
+#ifndef ETH_SPI_CLOCK_SD_MHZ
+#define ETH_SPI_CLOCK_SD_MHZ 4
+#endif
+#define ETH_SPI_SD_IDLE_MS 2000
+#define SHARED_SPI_HOST SPI3_HOST   // VSPI: dipakai bersama W5500 + SD Card
+
+// RS-485 Modbus. DE = pin RTS UART yang dikendalikan driver
+// (UART_MODE_RS485_HALF_DUPLEX); -1 = transceiver auto-direction.
+// Bisa di-override lewat build_flags.
+#ifndef RS485_MASTER_RX
+#define RS485_MASTER_UART 2
+#define RS485_MASTER_RX 16
+#define RS485_MASTER_TX 17
+#define RS485_MASTER_DE -1
+#endif
+// Port slave RTU di transceiver kedua. RX/TX -1 = tidak ada: slave RTU
+// berbagi bus master dan dilayani Task_ModbusClient di sela scan.
+#ifndef RS485_SLAVE_RX
+#define RS485_SLAVE_UART 1
+#define RS485_SLAVE_RX -1
+#define RS485_SLAVE_TX -1
+#define RS485_SLAVE_DE -1
+#endif
+
+// Kapasitas jsonParam (tag Modbus + slaveMap + alarms). Semua salinan
+// jsonParam (commit file, export, blob tag di NVS) ikut ukuran ini.
+#define JSON_PARAM_CAPACITY 8192
+
+// Pin boleh dipakai sebagai DO: GPIO output yang ada di ESP32 (bukan 20, 24,
+// 28-31, input-only 34-39, flash 6-11), bukan strapping (0, 2, 5, 12, 15),
+// bukan UART0 (1, 3) / I2C ADS1115 (21, 22), dan tidak dipakai periferal lain
+// di board ini.
+inline bool doPinUsable(int pin)
+{
+  static const int reserved[] = {0, 1, 2, 3, 5, 12, 15, 21, 22, SIG_LED_PIN, SD_CS_PIN, ETH_INT, ETH_MISO, ETH_MOSI, ETH_CLK, ETH_CS, ETH_RST,
+                                 RS485_MASTER_RX, RS485_MASTER_TX, RS485_MASTER_DE, RS485_SLAVE_RX, RS485_SLAVE_TX, RS485_SLAVE_DE};
+  if (pin < 0 || pin > 33 || (pin >= 6 && pin <= 11) || pin == 20 || pin == 24 || (pin >= 28 && pin <= 31))
+    return false;
+  for (int r : reserved)
+  {
+    if (r == pin)
+      return false;
+  }
+  for (int di : DI_PINS)
+  {
+    if (di == pin)
+      return false;
+  }
+  return true;
+}
 
 struct Network
 {
@@ -45,6 +113,7 @@ struct Network
   int port;
   float sendInterval;
   int sdSaveInterval = 5; // <-- TAMBAHAN: Default 5 menit
+  int liveInterval = 1000; // Interval push SSE /live ke dashboard (ms)
 } networkSettings;
 
 // struct Network
@@ -69,6 +138,7 @@ struct AnalogInput
   bool calibration;
   float mValue, cValue, lowLimit, highLimit, filterPeriod;
   byte pin;
+  uint32_t sampleMs; // millis() saat ADC kanal ini terakhir dibaca (totalizer)
 } analogInput[jumlahInputAnalog + 1];
 
 struct DigitalInput
@@ -103,33 +173,6 @@ struct ModbusParam
   bool mode;
 } modbusParam;
 
-struct IpAddressSplit
-{
-  int ip[5];
-};
-
-void IRAM_ATTR isrPulseMode1()
-{
-  digitalInput[1].sumValue++;
-}
-
-void IRAM_ATTR isrPulseMode2()
-{
-  digitalInput[2].sumValue++;
-}
-
-void IRAM_ATTR isrPulseMode3()
-{
-  digitalInput[3].sumValue++;
-}
-
-void IRAM_ATTR isrPulseMode4()
-{
-  digitalInput[4].sumValue++;
-}
-
-void (*isrPulseMode[])(void) = {nullptr, isrPulseMode1, isrPulseMode2, isrPulseMode3, isrPulseMode4};
-
 class ErrorBlinker
 {
 public:
@@ -279,6 +322,8 @@ private:
   }
 };
 
+size_t formatTimeNow(char *buf, size_t len); // main.cpp
+
 class ErrorMessages
 {
 public:
@@ -286,13 +331,22 @@ public:
   ErrorMessages(String path)
       : _eventSource(path) {}
 
-  void addMessage(const String &msg)
+  void addMessage(const char *msg)
   {
-    _eventSource.send(msg.c_str());
+    _eventSource.send(msg);
 #ifdef DEBUG
-    Serial.println("Added message: " + msg);
+    Serial.printf("Added message: %s\n", msg);
 #endif
   }
+
+  // "HH:MM:SS - msg" dirangkai di stack, tanpa String sementara
+  void addTimedMessage(const char *msg)
+  {
+    char line[128];
+    size_t n = formatTimeNow(line, sizeof(line));
+    snprintf(line + n, sizeof(line) - n, " - %s", msg);
+    addMessage(line);
+  }
 };
 
 #endif
\ No newline at end of file
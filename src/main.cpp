@@ -9,18 +9,40 @@
 #include <Update.h>
 #include <WiFiClientSecure.h>
 #include <ADS1X15.h>
-#include <SPI.h>
-#include <SD.h>
+#include "SharedSpiSD.hpp"
+#include "SpiBusManager.hpp"
+#include "StaticAssets.hpp"
+#include "ConfigImage.hpp"
+#include "ConfigStore.hpp"
+#include "RuntimeConfig.hpp"
+#include "FixedString.hpp"
+#include "SignalMath.hpp"
+#include "Payload.hpp"
+#include "ModbusFrame.hpp"
+#include "ScanStats.hpp"
+#include "TaskMessages.hpp"
+#include "Metrics.hpp"
+#include "CommandQueue.hpp"
+#include "ModbusSlave.hpp"
+#include "VirtualChannels.hpp"
+#include "Totalizers.hpp"
+#include "VibrationCapture.hpp"
+#include "AlarmEngine.hpp"
+#include "ModbusGateway.hpp"
+#include "ModbusTcpServer.hpp"
+#include "Rs485Port.hpp"
+#include "ModbusRtuSlave.hpp"
+#include "ModbusTcpClient.hpp"
+#include "LiveStream.hpp"
+#include "CommandSocket.hpp"
 #include <RTClib.h>
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
-#include <Ethernet.h> //ethernet w5500
+#include <esp32_w5500.h> // W5500 via esp_eth + lwIP
 #include <esp_wifi.h>
 #include "driver/spi_master.h"
 #include <time.h>
 #include <config.hpp>
-#include <ModbusIP_ESP8266.h>
-#include <ModbusRTU.h>
 #include <DNSServer.h>
 #include "NetworkFunctions.hpp"
 #include <esp_task_wdt.h>
@@ -33,18 +55,21 @@ TaskHandle_t Task_Core0_Network = NULL;
 TaskHandle_t Task_Core1_DataAcquisition = NULL;
 TaskHandle_t Task_Core1_ModbusClient = NULL;
 TaskHandle_t Task_Core1_DataLogger = NULL;
+TaskHandle_t Task_Core1_ModbusSlave = NULL; // hanya jika ada port slave RS-485 sendiri
+TaskHandle_t Task_Core0_ModbusTcp = NULL;
+TaskHandle_t Task_Core0_Vibration = NULL;
 
 // ============================================================================
 // QUEUE HANDLES untuk komunikasi antar task
 // ============================================================================
-QueueHandle_t queueSensorData = NULL;
-QueueHandle_t queueModbusData = NULL;
-QueueHandle_t queueLogData = NULL;
+QueueHandle_t queueSensorData = NULL; // SensorDataPacket   (akuisisi -> logger)
+QueueHandle_t queueModbusData = NULL; // ChannelBatchPacket (Modbus -> logger)
+QueueHandle_t queueAlarmEvents = NULL; // AlarmEvent (akuisisi -> logger)
 
 // ============================================================================
 // MUTEX untuk resource sharing
 // ============================================================================
-SemaphoreHandle_t spiMutex;
+// Bus SPI (W5500 + SD) diatur oleh spiBus (SpiBusManager.hpp), bukan mutex
 SemaphoreHandle_t i2cMutex;
 SemaphoreHandle_t sdMutex;
 SemaphoreHandle_t jsonMutex;
@@ -52,8 +77,6 @@ SemaphoreHandle_t modbusMutex;
 // ============================================================================
 // GLOBAL OBJECTS
 // ============================================================================
-ModbusIP mbIP;
-ModbusRTU mbRTU;
 RTC_DS3231 rtc;
 AsyncWebServer server(80);
 DNSServer dnsServer;
@@ -71,2168 +94,123 @@ ADS1115 ads;
 ErrorBlinker errorBlinker(SIG_LED_PIN, 800);
 ErrorMessages errorMessages("/debugStream");
 
-String stringParam, sendString;
+String stringParam;
+// Payload kirim data / simpan SD. Hanya dipakai Task_DataLogger (berurutan),
+// statis supaya serialize tiap interval tidak realloc String di heap
+FixedString<4096> sendString;
 int numOfParam, modbusCount;
 bool flagSend = false;
 unsigned long printTime, checkTime, sendTime, sendTimeModbus;
-HardwareSerial SerialModbus(2);
+HardwareSerial SerialModbus(RS485_MASTER_UART);
+HardwareSerial SerialModbusSlave(RS485_SLAVE_UART);
+Rs485Port rs485Master(SerialModbus, (uart_port_t)RS485_MASTER_UART, RS485_MASTER_RX, RS485_MASTER_TX, RS485_MASTER_DE);
+Rs485Port rs485Slave(SerialModbusSlave, (uart_port_t)RS485_SLAVE_UART, RS485_SLAVE_RX, RS485_SLAVE_TX, RS485_SLAVE_DE);
+ModbusRtuSlave rtuSlave;
 
-DynamicJsonDocument doc(4096), jsonParam(4096), jsonSend(4096);
+DynamicJsonDocument doc(4096), jsonParam(JSON_PARAM_CAPACITY), jsonSend(4096);
 bool flagGetJobNum = 1;
 String jobNum;
 
-// ============================================================================
-// STRUKTUR DATA untuk Queue
-// ============================================================================
-struct SensorDataPacket
-{
-  float analogValues[jumlahInputAnalog + 1];
-  float digitalValues[jumlahInputDigital + 1];
-  unsigned long timestamp;
-};
-
-struct ModbusDataPacket
-{
-  String paramName;
-  float value;
-  unsigned long timestamp;
-};
-
-struct LogDataPacket
-{
-  String jsonData;
-  unsigned long timestamp;
-};
+// Waktu sejak reset sampai sampel ADC pertama (ms), 0 = belum ada sampel
+uint32_t bootFirstSampleMs = 0;
 
 // ============================================================================
 // FORWARD DECLARATIONS
 // ============================================================================
 void readConfig();
-void saveToJson(const char *dir, const char *configType);
-void saveToSDConfig(const char *dir, const char *configType);
+void readRuntimeData();
+void buildConfigJson(const String &type, JsonDocument &out);
 void updateJson(const char *dir, const char *jsonKey, int jsonValue);
 void updateJson(const char *dir, const char *jsonKey, const char *jsonValue);
 void handleFileRequest(AsyncWebServerRequest *request, const char *filePath, const char *mimeType);
+DateTime dateTimeNow();
+size_t formatTimeDateNow(char *buf, size_t len);
 String getTimeDateNow();
-String getTimeNow();
-void modbusSlaveSetup();
 void setupWebServer();
 void setupInterrupts();
 bool isAuthenticated(AsyncWebServerRequest *request);
 void authenthicateUser(AsyncWebServerRequest *request);
 void handleFormSubmit(AsyncWebServerRequest *request);
+void configChanged(uint8_t sections);
 void printConfigurationDetails();
 int countJsonKeys(const JsonDocument &doc);
-float filterSensor(float filterVar, float filterResult_1, float fc);
-float mapFloat(float x, float in_min, float in_max, float out_min, float out_max);
-unsigned int readModbusNonBlocking(unsigned int modbusAddress, unsigned int funCode, unsigned int regAddress, unsigned int timeoutMs);
+size_t rs485Transaction(const uint8_t *request, size_t reqLen, uint8_t *response, size_t maxLen, size_t expectedLen, uint32_t timeoutMs);
+uint8_t readModbusBlock(uint8_t slaveId, uint8_t funCode, uint16_t regAddress, uint16_t count, uint16_t *values, uint32_t timeoutMs);
+void serviceModbusGateway(const RuntimeConfig *cfg);
+void serviceCommands(const RuntimeConfig *cfg);
 unsigned int readModbus(unsigned int modbusAddress, unsigned int funCode, unsigned int regAddress);
-unsigned int crcModbus(unsigned int crc[], byte start, byte sizeArray);
-unsigned int parseByte(unsigned int bytes, bool byteOrder);
 
 // ============================================================================
 // ISR DECLARATIONS
 // ============================================================================
 #define DEBOUNCE_TIME 50
-void IRAM_ATTR isrDI1()
-{
-  // Cek apakah selisih waktu dari trigger terakhir > 50ms
-  if (millis() - digitalInput[1].millisNow >= DEBOUNCE_TIME)
-  {
-    digitalInput[1].millisNow = millis(); // Simpan waktu trigger ini
-    digitalInput[1].flagInt = 1;          // Set flag untuk diproses task
-  }
-}
 
-void IRAM_ATTR isrDI2()
-{
-  if (millis() - digitalInput[2].millisNow >= DEBOUNCE_TIME)
-  {
-    digitalInput[2].millisNow = millis();
-    digitalInput[2].flagInt = 1;
-  }
-}
+// Satu ISR untuk semua DI, dipasang sekali di setupInterrupts(). Perilakunya
+// dipilih dari diIsrMode[] (satu byte, ditulis atomik), jadi ganti mode dari
+// web tidak perlu detach/attach ulang dan tidak ada pulsa yang hilang.
+#define DI_ISR_EDGE 0x01    // Cycle Time / Counting: flagInt + debounce
+#define DI_ISR_PULSE 0x02   // Pulse Mode: hitung semua pulsa
+#define DI_ISR_TRIGGER 0x04 // DI dipakai sebagai trigger kirim data
+volatile uint8_t diIsrMode[jumlahInputDigital + 1];
 
-void IRAM_ATTR isrDI3()
-{
-  if (millis() - digitalInput[3].millisNow >= DEBOUNCE_TIME)
-  {
-    digitalInput[3].millisNow = millis();
-    digitalInput[3].flagInt = 1;
-  }
-}
-
-void IRAM_ATTR isrDI4()
-{
-  if (millis() - digitalInput[4].millisNow >= DEBOUNCE_TIME)
-  {
-    digitalInput[4].millisNow = millis();
-    digitalInput[4].flagInt = 1;
-  }
-}
-
-void (*isrArray[])(void) = {nullptr, isrDI1, isrDI2, isrDI3, isrDI4};
-
-void attachDigitalInputInterrupt(int index)
-{
-  if (digitalInput[index].taskMode == "Cycle Time" || digitalInput[index].taskMode == "Counting")
-  {
-    if (index < sizeof(isrArray) / sizeof(isrArray[0]))
-    {
-      attachInterrupt(digitalPinToInterrupt(digitalInput[index].pin), isrArray[index], RISING);
-    }
-  }
-  else if (digitalInput[index].taskMode == "Pulse Mode")
-  {
-    if (index < sizeof(isrPulseMode) / sizeof(isrPulseMode[0]))
-    {
-      attachInterrupt(digitalPinToInterrupt(digitalInput[index].pin), isrPulseMode[index], RISING);
-    }
-  }
-  else
-  {
-    detachInterrupt(digitalPinToInterrupt(digitalInput[index].pin));
-  }
-}
-
-void configureSendTriggerInterrupt(Network networkSettings)
-{
-  if (networkSettings.sendTrig != "Timer/interval")
-  {
-    int pinTrig = networkSettings.sendTrig.substring(2, 3).toInt();
-    if (pinTrig >= 1 && pinTrig < sizeof(isrArray) / sizeof(isrArray[0]))
-    {
-      attachInterrupt(digitalPinToInterrupt(digitalInput[pinTrig].pin), isrArray[pinTrig], RISING);
-    }
-  }
-}
-
-// ============================================================================
-// ETHERNET WEB SERVER HANDLER
-// Menangani request website saat menggunakan kabel LAN (W5500)
-// ============================================================================
-String getContentType(String filename)
+void IRAM_ATTR isrDigitalInput(void *arg)
 {
-  filename.toLowerCase();
-
-  if (filename.endsWith(".html"))
-    return "text/html; charset=utf-8";
-  else if (filename.endsWith(".htm"))
-    return "text/html; charset=utf-8";
-  else if (filename.endsWith(".css"))
-    return "text/css; charset=utf-8";
-  else if (filename.endsWith(".js"))
-    return "application/javascript; charset=utf-8";
-  else if (filename.endsWith(".json"))
-    return "application/json";
-  else if (filename.endsWith(".png"))
-    return "image/png";
-  else if (filename.endsWith(".jpg"))
-    return "image/jpeg";
-  else if (filename.endsWith(".jpeg"))
-    return "image/jpeg";
-  else if (filename.endsWith(".gif"))
-    return "image/gif";
-  else if (filename.endsWith(".ico"))
-    return "image/x-icon";
-  else if (filename.endsWith(".svg"))
-    return "image/svg+xml";
-  else if (filename.endsWith(".woff"))
-    return "font/woff";
-  else if (filename.endsWith(".woff2"))
-    return "font/woff2";
-  else if (filename.endsWith(".ttf"))
-    return "font/ttf";
-  else if (filename.endsWith(".eot"))
-    return "application/vnd.ms-fontobject";
-
-  return "text/plain";
-}
-
-// void handleEthernetClient()
-// {
-//   EthernetClient client = ethServer.available();
-//   if (client)
-//   {
-//     Serial.println("New Ethernet Client");
-//     boolean currentLineIsBlank = true;
-//     String req = "";
-
-//     while (client.connected())
-//     {
-//       if (client.available())
-//       {
-//         char c = client.read();
-//         req += c;
-//         if (c == '\n' && currentLineIsBlank)
-//         {
-//           // Request Header selesai, parsing URL
-//           String url = req.substring(req.indexOf("GET") + 4, req.indexOf(" HTTP/1.1"));
-//           url.trim();
-
-//           // 1. ROUTING HALAMAN UTAMA
-//           if (url == "/")
-//             url = "/home.html";
-//           else if (url == "/network")
-//             url = "/network.html";
-//           else if (url == "/analog_input")
-//             url = "/analog_input.html";
-//           else if (url == "/digital_IO")
-//             url = "/digital_IO.html";
-//           else if (url == "/system_settings")
-//             url = "/system_settings.html";
-//           else if (url == "/modbus_setup")
-//             url = "/modbus_setup.html";
-//           else if (url == "/updateOTA")
-//             url = "/UpdateOTA.html";
-//           else if (url == "/debug")
-//             url = "/debug-monitor.html";
-//           // 2. ROUTING API JSON (Replikasi logika dari AsyncWebServer)
-//           if (url == "/getCurrentValue")
-//           {
-//             // Logika sama dengan server.on("/getCurrentValue"...)
-//             if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(100)))
-//             {
-//               DynamicJsonDocument docTemp(1024);
-//               for (int i = 1; i <= jumlahInputDigital; i++)
-//               { // Koreksi index loop dari 1
-//                 // Pastikan analogInput diakses dengan benar sesuai config
-//                 docTemp["rawValue" + String(i)] = analogInput[i].adcValue;
-//                 docTemp["scaledValue" + String(i)] = analogInput[i].mapValue;
-//               }
-//               String dataLoad;
-//               serializeJson(docTemp, dataLoad);
-//               xSemaphoreGive(jsonMutex);
-
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: application/json");
-//               client.println("Connection: close");
-//               client.println();
-//               client.println(dataLoad);
-//             }
-//             break;
-//           }
-//           else if (url == "/networkLoad")
-//           {
-//             // API Network Info
-//             if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(100)))
-//             {
-//               DynamicJsonDocument docTemp(1024);
-//               // Isi data sesuai variabel global networkSettings
-//               docTemp["networkMode"] = networkSettings.networkMode;
-//               docTemp["ipAddress"] = (networkSettings.networkMode == "Ethernet") ? Ethernet.localIP().toString() : networkSettings.ipAddress;
-//               docTemp["macAddress"] = networkSettings.macAddress;
-//               docTemp["connStatus"] = networkSettings.connStatus;
-//               docTemp["protocolMode"] = networkSettings.protocolMode;
-//               docTemp["sendInterval"] = networkSettings.sendInterval;
-
-//               String dataLoad;
-//               serializeJson(docTemp, dataLoad);
-//               xSemaphoreGive(jsonMutex);
-
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: application/json");
-//               client.println("Connection: close");
-//               client.println();
-//               client.println(dataLoad);
-//             }
-//             break;
-//           }
-
-//           // 3. ROUTING FILE STATIC (SPIFFS)
-//           if (SPIFFS.exists(url))
-//           {
-//             File file = SPIFFS.open(url, "r");
-//             client.println("HTTP/1.1 200 OK");
-//             client.println("Content-Type: " + getContentType(url));
-//             client.println("Connection: close");
-//             client.println();
-
-//             while (file.available())
-//             {
-//               client.write(file.read());
-//             }
-//             file.close();
-//           }
-//           else
-//           {
-//             // 404 Not Found
-//             client.println("HTTP/1.1 404 Not Found");
-//             client.println("Content-Type: text/plain");
-//             client.println("Connection: close");
-//             client.println();
-//             client.println("404: File Not Found");
-//           }
-//           break;
-//         }
-//         if (c == '\n')
-//         {
-//           currentLineIsBlank = true;
-//         }
-//         else if (c != '\r')
-//         {
-//           currentLineIsBlank = false;
-//         }
-//       }
-//     }
-//     delay(1);
-//     client.stop();
-//   }
-// }
-
-// ============================================================================
-// ETHERNET WEB SERVER HANDLER (FULL FEATURE)
-// Meniru logika ESPAsyncWebServer agar tampilan sama persis
-// ============================================================================
-// void handleEthernetClient()
-// {
-//   EthernetClient client = ethServer.available();
-//   if (client)
-//   {
-//     boolean currentLineIsBlank = true;
-//     String req = "";
-//     String reqBody = "";
-//     bool headerFinished = false;
-//     unsigned long timeout = millis();
-//     int contentLength = 0;
-
-//     while (client.connected() && millis() - timeout < 2000)
-//     {
-//       if (client.available())
-//       {
-//         char c = client.read();
-
-//         // 1. READ HEADER
-//         if (!headerFinished)
-//         {
-//           req += c;
-//           if (req.length() > 2048)
-//             req = req.substring(req.length() - 2048); // Prevent overflow
-
-//           if (c == '\n' && currentLineIsBlank)
-//           {
-//             headerFinished = true;
-
-//             // Check Content-Length if needed (for POST future use)
-//             String lowerReq = req;
-//             lowerReq.toLowerCase();
-//             int clIndex = lowerReq.indexOf("content-length:");
-//             if (clIndex >= 0)
-//             {
-//               contentLength = lowerReq.substring(clIndex + 15, lowerReq.indexOf("\n", clIndex)).toInt();
-//             }
-//           }
-//           if (c == '\n')
-//             currentLineIsBlank = true;
-//           else if (c != '\r')
-//             currentLineIsBlank = false;
-//         }
-//         // 2. READ BODY (If needed for POST)
-//         else
-//         {
-//           if (reqBody.length() < contentLength)
-//             reqBody += c;
-//         }
-
-//         // If Header is finished and (no body or body read)
-//         if (headerFinished && (contentLength == 0 || reqBody.length() >= contentLength))
-//         {
-//           // --- PARSING REQUEST LINE ---
-//           int methodEnd = req.indexOf(" ");
-//           int urlEnd = req.indexOf(" ", methodEnd + 1);
-//           if (methodEnd == -1 || urlEnd == -1)
-//             return;
-
-//           String url = req.substring(methodEnd + 1, urlEnd);
-//           url.trim();
-
-//           // Separate URL Path and Query Param (e.g., /analogLoad?input=1)
-//           String basePath = url;
-//           String queryParams = "";
-//           if (url.indexOf("?") > 0)
-//           {
-//             basePath = url.substring(0, url.indexOf("?"));
-//             queryParams = url.substring(url.indexOf("?") + 1);
-//           }
-
-//           // ==================================================================
-//           // PART A: PAGE ROUTING (URL -> FILE)
-//           // ==================================================================
-//           String filePath = basePath;
-
-//           if (basePath == "/")
-//             filePath = "/home.html";
-//           else if (basePath == "/network")
-//             filePath = "/network.html";
-//           else if (basePath == "/analog_input")
-//             filePath = "/analog_input.html";
-//           else if (basePath == "/digital_IO")
-//             filePath = "/digital_IO.html";
-//           else if (basePath == "/system_settings")
-//             filePath = "/system_settings.html";
-//           else if (basePath == "/modbus_setup")
-//             filePath = "/modbus_setup.html";
-//           else if (basePath == "/updateOTA")
-//             filePath = "/UpdateOTA.html";
-//           else if (basePath == "/debug")
-//             filePath = "/debug-monitor.html";
-
-//           // ==================================================================
-//           // PART B: API JSON (DATA LOADERS)
-//           // ==================================================================
-
-//           // 1. /homeLoad
-//           if (basePath == "/homeLoad")
-//           {
-//             if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-//             {
-//               doc = DynamicJsonDocument(2048);
-//               // Parsing Input Parameter if exists
-//               unsigned char id = 1;
-//               if (queryParams.indexOf("input=") >= 0)
-//               {
-//                 String valStr = queryParams.substring(queryParams.indexOf("input=") + 6);
-//                 id = valStr.toInt();
-//               }
-
-//               doc["networkMode"] = networkSettings.networkMode;
-//               doc["ssid"] = networkSettings.ssid;
-//               doc["ipAddress"] = Ethernet.localIP().toString();
-//               doc["macAddress"] = networkSettings.macAddress;
-//               doc["protocolMode"] = networkSettings.protocolMode;
-//               doc["endpoint"] = networkSettings.endpoint;
-//               doc["connStatus"] = networkSettings.connStatus;
-//               doc["jobNumber"] = jobNum;
-//               doc["sendInterval"] = networkSettings.sendInterval;
-//               doc["datetime"] = getTimeDateNow();
-
-//               JsonArray enableAI = doc.createNestedArray("enAI");
-//               for (int i = 1; i <= jumlahInputAnalog; i++)
-//                 enableAI.add(analogInput[i].name != "" ? 1 : 0);
-
-//               JsonObject AI = doc.createNestedObject("AI");
-//               JsonArray AIRawValue = AI.createNestedArray("rawValue");
-//               JsonArray AIScaledValue = AI.createNestedArray("scaledValue");
-//               for (int i = 1; i <= jumlahInputAnalog; i++)
-//               {
-//                 AIRawValue.add(analogInput[i].adcValue);
-//                 AIScaledValue.add(analogInput[i].mapValue);
-//               }
-
-//               JsonObject DI = doc.createNestedObject("DI");
-//               JsonArray DIValue = DI.createNestedArray("value");
-//               JsonArray DITaskMode = DI.createNestedArray("taskMode");
-//               for (int i = 1; i <= jumlahInputDigital; i++)
-//               {
-//                 DIValue.add(digitalInput[i].value);
-//                 DITaskMode.add(digitalInput[i].taskMode);
-//               }
-
-//               String dataLoad;
-//               serializeJson(doc, dataLoad);
-//               xSemaphoreGive(jsonMutex);
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: application/json");
-//               client.println("Connection: close");
-//               client.println();
-//               client.println(dataLoad);
-//             }
-//           }
-
-//           // 2. /networkLoad
-//           else if (basePath == "/networkLoad")
-//           {
-//             if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-//             {
-//               doc = DynamicJsonDocument(4096);
-//               doc["networkMode"] = networkSettings.networkMode;
-//               doc["ssid"] = networkSettings.ssid;
-//               doc["password"] = networkSettings.password;
-//               doc["apSsid"] = networkSettings.apSsid;
-//               doc["apPassword"] = networkSettings.apPassword;
-//               doc["dhcpMode"] = networkSettings.dhcpMode;
-//               doc["ipAddress"] = networkSettings.ipAddress;
-//               doc["subnet"] = networkSettings.subnetMask;
-//               doc["ipGateway"] = networkSettings.ipGateway;
-//               doc["ipDNS"] = networkSettings.ipDNS;
-//               doc["sendInterval"] = String(networkSettings.sendInterval, 2);
-//               doc["protocolMode"] = networkSettings.protocolMode;
-//               doc["endpoint"] = networkSettings.endpoint;
-//               doc["port"] = networkSettings.port;
-//               doc["pubTopic"] = networkSettings.pubTopic;
-//               doc["subTopic"] = networkSettings.subTopic;
-//               doc["mqttUsername"] = networkSettings.mqttUsername;
-//               doc["mqttPass"] = networkSettings.mqttPassword;
-//               doc["loggerMode"] = networkSettings.loggerMode;
-//               doc["protocolMode2"] = networkSettings.protocolMode2;
-//               doc["modbusMode"] = modbusParam.mode;
-//               doc["modbusPort"] = modbusParam.port;
-//               doc["modbusSlaveID"] = modbusParam.slaveID;
-//               doc["sendTrig"] = networkSettings.sendTrig;
-//               doc["erpUrl"] = networkSettings.erpUrl;
-//               doc["erpUsername"] = networkSettings.erpUsername;
-//               doc["erpPassword"] = networkSettings.erpPassword;
-
-//               String dataLoad;
-//               serializeJson(doc, dataLoad);
-//               xSemaphoreGive(jsonMutex);
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: application/json");
-//               client.println("Connection: close");
-//               client.println();
-//               client.println(dataLoad);
-//             }
-//           }
-
-//           // 3. /analogLoad (Requires parsing ?input=X)
-//           else if (basePath == "/analogLoad")
-//           {
-//             int id = 1;
-//             if (queryParams.indexOf("input=") >= 0)
-//             {
-//               int start = queryParams.indexOf("input=") + 6;
-//               int end = queryParams.indexOf("&", start);
-//               if (end == -1)
-//                 end = queryParams.length();
-//               id = queryParams.substring(start, end).toInt();
-//             }
-//             if (id < 1)
-//               id = 1;
-//             if (id > jumlahInputAnalog)
-//               id = jumlahInputAnalog;
-
-//             if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-//             {
-//               doc = DynamicJsonDocument(4096);
-//               doc["inputType"] = analogInput[id].inputType;
-//               doc["filter"] = analogInput[id].filter;
-//               doc["filterPeriod"] = (String(analogInput[id].filterPeriod, 2));
-//               doc["scaling"] = analogInput[id].scaling;
-//               doc["lowLimit"] = analogInput[id].lowLimit;
-//               doc["highLimit"] = analogInput[id].highLimit;
-//               doc["name"] = analogInput[id].name;
-//               doc["calibration"] = analogInput[id].calibration;
-//               doc["mValue"] = analogInput[id].mValue;
-//               doc["cValue"] = analogInput[id].cValue;
-
-//               String dataLoad;
-//               serializeJson(doc, dataLoad);
-//               xSemaphoreGive(jsonMutex);
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: application/json");
-//               client.println("Connection: close");
-//               client.println();
-//               client.println(dataLoad);
-//             }
-//           }
-
-//           // 4. /digitalLoad (Handles input, reset, output)
-//           else if (basePath == "/digitalLoad")
-//           {
-//             if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-//             {
-//               doc = DynamicJsonDocument(4096);
-
-//               // Case 1: Load Input Data
-//               if (queryParams.indexOf("input=") >= 0)
-//               {
-//                 int start = queryParams.indexOf("input=") + 6;
-//                 int end = queryParams.indexOf("&", start);
-//                 if (end == -1)
-//                   end = queryParams.length();
-//                 int id = queryParams.substring(start, end).toInt();
-//                 if (id >= 1 && id <= jumlahInputDigital)
-//                 {
-//                   doc["nameDI"] = digitalInput[id].name;
-//                   doc["invDI"] = digitalInput[id].inv;
-//                   doc["taskMode"] = digitalInput[id].taskMode;
-//                   doc["inputState"] = digitalInput[id].inputState ? "High" : "Low";
-//                   doc["intervalTime"] = (float)digitalInput[id].intervalTime / 1000;
-//                   doc["conversionFactor"] = digitalInput[id].conversionFactor;
-//                 }
-//               }
-//               // Case 2: Reset Value
-//               if (queryParams.indexOf("reset=") >= 0)
-//               {
-//                 int start = queryParams.indexOf("reset=") + 6;
-//                 int end = queryParams.indexOf("&", start);
-//                 if (end == -1)
-//                   end = queryParams.length();
-//                 int id = queryParams.substring(start, end).toInt();
-//                 if (id >= 1 && id <= jumlahInputDigital)
-//                   digitalInput[id].value = 0;
-//               }
-//               // Case 3: Load Output Data
-//               if (queryParams.indexOf("output=") >= 0)
-//               {
-//                 int start = queryParams.indexOf("output=") + 7;
-//                 int end = queryParams.indexOf("&", start);
-//                 if (end == -1)
-//                   end = queryParams.length();
-//                 int id = queryParams.substring(start, end).toInt();
-//                 if (id >= 1 && id <= jumlahOutputDigital)
-//                 {
-//                   doc["nameDO"] = digitalOutput[id].name;
-//                   doc["invDO"] = digitalOutput[id].inv;
-//                 }
-//               }
-//               String dataLoad;
-//               serializeJson(doc, dataLoad);
-//               xSemaphoreGive(jsonMutex);
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: application/json");
-//               client.println("Connection: close");
-//               client.println();
-//               client.println(dataLoad);
-//             }
-//           }
-
-//           // 5. /settingsLoad (System Settings)
-//           else if (basePath == "/settingsLoad")
-//           {
-//             String jsonAuth = "{";
-//             jsonAuth += "\"username\":\"" + networkSettings.loginUsername + "\",";
-//             jsonAuth += "\"password\":\"" + networkSettings.loginPassword + "\",";
-//             jsonAuth += "\"sdInterval\":" + String(networkSettings.sdSaveInterval);
-//             jsonAuth += "}";
-//             client.println("HTTP/1.1 200 OK");
-//             client.println("Content-Type: application/json");
-//             client.println("Connection: close");
-//             client.println();
-//             client.println(jsonAuth);
-//           }
-
-//           // 6. /getTime
-//           else if (basePath == "/getTime")
-//           {
-//             DynamicJsonDocument jsonDoc(256);
-//             jsonDoc["datetime"] = getTimeDateNow();
-//             String jsonTime;
-//             serializeJson(jsonDoc, jsonTime);
-//             client.println("HTTP/1.1 200 OK");
-//             client.println("Content-Type: application/json");
-//             client.println("Connection: close");
-//             client.println();
-//             client.println(jsonTime);
-//           }
-
-//           // 7. /modbusLoad
-//           else if (basePath == "/modbusLoad")
-//           {
-//             client.println("HTTP/1.1 200 OK");
-//             client.println("Content-Type: application/json");
-//             client.println("Connection: close");
-//             client.println();
-//             client.println(stringParam);
-//           }
-
-//           // 8. /getCurrentValue (Realtime)
-//           // else if (basePath == "/getCurrentValue")
-//           // {
-//           //   if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(500)))
-//           //   {
-//           //     DynamicJsonDocument docTemp(2048);
-//           //     for (int i = 0; i < jumlahInputDigital; i++)
-//           //     {
-//           //       docTemp["rawValue" + String(i + 1)] = analogInput[i + 1].adcValue;
-//           //       docTemp["scaledValue" + String(i + 1)] = analogInput[i + 1].mapValue;
-//           //     }
-//           //     String dataLoad;
-//           //     serializeJson(docTemp, dataLoad);
-//           //     xSemaphoreGive(jsonMutex);
-//           //     client.println("HTTP/1.1 200 OK");
-//           //     client.println("Content-Type: application/json");
-//           //     client.println("Access-Control-Allow-Origin: *");
-//           //     client.println("Cache-Control: no-store, no-cache, must-revalidate");
-//           //     client.println("Connection: close");
-//           //     client.println();
-//           //     client.println(dataLoad);
-//           //   }
-//           //   else
-//           //   {
-//           //     // Jika Mutex sibuk, kirim error 503 biar browser tau (bukan diam saja)
-//           //     client.println("HTTP/1.1 503 Service Unavailable");
-//           //     client.println("Connection: close");
-//           //     client.println();
-//           //   }
-//           // }
-
-// else if (basePath == "/getCurrentValue")
-//           {
-//              // Kita naikkan timeout jadi 200ms agar kalau sistem sibuk, dia tetap nunggu data
-//              if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(20))) {
-//                 DynamicJsonDocument docTemp(1024);
-
-//                 // Gunakan loop yang sama dengan WiFi, tapi akses array kita geser +1
-//                 // Karena data sensor Anda tersimpan di index 1, 2, 3, 4 (bukan 0, 1, 2, 3)
-//                 for (int i = 0; i < jumlahInputDigital; i++) {
-//                    docTemp["rawValue" + String(i + 1)] = analogInput[i+1].adcValue;
-//                    docTemp["scaledValue" + String(i + 1)] = analogInput[i+1].mapValue;
-//                 }
-
-//                 String dataLoad;
-//                 serializeJson(docTemp, dataLoad);
-//                 xSemaphoreGive(jsonMutex);
-
-//                 // Header HTTP Lengkap (Penting agar browser tidak menolak data)
-//                 client.println("HTTP/1.1 200 OK");
-//                 client.println("Content-Type: application/json");
-//                 client.println("Access-Control-Allow-Origin: *"); // Biar tidak diblokir browser
-//                 client.println("Connection: close");
-//                 client.println();
-
-//                 // Kirim Data JSON
-//                 client.print(dataLoad);
-//              }
-//              else {
-//                 // Jika Mutex Sibuk, kirim JSON kosong agar browser tidak error
-//                 client.println("HTTP/1.1 200 OK");
-//                 client.println("Content-Type: application/json");
-//                 client.println("Connection: close");
-//                 client.println();
-//                 client.println("{}");
-//              }
-//           }
-//           // 9. /wifiStatus (Faked using Ethernet data for frontend compatibility)
-//           else if (basePath == "/wifiStatus" || basePath == "/ethernetStatus")
-//           {
-//             DynamicJsonDocument statusDoc(512);
-//             statusDoc["mode"] = networkSettings.networkMode;
-//             statusDoc["ssid"] = "Ethernet (LAN)";
-//             statusDoc["connected"] = (Ethernet.linkStatus() == LinkON);
-//             statusDoc["ip"] = Ethernet.localIP().toString();
-//             statusDoc["rssi"] = -50;
-//             statusDoc["macAddress"] = networkSettings.macAddress;
-//             statusDoc["apIP"] = WiFi.softAPIP().toString();
-//             statusDoc["connectionStatus"] = networkSettings.connStatus;
-//             statusDoc["signalQuality"] = "Wired";
-
-//             String response;
-//             serializeJson(statusDoc, response);
-//             client.println("HTTP/1.1 200 OK");
-//             client.println("Content-Type: application/json");
-//             client.println("Connection: close");
-//             client.println();
-//             client.println(response);
-//           }
-
-//           // ==================================================================
-//           // PART C: STATIC FILES (CSS, JS, IMAGES)
-//           // ==================================================================
-//           else
-//           {
-//             if (SPIFFS.exists(filePath))
-//             {
-//               File file = SPIFFS.open(filePath, "r");
-//               String contentType = getContentType(filePath);
-
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: " + contentType);
-//               client.println("Connection: close");
-//               client.println();
-
-//               uint8_t buffer[512];
-//               while (file.available())
-//               {
-//                 int bytesRead = file.read(buffer, sizeof(buffer));
-//                 client.write(buffer, bytesRead);
-//               }
-//               file.close();
-//             }
-//             else
-//             {
-//               client.println("HTTP/1.1 404 Not Found");
-//               client.println("Connection: close");
-//               client.println();
-//               client.print("404: File Not Found (" + filePath + ")");
-//             }
-//           }
-
-//           break;
-//         }
-//       }
-//     }
-//     delay(5);
-//     client.stop();
-//   }
-// }
-
-// // ETHERNET WEB SERVER HANDLER (FIXED ROUTING)
-// // ============================================================================
-// // ============================================================================
-// // ETHERNET WEB SERVER HANDLER (FIXED FOR MODBUS VALUE)
-// // ============================================================================
-// void handleEthernetClient()
-// {
-//   EthernetClient client = ethServer.available();
-//   if (client)
-//   {
-//     boolean currentLineIsBlank = true;
-//     String reqLine = "";
-//     boolean readingFirstLine = true;
-//     unsigned long timeout = millis();
-
-//     while (client.connected() && millis() - timeout < 3000)
-//     {
-//       if (client.available())
-//       {
-//         char c = client.read();
-
-//         if (readingFirstLine)
-//         {
-//           if (c == '\r' || c == '\n')
-//           {
-//             readingFirstLine = false;
-//           }
-//           else
-//           {
-//             if (reqLine.length() < 250)
-//               reqLine += c;
-//           }
-//         }
-
-//         if (c == '\n' && currentLineIsBlank)
-//         {
-//           int methodEnd = reqLine.indexOf(" ");
-//           int urlEnd = reqLine.indexOf(" ", methodEnd + 1);
-//           if (methodEnd == -1 || urlEnd == -1)
-//           {
-//             client.stop();
-//             return;
-//           }
-
-//           String url = reqLine.substring(methodEnd + 1, urlEnd);
-//           url.trim();
-
-//           String basePath = url;
-//           String queryParams = "";
-//           if (url.indexOf("?") > 0)
-//           {
-//             basePath = url.substring(0, url.indexOf("?"));
-//             queryParams = url.substring(url.indexOf("?") + 1);
-//           }
-
-//           // A. ROUTING HALAMAN HTML
-//           String filePath = basePath;
-//           if (basePath == "/" || basePath == "/home")
-//             filePath = "/home.html";
-//           else if (basePath == "/network")
-//             filePath = "/network.html";
-//           else if (basePath == "/analog_input")
-//             filePath = "/analog_input.html";
-//           else if (basePath == "/digital_IO")
-//             filePath = "/digital_IO.html";
-//           else if (basePath == "/system_settings")
-//             filePath = "/system_settings.html";
-//           else if (basePath == "/modbus_setup")
-//             filePath = "/modbus_setup.html";
-//           else if (basePath == "/updateOTA")
-//             filePath = "/UpdateOTA.html";
-//           else if (basePath == "/debug")
-//             filePath = "/debug-monitor.html";
-
-//           // B. API JSON
-
-//           if (basePath == "/homeLoad")
-//           {
-//             if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-//             {
-//               doc = DynamicJsonDocument(2048);
-//               unsigned char id = 1;
-//               if (queryParams.indexOf("input=") >= 0)
-//               {
-//                 String valStr = queryParams.substring(queryParams.indexOf("input=") + 6);
-//                 id = valStr.toInt();
-//               }
-//               doc["networkMode"] = networkSettings.networkMode;
-//               doc["ssid"] = networkSettings.ssid;
-//               doc["ipAddress"] = Ethernet.localIP().toString();
-//               doc["macAddress"] = networkSettings.macAddress;
-//               doc["protocolMode"] = networkSettings.protocolMode;
-//               doc["endpoint"] = networkSettings.endpoint;
-//               doc["connStatus"] = networkSettings.connStatus;
-//               doc["jobNumber"] = jobNum;
-//               doc["sendInterval"] = networkSettings.sendInterval;
-//               doc["datetime"] = getTimeDateNow();
-//               JsonArray enableAI = doc.createNestedArray("enAI");
-//               for (int i = 1; i <= jumlahInputAnalog; i++)
-//               {
-//                 if (analogInput[i].name != "")
-//                   enableAI.add(1);
-//                 else
-//                   enableAI.add(0);
-//               }
-//               JsonObject AI = doc.createNestedObject("AI");
-//               JsonArray AIRawValue = AI.createNestedArray("rawValue");
-//               JsonArray AIScaledValue = AI.createNestedArray("scaledValue");
-//               for (int i = 1; i <= jumlahInputAnalog; i++)
-//               {
-//                 AIRawValue.add(analogInput[i].adcValue);
-//                 AIScaledValue.add(analogInput[i].mapValue);
-//               }
-//               JsonObject DI = doc.createNestedObject("DI");
-//               JsonArray DIValue = DI.createNestedArray("value");
-//               JsonArray DITaskMode = DI.createNestedArray("taskMode");
-//               for (int i = 1; i <= jumlahInputDigital; i++)
-//               {
-//                 DIValue.add(digitalInput[i].value);
-//                 DITaskMode.add(digitalInput[i].taskMode);
-//               }
-//               String dataLoad;
-//               serializeJson(doc, dataLoad);
-//               xSemaphoreGive(jsonMutex);
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: application/json");
-//               client.println("Connection: close");
-//               client.println();
-//               client.print(dataLoad);
-//             }
-//           }
-//           // else if (basePath == "/getValue")
-//           // {
-//           //   client.println("HTTP/1.1 200 OK");
-//           //   client.println("Content-Type: application/json");
-//           //   client.println("Access-Control-Allow-Origin: *");
-//           //   client.println("Connection: close");
-//           //   client.println();
-//           //   //  if (sendString.length() > 0) client.print(sendString);
-//           //   //  else client.print("{}");
-//           //   if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(100)))
-//           //   {
-//           //     String realtimeJson;
-//           //     serializeJson(jsonSend, realtimeJson); // Ambil jsonSend yg diupdate Task Modbus
-//           //     client.print(realtimeJson);
-//           //     xSemaphoreGive(jsonMutex);
-//           //   }
-//           //   else
-//           //   {
-//           //     client.print("{}");
-//           //   }
-//           // }
-
-//           else if (basePath == "/getValue")
-//           {
-//             client.println("HTTP/1.1 200 OK");
-//             client.println("Content-Type: application/json");
-//             client.println("Access-Control-Allow-Origin: *");
-//             client.println("Connection: close");
-//             client.println();
-
-//             if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-//             {
-//               String realtimeJson;
-//               // Mengambil data dari jsonSend yang sudah diisi oleh Task_ModbusClient
-//               serializeJson(jsonSend, realtimeJson);
-
-//               // --- DEBUG POINT 4: APA YANG DIKIRIM KE WEB? ---
-//               Serial.print("🌐 [Web Eth] Sending /getValue: ");
-//               Serial.println(realtimeJson);
-//               // ----------------------------------------------
-
-//               client.print(realtimeJson);
-//               xSemaphoreGive(jsonMutex);
-//             }
-//             else
-//             {
-//               Serial.println("🌐 [Web Eth] Mutex Busy, sending empty {}");
-//               client.print("{}");
-//             }
-//           }
-
-//           else if (basePath == "/getCurrentValue")
-//           {
-//             if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-//             {
-//               DynamicJsonDocument docTemp(1024);
-//               for (int i = 0; i < jumlahInputDigital; i++)
-//               {
-//                 docTemp["rawValue" + String(i + 1)] = analogInput[i + 1].adcValue;
-//                 docTemp["scaledValue" + String(i + 1)] = analogInput[i + 1].mapValue;
-//               }
-//               String dataLoad;
-//               serializeJson(docTemp, dataLoad);
-//               xSemaphoreGive(jsonMutex);
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: application/json");
-//               client.println("Connection: close");
-//               client.println();
-//               client.print(dataLoad);
-//             }
-//             else
-//             {
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Connection: close");
-//               client.println();
-//               client.print("{}");
-//             }
-//           }
-//           else if (basePath == "/networkLoad")
-//           {
-//             if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-//             {
-//               doc = DynamicJsonDocument(4096);
-//               doc["networkMode"] = networkSettings.networkMode;
-//               doc["ssid"] = networkSettings.ssid;
-//               doc["password"] = networkSettings.password;
-//               doc["apSsid"] = networkSettings.apSsid;
-//               doc["apPassword"] = networkSettings.apPassword;
-//               doc["dhcpMode"] = networkSettings.dhcpMode;
-//               doc["ipAddress"] = networkSettings.ipAddress;
-//               doc["subnet"] = networkSettings.subnetMask;
-//               doc["ipGateway"] = networkSettings.ipGateway;
-//               doc["ipDNS"] = networkSettings.ipDNS;
-//               doc["sendInterval"] = String(networkSettings.sendInterval, 2);
-//               doc["protocolMode"] = networkSettings.protocolMode;
-//               doc["endpoint"] = networkSettings.endpoint;
-//               doc["port"] = networkSettings.port;
-//               doc["pubTopic"] = networkSettings.pubTopic;
-//               doc["subTopic"] = networkSettings.subTopic;
-//               doc["mqttUsername"] = networkSettings.mqttUsername;
-//               doc["mqttPass"] = networkSettings.mqttPassword;
-//               doc["loggerMode"] = networkSettings.loggerMode;
-//               doc["protocolMode2"] = networkSettings.protocolMode2;
-//               doc["modbusMode"] = modbusParam.mode;
-//               doc["modbusPort"] = modbusParam.port;
-//               doc["modbusSlaveID"] = modbusParam.slaveID;
-//               doc["sendTrig"] = networkSettings.sendTrig;
-//               doc["erpUrl"] = networkSettings.erpUrl;
-//               doc["erpUsername"] = networkSettings.erpUsername;
-//               doc["erpPassword"] = networkSettings.erpPassword;
-//               String dataLoad;
-//               serializeJson(doc, dataLoad);
-//               xSemaphoreGive(jsonMutex);
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: application/json");
-//               client.println("Connection: close");
-//               client.println();
-//               client.print(dataLoad);
-//             }
-//           }
-//           else if (basePath == "/settingsLoad")
-//           {
-//             String jsonAuth = "{";
-//             jsonAuth += "\"username\":\"" + networkSettings.loginUsername + "\",";
-//             jsonAuth += "\"password\":\"" + networkSettings.loginPassword + "\",";
-//             jsonAuth += "\"sdInterval\":" + String(networkSettings.sdSaveInterval);
-//             jsonAuth += "}";
-//             client.println("HTTP/1.1 200 OK");
-//             client.println("Content-Type: application/json");
-//             client.println("Connection: close");
-//             client.println();
-//             client.print(jsonAuth);
-//           }
-//           else if (basePath == "/getTime")
-//           {
-//             DynamicJsonDocument jsonDoc(256);
-//             jsonDoc["datetime"] = getTimeDateNow();
-//             String jsonTime;
-//             serializeJson(jsonDoc, jsonTime);
-//             client.println("HTTP/1.1 200 OK");
-//             client.println("Content-Type: application/json");
-//             client.println("Connection: close");
-//             client.println();
-//             client.print(jsonTime);
-//           }
-//           else if (basePath == "/analogLoad")
-//           {
-//             int id = 1;
-//             if (queryParams.indexOf("input=") >= 0)
-//             {
-//               int start = queryParams.indexOf("input=") + 6;
-//               int end = queryParams.indexOf("&", start);
-//               if (end == -1)
-//                 end = queryParams.length();
-//               id = queryParams.substring(start, end).toInt();
-//             }
-//             if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-//             {
-//               doc = DynamicJsonDocument(4096);
-//               doc["inputType"] = analogInput[id].inputType;
-//               doc["filter"] = analogInput[id].filter;
-//               doc["filterPeriod"] = (String(analogInput[id].filterPeriod, 2));
-//               doc["scaling"] = analogInput[id].scaling;
-//               doc["lowLimit"] = analogInput[id].lowLimit;
-//               doc["highLimit"] = analogInput[id].highLimit;
-//               doc["name"] = analogInput[id].name;
-//               doc["calibration"] = analogInput[id].calibration;
-//               doc["mValue"] = analogInput[id].mValue;
-//               doc["cValue"] = analogInput[id].cValue;
-//               String dataLoad;
-//               serializeJson(doc, dataLoad);
-//               xSemaphoreGive(jsonMutex);
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: application/json");
-//               client.println("Connection: close");
-//               client.println();
-//               client.print(dataLoad);
-//             }
-//           }
-//           else if (basePath == "/digitalLoad")
-//           {
-//             if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-//             {
-//               doc = DynamicJsonDocument(4096);
-//               if (queryParams.indexOf("input=") >= 0)
-//               {
-//                 int start = queryParams.indexOf("input=") + 6;
-//                 int end = queryParams.indexOf("&", start);
-//                 if (end == -1)
-//                   end = queryParams.length();
-//                 int id = queryParams.substring(start, end).toInt();
-//                 doc["nameDI"] = digitalInput[id].name;
-//                 doc["invDI"] = digitalInput[id].inv;
-//                 doc["taskMode"] = digitalInput[id].taskMode;
-//                 doc["inputState"] = digitalInput[id].inputState ? "High" : "Low";
-//                 doc["intervalTime"] = (float)digitalInput[id].intervalTime / 1000;
-//                 doc["conversionFactor"] = digitalInput[id].conversionFactor;
-//               }
-//               String dataLoad;
-//               serializeJson(doc, dataLoad);
-//               xSemaphoreGive(jsonMutex);
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: application/json");
-//               client.println("Connection: close");
-//               client.println();
-//               client.print(dataLoad);
-//             }
-//           }
-//           else if (basePath == "/modbusLoad")
-//           {
-//             client.println("HTTP/1.1 200 OK");
-//             client.println("Content-Type: application/json");
-//             client.println("Connection: close");
-//             client.println();
-//             client.print(stringParam);
-//           }
-//           // C. STATIC FILE HANDLER
-//           else
-//           {
-//             if (SPIFFS.exists(filePath))
-//             {
-//               File file = SPIFFS.open(filePath, "r");
-//               String contentType = getContentType(filePath);
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: " + contentType);
-//               if (filePath.endsWith(".css") || filePath.endsWith(".js") || filePath.endsWith(".png"))
-//               {
-//                 client.println("Cache-Control: public, max-age=31536000");
-//               }
-//               client.println("Connection: close");
-//               client.println();
-//               uint8_t buffer[512];
-//               while (file.available())
-//               {
-//                 int bytesRead = file.read(buffer, sizeof(buffer));
-//                 client.write(buffer, bytesRead);
-//               }
-//               file.close();
-//             }
-//             else
-//             {
-//               client.println("HTTP/1.1 404 Not Found");
-//               client.println("Connection: close");
-//               client.println();
-//             }
-//           }
-
-//           break;
-//         }
-
-//         if (c == '\n')
-//           currentLineIsBlank = true;
-//         else if (c != '\r')
-//           currentLineIsBlank = false;
-//       }
-//     }
-//     delay(2);
-//     client.stop();
-//   }
-// }
+  uint32_t index = (uint32_t)arg;
+  uint8_t mode = diIsrMode[index];
 
-// ============================================================================
-// ETHERNET WEB SERVER HANDLER (TAMPILAN 100% SAMA DENGAN WIFI)
-// ============================================================================
-// void handleEthernetClient()
-// {
-//   EthernetClient client = ethServer.available();
-//   if (client)
-//   {
-//     boolean currentLineIsBlank = true;
-//     String reqLine = "";
-//     boolean readingFirstLine = true;
-//     unsigned long timeout = millis();
-
-//     while (client.connected() && millis() - timeout < 3000)
-//     {
-//       if (client.available())
-//       {
-//         char c = client.read();
-
-//         // 1. Tangkap Baris Pertama Request (GET /... HTTP/1.1)
-//         if (readingFirstLine) {
-//           if (c == '\r' || c == '\n') {
-//             readingFirstLine = false;
-//           } else {
-//             if (reqLine.length() < 250) reqLine += c;
-//           }
-//         }
-
-//         // 2. Deteksi Akhir Header
-//         if (c == '\n' && currentLineIsBlank)
-//         {
-//           int methodEnd = reqLine.indexOf(" ");
-//           int urlEnd = reqLine.indexOf(" ", methodEnd + 1);
-//           if (methodEnd == -1 || urlEnd == -1) { client.stop(); return; }
-
-//           String url = reqLine.substring(methodEnd + 1, urlEnd);
-//           url.trim();
-
-//           // Pisahkan URL Dasar dan Parameter (?input=1...)
-//           String basePath = url;
-//           String queryParams = "";
-//           if (url.indexOf("?") > 0) {
-//              basePath = url.substring(0, url.indexOf("?"));
-//              queryParams = url.substring(url.indexOf("?") + 1);
-//           }
-
-//           // ==================================================================
-//           // A. ROUTING HALAMAN HTML (URL -> FILE)
-//           // ==================================================================
-//           String filePath = basePath;
-//           if (basePath == "/" || basePath == "/home") filePath = "/home.html";
-//           else if (basePath == "/network") filePath = "/network.html";
-//           else if (basePath == "/analog_input") filePath = "/analog_input.html";
-//           else if (basePath == "/digital_IO") filePath = "/digital_IO.html";
-//           else if (basePath == "/system_settings") filePath = "/system_settings.html";
-//           else if (basePath == "/modbus_setup") filePath = "/modbus_setup.html";
-//           else if (basePath == "/updateOTA") filePath = "/UpdateOTA.html";
-//           else if (basePath == "/debug") filePath = "/debug-monitor.html";
-
-//           // ==================================================================
-//           // B. API JSON (WAJIB ADA AGAR TAMPILAN TIDAK KOSONG)
-//           // ==================================================================
-
-//           // 1. STATUS HEADER (Agar Tampilan Header Sama Persis WiFi)
-//           if (basePath == "/wifiStatus" || basePath == "/ethernetStatus")
-//           {
-//              DynamicJsonDocument statusDoc(512);
-//              statusDoc["mode"] = networkSettings.networkMode;
-//              statusDoc["ssid"] = "Ethernet LAN"; // Nama palsu biar header isi
-//              statusDoc["connected"] = (Ethernet.linkStatus() == LinkON);
-//              statusDoc["ip"] = Ethernet.localIP().toString();
-//              statusDoc["rssi"] = -40; // Sinyal Full (Palsu)
-//              statusDoc["macAddress"] = networkSettings.macAddress;
-//              statusDoc["connectionStatus"] = networkSettings.connStatus;
-//              statusDoc["signalQuality"] = "Wired"; // Indikator kabel
-
-//              // Info tambahan biar JS tidak error
-//              statusDoc["freeHeap"] = ESP.getFreeHeap();
-//              statusDoc["uptime"] = millis() / 1000;
-
-//              String response; serializeJson(statusDoc, response);
-//              client.println("HTTP/1.1 200 OK"); client.println("Content-Type: application/json");
-//              client.println("Connection: close"); client.println(); client.print(response);
-//           }
-
-//           // 2. HOME LOAD (Dashboard)
-//           else if (basePath == "/homeLoad")
-//           {
-//              if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(20))) {
-//                 doc = DynamicJsonDocument(2048);
-//                 // Parsing Input Param jika ada
-//                 unsigned char id = 1;
-//                 if(queryParams.indexOf("input=") >= 0) {
-//                    String valStr = queryParams.substring(queryParams.indexOf("input=") + 6);
-//                    id = valStr.toInt();
-//                 }
-
-//                 doc["networkMode"] = networkSettings.networkMode;
-//                 doc["ssid"] = networkSettings.ssid;
-//                 doc["ipAddress"] = Ethernet.localIP().toString();
-//                 doc["macAddress"] = networkSettings.macAddress;
-//                 doc["protocolMode"] = networkSettings.protocolMode;
-//                 doc["endpoint"] = networkSettings.endpoint;
-//                 doc["connStatus"] = networkSettings.connStatus;
-//                 doc["jobNumber"] = jobNum;
-//                 doc["sendInterval"] = networkSettings.sendInterval;
-//                 doc["datetime"] = getTimeDateNow();
-
-//                 JsonArray enableAI = doc.createNestedArray("enAI");
-//                 for (int i = 1; i <= jumlahInputAnalog; i++) {
-//                    enableAI.add(analogInput[i].name != "" ? 1 : 0);
-//                 }
-//                 JsonObject AI = doc.createNestedObject("AI");
-//                 JsonArray AIRawValue = AI.createNestedArray("rawValue");
-//                 JsonArray AIScaledValue = AI.createNestedArray("scaledValue");
-//                 for (int i = 1; i <= jumlahInputAnalog; i++) {
-//                    AIRawValue.add(analogInput[i].adcValue);
-//                    AIScaledValue.add(analogInput[i].mapValue);
-//                 }
-//                 JsonObject DI = doc.createNestedObject("DI");
-//                 JsonArray DIValue = DI.createNestedArray("value");
-//                 JsonArray DITaskMode = DI.createNestedArray("taskMode");
-//                 for (int i = 1; i <= jumlahInputDigital; i++) {
-//                    DIValue.add(digitalInput[i].value);
-//                    DITaskMode.add(digitalInput[i].taskMode);
-//                 }
-//                 String dataLoad; serializeJson(doc, dataLoad); xSemaphoreGive(jsonMutex);
-//                 client.println("HTTP/1.1 200 OK"); client.println("Content-Type: application/json");
-//                 client.println("Connection: close"); client.println(); client.print(dataLoad);
-//              }
-//           }
-
-//           // 3. GET VALUE (MODBUS REALTIME - DENGAN BYPASS)
-// else if (basePath == "/getValue")
-//           {
-//              client.println("HTTP/1.1 200 OK");
-//              client.println("Content-Type: application/json");
-//              client.println("Access-Control-Allow-Origin: *");
-//              client.println("Connection: close");
-//              client.println();
-
-//              if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(100))) {
-//                  String realtimeJson;
-//                  // Ambil data dari variabel global jsonSend
-//                  serializeJson(jsonSend, realtimeJson);
-
-//                  // --- DEBUG PRINT: Lihat apa yang dikirim ke browser ---
-//                  Serial.print("Kirim ke Web: ");
-//                  Serial.println(realtimeJson);
-//                  // -----------------------------------------------------
-
-//                  client.print(realtimeJson);
-//                  xSemaphoreGive(jsonMutex);
-//              } else {
-//                  client.print("{}"); // Kirim kosong jika sistem sibuk
-//              }
-//           }
-//           // 4. GET CURRENT VALUE (IO REALTIME)
-//           else if (basePath == "/getCurrentValue")
-//           {
-//              if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(20))) {
-//                 DynamicJsonDocument docTemp(1024);
-//                 for (int i = 0; i < jumlahInputDigital; i++) {
-//                    docTemp["rawValue" + String(i + 1)] = analogInput[i+1].adcValue;
-//                    docTemp["scaledValue" + String(i + 1)] = analogInput[i+1].mapValue;
-//                 }
-//                 String dataLoad; serializeJson(docTemp, dataLoad); xSemaphoreGive(jsonMutex);
-//                 client.println("HTTP/1.1 200 OK"); client.println("Content-Type: application/json");
-//                 client.println("Connection: close"); client.println(); client.print(dataLoad);
-//              }
-//           }
-
-//           // 5. NETWORK LOAD
-//           else if (basePath == "/networkLoad") {
-//              if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(20))) {
-//                 doc = DynamicJsonDocument(4096);
-//                 doc["networkMode"] = networkSettings.networkMode;
-//                 doc["ssid"] = networkSettings.ssid;
-//                 doc["password"] = networkSettings.password;
-//                 doc["apSsid"] = networkSettings.apSsid;
-//                 doc["apPassword"] = networkSettings.apPassword;
-//                 doc["dhcpMode"] = networkSettings.dhcpMode;
-//                 doc["ipAddress"] = networkSettings.ipAddress;
-//                 doc["subnet"] = networkSettings.subnetMask;
-//                 doc["ipGateway"] = networkSettings.ipGateway;
-//                 doc["ipDNS"] = networkSettings.ipDNS;
-//                 doc["sendInterval"] = String(networkSettings.sendInterval, 2);
-//                 doc["protocolMode"] = networkSettings.protocolMode;
-//                 doc["endpoint"] = networkSettings.endpoint;
-//                 doc["port"] = networkSettings.port;
-//                 doc["pubTopic"] = networkSettings.pubTopic;
-//                 doc["subTopic"] = networkSettings.subTopic;
-//                 doc["mqttUsername"] = networkSettings.mqttUsername;
-//                 doc["mqttPass"] = networkSettings.mqttPassword;
-//                 doc["loggerMode"] = networkSettings.loggerMode;
-//                 doc["protocolMode2"] = networkSettings.protocolMode2;
-//                 doc["modbusMode"] = modbusParam.mode;
-//                 doc["modbusPort"] = modbusParam.port;
-//                 doc["modbusSlaveID"] = modbusParam.slaveID;
-//                 doc["sendTrig"] = networkSettings.sendTrig;
-//                 doc["erpUrl"] = networkSettings.erpUrl;
-//                 doc["erpUsername"] = networkSettings.erpUsername;
-//                 doc["erpPassword"] = networkSettings.erpPassword;
-//                 String dataLoad; serializeJson(doc, dataLoad); xSemaphoreGive(jsonMutex);
-//                 client.println("HTTP/1.1 200 OK"); client.println("Content-Type: application/json");
-//                 client.println("Connection: close"); client.println(); client.print(dataLoad);
-//              }
-//           }
-
-//           // 6. SETTINGS LOAD
-//           else if (basePath == "/settingsLoad") {
-//              String jsonAuth = "{";
-//              jsonAuth += "\"username\":\"" + networkSettings.loginUsername + "\",";
-//              jsonAuth += "\"password\":\"" + networkSettings.loginPassword + "\",";
-//              jsonAuth += "\"sdInterval\":" + String(networkSettings.sdSaveInterval);
-//              jsonAuth += "}";
-//              client.println("HTTP/1.1 200 OK"); client.println("Content-Type: application/json");
-//              client.println("Connection: close"); client.println(); client.print(jsonAuth);
-//           }
-
-//           // 7. GET TIME (Jam di Header)
-//           else if (basePath == "/getTime") {
-//              DynamicJsonDocument jsonDoc(256);
-//              jsonDoc["datetime"] = getTimeDateNow();
-//              String jsonTime; serializeJson(jsonDoc, jsonTime);
-//              client.println("HTTP/1.1 200 OK"); client.println("Content-Type: application/json");
-//              client.println("Connection: close"); client.println(); client.print(jsonTime);
-//           }
-
-//           // 8. ANALOG LOAD
-//           else if (basePath == "/analogLoad") {
-//              int id = 1;
-//              if(queryParams.indexOf("input=") >= 0) {
-//                 int start = queryParams.indexOf("input=") + 6;
-//                 int end = queryParams.indexOf("&", start); if(end == -1) end = queryParams.length();
-//                 id = queryParams.substring(start, end).toInt();
-//              }
-//              if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(20))) {
-//                 doc = DynamicJsonDocument(4096);
-//                 doc["inputType"] = analogInput[id].inputType;
-//                 doc["filter"] = analogInput[id].filter;
-//                 doc["filterPeriod"] = (String(analogInput[id].filterPeriod, 2));
-//                 doc["scaling"] = analogInput[id].scaling;
-//                 doc["lowLimit"] = analogInput[id].lowLimit;
-//                 doc["highLimit"] = analogInput[id].highLimit;
-//                 doc["name"] = analogInput[id].name;
-//                 doc["calibration"] = analogInput[id].calibration;
-//                 doc["mValue"] = analogInput[id].mValue;
-//                 doc["cValue"] = analogInput[id].cValue;
-//                 String dataLoad; serializeJson(doc, dataLoad); xSemaphoreGive(jsonMutex);
-//                 client.println("HTTP/1.1 200 OK"); client.println("Content-Type: application/json");
-//                 client.println("Connection: close"); client.println(); client.print(dataLoad);
-//              }
-//           }
-
-//           // 9. DIGITAL LOAD
-//           else if (basePath == "/digitalLoad") {
-//              if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(20))) {
-//                 doc = DynamicJsonDocument(4096);
-//                 if(queryParams.indexOf("input=") >= 0) {
-//                    int start = queryParams.indexOf("input=") + 6;
-//                    int end = queryParams.indexOf("&", start); if(end == -1) end = queryParams.length();
-//                    int id = queryParams.substring(start, end).toInt();
-//                    doc["nameDI"] = digitalInput[id].name;
-//                    doc["invDI"] = digitalInput[id].inv;
-//                    doc["taskMode"] = digitalInput[id].taskMode;
-//                    doc["inputState"] = digitalInput[id].inputState ? "High" : "Low";
-//                    doc["intervalTime"] = (float)digitalInput[id].intervalTime/1000;
-//                    doc["conversionFactor"] = digitalInput[id].conversionFactor;
-//                 }
-//                 String dataLoad; serializeJson(doc, dataLoad); xSemaphoreGive(jsonMutex);
-//                 client.println("HTTP/1.1 200 OK"); client.println("Content-Type: application/json");
-//                 client.println("Connection: close"); client.println(); client.print(dataLoad);
-//              }
-//           }
-
-//           // 10. MODBUS LOAD
-//           else if (basePath == "/modbusLoad") {
-//              client.println("HTTP/1.1 200 OK"); client.println("Content-Type: application/json");
-//              client.println("Connection: close"); client.println(); client.print(stringParam);
-//           }
-
-//           // ==================================================================
-//           // C. STATIC FILE HANDLER (CSS, JS, IMAGES) - DENGAN BUFFER
-//           // ==================================================================
-//           else
-//           {
-//             if (SPIFFS.exists(filePath))
-//             {
-//               File file = SPIFFS.open(filePath, "r");
-//               String contentType = getContentType(filePath);
-
-//               client.println("HTTP/1.1 200 OK");
-//               client.println("Content-Type: " + contentType);
-
-//               // Cache Control agar browser tidak reload asset statis (Load Cepat)
-//               if (filePath.endsWith(".css") || filePath.endsWith(".js") || filePath.endsWith(".png")) {
-//                 client.println("Cache-Control: public, max-age=31536000");
-//               }
-//               client.println("Connection: close");
-//               client.println();
-
-//               // KIRIM DENGAN BUFFER 512 BYTE (Stabil & Cepat)
-//               uint8_t buffer[512];
-//               while (file.available()) {
-//                 int bytesRead = file.read(buffer, sizeof(buffer));
-//                 client.write(buffer, bytesRead);
-//               }
-//               file.close();
-//             }
-//             else
-//             {
-//               client.println("HTTP/1.1 404 Not Found");
-//               client.println("Connection: close");
-//               client.println();
-//             }
-//           }
-
-//           break;
-//         }
+  if (mode & DI_ISR_PULSE)
+    digitalInput[index].sumValue++;
 
-//         if (c == '\n') currentLineIsBlank = true;
-//         else if (c != '\r') currentLineIsBlank = false;
-//       }
-//     }
-//     delay(2);
-//     client.stop();
-//   }
-// }
-
-// ============================================================================
-// 1. HELPER FUNCTIONS (WAJIB ADA UNTUK MEMBACA DATA SAVE)
-// ============================================================================
-unsigned char h2int(char c)
-{
-  if (c >= '0' && c <= '9')
-    return ((unsigned char)c - '0');
-  if (c >= 'a' && c <= 'f')
-    return ((unsigned char)c - 'a' + 10);
-  if (c >= 'A' && c <= 'F')
-    return ((unsigned char)c - 'A' + 10);
-  return 0;
-}
-
-String urlDecode(String str)
-{
-  String encodedString = "";
-  char c, code0, code1;
-  for (int i = 0; i < str.length(); i++)
+  // Cek apakah selisih waktu dari trigger terakhir > 50ms
+  if ((mode & (DI_ISR_EDGE | DI_ISR_TRIGGER)) && millis() - digitalInput[index].millisNow >= DEBOUNCE_TIME)
   {
-    c = str.charAt(i);
-    if (c == '+')
-    {
-      encodedString += ' ';
-    }
-    else if (c == '%')
-    {
-      i++;
-      code0 = str.charAt(i);
-      i++;
-      code1 = str.charAt(i);
-      c = (h2int(code0) << 4) | h2int(code1);
-      encodedString += c;
-    }
-    else
-    {
-      encodedString += c;
-    }
+    digitalInput[index].millisNow = millis(); // Simpan waktu trigger ini
+    digitalInput[index].flagInt = 1;          // Set flag untuk diproses task
   }
-  return encodedString;
 }
 
-String getPostValue(String data, String key)
+// Terapkan mode ISR satu DI dari snapshot (mode DI & trigger kirim).
+// Enable: mode dulu baru interrupt; disable: interrupt dulu baru mode.
+void attachDigitalInputInterrupt(const RuntimeConfig *cfg, int index)
 {
-  String keyParam = key + "=";
-  int keyStart = data.indexOf(keyParam);
-  if (keyStart == -1)
-    return "";
-  int valStart = keyStart + keyParam.length();
-  int valEnd = data.indexOf("&", valStart);
-  if (valEnd == -1)
-    valEnd = data.length();
-  return urlDecode(data.substring(valStart, valEnd));
-}
-// ============================================================================
-// ETHERNET WEB SERVER HANDLER (FIXED VERSION - ANTI HANG)
-// ============================================================================
-// ============================================================================
-// ETHERNET WEB SERVER HANDLER (FULL VERSION - FIXED)
-// ============================================================================
-void handleEthernetClient()
-{
-  EthernetClient client = ethServer.available();
-  if (!client)
+  if (index < 1 || index > jumlahInputDigital)
     return;
 
-  // [SETTING] Timeout & Buffer
-  client.setTimeout(100);
-  client.setConnectionTimeout(500);
-
-  String req = "";
-  String postData = "";
-  unsigned long timeout = millis();
-  bool headerFinished = false;
-  int contentLength = 0;
-  uint8_t tempBuf[256];
-
-  // 1. READ REQUEST (Membaca Data dari Browser)
-  while (client.connected() && millis() - timeout < 1000)
-  {
-    if (client.available())
-    {
-      int len = client.read(tempBuf, sizeof(tempBuf));
-      if (len > 0)
-      {
-        if (!headerFinished)
-        {
-          for (int i = 0; i < len; i++)
-          {
-            req += (char)tempBuf[i];
-            if (req.endsWith("\r\n\r\n"))
-            {
-              headerFinished = true;
-              String lowerReq = req;
-              lowerReq.toLowerCase();
-              int clIndex = lowerReq.indexOf("content-length:");
-              if (clIndex != -1)
-              {
-                contentLength = lowerReq.substring(clIndex + 15, lowerReq.indexOf('\n', clIndex)).toInt();
-              }
-              for (int j = i + 1; j < len; j++)
-                postData += (char)tempBuf[j];
-              break;
-            }
-          }
-        }
-        else
-        {
-          for (int i = 0; i < len; i++)
-            postData += (char)tempBuf[i];
-        }
-      }
-      if (headerFinished)
-      {
-        if (req.startsWith("GET"))
-          break;
-        if (req.startsWith("POST") && postData.length() >= contentLength)
-          break;
-      }
-    }
-    vTaskDelay(1);
-  }
-
-  if (req.length() == 0)
-  {
-    client.stop();
-    return;
-  }
+  uint8_t mode = 0;
+  uint8_t taskMode = cfg->di[index].mode;
+  if (taskMode == DI_MODE_CYCLE_TIME || taskMode == DI_MODE_COUNTING)
+    mode |= DI_ISR_EDGE;
+  else if (taskMode == DI_MODE_PULSE)
+    mode |= DI_ISR_PULSE;
+  if (cfg->sendTrigPin == index)
+    mode |= DI_ISR_TRIGGER;
 
-  // 2. PARSE URL & METHOD
-  int firstSpace = req.indexOf(' ');
-  int secondSpace = req.indexOf(' ', firstSpace + 1);
-  if (firstSpace == -1 || secondSpace == -1)
-  {
-    client.stop();
+  if (mode == diIsrMode[index])
     return;
-  }
-
-  String method = req.substring(0, firstSpace);
-  String fullUrl = req.substring(firstSpace + 1, secondSpace);
-  fullUrl.trim();
 
-  String basePath = fullUrl;
-  String queryParams = "";
-  if (fullUrl.indexOf("?") > 0)
+  gpio_num_t pin = (gpio_num_t)digitalInput[index].pin;
+  if (mode)
   {
-    basePath = fullUrl.substring(0, fullUrl.indexOf("?"));
-    queryParams = fullUrl.substring(fullUrl.indexOf("?") + 1);
-  }
-
-  // 3. PARSE JSON BODY (Penting untuk Save Config dari Web Modern)
-  bool isJson = false;
-  DynamicJsonDocument jsonBody(2048);
-  postData.trim();
-  if (method == "POST" && (postData.startsWith("{") || postData.startsWith("[")))
-  {
-    DeserializationError error = deserializeJson(jsonBody, postData);
-    if (!error)
-      isJson = true;
-  }
-
-  // Helper Lambda: Otomatis pilih ambil data dari JSON atau Form Data
-  auto getValue = [&](String key) -> String
-  {
-    if (isJson && jsonBody.containsKey(key))
-      return jsonBody[key].as<String>();
-    return getPostValue(postData, key);
-  };
-
-  // ========================================================================
-  // A. POST HANDLING (SAVE CONFIGURATION)
-  // ========================================================================
-  if (method == "POST")
-  {
-    client.println("HTTP/1.1 200 OK");
-    client.println("Access-Control-Allow-Origin: *");
-    client.println("Content-Type: text/plain");
-    client.println("Connection: close");
-    client.println();
-
-    // --- 1. SAVE ANALOG INPUT (FIXED JSON SUPPORT) ---
-    if (basePath == "/analog_input" || getValue("inputPin").startsWith("AI"))
-    {
-      String targetPin = getValue("inputPin");
-      if (targetPin.startsWith("AI"))
-      {
-        int id = targetPin.substring(2).toInt();
-        if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(500)))
-        {
-          analogInput[id].name = getValue("name");
-          analogInput[id].inputType = getValue("inputType");
-
-          // [FIX UTAMA] Deteksi Boolean dari JSON vs Form
-          if (isJson)
-          {
-            analogInput[id].filter = jsonBody["filter"];
-            analogInput[id].scaling = jsonBody["scaling"];
-            analogInput[id].calibration = jsonBody["calibration"];
-          }
-          else
-          {
-            // Fallback Form Data (indexOf)
-            analogInput[id].filter = (postData.indexOf("filter=") != -1);
-            analogInput[id].scaling = (postData.indexOf("scaling=") != -1);
-            analogInput[id].calibration = (postData.indexOf("calibration=") != -1);
-          }
-
-          // Ambil Angka (getValue otomatis handle JSON)
-          analogInput[id].lowLimit = getValue("lowLimit").toFloat();
-          analogInput[id].highLimit = getValue("highLimit").toFloat();
-          analogInput[id].mValue = getValue("mValue").toFloat();
-          analogInput[id].cValue = getValue("cValue").toFloat();
-          analogInput[id].filterPeriod = getValue("filterPeriod").toFloat();
-
-          xSemaphoreGive(jsonMutex);
-        }
-        saveToJson("/configAnalog.json", "analog");
-        saveToSDConfig("/configAnalog.json", "analog");
-        client.print("Analog Saved");
-      }
-    }
-
-    // --- 2. SAVE DIGITAL INPUT ---
-    else if (basePath == "/digital_IO" || getValue("inputPin").startsWith("DI"))
-    {
-      String targetPin = getValue("inputPin");
-      if (targetPin.startsWith("DI"))
-      {
-        int id = targetPin.substring(2).toInt();
-        if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(500)))
-        {
-          digitalInput[id].name = getValue("nameDI");
-          digitalInput[id].taskMode = getValue("taskMode");
-          if (digitalInput[id].taskMode != getValue("taskMode"))
-            digitalInput[id].value = 0;
-          digitalInput[id].inputState = (getValue("inputState") == "High") ? 1 : 0;
-
-          if (isJson)
-            digitalInput[id].inv = jsonBody.containsKey("inputInversion") && jsonBody["inputInversion"];
-          else
-            digitalInput[id].inv = (postData.indexOf("inputInversion=") != -1);
-
-          digitalInput[id].intervalTime = (long)(getValue("intervalTime").toFloat() * 1000);
-          digitalInput[id].conversionFactor = getValue("conversionFactor").toFloat();
-          attachDigitalInputInterrupt(id);
-          xSemaphoreGive(jsonMutex);
-        }
-        saveToJson("/configDigital.json", "digital");
-        saveToSDConfig("/configDigital.json", "digital");
-        client.print("Digital Saved");
-      }
-    }
-
-    // --- 3. SAVE NETWORK ---
-    else if (basePath == "/network" || getValue("networkMode") != "" || getValue("erpUrl") != "")
-    {
-      if (getValue("erpUrl") != "")
-      {
-        networkSettings.erpUrl = getValue("erpUrl");
-        networkSettings.erpUsername = getValue("erpUsername");
-        networkSettings.erpPassword = getValue("erpPassword");
-      }
-      else
-      {
-        networkSettings.networkMode = getValue("networkMode");
-        networkSettings.dhcpMode = getValue("dhcpMode");
-        networkSettings.ssid = getValue("ssid");
-        networkSettings.password = getValue("password");
-        networkSettings.apSsid = getValue("apSsid");
-        networkSettings.apPassword = getValue("apPassword");
-        networkSettings.ipAddress = getValue("ipAddress");
-        networkSettings.subnetMask = getValue("subnet");
-        networkSettings.ipGateway = getValue("ipGateway");
-        networkSettings.ipDNS = getValue("ipDNS");
-        networkSettings.protocolMode = getValue("protocolMode");
-        networkSettings.endpoint = getValue("endpoint");
-        networkSettings.port = getValue("port").toInt();
-        networkSettings.sendInterval = getValue("sendInterval").toFloat();
-        networkSettings.sendTrig = getValue("sendTrig");
-        networkSettings.mqttUsername = getValue("mqttUsername");
-        networkSettings.mqttPassword = getValue("mqttPass");
-        networkSettings.pubTopic = getValue("pubTopic");
-        networkSettings.subTopic = getValue("subTopic");
-
-        if (getValue("modbusMode") != "")
-        {
-          networkSettings.protocolMode2 = getValue("protocolMode2");
-          modbusParam.port = getValue("modbusPort").toInt();
-          modbusParam.slaveID = getValue("slaveID").toInt();
-        }
-        configureSendTriggerInterrupt(networkSettings);
-      }
-      saveToJson("/configNetwork.json", "network");
-      saveToSDConfig("/configNetwork.json", "network");
-      client.print("Network Saved");
-    }
-
-    // --- 4. SAVE MODBUS SETUP ---
-    else if (basePath == "/modbus_setup")
-    {
-      if (isJson)
-      {
-        jsonParam = jsonBody; // Full copy JSON structure
-        modbusParam.baudrate = jsonParam["baudrate"];
-        modbusParam.parity = jsonParam["parity"].as<String>();
-        modbusParam.stopBit = jsonParam["stopBit"];
-        modbusParam.dataBit = jsonParam["dataBit"];
-        modbusParam.scanRate = jsonParam["scanRate"];
-      }
-      else if (getValue("baudrate") != "")
-      {
-        modbusParam.baudrate = getValue("baudrate").toInt();
-        modbusParam.parity = getValue("parity");
-        modbusParam.stopBit = getValue("stopBit").toInt();
-        modbusParam.dataBit = getValue("dataBit").toInt();
-        modbusParam.scanRate = getValue("scanRate").toFloat();
-        // Update global JSON
-        jsonParam["baudrate"] = modbusParam.baudrate;
-        jsonParam["parity"] = modbusParam.parity;
-        jsonParam["stopBit"] = modbusParam.stopBit;
-        jsonParam["dataBit"] = modbusParam.dataBit;
-        jsonParam["scanRate"] = modbusParam.scanRate;
-      }
-      stringParam = "";
-      serializeJson(jsonParam, stringParam);
-      saveToJson("/modbusSetup.json", "modbusSetup");
-      saveToSDConfig("/modbusSetup.json", "modbusSetup");
-      client.print("Modbus Saved");
-    }
-
-    // --- 5. SAVE SYSTEM SETTINGS ---
-    else if (basePath == "/system_settings" || getValue("username") != "")
-    {
-      networkSettings.loginUsername = getValue("username");
-      networkSettings.loginPassword = getValue("password");
-      networkSettings.sdSaveInterval = getValue("sdInterval").toInt();
-
-      String dt = getValue("datetime");
-      if (dt.length() >= 16)
-      {
-        int yy = dt.substring(0, 4).toInt();
-        int mm = dt.substring(5, 7).toInt();
-        int dd = dt.substring(8, 10).toInt();
-        int hh = dt.substring(11, 13).toInt();
-        int mn = dt.substring(14, 16).toInt();
-        rtc.adjust(DateTime(yy, mm, dd, hh, mn, 0));
-      }
-      saveToJson("/systemSettings.json", "systemSettings");
-      saveToSDConfig("/systemSettings.json", "systemSettings");
-      client.print("Settings Saved");
-    }
-    else
-    {
-      client.print("OK");
-    }
+    if (!(diIsrMode[index] & DI_ISR_PULSE) && (mode & DI_ISR_PULSE))
+      digitalInput[index].sumValue = 0;
+    diIsrMode[index] = mode;
+    gpio_intr_enable(pin);
   }
-
-  // ========================================================================
-  // B. GET HANDLING (LOAD DATA API) - FIXED REALTIME VALUE
-  // ========================================================================
-  else if (method == "GET")
+  else
   {
-    if (basePath.endsWith("Load") || basePath.endsWith("Value") ||
-        basePath.endsWith("Status") || basePath == "/getTime")
-    {
-      client.println("HTTP/1.1 200 OK");
-      client.println("Content-Type: application/json");
-      client.println("Access-Control-Allow-Origin: *");
-      client.println("Cache-Control: no-store, no-cache, must-revalidate"); 
-      client.println("Connection: close");
-      client.println();
-
-      // --- 1. GET VALUE 
-      if (basePath == "/getValue")
-      {
-        if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(100)))
-        {
-          DynamicJsonDocument docTemp(4096);
-          JsonArray arr = docTemp.to<JsonArray>();
-          JsonObject root = jsonSend.as<JsonObject>();
-
-          for (JsonPair kv : root)
-          {
-            if (String(kv.key().c_str()) == "-")
-              continue;
-            JsonObject item = arr.createNestedObject();
-            item["KodeSensor"] = kv.key().c_str();
-            item["Value"] = kv.value().as<String>();
-          }
-
-          String realtimeJson;
-          serializeJson(arr, realtimeJson);
-          xSemaphoreGive(jsonMutex);
-          client.print(realtimeJson);
-        }
-        else
-        {
-          client.print("[]"); 
-        }
-      }
-
-      // --- 2. GET CURRENT VALUE (ANALOG/DIGITAL REALTIME) ---
-      else if (basePath == "/getCurrentValue")
-      {
-        if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(100)))
-        {
-          DynamicJsonDocument docTemp(2048);
-          // Analog Input
-          for (int i = 1; i <= jumlahInputAnalog; i++)
-          {
-            docTemp["rawValue" + String(i)] = analogInput[i].adcValue;
-            docTemp["scaledValue" + String(i)] = analogInput[i].mapValue;
-          }
-          // Digital Input
-          for (int i = 1; i <= jumlahInputDigital; i++)
-          {
-            docTemp["diValue" + String(i)] = digitalInput[i].value;
-          }
-          String dataLoad;
-          serializeJson(docTemp, dataLoad);
-          xSemaphoreGive(jsonMutex);
-          client.print(dataLoad);
-        }
-        else
-        {
-          client.print("{}");
-        }
-      }
-
-      // --- 3. HOME LOAD (DASHBOARD DATA) ---
-      else if (basePath == "/homeLoad")
-      {
-        if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-        {
-          doc = DynamicJsonDocument(4096);
-          doc["networkMode"] = networkSettings.networkMode;
-          doc["ssid"] = networkSettings.ssid;
-          doc["ipAddress"] = Ethernet.localIP().toString();
-          doc["connStatus"] = networkSettings.connStatus;
-          doc["jobNumber"] = jobNum;
-          doc["datetime"] = getTimeDateNow();
-
-          // Struktur Data Analog
-          JsonObject AI = doc.createNestedObject("AI");
-          JsonArray AIRawValue = AI.createNestedArray("rawValue");
-          JsonArray AIScaledValue = AI.createNestedArray("scaledValue");
-          JsonArray EnAI = AI.createNestedArray("enAI");
-
-          for (int i = 1; i <= jumlahInputAnalog; i++)
-          {
-            AIRawValue.add(analogInput[i].adcValue);
-            AIScaledValue.add(analogInput[i].mapValue);
-            EnAI.add(analogInput[i].name != "" ? 1 : 0);
-          }
-
-          // Struktur Data Digital
-          JsonObject DI = doc.createNestedObject("DI");
-          JsonArray DIValue = DI.createNestedArray("value");
-          JsonArray DITaskMode = DI.createNestedArray("taskMode");
-          for (int i = 1; i <= jumlahInputDigital; i++)
-          {
-            DIValue.add(digitalInput[i].value);
-            DITaskMode.add(digitalInput[i].taskMode);
-          }
-
-          String dataLoad;
-          serializeJson(doc, dataLoad);
-          xSemaphoreGive(jsonMutex);
-          client.print(dataLoad);
-        }
-      }
-
-      // --- 4. ANALOG LOAD (CONFIG) ---
-      else if (basePath == "/analogLoad")
-      {
-        int id = 1;
-        if (queryParams.indexOf("input=") >= 0)
-          id = queryParams.substring(queryParams.indexOf("input=") + 6).toInt();
-        if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-        {
-          doc = DynamicJsonDocument(2048);
-          doc["name"] = analogInput[id].name;
-          doc["inputType"] = analogInput[id].inputType;
-          doc["filter"] = analogInput[id].filter;
-          doc["filterPeriod"] = String(analogInput[id].filterPeriod, 2);
-          doc["scaling"] = analogInput[id].scaling;
-          doc["lowLimit"] = analogInput[id].lowLimit;
-          doc["highLimit"] = analogInput[id].highLimit;
-          doc["mValue"] = analogInput[id].mValue;
-          doc["cValue"] = analogInput[id].cValue;
-          doc["calibration"] = analogInput[id].calibration;
-          String res;
-          serializeJson(doc, res);
-          xSemaphoreGive(jsonMutex);
-          client.print(res);
-        }
-      }
-
-      // --- 5. DIGITAL LOAD (CONFIG) ---
-      else if (basePath == "/digitalLoad")
-      {
-        if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-        {
-          doc = DynamicJsonDocument(2048);
-          if (queryParams.indexOf("input=") >= 0)
-          {
-            int id = queryParams.substring(queryParams.indexOf("input=") + 6).toInt();
-            doc["nameDI"] = digitalInput[id].name;
-            doc["invDI"] = digitalInput[id].inv;
-            doc["taskMode"] = digitalInput[id].taskMode;
-            doc["inputState"] = digitalInput[id].inputState ? "High" : "Low";
-            doc["intervalTime"] = (float)digitalInput[id].intervalTime / 1000;
-            doc["conversionFactor"] = digitalInput[id].conversionFactor;
-          }
-          if (queryParams.indexOf("reset=") >= 0)
-          {
-            int id = queryParams.substring(queryParams.indexOf("reset=") + 6).toInt();
-            digitalInput[id].value = 0;
-          }
-          String res;
-          serializeJson(doc, res);
-          xSemaphoreGive(jsonMutex);
-          client.print(res);
-        }
-      }
-
-      // --- 6. NETWORK LOAD ---
-      else if (basePath == "/networkLoad")
-      {
-        if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
-        {
-          doc = DynamicJsonDocument(4096);
-          doc["networkMode"] = networkSettings.networkMode;
-          doc["ssid"] = networkSettings.ssid;
-          doc["ipAddress"] = networkSettings.ipAddress;
-          doc["sendInterval"] = String(networkSettings.sendInterval, 2);
-          doc["dhcpMode"] = networkSettings.dhcpMode;
-          doc["subnet"] = networkSettings.subnetMask;
-          doc["ipGateway"] = networkSettings.ipGateway;
-          doc["ipDNS"] = networkSettings.ipDNS;
-          doc["protocolMode"] = networkSettings.protocolMode;
-          doc["endpoint"] = networkSettings.endpoint;
-          doc["port"] = networkSettings.port;
-          doc["pubTopic"] = networkSettings.pubTopic;
-          doc["subTopic"] = networkSettings.subTopic;
-          doc["mqttUsername"] = networkSettings.mqttUsername;
-          doc["mqttPass"] = networkSettings.mqttPassword;
-          doc["erpUrl"] = networkSettings.erpUrl;
-          doc["erpUsername"] = networkSettings.erpUsername;
-          doc["erpPassword"] = networkSettings.erpPassword;
-          doc["modbusMode"] = modbusParam.mode;
-          doc["modbusPort"] = modbusParam.port;
-          doc["modbusSlaveID"] = modbusParam.slaveID;
-          String res;
-          serializeJson(doc, res);
-          xSemaphoreGive(jsonMutex);
-          client.print(res);
-        }
-      }
-
-      // --- 7. MODBUS LOAD ---
-      else if (basePath == "/modbusLoad")
-      {
-        client.print(stringParam.length() > 0 ? stringParam : "{}");
-      }
-
-      // --- 8. SETTINGS LOAD ---
-      else if (basePath == "/settingsLoad")
-      {
-        String jsonAuth = "{";
-        jsonAuth += "\"username\":\"" + networkSettings.loginUsername + "\",";
-        jsonAuth += "\"password\":\"" + networkSettings.loginPassword + "\",";
-        jsonAuth += "\"sdInterval\":" + String(networkSettings.sdSaveInterval);
-        jsonAuth += "}";
-        client.print(jsonAuth);
-      }
-
-      // --- 9. GET TIME ---
-      else if (basePath == "/getTime")
-      {
-        client.printf("{\"datetime\":\"%s\"}", getTimeDateNow().c_str());
-      }
-
-      // --- 10. STATUS ---
-      else if (basePath == "/wifiStatus" || basePath == "/ethernetStatus")
-      {
-        DynamicJsonDocument stat(512);
-        stat["mode"] = networkSettings.networkMode;
-        stat["ip"] = Ethernet.localIP().toString();
-        stat["connected"] = (Ethernet.linkStatus() == LinkON);
-        stat["connectionStatus"] = networkSettings.connStatus;
-        String res;
-        serializeJson(stat, res);
-        client.print(res);
-      }
-    }
-    // ========================================================================
-    // C. STATIC FILE HANDLER (HTML/CSS/JS)
-    // ========================================================================
-    else
-    {
-      String filePath = basePath;
-      if (basePath == "/" || basePath == "/home")
-        filePath = "/home.html";
-      else if (basePath == "/network")
-        filePath = "/network.html";
-      else if (basePath == "/analog_input")
-        filePath = "/analog_input.html";
-      else if (basePath == "/digital_IO")
-        filePath = "/digital_IO.html";
-      else if (basePath == "/system_settings")
-        filePath = "/system_settings.html";
-      else if (basePath == "/modbus_setup")
-        filePath = "/modbus_setup.html";
-      else if (basePath == "/updateOTA")
-        filePath = "/UpdateOTA.html";
-      else if (basePath == "/debug")
-        filePath = "/debug-monitor.html";
-
-      if (SPIFFS.exists(filePath))
-      {
-        File file = SPIFFS.open(filePath, "r");
-        String contentType = getContentType(filePath);
-
-        client.println("HTTP/1.1 200 OK");
-        client.println("Content-Type: " + contentType);
-        if (filePath.endsWith(".css") || filePath.endsWith(".js") || filePath.endsWith(".png"))
-        {
-          client.println("Cache-Control: public, max-age=31536000");
-        }
-        client.println("Connection: close");
-        client.println();
-
-        uint8_t buffer[512];
-        while (file.available())
-        {
-          int bytesRead = file.read(buffer, sizeof(buffer));
-          client.write(buffer, bytesRead);
-        }
-        file.close();
-      }
-      else
-      {
-        client.println("HTTP/1.1 404 Not Found");
-        client.println("Connection: close");
-        client.println();
-      }
-    }
+    gpio_intr_disable(pin);
+    diIsrMode[index] = 0;
+    digitalInput[index].flagInt = 0;
   }
+}
 
-  client.flush();
-  vTaskDelay(pdMS_TO_TICKS(10));
-  client.stop();
+// Dipanggil Task_DataAcquisition tiap snapshot baru (pemakai flag ISR)
+void configureSendTriggerInterrupt(const RuntimeConfig *cfg)
+{
+  for (byte i = 1; i <= jumlahInputDigital; i++)
+    attachDigitalInputInterrupt(cfg, i);
 }
+
 // ============================================================================
 // CORE 0 TASK: Network Management (FIXED VERSION - ANTI REBOOT)
 // ============================================================================
@@ -2245,12 +223,29 @@ void Task_NetworkManagement(void *parameter)
   unsigned long lastMQTTCheck = 0;
   unsigned long lastStatusPrint = 0;
   unsigned long lastWatchdogFeed = 0;
+  unsigned long lastEthStats = 0;
+  bool lastEthLink = ETH.linkUp();
+  bool lastEthIP = ETH.hasIP();
+  bool dhcpTimeoutReported = false;
+  uint32_t cfgGeneration = 0;
   esp_task_wdt_add(NULL);
   vTaskDelay(pdMS_TO_TICKS(1000));
 
   while (true)
   {
     esp_task_wdt_reset();
+
+    // Titik aman RCU + terbitkan snapshot pending / bebaskan snapshot lama
+    runtimeConfig.maintain();
+    cpuLoad.update();
+    const RuntimeConfig *cfg = runtimeConfig.read(RCU_READER_NETWORK);
+    if (cfg->generation != cfgGeneration)
+    {
+      // Uplink ikut config baru tanpa restart (slave TCP diurus task-nya sendiri)
+      if (cfg->protocol == UPLINK_MQTT)
+        applyMqttServer(cfg->endpoint, cfg->port);
+      cfgGeneration = cfg->generation;
+    }
     // ============================================================
     // YIELD CPU SETIAP 5 DETIK (BIARKAN IDLE TASK RESET WATCHDOG)
     // ============================================================
@@ -2261,28 +256,50 @@ void Task_NetworkManagement(void *parameter)
     }
 
     // ============================================================
-    // 1. HANDLE ETHERNET SERVER
+    // 1. ETHERNET LINK MONITOR
+    // Request HTTP via LAN sudah dilayani AsyncWebServer lewat lwIP,
+    // task ini hanya memantau perubahan status kabel.
     // ============================================================
-    if (networkSettings.networkMode == "Ethernet")
+    if (cfg->ethernet)
     {
-      if (xSemaphoreTake(spiMutex, pdMS_TO_TICKS(20)) == pdTRUE)
+      bool linkNow = ETH.linkUp();
+      if (linkNow != lastEthLink)
       {
-        EthernetClient client = ethServer.available();
-        if (client)
+        if (linkNow)
         {
-          client.setTimeout(100);
+          Serial.printf("[ETH] Link UP, IP: %s\n", ETH.localIP().toString().c_str());
+        }
+        else
+        {
+          errorBlinker.trigger(5, 200);
+          errorMessages.addTimedMessage("Ethernet cable disconnected");
+        }
+        lastEthLink = linkNow;
+      }
 
-          unsigned long startProcess = millis();
-          handleEthernetClient();
+      // IP dari DHCP datang di background (setup tidak lagi menunggu)
+      bool ipNow = ETH.hasIP();
+      if (ipNow != lastEthIP)
+      {
+        if (ipNow)
+          Serial.printf("[ETH] Got IP %s (%lu ms after reset)\n", ETH.localIP().toString().c_str(), millis());
+        lastEthIP = ipNow;
+        dhcpTimeoutReported = false;
+      }
+      else if (!ipNow && ethReady && !dhcpTimeoutReported && cfg->dhcp &&
+               millis() - ethConfigMillis > 10000)
+      {
+        ESP_LOGE("Ethernet", "  ✗ Failed to configure Ethernet using DHCP");
+        errorMessages.addTimedMessage("Failed to start Ethernet (DHCP)");
+        dhcpTimeoutReported = true;
+      }
 
-          if (millis() - startProcess > 500)
-          {
-            Serial.printf("⚠️ handleEthernetClient() took %lu ms\n",
-                          millis() - startProcess);
-          }
-        }
-        xSemaphoreGive(spiMutex);
+      if (millis() - lastEthStats >= 5000)
+      {
+        updateEthRxStats();
+        lastEthStats = millis();
       }
+      updateEthSpiClock();
     }
 
     // ============================================================
@@ -2302,19 +319,20 @@ void Task_NetworkManagement(void *parameter)
     // ============================================================
     if (millis() - lastNetCheck >= 10000)
     {
-      checkWiFi(10000);
+      checkWiFi(!cfg->ethernet, 10000);
       lastNetCheck = millis();
     }
 
     // ============================================================
     // 4. MQTT HANDLING
     // ============================================================
-    if (networkSettings.protocolMode == "MQTT")
+    if (cfg->protocol == UPLINK_MQTT)
     {
       if (millis() - lastMQTTCheck >= 200)
       {
         if (mqtt.connected())
         {
+          mqttConfig = cfg; // mqttCallback: nama DO
           mqtt.loop();
         }
         lastMQTTCheck = millis();
@@ -2322,18 +340,10 @@ void Task_NetworkManagement(void *parameter)
     }
 
     // ============================================================
-    // 5. MODBUS TCP
+    // 5. LIVE STREAM (SSE /live ke dashboard)
     // ============================================================
-    bool useTCP = (networkSettings.protocolMode2.indexOf("TCP") >= 0);
-
-    if (useTCP)
-    {
-      if (xSemaphoreTake(modbusMutex, pdMS_TO_TICKS(5)) == pdTRUE)
-      {
-        mbIP.task();
-        xSemaphoreGive(modbusMutex);
-      }
-    }
+    liveStream.loop(cfg->liveIntervalMs);
+    commandSocket.loop(); // tune AI dari /ws -> snapshot baru
 
     // ============================================================
     // 6. UTILITY & STATUS
@@ -2342,23 +352,15 @@ void Task_NetworkManagement(void *parameter)
 
     if (millis() - lastStatusPrint >= 120000)
     {
-      String currentIP = (networkSettings.networkMode == "Ethernet")
-                             ? Ethernet.localIP().toString()
+      String currentIP = cfg->ethernet
+                             ? ETH.localIP().toString()
                              : WiFi.localIP().toString();
 
       String linkStatus = "Disconnected";
 
-      if (networkSettings.networkMode == "Ethernet")
+      if (cfg->ethernet)
       {
-        if (xSemaphoreTake(spiMutex, pdMS_TO_TICKS(20)))
-        {
-          linkStatus = (Ethernet.linkStatus() == LinkON) ? "Link ON" : "No Cable";
-          xSemaphoreGive(spiMutex);
-        }
-        else
-        {
-          linkStatus = "Unknown";
-        }
+        linkStatus = ETH.linkUp() ? "Link ON" : "No Cable";
       }
       else
       {
@@ -2366,11 +368,19 @@ void Task_NetworkManagement(void *parameter)
       }
 
       Serial.printf("\n[NET] Mode:%s IP:%s Status:%s Heap:%d\n",
-                    networkSettings.networkMode.c_str(),
+                    cfg->ethernet ? "Ethernet" : "WiFi",
                     currentIP.c_str(),
                     linkStatus.c_str(),
                     ESP.getFreeHeap());
 
+      spiBus.printStats();
+
+      if (cfg->ethernet)
+      {
+        Serial.printf("[ETH] RX %.1f frame/s, CPU %.1f%%, drop:%u, pool free:%u\n",
+                      ethRxFramesPerSec, ethRxCpuPercent, ethRxDropped, ethRxPoolFree);
+      }
+
       lastStatusPrint = millis();
     }
     vTaskDelay(pdMS_TO_TICKS(20));
@@ -2388,76 +398,61 @@ void Task_DataAcquisition(void *parameter)
   unsigned long lastRunTimeCheck = 0;
   unsigned long lastDebugPrint = 0;
   int16_t valueADC;
+  uint32_t cfgGeneration = 0;
   while (true)
   {
-    // --- Definisi variabel Modbus (digunakan di Analog & Digital) ---
-    bool useTCP = (networkSettings.protocolMode2.indexOf("TCP") >= 0);
-    bool useRTU = (networkSettings.protocolMode2.indexOf("RTU") >= 0);
+    // Titik aman RCU: snapshot config dipakai utuh sampai loop berikutnya
+    const RuntimeConfig *cfg = runtimeConfig.read(RCU_READER_ACQUISITION);
+    if (cfg->generation != cfgGeneration)
+    {
+      configureSendTriggerInterrupt(cfg);
+      if (cfgGeneration)
+        Serial.printf("[ACQ] Config gen %u applied\n", cfg->generation);
+      cfgGeneration = cfg->generation;
+    }
 
     // ========================================================================
     // A. BACA ANALOG (Setiap 100ms)
     // ========================================================================
     if (millis() - lastReadAnalog >= 100)
     {
-      if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(100)))
+      if (metricTake(i2cMutex, pdMS_TO_TICKS(100), mMutexWaitI2c, TR_I2C_WAIT, TR_I2C_HOLD))
       {
+        int64_t adcTimeUs = 0;
         // --- [ MULAI KODE BARU DARI ANDA ] ---
         for (byte i = 1; i < jumlahInputAnalog + 1; i++)
         {
+          int64_t t0 = esp_timer_get_time();
+          traceBegin(TR_ADC_READ);
           valueADC = ads.readADC(i - 1);
+          traceEnd(TR_ADC_READ);
+          analogInput[i].sampleMs = millis();
+          adcTimeUs += esp_timer_get_time() - t0;
+
+          const AnalogChannelConfig &ai = cfg->ai[i];
 
           // Filter Logic
-          if (analogInput[i].filter)
-            analogInput[i].adcValue = filterSensor(valueADC, analogInput[i].adcValue, analogInput[i].filterPeriod);
+          if (ai.filter)
+            analogInput[i].adcValue = lowPassStep(valueADC, analogInput[i].adcValue, ai.filterAlpha);
           else
             analogInput[i].adcValue = valueADC;
 
-          // Mapping Logic (Sesuai Request)
-          if (analogInput[i].inputType == "4-20 mA")
-          {
-            if (analogInput[i].scaling)
-              analogInput[i].mapValue = mapFloat(analogInput[i].adcValue, 5333.33, 26666.67, analogInput[i].lowLimit, analogInput[i].highLimit);
-            else
-              analogInput[i].mapValue = mapFloat(analogInput[i].adcValue, 5333.33, 26666.67, 4.0, 20.0); // 4mA=1V (5333), 20mA=5V (26666)
-          }
-          else if (analogInput[i].inputType == "0-20 mA")
-          {
-            if (analogInput[i].scaling)
-              analogInput[i].mapValue = mapFloat(analogInput[i].adcValue, 0.0, 26666.67, analogInput[i].lowLimit, analogInput[i].highLimit);
-            else
-              analogInput[i].mapValue = mapFloat(analogInput[i].adcValue, 0.0, 26666.67, 0.0, 20.0);
-          }
-          else
-          {
-            if (analogInput[i].scaling)
-              analogInput[i].mapValue = mapFloat(analogInput[i].adcValue, 0.0, 26666.67, analogInput[i].lowLimit, analogInput[i].highLimit);
-            else
-              analogInput[i].mapValue = mapFloat(analogInput[i].adcValue, 0.0, 26666.67, 0.0, 10.0);
-          }
-
-          // Kalibrasi Linear (mX + c) jika aktif
-          if (analogInput[i].calibration && analogInput[i].scaling)
-          {
-            float slope = (analogInput[i].mValue != 0) ? analogInput[i].mValue : 1.0;
-            analogInput[i].mapValue = (analogInput[i].mapValue * slope) + analogInput[i].cValue;
-          }
+          // Mapping per tipe input + skala + kalibrasi (SignalMath.hpp)
+          analogInput[i].mapValue = analogSample(ai, analogInput[i].adcValue);
 
           // Masukkan ke struct data untuk dikirim ke Task Logger
           sensorData.analogValues[i] = analogInput[i].mapValue;
+        }
+        metricGive(i2cMutex, TR_I2C_HOLD);
+        mAdcRead.observeUs((uint32_t)adcTimeUs);
+        mAdcReads.inc(jumlahInputAnalog);
 
-          // Update Register Modbus Slave (Agar bisa dibaca PLC/SCADA lain)
-          if (useTCP)
-          {
-            mbIP.Ireg(i + 9, (int)analogInput[i].adcValue);         // Register Raw
-            mbIP.Ireg(i - 1, (int)(analogInput[i].mapValue * 100)); // Register Value
-          }
-          if (useRTU)
-          {
-            mbRTU.Ireg(i + 9, (int)analogInput[i].adcValue);
-            mbRTU.Ireg(i - 1, (int)(analogInput[i].mapValue * 100));
-          }
+        if (bootFirstSampleMs == 0)
+        {
+          bootFirstSampleMs = millis();
+          Serial.printf("[BOOT] First sample %u ms after reset (config: %s, load %u us)\n",
+                        bootFirstSampleMs, configImage.source(), configImage.loadMicros());
         }
-        xSemaphoreGive(i2cMutex);
       }
       lastReadAnalog = millis();
     }
@@ -2467,26 +462,20 @@ void Task_DataAcquisition(void *parameter)
     {
       for (byte i = 1; i < jumlahInputDigital + 1; i++)
       {
-        int pinTrig = 0;
+        const DigitalChannelConfig &di = cfg->di[i];
 
         // 1. Data Logger Trigger Logic
-        if (networkSettings.sendTrig != "Timer/interval") // Koreksi typo: biasanya "Timer/interval"
-        {
-          // Parsing trig (misal "DI1" -> ambil angka 1)
-          if (networkSettings.sendTrig.length() >= 3)
-          {
-            pinTrig = (networkSettings.sendTrig.substring(2, 3)).toInt();
-          }
-        }
-
         // Jika Digital Input ini adalah Trigger, dan baru saja ON (Flag Interrupt)
-        if (digitalInput[i].flagInt and i == pinTrig)
+        if (digitalInput[i].flagInt and i == cfg->sendTrigPin)
         {
           flagSend = true; // Trigger pengiriman data
+          // Mode tanpa edge tidak mengonsumsi flag di bawah
+          if (di.mode != DI_MODE_CYCLE_TIME && di.mode != DI_MODE_COUNTING)
+            digitalInput[i].flagInt = 0;
         }
 
         // 2. Processing Berdasarkan Task Mode
-        if (digitalInput[i].taskMode == "Cycle Time")
+        if (di.mode == DI_MODE_CYCLE_TIME)
         {
           if (digitalInput[i].flagInt)
           {
@@ -2495,7 +484,7 @@ void Task_DataAcquisition(void *parameter)
             digitalInput[i].flagInt = 0;
           }
         }
-        else if (digitalInput[i].taskMode == "Counting")
+        else if (di.mode == DI_MODE_COUNTING)
         {
           if (digitalInput[i].flagInt)
           {
@@ -2503,25 +492,28 @@ void Task_DataAcquisition(void *parameter)
             digitalInput[i].flagInt = 0;
           }
         }
-        else if (digitalInput[i].taskMode == "Run Time")
+        else if (di.mode == DI_MODE_RUN_TIME)
         {
           // Menggunakan variable global timeElapsed
           if (millis() - timeElapsed >= 60000)
           {
-            if (digitalRead(digitalInput[i].pin) == digitalInput[i].inputState)
+            if (digitalRead(digitalInput[i].pin) == di.inputState)
             {
               digitalInput[i].value++;
-              updateJson("/runtimeData.json", String(i).c_str(), digitalInput[i].value);
+              char key[4];
+              snprintf(key, sizeof(key), "%d", i);
+              updateJson("/runtimeData.json", key, digitalInput[i].value);
             }
             timeElapsed = millis();
           }
         }
-        else if (digitalInput[i].taskMode == "Pulse Mode")
+        else if (di.mode == DI_MODE_PULSE)
         {
-          if (millis() - digitalInput[i].lastMillisPulseMode > digitalInput[i].intervalTime)
+          if (millis() - digitalInput[i].lastMillisPulseMode > di.intervalTime)
           {
-            digitalInput[i].value = (float)digitalInput[i].sumValue * digitalInput[i].conversionFactor;
-            digitalInput[i].sumValue = 0;
+            // Ambil & nolkan counter tanpa kehilangan pulsa yang masuk di antaranya
+            int pulses = __atomic_exchange_n(&digitalInput[i].sumValue, 0, __ATOMIC_SEQ_CST);
+            digitalInput[i].value = (float)pulses * di.conversionFactor;
             digitalInput[i].lastMillisPulseMode = millis();
           }
         }
@@ -2529,39 +521,48 @@ void Task_DataAcquisition(void *parameter)
         {
           // Normal Mode (High/Low) + Inversion Check
           int raw = digitalRead(digitalInput[i].pin);
-          digitalInput[i].value = digitalInput[i].inv ? !raw : raw;
+          digitalInput[i].value = di.inv ? !raw : raw;
         }
 
         // 3. Simpan ke SensorData & JSON Live Update
         sensorData.digitalValues[i] = digitalInput[i].value;
 
         // Update JSON Send (untuk Web Live View)
-        if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(10)))
+        if (metricTake(jsonMutex, pdMS_TO_TICKS(10), mMutexWaitJson, TR_JSON_WAIT, TR_JSON_HOLD))
         {
-          if (digitalInput[i].name != "")
+          if (di.name[0])
           {
-            jsonSend[digitalInput[i].name] = digitalInput[i].value;
-            jsonSend[digitalInput[i].name + "_mode"] = digitalInput[i].taskMode;
+            char modeKey[40];
+            snprintf(modeKey, sizeof(modeKey), "%s_mode", di.name);
+            jsonSend[jsonKey(di.name)] = digitalInput[i].value;
+            jsonSend[jsonKey(modeKey)] = diModeName(di.mode); // literal statis, aman disimpan sebagai pointer
           }
-          xSemaphoreGive(jsonMutex);
-        }
-
-        // 4. Modbus Write (TCP & RTU) - Sesuai Request Anda
-        if (useTCP)
-        {
-          mbIP.Ireg(i + 19, digitalInput[i].value); // Register 20-23
-        }
-        if (useRTU)
-        {
-          mbRTU.Ireg(i + 19, digitalInput[i].value); // Register 20-23
+          metricGive(jsonMutex, TR_JSON_HOLD);
         }
       }
       lastReadDigital = millis();
     }
 
+    // ------------------------------------------------------------------------
+    // C. KANAL VIRTUAL, TOTALIZER & ALARM: setelah transform AI/DI; alarm
+    //    setelah kanal virtual supaya bisa memakai hasilnya. Interlock DO
+    //    tanpa menunggu uplink
+    // ------------------------------------------------------------------------
+    virtualChannels.evaluate(cfg);
+    totalizers.evaluate(cfg, millis());
+    alarmEngine.evaluate(cfg, millis());
+
+    // Register Modbus slave (agar bisa dibaca PLC/SCADA lain): semua entri
+    // slave map di-encode sekaligus, sekali per siklus
+    if (cfg->slaveTCP || cfg->slaveRTU)
+      slaveRegisters.update(cfg);
+
     // Kirim Data ke Queue
     sensorData.timestamp = millis();
-    xQueueSend(queueSensorData, &sensorData, 0);
+    bool queued = xQueueSend(queueSensorData, &sensorData, 0) == pdTRUE;
+    scanStats.samplePushed(queued);
+    if (!queued)
+      mSensorQueueDrops.inc();
 
     // ------------------------------------------------------------------------
     // D. DEBUG MONITOR
@@ -2572,7 +573,7 @@ void Task_DataAcquisition(void *parameter)
       for (int i = 1; i <= jumlahInputAnalog; i++)
       {
         float displayMA;
-        if (analogInput[i].inputType.indexOf("mA") >= 0)
+        if (cfg->ai[i].type != AI_TYPE_0_10V)
         {
           // Jika mA, hitung pakai rumus Shunt Resistor (250 Ohm -> 20mA = 5V)
           // ADC 26666 = 5V = 20mA
@@ -2592,11 +593,11 @@ void Task_DataAcquisition(void *parameter)
         Serial.print(" | Raw: ");
         Serial.print(analogInput[i].adcValue);
         Serial.print(" | Type: ");
-        Serial.println(analogInput[i].inputType);
+        Serial.println(aiTypeName(cfg->ai[i].type));
         // Serial.print(" | mA: ");
         // // Serial.println(analogInput[i].adcValue / 65535.0 * 20.0, 2);
         // Serial.println(displayMA, 2);
-        if (analogInput[i].inputType.indexOf("mA") >= 0)
+        if (cfg->ai[i].type != AI_TYPE_0_10V)
         {
           Serial.print(" | mA: ");
         }
@@ -2613,10 +614,10 @@ void Task_DataAcquisition(void *parameter)
 
         Serial.printf("DI-%d [%s]: %.2f | RAW: %d | Mode: %s\n",
                       i,
-                      digitalInput[i].name.c_str(),    // Nama Sensor
+                      cfg->di[i].name,                 // Nama Sensor
                       digitalInput[i].value,           // Nilai Hasil Olahan (Counting/Timer/dll)
                       rawState,                        // Nilai Fisik Asli (0 atau 1)
-                      digitalInput[i].taskMode.c_str() // Konfigurasi Task
+                      diModeName(cfg->di[i].mode)      // Konfigurasi Task
         );
       }
       Serial.println("============================");
@@ -2696,96 +697,257 @@ void Task_DataAcquisition(void *parameter)
 // ============================================================================
 // CORE 1 TASK: Modbus Client (Master) - DEBUG VERSION
 // ============================================================================
+// Kirim satu batch ke logger; queue penuh = batch dibuang (nilai lama tetap
+// tampil, scan berikutnya mengisi lagi), task Modbus tidak ikut tertahan
+static void sendModbusBatch(const ChannelBatchPacket &batch)
+{
+  if (xQueueSend(queueModbusData, &batch, 0) != pdTRUE)
+    mModbusQueueDrops.inc();
+}
+
+struct ModbusScanContext
+{
+  const RuntimeConfig *cfg;
+  ChannelBatchPacket *batch;
+};
+
+// Hasil satu blok (RS-485 atau TCP) -> nilai tiap tag di blok itu.
+// values NULL / status gagal: semua tag blok bernilai 0 seperti sebelumnya
+static void onModbusBlock(uint16_t block, uint8_t status, const uint16_t *values, uint32_t latencyUs, void *ctx)
+{
+  ModbusScanContext &scan = *(ModbusScanContext *)ctx;
+  const RuntimeConfig *cfg = scan.cfg;
+  const ModbusBlock &b = cfg->blocks[block];
+  for (uint8_t k = 0; k < b.tagCount; k++)
+  {
+    uint8_t i = cfg->blockTags[b.firstTag + k];
+    const ModbusTagConfig &tag = cfg->tags[i];
+    unsigned int rawValue = status == MB_FRAME_OK ? values[tag.reg - b.start] : 0;
+    scanStats.tagResult(cfg->generation, i, status, latencyUs / 1000);
+    float finalValue = rawValue * tag.multiplier;
+
+    Serial.printf("MB-%d [%-15s]: %-8.2f | RAW: %-5u | ID: %d | Reg: %d%s\n",
+                  i + 1,       // Nomor Urut
+                  tag.name,    // Nama Parameter
+                  finalValue,  // Nilai setelah dikali scaling
+                  rawValue,    // Nilai Asli dari Modbus
+                  tag.slaveId, // Slave ID / unit ID
+                  tag.reg,     // Register Address
+                  tag.target ? " | TCP" : "");
+
+    // Ke logger lewat queue (logger yang menulis jsonSend untuk Web/MQTT)
+    scan.batch->add(channelId(CH_MODBUS, i), finalValue, status);
+    slaveRegisters.setTagValue(i, finalValue, status == MB_FRAME_OK);
+    if (scan.batch->full())
+    {
+      sendModbusBatch(*scan.batch);
+      scan.batch->reset(cfg->generation);
+    }
+  }
+}
+
 void Task_ModbusClient(void *parameter)
 {
   ESP_LOGI("Core1", "Modbus Client Task started");
   unsigned long lastModbusRead = 0;
   unsigned long lastWatchdogFeed = 0;
+  const RuntimeConfig *cfg = runtimeConfig.read(RCU_READER_MODBUS);
+  uint32_t cfgGeneration = cfg->generation;
+  // Format port yang sedang aktif (dibuka di setup dengan nilai yang sama)
+  RuntimeConfig::SerialParams serialActive = cfg->serialParams();
+  ChannelBatchPacket batch;
   while (true)
   {
-    // Cek Timer sesuai Scan Rate (Misal tiap 1 detik)
-    if (millis() - lastWatchdogFeed >= 5000)
-    {
-      esp_task_wdt_reset(); // Reset watchdog manual
-      lastWatchdogFeed = millis();
-    }
-    if (millis() - lastModbusRead >= (modbusParam.scanRate * 1000))
+    // Titik aman RCU
+    cfg = runtimeConfig.read(RCU_READER_MODBUS);
+    if (cfg->generation != cfgGeneration)
     {
-      int totalParamsToRead = 0;
-
-      // 1. Ambil Jumlah Sensor
-      if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
+      // Port RS-485 dibuka ulang di task ini (satu-satunya pemakai master)
+      // hanya jika format serial berubah; edit tag cukup ganti tabel
+      RuntimeConfig::SerialParams wanted = cfg->serialParams();
+      if (memcmp(&wanted, &serialActive, sizeof(wanted)) != 0 &&
+          xSemaphoreTake(modbusMutex, pdMS_TO_TICKS(1000)))
       {
-        deserializeJson(jsonParam, stringParam);
-        JsonArray nameData = jsonParam["nameData"];
-        totalParamsToRead = nameData.size();
-        xSemaphoreGive(jsonMutex);
+        rs485Master.end();
+        rs485Master.begin(wanted.baudrate, wanted.dataBit, wanted.stopBit, wanted.parity);
+        xSemaphoreGive(modbusMutex);
+        serialActive = wanted;
+        Serial.printf("[MB] RS-485 reopened: %d %u%c%u\n", wanted.baudrate, wanted.dataBit, wanted.parity[0], wanted.stopBit);
       }
+      slaveRegisters.resetTagValues(); // index tag lama tidak berlaku lagi
+      cfgGeneration = cfg->generation;
+    }
 
+    // Cek Timer sesuai Scan Rate (Misal tiap 1 detik)
+    if (millis() - lastWatchdogFeed >= 5000)
+    {
+      esp_task_wdt_reset(); // Reset watchdog manual
+      lastWatchdogFeed = millis();
+    }
+    if (millis() - lastModbusRead >= cfg->scanRateMs)
+    {
       // PRINT HEADER (Agar mirip Digital Input Status)
-      if (totalParamsToRead > 0)
+      if (cfg->tagCount > 0)
       {
         Serial.println("\n=== MODBUS DATA MONITOR ===");
       }
 
-      // 2. LOOPING SEMUA PARAMETER
-      for (int i = 0; i < totalParamsToRead; i++)
+      // LOOPING SEMUA BLOK (rencana block read dari snapshot, tanpa parse JSON).
+      // Blok TCP dikirim di sela blok RS-485, jadi kedua transport jalan paralel
+      unsigned long scanStart = millis();
+      rtuSlave.reset(); // bus bersama: master mengambil alih bus
+      batch.reset(cfgGeneration);
+      ModbusScanContext scan = {cfg, &batch};
+      modbusTcpClient.startScan(cfg->blocks, cfg->blockCount, cfg->tcpTargets, cfg->tcpTargetCount);
+
+      // Tabel berubah di tengah scan -> hentikan, scan berikutnya pakai tabel
+      // baru. Hanya intip generation: read() di sini menandai reader quiescent
+      // sementara scan.cfg & modbusTcpClient masih memegang snapshot lama.
+      // Snapshot baru diambil di titik aman awal loop.
+      auto tableChanged = [&]() -> bool
+      { return runtimeConfig.generation() != cfgGeneration; };
+
+      bool aborted = false;
+      for (uint16_t b = 0; !aborted && b < scan.cfg->blockCount; b++)
+      {
+        const ModbusBlock &blk = scan.cfg->blocks[b];
+        if (blk.target != 0)
+          continue;
+        modbusTcpClient.poll(onModbusBlock, &scan);
+        serviceCommands(cfg);      // perintah tulis menyela scan, paling lama 1 blok
+        serviceModbusGateway(cfg); // SCADA lewat gateway tidak menunggu scan selesai
+
+        uint16_t values[MODBUS_BLOCK_MAX_REGS];
+        int64_t requestStart = esp_timer_get_time();
+        uint8_t status = readModbusBlock(blk.unit, blk.fc, blk.start, blk.count, values, cfg->unitTimeoutMs(blk.unit));
+        onModbusBlock(b, status, values, (uint32_t)(esp_timer_get_time() - requestStart), &scan);
+
+        // Beri jeda sedikit antar request agar RS485 stabil
+        vTaskDelay(pdMS_TO_TICKS(10));
+        aborted = tableChanged();
+      }
+
+      // Sisa blok TCP (meter lambat / semua tag lewat TCP)
+      while (!aborted && modbusTcpClient.poll(onModbusBlock, &scan))
       {
-        String currentParamName = "";
-        unsigned int addr = 0, fc = 0, reg = 0;
-        float multiplier = 1.0;
-        bool validParam = false;
+        serviceCommands(cfg);
+        serviceModbusGateway(cfg);
+        vTaskDelay(1);
+        aborted = tableChanged();
+      }
+      if (aborted)
+        modbusTcpClient.abort();
+      if (batch.count > 0)
+        sendModbusBatch(batch);
+      if (cfg->tagCount > 0)
+        scanStats.scanDone(millis() - scanStart);
 
-        // A. Ambil Konfigurasi Sensor ke-i
-        if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(50)))
-        {
-          JsonArray nameData = jsonParam["nameData"];
-          currentParamName = nameData[i].as<String>();
+      lastModbusRead = millis();
+    }
 
-          JsonArray paramArray = jsonParam[currentParamName];
-          addr = paramArray[0];       // Slave ID
-          fc = paramArray[1];         // Function Code
-          reg = paramArray[2];        // Register
-          multiplier = paramArray[3]; // Scaling
+    // Waktu idle sampai scan berikutnya: perintah tulis & request gateway
+    // TCP->RTU dulu, lalu slave RTU tanpa port sendiri (bus yang sama,
+    // time-multiplex). Jendela dibatasi 20 ms supaya request baru tidak
+    // menunggu lama.
+    serviceCommands(cfg);
+    serviceModbusGateway(cfg);
+    if (cfg->slaveRTU && !rs485Slave.enabled())
+    {
+      uint32_t elapsed = millis() - lastModbusRead;
+      uint32_t budget = elapsed < cfg->scanRateMs ? cfg->scanRateMs - elapsed : 0;
+      rtuSlave.serviceFor(rs485Master, cfg->slaveId, slaveRegistersPdu, (void *)cfg, constrain(budget, 1, 20));
+    }
+    else
+    {
+      // Dibangunkan server TCP / commandQueue begitu ada request baru
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+    }
+  }
+}
 
-          validParam = true;
-          xSemaphoreGive(jsonMutex);
-        }
+// ============================================================================
+// CORE 0 TASK: Modbus TCP Server (slave)
+// Tidur di select() sampai master mengirim, jadi waktu jawab tidak ikut
+// menunggu DNS / MQTT / web di Task_NetworkManagement. Prioritas di atas
+// task network, di bawah task lwIP.
+// ============================================================================
+void Task_ModbusTcpServer(void *parameter)
+{
+  ESP_LOGI("Core0", "Modbus TCP Server Task started");
+  while (true)
+  {
+    // Titik aman RCU (paling lambat tiap 250 ms saat tidak ada request)
+    const RuntimeConfig *cfg = runtimeConfig.read(RCU_READER_TCP_SLAVE);
+    if (!cfg->slaveTCP)
+    {
+      modbusTcpServer.end();
+      vTaskDelay(pdMS_TO_TICKS(250));
+      continue;
+    }
+    if (!modbusTcpServer.begin())
+    {
+      vTaskDelay(pdMS_TO_TICKS(1000)); // stack TCP belum siap
+      continue;
+    }
+    modbusTcpServer.waitAndService(cfg, 250);
+  }
+}
 
-        // B. Baca Sensor
-        if (validParam)
-        {
-          // Panggil fungsi readModbus (pastikan fungsi ini sudah dibersihkan Serial.print-nya)
-          unsigned int rawValue = readModbusNonBlocking(addr, fc, reg, 100);
-          float finalValue = rawValue * multiplier;
-
-          Serial.printf("MB-%d [%-15s]: %-8.2f | RAW: %-5u | ID: %d | Reg: %d\n",
-                        i + 1,                    // Nomor Urut
-                        currentParamName.c_str(), // Nama Parameter (dari JSON)
-                        finalValue,               // Nilai setelah dikali scaling
-                        rawValue,                 // Nilai Asli dari Modbus
-                        addr,                     // Slave ID
-                        reg                       // Register Address
-          );
-
-          // D. Simpan ke JSON Send (Untuk Web/MQTT)
-          if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(50)))
-          {
-            jsonSend[currentParamName] = String(finalValue, 2);
-            xSemaphoreGive(jsonMutex);
-          }
-        }
-        // Beri jeda sedikit antar sensor agar RS485 stabil
-        vTaskDelay(pdMS_TO_TICKS(10));
-      }
+// ============================================================================
+// CORE 0 TASK: Vibration Capture (ADC1 DMA + FFT, lihat VibrationCapture.hpp)
+// Prioritas terendah: capture + analisis ~0.1..1 s per interval, hanya
+// memakai waktu idle core 0
+// ============================================================================
+void Task_Vibration(void *parameter)
+{
+  ESP_LOGI("Core0", "Vibration Task started");
+  while (true)
+  {
+    // Titik aman RCU (tiap 250 ms di luar capture)
+    const RuntimeConfig *cfg = runtimeConfig.read(RCU_READER_VIBRATION);
+    if (cfg->vibration.channelCount && vibration.due(cfg, millis()))
+      vibration.capture(cfg);
+    vTaskDelay(pdMS_TO_TICKS(250));
+  }
+}
+
+// ============================================================================
+// CORE 1 TASK: Modbus RTU Slave (port RS-485 sendiri, RS485_SLAVE_* di config.hpp)
+// Prioritas di atas akuisisi supaya balasan keluar dalam t3.5 + 1 tick
+// ============================================================================
+void Task_ModbusRtuSlave(void *parameter)
+{
+  ESP_LOGI("Core1", "Modbus RTU Slave Task started");
+  RuntimeConfig::SerialParams serialActive = {};
 
-      if (totalParamsToRead > 0)
+  while (true)
+  {
+    // Titik aman RCU
+    const RuntimeConfig *cfg = runtimeConfig.read(RCU_READER_RTU_SLAVE);
+    if (!cfg->slaveRTU)
+    {
+      if (serialActive.baudrate)
       {
+        rs485Slave.end();
+        serialActive = RuntimeConfig::SerialParams();
       }
+      vTaskDelay(pdMS_TO_TICKS(100));
+      continue;
+    }
 
-      lastModbusRead = millis();
+    // Format serial sama dengan master (satu setelan di halaman Modbus)
+    RuntimeConfig::SerialParams wanted = cfg->serialParams();
+    if (memcmp(&wanted, &serialActive, sizeof(wanted)) != 0)
+    {
+      rs485Slave.end();
+      rs485Slave.begin(wanted.baudrate, wanted.dataBit, wanted.stopBit, wanted.parity);
+      rtuSlave.reset();
+      serialActive = wanted;
+      Serial.printf("[MB] RTU slave port open: id %u, %d baud\n", cfg->slaveId, wanted.baudrate);
     }
-    vTaskDelay(pdMS_TO_TICKS(20));
+
+    rtuSlave.poll(rs485Slave, cfg->slaveId, slaveRegistersPdu, (void *)cfg);
+    vTaskDelay(1);
   }
 }
 // ============================================================================
@@ -2796,97 +958,193 @@ void Task_DataLogger(void *parameter)
   ESP_LOGI("Core1", "Data Logger Task started");
 
   SensorDataPacket sensorData;
-  ModbusDataPacket modbusData;
+  ChannelBatchPacket modbusBatch;
   unsigned long lastSendTime = 0;
   unsigned long lastSDSave = 0;
   unsigned long lastPrint = 0;
   unsigned long lastWatchdogFeed = 0; // ✅ TAMBAH
+  unsigned long lastTotalizerCheck = 0;
 
   // ✅ ALOKASI DI LUAR LOOP (Sekali saja!)
   DynamicJsonDocument docNew(1024);
   DynamicJsonDocument docSD(1024);
+  DynamicJsonDocument docAlarm(1024);
+  AlarmEvent alarmEvent;
 
   while (true)
   {
+    // Titik aman RCU
+    const RuntimeConfig *cfg = runtimeConfig.read(RCU_READER_LOGGER);
+
     if (millis() - lastWatchdogFeed >= 5000)
     {
       esp_task_wdt_reset();
       lastWatchdogFeed = millis();
     }
 
+    // Totalizer: reset terjadwal (jam RTC) & simpan akumulator ke NVS
+    if (millis() - lastTotalizerCheck >= 1000)
+    {
+      totalizers.schedule(dateTimeNow().unixtime());
+      if (totalizers.persistDue(millis()))
+        totalizers.persist();
+      lastTotalizerCheck = millis();
+    }
+
     // 1. UPDATE DATA JSON
-    if (xQueueReceive(queueSensorData, &sensorData, 0) == pdTRUE)
+    // Akuisisi mengirim paket tiap 50 ms, task ini jalan tiap 100 ms: kuras
+    // queue dan pakai paket terbaru supaya queue tidak penuh & paket hilang
+    bool haveSample = false;
+    while (xQueueReceive(queueSensorData, &sensorData, 0) == pdTRUE)
+    {
+      scanStats.sampleConsumed(sensorData.timestamp);
+      haveSample = true;
+    }
+    if (haveSample)
     {
-      if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(1000)))
+      if (metricTake(jsonMutex, pdMS_TO_TICKS(1000), mMutexWaitJson, TR_JSON_WAIT, TR_JSON_HOLD))
       {
         for (byte i = 1; i < jumlahInputAnalog + 1; i++)
         {
-          if (analogInput[i].name != "")
+          if (cfg->ai[i].name[0])
           {
-            jsonSend[analogInput[i].name] = String(sensorData.analogValues[i], 2);
+            jsonSend[jsonKey(cfg->ai[i].name)] = round2(sensorData.analogValues[i]);
           }
         }
         for (byte i = 1; i < jumlahInputDigital + 1; i++)
         {
-          if (digitalInput[i].name != "")
+          if (cfg->di[i].name[0])
           {
-            jsonSend[digitalInput[i].name] = sensorData.digitalValues[i];
+            jsonSend[jsonKey(cfg->di[i].name)] = sensorData.digitalValues[i];
           }
         }
-        xSemaphoreGive(jsonMutex);
+        if (virtualChannels.generation() == cfg->generation)
+        {
+          for (uint8_t n = 0; n < cfg->virtualCount; n++)
+            jsonSend[jsonKey(cfg->virtuals[n].name)] = round2(virtualChannels.value(n));
+        }
+        if (totalizers.generation() == cfg->generation)
+        {
+          for (uint8_t n = 0; n < cfg->totalizerCount; n++)
+            jsonSend[jsonKey(cfg->totalizers[n].name)] = totalizers.total(n);
+        }
+        if (vibration.generation() == cfg->generation)
+        {
+          // Hanya fitur per capture, bukan sampel mentah
+          VibrationFeatures f;
+          char key[48];
+          for (uint8_t n = 0; n < cfg->vibration.channelCount; n++)
+          {
+            const char *name = cfg->vibration.channels[n].name;
+            if (!vibration.features(n, f))
+              continue;
+            snprintf(key, sizeof(key), "%s_rms", name);
+            jsonSend[jsonKey(key)] = round2(f.rms);
+            snprintf(key, sizeof(key), "%s_peak", name);
+            jsonSend[jsonKey(key)] = round2(f.peak);
+            snprintf(key, sizeof(key), "%s_crest", name);
+            jsonSend[jsonKey(key)] = round2(f.crest);
+            snprintf(key, sizeof(key), "%s_freq", name);
+            jsonSend[jsonKey(key)] = round2(f.domFreq);
+            for (uint8_t b = 0; b < f.bandCount; b++)
+            {
+              snprintf(key, sizeof(key), "%s_band%u", name, b + 1);
+              jsonSend[jsonKey(key)] = round2(f.bandRms[b]);
+            }
+          }
+        }
+        metricGive(jsonMutex, TR_JSON_HOLD);
       }
     }
 
-    if (xQueueReceive(queueModbusData, &modbusData, 0) == pdTRUE)
+    // Hasil scan Modbus: beberapa tag per paket, satu take jsonMutex per paket
+    while (xQueueReceive(queueModbusData, &modbusBatch, 0) == pdTRUE)
     {
-      if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(100)))
+      if (modbusBatch.generation != cfg->generation)
+        cfg = runtimeConfig.read(RCU_READER_LOGGER); // producer sudah di config baru
+      if (modbusBatch.generation != cfg->generation)
+        continue; // dari tabel tag lama: index tidak lagi cocok dengan nama
+
+      if (metricTake(jsonMutex, pdMS_TO_TICKS(100), mMutexWaitJson, TR_JSON_WAIT, TR_JSON_HOLD))
       {
-        jsonSend[modbusData.paramName] = String(modbusData.value, 2);
-        xSemaphoreGive(jsonMutex);
+        for (uint8_t i = 0; i < modbusBatch.count; i++)
+        {
+          const ChannelSample &sample = modbusBatch.samples[i];
+          const char *name = channelName(cfg, sample.id);
+          if (name[0])
+            jsonSend[jsonKey(name)] = round2(sample.value);
+        }
+        metricGive(jsonMutex, TR_JSON_HOLD);
+      }
+    }
+
+    // Event alarm: dikirim & disimpan segera, tidak menunggu interval kirim
+    if (xQueuePeek(queueAlarmEvents, &alarmEvent, 0) == pdTRUE)
+    {
+      docAlarm.clear();
+      JsonArray events = docAlarm.to<JsonArray>();
+      char timeNow[24];
+      formatTimeDateNow(timeNow, sizeof(timeNow));
+      while (xQueueReceive(queueAlarmEvents, &alarmEvent, 0) == pdTRUE)
+      {
+        if (alarmEvent.generation != cfg->generation)
+          cfg = runtimeConfig.read(RCU_READER_LOGGER);
+        if (alarmEvent.generation != cfg->generation || alarmEvent.alarm >= cfg->alarmCount)
+          continue; // tabel alarm sudah berganti
+
+        const AlarmConfig &a = cfg->alarms[alarmEvent.alarm];
+        JsonObject e = events.createNestedObject();
+        e["KodeSensor"] = jsonKey(a.name); // disalin: snapshot bisa berganti di iterasi berikutnya
+        e["Alarm"] = ALARM_TYPE_NAMES[a.type];
+        e["State"] = alarmEvent.active ? "active" : "normal";
+        if (jobNum.length() > 4)
+        {
+          JsonObject additional = e.createNestedObject("additional");
+          additional["jobnum"] = jobNum.c_str();
+        }
+        e["StringWaktu"] = (const char *)timeNow;
+        char value[16];
+        snprintf(value, sizeof(value), "%.2f", alarmEvent.value);
+        e["Value"] = value;
+        Serial.printf("[ALARM] %s %s (%s)\n", a.name, alarmEvent.active ? "ACTIVE" : "normal", value);
+      }
+
+      sendString.clear();
+      if (events.size() > 0 && serializeJson(docAlarm, sendString) && !sendString.overflowed())
+      {
+        if (cfg->protocol == UPLINK_HTTP)
+          sendDataHTTP(sendString.c_str(), sendString.length(), cfg->endpoint, cfg->authUser, cfg->authPass, 0);
+        saveToSD(sendString.c_str());
       }
     }
 
     // 2. PERIODIC DATA SENDING
-    if (millis() - lastSendTime >= (networkSettings.sendInterval * 1000))
+    if (millis() - lastSendTime >= cfg->sendIntervalMs)
     {
       if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
       {
-        sendString = "";
+        sendString.clear();
         docNew.clear(); // ✅ REUSE (Jangan alokasi ulang!)
         JsonArray array = docNew.to<JsonArray>();
-
-        for (JsonPair kv : jsonSend.as<JsonObject>())
-        {
-          if (kv.key() == "-")
-            continue;
-          JsonObject nestedObj = array.createNestedObject();
-          nestedObj["KodeSensor"] = kv.key().c_str();
-          if (jobNum.length() > 4)
-          {
-            JsonObject additional = nestedObj.createNestedObject("additional");
-            additional["jobnum"] = jobNum.c_str();
-          }
-          if (networkSettings.connStatus == "Not Connected")
-          {
-            nestedObj["StringWaktu"] = getTimeDateNow();
-          }
-          nestedObj["Value"] = String(kv.value().as<float>());
-        }
+        // Satu akses RTC per kirim; disimpan sebagai pointer (const char*)
+        char timeNow[24];
+        formatTimeDateNow(timeNow, sizeof(timeNow));
+
+        // Waktu hanya saat offline (server memberi timestamp sendiri)
+        buildSensorPayload(jsonSend.as<JsonObjectConst>(), array,
+                           networkSettings.connStatus == "Not Connected" ? timeNow : NULL,
+                           jobNum.length() > 4 ? jobNum.c_str() : NULL);
         serializeJson(docNew, sendString);
         xSemaphoreGive(jsonMutex);
 
-        if (networkSettings.protocolMode == "HTTP")
+        if (sendString.overflowed())
         {
-          if (xSemaphoreTake(spiMutex, pdMS_TO_TICKS(2000)))
-          {
-            sendDataHTTP(sendString, networkSettings.endpoint,
-                         networkSettings.mqttUsername, networkSettings.mqttPassword, 0);
-            xSemaphoreGive(spiMutex);
-          }
-          else
-          {
-            Serial.println("⚠️ HTTP Send Skipped (SPI Busy)");
-          }
+          ESP_LOGW("Logger", "Payload > %u bytes, send skipped", (unsigned)sendString.capacity());
+        }
+        else if (cfg->protocol == UPLINK_HTTP)
+        {
+          // HTTP lewat lwIP; driver W5500 mengatur bus SPI sendiri per transaksi
+          sendDataHTTP(sendString.c_str(), sendString.length(), cfg->endpoint, cfg->authUser, cfg->authPass, 0);
         }
       }
       lastSendTime = millis();
@@ -2895,45 +1153,23 @@ void Task_DataLogger(void *parameter)
     // 3. SD CARD SAVE
     if (millis() - lastSDSave >= (networkSettings.sdSaveInterval * 60000UL))
     {
-      String dataToSave = "";
+      sendString.clear(); // buffer yang sama dengan kirim data (task yang sama)
       if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(200)))
       {
         docSD.clear(); // ✅ REUSE
         JsonArray arraySD = docSD.to<JsonArray>();
-        for (JsonPair kv : jsonSend.as<JsonObject>())
-        {
-          if (kv.key() == "-")
-            continue;
-          JsonObject nestedObj = arraySD.createNestedObject();
-          nestedObj["KodeSensor"] = kv.key().c_str();
-          if (jobNum.length() > 4)
-          {
-            JsonObject additional = nestedObj.createNestedObject("additional");
-            additional["jobnum"] = jobNum.c_str();
-          }
-          nestedObj["StringWaktu"] = getTimeDateNow();
-          nestedObj["Value"] = String(kv.value().as<float>());
-        }
-        serializeJson(docSD, dataToSave);
+        char timeNow[24];
+        formatTimeDateNow(timeNow, sizeof(timeNow));
+        buildSensorPayload(jsonSend.as<JsonObjectConst>(), arraySD, timeNow,
+                           jobNum.length() > 4 ? jobNum.c_str() : NULL);
+        serializeJson(docSD, sendString);
         xSemaphoreGive(jsonMutex);
       }
 
-      if (dataToSave.length() > 10)
+      if (sendString.length() > 10 && !sendString.overflowed())
       {
-        if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(500)))
-        {
-          if (xSemaphoreTake(spiMutex, pdMS_TO_TICKS(2000)))
-          {
-            saveToSD(dataToSave);
-            xSemaphoreGive(spiMutex);
-            ESP_LOGI("SD", "Data saved safely");
-          }
-          else
-          {
-            Serial.println("⚠️ SD Save Skipped (SPI Busy)");
-          }
-          xSemaphoreGive(sdMutex);
-        }
+        // saveToSD() mengambil sdMutex + lease bus SPI sendiri
+        saveToSD(sendString.c_str());
       }
       lastSDSave = millis();
     }
@@ -2943,23 +1179,14 @@ void Task_DataLogger(void *parameter)
     {
       if (networkSettings.connStatus == "Connected")
       {
-        if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(500)))
-        {
-          if (xSemaphoreTake(spiMutex, pdMS_TO_TICKS(3000))) 
-          {
-            sendBackupData();
-            xSemaphoreGive(spiMutex);
-          }
-          else
-          {
-            Serial.println("⚠️ Backup Send Skipped (SPI Busy)");
-          }
-          xSemaphoreGive(sdMutex);
-        }
+        sendBackupData(); // sdMutex + lease bus SPI diambil di dalam
       }
       lastPrint = millis();
     }
 
+    // 5. CONFIG COMMIT (ditunda dari web handler) + mirror SD
+    configStore.loop();
+
     vTaskDelay(pdMS_TO_TICKS(100));
   }
 }
@@ -2967,14 +1194,12 @@ void Task_DataLogger(void *parameter)
 void setup()
 {
   Serial.begin(115200);
-  delay(1000); 
 
   Serial.println("SYSTEM BOOT START");
-  esp_task_wdt_init(60, true);
   Serial.printf("MAC: %02X:%02X:%02X:%02X:%02X:%02X\n",
                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
   Serial.println("[Init] Configuring Watchdog Timer...");
-  esp_task_wdt_init(60, true); // 30 detik timeout
+  esp_task_wdt_init(60, true);
   Serial.println("  ✓ Watchdog: 60 seconds");
   // Set CPU frequency
   setCpuFrequencyMhz(240);
@@ -2990,32 +1215,79 @@ void setup()
     pinMode(digitalInput[i].pin, INPUT_PULLDOWN);
   }
 
+  // Digital output mulai OFF; level aktif disesuaikan "inv" setelah readConfig.
+  // Pin tidak terpasang / bentrok dengan board tidak disentuh.
+  for (byte i = 1; i < jumlahOutputDigital + 1; i++)
+  {
+    if (!doPinUsable(DO_PINS[i - 1]))
+    {
+      if (DO_PINS[i - 1] >= 0)
+        ESP_LOGE("DO", "DO%u: GPIO %d reserved on this board, output disabled", i, DO_PINS[i - 1]);
+      continue;
+    }
+    pinMode(DO_PINS[i - 1], OUTPUT);
+    digitalWrite(DO_PINS[i - 1], LOW);
+  }
+
   // 1. CREATE MUTEXES & QUEUES
-  spiMutex = xSemaphoreCreateMutex();
+  bool spiBusOk = spiBus.begin();
   i2cMutex = xSemaphoreCreateMutex();
   sdMutex = xSemaphoreCreateMutex();
   jsonMutex = xSemaphoreCreateMutex();
   modbusMutex = xSemaphoreCreateMutex();
   queueSensorData = xQueueCreate(10, sizeof(SensorDataPacket));
-  queueModbusData = xQueueCreate(10, sizeof(ModbusDataPacket));
-  queueLogData = xQueueCreate(10, sizeof(LogDataPacket));
+  // 2 scan penuh (64 tag / CHANNEL_BATCH_MAX = 4 paket per scan)
+  queueModbusData = xQueueCreate(2 * RUNTIME_MAX_MODBUS_TAGS / CHANNEL_BATCH_MAX, sizeof(ChannelBatchPacket));
+  queueAlarmEvents = xQueueCreate(RUNTIME_MAX_ALARMS, sizeof(AlarmEvent));
+
+  bool commandQueueOk = commandQueue.begin();
+  totalizers.begin();
 
-  if (!spiMutex || !jsonMutex || !queueSensorData || !modbusMutex)
+  if (!spiBusOk || !sdMutex || !jsonMutex || !queueSensorData || !queueModbusData || !queueAlarmEvents || !modbusMutex || !commandQueueOk)
   {
     Serial.println("❌ Critical Error: Failed to create Mutex/Queue!");
     while (1)
       delay(1000);
   }
 
-  // 2. READ CONFIG & INIT BASIC HARDWARE
-  // Read configuration (SPIFFS)
-  readConfig();
-  printConfigurationDetails();
+  // 2. LOAD CONFIG & INIT BASIC HARDWARE
+  // SPIFFS tetap di-mount untuk aset web & data runtime
+  if (!SPIFFS.begin())
+  {
+    ESP_LOGE("SPIFFS", "Failed to mount FS");
+    errorMessages.addTimedMessage("Failed to mount FS");
+  }
+
+  // Selesaikan commit config yang terputus (file .tmp) sebelum apa pun dibaca
+  configStore.begin();
+  runtimeConfig.begin();
+  cpuLoad.begin();
+
+  // Fast path: image biner di NVS. Jika belum ada (firmware lama) atau rusak,
+  // migrasi sekali dari file JSON lalu tulis image supaya boot berikutnya cepat.
+  if (!configImage.load())
+  {
+    Serial.println("[CFG] Migrating config from SPIFFS JSON...");
+    readConfig();
+    configImage.markSource("json");
+    configImage.save();
+  }
+  readRuntimeData();
+  for (byte i = 1; i < jumlahOutputDigital + 1; i++)
+  {
+    if (doPinUsable(DO_PINS[i - 1]))
+      digitalWrite(DO_PINS[i - 1], digitalOutput[i].inv); // OFF sesuai polaritas
+  }
+  rs485Master.begin(modbusParam.baudrate, modbusParam.dataBit, modbusParam.stopBit, modbusParam.parity.c_str());
+
   // Force Ethernet mode (sesuai request Anda)
   networkSettings.networkMode = "Ethernet";
   Serial.println("[FORCE] Mode set to Ethernet");
 
-  modbusSlaveSetup();
+  // Snapshot config pertama, wajib ada sebelum task mana pun dibuat
+  while (!runtimeConfig.publish())
+    delay(10);
+
   setupInterrupts();
 
   // Initialize I2C
@@ -3034,6 +1306,27 @@ void setup()
     // Sync time logic here if needed...
   }
 
+  // Initialize ADS1115
+  if (!ads.begin())
+  {
+    Serial.println("❌ ADS1115 Failed");
+    errorMessages.addMessage("ADS1115 Failed");
+  }
+  else
+  {
+    Serial.println("✅ ADS1115 Initialized");
+    ads.setGain(0);
+  }
+
+  // Init Variables
+  printTime = millis();
+  sendTimeModbus = millis();
+  modbusCount = 0;
+  jsonSend = DynamicJsonDocument(4096);
+
+  // Akuisisi jalan duluan: sampel pertama tidak menunggu SD, Ethernet & DHCP
+  xTaskCreatePinnedToCore(Task_DataAcquisition, "DataAcqTask", 12288, NULL, 3, &Task_Core1_DataAcquisition, 1);
+
   // ========================================================================
   // Ini menggantikan blok "SD CARD" yang lama.
   // Tujuannya: Menyalakan SD Card dan Ethernet dengan urutan yang benar (Anti-Bentrok)
@@ -3047,22 +1340,21 @@ void setup()
   pinMode(SD_CS_PIN, OUTPUT);
   digitalWrite(SD_CS_PIN, HIGH); // Matikan SD Card (CS HIGH = OFF)
 
-  delay(50); // Beri waktu jeda
-
   // B. Mulai Jalur SPI (Shared Bus)
-  // Kita set pin manual agar yakin W5500 dan SD Card pakai jalur yg sama
-  // Parameter terakhir -1 artinya "tidak ada CS default", karena kita atur manual
-  SPI.begin(ETH_CLK, ETH_MISO, ETH_MOSI, -1);
+  // Bus di-init lewat spi_master IDF (bukan SPIClass Arduino) karena driver
+  // esp_eth W5500 juga memakai spi_master di host yang sama.
+  sharedSpiBusInit();
 
   // C. Nyalakan SD Card Duluan (Sekali Saja!)
   Serial.print("[Init] Mounting SD Card... ");
 
-  // Gunakan Mutex untuk keamanan
-  if (xSemaphoreTake(spiMutex, portMAX_DELAY))
+  // Lease bus SPI (boot: belum ada client lain, tunggu selamanya)
   {
+    SpiBusLease lease(SPI_CLIENT_SYSTEM, SPI_PRIO_HIGH, SPI_BUS_WAIT_FOREVER, 1000);
+
     // Coba mount SD Card
     // Speed 4MHz lebih stabil untuk kabel jumper/panjang
-    if (!SD.begin(SD_CS_PIN, SPI, 4000000))
+    if (!SD.begin(SD_CS_PIN, 4000000))
     {
       Serial.println("❌ SD Card Mount Failed!");
       Serial.println("   -> Cek kabel atau format kartu (FAT32)");
@@ -3072,73 +1364,55 @@ void setup()
     {
       Serial.println("✅ SD Card Mounted Successfully!");
       Serial.print("   -> Size: ");
-      Serial.print(SD.totalBytes() / (1024 * 1024));
+      Serial.print((uint32_t)(SD.totalBytes() / (1024 * 1024)));
       Serial.println(" MB");
     }
-    xSemaphoreGive(spiMutex);
   }
 
   // Catatan: Ethernet W5500 belum dinyalakan disini.
   // Ethernet akan dinyalakan nanti di dalam fungsi configNetwork().
 
   // ========================================================================
-  // 4. INIT SENSORS & NETWORK
+  // 4. INIT NETWORK
   // ========================================================================
-
-  // Initialize ADS1115
-  if (!ads.begin())
-  {
-    Serial.println("❌ ADS1115 Failed");
-    errorMessages.addMessage("ADS1115 Failed");
-  }
-  else
-  {
-    Serial.println("✅ ADS1115 Initialized");
-    ads.setGain(0);
-  }
-
-  // Init Variables
-  printTime = millis();
-  sendTimeModbus = millis();
-  modbusCount = 0;
-  jsonSend = DynamicJsonDocument(4096);
-
   ESP_LOGI("Network", "Configuring network interface...");
 
-  // Di dalam fungsi ini, Ethernet.begin() akan dipanggil dan W5500 akan aktif
+  // Di dalam fungsi ini, ETH.begin() akan dipanggil dan W5500 aktif sebagai netif lwIP.
+  // DHCP tidak ditunggu: IP didapat di background, dipantau oleh Task_NetworkManagement.
   configNetwork();
 
   configProtocol();
 
-  delay(1000);
-
   // Start Web Server
   ESP_LOGI("WebServer", "Starting web server...");
   setupWebServer();
 
-  if (networkSettings.networkMode == "Ethernet")
-  {
-    ethServer.begin();
-    Serial.println("✅ Ethernet Web Server STARTED");
-  }
-
   // Print Access Info
   Serial.println("\n=================================");
   Serial.println("SYSTEM READY");
   if (networkSettings.networkMode == "Ethernet")
   {
-    Serial.printf("Ethernet IP: %s\n", Ethernet.localIP().toString().c_str());
+    Serial.printf("Ethernet IP: %s\n", ETH.localIP().toString().c_str());
   }
   Serial.printf("WiFi AP IP:  %s\n", WiFi.softAPIP().toString().c_str());
+  Serial.printf("Config:      %s (gen %u, load %u us)\n",
+                configImage.source(), configImage.generation(), configImage.loadMicros());
+  Serial.printf("Setup done:  %lu ms after reset\n", millis());
   Serial.println("=================================\n");
 
   // ========================================================================
   // 5. CREATE TASKS
   // ========================================================================
   xTaskCreatePinnedToCore(Task_NetworkManagement, "NetworkTask", 20480, NULL, 2, &Task_Core0_Network, 0);
-  xTaskCreatePinnedToCore(Task_DataAcquisition, "DataAcqTask", 12288, NULL, 3, &Task_Core1_DataAcquisition, 1);
   xTaskCreatePinnedToCore(Task_ModbusClient, "ModbusTask", 10240, NULL, 2, &Task_Core1_ModbusClient, 1);
   xTaskCreatePinnedToCore(Task_DataLogger, "LoggerTask", 20480, NULL, 1, &Task_Core1_DataLogger, 1);
+  xTaskCreatePinnedToCore(Task_ModbusTcpServer, "MbTcpTask", 4096, NULL, 3, &Task_Core0_ModbusTcp, 0);
+  xTaskCreatePinnedToCore(Task_Vibration, "VibrationTask", 4096, NULL, 1, &Task_Core0_Vibration, 0);
+  if (rs485Slave.enabled())
+    xTaskCreatePinnedToCore(Task_ModbusRtuSlave, "RtuSlaveTask", 4096, NULL, 4, &Task_Core1_ModbusSlave, 1);
+
+  // Diagnostik saja, setelah semua task jalan
+  printConfigurationDetails();
 }
 
 // ============================================================================
@@ -3166,11 +1440,13 @@ void setupWebServer()
       
       if (shouldReboot) {
         ESP_LOGI("OTA", "Update successful, rebooting...");
+        configStore.flush(); // edit config yang belum di-commit
+        totalizers.persist();
         delay(2000);
         ESP.restart();
       } else {
         ESP_LOGE("OTA", "Update failed");
-        errorMessages.addMessage(getTimeNow() + " - OTA Update Failed");
+        errorMessages.addTimedMessage("OTA Update Failed");
       } }, [](AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final)
             {
       if (!index) {
@@ -3188,7 +1464,7 @@ void setupWebServer()
         if (!Update.begin(UPDATE_SIZE_UNKNOWN, updateType)) {
           Update.printError(Serial);
           ESP_LOGE("OTA", "Update.begin failed");
-          errorMessages.addMessage(getTimeNow() + " - OTA Update.begin failed");
+          errorMessages.addTimedMessage("OTA Update.begin failed");
         } else {
           ESP_LOGI("OTA", "Update started successfully");
         }
@@ -3212,7 +1488,7 @@ void setupWebServer()
         } else {
           Update.printError(Serial);
           ESP_LOGE("OTA", "Update.end failed");
-          errorMessages.addMessage(getTimeNow() + " - OTA Update.end failed");
+          errorMessages.addTimedMessage("OTA Update.end failed");
         }
       } });
 
@@ -3243,7 +1519,7 @@ void setupWebServer()
   // Web server routes
   // [3] Root handler untuk captive portal
   server.on("/", HTTP_GET, [](AsyncWebServerRequest *request)
-            { request->send(SPIFFS, "/home.html", "text/html"); });
+            { handleFileRequest(request, "/home.html", "text/html"); });
   // [4] Redirect semua request ke root
   server.onNotFound([](AsyncWebServerRequest *request)
                     { request->redirect("/"); });
@@ -3252,6 +1528,8 @@ void setupWebServer()
             { handleFileRequest(request, "/debug-monitor.html", "text/html"); });
 
   server.addHandler(&errorMessages._eventSource);
+  liveStream.begin(server); // SSE /live: data realtime dashboard
+  commandSocket.begin(server); // WebSocket /ws: perintah DO & tuning live
 
   server.on("/system_settings", HTTP_GET, [](AsyncWebServerRequest *request)
             { handleFileRequest(request, "/system_settings.html", "text/html"); });
@@ -3263,7 +1541,8 @@ void setupWebServer()
     String jsonAuth = "{";
     jsonAuth += "\"username\":\"" + networkSettings.loginUsername + "\",";
     jsonAuth += "\"password\":\"" + networkSettings.loginPassword + "\",";
-    jsonAuth += "\"sdInterval\":" + String(networkSettings.sdSaveInterval);
+    jsonAuth += "\"sdInterval\":" + String(networkSettings.sdSaveInterval) + ",";
+    jsonAuth += "\"liveInterval\":" + String(networkSettings.liveInterval);
     jsonAuth += "}";
     request->send(200, "application/json", jsonAuth); });
 
@@ -3292,6 +1571,8 @@ void setupWebServer()
     if (request->hasArg("restart")){
       request->send(200, "text/plain", "OKKK");
       ESP_LOGI("ESP", "ESP will restart");
+      configStore.flush(); // edit config yang belum di-commit
+      totalizers.persist();
       delay(2000);
       ESP.restart();
     }
@@ -3400,7 +1681,12 @@ void setupWebServer()
   AsyncCallbackJsonWebHandler *handler = new AsyncCallbackJsonWebHandler("/modbus_setup", [](AsyncWebServerRequest *request, JsonVariant &json)
                                                                          {
     Serial.println("Masuk JSON");
-    jsonParam = DynamicJsonDocument(1024);
+    if (!xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(1000)))
+    {
+      request->send(503, "text/plain", "Busy");
+      return;
+    }
+    jsonParam.clear(); // kapasitas JSON_PARAM_CAPACITY tetap, tanpa realokasi
     if (json.is<JsonArray>())
     {
       jsonParam = json.as<JsonArray>();
@@ -3409,119 +1695,235 @@ void setupWebServer()
     {
       jsonParam = json.as<JsonObject>();
     }
+    if (jsonParam.overflowed())
+    {
+      // Tabel terpotong tidak boleh jalan / di-commit: kembalikan yang lama
+      jsonParam.clear();
+      deserializeJson(jsonParam, stringParam);
+      xSemaphoreGive(jsonMutex);
+      request->send(413, "text/plain", "Modbus setup too large");
+      return;
+    }
     stringParam = "";
     serializeJson(jsonParam, stringParam);
-    jsonSend = DynamicJsonDocument(1024);
+    jsonSend.clear(); // buang nilai tag lama
+    xSemaphoreGive(jsonMutex);
     request->send(200, "text/plain", "Succesfull");
-    saveToJson("/modbusSetup.json","modbusSetup");
-    Serial.println(stringParam); });
+    configChanged(CFG_MODBUS);
+    Serial.println(stringParam); }, 8192);
   server.addHandler(handler);
 
   server.on("/modbusLoad", HTTP_GET, [](AsyncWebServerRequest *request)
             { request->send(200, "application/json", stringParam); });
 
-  server.on("/getValue", HTTP_GET, [](AsyncWebServerRequest *request)
+  // =========================================================================
+  // CONFIG IMPORT / EXPORT (JSON). Boot memakai image biner di NVS; JSON
+  // hanya format pertukaran: {"network":{..},"digital":{..},"analog":{..},
+  // "modbusSetup":{..},"systemSettings":{..}} (key yang tidak ada dilewati)
+  // =========================================================================
+  server.on("/configExport", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    if (!request->authenticate(networkSettings.loginUsername.c_str(), networkSettings.loginPassword.c_str()))
+      return request->requestAuthentication();
+
+    DynamicJsonDocument exportDoc(JSON_PARAM_CAPACITY + 4096);
+    if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(1000)))
+    {
+      DynamicJsonDocument section(JSON_PARAM_CAPACITY);
+      for (const ConfigFileEntry &f : configFiles)
+      {
+        section.clear();
+        buildConfigJson(f.type, section);
+        exportDoc[f.type] = section.as<JsonVariantConst>();
+      }
+      xSemaphoreGive(jsonMutex);
+    }
+    exportDoc["generation"] = configImage.generation();
+
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    response->addHeader("Content-Disposition", "attachment; filename=\"config.json\"");
+    serializeJson(exportDoc, *response);
+    request->send(response); });
+
+  AsyncCallbackJsonWebHandler *importHandler = new AsyncCallbackJsonWebHandler("/configImport", [](AsyncWebServerRequest *request, JsonVariant &json)
+                                                                               {
+    if (!request->authenticate(networkSettings.loginUsername.c_str(), networkSettings.loginPassword.c_str()))
+      return request->requestAuthentication();
+
+    // Tulis file JSON (atomik) lalu parse lewat jalur migrasi yang sama (readConfig).
+    // Image NVS, normalisasi file & mirror SD dikerjakan commit configStore.
+    uint8_t imported = 0;
+    for (const ConfigFileEntry &f : configFiles)
+    {
+      JsonVariant section = json[f.type];
+      if (section.isNull())
+        continue;
+      String data;
+      serializeJson(section, data);
+      if (ConfigStore::writeAtomic(SPIFFS, f.path, data))
+        imported |= f.section;
+    }
+
+    if (imported == 0 || !xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(1000)))
+    {
+      request->send(400, "text/plain", "Nothing imported");
+      return;
+    }
+    readConfig();
+    configImage.markSource("json");
+    xSemaphoreGive(jsonMutex);
+
+    configChanged(imported);
+    request->send(200, "text/plain", "Config imported. Restart to apply network settings."); }, 8192);
+  server.addHandler(importHandler);
+
+  // =========================================================================
+  // COMMAND (tulis DO lokal / register perangkat RS-485), lihat CommandQueue.hpp
+  // POST /command {"do":"Pompa 1","value":true} atau
+  //               {"unit":1,"fc":6,"addr":100,"value":123,"priority":"high"}
+  //   -> 202 {"id":n,"status":"pending"} (DO lokal: status akhir langsung);
+  //      hasil RS-485 lewat GET /commandStatus?id=n
+  // =========================================================================
+  AsyncCallbackJsonWebHandler *commandHandler = new AsyncCallbackJsonWebHandler("/command", [](AsyncWebServerRequest *request, JsonVariant &json)
+                                                                                {
+    if (!request->authenticate(networkSettings.loginUsername.c_str(), networkSettings.loginPassword.c_str()))
+      return request->requestAuthentication();
+
+    RuntimeConfigReadGuard cfg;
+    WriteCommand cmd;
+    if (!json.is<JsonObject>() || !commandFromJson(cfg.get(), json.as<JsonObjectConst>(), CMD_SRC_HTTP, cmd))
+    {
+      request->send(400, "text/plain", "Invalid command");
+      return;
+    }
+    uint32_t id = commandQueue.submit(cmd);
+    if (id == 0)
+    {
+      request->send(503, "text/plain", "Command rejected (invalid target or queue full)");
+      return;
+    }
+    char body[48];
+    snprintf(body, sizeof(body), "{\"id\":%u,\"status\":\"%s\"}", id, commandQueue.ackStatus(cmd, id));
+    request->send(202, "application/json", body); });
+  server.addHandler(commandHandler);
+
+  server.on("/commandStatus", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    uint32_t id = request->hasParam("id") ? request->getParam("id")->value().toInt() : 0;
+    StaticJsonDocument<192> statusDoc;
+    CommandQueue::resultToJson(commandQueue.result(id), statusDoc.to<JsonObject>());
+
+    String response;
+    serializeJson(statusDoc, response);
+    request->send(200, "application/json", response); });
+
+  // Trace event beberapa detik terakhir (Chrome trace JSON, buka di Perfetto)
+  // ?ms=<jendela>, default 2000
+  server.on("/trace", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    uint32_t windowMs = 2000;
+    if (request->hasParam("ms"))
+      windowMs = constrain(request->getParam("ms")->value().toInt(), 10, 60000);
+    traceBuffer.sendChromeTrace(request, windowMs); });
+
+  // Counter & histogram runtime: Prometheus text (default) atau ?format=json
+  server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    if (request->hasParam("format") && request->getParam("format")->value() == "json")
+    {
+      DynamicJsonDocument metricsDoc(8192);
+      writeMetricsJson(metricsDoc.to<JsonObject>());
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      serializeJson(metricsDoc, *response);
+      request->send(response);
+      return;
+    }
+    AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+    writeMetricsPrometheus(*response);
+    request->send(response); });
+
+  // Throughput / latency / loss akuisisi & scan Modbus untuk konfigurasi aktif
+  server.on("/scanStats", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    DynamicJsonDocument statsDoc(8192);
+    RuntimeConfigReadGuard cfg;
+    scanStats.toJson(statsDoc.to<JsonObject>(), cfg.get());
+
+    String response;
+    serializeJson(statsDoc, response);
+    request->send(200, "application/json", response); });
+
+  // Status alarm lokal (definisi dari snapshot aktif + state AlarmEngine)
+  server.on("/alarms", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    DynamicJsonDocument alarmDoc(3072);
+    JsonArray list = alarmDoc.to<JsonArray>();
+    RuntimeConfigReadGuard cfg;
+    bool current = alarmEngine.generation() == cfg->generation;
+    for (uint8_t n = 0; n < cfg->alarmCount; n++)
+    {
+      const AlarmConfig &a = cfg->alarms[n];
+      JsonObject o = list.createNestedObject();
+      o["name"] = jsonKey(a.name);
+      o["type"] = ALARM_TYPE_NAMES[a.type];
+      o["limit"] = a.limit;
+      o["active"] = current && alarmEngine.active(n);
+      o["value"] = round2(alarmEngine.value(n));
+      o["stale"] = current && alarmEngine.stale(n);
+      if (a.doIndex)
+        o["do"] = a.doIndex;
+    }
+
+    String response;
+    serializeJson(alarmDoc, response);
+    request->send(200, "application/json", response); });
+
+  // Totalizer: akumulator berjalan & periode sebelumnya
+  server.on("/totalizers", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    DynamicJsonDocument totalDoc(1536);
+    totalizers.toJson(totalDoc.to<JsonArray>());
+
+    String response;
+    serializeJson(totalDoc, response);
+    request->send(200, "application/json", response); });
+
+  // Getaran: fitur capture terakhir per kanal + cycles FFT terakhir
+  server.on("/vibration", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    DynamicJsonDocument vibDoc(2048);
+    RuntimeConfigReadGuard cfg;
+    vibration.toJson(vibDoc.to<JsonObject>(), cfg.get());
+
+    String response;
+    serializeJson(vibDoc, response);
+    request->send(200, "application/json", response); });
+
+  // Reset manual: POST name=<nama totalizer>; total berjalan -> lastPeriod
+  server.on("/totalizerReset", HTTP_POST, [](AsyncWebServerRequest *request)
             {
-      String realtimeJson;
-      // Gunakan Mutex agar tidak crash saat membaca data live
-      if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(100))) 
-      {
-          // Ambil data dari jsonSend (Variable Live Update) BUKAN sendString
-          serializeJson(jsonSend, realtimeJson); 
-          xSemaphoreGive(jsonMutex);
-      } 
-      else 
-      {
-          realtimeJson = "{}"; // Kirim kosong jika sistem sibuk
-      }
-      request->send(200, "application/json", realtimeJson); });
-  server.on("/getCurrentValue", HTTP_GET, [](AsyncWebServerRequest *request)
+    if (!request->authenticate(networkSettings.loginUsername.c_str(), networkSettings.loginPassword.c_str()))
+      return request->requestAuthentication();
+    if (!request->hasParam("name", true) || !totalizers.reset(request->getParam("name", true)->value().c_str()))
+    {
+      request->send(404, "text/plain", "Unknown totalizer");
+      return;
+    }
+    request->send(200, "text/plain", "OK"); });
+
+  server.on("/configStatus", HTTP_GET, [](AsyncWebServerRequest *request)
             {
-      if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(100))) 
-      {
-          DynamicJsonDocument docTemp(2048); // Gunakan doc lokal agar aman
-          
-          // Fix: Loop dari 1 sampai jumlahInputAnalog (Bukan dari 0)
-          for (int i = 1; i <= jumlahInputAnalog; i++) {
-            docTemp["rawValue" + String(i)] = analogInput[i].adcValue;
-            docTemp["scaledValue" + String(i)] = analogInput[i].mapValue;
-          }
-          
-          // Tambahkan Digital Input
-          for (int i = 1; i <= jumlahInputDigital; i++) {
-             docTemp["diValue" + String(i)] = digitalInput[i].value;
-          }
+    DynamicJsonDocument statusDoc(384);
+    configStore.statsToJson(statusDoc.to<JsonObject>());
+    statusDoc["source"] = configImage.source();
 
-          String dataLoad;
-          serializeJson(docTemp, dataLoad);
-          xSemaphoreGive(jsonMutex);
-          request->send(200, "application/json", dataLoad); 
-      }
-      else
-      {
-          request->send(200, "application/json", "{}");
-      } });
+    String response;
+    serializeJson(statusDoc, response);
+    request->send(200, "application/json", response); });
+
+  // Data realtime (dulu /getValue, /getCurrentValue, /homeLoad) sekarang
+  // di-push lewat SSE /live, lihat LiveStream.hpp
 
-  server.on("/homeLoad", HTTP_GET, [](AsyncWebServerRequest *request)
-            {
-              // Ambil Mutex agar data konsisten
-              if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(100))) 
-              {
-                doc = DynamicJsonDocument(4096);
-                
-                // --- Data Network & System ---
-                doc["networkMode"] = networkSettings.networkMode;
-                doc["ssid"] = networkSettings.ssid;
-                doc["ipAddress"] = (networkSettings.networkMode == "WiFi") ? WiFi.localIP().toString() : networkSettings.ipAddress;
-                doc["macAddress"] = (networkSettings.networkMode == "WiFi") ? WiFi.macAddress() : networkSettings.macAddress;
-                doc["protocolMode"] = networkSettings.protocolMode;
-                doc["endpoint"] = networkSettings.endpoint;
-                doc["connStatus"] = networkSettings.connStatus;
-                doc["jobNumber"] = jobNum;
-                doc["sendInterval"] = networkSettings.sendInterval;
-                doc["datetime"] = getTimeDateNow();
-
-                // --- Data Analog Input ---
-                JsonObject AI = doc.createNestedObject("AI");
-                JsonArray AIRawValue = AI.createNestedArray("rawValue");
-                JsonArray AIScaledValue = AI.createNestedArray("scaledValue");
-                
-                // [FIX] BARIS INI WAJIB DIAKTIFKAN (Hapus tanda //)
-                JsonArray EnAI = AI.createNestedArray("enAI"); 
-                // ------------------------------------------------
-
-                for (int i = 1; i <= jumlahInputAnalog; i++) {
-                  AIRawValue.add(analogInput[i].adcValue);
-                  AIScaledValue.add(analogInput[i].mapValue);
-                  
-                  // [FIX] BARIS INI WAJIB DIAKTIFKAN (Hapus tanda //)
-                  // Jika nama sensor terisi, kirim 1 (aktif). Jika kosong, kirim 0.
-                  EnAI.add(analogInput[i].name != "" ? 1 : 0);
-                  // ------------------------------------------------
-                }
-
-                // --- Data Digital Input ---
-                JsonObject DI = doc.createNestedObject("DI");
-                JsonArray DIValue = DI.createNestedArray("value");
-                JsonArray DITaskMode = DI.createNestedArray("taskMode");
-                JsonArray DIName = DI.createNestedArray("name");
-
-                for (int i = 1; i <= jumlahInputDigital; i++) {
-                  DIValue.add(digitalInput[i].value);
-                  DITaskMode.add(digitalInput[i].taskMode);
-                  DIName.add(digitalInput[i].name);
-                }
-
-                String dataLoad;
-                serializeJson(doc, dataLoad);
-                xSemaphoreGive(jsonMutex);
-                
-                request->send(200, "application/json", dataLoad);
-              }
-              else 
-              {
-                request->send(503, "application/json", "{}");
-              } });
   // WiFi Status and Diagnostic Endpoint
   server.on("/wifiStatus", HTTP_GET, [](AsyncWebServerRequest *request)
             {
@@ -3562,73 +1964,39 @@ void setupWebServer()
   // =========================================================================
   server.on("/ethernetStatus", HTTP_GET, [](AsyncWebServerRequest *request)
             {
-  DynamicJsonDocument statusDoc(512);
+  DynamicJsonDocument statusDoc(768);
   
   statusDoc["mode"] = networkSettings.networkMode;
   
   if (networkSettings.networkMode == "Ethernet")
   {
-    // Hardware Status
-    auto hwStatus = Ethernet.hardwareStatus();
-    switch (hwStatus)
-    {
-      case EthernetNoHardware:
-        statusDoc["hardware"] = "Not Found";
-        statusDoc["hardwareStatus"] = false;
-        break;
-      case EthernetW5100:
-        statusDoc["hardware"] = "W5100";
-        statusDoc["hardwareStatus"] = true;
-        break;
-      case EthernetW5200:
-        statusDoc["hardware"] = "W5200";
-        statusDoc["hardwareStatus"] = true;
-        break;
-      case EthernetW5500:
-        statusDoc["hardware"] = "W5500";
-        statusDoc["hardwareStatus"] = true;
-        break;
-      default:
-        statusDoc["hardware"] = "Unknown";
-        statusDoc["hardwareStatus"] = false;
-        break;
-    }
-    
+    // Hardware Status (driver esp_eth W5500 berhasil di-install atau tidak)
+    statusDoc["hardware"] = ethReady ? "W5500" : "Not Found";
+    statusDoc["hardwareStatus"] = ethReady;
+
     // Link Status
-    auto linkStatus = Ethernet.linkStatus();
-    switch (linkStatus)
-    {
-      case Unknown:
-        statusDoc["link"] = "Unknown";
-        statusDoc["connected"] = false;
-        break;
-      case LinkON:
-        statusDoc["link"] = "Connected";
-        statusDoc["connected"] = true;
-        break;
-      case LinkOFF:
-        statusDoc["link"] = "Disconnected";
-        statusDoc["connected"] = false;
-        break;
-    }
+    bool linkUp = ETH.linkUp();
+    statusDoc["link"] = linkUp ? "Connected" : "Disconnected";
+    statusDoc["connected"] = linkUp;
     
     // Network Information
-    statusDoc["ip"] = Ethernet.localIP().toString();
-    statusDoc["subnet"] = Ethernet.subnetMask().toString();
-    statusDoc["gateway"] = Ethernet.gatewayIP().toString();
-    statusDoc["dns"] = Ethernet.dnsServerIP().toString();
+    statusDoc["ip"] = ETH.localIP().toString();
+    statusDoc["subnet"] = ETH.subnetMask().toString();
+    statusDoc["gateway"] = ETH.gatewayIP().toString();
+    statusDoc["dns"] = ETH.dnsIP().toString();
     statusDoc["macAddress"] = networkSettings.macAddress;
     
     // DHCP Mode
     statusDoc["dhcpMode"] = networkSettings.dhcpMode;
     
     // Connection quality indicator
-    if (linkStatus == LinkON)
+    if (linkUp)
     {
       statusDoc["quality"] = "Excellent";
       statusDoc["qualityPercent"] = 100;
+      statusDoc["linkSpeed"] = ETH.linkSpeed();
     }
-    else if (linkStatus == LinkOFF)
+    else if (ethReady)
     {
       statusDoc["quality"] = "No Cable";
       statusDoc["qualityPercent"] = 0;
@@ -3638,6 +2006,13 @@ void setupWebServer()
       statusDoc["quality"] = "Unknown";
       statusDoc["qualityPercent"] = 50;
     }
+
+    // RX driver W5500
+    statusDoc["spiClockMHz"] = ETH.spiClockMHz();
+    statusDoc["rxFramesPerSec"] = ethRxFramesPerSec;
+    statusDoc["rxCpuPercent"] = ethRxCpuPercent;
+    statusDoc["rxDropped"] = ethRxDropped;
+    statusDoc["rxPoolFree"] = ethRxPoolFree;
   }
   else
   {
@@ -3655,11 +2030,29 @@ void setupWebServer()
   statusDoc["cpuFreq"] = getCpuFrequencyMhz();
   statusDoc["uptime"] = millis() / 1000;
   statusDoc["connectionStatus"] = networkSettings.connStatus;
+
+  // Fast-boot: sumber config & waktu sampai sampel pertama
+  statusDoc["configSource"] = configImage.source();
+  statusDoc["configLoadUs"] = configImage.loadMicros();
+  statusDoc["bootToFirstSampleMs"] = bootFirstSampleMs;
   
   String response;
   serializeJson(statusDoc, response);
   request->send(200, "application/json", response); });
 
+  // =========================================================================
+  // ENDPOINT: Statistik arbitrase bus SPI (wait/hold per client)
+  // =========================================================================
+  server.on("/spiBusStatus", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+  DynamicJsonDocument busDoc(768);
+  busDoc["sliceBytes"] = SPI_BUS_SLICE_BYTES;
+  spiBus.statsToJson(busDoc.createNestedObject("clients"));
+
+  String response;
+  serializeJson(busDoc, response);
+  request->send(200, "application/json", response); });
+
   // =========================================================================
   // ENDPOINT BARU: Network Interface Information (kombinasi WiFi + Ethernet)
   // =========================================================================
@@ -3676,8 +2069,8 @@ void setupWebServer()
   {
     ethInfo["active"] = true;
     ethInfo["hardware"] = "W5500";
-    ethInfo["link"] = (Ethernet.linkStatus() == LinkON) ? "Connected" : "Disconnected";
-    ethInfo["ip"] = Ethernet.localIP().toString();
+    ethInfo["link"] = ETH.linkUp() ? "Connected" : "Disconnected";
+    ethInfo["ip"] = ETH.localIP().toString();
     ethInfo["mac"] = networkSettings.macAddress;
   }
   else
@@ -3738,13 +2131,13 @@ void setupWebServer()
   }
   
   // Test hardware
-  testDoc["hardwareDetected"] = (Ethernet.hardwareStatus() != EthernetNoHardware);
+  testDoc["hardwareDetected"] = ethReady;
   
   // Test link
-  testDoc["cableConnected"] = (Ethernet.linkStatus() == LinkON);
+  testDoc["cableConnected"] = ETH.linkUp();
   
   // Test IP configuration
-  testDoc["ipConfigured"] = (Ethernet.localIP() != IPAddress(0, 0, 0, 0));
+  testDoc["ipConfigured"] = (ETH.localIP() != IPAddress(0, 0, 0, 0));
   
   // Overall test result
   bool allTestsPassed = testDoc["hardwareDetected"].as<bool>() && 
@@ -3756,7 +2149,7 @@ void setupWebServer()
   
   if (allTestsPassed)
   {
-    testDoc["ip"] = Ethernet.localIP().toString();
+    testDoc["ip"] = ETH.localIP().toString();
   }
   
   String response;
@@ -3785,47 +2178,15 @@ void setupWebServer()
     ESP_LOGW("Ethernet", "Ethernet interface not initialized or no IP assigned.");
   }
   // ============================================================
-  // KODE BARU: STATIC FILES DENGAN CACHE (Agar Cepat)
-  // ============================================================
-
-  // 1. Cache Folder CSS & JS (Disimpan browser selama 1 tahun)
-  server.serveStatic("/css", SPIFFS, "/css").setCacheControl("max-age=31536000");
-  server.serveStatic("/js", SPIFFS, "/js").setCacheControl("max-age=31536000");
-
-  // 2. Cache File Libraries & Gambar Satuan (Disimpan browser selama 1 tahun)
-  server.serveStatic("/bootstrap.min.css", SPIFFS, "/bootstrap.min.css").setCacheControl("max-age=31536000");
-  server.serveStatic("/bootstrap.bundle.min.js", SPIFFS, "/bootstrap.bundle.min.js").setCacheControl("max-age=31536000");
-  server.serveStatic("/jquery-3.5.1.min.js", SPIFFS, "/jquery-3.5.1.min.js").setCacheControl("max-age=31536000");
-  server.serveStatic("/logoMeditech32.png", SPIFFS, "/logoMeditech32.png").setCacheControl("max-age=31536000");
-  server.serveStatic("/logoMeditech256.png", SPIFFS, "/logoMeditech256.png").setCacheControl("max-age=31536000");
-
-  // ============================================================
-  // Start the server
+  // STATIC FILES: gzip + ETag + 304 (lihat StaticAssets.hpp)
+  // Didaftarkan paling akhir supaya route di atas tetap didahulukan.
   // ============================================================
-  // KODE BARU: STATIC FILES DENGAN CACHE (Agar Cepat)
-  // ============================================================
-
-  // 1. Cache Folder CSS & JS (Disimpan browser selama 1 tahun)
-  server.serveStatic("/css", SPIFFS, "/css").setCacheControl("max-age=31536000");
-  server.serveStatic("/js", SPIFFS, "/js").setCacheControl("max-age=31536000");
-
-  // 2. Cache File Libraries & Gambar Satuan (Disimpan browser selama 1 tahun)
-  server.serveStatic("/bootstrap.min.css", SPIFFS, "/bootstrap.min.css").setCacheControl("max-age=31536000");
-  server.serveStatic("/bootstrap.bundle.min.js", SPIFFS, "/bootstrap.bundle.min.js").setCacheControl("max-age=31536000");
-  server.serveStatic("/jquery-3.5.1.min.js", SPIFFS, "/jquery-3.5.1.min.js").setCacheControl("max-age=31536000");
-  server.serveStatic("/logoMeditech32.png", SPIFFS, "/logoMeditech32.png").setCacheControl("max-age=31536000");
-  server.serveStatic("/logoMeditech256.png", SPIFFS, "/logoMeditech256.png").setCacheControl("max-age=31536000");
-
-  // 3. Halaman HTML Utama (JANGAN di-cache, agar data selalu update)
-  server.serveStatic("/", SPIFFS, "/").setDefaultFile("home.html").setCacheControl("no-cache");
+  staticAssets.begin(SPIFFS);
+  server.addHandler(&staticAssets);
 
   // ============================================================
+  // AsyncWebServer listen di IPADDR_ANY: otomatis melayani WiFi AP/STA dan Ethernet (lwIP)
   server.begin();
-  if (networkSettings.networkMode == "Ethernet")
-  {
-    ethServer.begin();
-    Serial.println("✅ Ethernet Web Server STARTED on Port 80");
-  }
   ESP_LOGI("WebServer", "Web server started successfully");
 
   // [1] Start DNS Server untuk captive portal
@@ -3839,125 +2200,127 @@ void setupWebServer()
 // ============================================================================
 void setupInterrupts()
 {
+  // ISR dipasang sekali untuk semua DI lalu dimatikan; mode per DI
+  // (termasuk trigger kirim) diatur Task_DataAcquisition dari snapshot
   for (byte i = 1; i <= jumlahInputDigital; i++)
-    attachDigitalInputInterrupt(i);
-  configureSendTriggerInterrupt(networkSettings);
-}
-
-// ============================================================================
-// MODBUS SLAVE SETUP
-// ============================================================================
-void modbusSlaveSetup()
-{
-  bool useTCP = (networkSettings.protocolMode2 == "Modbus TCP/IP" || networkSettings.protocolMode2 == "Modbus RTU + TCP/IP");
-  bool useRTU = (networkSettings.protocolMode2 == "Modbus RTU" || networkSettings.protocolMode2 == "Modbus RTU + TCP/IP");
-
-  if (useTCP)
-    mbIP.server(502);
-
-  if (useRTU)
-    mbRTU.begin(&SerialModbus);
-
-  for (byte i = 0; i < 100; i++)
   {
-    if (useTCP)
-      mbIP.addIreg(i);
-    if (useRTU)
-      mbRTU.addIreg(i);
+    diIsrMode[i] = 0;
+    attachInterruptArg(digitalPinToInterrupt(digitalInput[i].pin), isrDigitalInput, (void *)(uint32_t)i, RISING);
+    gpio_intr_disable((gpio_num_t)digitalInput[i].pin);
   }
 }
 
 // ============================================================================
 // SUPPORT FUNCTIONS
 // ============================================================================
-float filterSensor(float filterVar, float filterResult_1, float fc)
+// Satu transaksi master di bus RS-485: kirim frame, tunggu byte pertama
+// (timeoutMs), lalu baca sampai expectedLen byte (0 = tidak diketahui) atau bus
+// diam lebih dari t3.5. Kembalikan jumlah byte balasan (0 = timeout).
+size_t rs485Transaction(const uint8_t *request, size_t reqLen, uint8_t *response, size_t maxLen, size_t expectedLen, uint32_t timeoutMs)
 {
-  // Safety check: Jika fc terlalu kecil, skip filter
-  if (fc < 0.01)
-    return filterVar;
-
-  float Ts = 0.1; // Sampling time (sesuai loop 100ms)
-  float RC = 1.0 / (2.0 * 3.14159 * fc);
-  float alpha = Ts / (RC + Ts); // Normalized (0-1)
-
-  // Low-pass filter: Y = alpha*X + (1-alpha)*Y_prev
-  float filterResult = (alpha * filterVar) + ((1.0 - alpha) * filterResult_1);
-
-  // Safety: Jika hasil tidak masuk akal, return raw value
-  if (isnan(filterResult) || isinf(filterResult) || filterResult > 30000 || filterResult < -1000)
-  {
-    return filterVar;
-  }
-
-  return filterResult;
+  MetricTimer timer(mModbusTransaction);
+  mModbusRequests.inc();
+
+  traceBegin(TR_MODBUS_TX);
+  rs485Master.send(request, reqLen);
+  traceEnd(TR_MODBUS_TX);
+
+  // Tunggu dengan yield (Rs485Port::receive), framing diuji di test/test_rs485
+  TraceScope rxTrace(TR_MODBUS_RX);
+  size_t resIndex = rs485Master.receive(response, maxLen, expectedLen, timeoutMs);
+  if (resIndex == 0)
+    mModbusTimeouts.inc();
+  return resIndex;
 }
-unsigned int readModbusNonBlocking(unsigned int modbusAddress, unsigned int funCode, unsigned int regAddress, unsigned int timeoutMs)
-{
-  unsigned int buffSend[8];
-  unsigned int crcValue;
-  unsigned int returnValue = 0;
-  byte buffModbus[64];
-  int resIndex = 0;
-
-  // 1. Bersihkan Buffer
-  while (SerialModbus.available())
-    SerialModbus.read();
-
-  // 2. Siapkan Request
-  buffSend[0] = modbusAddress;
-  buffSend[1] = funCode;
-  buffSend[2] = parseByte(regAddress, 1);
-  buffSend[3] = parseByte(regAddress, 0);
-  buffSend[4] = 0;
-  buffSend[5] = 1;
-  crcValue = crcModbus(buffSend, 0, 6);
-  buffSend[6] = parseByte(crcValue, 1);
-  buffSend[7] = parseByte(crcValue, 0);
-
-  // 3. Kirim Request
-  for (byte j = 0; j < 8; j++)
-  {
-    SerialModbus.write(buffSend[j]);
-  }
-  SerialModbus.flush();
 
-  // 4. ✅ TUNGGU DENGAN YIELD (Non-Blocking!)
-  unsigned long startTime = millis();
-  while (millis() - startTime < timeoutMs)
-  {
-    if (SerialModbus.available())
-      break;
-    vTaskDelay(1); // ✅ WAJIB! Beri CPU ke task lain
-  }
+// Block read FC3/FC4 lewat RS-485: count register mulai regAddress ke values.
+// timeoutMs = tunggu byte pertama; panjang balasan diketahui dari count.
+uint8_t readModbusBlock(uint8_t slaveId, uint8_t funCode, uint16_t regAddress, uint16_t count, uint16_t *values, uint32_t timeoutMs)
+{
+  uint8_t buffSend[MODBUS_READ_REQUEST_LEN];
+  uint8_t buffModbus[MODBUS_RTU_FRAME_MAX];
+  modbusBuildReadRequest(buffSend, slaveId, funCode, regAddress, count);
+  size_t resIndex = rs485Transaction(buffSend, sizeof(buffSend), buffModbus, sizeof(buffModbus),
+                                     modbusReadResponseLen(count), timeoutMs);
+  if (resIndex == 0)
+    return MB_FRAME_TIMEOUT;
+
+  // Parse Data (slave ID, FC, byte count & CRC divalidasi)
+  uint8_t result = MB_FRAME_MISMATCH; // FC lain belum didukung master
+  if (funCode == 3 || funCode == 4)
+    result = modbusParseReadBlock(buffModbus, resIndex, slaveId, funCode, count, values);
+
+  if (result != MB_FRAME_OK)
+    mModbusErrors.inc();
+  return result;
+}
 
-  if (!SerialModbus.available())
-  {
-    return 0; // Timeout
-  }
+// Teruskan request gateway TCP->RTU yang antre. Hanya dari Task_ModbusClient
+// (pemilik port master), di sela blok scan dan saat idle. Timeout bus = timeout
+// unit tujuan di config (slave lambat di belakang gateway tidak selalu 100 ms).
+static size_t gatewayTransaction(const uint8_t *frame, size_t len, uint8_t *resp, size_t maxLen, uint8_t unit, void *ctx)
+{
+  const RuntimeConfig *cfg = (const RuntimeConfig *)ctx;
+  return rs485Transaction(frame, len, resp, maxLen, 0, cfg->unitTimeoutMs(unit));
+}
 
-  // 5. ✅ Baca dengan Yield
-  vTaskDelay(pdMS_TO_TICKS(10)); // Jeda sebentar biar byte lengkap
+void serviceModbusGateway(const RuntimeConfig *cfg)
+{
+  modbusGateway.service(gatewayTransaction, (void *)cfg);
+}
 
-  while (SerialModbus.available() && resIndex < 60)
-  {
-    buffModbus[resIndex] = SerialModbus.read();
-    resIndex++;
-  }
+// Baca ulang coil (FC1) / holding register (FC3) setelah write
+static uint8_t verifyModbusWrite(const WriteCommand &cmd, uint32_t timeoutMs)
+{
+  bool coils = cmd.fc == 5 || cmd.fc == 15;
+  uint8_t req[MODBUS_READ_REQUEST_LEN];
+  uint8_t resp[MODBUS_RTU_FRAME_MAX];
+  uint16_t values[COMMAND_MAX_VALUES];
+  modbusBuildReadRequest(req, cmd.unit, coils ? 1 : 3, cmd.addr, cmd.count);
+  size_t expected = coils ? 5 + (cmd.count + 7) / 8 : modbusReadResponseLen(cmd.count);
+  size_t n = rs485Transaction(req, sizeof(req), resp, sizeof(resp), expected, timeoutMs);
+  if (n == 0)
+    return MB_FRAME_TIMEOUT;
+  uint8_t result = coils ? modbusParseReadBits(resp, n, cmd.unit, 1, cmd.count, values)
+                         : modbusParseReadBlock(resp, n, cmd.unit, 3, cmd.count, values);
+  for (uint16_t i = 0; result == MB_FRAME_OK && i < cmd.count; i++)
+  {
+    if (values[i] != (coils ? (uint16_t)(cmd.values[i] != 0) : cmd.values[i]))
+      result = MB_FRAME_MISMATCH;
+  }
+  return result;
+}
 
-  // 6. Parse Data
-  if (resIndex >= 5)
-  {
-    if (buffModbus[0] == modbusAddress && buffModbus[1] == funCode)
-    {
-      if (funCode == 3 || funCode == 4)
-      {
-        returnValue = (buffModbus[3] << 8) | buffModbus[4];
-      }
-    }
-  }
+// Perintah RS-485 (DO lokal sudah diterapkan di commandQueue.submit)
+static void executeCommand(const WriteCommand &cmd, uint32_t timeoutMs)
+{
+  uint8_t status = CMD_STATUS_DONE;
+  uint8_t frame[MODBUS_RTU_FRAME_MAX];
+  uint8_t resp[MODBUS_RTU_FRAME_MAX];
+  size_t len = modbusBuildWriteRequest(frame, cmd.unit, cmd.fc, cmd.addr, cmd.count, cmd.values);
+  size_t n = rs485Transaction(frame, len, resp, sizeof(resp), MODBUS_WRITE_RESPONSE_LEN, timeoutMs);
+  uint8_t result = n ? modbusParseWriteResponse(resp, n, frame) : MB_FRAME_TIMEOUT;
+  if (result != MB_FRAME_OK)
+    status = CMD_STATUS_FAILED;
+  else if (cmd.verify && (result = verifyModbusWrite(cmd, timeoutMs)) != MB_FRAME_OK)
+    status = result == MB_FRAME_MISMATCH ? CMD_STATUS_VERIFY_FAILED : CMD_STATUS_FAILED;
+  if (result != MB_FRAME_OK && result != MB_FRAME_TIMEOUT)
+    mModbusErrors.inc();
+
+  commandQueue.finish(cmd, status, result);
+  Serial.printf("[CMD] #%u %s unit %u fc %u addr %u -> %s\n", cmd.id, COMMAND_SOURCE_NAMES[cmd.source],
+                cmd.unit, cmd.fc, cmd.addr, COMMAND_STATUS_NAMES[status]);
+}
 
-  return returnValue;
+// Habiskan antrean perintah tulis (HIGH dulu). Hanya dari Task_ModbusClient,
+// di titik preempt yang sama dengan gateway.
+void serviceCommands(const RuntimeConfig *cfg)
+{
+  WriteCommand cmd;
+  while (commandQueue.take(cmd))
+    executeCommand(cmd, cfg->unitTimeoutMs(cmd.unit));
 }
+
 // unsigned int readModbus(unsigned int modbusAddress, unsigned int funCode, unsigned int regAddress)
 // {
 //   unsigned int buffSend[8], crcValue, returnValue;
@@ -4126,9 +2489,8 @@ unsigned int readModbusNonBlocking(unsigned int modbusAddress, unsigned int funC
 // ============================================================================
 unsigned int readModbus(unsigned int modbusAddress, unsigned int funCode, unsigned int regAddress)
 {
-  unsigned int buffSend[8];
-  unsigned int crcValue;
-  unsigned int returnValue = 0;
+  uint8_t buffSend[MODBUS_READ_REQUEST_LEN];
+  uint16_t returnValue = 0;
   byte buffModbus[64];
   int resIndex = 0;
   unsigned long startTime;
@@ -4142,21 +2504,10 @@ unsigned int readModbus(unsigned int modbusAddress, unsigned int funCode, unsign
   }
 
   // 2. Siapkan Request
-  buffSend[0] = modbusAddress;
-  buffSend[1] = funCode;
-  buffSend[2] = parseByte(regAddress, 1);
-  buffSend[3] = parseByte(regAddress, 0);
-  buffSend[4] = 0;
-  buffSend[5] = 1;
-  crcValue = crcModbus(buffSend, 0, 6);
-  buffSend[6] = parseByte(crcValue, 1);
-  buffSend[7] = parseByte(crcValue, 0);
+  modbusBuildReadRequest(buffSend, modbusAddress, funCode, regAddress);
 
   // Kirim Request
-  for (byte j = 0; j < 8; j++)
-  {
-    SerialModbus.write(buffSend[j]);
-  }
+  SerialModbus.write(buffSend, sizeof(buffSend));
   SerialModbus.flush();
 
   // 3. Tunggu Respon (Timeout 200ms)
@@ -4186,60 +2537,17 @@ unsigned int readModbus(unsigned int modbusAddress, unsigned int funCode, unsign
   }
 
   // 5. Validasi & Ambil Data
-  if (resIndex >= 5) // Minimal 5 byte (Addr, FC, ByteCount, DataH, DataL)
+  if (funCode == 3 || funCode == 4)
   {
-    if (buffModbus[0] == modbusAddress && buffModbus[1] == funCode)
-    {
-      if (funCode == 3 || funCode == 4)
-      {
-        returnValue = (buffModbus[3] << 8) | buffModbus[4];
-      }
-    }
+    if (modbusParseReadResponse(buffModbus, resIndex, modbusAddress, funCode, &returnValue) != MB_FRAME_OK)
+      returnValue = 0;
   }
 
   return returnValue;
 }
 
-unsigned int crcModbus(unsigned int crc[], byte start, byte sizeArray)
-{
-  unsigned int crcReg = 0xffff;
-  for (byte j = start; j < sizeArray; j++)
-  {
-    crcReg ^= crc[j];
-    for (byte i = 0; i < 8; i++)
-    {
-      if (crcReg & 1)
-      {
-        crcReg >>= 1;
-        crcReg ^= 0xa001;
-        continue;
-      }
-      crcReg >>= 1;
-    }
-  }
-  unsigned int temp = 0;
-  temp = crcReg & 0xff;
-  crcReg = ((crcReg & 0xff00) >> 8) | (temp << 8);
-  return crcReg;
-}
-
-unsigned int parseByte(unsigned int bytes, bool byteOrder)
-{
-  unsigned int parseResult;
-  if (byteOrder == 0)
-    parseResult = bytes & 0xff;
-  else
-    parseResult = (bytes & 0xff00) >> 8;
-  return parseResult;
-}
-
-float mapFloat(float x, float in_min, float in_max, float out_min, float out_max)
-{
-  float mappedValue = (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
-  return roundf(mappedValue * 100.0) / 100.0;
-}
-
-String getTimeDateNow()
+// Waktu lokal dari RTC, fallback NTP; DateTime(0,...) jika keduanya tidak ada
+DateTime dateTimeNow()
 {
   DateTime now;
   if (rtc.begin())
@@ -4257,21 +2565,33 @@ String getTimeDateNow()
       now = DateTime(timeInfo.tm_year + 1900, timeInfo.tm_mon + 1, timeInfo.tm_mday, timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec);
     }
   }
+  return now;
+}
 
-  char timeBuffer[32];
-  sprintf(timeBuffer, "%04d-%02d-%02d %02d:%02d:%02d", now.year(), now.month(), now.day(), now.hour(), now.minute(), now.second());
-  return String(timeBuffer);
+// Tulis "YYYY-MM-DD HH:MM:SS" ke buf (tanpa heap), kembalikan panjangnya
+size_t formatTimeDateNow(char *buf, size_t len)
+{
+  DateTime now = dateTimeNow();
+  int n = snprintf(buf, len, "%04d-%02d-%02d %02d:%02d:%02d", now.year(), now.month(), now.day(), now.hour(), now.minute(), now.second());
+  return n < 0 ? 0 : ((size_t)n < len ? n : len - 1);
 }
 
-String getTimeNow()
+// Hanya "HH:MM:SS"
+size_t formatTimeNow(char *buf, size_t len)
 {
-  String dateTime = getTimeDateNow();
-  int spaceIndex = dateTime.indexOf(' ');
-  if (spaceIndex != -1)
-  {
-    return dateTime.substring(spaceIndex + 1);
-  }
-  return dateTime;
+  char dateTime[24];
+  formatTimeDateNow(dateTime, sizeof(dateTime));
+  const char *space = strchr(dateTime, ' ');
+  size_t n = strlcpy(buf, space ? space + 1 : dateTime, len);
+  return n < len ? n : len - 1;
+}
+
+// Versi String untuk web handler (di luar loop task)
+String getTimeDateNow()
+{
+  char timeBuffer[24];
+  formatTimeDateNow(timeBuffer, sizeof(timeBuffer));
+  return String(timeBuffer);
 }
 
 void authenthicateUser(AsyncWebServerRequest *request)
@@ -4284,6 +2604,9 @@ void authenthicateUser(AsyncWebServerRequest *request)
 // FILE & CONFIG HANDLING FUNCTIONS
 // ============================================================================
 
+// Import config dari file JSON di SPIFFS ke struct global. Boot normal memakai
+// image biner di NVS (ConfigImage.hpp); fungsi ini hanya untuk migrasi dari
+// firmware lama (image belum ada) dan /configImport.
 void readConfig()
 {
   ESP_LOGI("SPIFFS", "Mounting file system");
@@ -4302,10 +2625,8 @@ void readConfig()
       if (configFile)
       {
         ESP_LOGI("SPIFFS", "Opened network config file");
-        size_t size = configFile.size();
-        std::unique_ptr<char[]> buf(new char[size]);
-        configFile.readBytes(buf.get(), size);
-        auto error = deserializeJson(doc, buf.get());
+        auto error = deserializeJson(doc, configFile);
+        configFile.close();
 
         if (error)
         {
@@ -4363,8 +2684,6 @@ void readConfig()
         temp = doc["erpPassword"];
         networkSettings.erpPassword = String(temp);
 
-        configNetwork();
-        configProtocol();
       }
     }
 
@@ -4378,10 +2697,8 @@ void readConfig()
       if (configFile)
       {
         ESP_LOGI("SPIFFS", "Opened digital input config file");
-        size_t size = configFile.size();
-        std::unique_ptr<char[]> buf(new char[size]);
-        configFile.readBytes(buf.get(), size);
-        auto error = deserializeJson(doc, buf.get());
+        auto error = deserializeJson(doc, configFile);
+        configFile.close();
 
         if (error)
         {
@@ -4415,10 +2732,8 @@ void readConfig()
       if (configFile)
       {
         ESP_LOGI("SPIFFS", "Opened analog input config file");
-        size_t size = configFile.size();
-        std::unique_ptr<char[]> buf(new char[size]);
-        configFile.readBytes(buf.get(), size);
-        auto error = deserializeJson(doc, buf.get());
+        auto error = deserializeJson(doc, configFile);
+        configFile.close();
 
         if (error)
         {
@@ -4454,10 +2769,8 @@ void readConfig()
       if (configFile)
       {
         ESP_LOGI("SPIFFS", "Opened Modbus config file");
-        size_t size = configFile.size();
-        std::unique_ptr<char[]> buf(new char[size]);
-        configFile.readBytes(buf.get(), size);
-        auto error = deserializeJson(jsonParam, buf.get());
+        auto error = deserializeJson(jsonParam, configFile);
+        configFile.close();
 
         if (error)
         {
@@ -4473,32 +2786,6 @@ void readConfig()
         modbusParam.dataBit = jsonParam["dataBit"];
         modbusParam.scanRate = jsonParam["scanRate"];
 
-        // Configure Serial Modbus
-        if (modbusParam.dataBit == 8 and modbusParam.stopBit == 1 and modbusParam.parity == "None")
-          SerialModbus.begin(modbusParam.baudrate, SERIAL_8N1, 17, 16);
-        else if (modbusParam.dataBit == 8 and modbusParam.stopBit == 2 and modbusParam.parity == "None")
-          SerialModbus.begin(modbusParam.baudrate, SERIAL_8N2, 17, 16);
-        else if (modbusParam.dataBit == 8 and modbusParam.stopBit == 1 and modbusParam.parity == "Odd")
-          SerialModbus.begin(modbusParam.baudrate, SERIAL_8O1, 17, 16);
-        else if (modbusParam.dataBit == 8 and modbusParam.stopBit == 2 and modbusParam.parity == "Odd")
-          SerialModbus.begin(modbusParam.baudrate, SERIAL_8O2, 17, 16);
-        else if (modbusParam.dataBit == 8 and modbusParam.stopBit == 1 and modbusParam.parity == "Even")
-          SerialModbus.begin(modbusParam.baudrate, SERIAL_8E1, 17, 16);
-        else if (modbusParam.dataBit == 8 and modbusParam.stopBit == 2 and modbusParam.parity == "Even")
-          SerialModbus.begin(modbusParam.baudrate, SERIAL_8E2, 17, 16);
-        else if (modbusParam.dataBit == 7 and modbusParam.stopBit == 1 and modbusParam.parity == "None")
-          SerialModbus.begin(modbusParam.baudrate, SERIAL_7N1, 17, 16);
-        else if (modbusParam.dataBit == 7 and modbusParam.stopBit == 2 and modbusParam.parity == "None")
-          SerialModbus.begin(modbusParam.baudrate, SERIAL_7N2, 17, 16);
-        else if (modbusParam.dataBit == 7 and modbusParam.stopBit == 1 and modbusParam.parity == "Odd")
-          SerialModbus.begin(modbusParam.baudrate, SERIAL_7O1, 17, 16);
-        else if (modbusParam.dataBit == 7 and modbusParam.stopBit == 2 and modbusParam.parity == "Odd")
-          SerialModbus.begin(modbusParam.baudrate, SERIAL_7O2, 17, 16);
-        else if (modbusParam.dataBit == 7 and modbusParam.stopBit == 1 and modbusParam.parity == "Even")
-          SerialModbus.begin(modbusParam.baudrate, SERIAL_7E1, 17, 16);
-        else if (modbusParam.dataBit == 7 and modbusParam.stopBit == 2 and modbusParam.parity == "Even")
-          SerialModbus.begin(modbusParam.baudrate, SERIAL_7E2, 17, 16);
-
         JsonArray nameData = jsonParam["nameData"];
         numOfParam = nameData.size();
 
@@ -4507,32 +2794,6 @@ void readConfig()
       }
     }
 
-    // Read Runtime Data
-    if (SPIFFS.exists("/runtimeData.json"))
-    {
-      File runtimeFile = SPIFFS.open("/runtimeData.json");
-      doc = DynamicJsonDocument(4096);
-
-      if (runtimeFile)
-      {
-        size_t size = runtimeFile.size();
-        std::unique_ptr<char[]> buf(new char[size]);
-        runtimeFile.readBytes(buf.get(), size);
-        auto error = deserializeJson(doc, buf.get());
-
-        if (!error)
-        {
-          for (int i = 1; i < jumlahInputDigital + 1; i++)
-          {
-            if (digitalInput[i].taskMode == "Run Time")
-            {
-              digitalInput[i].value = doc[String(i)];
-            }
-          }
-        }
-      }
-    }
-
     // Read System Settings
     if (SPIFFS.exists("/systemSettings.json"))
     {
@@ -4541,10 +2802,8 @@ void readConfig()
 
       if (runtimeFile)
       {
-        size_t size = runtimeFile.size();
-        std::unique_ptr<char[]> buf(new char[size]);
-        runtimeFile.readBytes(buf.get(), size);
-        auto error = deserializeJson(doc, buf.get());
+        auto error = deserializeJson(doc, runtimeFile);
+        runtimeFile.close();
 
         if (!error)
         {
@@ -4558,6 +2817,10 @@ void readConfig()
           {
             networkSettings.sdSaveInterval = doc["sdInterval"];
           }
+          if (doc.containsKey("liveInterval"))
+          {
+            networkSettings.liveInterval = doc["liveInterval"];
+          }
         }
       }
     }
@@ -4565,7 +2828,33 @@ void readConfig()
   else
   {
     ESP_LOGE("SPIFFS", "Failed to mount FS");
-    errorMessages.addMessage(getTimeNow() + " - Failed to mount FS");
+    errorMessages.addTimedMessage("Failed to mount FS");
+  }
+}
+
+// Nilai akumulasi DI mode "Run Time" (bukan config, berubah tiap menit)
+void readRuntimeData()
+{
+  bool needed = false;
+  for (int i = 1; i <= jumlahInputDigital; i++)
+    needed |= (digitalInput[i].taskMode == "Run Time");
+  if (!needed || !SPIFFS.exists("/runtimeData.json"))
+    return;
+
+  File runtimeFile = SPIFFS.open("/runtimeData.json");
+  if (!runtimeFile)
+    return;
+
+  DynamicJsonDocument runtime(512);
+  auto error = deserializeJson(runtime, runtimeFile);
+  runtimeFile.close();
+  if (error)
+    return;
+
+  for (int i = 1; i <= jumlahInputDigital; i++)
+  {
+    if (digitalInput[i].taskMode == "Run Time")
+      digitalInput[i].value = runtime[String(i)];
   }
 }
 
@@ -4625,11 +2914,14 @@ void updateJson(const char *dir, const char *jsonKey, int jsonValue)
 
 void handleFileRequest(AsyncWebServerRequest *request, const char *filePath, const char *mimeType)
 {
+  TraceScope trace(TR_WEB_HANDLER);
+  // Aset terdaftar: dikirim gzip + ETag (atau 304 jika browser sudah punya)
+  if (staticAssets.send(request, filePath, mimeType))
+    return;
+
   if (SPIFFS.exists(filePath))
   {
-    File file = SPIFFS.open(filePath, "r");
     request->send(SPIFFS, filePath, mimeType);
-    file.close();
   }
   else
   {
@@ -4637,8 +2929,19 @@ void handleFileRequest(AsyncWebServerRequest *request, const char *filePath, con
   }
 }
 
+// Config diubah dari web: terbitkan snapshot baru (task mengambilnya di titik
+// aman loop masing-masing; mode ISR DI diterapkan Task_DataAcquisition), lalu
+// jadwalkan commit flash.
+// Jangan dipanggil sambil memegang jsonMutex (capture snapshot mengambilnya).
+void configChanged(uint8_t sections)
+{
+  runtimeConfig.publish();
+  configStore.markDirty(sections);
+}
+
 void handleFormSubmit(AsyncWebServerRequest *request)
 {
+  TraceScope trace(TR_WEB_HANDLER);
   Serial.println("Masuk Submit Form");
 
   // ========================================================================
@@ -4690,13 +2993,10 @@ void handleFormSubmit(AsyncWebServerRequest *request)
         modbusParam.slaveID = request->arg("slaveID").toInt();
     }
 
-    configureSendTriggerInterrupt(networkSettings);
-
     request->send(200, "text/plain", "Form data received");
 
-    // Simpan ke Internal & SD Card
-    saveToJson("/configNetwork.json", "network");
-    saveToSDConfig("/configNetwork.json", "network");
+    // Berlaku langsung (uplink, trigger, Modbus slave); IP/WiFi tetap perlu restart
+    configChanged(CFG_NETWORK);
   }
 
   // ========================================================================
@@ -4714,8 +3014,7 @@ void handleFormSubmit(AsyncWebServerRequest *request)
     Serial.print("ERP Password: ");
     Serial.println(networkSettings.erpPassword);
     request->send(200, "text/plain", "Form data received");
-    saveToJson("/configNetwork.json", "network");
-    saveToSDConfig("/configNetwork.json", "network");
+    configStore.markDirty(CFG_NETWORK);
   }
 
   // ========================================================================
@@ -4801,9 +3100,6 @@ void handleFormSubmit(AsyncWebServerRequest *request)
 
           digitalInput[i].taskMode = request->arg("taskMode");
 
-          // Attach ulang interrupt jika perlu
-          attachDigitalInputInterrupt(i);
-
           // Handle Run Time Persistence
           if (digitalInput[i].taskMode == "Run Time")
           {
@@ -4843,10 +3139,8 @@ void handleFormSubmit(AsyncWebServerRequest *request)
       }
       xSemaphoreGive(jsonMutex); // Lepas Mutex
     }
-    configureSendTriggerInterrupt(networkSettings);
     request->send(200, "text/plain", "Digital Config Saved");
-    saveToJson("/configDigital.json", "digital");
-    saveToSDConfig("/configDigital.json", "digital");
+    configChanged(CFG_DIGITAL); // snapshot baru + mode ISR diterapkan ulang
   }
 
   // ========================================================================
@@ -4872,9 +3166,7 @@ void handleFormSubmit(AsyncWebServerRequest *request)
     }
     request->send(200, "text/plain", "Form data received");
 
-    // Simpan ke Internal & SD Card
-    saveToJson("/configAnalog.json", "analog");
-    saveToSDConfig("/configAnalog.json", "analog"); // <--- 
+    configChanged(CFG_ANALOG);
   }
 
   // ========================================================================
@@ -4891,15 +3183,18 @@ void handleFormSubmit(AsyncWebServerRequest *request)
     request->send(200, "text/plain", "Form data received");
 
     // Update JSON global 'jsonParam' agar sinkron
-    jsonParam["baudrate"] = modbusParam.baudrate;
-    jsonParam["parity"] = modbusParam.parity;
-    jsonParam["stopBit"] = modbusParam.stopBit;
-    jsonParam["dataBit"] = modbusParam.dataBit;
-    jsonParam["scanRate"] = modbusParam.scanRate;
-
-    // Simpan ke Internal & SD Card
-    saveToJson("/modbusSetup.json", "modbusSetup");
-    saveToSDConfig("/modbusSetup.json", "modbusSetup"); // <--- 
+    if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(1000)))
+    {
+      jsonParam["baudrate"] = modbusParam.baudrate;
+      jsonParam["parity"] = modbusParam.parity;
+      jsonParam["stopBit"] = modbusParam.stopBit;
+      jsonParam["dataBit"] = modbusParam.dataBit;
+      jsonParam["scanRate"] = modbusParam.scanRate;
+      xSemaphoreGive(jsonMutex);
+    }
+
+    // Port RS-485 dibuka ulang oleh Task_ModbusClient, tanpa restart
+    configChanged(CFG_MODBUS);
   }
 
   // ========================================================================
@@ -4925,258 +3220,112 @@ void handleFormSubmit(AsyncWebServerRequest *request)
     {
       networkSettings.sdSaveInterval = request->arg("sdInterval").toInt();
     }
-
-    request->send(200, "text/plain", "Form data received");
-
-    // Simpan ke Internal & SD Card
-    saveToJson("/systemSettings.json", "systemSettings");
-    saveToSDConfig("/systemSettings.json", "systemSettings"); // <--- 
-  }
-  else
-  {
-    request->send(400, "text/plain", "Bad Request");
-  }
-}
-
-void saveToJson(const char *dir, const char *configType)
-{
-  // 1. Pastikan ambil Mutex dulu agar tidak bentrok dengan pembacaan sensor
-  if (xSemaphoreTake(jsonMutex, pdMS_TO_TICKS(1000)))
-  {
-    // Gunakan buffer cukup besar (4KB) untuk menampung JSON config
-    DynamicJsonDocument docSave(4096);
-    String type = String(configType);
-
-    // ========================================================
-    // A. CONFIG NETWORK
-    // ========================================================
-    if (type == "network")
-    {
-      docSave["networkMode"] = networkSettings.networkMode;
-      docSave["ssid"] = networkSettings.ssid;
-      docSave["password"] = networkSettings.password;
-      docSave["apSsid"] = networkSettings.apSsid;
-      docSave["apPassword"] = networkSettings.apPassword;
-      docSave["dhcpMode"] = networkSettings.dhcpMode;
-      docSave["ipAddress"] = networkSettings.ipAddress;
-      docSave["subnet"] = networkSettings.subnetMask;
-      docSave["ipGateway"] = networkSettings.ipGateway;
-      docSave["ipDNS"] = networkSettings.ipDNS;
-      docSave["sendInterval"] = networkSettings.sendInterval;
-      docSave["protocolMode"] = networkSettings.protocolMode;
-      docSave["endpoint"] = networkSettings.endpoint;
-      docSave["port"] = networkSettings.port;
-      docSave["pubTopic"] = networkSettings.pubTopic;
-      docSave["subTopic"] = networkSettings.subTopic;
-      docSave["mqttUsername"] = networkSettings.mqttUsername;
-      docSave["mqttPass"] = networkSettings.mqttPassword;
-      docSave["loggerMode"] = networkSettings.loggerMode;
-      docSave["protocolMode2"] = networkSettings.protocolMode2;
-      docSave["modbusMode"] = modbusParam.mode;
-      docSave["modbusPort"] = modbusParam.port;
-      docSave["modbusSlaveID"] = modbusParam.slaveID;
-      docSave["sendTrig"] = networkSettings.sendTrig;
-      docSave["erpUrl"] = networkSettings.erpUrl;
-      docSave["erpUsername"] = networkSettings.erpUsername;
-      docSave["erpPassword"] = networkSettings.erpPassword;
-    }
-    // ========================================================
-    // B. CONFIG DIGITAL
-    // ========================================================
-    else if (type == "digital")
-    {
-      for (unsigned char i = 1; i <= jumlahInputDigital; i++)
-      {
-        // Membuat object seperti "DI1": { ... }
-        JsonObject diObj = docSave.createNestedObject("DI" + String(i));
-        diObj["name"] = digitalInput[i].name;
-        diObj["invers"] = digitalInput[i].inv;
-        diObj["taskMode"] = digitalInput[i].taskMode;
-        diObj["inputState"] = digitalInput[i].inputState ? "High" : "Low";
-        diObj["intervalTime"] = digitalInput[i].intervalTime;
-        diObj["conversionFactor"] = digitalInput[i].conversionFactor;
-      }
-    }
-    // ========================================================
-    // C. CONFIG ANALOG
-    // ========================================================
-    else if (type == "analog")
-    {
-      for (unsigned char i = 1; i <= jumlahInputAnalog; i++)
-      {
-        JsonObject aiObj = docSave.createNestedObject("AI" + String(i));
-        aiObj["name"] = analogInput[i].name;
-        aiObj["inputType"] = analogInput[i].inputType;
-        aiObj["filter"] = analogInput[i].filter;
-        aiObj["filterPeriod"] = analogInput[i].filterPeriod;
-        aiObj["scaling"] = analogInput[i].scaling;
-        aiObj["lowLimit"] = analogInput[i].lowLimit;
-        aiObj["highLimit"] = analogInput[i].highLimit;
-        aiObj["calibration"] = analogInput[i].calibration;
-        aiObj["mValue"] = analogInput[i].mValue;
-        aiObj["cValue"] = analogInput[i].cValue;
-      }
-    }
-    // ========================================================
-    // D. CONFIG MODBUS SETUP
-    // ========================================================
-    else if (type == "modbusSetup")
-    {
-      docSave = jsonParam;
-    }
-    // ========================================================
-    // E. SYSTEM SETTINGS
-    // ========================================================
-    else if (type == "systemSettings")
+    if (request->hasArg("liveInterval"))
     {
-      docSave["username"] = networkSettings.loginUsername;
-      docSave["password"] = networkSettings.loginPassword;
-      docSave["sdInterval"] = networkSettings.sdSaveInterval;
+      networkSettings.liveInterval = constrain(request->arg("liveInterval").toInt(), 250, 10000);
     }
 
-    // ========================================================
-    // WRITE TO FILE (SPIFFS)
-    // ========================================================
-    File file = SPIFFS.open(dir, "w");
-    if (!file)
-    {
-      Serial.printf("❌ Failed to open file for writing: %s\n", dir);
-    }
-    else
-    {
-      if (serializeJson(docSave, file) == 0)
-      {
-        Serial.println("❌ Failed to write JSON content");
-      }
-      else
-      {
-        Serial.printf("✅ Config Saved: %s\n", dir);
-      }
-      file.close();
-    }
+    request->send(200, "text/plain", "Form data received");
 
-    // PENTING: Lepaskan Mutex setelah selesai!
-    xSemaphoreGive(jsonMutex);
+    // Commit (NVS + SPIFFS + SD) ditunda & digabung oleh configStore
+    configStore.markDirty(CFG_SYSTEM);
   }
   else
   {
-    Serial.println("⚠️ Save skipped: jsonMutex busy");
+    request->send(400, "text/plain", "Bad Request");
   }
 }
 
-void saveToSDConfig(const char *dir, const char *configType)
+// Bangun dokumen JSON satu jenis config dari struct global.
+// Dipakai ConfigStore (file SPIFFS + mirror SD) dan /configExport.
+void buildConfigJson(const String &type, JsonDocument &out)
 {
-  // Cek apakah SD Card siap (gunakan flag global jika ada, atau mutex)
-  if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(1000)))
-  {
-    Serial.printf("[SD] Saving config: %s ...\n", dir);
-
-    // Hapus file lama agar data bersih (overwrite)
-    if (SD.exists(dir))
-    {
-      SD.remove(dir);
-    }
-
-    DynamicJsonDocument docSD(4096);
-
-    // 1. NETWORK CONFIG
-    if (String(configType) == "network")
-    {
-      docSD["networkMode"] = networkSettings.networkMode;
-      docSD["ssid"] = networkSettings.ssid;
-      docSD["password"] = networkSettings.password;
-      docSD["apSsid"] = networkSettings.apSsid;
-      docSD["apPassword"] = networkSettings.apPassword;
-      docSD["dhcpMode"] = networkSettings.dhcpMode;
-      docSD["ipAddress"] = networkSettings.ipAddress;
-      docSD["subnet"] = networkSettings.subnetMask;
-      docSD["ipGateway"] = networkSettings.ipGateway;
-      docSD["ipDNS"] = networkSettings.ipDNS;
-      docSD["sendInterval"] = networkSettings.sendInterval;
-      docSD["protocolMode"] = networkSettings.protocolMode;
-      docSD["endpoint"] = networkSettings.endpoint;
-      docSD["port"] = networkSettings.port;
-      docSD["pubTopic"] = networkSettings.pubTopic;
-      docSD["subTopic"] = networkSettings.subTopic;
-      docSD["mqttUsername"] = networkSettings.mqttUsername;
-      docSD["mqttPass"] = networkSettings.mqttPassword;
-      docSD["loggerMode"] = networkSettings.loggerMode;
-      docSD["protocolMode2"] = networkSettings.protocolMode2;
-      docSD["modbusMode"] = modbusParam.mode;
-      docSD["modbusPort"] = modbusParam.port;
-      docSD["modbusSlaveID"] = modbusParam.slaveID;
-      docSD["sendTrig"] = networkSettings.sendTrig;
-      docSD["erpUrl"] = networkSettings.erpUrl;
-      docSD["erpUsername"] = networkSettings.erpUsername;
-      docSD["erpPassword"] = networkSettings.erpPassword;
-    }
-    // 2. DIGITAL INPUT CONFIG
-    else if (String(configType) == "digital")
-    {
-      for (unsigned char i = 1; i < jumlahInputDigital + 1; i++)
-      {
-        docSD["DI" + String(i)]["name"] = digitalInput[i].name;
-        docSD["DI" + String(i)]["invers"] = digitalInput[i].inv;
-        docSD["DI" + String(i)]["taskMode"] = digitalInput[i].taskMode;
-        docSD["DI" + String(i)]["inputState"] = digitalInput[i].inputState ? "High" : "Low";
-        docSD["DI" + String(i)]["intervalTime"] = digitalInput[i].intervalTime;
-        docSD["DI" + String(i)]["conversionFactor"] = digitalInput[i].conversionFactor;
-      }
-    }
-    // 3. ANALOG INPUT CONFIG
-    else if (String(configType) == "analog")
-    {
-      for (unsigned char i = 1; i < jumlahInputAnalog + 1; i++)
-      {
-        docSD["AI" + String(i)]["name"] = analogInput[i].name;
-        docSD["AI" + String(i)]["inputType"] = analogInput[i].inputType;
-        docSD["AI" + String(i)]["filter"] = analogInput[i].filter;
-        docSD["AI" + String(i)]["filterPeriod"] = analogInput[i].filterPeriod;
-        docSD["AI" + String(i)]["scaling"] = analogInput[i].scaling;
-        docSD["AI" + String(i)]["lowLimit"] = analogInput[i].lowLimit;
-        docSD["AI" + String(i)]["highLimit"] = analogInput[i].highLimit;
-        docSD["AI" + String(i)]["calibration"] = analogInput[i].calibration;
-        docSD["AI" + String(i)]["mValue"] = analogInput[i].mValue;
-        docSD["AI" + String(i)]["cValue"] = analogInput[i].cValue;
-      }
-    }
-    // 4. MODBUS SETUP (Menggunakan jsonParam global yang sudah diupdate)
-    else if (String(configType) == "modbusSetup")
-    {
-      docSD = jsonParam;
-    }
-    // 5. SYSTEM SETTINGS
-    else if (String(configType) == "systemSettings")
-    {
-      docSD["username"] = networkSettings.loginUsername;
-      docSD["password"] = networkSettings.loginPassword;
-      docSD["sdInterval"] = networkSettings.sdSaveInterval;
-    }
-
-    // Tulis ke SD Card
-    File file = SD.open(dir, FILE_WRITE);
-    if (file)
-    {
-      if (serializeJson(docSD, file) == 0)
-      {
-        Serial.println("  ✗ Failed to write config to SD");
-      }
-      else
-      {
-        Serial.println("  ✓ Config saved to SD Card");
-      }
-      file.close();
-    }
-    else
-    {
-      Serial.println("  ✗ Failed to open file on SD Card");
-    }
-
-    xSemaphoreGive(sdMutex);
-  }
-  else
-  {
-    Serial.println("  ⚠ SD Card Busy (Mutex), Config NOT saved to SD.");
+  // ========================================================
+  // A. CONFIG NETWORK
+  // ========================================================
+  if (type == "network")
+  {
+    out["networkMode"] = networkSettings.networkMode;
+    out["ssid"] = networkSettings.ssid;
+    out["password"] = networkSettings.password;
+    out["apSsid"] = networkSettings.apSsid;
+    out["apPassword"] = networkSettings.apPassword;
+    out["dhcpMode"] = networkSettings.dhcpMode;
+    out["ipAddress"] = networkSettings.ipAddress;
+    out["subnet"] = networkSettings.subnetMask;
+    out["ipGateway"] = networkSettings.ipGateway;
+    out["ipDNS"] = networkSettings.ipDNS;
+    out["sendInterval"] = networkSettings.sendInterval;
+    out["protocolMode"] = networkSettings.protocolMode;
+    out["endpoint"] = networkSettings.endpoint;
+    out["port"] = networkSettings.port;
+    out["pubTopic"] = networkSettings.pubTopic;
+    out["subTopic"] = networkSettings.subTopic;
+    out["mqttUsername"] = networkSettings.mqttUsername;
+    out["mqttPass"] = networkSettings.mqttPassword;
+    out["loggerMode"] = networkSettings.loggerMode;
+    out["protocolMode2"] = networkSettings.protocolMode2;
+    out["modbusMode"] = modbusParam.mode;
+    out["modbusPort"] = modbusParam.port;
+    out["modbusSlaveID"] = modbusParam.slaveID;
+    out["sendTrig"] = networkSettings.sendTrig;
+    out["erpUrl"] = networkSettings.erpUrl;
+    out["erpUsername"] = networkSettings.erpUsername;
+    out["erpPassword"] = networkSettings.erpPassword;
+  }
+  // ========================================================
+  // B. CONFIG DIGITAL
+  // ========================================================
+  else if (type == "digital")
+  {
+    for (unsigned char i = 1; i <= jumlahInputDigital; i++)
+    {
+      // Membuat object seperti "DI1": { ... }
+      JsonObject diObj = out.createNestedObject("DI" + String(i));
+      diObj["name"] = digitalInput[i].name;
+      diObj["invers"] = digitalInput[i].inv;
+      diObj["taskMode"] = digitalInput[i].taskMode;
+      diObj["inputState"] = digitalInput[i].inputState ? "High" : "Low";
+      diObj["intervalTime"] = digitalInput[i].intervalTime;
+      diObj["conversionFactor"] = digitalInput[i].conversionFactor;
+    }
+  }
+  // ========================================================
+  // C. CONFIG ANALOG
+  // ========================================================
+  else if (type == "analog")
+  {
+    for (unsigned char i = 1; i <= jumlahInputAnalog; i++)
+    {
+      JsonObject aiObj = out.createNestedObject("AI" + String(i));
+      aiObj["name"] = analogInput[i].name;
+      aiObj["inputType"] = analogInput[i].inputType;
+      aiObj["filter"] = analogInput[i].filter;
+      aiObj["filterPeriod"] = analogInput[i].filterPeriod;
+      aiObj["scaling"] = analogInput[i].scaling;
+      aiObj["lowLimit"] = analogInput[i].lowLimit;
+      aiObj["highLimit"] = analogInput[i].highLimit;
+      aiObj["calibration"] = analogInput[i].calibration;
+      aiObj["mValue"] = analogInput[i].mValue;
+      aiObj["cValue"] = analogInput[i].cValue;
+    }
+  }
+  // ========================================================
+  // D. CONFIG MODBUS SETUP
+  // ========================================================
+  else if (type == "modbusSetup")
+  {
+    out.set(jsonParam);
+  }
+  // ========================================================
+  // E. SYSTEM SETTINGS
+  // ========================================================
+  else if (type == "systemSettings")
+  {
+    out["username"] = networkSettings.loginUsername;
+    out["password"] = networkSettings.loginPassword;
+    out["sdInterval"] = networkSettings.sdSaveInterval;
+    out["liveInterval"] = networkSettings.liveInterval;
   }
 }
 
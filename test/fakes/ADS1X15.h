@@ -0,0 +1,39 @@
+#ifndef FAKE_ADS1X15_H
+#define FAKE_ADS1X15_H
+
+#include <functional>
+#include "Arduino.h"
+
+// ============================================================================
+// ADS1115 PALSU (API robtillaart/ADS1X15 yang dipakai firmware)
+// readADC(ch) mengembalikan raw[ch] atau source(ch, waktu) jika diisi
+// (gelombang skrip), dan memajukan jam satu periode konversi (860 SPS).
+// ============================================================================
+class ADS1115
+{
+public:
+  explicit ADS1115(uint8_t address = 0x48, void *wire = NULL) { (void)address, (void)wire; }
+  bool begin() { return true; }
+  bool isConnected() { return true; }
+  void setGain(uint8_t gain) { _gain = gain; }
+  uint8_t getGain() const { return _gain; }
+  void setDataRate(uint8_t rate) { (void)rate; }
+
+  int16_t readADC(uint8_t ch)
+  {
+    fakeAdvanceUs(1163); // 1 / 860 SPS
+    reads++;
+    if (source)
+      return source(ch, fakeNowUs());
+    return ch < 4 ? raw[ch] : 0;
+  }
+
+  int16_t raw[4] = {};
+  std::function<int16_t(uint8_t, int64_t)> source;
+  uint32_t reads = 0;
+
+private:
+  uint8_t _gain = 0;
+};
+
+#endif
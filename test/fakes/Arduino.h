@@ -0,0 +1,52 @@
+#ifndef FAKE_ARDUINO_H
+#define FAKE_ARDUINO_H
+
+// ============================================================================
+// ARDUINO HAL PALSU (env:native)
+// Cukup untuk header firmware yang dikompilasi di host: jam virtual
+// (FakeClock.h), Print/Stream/String, UART palsu (HardwareSerial.h) dan
+// Serial konsol. Bukan emulator ESP32: yang tidak dipakai test tidak ada.
+// ============================================================================
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FakeClock.h"
+#include "Print.h"
+#include "Stream.h"
+#include "WString.h"
+#include "HardwareSerial.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef uint8_t byte;
+
+// newlib ESP32 punya strlcpy; glibc baru sejak 2.38
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+inline size_t strlcpy(char *dst, const char *src, size_t size)
+{
+  size_t len = strlen(src);
+  if (size)
+  {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = 0;
+  }
+  return len;
+}
+#endif
+
+inline unsigned long millis() { return (unsigned long)(fakeNowUs() / 1000); }
+inline unsigned long micros() { return (unsigned long)fakeNowUs(); }
+inline void delay(unsigned long ms) { fakeAdvanceUs((int64_t)ms * 1000); }
+inline void delayMicroseconds(unsigned int us) { fakeAdvanceUs(us); }
+
+template <class T>
+inline T constrain(T v, T lo, T hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+// Konsol: echo ke stdout, isi juga tersimpan di Serial.tx
+static HardwareSerial Serial(true);
+
+#endif
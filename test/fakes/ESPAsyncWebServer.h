@@ -0,0 +1,75 @@
+#ifndef FAKE_ESP_ASYNC_WEB_SERVER_H
+#define FAKE_ESP_ASYNC_WEB_SERVER_H
+
+#include <functional>
+#include <vector>
+#include <string>
+#include <Arduino.h>
+
+// ============================================================================
+// ESPAsyncWebServer PALSU (env:native)
+// Hanya request/response yang dipakai handler yang diuji: send() langsung dan
+// response chunked. Test menarik isi chunked lewat drain() dengan ukuran
+// buffer kecil, jadi jalur "buffer penuh, lanjut di panggilan berikutnya"
+// ikut teruji seperti di async_tcp.
+// ============================================================================
+
+typedef std::function<size_t(uint8_t *buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+class AsyncWebServerResponse
+{
+public:
+  AsyncWebServerResponse(const char *contentType, AwsResponseFiller filler) : contentType(contentType), filler(filler) {}
+
+  void addHeader(const char *name, const char *value) { headers += std::string(name) + ": " + value + "\n"; }
+
+  // Panggil filler sampai mengembalikan 0 (akhir response)
+  std::string drain(size_t chunk = 256)
+  {
+    std::string body;
+    std::vector<uint8_t> buf(chunk);
+    size_t n;
+    while ((n = filler(buf.data(), chunk, body.size())) > 0)
+    {
+      body.append((const char *)buf.data(), n);
+      chunks++;
+    }
+    return body;
+  }
+
+  std::string contentType;
+  std::string headers;
+  AwsResponseFiller filler;
+  size_t chunks = 0;
+};
+
+class AsyncWebServerRequest
+{
+public:
+  ~AsyncWebServerRequest() { delete response; }
+
+  AsyncWebServerResponse *beginChunkedResponse(const char *contentType, AwsResponseFiller filler)
+  {
+    return new AsyncWebServerResponse(contentType, filler);
+  }
+
+  void send(AsyncWebServerResponse *r)
+  {
+    delete response;
+    response = r;
+    code = 200;
+  }
+
+  void send(int status, const char *contentType, const char *content)
+  {
+    code = status;
+    body = content;
+    (void)contentType;
+  }
+
+  int code = 0;
+  std::string body;
+  AsyncWebServerResponse *response = nullptr;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef FAKE_FS_H
+#define FAKE_FS_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+// ============================================================================
+// FILESYSTEM PALSU (SD / SPIFFS di RAM)
+// File menulis langsung ke isi di map FS; flushes menghitung File.flush()
+// supaya test bisa memeriksa pola sync ke kartu.
+// ============================================================================
+namespace fs
+{
+  struct FileData
+  {
+    std::string bytes;
+    uint32_t flushes = 0;
+  };
+
+  class File : public Stream
+  {
+  public:
+    File() {}
+    File(std::shared_ptr<FileData> data, bool write) : _data(data), _write(write) {}
+
+    explicit operator bool() const { return (bool)_data; }
+    size_t size() const { return _data ? _data->bytes.size() : 0; }
+    size_t position() const { return _pos; }
+    bool seek(size_t pos)
+    {
+      _pos = pos;
+      return _data && pos <= _data->bytes.size();
+    }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t len) override
+    {
+      if (!_data || !_write)
+        return 0;
+      _data->bytes.append((const char *)buf, len);
+      return len;
+    }
+    void flush() override
+    {
+      if (_data)
+        _data->flushes++;
+    }
+
+    int available() override { return _data ? (int)(_data->bytes.size() - _pos) : 0; }
+    int read() override { return available() > 0 ? (uint8_t)_data->bytes[_pos++] : -1; }
+    int peek() override { return available() > 0 ? (uint8_t)_data->bytes[_pos] : -1; }
+    size_t read(uint8_t *buf, size_t len)
+    {
+      size_t n = 0;
+      while (n < len && available() > 0)
+        buf[n++] = (uint8_t)read();
+      return n;
+    }
+
+    void close() { _data.reset(); }
+
+  private:
+    std::shared_ptr<FileData> _data;
+    size_t _pos = 0;
+    bool _write = false;
+  };
+
+  class FS
+  {
+  public:
+    File open(const char *path, const char *mode = FILE_READ)
+    {
+      std::shared_ptr<FileData> &data = _files[path];
+      bool write = mode[0] == 'w' || mode[0] == 'a';
+      if (!data)
+      {
+        if (!write)
+        {
+          _files.erase(path);
+          return File();
+        }
+        data = std::make_shared<FileData>();
+      }
+      if (mode[0] == 'w')
+        data->bytes.clear();
+      return File(data, write);
+    }
+    bool exists(const char *path) const { return _files.count(path) > 0; }
+    bool remove(const char *path) { return _files.erase(path) > 0; }
+
+    // Akses langsung untuk assert di test
+    std::shared_ptr<FileData> data(const char *path) { return _files.count(path) ? _files[path] : nullptr; }
+    void format() { _files.clear(); }
+
+  private:
+    std::map<std::string, std::shared_ptr<FileData>> _files;
+  };
+}
+
+using fs::File;
+
+#endif
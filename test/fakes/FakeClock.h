@@ -0,0 +1,56 @@
+#ifndef FAKE_CLOCK_H
+#define FAKE_CLOCK_H
+
+#include <stdint.h>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// FAKE CLOCK (env:native)
+// Satu jam virtual untuk millis() / micros() / esp_timer_get_time(). Waktu
+// hanya maju lewat delay(), vTaskDelay(), flush() UART palsu, atau
+// fakeAdvanceUs() dari test, jadi timeout & jeda t3.5 deterministik.
+// Listener dipanggil tiap jam maju (mis. slave palsu menjadwalkan balasan).
+// Mode real-time (harness test/sim lewat pty): jam mengikuti steady_clock dan
+// fakeAdvanceUs() benar-benar sleep.
+// ============================================================================
+
+inline bool &fakeClockRealtime()
+{
+  static bool realtime = false;
+  return realtime;
+}
+
+inline int64_t &fakeNowUs()
+{
+  static int64_t now = 0;
+  if (fakeClockRealtime())
+    now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  return now;
+}
+
+inline std::vector<std::function<void(int64_t)>> &fakeClockListeners()
+{
+  static std::vector<std::function<void(int64_t)>> listeners;
+  return listeners;
+}
+
+inline void fakeAdvanceUs(int64_t us)
+{
+  if (fakeClockRealtime())
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  else
+    fakeNowUs() += us;
+  for (auto &l : fakeClockListeners())
+    l(fakeNowUs());
+}
+
+inline void fakeClockReset()
+{
+  fakeNowUs() = 0;
+  fakeClockListeners().clear();
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef FAKE_HARDWARE_SERIAL_H
+#define FAKE_HARDWARE_SERIAL_H
+
+#include <deque>
+#include <functional>
+#include <vector>
+#include "Stream.h"
+#include "FakeClock.h"
+
+#define SERIAL_8N1 0x800001c
+#define SERIAL_8N2 0x800003c
+#define SERIAL_8E1 0x800001e
+#define SERIAL_8E2 0x800003e
+#define SERIAL_8O1 0x800001f
+#define SERIAL_8O2 0x800003f
+#define SERIAL_7N1 0x8000018
+#define SERIAL_7N2 0x8000038
+#define SERIAL_7E1 0x800001a
+#define SERIAL_7E2 0x800003a
+#define SERIAL_7O1 0x800001b
+#define SERIAL_7O2 0x800003b
+
+// ============================================================================
+// UART PALSU
+// RX: byte dijadwalkan dengan waktu tiba (jam virtual); available() hanya
+// menghitung byte yang sudah "tiba". TX: write() disimpan & diteruskan ke
+// onTransmit (slave palsu), flush() memajukan jam selama waktu kirim (10 bit
+// per karakter). Serial (konsol) memakai kelas yang sama dengan echo ke stdout.
+// ============================================================================
+class HardwareSerial : public Stream
+{
+public:
+  explicit HardwareSerial(bool echo = false) : _echo(echo) {}
+
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rx = -1, int8_t tx = -1)
+  {
+    (void)config, (void)rx, (void)tx;
+    _baud = baud;
+    _open = true;
+  }
+  void begin(unsigned long baud, uint32_t config, int rx, int tx) { begin(baud, config, (int8_t)rx, (int8_t)tx); }
+  void end() { _open = false; }
+  bool isOpen() const { return _open; }
+  unsigned long baudrate() const { return _baud; }
+
+  // Waktu satu karakter (start + 8 data + stop) di baud sekarang
+  int64_t charUs() const { return _baud ? 10000000LL / _baud : 0; }
+
+  // Jadwalkan byte masuk mulai atUs, berjarak satu karakter
+  void inject(const uint8_t *data, size_t len, int64_t atUs)
+  {
+    for (size_t i = 0; i < len; i++)
+      _rx.push_back(RxByte{atUs + (int64_t)i * charUs(), data[i]});
+  }
+  void inject(const std::vector<uint8_t> &data, int64_t atUs) { inject(data.data(), data.size(), atUs); }
+
+  int available() override
+  {
+    int n = 0;
+    for (const RxByte &b : _rx)
+    {
+      if (b.atUs > fakeNowUs())
+        break;
+      n++;
+    }
+    return n;
+  }
+  int read() override
+  {
+    if (!available())
+      return -1;
+    uint8_t c = _rx.front().c;
+    _rx.pop_front();
+    return c;
+  }
+  int peek() override { return available() ? _rx.front().c : -1; }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *data, size_t size) override
+  {
+    if (_echo)
+      fwrite(data, 1, size, stdout);
+    tx.insert(tx.end(), data, data + size);
+    _pending += size;
+    if (onTransmit)
+      onTransmit(data, size);
+    return size;
+  }
+  void flush() override
+  {
+    fakeAdvanceUs(_pending * charUs());
+    _pending = 0;
+  }
+
+  std::vector<uint8_t> tx;                               // semua byte terkirim
+  std::function<void(const uint8_t *, size_t)> onTransmit; // request ke slave palsu
+
+private:
+  struct RxByte
+  {
+    int64_t atUs;
+    uint8_t c;
+  };
+  std::deque<RxByte> _rx;
+  unsigned long _baud = 0;
+  size_t _pending = 0;
+  bool _echo;
+  bool _open = false;
+};
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef FAKE_SD_H
+#define FAKE_SD_H
+
+#include "FS.h"
+
+class SDFS : public fs::FS
+{
+public:
+  bool begin(uint8_t csPin = 5) { (void)csPin; return true; }
+  void end() {}
+};
+
+static SDFS SD;
+
+#endif
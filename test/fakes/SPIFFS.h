@@ -0,0 +1,15 @@
+#ifndef FAKE_SPIFFS_H
+#define FAKE_SPIFFS_H
+
+#include "FS.h"
+
+class SPIFFSFS : public fs::FS
+{
+public:
+  bool begin(bool formatOnFail = false) { (void)formatOnFail; return true; }
+  void end() {}
+};
+
+static SPIFFSFS SPIFFS;
+
+#endif
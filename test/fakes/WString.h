@@ -0,0 +1,47 @@
+#ifndef FAKE_WSTRING_H
+#define FAKE_WSTRING_H
+
+#include <stdlib.h>
+#include <string>
+
+// String Arduino minimal (std::string di belakangnya), cukup untuk field
+// config seperti networkSettings.ipAddress
+class String
+{
+public:
+  String(const char *s = "") : _s(s ? s : "") {}
+  String(const std::string &s) : _s(s) {}
+  explicit String(int v) : _s(std::to_string(v)) {}
+
+  const char *c_str() const { return _s.c_str(); }
+  unsigned length() const { return _s.size(); }
+  char charAt(unsigned i) const { return i < _s.size() ? _s[i] : 0; }
+  int indexOf(const char *s) const
+  {
+    size_t p = _s.find(s);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  bool startsWith(const char *s) const { return _s.compare(0, strlen(s), s) == 0; }
+  String substring(unsigned from, unsigned to) const { return from < _s.size() ? String(_s.substr(from, to - from)) : String(); }
+  String substring(unsigned from) const { return substring(from, _s.size()); }
+  long toInt() const { return atol(_s.c_str()); }
+  bool concat(const char *s)
+  {
+    _s += s;
+    return true;
+  }
+  String &operator+=(const String &o)
+  {
+    _s += o._s;
+    return *this;
+  }
+  bool operator==(const char *s) const { return _s == s; }
+  bool operator==(const String &o) const { return _s == o._s; }
+  bool operator!=(const char *s) const { return _s != s; }
+  friend String operator+(const String &a, const String &b) { return String(a._s + b._s); }
+
+private:
+  std::string _s;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef FAKE_WIFI_H
+#define FAKE_WIFI_H
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <Arduino.h>
+
+// ============================================================================
+// WiFi PALSU (env:native, Linux)
+// WiFiClient di atas socket TCP host, cukup untuk menguji client Modbus TCP
+// terhadap simulator lokal (127.0.0.1). Perilaku mengikuti WiFiClient ESP32:
+// connect() blocking dengan timeout, read/available/write non-blocking,
+// connected() false setelah peer menutup koneksi.
+// ============================================================================
+
+class IPAddress
+{
+public:
+  IPAddress(uint32_t addr = 0) : _addr(addr) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+  {
+    uint8_t bytes[4] = {a, b, c, d};
+    memcpy(&_addr, bytes, 4); // octet pertama di byte terendah, seperti ESP32
+  }
+  operator uint32_t() const { return _addr; }
+
+private:
+  uint32_t _addr;
+};
+
+class WiFiClient
+{
+public:
+  ~WiFiClient() { stop(); }
+
+  int connect(IPAddress ip, uint16_t port, int32_t timeoutMs)
+  {
+    stop();
+    _fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_fd < 0)
+      return 0;
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = (uint32_t)ip; // sudah urutan jaringan
+    if (::connect(_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+      struct pollfd p = {_fd, POLLOUT, 0};
+      int err = 0;
+      socklen_t len = sizeof(err);
+      if (errno != EINPROGRESS || poll(&p, 1, timeoutMs) != 1 ||
+          getsockopt(_fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0)
+      {
+        stop();
+        return 0;
+      }
+    }
+    return 1;
+  }
+
+  int setNoDelay(bool on)
+  {
+    int v = on;
+    return setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v));
+  }
+
+  uint8_t connected()
+  {
+    if (_fd < 0)
+      return 0;
+    uint8_t c;
+    ssize_t n = recv(_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)))
+      return 1;
+    stop(); // EOF / error
+    return 0;
+  }
+
+  int available()
+  {
+    int n = 0;
+    return _fd >= 0 && ioctl(_fd, FIONREAD, &n) == 0 ? n : 0;
+  }
+
+  int read(uint8_t *buf, size_t size)
+  {
+    if (_fd < 0)
+      return -1;
+    ssize_t n = recv(_fd, buf, size, MSG_DONTWAIT);
+    return n > 0 ? (int)n : -1;
+  }
+
+  size_t write(const uint8_t *buf, size_t size)
+  {
+    if (_fd < 0)
+      return 0;
+    ssize_t n = send(_fd, buf, size, MSG_NOSIGNAL);
+    return n > 0 ? (size_t)n : 0;
+  }
+
+  void stop()
+  {
+    if (_fd >= 0)
+      ::close(_fd);
+    _fd = -1;
+  }
+
+private:
+  int _fd = -1;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef FAKE_DRIVER_UART_H
+#define FAKE_DRIVER_UART_H
+
+#include "../freertos/FreeRTOS.h"
+
+typedef int uart_port_t;
+typedef int esp_err_t;
+#define ESP_OK 0
+#define UART_PIN_NO_CHANGE (-1)
+
+typedef enum
+{
+  UART_MODE_UART = 0,
+  UART_MODE_RS485_HALF_DUPLEX
+} uart_mode_t;
+
+// Pin & mode half-duplex tidak berpengaruh pada UART palsu
+inline esp_err_t uart_set_pin(uart_port_t, int, int, int, int) { return ESP_OK; }
+inline esp_err_t uart_set_mode(uart_port_t, uart_mode_t) { return ESP_OK; }
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef FAKE_ESP_TIMER_H
+#define FAKE_ESP_TIMER_H
+
+#include "FakeClock.h"
+
+inline int64_t esp_timer_get_time() { return fakeNowUs(); }
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef FAKE_FREERTOS_H
+#define FAKE_FREERTOS_H
+
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include "../FakeClock.h"
+
+// Tick 1 ms (CONFIG_FREERTOS_HZ=1000 seperti firmware)
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define pdTRUE 1
+#define pdFALSE 0
+#define configMAX_TASK_NAME_LEN 16
+
+// Identitas "task" = thread host. Default "main" di core 1 (loopTask);
+// thread test memanggil fakeTaskBegin() untuk memberi nama & core.
+struct FakeTask
+{
+  char name[configMAX_TASK_NAME_LEN];
+  int core;
+};
+typedef FakeTask *TaskHandle_t;
+
+inline FakeTask &fakeCurrentTask()
+{
+  // Dialokasikan per thread dan tidak dibebaskan: handle tetap unik walau
+  // thread lama sudah selesai (seperti TCB task yang dihapus di FreeRTOS,
+  // alamatnya tidak dipakai ulang selama test)
+  static thread_local FakeTask *task = new FakeTask{"main", 1};
+  return *task;
+}
+
+inline void fakeTaskBegin(const char *name, int core)
+{
+  FakeTask &t = fakeCurrentTask();
+  snprintf(t.name, sizeof(t.name), "%s", name);
+  t.core = core;
+}
+
+inline int xPortGetCoreID() { return fakeCurrentTask().core; }
+
+// Spinlock critical section (portMUX) antar thread host
+struct FakeMux
+{
+  std::atomic_flag locked;
+};
+typedef FakeMux portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {}
+
+inline void portENTER_CRITICAL(portMUX_TYPE *mux)
+{
+  while (mux->locked.test_and_set(std::memory_order_acquire))
+  {
+  }
+}
+
+inline void portEXIT_CRITICAL(portMUX_TYPE *mux) { mux->locked.clear(std::memory_order_release); }
+
+#endif
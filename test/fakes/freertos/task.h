@@ -0,0 +1,13 @@
+#ifndef FAKE_FREERTOS_TASK_H
+#define FAKE_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+// Satu task di host: "yield" = majukan jam virtual
+inline void vTaskDelay(TickType_t ticks) { fakeAdvanceUs((int64_t)ticks * 1000); }
+inline void taskYIELD() {}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return &fakeCurrentTask(); }
+inline const char *pcTaskGetTaskName(TaskHandle_t task) { return task->name; }
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef PTY_LINE_H
+#define PTY_LINE_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <Arduino.h>
+#include "SimSlaves.h"
+
+// ============================================================================
+// SALURAN SERIAL VIRTUAL (pty, Linux)
+// Master (Rs485Port firmware) memegang sisi slave pty lewat PtySerial; slave
+// simulasi berjalan di thread sendiri di sisi master pty, memisah frame
+// request dengan jeda t3.5 seperti slave RTU sungguhan. pty tidak punya baud:
+// waktu kirim di-emulasikan (flush() master & sleep sebelum balasan slave),
+// jadi angka throughput tetap mengikuti baudrate config.
+// Jam real-time (fakeClockRealtime): durasi simulasi = durasi wall clock.
+// Nama pty dicetak agar bisa juga diintip dengan tool lain.
+// ============================================================================
+
+// HardwareSerial di atas file descriptor pty (non-blocking)
+class PtySerial : public HardwareSerial
+{
+public:
+  explicit PtySerial(int fd) : _fd(fd) {}
+
+  int available() override
+  {
+    if (_peek >= 0)
+      return 1 + pending();
+    return pending();
+  }
+  int read() override
+  {
+    if (_peek >= 0)
+    {
+      int c = _peek;
+      _peek = -1;
+      return c;
+    }
+    uint8_t c;
+    return ::read(_fd, &c, 1) == 1 ? c : -1;
+  }
+  int peek() override
+  {
+    if (_peek < 0)
+      _peek = read();
+    return _peek;
+  }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *data, size_t size) override
+  {
+    size_t done = 0;
+    while (done < size)
+    {
+      ssize_t n = ::write(_fd, data + done, size - done);
+      if (n > 0)
+        done += n;
+      else if (errno != EAGAIN && errno != EINTR)
+        break;
+    }
+    _pending += done;
+    return done;
+  }
+  // Tunggu selama byte "keluar" di baud config
+  void flush() override
+  {
+    fakeAdvanceUs(_pending * charUs());
+    _pending = 0;
+  }
+
+private:
+  int pending()
+  {
+    int n = 0;
+    return ioctl(_fd, FIONREAD, &n) == 0 ? n : 0;
+  }
+
+  int _fd;
+  int _peek = -1;
+  size_t _pending = 0;
+};
+
+class PtyLine
+{
+public:
+  PtyLine(SimSlaves &slaves) : _slaves(slaves) {}
+  ~PtyLine() { close(); }
+
+  // Buka pasangan pty (raw, non-blocking). Kembalikan nama sisi slave.
+  const char *open()
+  {
+    if (openpty(&_masterFd, &_slaveFd, _name, NULL, NULL) != 0)
+      return NULL;
+    struct termios t;
+    tcgetattr(_slaveFd, &t);
+    cfmakeraw(&t);
+    tcsetattr(_slaveFd, TCSANOW, &t);
+    fcntl(_slaveFd, F_SETFL, fcntl(_slaveFd, F_GETFL) | O_NONBLOCK);
+    return _name;
+  }
+
+  int busFd() const { return _slaveFd; } // sisi Rs485Port (PtySerial)
+
+  // Thread slave: kumpulkan byte sampai bus diam gapUs, jawab setelah
+  // delay slave + waktu kirim balasan
+  void start(uint32_t baudrate, uint32_t gapUs)
+  {
+    _charUs = 10000000LL / baudrate;
+    _gapUs = gapUs;
+    _run = true;
+    _thread = std::thread([this]() { serve(); });
+  }
+
+  void close()
+  {
+    _run = false;
+    if (_thread.joinable())
+      _thread.join();
+    if (_masterFd >= 0)
+      ::close(_masterFd);
+    if (_slaveFd >= 0)
+      ::close(_slaveFd);
+    _masterFd = _slaveFd = -1;
+  }
+
+private:
+  static int64_t nowUs()
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void serve()
+  {
+    std::vector<uint8_t> frame, reply;
+    int64_t lastByteUs = 0;
+    while (_run)
+    {
+      struct pollfd p = {_masterFd, POLLIN, 0};
+      int timeoutMs = frame.empty() ? 10 : 1;
+      if (poll(&p, 1, timeoutMs) > 0 && (p.revents & POLLIN))
+      {
+        uint8_t buf[256];
+        ssize_t n = ::read(_masterFd, buf, sizeof(buf));
+        if (n > 0)
+        {
+          frame.insert(frame.end(), buf, buf + n);
+          lastByteUs = nowUs();
+        }
+        continue;
+      }
+      // Byte pty tiba seketika: tunggu juga waktu kirim frame di baud config
+      if (frame.empty() || nowUs() - lastByteUs < _gapUs + (int64_t)frame.size() * _charUs)
+        continue;
+
+      uint32_t delayUs = 0;
+      if (_slaves.respond(frame.data(), frame.size(), nowUs(), reply, delayUs))
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(delayUs + reply.size() * _charUs));
+        if (::write(_masterFd, reply.data(), reply.size()) < 0)
+          break;
+      }
+      frame.clear();
+    }
+  }
+
+  SimSlaves &_slaves;
+  int _masterFd = -1, _slaveFd = -1;
+  char _name[64] = {};
+  int64_t _charUs = 0, _gapUs = 0;
+  std::atomic<bool> _run{false};
+  std::thread _thread;
+};
+
+#endif
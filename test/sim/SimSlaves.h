@@ -0,0 +1,144 @@
+#ifndef SIM_SLAVES_H
+#define SIM_SLAVES_H
+
+#include <math.h>
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "ModbusFrame.hpp"
+#include "ModbusPlanner.hpp"
+
+// ============================================================================
+// SLAVE RTU SIMULASI (harness test/sim)
+// Semua unit ID yang di-addUnit() dijawab oleh satu objek. Nilai register = gelombang
+// sinus per unit/register (berubah terhadap waktu, jadi umur data terukur).
+// Gangguan per request:
+//   latency  : waktu proses slave, latencyUs + jitter acak [0, jitterUs]
+//   drop     : peluang slave diam (timeout di master)
+//   noise    : peluang satu byte balasan rusak (CRC error di master)
+//   outage   : unit mati total selama outageUs tiap outagePeriodUs (fase
+//              digeser per unit, tidak semua unit mati bersamaan)
+// Sampel terakhir per blok disimpan agar master bisa memeriksa nilai yang
+// lolos CRC & menghitung latency end-to-end dari saat slave mengambil data.
+// Thread-safe: mode pty memanggil respond() dari thread slave.
+// ============================================================================
+
+struct SimFaults
+{
+  uint32_t latencyUs = 5000;
+  uint32_t jitterUs = 0;
+  float drop = 0;
+  float noise = 0;
+  uint32_t outageUs = 0, outagePeriodUs = 0;
+};
+
+struct SimSample
+{
+  int64_t atUs = -1; // saat slave mengambil nilai (-1 = belum pernah)
+  std::vector<uint16_t> values;
+};
+
+class SimSlaves
+{
+public:
+  SimSlaves(const SimFaults &faults, uint32_t seed) : _faults(faults), _rng(seed) {}
+
+  void addUnit(uint8_t unit) { _units[unit] = true; }
+
+  // Gelombang deterministik: offset & periode berbeda tiap unit/register
+  static uint16_t valueAt(uint8_t unit, uint16_t reg, int64_t atUs)
+  {
+    double periodS = 30.0 + (unit * 7 + reg) % 50;
+    double phase = 2.0 * M_PI * ((double)atUs / 1e6 / periodS);
+    return (uint16_t)(1000 + 100 * unit + 500.0 * sin(phase + reg));
+  }
+
+  // Request RTU lengkap -> balasan. false = slave diam (unit lain, drop,
+  // outage, CRC request rusak). delayUs = waktu proses sebelum byte pertama.
+  bool respond(const uint8_t *req, size_t len, int64_t nowUs, std::vector<uint8_t> &reply, uint32_t &delayUs)
+  {
+    std::lock_guard<std::mutex> lock(_lock);
+    _requests++;
+    if (len < 8 || modbusCrc16(req, len - 2) != (uint16_t)(req[len - 2] | req[len - 1] << 8))
+      return false;
+    uint8_t unit = req[0], fc = req[1];
+    uint16_t start = req[2] << 8 | req[3], count = req[4] << 8 | req[5];
+    if (!_units[unit])
+      return false;
+
+    if (_faults.outagePeriodUs && (nowUs + unit * 7919000LL) % _faults.outagePeriodUs < _faults.outageUs)
+    {
+      _outages++;
+      return false;
+    }
+    if (chance(_faults.drop))
+    {
+      _drops++;
+      return false;
+    }
+    delayUs = _faults.latencyUs + (_faults.jitterUs ? _rng() % (_faults.jitterUs + 1) : 0);
+
+    reply.clear();
+    reply.push_back(unit);
+    if ((fc != 3 && fc != 4) || count == 0 || count > MODBUS_BLOCK_MAX_REGS)
+    {
+      reply.push_back(fc | 0x80);
+      reply.push_back(fc != 3 && fc != 4 ? 0x01 : 0x03); // illegal function / value
+    }
+    else
+    {
+      SimSample &s = _served[key(unit, fc, start)];
+      s.atUs = nowUs + delayUs;
+      s.values.resize(count);
+      reply.push_back(fc);
+      reply.push_back((uint8_t)(count * 2));
+      for (uint16_t i = 0; i < count; i++)
+      {
+        uint16_t v = valueAt(unit, start + i, s.atUs);
+        s.values[i] = v;
+        reply.push_back(v >> 8);
+        reply.push_back(v & 0xFF);
+      }
+    }
+    uint16_t crc = modbusCrc16(reply.data(), reply.size());
+    reply.push_back(crc & 0xFF);
+    reply.push_back(crc >> 8);
+
+    if (chance(_faults.noise))
+    {
+      reply[_rng() % reply.size()] ^= (uint8_t)(1 + _rng() % 255);
+      _corrupted++;
+    }
+    _replies++;
+    return true;
+  }
+
+  // Sampel terakhir yang dikirim untuk blok (unit, fc, start)
+  SimSample served(uint8_t unit, uint8_t fc, uint16_t start)
+  {
+    std::lock_guard<std::mutex> lock(_lock);
+    auto it = _served.find(key(unit, fc, start));
+    return it == _served.end() ? SimSample() : it->second;
+  }
+
+  uint32_t requests() const { return _requests; }
+  uint32_t replies() const { return _replies; }
+  uint32_t drops() const { return _drops; }
+  uint32_t outages() const { return _outages; }
+  uint32_t corrupted() const { return _corrupted; }
+
+private:
+  static uint32_t key(uint8_t unit, uint8_t fc, uint16_t start) { return (uint32_t)unit << 24 | (uint32_t)fc << 16 | start; }
+  bool chance(float p) { return p > 0 && std::uniform_real_distribution<float>(0, 1)(_rng) < p; }
+
+  SimFaults _faults;
+  std::mt19937 _rng;
+  std::mutex _lock;
+  std::map<uint32_t, SimSample> _served;
+  bool _units[256] = {};
+  uint32_t _requests = 0, _replies = 0, _drops = 0, _outages = 0, _corrupted = 0;
+};
+
+#endif
@@ -0,0 +1,454 @@
+// ============================================================================
+// RTU SIM (harness host, Linux)
+// Menjalankan scan Modbus RTU firmware (ModbusPlanner + ModbusFrame +
+// Rs485Port, urutan & jeda sama dengan Task_ModbusClient) terhadap slave
+// simulasi (SimSlaves.h) dengan latency, noise & dropout, lalu melaporkan per
+// modbusSetup.json: sampel/detik, latency request & end-to-end, data loss.
+//
+//   pio run -e rtu_sim
+//   .pio/build/rtu_sim/program [opsi] [modbusSetup.json ...]
+//
+// Mode default: jam virtual + UART palsu (test/fakes), satu jam plant
+// tersimulasi dalam hitungan detik. --pty: bus lewat pasangan pty dengan
+// slave di thread terpisah, real-time (durasi = wall clock).
+// End-to-end = dari saat slave mengambil nilai sampai baris dikirim logger
+// (tiap sendInterval). Sink HTTP/MQTT tidak dijalankan: baris dihitung di
+// titik kirim, jaringan di luar cakupan harness ini. Tag Modbus TCP
+// (elemen ke-6) dilewati.
+// ============================================================================
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ModbusFrame.hpp"
+#include "ModbusPlanner.hpp"
+#include "Rs485Port.hpp"
+#include "SimSlaves.h"
+#include "PtyLine.h"
+
+#define SIM_MAX_TAGS 64 // RUNTIME_MAX_MODBUS_TAGS
+#define SIM_BLOCK_PAUSE_MS 10 // jeda antar blok di Task_ModbusClient
+
+struct SimTag
+{
+  char name[32];
+  uint8_t slaveId, fc;
+  uint16_t reg;
+  float multiplier;
+  uint8_t target; // selalu 0 (RS-485), dipakai modbusPlanBlocks
+};
+
+struct SimConfig
+{
+  std::string path;
+  long baudrate;
+  uint8_t dataBit, stopBit;
+  std::string parity;
+  uint32_t scanRateMs;
+  SimTag tags[SIM_MAX_TAGS];
+  size_t tagCount = 0, skippedTcp = 0;
+  uint8_t blockTags[SIM_MAX_TAGS];
+  ModbusBlock blocks[SIM_MAX_TAGS];
+  size_t blockCount = 0;
+};
+
+struct SimOptions
+{
+  double seconds = 3600;
+  bool pty = false;
+  uint32_t sendIntervalMs = 10000;
+  uint32_t timeoutMs = 100; // timeout blok di Task_ModbusClient
+  uint32_t seed = 1;
+  SimFaults faults;
+};
+
+struct SimTagStats
+{
+  uint32_t ok, timeout, crc, exception, mismatch, wrongValue;
+  int64_t sampleUs, sentUs; // sampel terakhir diterima / sudah dikirim
+};
+
+struct SimReport
+{
+  SimTagStats tags[SIM_MAX_TAGS];
+  std::vector<uint32_t> requestUs, e2eUs;
+  uint32_t scans = 0, overruns = 0, rows = 0, delivered = 0, stale = 0;
+  int64_t scanSumUs = 0, scanMaxUs = 0;
+};
+
+static bool loadConfig(const char *path, SimConfig &c)
+{
+  std::ifstream in(path);
+  if (!in)
+  {
+    fprintf(stderr, "cannot open %s\n", path);
+    return false;
+  }
+  std::stringstream text;
+  text << in.rdbuf();
+  DynamicJsonDocument doc(32768);
+  DeserializationError err = deserializeJson(doc, text.str());
+  if (err)
+  {
+    fprintf(stderr, "%s: %s\n", path, err.c_str());
+    return false;
+  }
+
+  // Default & konversi sama dengan RuntimeConfig::capture()
+  c.path = path;
+  c.baudrate = doc["baudrate"] | 9600;
+  c.parity = doc["parity"] | "None";
+  c.stopBit = doc["stopBit"] | 1;
+  c.dataBit = doc["dataBit"] | 8;
+  c.scanRateMs = (uint32_t)((doc["scanRate"] | 1.0f) * 1000);
+  for (JsonVariant v : doc["nameData"].as<JsonArray>())
+  {
+    const char *name = v.as<const char *>();
+    JsonArray p = doc[name];
+    if (!name || p.isNull())
+      continue;
+    if (p[5].is<const char *>())
+    {
+      c.skippedTcp++;
+      continue;
+    }
+    if (c.tagCount >= SIM_MAX_TAGS)
+      break;
+    SimTag &t = c.tags[c.tagCount++];
+    strlcpy(t.name, name, sizeof(t.name));
+    t.slaveId = p[0] | 0;
+    t.fc = p[1] | 0;
+    t.reg = p[2] | 0;
+    t.multiplier = p[3] | 1.0f;
+    t.target = 0;
+  }
+  c.blockCount = modbusPlanBlocks(c.tags, c.tagCount, c.blockTags, c.blocks);
+  return true;
+}
+
+static uint32_t percentile(std::vector<uint32_t> &v, double p)
+{
+  if (v.empty())
+    return 0;
+  size_t k = (size_t)(p * (v.size() - 1));
+  std::nth_element(v.begin(), v.begin() + k, v.end());
+  return v[k];
+}
+
+static double average(const std::vector<uint32_t> &v)
+{
+  double sum = 0;
+  for (uint32_t x : v)
+    sum += x;
+  return v.empty() ? 0 : sum / v.size();
+}
+
+class Simulation
+{
+public:
+  Simulation(const SimConfig &cfg, const SimOptions &opt)
+      : _cfg(cfg), _opt(opt), _slaves(opt.faults, opt.seed), _line(_slaves) {}
+
+  bool run(SimReport &r)
+  {
+    for (size_t i = 0; i < _cfg.tagCount; i++)
+      _slaves.addUnit(_cfg.tags[i].slaveId);
+
+    fakeClockReset();
+    fakeClockRealtime() = _opt.pty;
+    HardwareSerial uart;
+    HardwareSerial *bus = &uart;
+    PtySerial *ptySerial = NULL;
+    if (_opt.pty)
+    {
+      const char *name = _line.open();
+      if (!name)
+      {
+        perror("openpty");
+        return false;
+      }
+      _ptyName = name;
+      ptySerial = new PtySerial(_line.busFd());
+      bus = ptySerial;
+    }
+    else
+    {
+      // Slave menjawab setelah frame request selesai terkirim + delay slave
+      uart.onTransmit = [&](const uint8_t *data, size_t len)
+      {
+        std::vector<uint8_t> reply;
+        uint32_t delayUs = 0;
+        int64_t doneUs = fakeNowUs() + (int64_t)len * uart.charUs();
+        if (_slaves.respond(data, len, doneUs, reply, delayUs))
+          uart.inject(reply, doneUs + delayUs);
+      };
+    }
+
+    Rs485Port port(*bus, (uart_port_t)1, 16, 17, -1);
+    if (!port.begin(_cfg.baudrate, _cfg.dataBit, _cfg.stopBit, _cfg.parity.c_str()))
+    {
+      fprintf(stderr, "%s: unsupported serial format\n", _cfg.path.c_str());
+      delete ptySerial;
+      return false;
+    }
+    if (_opt.pty)
+      _line.start(_cfg.baudrate, std::max<uint32_t>(port.frameGapUs(), 2000));
+
+    memset(r.tags, 0, sizeof(r.tags));
+    for (size_t i = 0; i < _cfg.tagCount; i++)
+      r.tags[i].sampleUs = r.tags[i].sentUs = -1;
+
+    int64_t startUs = fakeNowUs(), endUs = startUs + (int64_t)(_opt.seconds * 1e6);
+    int64_t nextScanUs = startUs, nextSendUs = startUs + _opt.sendIntervalMs * 1000LL;
+    while (fakeNowUs() < endUs)
+    {
+      if (fakeNowUs() >= nextScanUs)
+      {
+        scan(port, r);
+        nextScanUs = fakeNowUs() + _cfg.scanRateMs * 1000LL; // lastModbusRead = akhir scan
+      }
+      if (fakeNowUs() >= nextSendUs)
+      {
+        send(r);
+        nextSendUs += _opt.sendIntervalMs * 1000LL;
+      }
+      int64_t wakeUs = std::min(std::min(nextScanUs, nextSendUs), endUs);
+      if (wakeUs > fakeNowUs())
+        fakeAdvanceUs(wakeUs - fakeNowUs());
+    }
+    _simulatedUs = fakeNowUs() - startUs;
+
+    _line.close();
+    port.end();
+    delete ptySerial;
+    fakeClockRealtime() = false;
+    return true;
+  }
+
+  SimSlaves &slaves() { return _slaves; }
+  const std::string &ptyName() const { return _ptyName; }
+  int64_t simulatedUs() const { return _simulatedUs; }
+
+private:
+  // Satu siklus scan, sama dengan loop blok RS-485 di Task_ModbusClient
+  void scan(Rs485Port &port, SimReport &r)
+  {
+    int64_t scanStart = fakeNowUs();
+    for (size_t b = 0; b < _cfg.blockCount; b++)
+    {
+      const ModbusBlock &blk = _cfg.blocks[b];
+      uint8_t request[MODBUS_READ_REQUEST_LEN];
+      uint8_t response[256]; // MODBUS_RTU_FRAME_MAX
+      uint16_t values[MODBUS_BLOCK_MAX_REGS];
+      modbusBuildReadRequest(request, blk.unit, blk.fc, blk.start, blk.count);
+
+      int64_t requestStart = fakeNowUs();
+      port.send(request, sizeof(request));
+      size_t n = port.receive(response, sizeof(response), modbusReadResponseLen(blk.count), _opt.timeoutMs);
+      uint8_t status = n == 0 ? (uint8_t)MB_FRAME_TIMEOUT
+                              : (uint8_t)modbusParseReadBlock(response, n, blk.unit, blk.fc, blk.count, values);
+      r.requestUs.push_back((uint32_t)(fakeNowUs() - requestStart));
+
+      SimSample served;
+      if (status == MB_FRAME_OK)
+        served = _slaves.served(blk.unit, blk.fc, blk.start);
+      for (uint8_t k = 0; k < blk.tagCount; k++)
+      {
+        uint8_t i = _cfg.blockTags[blk.firstTag + k];
+        uint16_t offset = _cfg.tags[i].reg - blk.start;
+        SimTagStats &t = r.tags[i];
+        switch (status)
+        {
+        case MB_FRAME_OK:
+          // Lolos CRC tapi bukan nilai yang terakhir dikirim slave (balasan
+          // terlambat dari request sebelumnya ikut terbaca)
+          if (offset >= served.values.size() || served.values[offset] != values[offset])
+          {
+            t.wrongValue++;
+            break;
+          }
+          t.ok++;
+          t.sampleUs = served.atUs;
+          break;
+        case MB_FRAME_TIMEOUT:
+          t.timeout++;
+          break;
+        case MB_FRAME_CRC:
+        case MB_FRAME_SHORT:
+          t.crc++;
+          break;
+        case MB_FRAME_EXCEPTION:
+          t.exception++;
+          break;
+        default:
+          t.mismatch++;
+          break;
+        }
+      }
+      fakeAdvanceUs(SIM_BLOCK_PAUSE_MS * 1000);
+    }
+
+    int64_t durationUs = fakeNowUs() - scanStart;
+    r.scans++;
+    r.scanSumUs += durationUs;
+    r.scanMaxUs = std::max(r.scanMaxUs, durationUs);
+    if (durationUs > _cfg.scanRateMs * 1000LL)
+      r.overruns++;
+  }
+
+  // Logger: satu baris tiap sendInterval berisi nilai terakhir tiap tag.
+  // Nilai yang belum diperbarui sejak baris sebelumnya = stale (hilang).
+  void send(SimReport &r)
+  {
+    r.rows++;
+    for (size_t i = 0; i < _cfg.tagCount; i++)
+    {
+      SimTagStats &t = r.tags[i];
+      if (t.sampleUs > t.sentUs)
+      {
+        r.e2eUs.push_back((uint32_t)(fakeNowUs() - t.sampleUs));
+        t.sentUs = t.sampleUs;
+        r.delivered++;
+      }
+      else
+        r.stale++;
+    }
+  }
+
+  const SimConfig &_cfg;
+  const SimOptions &_opt;
+  SimSlaves _slaves;
+  PtyLine _line;
+  std::string _ptyName;
+  int64_t _simulatedUs = 0;
+};
+
+static void printReport(const SimConfig &c, const SimOptions &o, Simulation &sim, SimReport &r, double wallS)
+{
+  double simS = sim.simulatedUs() / 1e6;
+  uint32_t ok = 0, total = 0;
+  for (size_t i = 0; i < c.tagCount; i++)
+  {
+    const SimTagStats &t = r.tags[i];
+    ok += t.ok;
+    total += t.ok + t.timeout + t.crc + t.exception + t.mismatch + t.wrongValue;
+  }
+
+  printf("\n=== %s ===\n", c.path.c_str());
+  printf("mode         : %s%s\n", o.pty ? "pty " : "virtual clock", o.pty ? sim.ptyName().c_str() : "");
+  printf("bus          : %ld %u%c%u, %zu tags in %zu blocks (%zu TCP tags skipped)\n", c.baudrate, c.dataBit,
+         c.parity[0], c.stopBit, c.tagCount, c.blockCount, c.skippedTcp);
+  printf("rates        : scan %u ms, send %u ms, timeout %u ms\n", c.scanRateMs, o.sendIntervalMs, o.timeoutMs);
+  printf("faults       : latency %.1f ms + jitter %.1f ms, drop %.1f %%, noise %.1f %%, outage %.1f s / %.1f s\n",
+         o.faults.latencyUs / 1e3, o.faults.jitterUs / 1e3, o.faults.drop * 100, o.faults.noise * 100,
+         o.faults.outageUs / 1e6, o.faults.outagePeriodUs / 1e6);
+  printf("simulated    : %.1f s (wall %.2f s)\n", simS, wallS);
+  printf("slaves       : %u requests, %u replies, %u dropped, %u in outage, %u corrupted\n",
+         sim.slaves().requests(), sim.slaves().replies(), sim.slaves().drops(), sim.slaves().outages(),
+         sim.slaves().corrupted());
+  printf("scans        : %u, cycle avg %.1f ms max %.1f ms, overrun %u\n", r.scans,
+         r.scans ? r.scanSumUs / 1e3 / r.scans : 0, r.scanMaxUs / 1e3, r.overruns);
+  printf("samples/s    : %.2f (tag reads ok per simulated second)\n", simS > 0 ? ok / simS : 0);
+  printf("loss         : reads %.2f %% (%u/%u), stale values in rows %.2f %% (%u/%u)\n",
+         total ? 100.0 * (total - ok) / total : 0, total - ok, total,
+         r.delivered + r.stale ? 100.0 * r.stale / (r.delivered + r.stale) : 0, r.stale, r.delivered + r.stale);
+  printf("request      : avg %.1f ms, p50 %.1f ms, p99 %.1f ms, max %.1f ms\n", average(r.requestUs) / 1e3,
+         percentile(r.requestUs, 0.5) / 1e3, percentile(r.requestUs, 0.99) / 1e3, percentile(r.requestUs, 1.0) / 1e3);
+  printf("end-to-end   : avg %.1f ms, p50 %.1f ms, p99 %.1f ms, max %.1f ms (slave sample -> row sent)\n",
+         average(r.e2eUs) / 1e3, percentile(r.e2eUs, 0.5) / 1e3, percentile(r.e2eUs, 0.99) / 1e3,
+         percentile(r.e2eUs, 1.0) / 1e3);
+  printf("%-20s %8s %8s %8s %8s %8s %8s %7s\n", "tag", "ok", "timeout", "crc", "except", "mismatch", "wrong", "loss%");
+  for (size_t i = 0; i < c.tagCount; i++)
+  {
+    const SimTagStats &t = r.tags[i];
+    uint32_t n = t.ok + t.timeout + t.crc + t.exception + t.mismatch + t.wrongValue;
+    printf("%-20.20s %8u %8u %8u %8u %8u %8u %7.2f\n", c.tags[i].name, t.ok, t.timeout, t.crc, t.exception,
+           t.mismatch, t.wrongValue, n ? 100.0 * (n - t.ok) / n : 0);
+  }
+}
+
+static void usage()
+{
+  printf("usage: rtu_sim [options] [modbusSetup.json ...]   (default data/modbusSetup.json)\n"
+         "  --hours H | --seconds S   simulated duration (default 1 h)\n"
+         "  --pty                     real-time run over a pty pair instead of the virtual clock\n"
+         "  --send-interval-s S       logger send interval (default 10)\n"
+         "  --timeout-ms MS           master response timeout (default 100)\n"
+         "  --latency-ms MS           slave processing delay (default 5)\n"
+         "  --jitter-ms MS            extra random delay 0..MS\n"
+         "  --drop P                  probability a slave stays silent (0..1)\n"
+         "  --noise P                 probability one reply byte is corrupted (0..1)\n"
+         "  --outage S --every S      each unit offline S seconds every S seconds\n"
+         "  --seed N                  random seed (default 1)\n");
+}
+
+int main(int argc, char **argv)
+{
+  SimOptions opt;
+  std::vector<const char *> files;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (a == "--pty")
+      opt.pty = true;
+    else if (a == "--hours" && hasValue)
+      opt.seconds = atof(argv[++i]) * 3600;
+    else if (a == "--seconds" && hasValue)
+      opt.seconds = atof(argv[++i]);
+    else if (a == "--send-interval-s" && hasValue)
+      opt.sendIntervalMs = (uint32_t)(atof(argv[++i]) * 1000);
+    else if (a == "--timeout-ms" && hasValue)
+      opt.timeoutMs = atoi(argv[++i]);
+    else if (a == "--latency-ms" && hasValue)
+      opt.faults.latencyUs = (uint32_t)(atof(argv[++i]) * 1000);
+    else if (a == "--jitter-ms" && hasValue)
+      opt.faults.jitterUs = (uint32_t)(atof(argv[++i]) * 1000);
+    else if (a == "--drop" && hasValue)
+      opt.faults.drop = atof(argv[++i]);
+    else if (a == "--noise" && hasValue)
+      opt.faults.noise = atof(argv[++i]);
+    else if (a == "--outage" && hasValue)
+      opt.faults.outageUs = (uint32_t)(atof(argv[++i]) * 1e6);
+    else if (a == "--every" && hasValue)
+      opt.faults.outagePeriodUs = (uint32_t)(atof(argv[++i]) * 1e6);
+    else if (a == "--seed" && hasValue)
+      opt.seed = atoi(argv[++i]);
+    else if (a[0] == '-')
+    {
+      usage();
+      return a == "--help" || a == "-h" ? 0 : 2;
+    }
+    else
+      files.push_back(argv[i]);
+  }
+  if (files.empty())
+    files.push_back("data/modbusSetup.json");
+
+  int failed = 0;
+  for (const char *path : files)
+  {
+    SimConfig *cfg = new SimConfig;
+    if (!loadConfig(path, *cfg))
+    {
+      delete cfg;
+      failed++;
+      continue;
+    }
+    SimReport *report = new SimReport;
+    Simulation sim(*cfg, opt);
+    auto wall0 = std::chrono::steady_clock::now();
+    if (sim.run(*report))
+      printReport(*cfg, opt, sim, *report,
+                  std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count());
+    else
+      failed++;
+    delete report;
+    delete cfg;
+  }
+  return failed ? 1 : 0;
+}
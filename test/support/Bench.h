@@ -0,0 +1,40 @@
+#ifndef TEST_BENCH_H
+#define TEST_BENCH_H
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+
+// ============================================================================
+// MICRO-BENCHMARK (env:native)
+// Tanpa Google Benchmark: ulangi fn sampai minimal minMs (jam nyata host,
+// bukan jam palsu HAL), cetak ns/op. Angka host tidak sama dengan ESP32,
+// dipakai untuk membandingkan versi / mendeteksi regresi relatif.
+//   pio test -e native -v   -> baris "[BENCH] nama: x ns/op"
+// ============================================================================
+
+// Tempat buang hasil supaya compiler tidak menghapus kerja di benchmark
+static volatile uint32_t benchSink;
+
+template <class F>
+double benchRun(const char *name, F fn, uint32_t minMs = 200)
+{
+  typedef std::chrono::steady_clock Clock;
+  uint64_t iterations = 0;
+  uint64_t batch = 1;
+  Clock::time_point start = Clock::now();
+  double elapsedNs = 0;
+  while (elapsedNs < minMs * 1e6)
+  {
+    for (uint64_t i = 0; i < batch; i++)
+      fn();
+    iterations += batch;
+    batch *= 2;
+    elapsedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  }
+  double nsPerOp = elapsedNs / iterations;
+  printf("[BENCH] %s: %.1f ns/op (%llu iterasi)\n", name, nsPerOp, (unsigned long long)iterations);
+  return nsPerOp;
+}
+
+#endif
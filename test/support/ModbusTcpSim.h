@@ -0,0 +1,229 @@
+#ifndef TEST_MODBUS_TCP_SIM_H
+#define TEST_MODBUS_TCP_SIM_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "ModbusFrame.hpp"
+
+// ============================================================================
+// SIMULATOR MODBUS TCP LOKAL (Linux, 127.0.0.1 port acak)
+// Server multi-koneksi di thread sendiri untuk test client Modbus TCP.
+// Nilai register = unit * 1000 + register, jadi hasil blok bisa dicek tanpa
+// tabel. Perilaku:
+//   FC3/FC4, start + count <= 1000 : balasan normal
+//   start + count > 1000            : exception 02 (illegal address)
+//   FC lain                         : exception 01
+//   unit == silentUnit              : tidak dijawab (timeout di master)
+//   reorder                         : request yang datang pipelined ditahan
+//                                     lalu dijawab terbalik (cek TID)
+// Dicatat: koneksi diterima, jumlah request, request terbanyak yang pernah
+// menunggu jawaban sekaligus dalam satu koneksi.
+// ============================================================================
+
+class ModbusTcpSim
+{
+public:
+  std::atomic<uint8_t> silentUnit{0};
+  std::atomic<bool> reorder{false};
+  std::atomic<uint32_t> accepted{0};
+  std::atomic<uint32_t> requests{0};
+  std::atomic<uint32_t> maxPending{0};
+
+  ~ModbusTcpSim() { stop(); }
+
+  static uint16_t valueOf(uint8_t unit, uint16_t reg) { return unit * 1000 + reg; }
+
+  // Listen di 127.0.0.1, kembalikan port (0 = gagal)
+  uint16_t start()
+  {
+    _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (_listenFd < 0 || bind(_listenFd, (struct sockaddr *)&addr, len) != 0 || listen(_listenFd, 8) != 0 ||
+        getsockname(_listenFd, (struct sockaddr *)&addr, &len) != 0)
+      return 0;
+    _run = true;
+    _thread = std::thread([this]() { serve(); });
+    return ntohs(addr.sin_port);
+  }
+
+  void stop()
+  {
+    _run = false;
+    if (_thread.joinable())
+      _thread.join();
+    for (Client &c : _clients)
+      ::close(c.fd);
+    _clients.clear();
+    if (_listenFd >= 0)
+      ::close(_listenFd);
+    _listenFd = -1;
+  }
+
+  // Putus semua koneksi dari sisi server (meter reboot / gateway idle timeout)
+  void dropClients() { _dropClients = true; }
+
+private:
+  struct Client
+  {
+    int fd;
+    std::vector<uint8_t> rx;
+    std::vector<std::vector<uint8_t>> held; // balasan ditahan (reorder)
+    int64_t lastRequestUs;
+  };
+
+  static int64_t nowUs()
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void serve()
+  {
+    while (_run)
+    {
+      if (_dropClients.exchange(false))
+      {
+        for (Client &c : _clients)
+          ::close(c.fd);
+        _clients.clear();
+      }
+
+      std::vector<struct pollfd> fds;
+      fds.push_back({_listenFd, POLLIN, 0});
+      for (Client &c : _clients)
+        fds.push_back({c.fd, POLLIN, 0});
+      poll(fds.data(), fds.size(), 2);
+
+      if (fds[0].revents & POLLIN)
+      {
+        int fd = accept(_listenFd, NULL, NULL);
+        if (fd >= 0)
+        {
+          int one = 1; // tanpa Nagle: balasan pipelined tidak menunggu delayed ACK
+          setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+          _clients.push_back({fd, {}, {}, 0});
+          accepted++;
+        }
+      }
+
+      for (size_t i = 0; i < _clients.size();)
+      {
+        Client &c = _clients[i];
+        bool alive = true;
+        if (i + 1 < fds.size() && (fds[i + 1].revents & (POLLIN | POLLHUP)))
+          alive = receive(c);
+        // reorder: tahan sampai 4 request atau jalur diam 20 ms
+        if (alive && !c.held.empty() && (c.held.size() >= 4 || nowUs() - c.lastRequestUs > 20000))
+        {
+          for (size_t r = c.held.size(); r-- > 0;)
+            sendAll(c.fd, c.held[r]);
+          c.held.clear();
+        }
+        if (!alive)
+        {
+          ::close(c.fd);
+          _clients.erase(_clients.begin() + i);
+          continue;
+        }
+        i++;
+      }
+    }
+  }
+
+  bool receive(Client &c)
+  {
+    uint8_t buf[512];
+    ssize_t n = recv(c.fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (n <= 0)
+      return false;
+    c.rx.insert(c.rx.end(), buf, buf + n);
+    while (true)
+    {
+      size_t frameLen = modbusTcpFrameLen(c.rx.data(), c.rx.size(), MODBUS_MBAP_LEN + 253);
+      if (frameLen == (size_t)-1)
+        return false;
+      if (frameLen == 0)
+        return true;
+      std::vector<uint8_t> reply;
+      requests++;
+      c.lastRequestUs = nowUs();
+      if (answer(c.rx.data(), frameLen, reply))
+      {
+        if (reorder)
+        {
+          c.held.push_back(reply);
+          if (c.held.size() > maxPending)
+            maxPending = c.held.size();
+        }
+        else
+          sendAll(c.fd, reply);
+      }
+      c.rx.erase(c.rx.begin(), c.rx.begin() + frameLen);
+    }
+  }
+
+  bool answer(const uint8_t *adu, size_t len, std::vector<uint8_t> &reply)
+  {
+    uint8_t unit = adu[6], fc = adu[7];
+    if (unit == silentUnit || len < MODBUS_TCP_READ_REQUEST_LEN)
+      return false;
+    uint16_t start = adu[8] << 8 | adu[9], count = adu[10] << 8 | adu[11];
+
+    reply.assign(adu, adu + MODBUS_MBAP_LEN); // TID, protocol, unit
+    if (fc != 3 && fc != 4)
+    {
+      reply.push_back(fc | 0x80);
+      reply.push_back(0x01);
+    }
+    else if (start + count > 1000)
+    {
+      reply.push_back(fc | 0x80);
+      reply.push_back(0x02);
+    }
+    else
+    {
+      reply.push_back(fc);
+      reply.push_back(count * 2);
+      for (uint16_t r = 0; r < count; r++)
+      {
+        uint16_t v = valueOf(unit, start + r);
+        reply.push_back(v >> 8);
+        reply.push_back(v & 0xFF);
+      }
+    }
+    uint16_t length = reply.size() - 6; // unit + PDU
+    reply[4] = length >> 8;
+    reply[5] = length & 0xFF;
+    return true;
+  }
+
+  static void sendAll(int fd, const std::vector<uint8_t> &data)
+  {
+    size_t done = 0;
+    while (done < data.size())
+    {
+      ssize_t n = send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+      if (n <= 0)
+        return;
+      done += n;
+    }
+  }
+
+  int _listenFd = -1;
+  std::atomic<bool> _run{false};
+  std::atomic<bool> _dropClients{false};
+  std::vector<Client> _clients;
+  std::thread _thread;
+};
+
+#endif
@@ -0,0 +1,215 @@
+// Kanal virtual (Expression.hpp): bytecode hasil compile harus sama dengan
+// ekspresi yang sama ditulis langsung di C++, di grid nilai input. Benchmark
+// membandingkan eval bytecode dengan parse ulang string tiap sampel
+// (interpretasi langsung) dan dengan C++ native sebagai batas bawah.
+#include <unity.h>
+#include "Expression.hpp"
+#include "Bench.h"
+
+// Slot variabel: AI1-4 = 0-3, DI1-4 = 4-7, {Flow Meter 1} = 8
+#define VAR_COUNT 9
+
+static int resolve(const char *name, size_t len, void *)
+{
+  static const char *const names[VAR_COUNT] = {"AI1", "AI2", "AI3", "AI4", "DI1", "DI2", "DI3", "DI4", "Flow Meter 1"};
+  for (int i = 0; i < VAR_COUNT; i++)
+  {
+    if (strlen(names[i]) == len && strncmp(names[i], name, len) == 0)
+      return i;
+  }
+  return -1;
+}
+
+static ExprProgram compileOk(const char *src)
+{
+  ExprProgram p;
+  ExprCompiler c;
+  const char *error = c.compile(src, p, resolve, NULL);
+  TEST_ASSERT_NULL(error);
+  return p;
+}
+
+static float eval(const char *src, const float *vars)
+{
+  ExprProgram p = compileOk(src);
+  float state[EXPR_MAX_STATE] = {};
+  return exprEval(p, vars, state, 0.1f);
+}
+
+static const char *compileError(const char *src)
+{
+  ExprProgram p;
+  ExprCompiler c;
+  return c.compile(src, p, resolve, NULL);
+}
+
+void setUp() {}
+void tearDown() {}
+
+struct NativeCase
+{
+  const char *src;
+  float (*native)(const float *v);
+};
+
+static const NativeCase nativeCases[] = {
+    {"sqrt(max(AI1-AI2,0))*12.5", [](const float *v) { return sqrtf(fmaxf(v[0] - v[1], 0.0f)) * 12.5f; }},
+    {"AI1 + AI2 * AI3 - AI4 / 4", [](const float *v) { return v[0] + v[1] * v[2] - v[3] / 4.0f; }},
+    {"(AI1 + AI2) * (AI3 - AI4)", [](const float *v) { return (v[0] + v[1]) * (v[2] - v[3]); }},
+    {"-AI1 ^ 2", [](const float *v) { return -powf(v[0], 2.0f); }},
+    {"abs(AI2 - AI3) + pow(AI4, 0.5)", [](const float *v) { return fabsf(v[1] - v[2]) + powf(v[3], 0.5f); }},
+    {"min(AI1, AI2, AI3, AI4)", [](const float *v) { return fminf(fminf(fminf(v[0], v[1]), v[2]), v[3]); }},
+    {"AI1 > 2 && !DI2", [](const float *v) { return (float)(v[0] > 2.0f && !(v[5] != 0.0f)); }},
+    {"AI1 <= AI2 || AI3 == AI4", [](const float *v) { return (float)(v[0] <= v[1] || v[2] == v[3]); }},
+    {"if(AI1 >= AI2, AI3 * AI4 / 1000, {Flow Meter 1})", [](const float *v) { return v[0] >= v[1] ? v[2] * v[3] / 1000.0f : v[8]; }},
+    {"DI1 != DI3", [](const float *v) { return (float)(v[4] != v[6]); }},
+};
+
+void test_bytecode_matches_native_over_grid()
+{
+  const float grid[] = {-7.5f, -1.0f, 0.0f, 0.25f, 2.0f, 3.0f, 12.0f, 400.0f};
+  const int n = sizeof(grid) / sizeof(grid[0]);
+  for (const NativeCase &c : nativeCases)
+  {
+    ExprProgram p = compileOk(c.src);
+    for (int i = 0; i < n * n * n; i++)
+    {
+      // AI3/AI4 >= 0 supaya pow(AI4, 0.5) tidak NaN; DI = 0/1
+      float v[VAR_COUNT] = {grid[i % n], grid[i / n % n], fabsf(grid[i / n / n]), fabsf(grid[(i + 3) % n]),
+                            (float)(i & 1), (float)(i >> 1 & 1), (float)(i >> 2 & 1), 0.0f, grid[(i + 5) % n]};
+      float state[EXPR_MAX_STATE] = {};
+      float expected = c.native(v);
+      float actual = exprEval(p, v, state, 0.1f);
+      if (expected != actual && !(isnan(expected) && isnan(actual)))
+      {
+        char msg[160];
+        snprintf(msg, sizeof(msg), "%s at AI=%g,%g,%g,%g: %g != %g", c.src, v[0], v[1], v[2], v[3], actual, expected);
+        TEST_FAIL_MESSAGE(msg);
+      }
+    }
+  }
+}
+
+void test_precedence_and_associativity()
+{
+  const float v[VAR_COUNT] = {};
+  TEST_ASSERT_EQUAL_FLOAT(7.0f, eval("1 + 2 * 3", v));
+  TEST_ASSERT_EQUAL_FLOAT(512.0f, eval("2 ^ 3 ^ 2", v)); // kanan: 2^9
+  TEST_ASSERT_EQUAL_FLOAT(-4.0f, eval("-2 ^ 2", v));
+  TEST_ASSERT_EQUAL_FLOAT(2.0f, eval("8 / 2 / 2", v)); // kiri
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, eval("1 < 2 == 1", v));
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, eval("0 || 1 && 1", v)); // && lebih kuat dari ||
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, eval("!0", v));
+  TEST_ASSERT_EQUAL_FLOAT(3.0f, eval("max(1, 3, 2)", v));
+}
+
+void test_division_by_zero_and_negative_sqrt_are_not_clipped()
+{
+  const float v[VAR_COUNT] = {5.0f, 0.0f};
+  TEST_ASSERT_TRUE(isinf(eval("AI1 / AI2", v)));
+  TEST_ASSERT_TRUE(isnan(eval("sqrt(AI2 - AI1)", v)));
+}
+
+void test_prev_returns_previous_evaluation()
+{
+  ExprProgram p = compileOk("AI1 - prev(AI1)");
+  float state[EXPR_MAX_STATE] = {};
+  float v[VAR_COUNT] = {10.0f};
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, exprEval(p, v, state, 1.0f)); // evaluasi pertama: prev = x
+  v[0] = 13.0f;
+  TEST_ASSERT_EQUAL_FLOAT(3.0f, exprEval(p, v, state, 1.0f));
+  v[0] = 11.0f;
+  TEST_ASSERT_EQUAL_FLOAT(-2.0f, exprEval(p, v, state, 1.0f));
+}
+
+void test_integ_accumulates_over_dt()
+{
+  ExprProgram p = compileOk("integ(AI1 * AI2) / 3600");
+  float state[EXPR_MAX_STATE] = {};
+  float v[VAR_COUNT] = {230.0f, 2.0f}; // 460 W
+  float wh = 0;
+  for (int i = 0; i < 36000; i++)
+    wh = exprEval(p, v, state, 0.1f); // 1 jam @ 10 Hz
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 460.0f, wh);
+}
+
+void test_state_slots_are_separate_per_call()
+{
+  ExprProgram p = compileOk("prev(AI1) + integ(AI2) + prev(AI2)");
+  TEST_ASSERT_EQUAL_UINT8(5, p.stateCount); // prev = 2 slot, integ = 1
+  float state[EXPR_MAX_STATE] = {};
+  float v[VAR_COUNT] = {1.0f, 2.0f};
+  TEST_ASSERT_EQUAL_FLOAT(1.0f + 2.0f + 2.0f, exprEval(p, v, state, 1.0f));
+  v[0] = 5.0f;
+  v[1] = 3.0f;
+  TEST_ASSERT_EQUAL_FLOAT(1.0f + 5.0f + 2.0f, exprEval(p, v, state, 1.0f));
+}
+
+void test_compile_errors()
+{
+  TEST_ASSERT_EQUAL_STRING("unknown variable", compileError("AI9 + 1"));
+  TEST_ASSERT_EQUAL_STRING("unknown variable", compileError("{Flow Meter 2}"));
+  TEST_ASSERT_EQUAL_STRING("missing '}'", compileError("{Flow Meter 1"));
+  TEST_ASSERT_EQUAL_STRING("missing ')'", compileError("(AI1 + 2"));
+  TEST_ASSERT_EQUAL_STRING("unexpected character", compileError("AI1 2"));
+  TEST_ASSERT_NOT_NULL(compileError(""));
+  TEST_ASSERT_EQUAL_STRING("too many constants", compileError("1+2+3+4+5+6+7+8+9"));
+  TEST_ASSERT_EQUAL_STRING("min/max need 2+ arguments", compileError("min(AI1)"));
+  TEST_ASSERT_EQUAL_STRING("unknown function or wrong argument count", compileError("sqrt(AI1, AI2)"));
+  TEST_ASSERT_EQUAL_STRING("unknown function or wrong argument count", compileError("log(AI1)"));
+  TEST_ASSERT_EQUAL_STRING("too many prev/integ", compileError("prev(AI1)+prev(AI2)+prev(AI3)+prev(AI4)+prev(DI1)"));
+  TEST_ASSERT_EQUAL_STRING("expression too deep", compileError("AI1+(AI1+(AI1+(AI1+(AI1+(AI1+(AI1+(AI1+(AI1+(AI1+(AI1+(AI1+AI1)))))))))))"));
+}
+
+void test_bench_bytecode_vs_interpreted()
+{
+  static const char *const exprs[] = {"sqrt(max(AI1-AI2,0))*12.5", "if(AI1>2 && !DI2, AI3*AI4/1000, prev(AI3))",
+                                      "integ(AI1*AI2)/3600"};
+  float v[VAR_COUNT] = {4.2f, 1.1f, 230.0f, 12.5f, 0, 0, 0, 0, 0};
+  for (const char *src : exprs)
+  {
+    ExprProgram p = compileOk(src);
+    float state[EXPR_MAX_STATE] = {};
+    char name[96];
+    snprintf(name, sizeof(name), "bytecode %s", src);
+    double compiled = benchRun(name, [&]()
+    {
+      v[0] += 1e-3f;
+      benchSink += (uint32_t)exprEval(p, v, state, 0.1f);
+    });
+
+    // Parse ulang string tiap sampel: yang dihindari dengan compile sekali
+    // saat snapshot config dibuat
+    snprintf(name, sizeof(name), "interpreted %s", src);
+    double interpreted = benchRun(name, [&]()
+    {
+      ExprProgram q;
+      ExprCompiler c;
+      float s[EXPR_MAX_STATE] = {};
+      c.compile(src, q, resolve, NULL);
+      v[0] += 1e-3f;
+      benchSink += (uint32_t)exprEval(q, v, s, 0.1f);
+    });
+    TEST_ASSERT_TRUE(compiled < interpreted);
+  }
+
+  benchRun("native sqrt(max(AI1-AI2,0))*12.5", [&]()
+  {
+    v[0] += 1e-3f;
+    benchSink += (uint32_t)(sqrtf(fmaxf(v[0] - v[1], 0.0f)) * 12.5f);
+  });
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_bytecode_matches_native_over_grid);
+  RUN_TEST(test_precedence_and_associativity);
+  RUN_TEST(test_division_by_zero_and_negative_sqrt_are_not_clipped);
+  RUN_TEST(test_prev_returns_previous_evaluation);
+  RUN_TEST(test_integ_accumulates_over_dt);
+  RUN_TEST(test_state_slots_are_separate_per_call);
+  RUN_TEST(test_compile_errors);
+  RUN_TEST(test_bench_bytecode_vs_interpreted);
+  return UNITY_END();
+}
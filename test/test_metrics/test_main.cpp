@@ -0,0 +1,133 @@
+// Counter & histogram /metrics (MetricTypes.hpp): penempatan bucket di batas,
+// kuantil interpolasi, carry sum 64-bit, dan hitungan tetap tepat saat
+// observeUs dipanggil bersamaan dari beberapa thread (seperti dua core).
+#include <unity.h>
+#include <thread>
+#include <vector>
+#include "MetricTypes.hpp"
+#include "Bench.h"
+
+// Objek metric static: tetap hidup di linked list global seperti di firmware
+void setUp() {}
+void tearDown() {}
+
+void test_bucket_boundaries_are_inclusive()
+{
+  static MetricHistogram h("t_bucket_us", "test");
+  h.observeUs(0);
+  h.observeUs(100);  // le=100
+  h.observeUs(101);  // le=300
+  h.observeUs(1000); // le=1000
+  h.observeUs(1000000);
+  h.observeUs(1000001); // +Inf
+  h.observeUs(0xFFFFFFFF);
+
+  TEST_ASSERT_EQUAL_UINT32(2, h.bucket(0));
+  TEST_ASSERT_EQUAL_UINT32(1, h.bucket(1));
+  TEST_ASSERT_EQUAL_UINT32(1, h.bucket(2));
+  TEST_ASSERT_EQUAL_UINT32(1, h.bucket(METRIC_BUCKETS - 2));
+  TEST_ASSERT_EQUAL_UINT32(2, h.bucket(METRIC_BUCKETS - 1));
+  TEST_ASSERT_EQUAL_UINT32(7, h.count());
+}
+
+void test_quantile_interpolates_inside_bucket()
+{
+  static MetricHistogram h("t_quantile_us", "test");
+  TEST_ASSERT_EQUAL_UINT32(0, h.quantileUs(0.5f)); // kosong
+
+  // 100 sampel di (1000, 3000]: p50 di tengah bucket
+  for (int i = 0; i < 100; i++)
+    h.observeUs(2000);
+  TEST_ASSERT_UINT32_WITHIN(1, 2000, h.quantileUs(0.5f));
+  TEST_ASSERT_UINT32_WITHIN(1, 2980, h.quantileUs(0.99f));
+
+  // 100 sampel lagi di (0, 100]: p25 di bucket pertama
+  for (int i = 0; i < 100; i++)
+    h.observeUs(50);
+  TEST_ASSERT_UINT32_WITHIN(1, 50, h.quantileUs(0.25f));
+  TEST_ASSERT_UINT32_WITHIN(1, 100, h.quantileUs(0.5f)); // tepat di batas atas bucket pertama
+
+  // Mayoritas +Inf: kuantil dibatasi ke batas terakhir
+  for (int i = 0; i < 1000; i++)
+    h.observeUs(5000000);
+  TEST_ASSERT_EQUAL_UINT32(1000000, h.quantileUs(0.99f));
+}
+
+void test_sum_carries_past_32_bit()
+{
+  static MetricHistogram h("t_sum_us", "test");
+  h.observeUs(0xFFFFFF00);
+  h.observeUs(0x200);
+  h.observeUs(0xFFFFFFFF);
+  TEST_ASSERT_TRUE(h.sumUs() == 0xFFFFFF00ULL + 0x200ULL + 0xFFFFFFFFULL);
+}
+
+void test_concurrent_observe_keeps_exact_count()
+{
+  static MetricHistogram h("t_concurrent_us", "test");
+  static MetricCounter c("t_concurrent_total", "test");
+  const int threads = 4, perThread = 250000;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++)
+    workers.push_back(std::thread([&, t]()
+    {
+      for (int i = 0; i < perThread; i++)
+      {
+        h.observeUs((uint32_t)(t * 1000 + i % 5000));
+        c.inc();
+      }
+    }));
+  for (std::thread &w : workers)
+    w.join();
+
+  uint32_t inBuckets = 0;
+  uint64_t expectedSum = 0;
+  for (int b = 0; b < METRIC_BUCKETS; b++)
+    inBuckets += h.bucket(b);
+  for (int t = 0; t < threads; t++)
+    for (int i = 0; i < perThread; i++)
+      expectedSum += (uint32_t)(t * 1000 + i % 5000);
+
+  TEST_ASSERT_EQUAL_UINT32(threads * perThread, h.count());
+  TEST_ASSERT_EQUAL_UINT32(threads * perThread, inBuckets);
+  TEST_ASSERT_EQUAL_UINT32(threads * perThread, c.value());
+  TEST_ASSERT_TRUE(h.sumUs() == expectedSum);
+}
+
+void test_registration_list_newest_first()
+{
+  // Export berjalan dari head(); metric terakhir dibuat ada di depan
+  static MetricCounter a("t_list_a_total", "a");
+  static MetricCounter b("t_list_b_total", "b");
+  TEST_ASSERT_EQUAL_PTR(&b, MetricCounter::head());
+  TEST_ASSERT_EQUAL_PTR(&a, b._next);
+
+  static MetricHistogram h("t_list_us", "h", "unit=\"7\"", 3);
+  TEST_ASSERT_EQUAL_PTR(&h, MetricHistogram::head());
+  TEST_ASSERT_EQUAL_STRING("unit=\"7\"", h._labels);
+  TEST_ASSERT_EQUAL_UINT8(3, h._traceId);
+}
+
+void test_bench_observe()
+{
+  static MetricHistogram h("t_bench_us", "bench");
+  static MetricCounter c("t_bench_total", "bench");
+  uint32_t us = 0;
+  benchRun("histogram observeUs", [&]()
+  { h.observeUs(us = (us * 1103515245u + 12345u) >> 12); });
+  benchRun("counter inc", [&]()
+  { c.inc(); });
+  benchSink += h.count() + c.value();
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_bucket_boundaries_are_inclusive);
+  RUN_TEST(test_quantile_interpolates_inside_bucket);
+  RUN_TEST(test_sum_carries_past_32_bit);
+  RUN_TEST(test_concurrent_observe_keeps_exact_count);
+  RUN_TEST(test_registration_list_newest_first);
+  RUN_TEST(test_bench_observe);
+  return UNITY_END();
+}
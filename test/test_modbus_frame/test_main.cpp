@@ -0,0 +1,248 @@
+// Framing Modbus RTU/TCP (ModbusFrame.hpp): CRC, request, validasi response,
+// encoding slave map. Murni byte buffer, tanpa UART.
+#include <unity.h>
+#include <stdlib.h>
+#include "ModbusFrame.hpp"
+#include "Bench.h"
+
+void setUp() {}
+void tearDown() {}
+
+// CRC16 bit-per-bit (versi lama crcModbus) sebagai referensi tabel
+static uint16_t crcReference(const uint8_t *data, size_t len)
+{
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++)
+  {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+  }
+  return crc;
+}
+
+// Response FC3/FC4 lengkap dengan CRC
+static size_t readResponse(uint8_t *out, uint8_t id, uint8_t fc, const uint16_t *values, uint8_t count)
+{
+  out[0] = id;
+  out[1] = fc;
+  out[2] = count * 2;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    out[3 + 2 * i] = values[i] >> 8;
+    out[4 + 2 * i] = values[i] & 0xFF;
+  }
+  return modbusRtuFinishFrame(out, 3 + 2 * count);
+}
+
+void test_crc_known_vector()
+{
+  const uint8_t req[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x01};
+  TEST_ASSERT_EQUAL_HEX16(0x0A84, modbusCrc16(req, sizeof(req))); // dikirim 84 0A
+}
+
+void test_crc_table_matches_bitwise()
+{
+  uint8_t buf[256];
+  srand(1234);
+  for (int round = 0; round < 200; round++)
+  {
+    size_t len = rand() % sizeof(buf);
+    for (size_t i = 0; i < len; i++)
+      buf[i] = rand();
+    TEST_ASSERT_EQUAL_HEX16(crcReference(buf, len), modbusCrc16(buf, len));
+  }
+}
+
+void test_build_read_request()
+{
+  uint8_t req[MODBUS_READ_REQUEST_LEN];
+  TEST_ASSERT_EQUAL(8, modbusBuildReadRequest(req, 1, 3, 0, 1));
+  const uint8_t expected[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x01, 0x84, 0x0A};
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, req, sizeof(expected));
+
+  modbusBuildReadRequest(req, 17, 4, 0x1234, 10);
+  TEST_ASSERT_EQUAL_HEX8(0x12, req[2]);
+  TEST_ASSERT_EQUAL_HEX8(0x34, req[3]);
+  TEST_ASSERT_EQUAL_HEX8(10, req[5]);
+  TEST_ASSERT_EQUAL_HEX16(modbusCrc16(req, 6), req[6] | (req[7] << 8));
+}
+
+void test_parse_read_block()
+{
+  uint8_t resp[64];
+  const uint16_t regs[] = {0x002A, 0xFFFF, 0x1234};
+  size_t len = readResponse(resp, 7, 3, regs, 3);
+  TEST_ASSERT_EQUAL(modbusReadResponseLen(3), len);
+
+  uint16_t values[3] = {};
+  TEST_ASSERT_EQUAL(MB_FRAME_OK, modbusParseReadBlock(resp, len, 7, 3, 3, values));
+  TEST_ASSERT_EQUAL_UINT16_ARRAY(regs, values, 3);
+
+  uint16_t one = 0;
+  len = readResponse(resp, 7, 4, regs, 1);
+  TEST_ASSERT_EQUAL(MB_FRAME_OK, modbusParseReadResponse(resp, len, 7, 4, &one));
+  TEST_ASSERT_EQUAL_HEX16(0x002A, one);
+}
+
+void test_parse_read_block_errors()
+{
+  uint8_t resp[64];
+  uint16_t values[2];
+  const uint16_t regs[] = {1, 2};
+  size_t len = readResponse(resp, 7, 3, regs, 2);
+
+  TEST_ASSERT_EQUAL(MB_FRAME_SHORT, modbusParseReadBlock(resp, 4, 7, 3, 2, values));
+  TEST_ASSERT_EQUAL(MB_FRAME_SHORT, modbusParseReadBlock(resp, len - 1, 7, 3, 2, values)); // terpotong
+  TEST_ASSERT_EQUAL(MB_FRAME_MISMATCH, modbusParseReadBlock(resp, len, 8, 3, 2, values));  // slave lain
+  TEST_ASSERT_EQUAL(MB_FRAME_MISMATCH, modbusParseReadBlock(resp, len, 7, 4, 2, values));  // FC lain
+  TEST_ASSERT_EQUAL(MB_FRAME_MISMATCH, modbusParseReadBlock(resp, len, 7, 3, 3, values));  // count beda
+
+  resp[4] ^= 0x01; // noise di bus
+  TEST_ASSERT_EQUAL(MB_FRAME_CRC, modbusParseReadBlock(resp, len, 7, 3, 2, values));
+
+  // Exception: 07 83 02 + CRC
+  uint8_t ex[5] = {7, 0x83, 0x02};
+  modbusRtuFinishFrame(ex, 3);
+  TEST_ASSERT_EQUAL(MB_FRAME_EXCEPTION, modbusParseReadBlock(ex, 5, 7, 3, 2, values));
+  ex[2] = 0x03;
+  TEST_ASSERT_EQUAL(MB_FRAME_CRC, modbusParseReadBlock(ex, 5, 7, 3, 2, values));
+}
+
+void test_write_requests_and_echo()
+{
+  uint8_t req[256];
+  uint16_t on = 1;
+  size_t len = modbusBuildWriteRequest(req, 1, 5, 0x0010, 1, &on);
+  TEST_ASSERT_EQUAL(8, len);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, req[4]);
+  TEST_ASSERT_EQUAL(MB_FRAME_OK, modbusParseWriteResponse(req, len, req)); // FC5 = echo
+
+  const uint16_t regs[] = {100, 200, 300};
+  len = modbusBuildWriteRequest(req, 2, 16, 0x0100, 3, regs);
+  TEST_ASSERT_EQUAL(7 + 6 + 2, len);
+  TEST_ASSERT_EQUAL_HEX8(6, req[6]);
+
+  uint8_t resp[8];
+  memcpy(resp, req, 6);
+  modbusRtuFinishFrame(resp, 6);
+  TEST_ASSERT_EQUAL(MB_FRAME_OK, modbusParseWriteResponse(resp, 8, req));
+  resp[5] = 4; // count lain, CRC dihitung ulang
+  modbusRtuFinishFrame(resp, 6);
+  TEST_ASSERT_EQUAL(MB_FRAME_MISMATCH, modbusParseWriteResponse(resp, 8, req));
+
+  const uint16_t coils[] = {1, 0, 1, 1, 0, 0, 0, 0, 1};
+  len = modbusBuildWriteRequest(req, 3, 15, 0, 9, coils);
+  TEST_ASSERT_EQUAL(2, req[6]);
+  TEST_ASSERT_EQUAL_HEX8(0x0D, req[7]);
+  TEST_ASSERT_EQUAL_HEX8(0x01, req[8]);
+  TEST_ASSERT_EQUAL(0, modbusBuildWriteRequest(req, 3, 22, 0, 1, coils)); // FC tidak didukung
+}
+
+void test_parse_read_bits()
+{
+  uint8_t resp[8] = {3, 1, 2, 0x0D, 0x01};
+  size_t len = modbusRtuFinishFrame(resp, 5);
+  uint16_t values[9];
+  TEST_ASSERT_EQUAL(MB_FRAME_OK, modbusParseReadBits(resp, len, 3, 1, 9, values));
+  const uint16_t expected[] = {1, 0, 1, 1, 0, 0, 0, 0, 1};
+  TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, values, 9);
+}
+
+void test_rtu_slave_request_pdu()
+{
+  uint8_t req[MODBUS_READ_REQUEST_LEN];
+  modbusBuildReadRequest(req, 5, 3, 0, 2);
+  TEST_ASSERT_EQUAL(5, modbusRtuRequestPdu(req, sizeof(req), 5));
+  TEST_ASSERT_EQUAL(0, modbusRtuRequestPdu(req, sizeof(req), 6)); // alamat lain
+  req[3] ^= 1;
+  TEST_ASSERT_EQUAL(0, modbusRtuRequestPdu(req, sizeof(req), 5)); // CRC salah
+}
+
+void test_tcp_frame()
+{
+  uint8_t adu[32];
+  TEST_ASSERT_EQUAL(12, modbusTcpBuildReadRequest(adu, 0x0102, 9, 3, 40, 2));
+  TEST_ASSERT_EQUAL(12, modbusTcpFrameLen(adu, 12, 260));
+  TEST_ASSERT_EQUAL(0, modbusTcpFrameLen(adu, 11, 260)); // belum lengkap
+  adu[2] = 1;                                          // protocol ID bukan 0
+  TEST_ASSERT_EQUAL((size_t)-1, modbusTcpFrameLen(adu, 12, 260));
+
+  const uint8_t resp[] = {0x01, 0x02, 0, 0, 0, 7, 9, 3, 4, 0x00, 0x2A, 0x12, 0x34};
+  uint16_t values[2];
+  TEST_ASSERT_EQUAL(MB_FRAME_OK, modbusTcpParseReadBlock(resp, sizeof(resp), 9, 3, 2, values));
+  TEST_ASSERT_EQUAL_HEX16(0x1234, values[1]);
+  TEST_ASSERT_EQUAL(MB_FRAME_MISMATCH, modbusTcpParseReadBlock(resp, sizeof(resp), 8, 3, 2, values));
+}
+
+void test_frame_gap()
+{
+  TEST_ASSERT_EQUAL(4010, modbusRtuFrameGapUs(9600)); // 3.5 x 11 bit
+  TEST_ASSERT_EQUAL(1750, modbusRtuFrameGapUs(115200));
+}
+
+void test_encode_decode_round_trip()
+{
+  uint16_t regs[4];
+  const uint8_t encodings[] = {MB_ENC_INT16, MB_ENC_UINT16, MB_ENC_INT32, MB_ENC_FLOAT32, MB_ENC_UINT32, MB_ENC_INT64, MB_ENC_FLOAT64};
+  for (uint8_t enc : encodings)
+  {
+    for (uint8_t order = MB_ORDER_ABCD; order <= MB_ORDER_DCBA; order++)
+    {
+      modbusEncodeValue(regs, 123.4, 10.0f, enc, order);
+      TEST_ASSERT_FLOAT_WITHIN(0.01f, 123.4f, modbusDecodeValue(regs, 10.0f, enc, order));
+    }
+  }
+
+  modbusEncodeValue(regs, 1.0, 1.0f, MB_ENC_FLOAT32, MB_ORDER_ABCD);
+  TEST_ASSERT_EQUAL_HEX16(0x3F80, regs[0]);
+  modbusEncodeValue(regs, 1.0, 1.0f, MB_ENC_FLOAT32, MB_ORDER_CDAB);
+  TEST_ASSERT_EQUAL_HEX16(0x3F80, regs[1]);
+  modbusEncodeValue(regs, 1e6, 1.0f, MB_ENC_INT16, MB_ORDER_ABCD); // clamp, bukan wrap
+  TEST_ASSERT_EQUAL_HEX16(0x7FFF, regs[0]);
+  modbusEncodeValue(regs, -2.5, 1.0f, MB_ENC_INT16, MB_ORDER_ABCD); // dibulatkan menjauhi nol
+  TEST_ASSERT_EQUAL_HEX16(0xFFFD, regs[0]);
+}
+
+void test_bench_framing()
+{
+  uint8_t req[MODBUS_READ_REQUEST_LEN];
+  uint8_t resp[256];
+  uint16_t regs[32], values[32];
+  for (int i = 0; i < 32; i++)
+    regs[i] = i * 77;
+  size_t len = readResponse(resp, 1, 3, regs, 32);
+  uint16_t addr = 0;
+
+  TEST_ASSERT_GREATER_THAN(0, benchRun("modbusBuildReadRequest", [&]() {
+    modbusBuildReadRequest(req, 1, 3, addr++, 1);
+    benchSink = req[6];
+  }));
+  TEST_ASSERT_GREATER_THAN(0, benchRun("modbusParseReadBlock (32 register)", [&]() {
+    benchSink = modbusParseReadBlock(resp, len, 1, 3, 32, values);
+  }));
+  TEST_ASSERT_GREATER_THAN(0, benchRun("modbusCrc16 tabel (69 byte)", [&]() {
+    benchSink = modbusCrc16(resp, len);
+  }));
+  TEST_ASSERT_GREATER_THAN(0, benchRun("CRC16 bit-per-bit lama (69 byte)", [&]() {
+    benchSink = crcReference(resp, len);
+  }));
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_crc_known_vector);
+  RUN_TEST(test_crc_table_matches_bitwise);
+  RUN_TEST(test_build_read_request);
+  RUN_TEST(test_parse_read_block);
+  RUN_TEST(test_parse_read_block_errors);
+  RUN_TEST(test_write_requests_and_echo);
+  RUN_TEST(test_parse_read_bits);
+  RUN_TEST(test_rtu_slave_request_pdu);
+  RUN_TEST(test_tcp_frame);
+  RUN_TEST(test_frame_gap);
+  RUN_TEST(test_encode_decode_round_trip);
+  RUN_TEST(test_bench_framing);
+  return UNITY_END();
+}
@@ -0,0 +1,250 @@
+// Gateway Modbus TCP -> RTU (ModbusGateway.hpp) dengan UART palsu sebagai bus:
+// sisi TCP (ModbusGatewayPending) dipanggil langsung dengan frame MBAP, bus
+// dilayani service() seperti Task_ModbusClient. Dicek: transaction ID & unit
+// ID kembali ke master yang benar (juga saat read ditumpangkan), timeout bus
+// maupun timeout TCP -> exception 0x0B, balasan terlambat dibuang.
+#include <unity.h>
+#include <map>
+#include <vector>
+#include "MetricTypes.hpp"
+
+MetricCounter mGatewayRequests("t_gateway_requests_total", "test");
+MetricCounter mGatewayCoalesced("t_gateway_coalesced_total", "test");
+MetricCounter mGatewayCacheHits("t_gateway_cache_hits_total", "test");
+MetricCounter mGatewayBusTransactions("t_gateway_bus_transactions_total", "test");
+MetricCounter mModbusErrors("t_modbus_errors_total", "test");
+
+#include "ModbusGateway.hpp"
+#include "Rs485Port.hpp"
+
+#define BUS_TIMEOUT_MS 100
+
+static HardwareSerial uart;
+static Rs485Port port(uart, 1, 16, 17, 4);
+
+// Slave palsu per unit: balas FC3 dengan register berisi unit ID, unit yang
+// tidak terdaftar diam. requests = frame yang benar-benar lewat bus.
+struct FakeBus
+{
+  std::map<uint8_t, int64_t> latencyUs;
+  std::vector<std::vector<uint8_t>> requests;
+
+  void attach()
+  {
+    uart.onTransmit = [this](const uint8_t *data, size_t len) {
+      requests.push_back(std::vector<uint8_t>(data, data + len));
+      auto unit = latencyUs.find(data[0]);
+      if (unit == latencyUs.end())
+        return;
+      uint16_t count = (data[4] << 8) | data[5];
+      std::vector<uint8_t> f(3 + 2 * count + 2);
+      f[0] = data[0];
+      f[1] = data[1];
+      f[2] = count * 2;
+      for (uint16_t i = 0; i < count; i++)
+      {
+        f[3 + 2 * i] = data[0];
+        f[4 + 2 * i] = i;
+      }
+      modbusRtuFinishFrame(f.data(), f.size() - 2);
+      uart.inject(f, fakeNowUs() + (int64_t)len * uart.charUs() + unit->second);
+    };
+  }
+};
+
+// Dipanggil di tengah transaksi bus, setelah balasan diterima: mensimulasikan
+// server TCP (core lain) yang berjalan selama bus sibuk
+static void (*duringBus)() = NULL;
+
+static size_t busTransaction(const uint8_t *frame, size_t len, uint8_t *resp, size_t maxLen, uint8_t, void *)
+{
+  port.send(frame, len);
+  size_t n = port.receive(resp, maxLen, 0, BUS_TIMEOUT_MS);
+  if (duringBus)
+    duringBus();
+  return n;
+}
+
+// Balasan yang sampai ke master, dibingkai seperti ModbusTcpServer::sendFrame
+struct Sent
+{
+  uint8_t client;
+  bool timedOut;
+  std::vector<uint8_t> frame;
+};
+static std::vector<Sent> sent;
+
+static void collect(uint8_t client, const uint8_t *mbap, const uint8_t *pdu, size_t pduLen, bool timedOut, int64_t, void *)
+{
+  Sent s;
+  s.client = client;
+  s.timedOut = timedOut;
+  s.frame.assign(mbap, mbap + 7);
+  s.frame[4] = (pduLen + 1) >> 8;
+  s.frame[5] = (pduLen + 1) & 0xFF;
+  s.frame.insert(s.frame.end(), pdu, pdu + pduLen);
+  sent.push_back(s);
+}
+
+// Read holding register FC3 dalam MBAP: TID, unit, alamat, jumlah
+static std::vector<uint8_t> tcpRead(uint16_t tid, uint8_t unit, uint16_t addr, uint16_t count)
+{
+  return {(uint8_t)(tid >> 8), (uint8_t)tid, 0, 0, 0, 6, unit, 3, (uint8_t)(addr >> 8), (uint8_t)addr,
+          (uint8_t)(count >> 8), (uint8_t)count};
+}
+
+static void add(ModbusGatewayPending &pending, uint8_t client, const std::vector<uint8_t> &frame, uint16_t cacheMs = 0)
+{
+  TEST_ASSERT_TRUE(pending.add(client, frame.data(), frame.size(), cacheMs, fakeNowUs()));
+}
+
+static const Sent &sentTo(uint8_t client)
+{
+  for (const Sent &s : sent)
+  {
+    if (s.client == client)
+      return s;
+  }
+  TEST_FAIL_MESSAGE("no reply for client");
+  return sent[0];
+}
+
+void setUp()
+{
+  fakeClockReset();
+  uart = HardwareSerial();
+  port.begin(9600, 8, 1, "None");
+  sent.clear();
+  duringBus = NULL;
+}
+void tearDown() { port.end(); }
+
+void test_tid_and_unit_mapped_back_to_each_master()
+{
+  ModbusGateway gateway;
+  ModbusGatewayPending pending(gateway);
+  FakeBus bus;
+  bus.latencyUs[5] = 3000;
+  bus.latencyUs[7] = 3000;
+  bus.attach();
+
+  uint32_t busBefore = mGatewayBusTransactions.value();
+  add(pending, 0, tcpRead(0x1234, 5, 0, 2), 500);
+  add(pending, 1, tcpRead(0xBEEF, 5, 0, 2), 500); // identik: menumpang
+  add(pending, 2, tcpRead(0x0001, 7, 0, 1), 500);
+  gateway.service(busTransaction, NULL);
+  pending.deliver(fakeNowUs(), collect, NULL);
+
+  TEST_ASSERT_EQUAL(2, bus.requests.size());
+  TEST_ASSERT_EQUAL_UINT32(2, mGatewayBusTransactions.value() - busBefore);
+  TEST_ASSERT_EQUAL(3, sent.size());
+  TEST_ASSERT_EQUAL(0, pending.count());
+
+  const uint8_t a[] = {0x12, 0x34, 0, 0, 0, 7, 5, 3, 4, 5, 0, 5, 1};
+  const uint8_t b[] = {0xBE, 0xEF, 0, 0, 0, 7, 5, 3, 4, 5, 0, 5, 1};
+  const uint8_t c[] = {0x00, 0x01, 0, 0, 0, 5, 7, 3, 2, 7, 0};
+  TEST_ASSERT_EQUAL(sizeof(a), sentTo(0).frame.size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(a, sentTo(0).frame.data(), sizeof(a));
+  TEST_ASSERT_EQUAL(sizeof(b), sentTo(1).frame.size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(b, sentTo(1).frame.data(), sizeof(b));
+  TEST_ASSERT_EQUAL(sizeof(c), sentTo(2).frame.size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(c, sentTo(2).frame.data(), sizeof(c));
+  TEST_ASSERT_FALSE(sentTo(0).timedOut);
+}
+
+void test_silent_unit_gets_exception_0b()
+{
+  ModbusGateway gateway;
+  ModbusGatewayPending pending(gateway);
+  FakeBus bus; // unit 9 tidak terdaftar: diam
+  bus.attach();
+
+  add(pending, 3, tcpRead(0x0042, 9, 10, 1));
+  int64_t t0 = fakeNowUs();
+  gateway.service(busTransaction, NULL);
+  TEST_ASSERT_GREATER_OR_EQUAL(BUS_TIMEOUT_MS * 1000LL, fakeNowUs() - t0);
+  pending.deliver(fakeNowUs(), collect, NULL);
+
+  const uint8_t ex[] = {0x00, 0x42, 0, 0, 0, 3, 9, 0x83, MODBUS_EX_GATEWAY_TARGET};
+  TEST_ASSERT_EQUAL(1, sent.size());
+  TEST_ASSERT_EQUAL(sizeof(ex), sent[0].frame.size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(ex, sent[0].frame.data(), sizeof(ex));
+  TEST_ASSERT_FALSE(sent[0].timedOut); // dari bus, bukan timeout TCP
+}
+
+void test_tcp_timeout_gets_exception_0b()
+{
+  ModbusGateway gateway;
+  ModbusGatewayPending pending(gateway);
+  add(pending, 1, tcpRead(0x0777, 5, 0, 1));
+  int64_t rxUs = fakeNowUs();
+
+  // Bus tidak pernah melayani (mis. scan panjang): belum ada yang dikirim
+  pending.deliver(rxUs + MODBUS_TCP_GATEWAY_TIMEOUT_MS * 1000LL, collect, NULL);
+  TEST_ASSERT_EQUAL(0, sent.size());
+  pending.deliver(rxUs + MODBUS_TCP_GATEWAY_TIMEOUT_MS * 1000LL + 1, collect, NULL);
+
+  const uint8_t ex[] = {0x07, 0x77, 0, 0, 0, 3, 5, 0x83, MODBUS_EX_GATEWAY_TARGET};
+  TEST_ASSERT_EQUAL(1, sent.size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(ex, sent[0].frame.data(), sizeof(ex));
+  TEST_ASSERT_TRUE(sent[0].timedOut);
+  TEST_ASSERT_EQUAL(0, pending.count());
+
+  // Semua peminta sudah menyerah: request tidak lagi dikirim ke bus
+  FakeBus bus;
+  bus.attach();
+  gateway.service(busTransaction, NULL);
+  TEST_ASSERT_EQUAL(0, bus.requests.size());
+}
+
+static ModbusGatewayPending *latePending;
+
+static void tcpTimesOutDuringBus()
+{
+  fakeAdvanceUs(MODBUS_TCP_GATEWAY_TIMEOUT_MS * 1000LL);
+  latePending->deliver(fakeNowUs(), collect, NULL);
+}
+
+void test_late_reply_dropped()
+{
+  ModbusGateway gateway;
+  ModbusGatewayPending pending(gateway);
+  FakeBus bus;
+  bus.latencyUs[5] = 3000;
+  bus.attach();
+
+  // Timeout TCP lewat selagi transaksi di bus: master dapat 0x0B
+  add(pending, 0, tcpRead(0x0100, 5, 0, 2), 1000);
+  latePending = &pending;
+  duringBus = tcpTimesOutDuringBus;
+  gateway.service(busTransaction, NULL);
+  duringBus = NULL;
+  TEST_ASSERT_EQUAL(1, sent.size());
+  TEST_ASSERT_TRUE(sent[0].timedOut);
+  TEST_ASSERT_EQUAL_HEX8(0x83, sent[0].frame[7]);
+
+  // Balasan terlambat tidak dikirim ke siapa pun...
+  pending.deliver(fakeNowUs(), collect, NULL);
+  TEST_ASSERT_EQUAL(1, sent.size());
+
+  // ...dan tidak disimpan sebagai cache: read identik berikutnya ke bus lagi
+  uint32_t hits = mGatewayCacheHits.value();
+  add(pending, 1, tcpRead(0x0101, 5, 0, 2), 1000);
+  gateway.service(busTransaction, NULL);
+  pending.deliver(fakeNowUs(), collect, NULL);
+  TEST_ASSERT_EQUAL(2, bus.requests.size());
+  TEST_ASSERT_EQUAL_UINT32(hits, mGatewayCacheHits.value());
+  TEST_ASSERT_EQUAL(2, sent.size());
+  TEST_ASSERT_EQUAL_HEX8(0x01, sent[1].frame[1]); // TID 0x0101
+  TEST_ASSERT_EQUAL_HEX8(3, sent[1].frame[7]);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_tid_and_unit_mapped_back_to_each_master);
+  RUN_TEST(test_silent_unit_gets_exception_0b);
+  RUN_TEST(test_tcp_timeout_gets_exception_0b);
+  RUN_TEST(test_late_reply_dropped);
+  return UNITY_END();
+}
@@ -0,0 +1,239 @@
+// Planner blok + client Modbus TCP (ModbusTcpClient.hpp) terhadap simulator
+// TCP lokal di 127.0.0.1: pipelining dengan TID, koneksi persisten, exception,
+// timeout, peer menutup koneksi, dan backoff target yang tidak terjangkau.
+// Jam real-time (socket sungguhan), jadi test timeout berjalan ~1 detik.
+#include <unity.h>
+#include <map>
+#include "MetricTypes.hpp"
+
+MetricCounter mModbusTcpRequests("t_tcp_requests_total", "test");
+MetricCounter mModbusTcpFailures("t_tcp_failures_total", "test");
+MetricCounter mModbusTcpConnects("t_tcp_connects_total", "test");
+MetricHistogram mModbusTcpTransaction("t_tcp_transaction_seconds", "test");
+
+#include "ModbusTcpClient.hpp"
+#include "ModbusTcpSim.h"
+#include "Bench.h"
+
+struct Tag
+{
+  uint8_t slaveId, fc;
+  uint16_t reg;
+  uint8_t target;
+};
+
+struct BlockResult
+{
+  uint8_t status = 0xFF; // belum selesai
+  uint16_t values[MODBUS_BLOCK_MAX_REGS];
+  uint32_t calls = 0;
+};
+
+static ModbusTcpSim simA, simB;
+static ModbusTcpTarget targets[3];
+static ModbusBlock blocks[64];
+static uint8_t order[64];
+static std::map<uint16_t, BlockResult> results;
+
+static void onBlock(uint16_t block, uint8_t status, const uint16_t *values, uint32_t, void *)
+{
+  BlockResult &r = results[block];
+  r.status = status;
+  r.calls++;
+  if (status == MB_FRAME_OK)
+    memcpy(r.values, values, blocks[block].count * 2);
+}
+
+// Satu scan penuh seperti Task_ModbusClient (tanpa blok RS-485)
+static uint32_t runScan(ModbusTcpClient &client, uint16_t blockCount, uint8_t targetCount)
+{
+  results.clear();
+  uint32_t startMs = millis();
+  client.startScan(blocks, blockCount, targets, targetCount);
+  while (client.poll(onBlock, NULL) && millis() - startMs < 5000)
+    usleep(100);
+  return millis() - startMs;
+}
+
+static void assertBlockValues(uint16_t b)
+{
+  const ModbusBlock &blk = blocks[b];
+  TEST_ASSERT_EQUAL_UINT8(MB_FRAME_OK, results[b].status);
+  TEST_ASSERT_EQUAL_UINT32(1, results[b].calls);
+  for (uint16_t r = 0; r < blk.count; r++)
+    TEST_ASSERT_EQUAL_UINT16(ModbusTcpSim::valueOf(blk.unit, blk.start + r), results[b].values[r]);
+}
+
+void setUp()
+{
+  simA.silentUnit = 0;
+  simA.reorder = false;
+}
+void tearDown() {}
+
+void test_planner_groups_by_target_unit_fc()
+{
+  const Tag tags[] = {
+      {1, 3, 10, 1}, {1, 3, 0, 1}, {1, 3, 2, 1}, {1, 3, 1, 1}, // t1 u1: 0..10 (celah 7)
+      {1, 3, 200, 1},                                        // celah > 8: blok baru
+      {2, 4, 5, 1}, {1, 3, 0, 0}, {1, 3, 0, 2}, {1, 3, 2, 1}}; // reg sama: ikut blok
+  size_t n = modbusPlanBlocks(tags, sizeof(tags) / sizeof(tags[0]), order, blocks);
+
+  TEST_ASSERT_EQUAL(5, n);
+  TEST_ASSERT_EQUAL_UINT8(0, blocks[0].target); // RS-485 dulu
+  TEST_ASSERT_EQUAL_UINT8(1, blocks[1].target);
+  TEST_ASSERT_EQUAL_UINT16(0, blocks[1].start);
+  TEST_ASSERT_EQUAL_UINT16(11, blocks[1].count);
+  TEST_ASSERT_EQUAL_UINT8(5, blocks[1].tagCount);
+  TEST_ASSERT_EQUAL_UINT16(200, blocks[2].start);
+  TEST_ASSERT_EQUAL_UINT8(2, blocks[3].unit);
+  TEST_ASSERT_EQUAL_UINT8(4, blocks[3].fc);
+  TEST_ASSERT_EQUAL_UINT8(2, blocks[4].target);
+
+  // Batas 125 register per request
+  Tag wide[20];
+  for (uint8_t i = 0; i < 20; i++)
+    wide[i] = {1, 4, (uint16_t)(i * 8), 1};
+  n = modbusPlanBlocks(wide, 20, order, blocks);
+  TEST_ASSERT_EQUAL(2, n);
+  TEST_ASSERT_TRUE(blocks[0].count <= MODBUS_BLOCK_MAX_REGS);
+  TEST_ASSERT_EQUAL_UINT16(blocks[0].start + blocks[0].count + 7, blocks[1].start);
+}
+
+void test_pipelined_scan_matches_replies_by_tid()
+{
+  // 6 blok di A (dijawab terbalik), 2 blok di B, koneksi dipakai ulang
+  Tag tags[] = {{1, 3, 0, 1}, {1, 3, 100, 1}, {1, 4, 0, 1}, {2, 3, 10, 1}, {3, 3, 0, 1}, {3, 4, 900, 1},
+                {7, 3, 0, 2}, {7, 3, 40, 2}}; // celah > 8: tiap tag satu blok
+  uint16_t n = modbusPlanBlocks(tags, 8, order, blocks);
+  TEST_ASSERT_EQUAL(8, n);
+  simA.reorder = true;
+  uint32_t acceptedA = simA.accepted, acceptedB = simB.accepted;
+
+  ModbusTcpClient client;
+  for (int scan = 0; scan < 3; scan++)
+  {
+    runScan(client, n, 2);
+    for (uint16_t b = 0; b < n; b++)
+      assertBlockValues(b);
+  }
+  TEST_ASSERT_EQUAL_UINT32(acceptedA + 1, simA.accepted); // persisten antar scan
+  TEST_ASSERT_EQUAL_UINT32(acceptedB + 1, simB.accepted);
+  TEST_ASSERT_TRUE(simA.maxPending >= 2);                 // benar-benar pipelined
+  TEST_ASSERT_TRUE(simA.maxPending <= MODBUS_TCP_MAX_INFLIGHT);
+}
+
+void test_exception_fails_only_its_block()
+{
+  Tag tags[] = {{1, 3, 0, 1}, {1, 3, 995, 1}, {1, 3, 20, 1}};
+  uint16_t n = modbusPlanBlocks(tags, 3, order, blocks);
+  blocks[2].count = 10; // start 995 + 10 > 1000 -> exception 02
+  ModbusTcpClient client;
+  uint32_t accepted = simA.accepted;
+
+  runScan(client, n, 1);
+  assertBlockValues(0);
+  assertBlockValues(1);
+  TEST_ASSERT_EQUAL_UINT8(MB_FRAME_EXCEPTION, results[2].status);
+  runScan(client, n, 1);
+  TEST_ASSERT_EQUAL_UINT32(accepted + 1, simA.accepted); // exception tidak memutus koneksi
+}
+
+void test_timeout_closes_and_reconnects()
+{
+  Tag tags[] = {{1, 3, 0, 1}, {9, 3, 0, 1}};
+  uint16_t n = modbusPlanBlocks(tags, 2, order, blocks);
+  simA.silentUnit = 9;
+  ModbusTcpClient client;
+  uint32_t accepted = simA.accepted;
+  uint32_t failures = mModbusTcpFailures.value();
+
+  uint32_t ms = runScan(client, n, 1);
+  assertBlockValues(0);
+  TEST_ASSERT_EQUAL_UINT8(MB_FRAME_TIMEOUT, results[1].status);
+  TEST_ASSERT_EQUAL_UINT32(1, results[1].calls);
+  TEST_ASSERT_TRUE(ms >= MODBUS_TCP_TIMEOUT_MS && ms < MODBUS_TCP_TIMEOUT_MS + 500);
+  TEST_ASSERT_EQUAL_UINT32(failures + 1, mModbusTcpFailures.value());
+
+  // Koneksi ditutup setelah timeout (stream bisa tidak sinkron): dibuka ulang
+  simA.silentUnit = 0;
+  runScan(client, n, 1);
+  assertBlockValues(0);
+  assertBlockValues(1);
+  TEST_ASSERT_EQUAL_UINT32(accepted + 2, simA.accepted);
+}
+
+void test_peer_close_reconnects_next_scan()
+{
+  Tag tags[] = {{4, 4, 0, 1}};
+  uint16_t n = modbusPlanBlocks(tags, 1, order, blocks);
+  ModbusTcpClient client;
+  runScan(client, n, 1);
+  assertBlockValues(0);
+  uint32_t accepted = simA.accepted;
+
+  simA.dropClients();
+  usleep(20000);
+  runScan(client, n, 1);
+  assertBlockValues(0);
+  TEST_ASSERT_EQUAL_UINT32(accepted + 1, simA.accepted);
+}
+
+void test_unreachable_target_backs_off()
+{
+  // Port yang baru saja ditutup: connect ditolak seketika
+  ModbusTcpSim closed;
+  uint16_t deadPort = closed.start();
+  closed.stop();
+  targets[2] = {IPAddress(127, 0, 0, 1), deadPort};
+
+  Tag tags[] = {{1, 3, 0, 1}, {1, 3, 0, 3}, {1, 3, 50, 3}};
+  uint16_t n = modbusPlanBlocks(tags, 3, order, blocks);
+  ModbusTcpClient client;
+  uint32_t connects = mModbusTcpConnects.value();
+
+  uint32_t ms = runScan(client, n, 3);
+  assertBlockValues(0);
+  TEST_ASSERT_EQUAL_UINT8(MB_FRAME_TIMEOUT, results[1].status);
+  TEST_ASSERT_EQUAL_UINT8(MB_FRAME_TIMEOUT, results[2].status);
+  TEST_ASSERT_TRUE(ms < 200); // target mati tidak menahan scan
+
+  // Scan berikutnya masih dalam MODBUS_TCP_RETRY_MS: tidak connect lagi
+  runScan(client, n, 3);
+  assertBlockValues(0);
+  TEST_ASSERT_EQUAL_UINT8(MB_FRAME_TIMEOUT, results[1].status);
+  TEST_ASSERT_EQUAL_UINT32(connects + 2, mModbusTcpConnects.value()); // A + target mati, sekali
+}
+
+void test_bench_tcp_scan()
+{
+  Tag tags[8];
+  for (uint8_t i = 0; i < 8; i++)
+    tags[i] = {(uint8_t)(1 + i), 3, 0, 1};
+  uint16_t n = modbusPlanBlocks(tags, 8, order, blocks);
+  for (uint16_t b = 0; b < n; b++)
+    blocks[b].count = 20;
+  ModbusTcpClient client;
+  benchRun("tcp scan 8 blok x 20 reg (loopback)", [&]()
+  { benchSink += runScan(client, n, 1); });
+}
+
+int main(int, char **)
+{
+  fakeClockRealtime() = true;
+  targets[0] = {IPAddress(127, 0, 0, 1), simA.start()};
+  targets[1] = {IPAddress(127, 0, 0, 1), simB.start()};
+
+  UNITY_BEGIN();
+  RUN_TEST(test_planner_groups_by_target_unit_fc);
+  RUN_TEST(test_pipelined_scan_matches_replies_by_tid);
+  RUN_TEST(test_exception_fails_only_its_block);
+  RUN_TEST(test_timeout_closes_and_reconnects);
+  RUN_TEST(test_peer_close_reconnects_next_scan);
+  RUN_TEST(test_unreachable_target_backs_off);
+  RUN_TEST(test_bench_tcp_scan);
+  int failures = UNITY_END();
+  simA.stop();
+  simB.stop();
+  return failures;
+}
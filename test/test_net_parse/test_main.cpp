@@ -0,0 +1,61 @@
+// Parsing IP statis dari config (NetParse.hpp), dipakai configNetwork()
+// untuk WiFi & Ethernet.
+#include <unity.h>
+#include <Arduino.h>
+#include "NetParse.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+static void assertIp(const int *expected, const IpAddressSplit &got)
+{
+  for (int i = 0; i < 5; i++)
+    TEST_ASSERT_EQUAL_INT(expected[i], got.ip[i]);
+}
+
+void test_dotted_quad()
+{
+  const int expected[] = {192, 168, 1, 10, 0};
+  assertIp(expected, parsingIP("192.168.1.10"));
+}
+
+void test_comma_separator()
+{
+  const int expected[] = {10, 0, 0, 1, 0};
+  assertIp(expected, parsingIP("10,0,0,1"));
+}
+
+void test_empty_and_missing_fields_are_zero()
+{
+  const int zero[] = {0, 0, 0, 0, 0};
+  assertIp(zero, parsingIP(""));
+  const int partial[] = {192, 168, 0, 1, 0};
+  assertIp(partial, parsingIP("192.168..1"));
+  const int garbage[] = {255, 0, 0, 0, 0};
+  assertIp(garbage, parsingIP("255.x.y"));
+}
+
+void test_extra_fields_capped_at_five()
+{
+  const int expected[] = {1, 2, 3, 4, 5};
+  assertIp(expected, parsingIP("1.2.3.4.5.6.7"));
+}
+
+void test_from_config_string()
+{
+  // Sama seperti pemanggil: parsingIP(networkSettings.ipAddress.c_str())
+  String ipAddress = "172.16.0.254";
+  const int expected[] = {172, 16, 0, 254, 0};
+  assertIp(expected, parsingIP(ipAddress.c_str()));
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_dotted_quad);
+  RUN_TEST(test_comma_separator);
+  RUN_TEST(test_empty_and_missing_fields_are_zero);
+  RUN_TEST(test_extra_fields_capped_at_five);
+  RUN_TEST(test_from_config_string);
+  return UNITY_END();
+}
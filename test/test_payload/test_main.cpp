@@ -0,0 +1,121 @@
+// Payload kirim / simpan SD (Payload.hpp): jsonSend -> array record,
+// serialize ke FixedString (buffer kirim) dan ke file SD palsu.
+#include <unity.h>
+#include <ArduinoJson.h>
+#include <SD.h>
+#include "FixedString.hpp"
+#include "Payload.hpp"
+#include "Bench.h"
+
+static DynamicJsonDocument jsonSend(1024);
+static DynamicJsonDocument docNew(4096);
+static FixedString<2048> sendString;
+
+void setUp()
+{
+  jsonSend.clear();
+  jsonSend["-"] = 0; // placeholder, tidak ikut dikirim
+  jsonSend["AI1"] = 1.234;
+  jsonSend["Flow"] = 12.5;
+  docNew.clear();
+  sendString.clear();
+  SD.format();
+}
+void tearDown() {}
+
+void test_record_fields_with_time_and_job()
+{
+  JsonArray array = docNew.to<JsonArray>();
+  TEST_ASSERT_EQUAL(2, buildSensorPayload(jsonSend.as<JsonObjectConst>(), array, "2026-10-19 10:00:00", "JOB-1234"));
+  serializeJson(docNew, sendString);
+  TEST_ASSERT_FALSE(sendString.overflowed());
+  TEST_ASSERT_EQUAL_STRING(
+      "[{\"KodeSensor\":\"AI1\",\"additional\":{\"jobnum\":\"JOB-1234\"},\"StringWaktu\":\"2026-10-19 10:00:00\",\"Value\":\"1.23\"},"
+      "{\"KodeSensor\":\"Flow\",\"additional\":{\"jobnum\":\"JOB-1234\"},\"StringWaktu\":\"2026-10-19 10:00:00\",\"Value\":\"12.50\"}]",
+      sendString.c_str());
+}
+
+void test_online_record_without_time_and_job()
+{
+  JsonArray array = docNew.to<JsonArray>();
+  buildSensorPayload(jsonSend.as<JsonObjectConst>(), array, NULL, NULL);
+  serializeJson(docNew, sendString);
+  TEST_ASSERT_EQUAL_STRING("[{\"KodeSensor\":\"AI1\",\"Value\":\"1.23\"},{\"KodeSensor\":\"Flow\",\"Value\":\"12.50\"}]",
+                           sendString.c_str());
+}
+
+void test_overflow_is_reported_not_written_past_buffer()
+{
+  FixedString<32> small;
+  JsonArray array = docNew.to<JsonArray>();
+  buildSensorPayload(jsonSend.as<JsonObjectConst>(), array, NULL, NULL);
+  serializeJson(docNew, small);
+  TEST_ASSERT_TRUE(small.overflowed());
+  TEST_ASSERT_EQUAL(31, small.length());
+}
+
+void test_sd_record_lines()
+{
+  // Seperti saveToSD(): satu baris JSON per simpan di /sensor_data.csv
+  for (int i = 0; i < 2; i++)
+  {
+    jsonSend["AI1"] = 1.0 + i;
+    docNew.clear();
+    sendString.clear();
+    buildSensorPayload(jsonSend.as<JsonObjectConst>(), docNew.to<JsonArray>(), "2026-10-19 10:00:00", NULL);
+    serializeJson(docNew, sendString);
+    File f = SD.open("/sensor_data.csv", FILE_APPEND);
+    TEST_ASSERT_TRUE((bool)f);
+    f.println(sendString.c_str());
+    f.close();
+  }
+
+  File f = SD.open("/sensor_data.csv", FILE_READ);
+  for (int i = 0; i < 2; i++)
+  {
+    char line[512];
+    size_t n = 0;
+    int c;
+    while ((c = f.read()) >= 0 && c != '\n')
+      line[n++] = (char)c;
+    line[n] = '\0';
+    StaticJsonDocument<1024> row;
+    TEST_ASSERT_EQUAL(DeserializationError::Ok, deserializeJson(row, line).code());
+    TEST_ASSERT_EQUAL(2, row.size());
+    TEST_ASSERT_EQUAL_STRING(i == 0 ? "1.00" : "2.00", row[0]["Value"].as<const char *>());
+    TEST_ASSERT_EQUAL_STRING("2026-10-19 10:00:00", row[0]["StringWaktu"].as<const char *>());
+  }
+  TEST_ASSERT_EQUAL(-1, f.read());
+}
+
+void test_bench_per_send()
+{
+  // 16 kanal (4 AI + 4 DI + 8 tag Modbus), jalur kirim periodik
+  jsonSend.clear();
+  char key[8];
+  for (int i = 0; i < 16; i++)
+  {
+    snprintf(key, sizeof(key), "CH%d", i);
+    jsonSend[key] = i * 1.5;
+  }
+  double ns = benchRun("buildSensorPayload + serializeJson (16 kanal)", [&]() {
+    docNew.clear();
+    sendString.clear();
+    buildSensorPayload(jsonSend.as<JsonObjectConst>(), docNew.to<JsonArray>(), "2026-10-19 10:00:00", "JOB-1234");
+    serializeJson(docNew, sendString);
+    benchSink = sendString.length();
+  });
+  TEST_ASSERT_GREATER_THAN(0, ns);
+  TEST_ASSERT_FALSE(sendString.overflowed());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_record_fields_with_time_and_job);
+  RUN_TEST(test_online_record_without_time_and_job);
+  RUN_TEST(test_overflow_is_reported_not_written_past_buffer);
+  RUN_TEST(test_sd_record_lines);
+  RUN_TEST(test_bench_per_send);
+  return UNITY_END();
+}
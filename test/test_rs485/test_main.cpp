@@ -0,0 +1,177 @@
+// Transaksi master RS-485 (Rs485Port::send / receive, dipakai
+// rs485Transaction di Task_ModbusClient) terhadap UART palsu: tunggu byte
+// pertama, baca sampai panjang diketahui / exception / jeda t3.5.
+#include <unity.h>
+#include <vector>
+#include "Rs485Port.hpp"
+
+static HardwareSerial uart;
+static Rs485Port port(uart, 1, 16, 17, 4);
+
+// Slave palsu: balas setiap request setelah latencyUs (dihitung dari akhir
+// request di bus). reply kosong = diam (timeout).
+struct FakeSlave
+{
+  int64_t latencyUs = 3000;
+  std::vector<uint8_t> reply;
+  std::vector<uint8_t> lastRequest;
+
+  void attach()
+  {
+    uart.onTransmit = [this](const uint8_t *data, size_t len) {
+      lastRequest.assign(data, data + len);
+      if (!reply.empty())
+        uart.inject(reply, fakeNowUs() + (int64_t)len * uart.charUs() + latencyUs);
+    };
+  }
+};
+
+static std::vector<uint8_t> readReply(uint8_t id, uint8_t fc, std::vector<uint16_t> regs)
+{
+  std::vector<uint8_t> f(3 + 2 * regs.size() + 2);
+  f[0] = id;
+  f[1] = fc;
+  f[2] = regs.size() * 2;
+  for (size_t i = 0; i < regs.size(); i++)
+  {
+    f[3 + 2 * i] = regs[i] >> 8;
+    f[4 + 2 * i] = regs[i] & 0xFF;
+  }
+  modbusRtuFinishFrame(f.data(), f.size() - 2);
+  return f;
+}
+
+void setUp()
+{
+  fakeClockReset();
+  uart = HardwareSerial();
+  port.begin(9600, 8, 1, "None");
+}
+void tearDown() { port.end(); }
+
+void test_read_block_complete_frame()
+{
+  FakeSlave slave;
+  slave.reply = readReply(1, 3, {0x002A, 0x0100});
+  slave.attach();
+
+  uint8_t req[MODBUS_READ_REQUEST_LEN], resp[64];
+  modbusBuildReadRequest(req, 1, 3, 0, 2);
+  port.send(req, sizeof(req));
+  size_t n = port.receive(resp, sizeof(resp), modbusReadResponseLen(2), 100);
+
+  TEST_ASSERT_EQUAL(9, n);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(req, slave.lastRequest.data(), sizeof(req));
+  uint16_t values[2];
+  TEST_ASSERT_EQUAL(MB_FRAME_OK, modbusParseReadBlock(resp, n, 1, 3, 2, values));
+  TEST_ASSERT_EQUAL_HEX16(0x0100, values[1]);
+  // Panjang diketahui: berhenti di byte terakhir, tanpa menunggu t3.5
+  // (8 byte TX + 3 ms + 9 byte RX di 9600 baud ~ 20.7 ms, ditambah tick yield)
+  TEST_ASSERT_LESS_THAN(24000, (int)fakeNowUs());
+}
+
+void test_timeout_when_slave_silent()
+{
+  FakeSlave slave;
+  slave.attach();
+  uint8_t req[MODBUS_READ_REQUEST_LEN], resp[64];
+  modbusBuildReadRequest(req, 9, 3, 0, 1);
+  port.send(req, sizeof(req));
+  int64_t t0 = fakeNowUs();
+  TEST_ASSERT_EQUAL(0, port.receive(resp, sizeof(resp), 7, 100));
+  TEST_ASSERT_GREATER_OR_EQUAL(100000, (int)(fakeNowUs() - t0));
+  TEST_ASSERT_LESS_THAN(102000, (int)(fakeNowUs() - t0));
+}
+
+void test_exception_reply_stops_after_five_bytes()
+{
+  FakeSlave slave;
+  slave.reply = {1, 0x83, 0x02, 0, 0};
+  modbusRtuFinishFrame(slave.reply.data(), 3);
+  slave.attach();
+
+  uint8_t req[MODBUS_READ_REQUEST_LEN], resp[64];
+  modbusBuildReadRequest(req, 1, 3, 0, 10);
+  port.send(req, sizeof(req));
+  size_t n = port.receive(resp, sizeof(resp), modbusReadResponseLen(10), 100);
+  TEST_ASSERT_EQUAL(5, n);
+  uint16_t values[10];
+  TEST_ASSERT_EQUAL(MB_FRAME_EXCEPTION, modbusParseReadBlock(resp, n, 1, 3, 10, values));
+}
+
+void test_unknown_length_ends_on_bus_silence()
+{
+  // Gateway TCP->RTU: panjang balasan tidak diketahui (expectedLen 0)
+  FakeSlave slave;
+  slave.reply = readReply(2, 4, {1, 2, 3});
+  slave.attach();
+  uint8_t req[MODBUS_READ_REQUEST_LEN], resp[64];
+  modbusBuildReadRequest(req, 2, 4, 0, 3);
+  port.send(req, sizeof(req));
+  int64_t t0 = fakeNowUs();
+  size_t n = port.receive(resp, sizeof(resp), 0, 100);
+  TEST_ASSERT_EQUAL(11, n);
+  // Selesai = byte terakhir + jeda t3.5 (4.01 ms di 9600)
+  int64_t lastByteAt = t0 + 3000 + 10 * uart.charUs();
+  TEST_ASSERT_GREATER_THAN((int)(lastByteAt + port.frameGapUs()), (int)fakeNowUs());
+  TEST_ASSERT_LESS_THAN((int)(lastByteAt + port.frameGapUs() + 3000), (int)fakeNowUs());
+}
+
+void test_truncated_reply_returns_partial_frame()
+{
+  FakeSlave slave;
+  slave.reply = readReply(1, 3, {7, 8, 9});
+  slave.reply.resize(6); // slave reset di tengah frame
+  slave.attach();
+  uint8_t req[MODBUS_READ_REQUEST_LEN], resp[64];
+  modbusBuildReadRequest(req, 1, 3, 0, 3);
+  port.send(req, sizeof(req));
+  size_t n = port.receive(resp, sizeof(resp), modbusReadResponseLen(3), 100);
+  TEST_ASSERT_EQUAL(6, n);
+  uint16_t values[3];
+  TEST_ASSERT_EQUAL(MB_FRAME_SHORT, modbusParseReadBlock(resp, n, 1, 3, 3, values));
+}
+
+void test_stale_bytes_flushed_before_request()
+{
+  const uint8_t noise[] = {0xFF, 0x00, 0x55};
+  uart.inject(noise, sizeof(noise), 0);
+  fakeAdvanceUs(5000);
+
+  FakeSlave slave;
+  slave.reply = readReply(1, 3, {0x1234});
+  slave.attach();
+  uint8_t req[MODBUS_READ_REQUEST_LEN], resp[64];
+  modbusBuildReadRequest(req, 1, 3, 0, 1);
+  port.send(req, sizeof(req));
+  size_t n = port.receive(resp, sizeof(resp), modbusReadResponseLen(1), 100);
+  uint16_t value;
+  TEST_ASSERT_EQUAL(MB_FRAME_OK, modbusParseReadResponse(resp, n, 1, 3, &value));
+  TEST_ASSERT_EQUAL_HEX16(0x1234, value);
+}
+
+void test_response_never_overflows_buffer()
+{
+  FakeSlave slave;
+  slave.reply.assign(100, 0x2A); // sampah panjang tanpa bit exception
+  slave.attach();
+  uint8_t req[MODBUS_READ_REQUEST_LEN], resp[16 + 1];
+  resp[16] = 0x5A; // penjaga
+  modbusBuildReadRequest(req, 1, 3, 0, 1);
+  port.send(req, sizeof(req));
+  TEST_ASSERT_EQUAL(16, port.receive(resp, 16, 0, 100));
+  TEST_ASSERT_EQUAL_HEX8(0x5A, resp[16]);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_read_block_complete_frame);
+  RUN_TEST(test_timeout_when_slave_silent);
+  RUN_TEST(test_exception_reply_stops_after_five_bytes);
+  RUN_TEST(test_unknown_length_ends_on_bus_silence);
+  RUN_TEST(test_truncated_reply_returns_partial_frame);
+  RUN_TEST(test_stale_bytes_flushed_before_request);
+  RUN_TEST(test_response_never_overflows_buffer);
+  return UNITY_END();
+}
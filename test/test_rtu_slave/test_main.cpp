@@ -0,0 +1,179 @@
+// Slave Modbus RTU (ModbusRtuSlave.hpp) dilihat dari sisi master lewat UART
+// palsu: request disuntik byte per byte di jam virtual, slave di-poll tiap
+// tick 1 ms seperti Task_ModbusRtuSlave. Latency = byte terakhir request ->
+// byte pertama balasan di bus; batasnya t3.5 (dibulatkan ke tick) + 1 tick.
+#include <unity.h>
+#include <vector>
+#include "MetricTypes.hpp"
+
+MetricCounter mSlaveRequests("t_slave_requests_total", "test");
+MetricCounter mSlaveExceptions("t_slave_exceptions_total", "test");
+MetricHistogram mSlaveRequestRtu("t_slave_request_seconds", "test");
+
+#include "ModbusRtuSlave.hpp"
+#include "ModbusRegisterTable.hpp"
+
+#define SLAVE_ID 7
+#define TICK_US 1000
+
+static HardwareSerial uart;
+static Rs485Port port(uart, 1, 16, 17, 4);
+static ModbusRtuSlave slave;
+static ModbusRegisterTable table;
+
+// Balasan yang dikirim slave + waktu mulai kirim (jam virtual)
+struct Reply
+{
+  std::vector<uint8_t> frame;
+  int64_t startUs = -1;
+};
+static Reply reply;
+
+static size_t tablePdu(const uint8_t *req, size_t len, uint8_t *resp, void *ctx)
+{
+  return ((ModbusRegisterTable *)ctx)->processRead(req, len, resp);
+}
+
+void setUp()
+{
+  fakeClockReset();
+  uart = HardwareSerial();
+  uart.onTransmit = [](const uint8_t *data, size_t len) {
+    if (reply.startUs < 0)
+      reply.startUs = fakeNowUs();
+    reply.frame.insert(reply.frame.end(), data, data + len);
+  };
+  slave.reset();
+  reply = Reply();
+
+  ModbusRegisterTable::Bank &bank = table.beginWrite();
+  for (uint16_t a = 0; a < MODBUS_SLAVE_REGS; a++)
+    bank.hreg[a] = bank.ireg[a] = 0x4000 + a;
+  table.commit();
+}
+void tearDown() { port.end(); }
+
+// Master: request masuk mulai atUs; poll slave tiap tick sampai balasan
+// selesai dikirim atau timeoutUs. Hasil: latency (us), -1 = tidak dijawab.
+static int64_t transact(const uint8_t *req, size_t len, int64_t atUs, int64_t timeoutUs = 50000)
+{
+  reply = Reply();
+  uart.inject(req, len, atUs);
+  int64_t lastByteUs = atUs + (int64_t)(len - 1) * uart.charUs();
+  while (reply.startUs < 0 && fakeNowUs() < atUs + timeoutUs)
+  {
+    slave.poll(port, SLAVE_ID, tablePdu, &table);
+    vTaskDelay(1);
+  }
+  return reply.startUs < 0 ? -1 : reply.startUs - lastByteUs;
+}
+
+static int64_t boundUs()
+{
+  int64_t gapTicks = (port.frameGapUs() + TICK_US - 1) / TICK_US;
+  return (gapTicks + 1) * TICK_US;
+}
+
+void test_read_holding_registers_reply()
+{
+  port.begin(19200, 8, 1, "None");
+  uint8_t req[MODBUS_READ_REQUEST_LEN];
+  modbusBuildReadRequest(req, SLAVE_ID, 3, 10, 3);
+  uint32_t served = mSlaveRequests.value();
+
+  int64_t latency = transact(req, sizeof(req), fakeNowUs() + 300);
+  TEST_ASSERT_TRUE(latency >= 0);
+  TEST_ASSERT_EQUAL(5 + 3 * 2, reply.frame.size());
+  TEST_ASSERT_EQUAL_HEX8(SLAVE_ID, reply.frame[0]);
+  TEST_ASSERT_EQUAL_HEX8(3, reply.frame[1]);
+  TEST_ASSERT_EQUAL(6, reply.frame[2]);
+  uint16_t values[3];
+  TEST_ASSERT_EQUAL(MB_FRAME_OK, modbusParseReadBlock(reply.frame.data(), reply.frame.size(), SLAVE_ID, 3, 3, values));
+  TEST_ASSERT_EQUAL_HEX16(0x400A, values[0]);
+  TEST_ASSERT_EQUAL_HEX16(0x400C, values[2]);
+  TEST_ASSERT_EQUAL_UINT32(served + 1, mSlaveRequests.value());
+}
+
+void test_other_id_and_bad_crc_stay_silent()
+{
+  port.begin(19200, 8, 1, "None");
+  uint8_t req[MODBUS_READ_REQUEST_LEN];
+  modbusBuildReadRequest(req, SLAVE_ID + 1, 3, 0, 1);
+  TEST_ASSERT_EQUAL(-1, transact(req, sizeof(req), fakeNowUs() + 100));
+
+  modbusBuildReadRequest(req, SLAVE_ID, 3, 0, 1);
+  req[sizeof(req) - 1] ^= 0x55;
+  TEST_ASSERT_EQUAL(-1, transact(req, sizeof(req), fakeNowUs() + 100));
+  TEST_ASSERT_TRUE(uart.tx.empty());
+}
+
+void test_illegal_address_is_exception()
+{
+  port.begin(19200, 8, 1, "None");
+  uint8_t req[MODBUS_READ_REQUEST_LEN];
+  modbusBuildReadRequest(req, SLAVE_ID, 4, MODBUS_SLAVE_REGS - 1, 2);
+  uint32_t exceptions = mSlaveExceptions.value();
+  TEST_ASSERT_TRUE(transact(req, sizeof(req), fakeNowUs() + 100) >= 0);
+  TEST_ASSERT_EQUAL(5, reply.frame.size());
+  TEST_ASSERT_EQUAL_HEX8(0x84, reply.frame[1]);
+  TEST_ASSERT_EQUAL_HEX8(MODBUS_EX_ILLEGAL_ADDRESS, reply.frame[2]);
+  TEST_ASSERT_EQUAL_UINT32(exceptions + 1, mSlaveExceptions.value());
+}
+
+void test_back_to_back_requests_both_answered()
+{
+  // Request kedua datang tepat setelah balasan pertama selesai di bus
+  port.begin(38400, 8, 1, "None");
+  uint8_t req[MODBUS_READ_REQUEST_LEN];
+  modbusBuildReadRequest(req, SLAVE_ID, 3, 0, 2);
+  TEST_ASSERT_TRUE(transact(req, sizeof(req), fakeNowUs() + 100) >= 0);
+  modbusBuildReadRequest(req, SLAVE_ID, 3, 100, 2);
+  TEST_ASSERT_TRUE(transact(req, sizeof(req), fakeNowUs()) >= 0);
+  TEST_ASSERT_EQUAL_HEX16(0x4064, (reply.frame[3] << 8) | reply.frame[4]);
+}
+
+// Fase kedatangan request terhadap tick digeser 0..999 us: latency harus
+// selalu di [t3.5, bound], dilaporkan min/rata-rata/maks per baud
+void test_latency_within_gap_plus_tick()
+{
+  const long bauds[] = {9600, 19200, 115200};
+  for (long baud : bauds)
+  {
+    setUp();
+    port.begin(baud, 8, 1, "None");
+    uint8_t req[MODBUS_READ_REQUEST_LEN];
+    modbusBuildReadRequest(req, SLAVE_ID, 3, 0, 10);
+
+    int64_t minUs = INT64_MAX, maxUs = 0, sumUs = 0, endToEndMax = 0;
+    const int runs = 200;
+    for (int i = 0; i < runs; i++)
+    {
+      int64_t phase = (i * 37) % TICK_US;
+      int64_t latency = transact(req, sizeof(req), fakeNowUs() + phase);
+      TEST_ASSERT_TRUE(latency >= 0);
+      TEST_ASSERT_TRUE(latency >= (int64_t)port.frameGapUs());
+      TEST_ASSERT_TRUE(latency <= boundUs());
+      minUs = latency < minUs ? latency : minUs;
+      maxUs = latency > maxUs ? latency : maxUs;
+      sumUs += latency;
+      int64_t endToEnd = latency + (int64_t)reply.frame.size() * uart.charUs();
+      endToEndMax = endToEnd > endToEndMax ? endToEnd : endToEndMax;
+    }
+    printf("[LATENCY] RTU slave %ld baud: t3.5 %u us, request->reply %lld/%lld/%lld us (min/avg/max, batas %lld), "
+           "sampai balasan lengkap maks %lld us\n",
+           baud, (unsigned)port.frameGapUs(), (long long)minUs, (long long)(sumUs / runs), (long long)maxUs,
+           (long long)boundUs(), (long long)endToEndMax);
+    port.end();
+  }
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_read_holding_registers_reply);
+  RUN_TEST(test_other_id_and_bad_crc_stay_silent);
+  RUN_TEST(test_illegal_address_is_exception);
+  RUN_TEST(test_back_to_back_requests_both_answered);
+  RUN_TEST(test_latency_within_gap_plus_tick);
+  return UNITY_END();
+}
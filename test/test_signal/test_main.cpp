@@ -0,0 +1,139 @@
+// Per-sampel AI: low-pass, mapping per tipe input, skala & kalibrasi
+// (SignalMath.hpp), dengan ADS1115 palsu sebagai sumber count.
+#include <unity.h>
+#include <ADS1X15.h>
+#include "SignalMath.hpp"
+#include "Bench.h"
+
+void setUp() { fakeClockReset(); }
+void tearDown() {}
+
+static AnalogChannelConfig channel(uint8_t type, bool scaling = false, float lo = 0, float hi = 0)
+{
+  AnalogChannelConfig ai = {};
+  ai.type = type;
+  ai.scaling = scaling;
+  ai.lowLimit = lo;
+  ai.highLimit = hi;
+  return ai;
+}
+
+void test_low_pass_alpha()
+{
+  // fc 1 Hz, Ts 0.1 s: RC = 1/(2 pi) -> alpha = Ts / (RC + Ts)
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.38587f, lowPassAlpha(1.0f));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, lowPassAlpha(0.005f)); // di bawah 0.01 Hz: tanpa filter
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, lowPassAlpha(0.0f));
+}
+
+void test_low_pass_step()
+{
+  TEST_ASSERT_EQUAL_FLOAT(123.0f, lowPassStep(123.0f, 7.0f, 0.0f)); // alpha 0 = raw
+  TEST_ASSERT_EQUAL_FLOAT(50.0f, lowPassStep(100.0f, 0.0f, 0.5f));
+  TEST_ASSERT_EQUAL_FLOAT(10.0f, lowPassStep(10.0f, NAN, 0.5f));         // state rusak -> raw
+  TEST_ASSERT_EQUAL_FLOAT(31000.0f, lowPassStep(31000.0f, 31000.0f, 0.5f)); // di luar range -> raw
+}
+
+void test_filter_sensor_matches_precomputed_alpha()
+{
+  float alpha = lowPassAlpha(0.5f);
+  TEST_ASSERT_EQUAL_FLOAT(lowPassStep(2000.0f, 1000.0f, alpha), filterSensor(2000.0f, 1000.0f, 0.5f));
+}
+
+void test_map_float_rounds_to_two_decimals()
+{
+  TEST_ASSERT_EQUAL_FLOAT(4.0f, mapFloat(AI_ADC_1V, AI_ADC_1V, AI_ADC_5V, 4.0f, 20.0f));
+  TEST_ASSERT_EQUAL_FLOAT(20.0f, mapFloat(AI_ADC_5V, AI_ADC_1V, AI_ADC_5V, 4.0f, 20.0f));
+  TEST_ASSERT_EQUAL_FLOAT(12.0f, mapFloat(16000.0f, AI_ADC_1V, AI_ADC_5V, 4.0f, 20.0f));
+  TEST_ASSERT_EQUAL_FLOAT(1.23f, mapFloat(1.234567f, 0.0f, 1.0f, 0.0f, 1.0f));
+  TEST_ASSERT_EQUAL_FLOAT(-1.23f, mapFloat(-1.234567f, 0.0f, 1.0f, 0.0f, 1.0f));
+}
+
+void test_analog_sample_per_type()
+{
+  TEST_ASSERT_EQUAL_FLOAT(12.0f, analogSample(channel(AI_TYPE_4_20MA), 16000.0f));
+  TEST_ASSERT_EQUAL_FLOAT(10.0f, analogSample(channel(AI_TYPE_0_20MA), AI_ADC_5V / 2));
+  TEST_ASSERT_EQUAL_FLOAT(5.0f, analogSample(channel(AI_TYPE_0_10V), AI_ADC_5V / 2));
+  // Di bawah live zero tetap linear: 0 V -> 0 mA (loop putus terlihat di data)
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, analogSample(channel(AI_TYPE_4_20MA), 0.0f));
+}
+
+void test_analog_sample_scaling_and_calibration()
+{
+  AnalogChannelConfig ai = channel(AI_TYPE_4_20MA, true, 0.0f, 10.0f); // 0..10 bar
+  TEST_ASSERT_EQUAL_FLOAT(5.0f, analogSample(ai, 16000.0f));
+
+  ai.calibration = true;
+  ai.mValue = 2.0f;
+  ai.cValue = 1.0f;
+  TEST_ASSERT_EQUAL_FLOAT(11.0f, analogSample(ai, 16000.0f));
+
+  ai.mValue = 0.0f; // slope 0 tidak valid -> 1
+  TEST_ASSERT_EQUAL_FLOAT(6.0f, analogSample(ai, 16000.0f));
+
+  ai.scaling = false; // kalibrasi hanya berlaku bersama scaling
+  TEST_ASSERT_EQUAL_FLOAT(12.0f, analogSample(ai, 16000.0f));
+}
+
+// Siklus akuisisi 100 ms seperti Task_DataAcquisition: step 0 -> 20000 count
+// dari ADS1115 palsu lewat filter 1 Hz, respons orde 1 tanpa overshoot
+void test_acquisition_step_response()
+{
+  ADS1115 ads;
+  ads.source = [](uint8_t ch, int64_t) -> int16_t { return ch == 0 ? 20000 : 0; };
+  AnalogChannelConfig ai = channel(AI_TYPE_0_10V);
+  ai.filter = true;
+  ai.filterAlpha = lowPassAlpha(1.0f);
+
+  float adcValue = 0, expected = 0;
+  for (int n = 1; n <= 20; n++)
+  {
+    adcValue = lowPassStep(ads.readADC(0), adcValue, ai.filterAlpha);
+    expected = 20000.0f * (1.0f - powf(1.0f - ai.filterAlpha, n));
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, expected, adcValue);
+    delay(100);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, mapFloat(adcValue, 0.0f, AI_ADC_5V, 0.0f, 10.0f), analogSample(ai, adcValue));
+  TEST_ASSERT_EQUAL_UINT32(20, ads.reads);
+  TEST_ASSERT_GREATER_OR_EQUAL(2000, (int)millis()); // jam palsu ikut maju
+}
+
+void test_bench_per_sample()
+{
+  AnalogChannelConfig ai = channel(AI_TYPE_4_20MA, true, 0.0f, 10.0f);
+  ai.calibration = true;
+  ai.mValue = 1.01f;
+  ai.filterAlpha = lowPassAlpha(1.0f);
+  float y = 0, x = 12000;
+
+  double ns = benchRun("filterSensor (alpha per sampel, versi lama)", [&]() {
+    y = filterSensor(x, y, 1.0f);
+    x = x < 20000 ? x + 1 : 12000;
+  });
+  TEST_ASSERT_GREATER_THAN(0, ns);
+  ns = benchRun("lowPassStep + analogSample (alpha dari snapshot)", [&]() {
+    y = lowPassStep(x, y, ai.filterAlpha);
+    benchSink = (uint32_t)analogSample(ai, y);
+    x = x < 20000 ? x + 1 : 12000;
+  });
+  TEST_ASSERT_GREATER_THAN(0, ns);
+  ns = benchRun("mapFloat", [&]() {
+    benchSink = (uint32_t)mapFloat(x, AI_ADC_1V, AI_ADC_5V, 4.0f, 20.0f);
+    x = x < 20000 ? x + 1 : 12000;
+  });
+  TEST_ASSERT_GREATER_THAN(0, ns);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_low_pass_alpha);
+  RUN_TEST(test_low_pass_step);
+  RUN_TEST(test_filter_sensor_matches_precomputed_alpha);
+  RUN_TEST(test_map_float_rounds_to_two_decimals);
+  RUN_TEST(test_analog_sample_per_type);
+  RUN_TEST(test_analog_sample_scaling_and_calibration);
+  RUN_TEST(test_acquisition_step_response);
+  RUN_TEST(test_bench_per_sample);
+  return UNITY_END();
+}
@@ -0,0 +1,186 @@
+// Tabel register Modbus slave (ModbusRegisterTable.hpp): jawaban FC1-4,
+// exception, dan double buffer (reader tidak pernah melihat blok setengah
+// ditulis saat writer terus meng-update dari thread lain).
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "ModbusFrame.hpp"
+#include "ModbusRegisterTable.hpp"
+#include "Bench.h"
+
+static ModbusRegisterTable table;
+static uint8_t resp[MODBUS_PDU_MAX];
+
+void setUp() {}
+void tearDown() {}
+
+static size_t readPdu(uint8_t fc, uint16_t addr, uint16_t qty)
+{
+  const uint8_t req[5] = {fc, (uint8_t)(addr >> 8), (uint8_t)addr, (uint8_t)(qty >> 8), (uint8_t)qty};
+  return table.processRead(req, sizeof(req), resp);
+}
+
+static uint16_t respReg(uint16_t i) { return (resp[2 + 2 * i] << 8) | resp[3 + 2 * i]; }
+
+void test_fc3_fc4_read_registers()
+{
+  ModbusRegisterTable::Bank &bank = table.beginWrite();
+  for (uint16_t a = 0; a < MODBUS_SLAVE_REGS; a++)
+  {
+    bank.hreg[a] = 0x1000 + a;
+    bank.ireg[a] = 0x2000 + a;
+  }
+  table.commit();
+
+  TEST_ASSERT_EQUAL(2 + 3 * 2, readPdu(3, 10, 3));
+  TEST_ASSERT_EQUAL_HEX8(3, resp[0]);
+  TEST_ASSERT_EQUAL(6, resp[1]);
+  TEST_ASSERT_EQUAL_HEX16(0x100A, respReg(0));
+  TEST_ASSERT_EQUAL_HEX16(0x100C, respReg(2));
+
+  // Batas atas: 125 register berakhir tepat di alamat terakhir
+  TEST_ASSERT_EQUAL(2 + 125 * 2, readPdu(4, MODBUS_SLAVE_REGS - 125, 125));
+  TEST_ASSERT_EQUAL_HEX8(4, resp[0]);
+  TEST_ASSERT_EQUAL_HEX16(0x2000 + MODBUS_SLAVE_REGS - 125, respReg(0));
+  TEST_ASSERT_EQUAL_HEX16(0x2000 + MODBUS_SLAVE_REGS - 1, respReg(124));
+}
+
+void test_float32_value_roundtrip_through_table()
+{
+  // Seperti ModbusSlave::update(): nilai di-encode ke IR, master decode lagi
+  ModbusRegisterTable::Bank &bank = table.beginWrite();
+  modbusEncodeValue(&bank.ireg[20], 123.45, 1.0f, MB_ENC_FLOAT32, MB_ORDER_CDAB);
+  table.commit();
+
+  readPdu(4, 20, 2);
+  uint16_t regs[2] = {respReg(0), respReg(1)};
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 123.45f, modbusDecodeValue(regs, 1.0f, MB_ENC_FLOAT32, MB_ORDER_CDAB));
+}
+
+void test_fc1_fc2_read_bits()
+{
+  ModbusRegisterTable::Bank &bank = table.beginWrite();
+  memset(bank.coil, 0, sizeof(bank.coil));
+  memset(bank.ists, 0, sizeof(bank.ists));
+  for (uint16_t a = 0; a < MODBUS_SLAVE_REGS; a += 3)
+    ModbusRegisterTable::setBit(bank.coil, a, true); // 0, 3, 6, 9, ...
+  ModbusRegisterTable::setBit(bank.ists, 255, true);
+  table.commit();
+
+  // Mulai di alamat 1: bit ke-i = alamat 1+i -> set di i = 2, 5, 8
+  TEST_ASSERT_EQUAL(2 + 2, readPdu(1, 1, 10));
+  TEST_ASSERT_EQUAL_HEX8(1, resp[0]);
+  TEST_ASSERT_EQUAL(2, resp[1]);
+  TEST_ASSERT_EQUAL_HEX8(0x24, resp[2]); // bit 2, 5
+  TEST_ASSERT_EQUAL_HEX8(0x01, resp[3]); // bit 8, sisa byte terakhir nol
+
+  TEST_ASSERT_EQUAL(2 + 1, readPdu(2, 255, 1));
+  TEST_ASSERT_EQUAL_HEX8(0x01, resp[2]);
+  TEST_ASSERT_EQUAL(2 + 1, readPdu(2, 0, 8));
+  TEST_ASSERT_EQUAL_HEX8(0x00, resp[2]);
+}
+
+void test_exceptions()
+{
+  TEST_ASSERT_EQUAL(2, readPdu(6, 0, 1));
+  TEST_ASSERT_EQUAL_HEX8(0x86, resp[0]);
+  TEST_ASSERT_EQUAL_HEX8(MODBUS_EX_ILLEGAL_FUNCTION, resp[1]);
+
+  TEST_ASSERT_EQUAL(2, readPdu(3, 0, 0));
+  TEST_ASSERT_EQUAL_HEX8(0x83, resp[0]);
+  TEST_ASSERT_EQUAL_HEX8(MODBUS_EX_ILLEGAL_VALUE, resp[1]);
+  readPdu(4, 0, 126);
+  TEST_ASSERT_EQUAL_HEX8(MODBUS_EX_ILLEGAL_VALUE, resp[1]);
+  readPdu(1, 0, 2001);
+  TEST_ASSERT_EQUAL_HEX8(MODBUS_EX_ILLEGAL_VALUE, resp[1]);
+
+  readPdu(3, MODBUS_SLAVE_REGS - 1, 2);
+  TEST_ASSERT_EQUAL_HEX8(0x83, resp[0]);
+  TEST_ASSERT_EQUAL_HEX8(MODBUS_EX_ILLEGAL_ADDRESS, resp[1]);
+  readPdu(2, 0xFFFF, 1); // addr + qty tidak boleh wrap 16-bit
+  TEST_ASSERT_EQUAL_HEX8(MODBUS_EX_ILLEGAL_ADDRESS, resp[1]);
+
+  // PDU terpotong
+  const uint8_t shortReq[3] = {3, 0, 0};
+  TEST_ASSERT_EQUAL(2, table.processRead(shortReq, sizeof(shortReq), resp));
+  TEST_ASSERT_EQUAL_HEX8(MODBUS_EX_ILLEGAL_VALUE, resp[1]);
+  TEST_ASSERT_EQUAL(0, table.processRead(shortReq, 0, resp));
+}
+
+void test_reader_never_sees_torn_block()
+{
+  // Writer: seluruh HR diisi satu generasi 32-bit (pasangan hi/lo) per
+  // update. Reader: 62 pasangan dalam satu blok harus sama, dan generasi
+  // tidak pernah mundur.
+  // Bank aktif masih berisi pola test sebelumnya (0x1000 + a): isi dulu
+  // generasi 0 seragam, supaya reader yang mulai sebelum commit pertama
+  // writer tidak membaca blok "sobek" palsu.
+  ModbusRegisterTable::Bank &seed = table.beginWrite();
+  for (uint16_t a = 0; a < MODBUS_SLAVE_REGS; a++)
+    seed.hreg[a] = 0;
+  table.commit();
+
+  std::atomic<bool> run{true};
+  std::thread writer([&]()
+  {
+    uint32_t gen = 0;
+    while (run.load(std::memory_order_relaxed))
+    {
+      ModbusRegisterTable::Bank &bank = table.beginWrite();
+      gen++;
+      for (uint16_t a = 0; a < MODBUS_SLAVE_REGS; a += 2)
+      {
+        bank.hreg[a] = gen >> 16;
+        bank.hreg[a + 1] = gen & 0xFFFF;
+      }
+      table.commit();
+    }
+  });
+
+  uint32_t torn = 0, backwards = 0, changes = 0;
+  uint32_t last = 0;
+  for (uint32_t i = 0; i < 200000; i++)
+  {
+    readPdu(3, (uint16_t)(i % 50) * 2, 124);
+    uint32_t first = ((uint32_t)respReg(0) << 16) | respReg(1);
+    for (uint16_t r = 2; r < 124; r += 2)
+      if ((((uint32_t)respReg(r) << 16) | respReg(r + 1)) != first)
+      {
+        torn++;
+        break;
+      }
+    if (first < last)
+      backwards++;
+    if (first != last)
+      changes++;
+    last = first;
+  }
+  run = false;
+  writer.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+  TEST_ASSERT_EQUAL_UINT32(0, backwards);
+  TEST_ASSERT_TRUE(changes > 0); // writer benar-benar berjalan bersamaan
+}
+
+void test_bench_process_read()
+{
+  benchRun("slave FC3 10 register", [&]()
+  { benchSink += readPdu(3, 10, 10); });
+  benchRun("slave FC3 125 register", [&]()
+  { benchSink += readPdu(3, 0, 125); });
+  benchRun("slave FC1 64 coil", [&]()
+  { benchSink += readPdu(1, 0, 64); });
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_fc3_fc4_read_registers);
+  RUN_TEST(test_float32_value_roundtrip_through_table);
+  RUN_TEST(test_fc1_fc2_read_bits);
+  RUN_TEST(test_exceptions);
+  RUN_TEST(test_reader_never_sees_torn_block);
+  RUN_TEST(test_bench_process_read);
+  return UNITY_END();
+}
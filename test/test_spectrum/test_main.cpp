@@ -0,0 +1,174 @@
+// Fitur getaran (Spectrum.hpp) dengan sinyal sintetis: FFT dibanding DFT
+// langsung, lalu RMS / crest / frekuensi dominan / RMS per pita dibanding
+// nilai analitis sinyal uji.
+#include <unity.h>
+#include <stdlib.h>
+#include "Spectrum.hpp"
+#include "Bench.h"
+
+#define FS 10000.0f
+
+static SpectrumAnalyzer analyzer; // ~10 KB buffer, seperti di firmware (global)
+static float signal[SPECTRUM_MAX_N];
+
+void setUp() {}
+void tearDown() {}
+
+// DFT kompleks O(m^2) dalam double sebagai referensi
+static void dft(const float *in, double *out, uint16_t m)
+{
+  for (uint16_t k = 0; k < m; k++)
+  {
+    double re = 0, im = 0;
+    for (uint16_t t = 0; t < m; t++)
+    {
+      double a = -2.0 * M_PI * k * t / m;
+      re += in[2 * t] * cos(a) - in[2 * t + 1] * sin(a);
+      im += in[2 * t] * sin(a) + in[2 * t + 1] * cos(a);
+    }
+    out[2 * k] = re;
+    out[2 * k + 1] = im;
+  }
+}
+
+// Error maksimum FFT vs DFT, relatif terhadap magnitudo terbesar
+static double fftError(uint16_t n)
+{
+  uint16_t m = n / 2;
+  static float data[SPECTRUM_MAX_N], in[SPECTRUM_MAX_N];
+  static double ref[SPECTRUM_MAX_N];
+  srand(n);
+  for (uint16_t i = 0; i < 2 * m; i++)
+    in[i] = data[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+  TEST_ASSERT_TRUE(analyzer.init(n));
+  analyzer.fft(data, m);
+  dft(in, ref, m);
+
+  double maxErr = 0, maxMag = 0;
+  for (uint16_t k = 0; k < m; k++)
+  {
+    maxErr = fmax(maxErr, hypot(data[2 * k] - ref[2 * k], data[2 * k + 1] - ref[2 * k + 1]));
+    maxMag = fmax(maxMag, hypot(ref[2 * k], ref[2 * k + 1]));
+  }
+  return maxErr / maxMag;
+}
+
+static void sine(uint16_t n, float dc, float a1, float f1, float a2, float f2)
+{
+  for (uint16_t i = 0; i < n; i++)
+  {
+    float t = i / FS;
+    signal[i] = dc + a1 * sinf(2.0f * (float)M_PI * f1 * t) + a2 * sinf(2.0f * (float)M_PI * f2 * t);
+  }
+}
+
+void test_init_rejects_bad_sizes()
+{
+  TEST_ASSERT_FALSE(analyzer.init(0));
+  TEST_ASSERT_FALSE(analyzer.init(4));
+  TEST_ASSERT_FALSE(analyzer.init(1000));
+  TEST_ASSERT_FALSE(analyzer.init(2048));
+  TEST_ASSERT_TRUE(analyzer.init(8));
+  TEST_ASSERT_TRUE(analyzer.init(SPECTRUM_MAX_N));
+  TEST_ASSERT_EQUAL_UINT16(SPECTRUM_MAX_N, analyzer.size());
+}
+
+void test_fft_matches_dft()
+{
+  // Kernel dipakai untuk m = n/2 titik kompleks
+  TEST_ASSERT_LESS_THAN(1e-5, fftError(16));
+  TEST_ASSERT_LESS_THAN(1e-5, fftError(256));
+  TEST_ASSERT_LESS_THAN(1e-5, fftError(1024));
+}
+
+void test_two_tone_features()
+{
+  // 1 + 2 sin(120 Hz) + 0.5 sin(1500 Hz), fs 10 kHz, N 1024
+  const float edges[] = {10, 500, 1000, 2000};
+  VibrationFeatures f;
+  TEST_ASSERT_TRUE(analyzer.init(1024));
+  sine(1024, 1.0f, 2.0f, 120.0f, 0.5f, 1500.0f);
+  analyzer.analyze(signal, FS, edges, 3, f);
+
+  float binHz = FS / 1024;
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 1.0f, f.mean); // 12.3 periode 120 Hz: sisa setengah periode
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, sqrtf(2.0f * 2.0f / 2 + 0.5f * 0.5f / 2), f.rms); // 1.458
+  TEST_ASSERT_FLOAT_WITHIN(binHz / 4, 120.0f, f.domFreq);
+  TEST_ASSERT_FLOAT_WITHIN(0.3f, 2.0f, f.domAmp); // Hann di luar bin: scalloping s.d. -1.4 dB
+  TEST_ASSERT_EQUAL_UINT8(3, f.bandCount);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.0f / sqrtf(2), f.bandRms[0]);  // 10-500 Hz: hanya 120 Hz
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, f.bandRms[1]);             // 500-1000 Hz: kosong
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.5f / sqrtf(2), f.bandRms[2]);  // 1-2 kHz: 1500 Hz
+}
+
+void test_off_bin_sine()
+{
+  // 437.3 Hz tidak jatuh di bin (9.77 Hz): interpolasi parabola
+  const float edges[] = {0, 5000};
+  VibrationFeatures f;
+  TEST_ASSERT_TRUE(analyzer.init(1024));
+  sine(1024, 0.0f, 1.0f, 437.3f, 0.0f, 0.0f);
+  analyzer.analyze(signal, FS, edges, 1, f);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 1.0f / sqrtf(2), f.rms);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, sqrtf(2), f.crest);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 437.3f, f.domFreq);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, f.rms, f.bandRms[0]); // satu pita penuh = RMS total
+}
+
+void test_impulse_train_has_high_crest()
+{
+  const float edges[] = {0, 5000};
+  VibrationFeatures f;
+  TEST_ASSERT_TRUE(analyzer.init(1024));
+  for (uint16_t i = 0; i < 1024; i++)
+    signal[i] = i % 100 == 0 ? 1.0f : 0.0f; // ketukan bearing, 100 Hz
+  analyzer.analyze(signal, FS, edges, 1, f);
+
+  TEST_ASSERT_GREATER_THAN(8.0f, f.crest);
+  TEST_ASSERT_FLOAT_WITHIN(0.3f, 1.0f - f.mean, f.peak);
+}
+
+void test_bands_clamped_to_max()
+{
+  const float edges[] = {0, 100, 200, 300, 400, 500, 600, 700, 800};
+  VibrationFeatures f;
+  TEST_ASSERT_TRUE(analyzer.init(256));
+  sine(256, 0.0f, 1.0f, 250.0f, 0.0f, 0.0f);
+  analyzer.analyze(signal, FS, edges, 8, f);
+  TEST_ASSERT_EQUAL_UINT8(SPECTRUM_MAX_BANDS, f.bandCount);
+}
+
+void test_bench_analyze()
+{
+  const float edges[] = {10, 500, 1000, 2000};
+  VibrationFeatures f;
+  analyzer.init(1024);
+  sine(1024, 1.0f, 2.0f, 120.0f, 0.5f, 1500.0f);
+  benchRun("analyze N=1024 (3 pita)", [&]()
+  {
+    analyzer.analyze(signal, FS, edges, 3, f);
+    benchSink += (uint32_t)f.domFreq;
+  });
+
+  static float data[SPECTRUM_MAX_N];
+  benchRun("fft m=512 (real N=1024)", [&]()
+  {
+    memcpy(data, signal, sizeof(data));
+    analyzer.fft(data, 512);
+    benchSink += (uint32_t)data[2];
+  });
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_init_rejects_bad_sizes);
+  RUN_TEST(test_fft_matches_dft);
+  RUN_TEST(test_two_tone_features);
+  RUN_TEST(test_off_bin_sine);
+  RUN_TEST(test_impulse_train_has_high_crest);
+  RUN_TEST(test_bands_clamped_to_max);
+  RUN_TEST(test_bench_analyze);
+  return UNITY_END();
+}
@@ -0,0 +1,233 @@
+// Trace ring per core (Trace.hpp): isi export Chrome trace, ring yang
+// melingkar, jendela waktu, tabel nama task, response chunked kecil, dan
+// writer paralel di dua "core" selama export berjalan.
+#include <unity.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Trace.hpp"
+#include "Bench.h"
+
+void setUp() { fakeClockReset(); }
+void tearDown() {}
+
+// Export lengkap sebagai string (chunk kecil: jalur "buffer penuh" ikut jalan)
+static std::string exportTrace(TraceBuffer &tb, uint32_t windowMs, size_t chunk = 512)
+{
+  AsyncWebServerRequest request;
+  tb.sendChromeTrace(&request, windowMs);
+  TEST_ASSERT_EQUAL(200, request.code);
+  TEST_ASSERT_NOT_NULL(request.response);
+  return request.response->drain(chunk);
+}
+
+struct Counts
+{
+  int meta = 0, begin = 0, end = 0, other = 0;
+};
+
+// Parse JSON export; hitung event per fase. lastTs = ts event terakhir core.
+static Counts parseTrace(const std::string &json, int core = -1, long *lastTs = nullptr)
+{
+  DynamicJsonDocument doc(256 * 1024);
+  TEST_ASSERT_FALSE(deserializeJson(doc, json));
+  Counts c;
+  for (JsonVariant e : doc["traceEvents"].as<JsonArray>())
+  {
+    const char *ph = e["ph"] | "";
+    if (!strcmp(ph, "M"))
+    {
+      c.meta++;
+      continue;
+    }
+    if (core >= 0 && (e["pid"] | -1) != core)
+      continue;
+    if (!strcmp(ph, "B"))
+      c.begin++;
+    else if (!strcmp(ph, "E"))
+      c.end++;
+    else
+      c.other++;
+    if (lastTs)
+      *lastTs = e["ts"] | 0L;
+  }
+  return c;
+}
+
+void test_export_is_chrome_trace_json()
+{
+  std::unique_ptr<TraceBuffer> tb(new TraceBuffer);
+  fakeTaskBegin("Task_Modbus", 1);
+  fakeAdvanceUs(1000);
+  tb->record(TR_MODBUS_TX, 'B');
+  fakeAdvanceUs(250);
+  tb->record(TR_MODBUS_TX, 'E');
+  tb->record(TR_NONE, 'B'); // diabaikan
+
+  std::thread core0([&]()
+  {
+    fakeTaskBegin("Task_DAQ", 0);
+    tb->record(TR_ADC_READ, 'B');
+    tb->record(TR_ADC_READ, 'E');
+  });
+  core0.join();
+
+  std::string json = exportTrace(*tb, 1000);
+  Counts all = parseTrace(json);
+  TEST_ASSERT_EQUAL(2, all.begin);
+  TEST_ASSERT_EQUAL(2, all.end);
+  TEST_ASSERT_EQUAL(0, all.other);
+  // 2 nama core + 2 task x 2 core + "other"
+  TEST_ASSERT_EQUAL(2 + 4 + 1, all.meta);
+  TEST_ASSERT_TRUE(json.find("\"name\":\"modbus_tx\",\"ph\":\"B\",\"ts\":1000,\"pid\":1,\"tid\":0") != std::string::npos);
+  TEST_ASSERT_TRUE(json.find("\"name\":\"adc_read\",\"ph\":\"E\",\"ts\":1250,\"pid\":0,\"tid\":1") != std::string::npos);
+  TEST_ASSERT_TRUE(json.find("\"name\":\"Task_DAQ\"") != std::string::npos);
+}
+
+void test_small_chunks_produce_same_body()
+{
+  std::unique_ptr<TraceBuffer> tb(new TraceBuffer);
+  fakeTaskBegin("loopTask", 1);
+  for (int i = 0; i < 300; i++)
+  {
+    fakeAdvanceUs(10);
+    tb->record(TR_SD_WRITE, i % 2 ? 'E' : 'B');
+  }
+  std::string whole = exportTrace(*tb, 1000, 64 * 1024);
+  std::string chunked = exportTrace(*tb, 1000, 512);
+  TEST_ASSERT_TRUE(whole == chunked);
+  TEST_ASSERT_EQUAL(300, parseTrace(chunked).begin + parseTrace(chunked).end);
+}
+
+void test_ring_keeps_newest_events_per_core()
+{
+  std::unique_ptr<TraceBuffer> tb(new TraceBuffer);
+  fakeTaskBegin("Task_Net", 1);
+  const int total = 3 * TRACE_EVENTS_PER_CORE + 7;
+  for (int i = 0; i < total; i++)
+  {
+    fakeAdvanceUs(1);
+    tb->record(TR_HTTP_POST, 'B');
+  }
+  long lastTs = 0;
+  Counts c = parseTrace(exportTrace(*tb, 1000), 1, &lastTs);
+  TEST_ASSERT_EQUAL(TRACE_EVENTS_PER_CORE, c.begin);
+  TEST_ASSERT_EQUAL(total, lastTs); // event paling baru ikut, yang lama tertimpa
+  TEST_ASSERT_EQUAL(0, parseTrace(exportTrace(*tb, 1000), 0).begin);
+}
+
+void test_window_drops_old_events()
+{
+  std::unique_ptr<TraceBuffer> tb(new TraceBuffer);
+  fakeTaskBegin("Task_Log", 1);
+  tb->record(TR_JSON_WAIT, 'B'); // t = 0
+  fakeAdvanceUs(5000000);
+  tb->record(TR_JSON_WAIT, 'E'); // t = 5 s
+  fakeAdvanceUs(100000);
+
+  TEST_ASSERT_EQUAL(1, parseTrace(exportTrace(*tb, 1000)).end);
+  TEST_ASSERT_EQUAL(0, parseTrace(exportTrace(*tb, 1000)).begin);
+  TEST_ASSERT_EQUAL(1, parseTrace(exportTrace(*tb, 10000)).begin);
+}
+
+void test_task_table_overflow_goes_to_other()
+{
+  std::unique_ptr<TraceBuffer> tb(new TraceBuffer);
+  for (int t = 0; t < TRACE_MAX_TASKS + 3; t++)
+  {
+    std::thread([&, t]()
+    {
+      char name[16];
+      snprintf(name, sizeof(name), "task%d", t);
+      fakeTaskBegin(name, t % 2);
+      tb->record(TR_I2C_HOLD, 'B');
+    }).join();
+  }
+  std::string json = exportTrace(*tb, 1000);
+  TEST_ASSERT_TRUE(json.find("\"name\":\"task15\"") != std::string::npos);
+  TEST_ASSERT_TRUE(json.find("\"name\":\"task16\"") == std::string::npos);
+  char other[64];
+  snprintf(other, sizeof(other), "\"pid\":0,\"tid\":%d}", TRACE_MAX_TASKS);
+  size_t n = 0;
+  for (size_t p = json.find(other); p != std::string::npos; p = json.find(other, p + 1))
+    n++;
+  TEST_ASSERT_EQUAL(2, n); // task16 & task18 (core 0) memakai tid "other"
+}
+
+void test_concurrent_writers_never_export_torn_events()
+{
+  // Dua writer per core (task yang saling preempt) sambil export berulang.
+  // Tiap writer punya id sendiri: event yang lolos harus konsisten
+  // (nama cocok dengan core & task penulisnya).
+  static const char *const names[4] = {"adc_read", "modbus_tx", "modbus_rx", "modbus_transaction"};
+  std::unique_ptr<TraceBuffer> tb(new TraceBuffer);
+  std::atomic<bool> run{true};
+  std::vector<std::thread> writers;
+  for (int w = 0; w < 4; w++)
+    writers.push_back(std::thread([&, w]()
+    {
+      char name[16];
+      snprintf(name, sizeof(name), "writer%d", w);
+      fakeTaskBegin(name, w % 2);
+      uint8_t id = TR_ADC_READ + w;
+      while (run.load(std::memory_order_relaxed))
+      {
+        tb->record(id, 'B');
+        tb->record(id, 'E');
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+      }
+    }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+  int events = 0, torn = 0;
+  for (int exports = 0; exports < 50; exports++)
+  {
+    DynamicJsonDocument doc(256 * 1024);
+    TEST_ASSERT_FALSE(deserializeJson(doc, exportTrace(*tb, 1000)));
+    for (JsonVariant e : doc["traceEvents"].as<JsonArray>())
+    {
+      const char *ph = e["ph"] | "";
+      if (!strcmp(ph, "M"))
+        continue;
+      events++;
+      int pid = e["pid"] | -1;
+      const char *name = e["name"] | "";
+      bool known = false;
+      for (int w = 0; w < 4; w++)
+        known |= !strcmp(name, names[w]) && pid == w % 2;
+      if (!known || (strcmp(ph, "B") && strcmp(ph, "E")))
+        torn++;
+    }
+  }
+  run = false;
+  for (std::thread &w : writers)
+    w.join();
+  TEST_ASSERT_EQUAL(0, torn);
+  TEST_ASSERT_TRUE(events > 0);
+}
+
+void test_bench_record()
+{
+  static TraceBuffer tb;
+  fakeTaskBegin("bench", 1);
+  benchRun("trace record", [&]()
+  { tb.record(TR_MODBUS_RX, 'B'); });
+  benchRun("TraceScope (B+E)", [&]()
+  { TraceScope t(TR_SPI_HOLD); });
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_export_is_chrome_trace_json);
+  RUN_TEST(test_small_chunks_produce_same_body);
+  RUN_TEST(test_ring_keeps_newest_events_per_core);
+  RUN_TEST(test_window_drops_old_events);
+  RUN_TEST(test_task_table_overflow_goes_to_other);
+  RUN_TEST(test_concurrent_writers_never_export_torn_events);
+  RUN_TEST(test_bench_record);
+  return UNITY_END();
+}
@@ -0,0 +1,212 @@
+// Jalur panas loop task tanpa alokasi heap: 10^6 iterasi akuisisi AI,
+// framing Modbus dan payload logger (jsonSend -> array -> FixedString).
+// Semua buffer/dokumen dibuat sekali di luar loop, seperti di firmware.
+// Alokasi dihitung lewat operator new/delete dan (glibc) malloc/free.
+#include <unity.h>
+#include <ArduinoJson.h>
+#include <new>
+#include "SignalMath.hpp"
+#include "ModbusFrame.hpp"
+#include "FixedString.hpp"
+#include "Payload.hpp"
+#include "Bench.h"
+
+#define ZERO_ALLOC_ITERATIONS 1000000UL
+
+static volatile bool countAllocs = false;
+static volatile unsigned long allocCount = 0;
+
+static inline void noteAlloc()
+{
+  if (countAllocs)
+    allocCount++;
+}
+
+void *operator new(size_t size)
+{
+  noteAlloc();
+  void *p = malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+  noteAlloc();
+  return malloc(size ? size : 1);
+}
+void *operator new[](size_t size, const std::nothrow_t &t) noexcept { return operator new(size, t); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+#if defined(__GLIBC__)
+// malloc langsung (mis. di library / snprintf) juga ikut terhitung
+extern "C" void *__libc_malloc(size_t);
+extern "C" void *__libc_calloc(size_t, size_t);
+extern "C" void *__libc_realloc(void *, size_t);
+extern "C" void __libc_free(void *);
+extern "C" void *malloc(size_t size)
+{
+  noteAlloc();
+  return __libc_malloc(size);
+}
+extern "C" void *calloc(size_t n, size_t size)
+{
+  noteAlloc();
+  return __libc_calloc(n, size);
+}
+extern "C" void *realloc(void *p, size_t size)
+{
+  noteAlloc();
+  return __libc_realloc(p, size);
+}
+extern "C" void free(void *p) { __libc_free(p); }
+#endif
+
+// Hitung alokasi selama fn() dijalankan ZERO_ALLOC_ITERATIONS kali
+template <class F>
+static unsigned long allocationsDuring(F fn)
+{
+  fn(0); // iterasi pemanasan (static lokal, buffer stdio) di luar hitungan
+  allocCount = 0;
+  countAllocs = true;
+  for (unsigned long i = 1; i <= ZERO_ALLOC_ITERATIONS; i++)
+    fn(i);
+  countAllocs = false;
+  return allocCount;
+}
+
+static AnalogChannelConfig channel(uint8_t type, bool scaling, float lo, float hi, float fc)
+{
+  AnalogChannelConfig ai = {};
+  ai.type = type;
+  ai.scaling = scaling;
+  ai.lowLimit = lo;
+  ai.highLimit = hi;
+  ai.filterAlpha = lowPassAlpha(fc);
+  return ai;
+}
+
+// Dibuat sekali seperti jsonSend / docNew / sendString di firmware
+static DynamicJsonDocument jsonSend(2048);
+static DynamicJsonDocument docNew(8192);
+static FixedString<4096> sendString;
+static const char *const keys[16] = {"AI1", "AI2", "AI3", "AI4", "DI1", "DI2", "DI3", "DI4",
+                                     "Flow", "Temp", "Press", "Level", "kWh", "Volt", "Amp", "Hz"};
+
+void setUp() {}
+void tearDown() {}
+
+void test_counter_sees_allocations()
+{
+  // Kontrol: hook memang terpasang
+  countAllocs = true;
+  allocCount = 0;
+  int *volatile p = new int[4]; // volatile: pasangan new/delete tidak dibuang optimizer
+  void *volatile m = malloc(32);
+  countAllocs = false;
+  delete[] p;
+  free(m);
+  TEST_ASSERT_TRUE(allocCount >= 1);
+}
+
+void test_acquisition_path_allocates_nothing()
+{
+  const AnalogChannelConfig ai[4] = {
+      channel(AI_TYPE_4_20MA, true, 0, 100, 0.5f), channel(AI_TYPE_0_10V, false, 0, 0, 0),
+      channel(AI_TYPE_0_20MA, true, -50, 150, 1.0f), channel(AI_TYPE_4_20MA, false, 0, 0, 2.0f)};
+  float filtered[4] = {};
+  unsigned long n = allocationsDuring([&](unsigned long i)
+  {
+    // Task_DataAcquisition per siklus: low-pass count lalu mapping
+    for (uint8_t ch = 0; ch < 4; ch++)
+    {
+      float adc = (float)((i * 37 + ch * 1000) % 26000);
+      filtered[ch] = lowPassStep(adc, filtered[ch], ai[ch].filterAlpha);
+      benchSink += (uint32_t)analogSample(ai[ch], filtered[ch]);
+    }
+  });
+  TEST_ASSERT_EQUAL_UINT32(0, n);
+}
+
+void test_modbus_framing_allocates_nothing()
+{
+  uint8_t request[MODBUS_READ_REQUEST_LEN];
+  uint8_t response[5 + 2 * 10];
+  uint16_t values[10];
+  unsigned long n = allocationsDuring([&](unsigned long i)
+  {
+    uint16_t count = 10;
+    modbusBuildReadRequest(request, 1, 3, (uint16_t)i, count);
+    response[0] = 1;
+    response[1] = 3;
+    response[2] = count * 2;
+    for (uint16_t r = 0; r < count; r++)
+    {
+      response[3 + 2 * r] = (uint8_t)(i >> 8);
+      response[4 + 2 * r] = (uint8_t)(i + r);
+    }
+    uint16_t crc = modbusCrc16(response, 3 + 2 * count);
+    response[3 + 2 * count] = crc & 0xFF;
+    response[4 + 2 * count] = crc >> 8;
+    if (modbusParseReadBlock(response, sizeof(response), 1, 3, count, values) == MB_FRAME_OK)
+      benchSink += values[9];
+  });
+  TEST_ASSERT_EQUAL_UINT32(0, n);
+}
+
+void test_logger_payload_allocates_nothing_and_pool_is_stable()
+{
+  for (const char *k : keys)
+    jsonSend[k] = 0.0;
+  size_t poolBefore = 0;
+  char timeNow[24];
+
+  unsigned long n = allocationsDuring([&](unsigned long i)
+  {
+    // Task_DataLogger: nilai baru ke jsonSend (angka, key pointer)
+    for (uint8_t k = 0; k < 16; k++)
+      jsonSend[keys[k]] = round2((float)(i % 1000) * 0.1f + k);
+    if (i == 0)
+      poolBefore = jsonSend.memoryUsage();
+
+    // Kirim / simpan SD: array record -> buffer kirim statis
+    snprintf(timeNow, sizeof(timeNow), "2026-10-19 %02lu:%02lu:%02lu", i / 3600 % 24, i / 60 % 60, i % 60);
+    docNew.clear();
+    sendString.clear();
+    buildSensorPayload(jsonSend.as<JsonObjectConst>(), docNew.to<JsonArray>(), timeNow, "JOB-1234");
+    serializeJson(docNew, sendString);
+    benchSink += sendString.length();
+  });
+  TEST_ASSERT_EQUAL_UINT32(0, n);
+  TEST_ASSERT_FALSE(sendString.overflowed());
+  TEST_ASSERT_FALSE(docNew.overflowed());
+  // Menimpa nilai angka tidak menghabiskan pool jsonSend
+  TEST_ASSERT_EQUAL(poolBefore, jsonSend.memoryUsage());
+}
+
+void test_bench_logger_cycle()
+{
+  benchRun("logger cycle (16 ch payload)", [&]()
+  {
+    docNew.clear();
+    sendString.clear();
+    buildSensorPayload(jsonSend.as<JsonObjectConst>(), docNew.to<JsonArray>(), NULL, NULL);
+    serializeJson(docNew, sendString);
+    benchSink += sendString.length();
+  });
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_counter_sees_allocations);
+  RUN_TEST(test_acquisition_path_allocates_nothing);
+  RUN_TEST(test_modbus_framing_allocates_nothing);
+  RUN_TEST(test_logger_payload_allocates_nothing_and_pool_is_stable);
+  RUN_TEST(test_bench_logger_cycle);
+  return UNITY_END();
+}